@@ -31,8 +31,10 @@
 #include <cmath>
 #include "fpga_dma_test_utils.h"
 #include "fpga_dma_common.h"
+#include <opae/cxx/core/buffer_ops.h>
 
 using namespace std;
+using namespace opae::fpga::types;
 
 static sem_t transfer_done;
 
@@ -61,6 +63,20 @@ static fpga_result verify_buffer(unsigned char *buf, size_t payload_size, uint16
 	unsigned char test_word = 0;
 	uint64_t byte_cnt = 1;
 
+	// Without decimation the pattern is a plain byte counter,
+	// since PATTERN_LENGTH * PATTERN_WIDTH is a multiple of 256.
+	if(!decim_factor) {
+		buffer_ops::compare_result r =
+			buffer_ops::compare_incrementing(buf, payload_size, 0);
+		if(r.mismatches) {
+			printf("Invalid data at byte %zd Expected = %x Actual = %x (%zd bytes differ)\n",
+			       r.first_mismatch + 1, (unsigned char)r.first_mismatch,
+			       buf[r.first_mismatch], r.mismatches);
+			return FPGA_EXCEPTION;
+		}
+		return FPGA_OK;
+	}
+
 	while(payload_size) {
 		test_word = 0x00;
 		for (i = 0; i < PATTERN_LENGTH; i++) {
@@ -89,21 +105,7 @@ out:
 
 //Populate repeating pattern 0x00...0xFF of payload size
 static void fill_buffer(unsigned char *buf, size_t payload_size) {
-	size_t i,j;
-	unsigned char test_word = 0;
-	while(payload_size) {
-		test_word = 0x00;
-		for (i = 0; i < PATTERN_LENGTH; i++) {
-			for (j = 0; j < (PATTERN_WIDTH/sizeof(test_word)); j++) {
-				if(!payload_size)
-					return;
-				*buf = test_word;
-				payload_size -= sizeof(test_word);
-				buf++;
-				test_word += 0x01;
-			}
-		}
-	}
+	buffer_ops::fill_incrementing(buf, payload_size, 0);
 }
 
 static double getBandwidth(size_t size, double seconds) {
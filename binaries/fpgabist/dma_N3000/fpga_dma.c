@@ -40,6 +40,8 @@
 #include <assert.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
 #include "fpga_dma_internal.h"
 #include "fpga_dma.h"
 
@@ -604,6 +606,10 @@ fpga_result fpgaDmaOpen(fpga_handle fpga, int dma_idx, fpga_dma_handle *dma_p)
 	dma_h->fpga_h = fpga;
 	for (i = 0; i < FPGA_DMA_MAX_BUF; i++)
 		dma_h->dma_buf_ptr[i] = NULL;
+	dma_h->pin_enabled = false;
+	dma_h->page_size = (uint64_t)sysconf(_SC_PAGE_SIZE);
+	dma_h->pin_clock = 0;
+	memset(dma_h->pin_cache, 0, sizeof(dma_h->pin_cache));
 	dma_h->mmio_num = 0;
 	dma_h->mmio_offset = 0;
 	dma_h->cur_ase_page = 0xffffffffffffffffUll;
@@ -669,7 +675,8 @@ fpga_result fpgaDmaOpen(fpga_handle fpga, int dma_idx, fpga_dma_handle *dma_p)
 	}
 
 	// Allocate magic number buffer
-	res = fpgaPrepareBuffer(dma_h->fpga_h, FPGA_DMA_ALIGN_BYTES,
+	res = fpgaPrepareBuffer(dma_h->fpga_h,
+				FPGA_DMA_MAGIC_SLOTS * FPGA_DMA_ALIGN_BYTES,
 				(void **)&(dma_h->magic_buf),
 				&dma_h->magic_wsid, 0);
 	ON_ERR_GOTO(res, out, "fpgaPrepareBuffer");
@@ -677,7 +684,8 @@ fpga_result fpgaDmaOpen(fpga_handle fpga, int dma_idx, fpga_dma_handle *dma_p)
 	res = fpgaGetIOAddress(dma_h->fpga_h, dma_h->magic_wsid,
 			       &dma_h->magic_iova);
 	ON_ERR_GOTO(res, rel_buf, "fpgaGetIOAddress");
-	memset((void *)dma_h->magic_buf, 0, FPGA_DMA_ALIGN_BYTES);
+	memset((void *)dma_h->magic_buf, 0,
+	       FPGA_DMA_MAGIC_SLOTS * FPGA_DMA_ALIGN_BYTES);
 
 	// turn on global interrupts
 	msgdma_ctrl_t ctrl = {0};
@@ -1187,6 +1195,234 @@ static void _wait_magic(fpga_dma_handle dma_h)
 	*(dma_h->magic_buf) = 0x0ULL;
 }
 
+/**
+ * _issue_magic_slot
+ *
+ * @brief                Posts a write of the magic number to a magic slot.
+ * The DMA engine processes descriptors in order, so the magic number lands
+ * once the engine has moved past every descriptor posted before it.
+ * @param[in] dma_h      Handle to the FPGA DMA object
+ * @param[in] slot       Magic slot index
+ * @return fpga_result FPGA_OK on success, return code otherwise
+ *
+ */
+static fpga_result _issue_magic_slot(fpga_dma_handle dma_h, int slot)
+{
+	*FPGA_DMA_MAGIC_SLOT(dma_h, slot) = 0x0ULL;
+
+	return _do_dma(dma_h,
+		       (dma_h->magic_iova + slot * FPGA_DMA_ALIGN_BYTES)
+			       | FPGA_DMA_WF_HOST_MASK,
+		       FPGA_DMA_WF_ROM_MAGIC_NO_MASK, 64, 1, FPGA_TO_HOST_MM,
+		       false /*intr_en */);
+}
+
+/**
+ * _wait_magic_slot
+ *
+ * @brief                Spins until the magic number posted by
+ * _issue_magic_slot() arrives, then clears the slot.
+ * @param[in] dma_h      Handle to the FPGA DMA object
+ * @param[in] slot       Magic slot index
+ * @return fpga_result FPGA_OK on success, FPGA_EXCEPTION on timeout
+ *
+ */
+static fpga_result _wait_magic_slot(fpga_dma_handle dma_h, int slot)
+{
+	volatile uint64_t *magic = FPGA_DMA_MAGIC_SLOT(dma_h, slot);
+	struct timespec start, now;
+	uint64_t spins = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (*magic != FPGA_DMA_WF_MAGIC_NO) {
+		if (++spins % 4096)
+			continue;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec - start.tv_sec) * 1000
+			    + (now.tv_nsec - start.tv_nsec) / 1000000
+		    > FPGA_DMA_TIMEOUT_MSEC) {
+			fprintf(stderr, "Magic number (slot %d) timeout\n",
+				slot);
+			return FPGA_EXCEPTION;
+		}
+	}
+	*magic = 0x0ULL;
+	return FPGA_OK;
+}
+
+static void _pin_release(fpga_dma_handle dma_h, fpga_dma_pin_t *pin)
+{
+	fpga_result res;
+
+	if (pin->valid && pin->pinned) {
+		res = fpgaReleaseBuffer(dma_h->fpga_h, pin->wsid);
+		if (res != FPGA_OK) {
+			error_print("Error fpgaReleaseBuffer: %s\n",
+				    fpgaErrStr(res));
+		}
+	}
+	memset(pin, 0, sizeof(*pin));
+}
+
+// Release the pinned regions that overlap [addr, addr + len).
+static void _pin_release_range(fpga_dma_handle dma_h, uint64_t addr,
+			       uint64_t len)
+{
+	int i;
+
+	for (i = 0; i < FPGA_DMA_PIN_CACHE_SIZE; i++) {
+		fpga_dma_pin_t *pin = &dma_h->pin_cache[i];
+		if (pin->valid && addr < pin->addr + pin->len
+		    && pin->addr < addr + len)
+			_pin_release(dma_h, pin);
+	}
+}
+
+static void _pin_release_all(fpga_dma_handle dma_h)
+{
+	int i;
+
+	for (i = 0; i < FPGA_DMA_PIN_CACHE_SIZE; i++)
+		_pin_release(dma_h, &dma_h->pin_cache[i]);
+}
+
+/**
+ * _pin_lookup
+ *
+ * @brief                Finds the IO address of a host buffer, pinning it
+ * if it isn't pinned yet. The least recently used pinned region is
+ * released to make room for a new one.
+ * @param[in] dma_h      Handle to the FPGA DMA object
+ * @param[in] addr       Host buffer address
+ * @param[in] len        Size in bytes
+ * @param[out] iova      IO address of addr
+ * @return true if the buffer can be DMA'd in place
+ *
+ */
+static bool _pin_lookup(fpga_dma_handle dma_h, uint64_t addr, uint64_t len,
+			uint64_t *iova)
+{
+	fpga_dma_pin_t *pin = NULL;
+	void *buf = (void *)addr;
+	fpga_result res;
+	int i;
+
+	if (!dma_h->pin_enabled || len < FPGA_DMA_PIN_MIN_SIZE
+	    || !IS_DMA_ALIGNED(addr))
+		return false;
+
+	for (i = 0; i < FPGA_DMA_PIN_CACHE_SIZE; i++) {
+		fpga_dma_pin_t *p = &dma_h->pin_cache[i];
+		if (p->valid && addr >= p->addr
+		    && addr + len <= p->addr + p->len) {
+			p->last_use = ++dma_h->pin_clock;
+			*iova = p->iova + (addr - p->addr);
+			return p->pinned;
+		}
+	}
+
+	if (addr & (dma_h->page_size - 1))
+		return false;
+
+	// Don't pin the same pages twice.
+	_pin_release_range(dma_h, addr, len);
+
+	for (i = 0; i < FPGA_DMA_PIN_CACHE_SIZE; i++) {
+		fpga_dma_pin_t *p = &dma_h->pin_cache[i];
+		if (!p->valid) {
+			pin = p;
+			break;
+		}
+		if (!pin || p->last_use < pin->last_use)
+			pin = p;
+	}
+	_pin_release(dma_h, pin);
+
+	pin->addr = addr;
+	pin->len = (len + dma_h->page_size - 1) & ~(dma_h->page_size - 1);
+	pin->last_use = ++dma_h->pin_clock;
+	pin->valid = true;
+
+	res = fpgaPrepareBuffer(dma_h->fpga_h, pin->len, &buf, &pin->wsid,
+				FPGA_BUF_PREALLOCATED | FPGA_BUF_QUIET);
+	if (res != FPGA_OK) {
+		debug_print("can't pin 0x%lx bytes at 0x%lx, bouncing\n",
+			    pin->len, addr);
+		return false;
+	}
+
+	res = fpgaGetIOAddress(dma_h->fpga_h, pin->wsid, &pin->iova);
+	if (res != FPGA_OK) {
+		fpgaReleaseBuffer(dma_h->fpga_h, pin->wsid);
+		return false;
+	}
+
+	pin->pinned = true;
+	*iova = pin->iova;
+	return true;
+}
+
+/**
+ * _direct_host_to_fpga
+ *
+ * @brief                DMA a pinned host buffer to the FPGA in place.
+ * @param[in] dma_h      Handle to the FPGA DMA object
+ * @param[in] dst        FPGA address, 64-byte aligned
+ * @param[in] iova       IO address of the host buffer, 64-byte aligned
+ * @param[in] count      Size in bytes, a multiple of 64
+ * @return fpga_result FPGA_OK on success, return code otherwise
+ *
+ */
+static fpga_result _direct_host_to_fpga(fpga_dma_handle dma_h, uint64_t dst,
+					uint64_t iova, uint64_t count)
+{
+	fpga_result res = FPGA_OK;
+	uint64_t offset;
+
+	for (offset = 0; offset < count; offset += fpga_dma_buf_size) {
+		uint64_t len = min(count - offset, fpga_dma_buf_size);
+		bool last = (offset + len == count);
+		res = _do_dma(dma_h, dst + offset,
+			      (iova + offset) | FPGA_DMA_HOST_MASK, len, last,
+			      HOST_TO_FPGA_MM, last /*intr_en */);
+		ON_ERR_RETURN(res, "HOST_TO_FPGA_MM Transfer failed");
+	}
+
+	return poll_interrupt(dma_h);
+}
+
+/**
+ * _direct_fpga_to_host
+ *
+ * @brief                DMA from the FPGA into a pinned host buffer.
+ * @param[in] dma_h      Handle to the FPGA DMA object
+ * @param[in] iova       IO address of the host buffer, 64-byte aligned
+ * @param[in] src        FPGA address, 64-byte aligned
+ * @param[in] count      Size in bytes, a multiple of 64
+ * @return fpga_result FPGA_OK on success, return code otherwise
+ *
+ */
+static fpga_result _direct_fpga_to_host(fpga_dma_handle dma_h, uint64_t iova,
+					uint64_t src, uint64_t count)
+{
+	fpga_result res = FPGA_OK;
+	uint64_t offset;
+
+	for (offset = 0; offset < count; offset += fpga_dma_buf_size) {
+		uint64_t len = min(count - offset, fpga_dma_buf_size);
+		res = _do_dma(dma_h, (iova + offset) | FPGA_DMA_HOST_MASK,
+			      src + offset, len, 1, FPGA_TO_HOST_MM,
+			      false /*intr_en */);
+		ON_ERR_RETURN(res, "FPGA_TO_HOST_MM Transfer failed");
+	}
+
+	res = _issue_magic(dma_h);
+	ON_ERR_RETURN(res, "Magic number issue failed");
+	_wait_magic(dma_h);
+
+	return FPGA_OK;
+}
+
 fpga_result transferHostToFpga(fpga_dma_handle dma_h, uint64_t dst,
 			       uint64_t src, size_t count,
 			       fpga_dma_transfer_t type)
@@ -1216,59 +1452,89 @@ fpga_result transferHostToFpga(fpga_dma_handle dma_h, uint64_t dst,
 		}
 	}
 	if (count_left) {
+		uint64_t iova = 0;
+		uint64_t direct_bytes = (count_left / FPGA_DMA_ALIGN_BYTES)
+					* FPGA_DMA_ALIGN_BYTES;
+		if (_pin_lookup(dma_h, src, direct_bytes, &iova)) {
+			debug_print("DMA TX : 0x%lx bytes direct from 0x%lx\n",
+				    direct_bytes, src);
+			res = _direct_host_to_fpga(dma_h, dst, iova,
+						   direct_bytes);
+			ON_ERR_GOTO(res, out,
+				    "HOST_TO_FPGA_MM Transfer failed\n");
+			count_left -= direct_bytes;
+			if (count_left) {
+				dst += direct_bytes;
+				src += direct_bytes;
+				res = _ase_host_to_fpga(dma_h, &dst, &src,
+							count_left);
+				ON_ERR_GOTO(
+					res, out,
+					"HOST_TO_FPGA_MM Transfer failed\n");
+			}
+			goto out;
+		}
+
 		uint64_t dma_chunks = count_left / fpga_dma_buf_size;
 		count_left -= (dma_chunks * fpga_dma_buf_size);
 		debug_print("DMA TX : dma chuncks = %" PRIu64
 			    ", count_left = %08lx, dst = %08lx, src = %08lx \n",
 			    dma_chunks, count_left, dst, src);
 
+		// Copy chunk i into its bounce buffer while the engine is
+		// still moving the chunks before it. A magic number posted
+		// behind each chunk tells when its buffer may be refilled.
 		for (i = 0; i < dma_chunks; i++) {
+			const int b = i % FPGA_DMA_MAX_BUF;
+			if (i >= FPGA_DMA_MAX_BUF) {
+				res = _wait_magic_slot(dma_h, b + 1);
+				ON_ERR_GOTO(res, out,
+					    "Magic number wait failed");
+			}
 			// constant size transfer, no length check required for
 			// memcpy
-			local_memcpy(dma_h->dma_buf_ptr[i % FPGA_DMA_MAX_BUF],
+			local_memcpy(dma_h->dma_buf_ptr[b],
 				     (void *)(src + i * fpga_dma_buf_size),
 				     fpga_dma_buf_size);
-			if ((i % (FPGA_DMA_MAX_BUF / 2)
-			     == (FPGA_DMA_MAX_BUF / 2) - 1)
-			    || i == (dma_chunks - 1) /*last descriptor */) {
-				if (i == (FPGA_DMA_MAX_BUF / 2) - 1) {
-					res = _do_dma(
-						dma_h,
-						(dst + i * fpga_dma_buf_size),
-						dma_h->dma_buf_iova
-								[i
-								 % FPGA_DMA_MAX_BUF]
-							| FPGA_DMA_HOST_MASK,
-						fpga_dma_buf_size, 0, type,
-						true);
-				} else {
-					if (issued_intr)
-						poll_interrupt(dma_h);
-					res = _do_dma(
-						dma_h,
-						(dst + i * fpga_dma_buf_size),
-						dma_h->dma_buf_iova
-								[i
-								 % FPGA_DMA_MAX_BUF]
-							| FPGA_DMA_HOST_MASK,
-						fpga_dma_buf_size, 0, type,
-						true /*intr_en */);
-				}
+			if (i == (dma_chunks - 1) /*last descriptor */) {
+				res = _do_dma(dma_h,
+					      (dst + i * fpga_dma_buf_size),
+					      dma_h->dma_buf_iova[b]
+						      | FPGA_DMA_HOST_MASK,
+					      fpga_dma_buf_size, 0, type,
+					      true /*intr_en */);
+				ON_ERR_GOTO(
+					res, out,
+					"HOST_TO_FPGA_MM Transfer failed\n");
 				issued_intr = 1;
 			} else {
-				res = _do_dma(
-					dma_h, (dst + i * fpga_dma_buf_size),
-					dma_h->dma_buf_iova[i
-							    % FPGA_DMA_MAX_BUF]
-						| FPGA_DMA_HOST_MASK,
-					fpga_dma_buf_size, 0, type,
-					false /*intr_en */);
+				res = _do_dma(dma_h,
+					      (dst + i * fpga_dma_buf_size),
+					      dma_h->dma_buf_iova[b]
+						      | FPGA_DMA_HOST_MASK,
+					      fpga_dma_buf_size, 0, type,
+					      false /*intr_en */);
+				ON_ERR_GOTO(
+					res, out,
+					"HOST_TO_FPGA_MM Transfer failed\n");
+				res = _issue_magic_slot(dma_h, b + 1);
+				ON_ERR_GOTO(res, out,
+					    "Magic number issue failed");
 			}
 		}
 		if (issued_intr) {
 			poll_interrupt(dma_h);
 			issued_intr = 0;
 		}
+		// consume the magic numbers nobody waited for
+		for (i = (dma_chunks > FPGA_DMA_MAX_BUF)
+				 ? dma_chunks - FPGA_DMA_MAX_BUF
+				 : 0;
+		     i + 1 < dma_chunks; i++) {
+			res = _wait_magic_slot(dma_h,
+					       (i % FPGA_DMA_MAX_BUF) + 1);
+			ON_ERR_GOTO(res, out, "Magic number wait failed");
+		}
 		if (count_left) {
 			uint64_t dma_tx_bytes =
 				(count_left / FPGA_DMA_ALIGN_BYTES)
@@ -1325,11 +1591,9 @@ fpga_result transferFpgaToHost(fpga_dma_handle dma_h, uint64_t dst,
 {
 	fpga_result res = FPGA_OK;
 	uint64_t i = 0;
-	uint64_t j = 0;
 	uint64_t count_left = count;
 	uint64_t aligned_addr = 0;
 	uint64_t align_bytes = 0;
-	int wf_issued = 0;
 
 	debug_print("FPGA To Host ----------- src = %08lx, dst = %08lx \n", src,
 		    dst);
@@ -1350,73 +1614,64 @@ fpga_result transferFpgaToHost(fpga_dma_handle dma_h, uint64_t dst,
 		}
 	}
 	if (count_left) {
+		uint64_t iova = 0;
+		uint64_t direct_bytes = (count_left / FPGA_DMA_ALIGN_BYTES)
+					* FPGA_DMA_ALIGN_BYTES;
+		if (_pin_lookup(dma_h, dst, direct_bytes, &iova)) {
+			debug_print("DMA TX : 0x%lx bytes direct to 0x%lx\n",
+				    direct_bytes, dst);
+			res = _direct_fpga_to_host(dma_h, iova, src,
+						   direct_bytes);
+			ON_ERR_GOTO(res, out,
+				    "FPGA_TO_HOST_MM Transfer failed");
+			count_left -= direct_bytes;
+			if (count_left) {
+				dst += direct_bytes;
+				src += direct_bytes;
+				res = _ase_fpga_to_host(dma_h, &src, &dst,
+							count_left);
+				ON_ERR_GOTO(res, out,
+					    "FPGA_TO_HOST_MM Transfer failed");
+			}
+			goto out;
+		}
+
 		uint64_t dma_chunks = count_left / fpga_dma_buf_size;
 		count_left -= (dma_chunks * fpga_dma_buf_size);
 		debug_print("DMA TX : dma chunks = %" PRIu64
 			    ", count_left = %08lx, dst = %08lx, src = %08lx \n",
 			    dma_chunks, count_left, dst, src);
-		assert(FPGA_DMA_MAX_BUF >= 8);
-		uint64_t pending_buf = 0;
-		for (i = 0; i < dma_chunks; i++) {
-			res = _do_dma(
-				dma_h,
-				dma_h->dma_buf_iova[i % (FPGA_DMA_MAX_BUF)]
-					| FPGA_DMA_HOST_MASK,
-				(src + i * fpga_dma_buf_size),
-				fpga_dma_buf_size, 1, type, false /*intr_en */);
-			ON_ERR_GOTO(res, out,
-				    "FPGA_TO_HOST_MM Transfer failed");
 
-			const int num_pending = i - pending_buf + 1;
-			if (num_pending
-			    == (FPGA_DMA_MAX_BUF
-				/ 2)) { // Enters this loop only once,after
-					// first batch of descriptors.
-				res = _issue_magic(dma_h);
+		// Keep up to FPGA_DMA_MAX_BUF chunks in flight and copy chunk i
+		// out of its bounce buffer while the following ones are moved.
+		uint64_t posted = 0;
+		for (i = 0; i < dma_chunks; i++) {
+			while (posted < dma_chunks
+			       && posted < i + FPGA_DMA_MAX_BUF) {
+				const int b = posted % FPGA_DMA_MAX_BUF;
+				res = _do_dma(dma_h,
+					      dma_h->dma_buf_iova[b]
+						      | FPGA_DMA_HOST_MASK,
+					      (src + posted * fpga_dma_buf_size),
+					      fpga_dma_buf_size, 1, type,
+					      false /*intr_en */);
 				ON_ERR_GOTO(res, out,
-					    "Magic number issue failed");
-				wf_issued = 1;
-			}
-			if (num_pending > (FPGA_DMA_MAX_BUF - 1)
-			    || i == (dma_chunks - 1) /*last descriptor */) {
-				if (wf_issued) {
-					_wait_magic(dma_h);
-					for (j = 0; j < (FPGA_DMA_MAX_BUF / 2);
-					     j++) {
-						// constant size transfer; no
-						// length check required
-						local_memcpy(
-							(void *)(dst
-								 + pending_buf
-									   * fpga_dma_buf_size),
-							dma_h->dma_buf_ptr
-								[pending_buf
-								 % (FPGA_DMA_MAX_BUF)],
-							fpga_dma_buf_size);
-						pending_buf++;
-					}
-					wf_issued = 0;
-				}
-				res = _issue_magic(dma_h);
+					    "FPGA_TO_HOST_MM Transfer failed");
+				res = _issue_magic_slot(dma_h, b + 1);
 				ON_ERR_GOTO(res, out,
 					    "Magic number issue failed");
-				wf_issued = 1;
+				posted++;
 			}
-		}
-
-		if (wf_issued)
-			_wait_magic(dma_h);
 
-		// clear out final dma memcpy operations
-		while (pending_buf < dma_chunks) {
+			res = _wait_magic_slot(dma_h,
+					       (i % FPGA_DMA_MAX_BUF) + 1);
+			ON_ERR_GOTO(res, out, "Magic number wait failed");
 			// constant size transfer; no length check required
-			local_memcpy(
-				(void *)(dst + pending_buf * fpga_dma_buf_size),
-				dma_h->dma_buf_ptr[pending_buf
-						   % (FPGA_DMA_MAX_BUF)],
-				fpga_dma_buf_size);
-			pending_buf++;
+			local_memcpy((void *)(dst + i * fpga_dma_buf_size),
+				     dma_h->dma_buf_ptr[i % FPGA_DMA_MAX_BUF],
+				     fpga_dma_buf_size);
 		}
+
 		if (count_left > 0) {
 			uint64_t dma_tx_bytes =
 				(count_left / FPGA_DMA_ALIGN_BYTES)
@@ -1596,6 +1851,159 @@ fpga_result fpgaDmaTransferSync(fpga_dma_handle dma_h, uint64_t dst,
 	return res;
 }
 
+fpga_result fpgaDmaPinUserBuffers(fpga_dma_handle dma_h, bool enable)
+{
+	if (!dma_h || !dma_h->fpga_h)
+		return FPGA_INVALID_PARAM;
+
+	if (!enable)
+		_pin_release_all(dma_h);
+	dma_h->pin_enabled = enable;
+
+	return FPGA_OK;
+}
+
+fpga_result fpgaDmaUnpinBuffer(fpga_dma_handle dma_h, void *buf,
+			       size_t count)
+{
+	if (!dma_h || !dma_h->fpga_h || !buf)
+		return FPGA_INVALID_PARAM;
+
+	_pin_release_range(dma_h, (uint64_t)buf, count);
+
+	return FPGA_OK;
+}
+
+// Map a page-aligned test buffer, backed by a single huge page when one
+// is available so that it can be pinned without an IOMMU.
+static void *_bw_test_alloc(size_t count, size_t *map_len)
+{
+	void *buf;
+
+#ifdef MAP_HUGE_SHIFT
+	const size_t huge = (count > (2UL << 20)) ? (1UL << 30) : (2UL << 20);
+	const int shift = (count > (2UL << 20)) ? 30 : 21;
+
+	if (count <= huge) {
+		buf = mmap(NULL, huge, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+				   | (shift << MAP_HUGE_SHIFT),
+			   -1, 0);
+		if (buf != MAP_FAILED) {
+			*map_len = huge;
+			return buf;
+		}
+	}
+#endif
+	buf = mmap(NULL, count, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (buf == MAP_FAILED)
+		return NULL;
+	*map_len = count;
+	return buf;
+}
+
+static void _bw_test_fill(uint64_t *buf, size_t count, uint64_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < count / sizeof(uint64_t); i++)
+		buf[i] = (i + seed) * 0x9e3779b97f4a7c15ULL;
+}
+
+static bool _bw_test_verify(const uint64_t *buf, size_t count, uint64_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < count / sizeof(uint64_t); i++) {
+		if (buf[i] != (i + seed) * 0x9e3779b97f4a7c15ULL) {
+			error_print("mismatch at offset 0x%lx\n",
+				    i * sizeof(uint64_t));
+			return false;
+		}
+	}
+	return true;
+}
+
+static double _bw_test_mbps(size_t count, struct timespec *start,
+			    struct timespec *end)
+{
+	double ns = (double)(end->tv_sec - start->tv_sec) * 1e9
+		    + (double)(end->tv_nsec - start->tv_nsec);
+
+	return ns > 0.0 ? (double)count * 1e3 / ns : 0.0;
+}
+
+fpga_result fpgaDmaBandwidthTest(fpga_dma_handle dma_h, uint64_t fpga_addr,
+				 size_t count, fpga_dma_bandwidth_t *bw)
+{
+	fpga_result res = FPGA_OK;
+	struct timespec start, end;
+	size_t map_len = 0;
+	uint64_t iova = 0;
+	uint64_t *buf;
+	bool pin_enabled;
+	int direct;
+
+	if (!dma_h || !dma_h->fpga_h || !bw)
+		return FPGA_INVALID_PARAM;
+
+	count &= ~(dma_h->page_size - 1);
+	if (count < FPGA_DMA_PIN_MIN_SIZE || !IS_DMA_ALIGNED(fpga_addr))
+		return FPGA_INVALID_PARAM;
+
+	buf = (uint64_t *)_bw_test_alloc(count, &map_len);
+	if (!buf)
+		return FPGA_NO_MEMORY;
+
+	memset(bw, 0, sizeof(*bw));
+	pin_enabled = dma_h->pin_enabled;
+	// an earlier buffer may have been pinned at the same address
+	_pin_release_range(dma_h, (uint64_t)buf, count);
+
+	for (direct = 0; direct < 2; direct++) {
+		double *h2f = direct ? &bw->direct_host_to_fpga
+				     : &bw->bounce_host_to_fpga;
+		double *f2h = direct ? &bw->direct_fpga_to_host
+				     : &bw->bounce_fpga_to_host;
+
+		dma_h->pin_enabled = direct;
+		if (direct) {
+			// Pin up front, so that only the transfers are timed.
+			if (!_pin_lookup(dma_h, (uint64_t)buf, count, &iova))
+				break;
+			bw->direct = true;
+		}
+
+		_bw_test_fill(buf, count, direct);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		res = fpgaDmaTransferSync(dma_h, fpga_addr, (uint64_t)buf,
+					  count, HOST_TO_FPGA_MM);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ON_ERR_GOTO(res, out, "HOST_TO_FPGA_MM Transfer failed");
+		*h2f = _bw_test_mbps(count, &start, &end);
+
+		memset(buf, 0, count);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		res = fpgaDmaTransferSync(dma_h, (uint64_t)buf, fpga_addr,
+					  count, FPGA_TO_HOST_MM);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ON_ERR_GOTO(res, out, "FPGA_TO_HOST_MM Transfer failed");
+		*f2h = _bw_test_mbps(count, &start, &end);
+
+		if (!_bw_test_verify(buf, count, direct)) {
+			res = FPGA_EXCEPTION;
+			goto out;
+		}
+	}
+
+out:
+	_pin_release_range(dma_h, (uint64_t)buf, count);
+	dma_h->pin_enabled = pin_enabled;
+	munmap(buf, map_len);
+	return res;
+}
+
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #pragma GCC diagnostic ignored "-Wunused-value"
 #define UNUSED(...) (void)(__VA_ARGS__)
@@ -1633,6 +2041,8 @@ fpga_result fpgaDmaClose(fpga_dma_handle dma_h)
 		CsrControl = NULL;
 	}
 
+	_pin_release_all(dma_h);
+
 	for (i = 0; i < FPGA_DMA_MAX_BUF; i++) {
 		res = fpgaReleaseBuffer(dma_h->fpga_h, dma_h->dma_buf_wsid[i]);
 		ON_ERR_GOTO(res, out, "fpgaReleaseBuffer failed");
@@ -120,6 +120,68 @@ fpga_result fpgaDmaTransferAsync(fpga_dma_handle dma, uint64_t dst,
 				 fpga_dma_transfer_t type,
 				 fpga_dma_transfer_cb cb, void *context);
 
+/**
+ * fpgaDmaPinUserBuffers
+ *
+ * @brief           Enable or disable DMA directly to and from user buffers.
+ *                  Direct DMA is off by default. When enabled, host buffers
+ *                  of at least 2 MiB that start on a page boundary are pinned
+ *                  on first use and kept pinned, so that later transfers skip
+ *                  the bounce buffers. Disabling releases all pinned buffers.
+ *
+ * Note: only enable direct DMA if every pinned buffer is unpinned with
+ * fpgaDmaUnpinBuffer() before it is freed or remapped. Otherwise a later
+ * allocation at the same address would be DMA'd to the old pages.
+ *
+ * @param[in] dma    DMA object handle
+ * @param[in] enable True to pin user buffers, false to always bounce
+ * @returns          FPGA_OK on success, return code otherwise
+ */
+fpga_result fpgaDmaPinUserBuffers(fpga_dma_handle dma, bool enable);
+
+/**
+ * fpgaDmaUnpinBuffer
+ *
+ * @brief           Release the pinned buffers that overlap a host buffer.
+ *
+ * @param[in] dma   DMA object handle
+ * @param[in] buf   Address of the host buffer
+ * @param[in] count Size in bytes
+ * @returns         FPGA_OK on success, return code otherwise
+ */
+fpga_result fpgaDmaUnpinBuffer(fpga_dma_handle dma, void *buf, size_t count);
+
+/*
+ * Bandwidth, in MB/s, of the bounce buffer and the direct (pinned user
+ * buffer) transfer paths, as measured by fpgaDmaBandwidthTest(). The
+ * direct_* values are 0 when the test buffer could not be pinned.
+ */
+typedef struct {
+	double bounce_host_to_fpga;
+	double bounce_fpga_to_host;
+	double direct_host_to_fpga;
+	double direct_fpga_to_host;
+	bool direct;
+} fpga_dma_bandwidth_t;
+
+/**
+ * fpgaDmaBandwidthTest
+ *
+ * @brief               Measure and compare the bounce buffer and the direct
+ * transfer paths. A page-aligned host buffer (backed by huge pages when
+ * available) is copied to FPGA memory and back through each path, and the
+ * data read back is verified.
+ * @param[in]  dma       Handle to the FPGA DMA object
+ * @param[in]  fpga_addr 64-byte aligned FPGA address of the test area
+ * @param[in]  count     Size in bytes, at least 2 MiB; rounded down to a
+ * multiple of the page size
+ * @param[out] bw        Measured bandwidth
+ * @return fpga_result FPGA_OK on success, FPGA_EXCEPTION on a data mismatch,
+ * return code otherwise
+ */
+fpga_result fpgaDmaBandwidthTest(fpga_dma_handle dma, uint64_t fpga_addr,
+				 size_t count, fpga_dma_bandwidth_t *bw);
+
 /**
  * fpgaDmaClose
  *
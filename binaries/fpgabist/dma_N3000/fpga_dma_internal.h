@@ -32,6 +32,7 @@
 #ifndef __FPGA_DMA_INT_H__
 #define __FPGA_DMA_INT_H__
 
+#include <stdbool.h>
 #include <opae/fpga.h>
 #include "x86-sse2.h"
 
@@ -159,6 +160,34 @@
 
 #define FPGA_DMA_MAX_BUF 8
 
+// magic_buf holds one cache line per slot. Slot 0 fences a whole
+// transfer, slot 1 + n tracks bounce buffer n so that the buffer can
+// be refilled as soon as the DMA engine has read (or written) it.
+#define FPGA_DMA_MAGIC_SLOTS (FPGA_DMA_MAX_BUF + 1)
+#define FPGA_DMA_MAGIC_SLOT(dma_h, n)                                          \
+	((volatile uint64_t *)((uint64_t)(dma_h)->magic_buf                    \
+			       + (uint64_t)(n) * FPGA_DMA_ALIGN_BYTES))
+
+// Once enabled with fpgaDmaPinUserBuffers(), host buffers of at least
+// FPGA_DMA_PIN_MIN_SIZE bytes that start on a page boundary are pinned
+// with fpgaPrepareBuffer() and DMA'd in place instead of being copied
+// through the bounce buffers. Up to FPGA_DMA_PIN_CACHE_SIZE pinned
+// regions are kept; the least recently used one is released first.
+// Regions that could not be pinned are remembered too, so that the
+// attempt isn't repeated on every call.
+#define FPGA_DMA_PIN_MIN_SIZE (2 * 1024 * 1024)
+#define FPGA_DMA_PIN_CACHE_SIZE 16
+
+typedef struct {
+	uint64_t addr;
+	uint64_t len;
+	uint64_t wsid;
+	uint64_t iova;
+	uint64_t last_use;
+	bool valid;
+	bool pinned; // false: fpgaPrepareBuffer() failed for this region
+} fpga_dma_pin_t;
+
 typedef struct __attribute__((__packed__)) {
 	uint64_t dfh;
 	uint64_t feature_uuid_lo;
@@ -200,6 +229,11 @@ struct _dma_handle_t {
 	uint64_t *dma_buf_ptr[FPGA_DMA_MAX_BUF];
 	uint64_t dma_buf_wsid[FPGA_DMA_MAX_BUF];
 	uint64_t dma_buf_iova[FPGA_DMA_MAX_BUF];
+	// pinned user buffers
+	bool pin_enabled;
+	uint64_t page_size;
+	uint64_t pin_clock;
+	fpga_dma_pin_t pin_cache[FPGA_DMA_PIN_CACHE_SIZE];
 };
 
 typedef union {
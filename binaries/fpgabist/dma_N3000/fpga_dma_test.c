@@ -57,6 +57,7 @@
 #define TEST_BUF_SIZE (10 * 1024 * 1024)
 #define ASE_TEST_BUF_SIZE (4 * 1024)
 #define TEST_TOTAL_SIZE (uint64_t)4 * 1024 * 1024 * 1024
+#define BW_TEST_SIZE (512 * 1024 * 1024)
 
 #ifdef CHECK_DELAYS
 extern double poll_wait_count;
@@ -80,6 +81,8 @@ bool use_advise = false;
 bool do_not_verify = false;
 bool cpu_affinity = false;
 bool memory_affinity = false;
+bool pin_user_buffers = true;
+bool bandwidth_test = false;
 
 /*
  * macro for checking return codes
@@ -117,7 +120,7 @@ config = {
 /*
  *  *  * Parse command line arguments
  *   *   */
-#define GETOPT_STRING ":B:D:S:s:G:mpc2nayCMv"
+#define GETOPT_STRING ":B:D:S:s:G:mpc2nayCMubv"
 fpga_result parse_args(int argc, char *argv[])
 {
     struct option longopts[] = {
@@ -234,6 +237,12 @@ fpga_result parse_args(int argc, char *argv[])
 		case 'M':
 			memory_affinity = true;
 			break;
+		case 'u':
+			pin_user_buffers = false;
+			break;
+		case 'b':
+			bandwidth_test = true;
+			break;
 
 		case 'v':
 			printf("fpga_dma_N3000_test %s %s%s\n",
@@ -519,6 +528,7 @@ fpga_result ddr_sweep(fpga_dma_handle dma_h, uint64_t mem_size, uint64_t ptr_ali
 		if (res != FPGA_OK) {
 			printf(" fpgaDmaTransferSync Host to FPGA failed with error %s",
 			       fpgaErrStr(res));
+			fpgaDmaUnpinBuffer(dma_h, buf_to_free_ptr, mem_size);
 			free_aligned(buf_to_free_ptr);
 			return FPGA_EXCEPTION;
 		}
@@ -555,6 +565,7 @@ fpga_result ddr_sweep(fpga_dma_handle dma_h, uint64_t mem_size, uint64_t ptr_ali
 		if (res != FPGA_OK) {
 			printf(" fpgaDmaTransferSync FPGA to Host failed with error %s",
 			       fpgaErrStr(res));
+			fpgaDmaUnpinBuffer(dma_h, buf_to_free_ptr, mem_size);
 			free_aligned(buf_to_free_ptr);
 			return FPGA_EXCEPTION;
 		}
@@ -572,6 +583,7 @@ fpga_result ddr_sweep(fpga_dma_handle dma_h, uint64_t mem_size, uint64_t ptr_ali
 	printf("Verifying buffer..\n");
 	verify_buffer((char *)dma_buf_ptr, total_mem_size);
 
+	fpgaDmaUnpinBuffer(dma_h, buf_to_free_ptr, mem_size);
 	free_aligned(buf_to_free_ptr);
 	return FPGA_OK;
 }
@@ -589,6 +601,8 @@ static void usage(void)
 	printf("\t-y\tDo not verify buffer contents - faster (default is to verify)\n");
 	printf("\t-C\tDo not restrict process to CPUs attached to DCP NUMA node\n");
 	printf("\t-M\tDo not restrict process memory allocation to DCP NUMA node\n");
+	printf("\t-u\tDo not pin user buffers, always copy through bounce buffers\n");
+	printf("\t-b\tCompare bounce buffer and pinned user buffer bandwidth\n");
 	printf("\t-B\tSet a target bus number\n");
 	printf("\t-D\tSelect DMA to test\n");
 	printf("\t-S\tSet memory test size\n");
@@ -762,6 +776,9 @@ int main(int argc, char *argv[])
         ON_ERR_GOTO(res, out_dma_close, "Invaid DMA Handle");
     }
 
+	res = fpgaDmaPinUserBuffers(dma_h, pin_user_buffers);
+	ON_ERR_GOTO(res, out_dma_close, "fpgaDmaPinUserBuffers");
+
 	if (use_ase)
 		count = ASE_TEST_BUF_SIZE;
 	else
@@ -865,13 +882,33 @@ int main(int argc, char *argv[])
 			res |= ddr_sweep(dma_h, config.target.size, 0, 7);
 		}
 		ON_ERR_GOTO(res, out_dma_close, "ddr_sweep");
+
+		if (bandwidth_test) {
+			fpga_dma_bandwidth_t bw;
+			printf("Running bandwidth self-test\n");
+			res = fpgaDmaBandwidthTest(dma_h, 0x0, BW_TEST_SIZE,
+						   &bw);
+			ON_ERR_GOTO(res, out_dma_close,
+				    "fpgaDmaBandwidthTest");
+			printf("Bounce buffers: H->F %lf MB/s, F->H %lf MB/s\n",
+			       bw.bounce_host_to_fpga, bw.bounce_fpga_to_host);
+			if (bw.direct)
+				printf("Pinned buffer:  H->F %lf MB/s, F->H %lf MB/s\n",
+				       bw.direct_host_to_fpga,
+				       bw.direct_fpga_to_host);
+			else
+				printf("Pinned buffer:  test buffer could not be pinned\n");
+		}
 	}
 
 	free(verify_buf);
 
 out_dma_close:
-	if (dma_buf_ptr)
+	if (dma_buf_ptr) {
+		if (dma_h)
+			fpgaDmaUnpinBuffer(dma_h, dma_buf_ptr, count);
 		free_aligned(dma_buf_ptr);
+	}
 	if (dma_h) {
 		res = fpgaDmaClose(dma_h);
 		ON_ERR_GOTO(res, out_unmap, "fpgaDmaClose");
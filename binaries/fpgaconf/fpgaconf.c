@@ -35,6 +35,7 @@
  * Features:
  *   * Auto-discovery of compatible slots for supplied bitstream
  *   * Dry-run mode ("what would happen if...?")
+ *   * Concurrent programming of all compatible FPGAs (--all)
  */
 #define _GNU_SOURCE
 #ifdef HAVE_CONFIG_H
@@ -46,6 +47,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 #include <uuid/uuid.h>
@@ -79,11 +82,13 @@ struct config {
 	} mode;
 	int flags;
 	char *filename;
+	bool all;
 } config = {.verbosity = 0,
 	    .dry_run = false,
 	    .mode = NORMAL,
 	    .flags = 0,
-	    .filename = NULL };
+	    .filename = NULL,
+	    .all = false };
 
 /*
  * Print readable error message for fpga_results
@@ -112,11 +117,12 @@ void help(void)
 	       "FPGA configuration utility\n"
 	       "\n"
 	       "Usage:\n"
-	       "        fpgaconf [-hVvn] [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR] <gbs>\n"
+	       "        fpgaconf [-hVvna] [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR] <gbs>\n"
 	       "\n"
 	       "                -h,--help           Print this help\n"
 	       "                -V,--verbose        Increase verbosity\n"
 	       "                -n,--dry-run        Don't actually perform actions\n"
+	       "                -a,--all            Program all matching FPGAs concurrently\n"
 	       "                --force             Attempt to reconfigure even if in use\n"
 	       "                --skip-usrclk       Don't program user clocks\n"
 	       "                -S,--segment        Set target segment number\n"
@@ -130,13 +136,14 @@ void help(void)
 /*
  * Parse command line arguments
  */
-#define GETOPT_STRING ":hVvnAIQ"
+#define GETOPT_STRING ":hVvnaAIQ"
 int parse_args(int argc, char *argv[])
 {
 	struct option longopts[] = {
 		{"help",        no_argument,       NULL, 'h'},
 		{"verbose",     no_argument,       NULL, 'V'},
 		{"dry-run",     no_argument,       NULL, 'n'},
+		{"all",         no_argument,       NULL, 'a'},
 		{"force",       no_argument,       NULL, 0xf},
 		{"skip-usrclk", no_argument,       NULL, 0x5},
 		{"version",     no_argument,       NULL, 'v'},
@@ -167,6 +174,10 @@ int parse_args(int argc, char *argv[])
 			config.dry_run = true;
 			break;
 
+		case 'a': /* all */
+			config.all = true;
+			break;
+
 		case 0xf: /* force */
 			config.flags |= FPGA_RECONF_FORCE;
 			break;
@@ -393,6 +404,202 @@ out_err:
 	return -1;
 }
 
+/*
+ * Find all FPGAs matching the interface ID of the GBS
+ *
+ * On success, *fpgas is an allocated array of *num_fpgas tokens, which
+ * the caller releases with fpgaDestroyToken() and opae_free().
+ *
+ * @returns the total number of FPGAs matching the interface ID
+ */
+int find_fpgas(fpga_properties device_filter,
+	       fpga_guid interface_id,
+	       fpga_token **fpgas,
+	       uint32_t *num_fpgas)
+{
+	fpga_properties filter = NULL;
+	uint32_t num_matches = 0;
+	fpga_result res;
+	int retval = -1;
+
+	*fpgas = NULL;
+	*num_fpgas = 0;
+
+	res = fpgaCloneProperties(device_filter, &filter);
+	ON_ERR_GOTO(res, out_err, "cloning properties");
+
+	res = fpgaPropertiesSetObjectType(filter, FPGA_DEVICE);
+	ON_ERR_GOTO(res, out_destroy, "setting object type");
+
+	res = fpgaPropertiesSetGUID(filter, interface_id);
+	ON_ERR_GOTO(res, out_destroy, "setting interface ID");
+
+	res = fpgaEnumerate(&filter, 1, NULL, 0, &num_matches);
+	ON_ERR_GOTO(res, out_destroy, "enumerating FPGAs");
+
+	if (!num_matches) {
+		retval = 0; /* no FPGA found */
+		goto out_destroy;
+	}
+
+	*fpgas = opae_calloc(num_matches, sizeof(fpga_token));
+	if (!*fpgas) {
+		print_err("allocating tokens", FPGA_NO_MEMORY);
+		goto out_destroy;
+	}
+
+	*num_fpgas = num_matches;
+	res = fpgaEnumerate(&filter, 1, *fpgas, *num_fpgas, &num_matches);
+	if (res != FPGA_OK) {
+		print_err("enumerating FPGAs", res);
+		opae_free(*fpgas);
+		*fpgas = NULL;
+		*num_fpgas = 0;
+		goto out_destroy;
+	}
+
+	/* devices may have disappeared between the two calls */
+	if (num_matches < *num_fpgas)
+		*num_fpgas = num_matches;
+
+	retval = (int)*num_fpgas;
+
+out_destroy:
+	res = fpgaDestroyProperties(&filter); /* not needed anymore */
+	ON_ERR_GOTO(res, out_err, "destroying properties object");
+out_err:
+	return retval;
+}
+
+/*
+ * Per-device state for --all mode
+ */
+struct program_job {
+	fpga_token token;
+	uint32_t slot_num;
+	opae_bitstream_info *info; /* shared, read-only */
+	int flags;
+	pthread_t thread;
+	bool thread_started;
+	char addr[16];
+	int result;
+	double elapsed_ms;
+};
+
+static void job_format_address(struct program_job *job)
+{
+	fpga_properties props = NULL;
+	uint16_t segment = 0;
+	uint8_t bus = 0;
+	uint8_t device = 0;
+	uint8_t function = 0;
+
+	snprintf(job->addr, sizeof(job->addr), "????:??:??.?");
+
+	if (fpgaGetProperties(job->token, &props) != FPGA_OK)
+		return;
+
+	if ((fpgaPropertiesGetSegment(props, &segment) == FPGA_OK) &&
+	    (fpgaPropertiesGetBus(props, &bus) == FPGA_OK) &&
+	    (fpgaPropertiesGetDevice(props, &device) == FPGA_OK) &&
+	    (fpgaPropertiesGetFunction(props, &function) == FPGA_OK))
+		snprintf(job->addr, sizeof(job->addr), "%04x:%02x:%02x.%1x",
+			 segment, bus, device, function);
+
+	fpgaDestroyProperties(&props);
+}
+
+static void *program_job_thread(void *arg)
+{
+	struct program_job *job = (struct program_job *)arg;
+	struct timespec start;
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	job->result = program_bitstream(job->token, job->slot_num,
+					job->info, job->flags);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	job->elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 +
+			  (end.tv_nsec - start.tv_nsec) / 1000000.0;
+
+	return NULL;
+}
+
+/*
+ * Program the given bitstream to each of the tokens concurrently,
+ * one worker thread per device. The bitstream is shared by all
+ * workers. A failure on one device does not affect the others.
+ *
+ * @returns the number of devices that failed to program, or -1
+ */
+int program_all(fpga_token *tokens, uint32_t num_tokens,
+		uint32_t slot_num, opae_bitstream_info *info, int flags)
+{
+	struct program_job *jobs;
+	struct timespec start;
+	struct timespec end;
+	double total_ms;
+	uint32_t i;
+	int failures = 0;
+
+	jobs = opae_calloc(num_tokens, sizeof(struct program_job));
+	if (!jobs) {
+		print_err("allocating jobs", FPGA_NO_MEMORY);
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		struct program_job *job = &jobs[i];
+		int err;
+
+		job->token = tokens[i];
+		job->slot_num = slot_num;
+		job->info = info;
+		job->flags = flags;
+		job->result = -1;
+		job_format_address(job);
+
+		err = pthread_create(&job->thread, NULL,
+				     program_job_thread, job);
+		if (err) {
+			fprintf(stderr, "%s: failed to create thread: %s\n",
+				job->addr, strerror(err));
+			continue;
+		}
+		job->thread_started = true;
+	}
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		if (jobs[i].thread_started)
+			pthread_join(jobs[i].thread, NULL);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	total_ms = (end.tv_sec - start.tv_sec) * 1000.0 +
+		   (end.tv_nsec - start.tv_nsec) / 1000000.0;
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		struct program_job *job = &jobs[i];
+
+		if (job->result < 0)
+			++failures;
+
+		printf("%s: %-6s %10.3f ms\n",
+		       job->addr,
+		       job->result < 0 ? "FAILED" : "OK",
+		       job->elapsed_ms);
+	}
+
+	printf("Programmed %u of %u device(s) in %.3f ms\n",
+	       num_tokens - (uint32_t)failures, num_tokens, total_ms);
+
+	opae_free(jobs);
+	return failures;
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -401,6 +608,9 @@ int main(int argc, char *argv[])
 	int retval = 0;
 	opae_bitstream_info info;
 	fpga_token token;
+	fpga_token *tokens = NULL;
+	uint32_t num_tokens = 0;
+	uint32_t i;
 	uint32_t slot_num = 0; /* currently, we don't support multiple slots */
 	fpga_properties device_filter = NULL;
 
@@ -442,6 +652,38 @@ int main(int argc, char *argv[])
 		goto out_exit;
 	}
 
+	if (config.all) {
+		/* program every compatible FPGA concurrently */
+		print_msg(1, "Looking for slots");
+		res = find_fpgas(device_filter, info.pr_interface_id,
+				 &tokens, &num_tokens);
+		if (res < 0) {
+			retval = 3;
+			goto out_free;
+		}
+		if (res == 0) {
+			fprintf(stderr, "No suitable slots found.\n");
+			retval = 4;
+			if (config.verbosity > 0)
+				print_interface_id(device_filter,
+						   info.pr_interface_id);
+			goto out_free;
+		}
+
+		print_msg(1, "Programming bitstream");
+		res = program_all(tokens, num_tokens, slot_num,
+				  &info, config.flags);
+		if (res != 0)
+			retval = 5;
+		else
+			print_msg(1, "Done");
+
+		for (i = 0 ; i < num_tokens ; ++i)
+			fpgaDestroyToken(&tokens[i]);
+		opae_free(tokens);
+		goto out_free;
+	}
+
 	/* find suitable slot */
 	print_msg(1, "Looking for slot");
 	res = find_fpga(device_filter, info.pr_interface_id, &token);
@@ -458,7 +700,8 @@ int main(int argc, char *argv[])
 	}
 	if (res > 1) {
 		fprintf(stderr,
-			"Found more than one suitable slot, please be more specific.\n");
+			"Found more than one suitable slot, please be more specific"
+			" or use --all.\n");
 		retval = 5;
 		goto out_destroy;
 	}
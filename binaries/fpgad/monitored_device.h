@@ -99,6 +99,10 @@ typedef struct _fpgad_monitored_device {
 #define MAX_DEV_SCRATCHPAD 2
 	uint64_t scratchpad[MAX_DEV_SCRATCHPAD];
 
+	// Owned by the plugin: set up in its configure routine
+	// and released in its destroy routine.
+	void *plugin_context;
+
 	struct _fpgad_monitored_device *next;
 } fpgad_monitored_device;
 
@@ -36,6 +36,7 @@
 #include "fpgad/api/sysfs.h"
 #include "mock/opae_std.h"
 #include "cfg-file.h"
+#include "telemetry-shm.h"
 
 #ifdef LOG
 #undef LOG
@@ -118,8 +119,19 @@ typedef struct _vc_device {
 	bool fpga_seu_err;
 	bool bmc_seu_err;
 	char sbdf[16];
+	bool publish_telemetry;
+	uint64_t telemetry_interval_msec;
+	uint64_t next_publish_ns;
+	char telemetry_name[TELEMETRY_SHM_NAME_MAX];
+	telemetry_writer telemetry;
+	fpga_handle metrics_h;
+	uint64_t num_metrics;
+	uint64_t *metric_num;
+	fpga_metric *metrics;
 } vc_device;
 
+#define VC_DEFAULT_TELEMETRY_INTERVAL_MSEC 1000
+
 #define BIT_SET_MASK(__n)  (1 << ((__n) % 8))
 #define BIT_SET_INDEX(__n) ((__n) / 8)
 
@@ -651,6 +663,167 @@ STATIC fpga_result vc_enable_aer(vc_device *vc)
 	return FPGA_OK;
 }
 
+STATIC void vc_telemetry_close(vc_device *vc)
+{
+	telemetry_writer_close(&vc->telemetry);
+
+	if (vc->metrics_h) {
+		fpgaClose(vc->metrics_h);
+		vc->metrics_h = NULL;
+	}
+
+	if (vc->metric_num) {
+		opae_free(vc->metric_num);
+		vc->metric_num = NULL;
+	}
+
+	if (vc->metrics) {
+		opae_free(vc->metrics);
+		vc->metrics = NULL;
+	}
+
+	vc->num_metrics = 0;
+}
+
+// Discover the device metrics and create the telemetry
+// segment. Sensor values are published even when the
+// device has no metrics.
+STATIC void vc_telemetry_open(vc_device *vc)
+{
+	fpga_metric_info *info = NULL;
+	telemetry_shm *shm;
+	uint64_t i;
+
+	if (!vc->publish_telemetry)
+		return;
+
+	if (fpgaOpen(vc->base_device->token,
+		     &vc->metrics_h,
+		     FPGA_OPEN_SHARED) != FPGA_OK) {
+		LOG("failed to open %s for telemetry.\n", vc->sbdf);
+		vc->metrics_h = NULL;
+	}
+
+	if (vc->metrics_h &&
+	    (fpgaGetNumMetrics(vc->metrics_h,
+			       &vc->num_metrics) == FPGA_OK) &&
+	    vc->num_metrics) {
+
+		if (vc->num_metrics > TELEMETRY_MAX_METRICS)
+			vc->num_metrics = TELEMETRY_MAX_METRICS;
+
+		info = opae_calloc(vc->num_metrics, sizeof(fpga_metric_info));
+		vc->metric_num = opae_calloc(vc->num_metrics, sizeof(uint64_t));
+		vc->metrics = opae_calloc(vc->num_metrics, sizeof(fpga_metric));
+
+		if (!info || !vc->metric_num || !vc->metrics ||
+		    (fpgaGetMetricsInfo(vc->metrics_h,
+					info,
+					&vc->num_metrics) != FPGA_OK)) {
+			LOG("failed to get metrics info for %s.\n", vc->sbdf);
+			vc->num_metrics = 0;
+		}
+	} else
+		vc->num_metrics = 0;
+
+	if (telemetry_writer_open(&vc->telemetry,
+				  vc->telemetry_name,
+				  vc->telemetry_interval_msec * 1000000ULL)) {
+		LOG("failed to create %s.\n", vc->telemetry_name);
+		if (info)
+			opae_free(info);
+		vc_telemetry_close(vc);
+		return;
+	}
+
+	shm = vc->telemetry.shm;
+
+	for (i = 0 ; i < vc->num_metrics ; ++i) {
+		size_t len;
+
+		vc->metric_num[i] = info[i].metric_num;
+
+		shm->metric[i].metric_num = info[i].metric_num;
+		len = strnlen(info[i].qualifier_name,
+			      sizeof(shm->metric[i].name) - 1);
+		memcpy(shm->metric[i].name, info[i].qualifier_name, len);
+		len = strnlen(info[i].metric_units,
+			      sizeof(shm->metric[i].units) - 1);
+		memcpy(shm->metric[i].units, info[i].metric_units, len);
+	}
+	shm->num_metrics = (uint32_t)vc->num_metrics;
+
+	for (i = 0 ; i < vc->num_sensors ; ++i) {
+		vc_sensor *s = &vc->sensors[i];
+		size_t len;
+
+		len = strnlen(s->name, sizeof(shm->sensor[i].name) - 1);
+		memcpy(shm->sensor[i].name, s->name, len);
+		len = strnlen(s->type, sizeof(shm->sensor[i].type) - 1);
+		memcpy(shm->sensor[i].type, s->type, len);
+	}
+	shm->num_sensors = vc->num_sensors;
+
+	if (info)
+		opae_free(info);
+
+	vc->next_publish_ns = 0;
+
+	LOG("publishing %lu metrics and %u sensors to /dev/shm%s\n",
+	    (unsigned long)vc->num_metrics, vc->num_sensors,
+	    vc->telemetry_name);
+}
+
+// Publish the latest sensor values along with a fresh read of
+// the device metrics, once per telemetry interval.
+STATIC void vc_telemetry_publish(vc_device *vc)
+{
+	telemetry_sample *sample;
+	fpga_result res = FPGA_NOT_FOUND;
+	uint64_t now;
+	uint64_t i;
+
+	if (!vc->telemetry.shm)
+		return;
+
+	now = telemetry_now_ns();
+	if (now < vc->next_publish_ns)
+		return;
+	vc->next_publish_ns = now + vc->telemetry_interval_msec * 1000000ULL;
+
+	// Read the metrics outside of the update, so that
+	// readers aren't held off by a slow BMC.
+	if (vc->num_metrics)
+		res = fpgaGetMetricsByIndex(vc->metrics_h,
+					    vc->metric_num,
+					    vc->num_metrics,
+					    vc->metrics);
+
+	sample = telemetry_writer_begin(&vc->telemetry);
+
+	memset(sample->metric_valid, 0, sizeof(sample->metric_valid));
+	for (i = 0 ; i < vc->num_metrics ; ++i) {
+		if ((res == FPGA_OK) && vc->metrics[i].isvalid) {
+			sample->metrics[i] = vc->metrics[i].value;
+			sample->metric_valid[i / 8] |= 1 << (i % 8);
+		}
+	}
+
+	for (i = 0 ; i < vc->num_sensors ; ++i) {
+		vc_sensor *s = &vc->sensors[i];
+
+		sample->sensors[i] = s->value;
+		if (s->flags & FPGAD_SENSOR_VC_IGNORE)
+			vc->telemetry.shm->sensor[i].flags &=
+				~TELEMETRY_SENSOR_VALID;
+		else
+			vc->telemetry.shm->sensor[i].flags |=
+				TELEMETRY_SENSOR_VALID;
+	}
+
+	telemetry_writer_end(&vc->telemetry);
+}
+
 STATIC bool vc_monitor_sensors(vc_device *vc)
 {
 	uint32_t i;
@@ -659,6 +832,7 @@ STATIC bool vc_monitor_sensors(vc_device *vc)
 	bool res = true;
 
 	if (vc->num_sensors == 0) { // no sensor found
+		vc_telemetry_publish(vc);
 		return true;
 	}
 
@@ -744,6 +918,8 @@ STATIC bool vc_monitor_sensors(vc_device *vc)
 
 	memset(vc->state_tripped, 0, (vc->num_sensors + 7) / 8);
 
+	vc_telemetry_publish(vc);
+
 	return res;
 }
 
@@ -891,6 +1067,8 @@ STATIC void *monitor_fme_vc_thread(void *arg)
 			save_state_last = NULL;
 		}
 
+		vc_telemetry_open(vc);
+
 		while (vc_monitor_sensors(vc)) {
 			if (vc->poll_seu_event) {
 				int poll_ret = poll(&vc->event_fd, 1, vc->poll_timeout_msec);
@@ -912,6 +1090,7 @@ STATIC void *monitor_fme_vc_thread(void *arg)
 			}
 
 			if (!vc_threads_running) {
+				vc_telemetry_close(vc);
 				vc_destroy_sensors(vc);
 				vc_unregister_err_event(vc);
 				return NULL;
@@ -921,6 +1100,7 @@ STATIC void *monitor_fme_vc_thread(void *arg)
 		save_state_last = vc->state_last;
 		vc->state_last = NULL;
 
+		vc_telemetry_close(vc);
 		vc_destroy_sensors(vc);
 		vc_unregister_err_event(vc);
 	}
@@ -943,6 +1123,8 @@ STATIC int vc_parse_config(vc_device *vc, const char *cfg)
 	json_object *j_set_aer_0 = NULL;
 	json_object *j_set_aer_1 = NULL;
 	json_object *j_monitor_seu = NULL;
+	json_object *j_publish_telemetry = NULL;
+	json_object *j_telemetry_interval = NULL;
 	json_object *j_sensor_overrides = NULL;
 	int res = 1;
 	int sensor_entries;
@@ -1116,6 +1298,30 @@ STATIC int vc_parse_config(vc_device *vc, const char *cfg)
 		LOG("monitoring for SEU events\n");
 	}
 
+	// publish-telemetry is optional and defaults to true.
+	vc->publish_telemetry = true;
+	j_publish_telemetry = parse_json_boolean(root,
+						 "publish-telemetry",
+						 &vc->publish_telemetry);
+	if (j_publish_telemetry && !vc->publish_telemetry) {
+		LOG("telemetry publishing disabled\n");
+	}
+
+	vc->telemetry_interval_msec = VC_DEFAULT_TELEMETRY_INTERVAL_MSEC;
+	if (json_object_object_get_ex(root,
+				      "telemetry-interval",
+				      &j_telemetry_interval)) {
+		if (json_object_is_type(j_telemetry_interval, json_type_int) &&
+		    (json_object_get_int(j_telemetry_interval) > 0)) {
+			vc->telemetry_interval_msec =
+				json_object_get_int(j_telemetry_interval);
+			LOG("set telemetry-interval to %lu msec.\n",
+			    (unsigned long)vc->telemetry_interval_msec);
+		} else {
+			LOG("telemetry-interval key not a positive integer.\n");
+		}
+	}
+
 	if (!json_object_object_get_ex(root,
 				       "sensor-overrides",
 				       &j_sensor_overrides)) {
@@ -1314,6 +1520,10 @@ int fpgad_plugin_configure(fpgad_monitored_device *d,
 		snprintf(vc->sbdf, sizeof(vc->sbdf), "%04x:%02x:%02x.%d",
 			 (int)seg, (int)bus, (int)dev, (int)fn);
 
+		telemetry_shm_name(vc->telemetry_name,
+				   sizeof(vc->telemetry_name),
+				   seg, bus, dev, fn);
+
 		LOG("monitoring 0x%04x:0x%04x 0x%04x:0x%04x (%s)\n",
 			d->supported->vendor_id,
 			d->supported->device_id,
@@ -301,6 +301,89 @@ fpgad_xfpga_Error_context fpgad_xfpga_Error_contexts[] = {
 	/*104 */ { "errors/catfatal_errors",  "RAS_CATFAT_ERROR_STAT[0x4060].KtiLinkFatalErr",     0,  0 },
 };
 
+#define FPGAD_XFPGA_ERRORS_GROUP "errors/"
+
+// A snapshot of the errors group, refreshed once per monitor pass
+// with fpgaObjectReadGroup() instead of reading each error file per
+// detection context.
+typedef struct _fpgad_xfpga_errors_snapshot {
+	fpga_object group;
+	bool disabled;
+	void *refresh_context;
+	uint32_t count;
+	fpga_object_value *values;
+} fpgad_xfpga_errors_snapshot;
+
+STATIC fpga_result
+fpgad_xfpga_snapshot_read(fpgad_monitored_device *d,
+			  void *context,
+			  const char *sysfs_file,
+			  uint64_t *value)
+{
+	fpgad_xfpga_errors_snapshot *snap =
+		(fpgad_xfpga_errors_snapshot *)d->plugin_context;
+	const char *name;
+	fpga_result res;
+	uint32_t i;
+
+	if (!snap || snap->disabled)
+		return FPGA_NOT_FOUND;
+
+	if (strncmp(sysfs_file, FPGAD_XFPGA_ERRORS_GROUP,
+		    sizeof(FPGAD_XFPGA_ERRORS_GROUP) - 1))
+		return FPGA_NOT_FOUND;
+
+	name = sysfs_file + sizeof(FPGAD_XFPGA_ERRORS_GROUP) - 1;
+	if (strchr(name, '/'))
+		return FPGA_NOT_FOUND;
+
+	if (!snap->group) {
+		res = fpgaTokenGetObject(d->token, "errors", &snap->group,
+					 FPGA_OBJECT_RECURSE_ONE);
+		if (res == FPGA_OK)
+			res = fpgaObjectGetSize(snap->group, &snap->count, 0);
+		if (res == FPGA_OK) {
+			snap->values = opae_calloc(snap->count,
+						   sizeof(fpga_object_value));
+			if (!snap->values)
+				res = FPGA_NO_MEMORY;
+		}
+		if (res != FPGA_OK) {
+			// Not available: use the per-file reads from now on.
+			if (snap->group)
+				fpgaDestroyObject(&snap->group);
+			snap->disabled = true;
+			return res;
+		}
+		snap->refresh_context = NULL;
+	}
+
+	// The first context to hit the snapshot in a pass refreshes it.
+	if (!snap->refresh_context || snap->refresh_context == context) {
+		res = fpgaObjectReadGroup(snap->group, snap->values,
+					  snap->count, NULL, 0);
+		if (res != FPGA_OK) {
+			fpgaDestroyObject(&snap->group);
+			opae_free(snap->values);
+			snap->values = NULL;
+			snap->disabled = true;
+			return res;
+		}
+		snap->refresh_context = context;
+	}
+
+	for (i = 0 ; i < snap->count ; ++i) {
+		if (!strcmp(snap->values[i].name, name)) {
+			if (snap->values[i].result != FPGA_OK)
+				return snap->values[i].result;
+			*value = snap->values[i].value;
+			return FPGA_OK;
+		}
+	}
+
+	return FPGA_NOT_FOUND;
+}
+
 fpgad_detection_status
 fpgad_xfpga_detect_Error(fpgad_monitored_device *d,
 			 void *context)
@@ -315,22 +398,25 @@ fpgad_xfpga_detect_Error(fpgad_monitored_device *d,
 	int i;
 	bool detected = false;
 
-	res = fpgaTokenGetObject(d->token, c->sysfs_file,
-				 &obj, 0);
+	res = fpgad_xfpga_snapshot_read(d, context, c->sysfs_file, &err);
 	if (res != FPGA_OK) {
-		LOG("failed to get error object\n");
-		return FPGAD_STATUS_NOT_DETECTED;
-	}
+		res = fpgaTokenGetObject(d->token, c->sysfs_file,
+					 &obj, 0);
+		if (res != FPGA_OK) {
+			LOG("failed to get error object\n");
+			return FPGAD_STATUS_NOT_DETECTED;
+		}
+
+		res = fpgaObjectRead64(obj, &err, 0);
+		if (res != FPGA_OK) {
+			LOG("failed to read error object\n");
+			fpgaDestroyObject(&obj);
+			return FPGAD_STATUS_NOT_DETECTED;
+		}
 
-	res = fpgaObjectRead64(obj, &err, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to read error object\n");
 		fpgaDestroyObject(&obj);
-		return FPGAD_STATUS_NOT_DETECTED;
 	}
 
-	fpgaDestroyObject(&obj);
-
 	mask = 0;
 	for (i = c->low_bit ; i <= c->high_bit ; ++i)
 		mask |= 1ULL << i;
@@ -977,6 +1063,9 @@ int fpgad_plugin_configure(fpgad_monitored_device *d,
 		d->response_contexts = fpgad_xfpga_fme_response_contexts;
 	}
 
+	d->plugin_context = opae_calloc(1,
+		sizeof(fpgad_xfpga_errors_snapshot));
+
 	return 0;
 }
 
@@ -988,4 +1077,15 @@ void fpgad_plugin_destroy(fpgad_monitored_device *d)
 			d->object_id,
 			d->object_type == FPGA_ACCELERATOR ?
 			"accelerator" : "device");
+
+	if (d->plugin_context) {
+		fpgad_xfpga_errors_snapshot *snap =
+			(fpgad_xfpga_errors_snapshot *)d->plugin_context;
+		if (snap->group)
+			fpgaDestroyObject(&snap->group);
+		if (snap->values)
+			opae_free(snap->values);
+		opae_free(snap);
+		d->plugin_context = NULL;
+	}
 }
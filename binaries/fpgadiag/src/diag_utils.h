@@ -68,24 +68,9 @@ bool buffer_poll(opae::fpga::types::shared_buffer::ptr_t buffer, std::size_t off
 }
 
 template<typename T>
-bool buffer_wait(opae::fpga::types::shared_buffer::ptr_t buffer, std::size_t offset, std::chrono::microseconds each, std::chrono::microseconds timeout, T mask, T value)
+bool buffer_wait(opae::fpga::types::shared_buffer::ptr_t buffer, std::size_t offset, std::chrono::microseconds timeout, T mask, T value)
 {
-    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-    std::chrono::microseconds elapsed;
-
-    do
-    {
-        if ((buffer->read<T>(offset) & mask) == value)
-            return true;
-
-        std::this_thread::sleep_for(each);
-
-        elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
-                    std::chrono::high_resolution_clock::now() - start);
-
-    }while(elapsed < timeout);
-
-    return false;
+    return buffer->wait_for<T>(offset, mask, value, timeout);
 }
 
 class split_buffer : public opae::fpga::types::shared_buffer {
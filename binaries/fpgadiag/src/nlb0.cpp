@@ -470,7 +470,7 @@ bool nlb0::run()
             // stop the device
             write_csr32(static_cast<uint32_t>(nlb0_csr::ctl), 7);
             if (!buffer_wait(dsm_, static_cast<size_t>(nlb0_dsm::test_complete),
-                           std::chrono::microseconds(10), dsm_timeout_, 0x1, 1))
+                           dsm_timeout_, 0x1, 1))
             {
                 log_.error("nlb0") << "test timeout at "
                                    << i << " cachelines." << std::endl;
@@ -480,7 +480,7 @@ bool nlb0::run()
         else
         {
             if (!buffer_wait(dsm_, static_cast<size_t>(nlb0_dsm::test_complete),
-                        std::chrono::microseconds(10), dsm_timeout_, 0x1, 1))
+                        dsm_timeout_, 0x1, 1))
             {
                 log_.error("nlb0") << "test timeout at "
                                    << i << " cachelines." << std::endl;
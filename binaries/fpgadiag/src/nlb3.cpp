@@ -576,7 +576,7 @@ bool nlb3::run()
             // stop the device
             accelerator_->write_csr32(static_cast<uint32_t>(nlb3_csr::ctl), 7);
             if (!buffer_wait(dsm_, static_cast<size_t>(nlb3_dsm::test_complete),
-                        std::chrono::microseconds(10), dsm_timeout_, 0x1, 1))
+                        dsm_timeout_, 0x1, 1))
             {
                 log_.error("nlb3") << "test timeout at "
                                    << i << " cachelines." << std::endl;
@@ -586,7 +586,7 @@ bool nlb3::run()
         else
         {
             if (!buffer_wait(dsm_, static_cast<size_t>(nlb3_dsm::test_complete),
-                        std::chrono::microseconds(10), dsm_timeout_, 0x1, 1))
+                        dsm_timeout_, 0x1, 1))
             {
                 log_.error("nlb3") << "test timeout at "
                                    << i << " cachelines." << std::endl;
@@ -96,7 +96,6 @@ bool nlb_cache_cool::cool()
     std::chrono::microseconds dsm_timeout = (target_ == "ase") ? ASE_DSM_TIMEOUT : FPGA_DSM_TIMEOUT;
     if (!buffer_wait<uint32_t>(dsm_,
                               static_cast<size_t>(nlb0_dsm::test_complete),
-                              std::chrono::microseconds(10),
                               dsm_timeout,
                               static_cast<uint32_t>(0x1),
                               static_cast<uint32_t>(1)))
@@ -166,7 +165,6 @@ bool nlb_read_cache_warm::warm()
     std::chrono::microseconds dsm_timeout = (target_ == "ase") ? ASE_DSM_TIMEOUT : FPGA_DSM_TIMEOUT;
     if (!buffer_wait<uint32_t>(dsm_,
                               static_cast<size_t>(nlb0_dsm::test_complete),
-                              std::chrono::microseconds(10),
                               dsm_timeout,
                               static_cast<uint32_t>(0x1),
                               static_cast<uint32_t>(1)))
@@ -236,7 +234,6 @@ bool nlb_write_cache_warm::warm()
     std::chrono::microseconds dsm_timeout = (target_ == "ase") ? ASE_DSM_TIMEOUT : FPGA_DSM_TIMEOUT;
     if (!buffer_wait<uint32_t>(dsm_,
                               static_cast<size_t>(nlb0_dsm::test_complete),
-                              std::chrono::microseconds(10),
                               dsm_timeout,
                               static_cast<uint32_t>(0x1),
                               static_cast<uint32_t>(1)))
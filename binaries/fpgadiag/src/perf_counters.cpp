@@ -28,7 +28,9 @@
 #include <fstream>
 #include <cstdint>
 #include "perf_counters.h"
-#include <opae/cxx/core/handle.h>
+#include <mutex>
+#include <opae/cxx/core/perf_sampler.h>
+#include <opae/cxx/core/properties.h>
 #include <opae/cxx/core/sysobject.h>
 
 using namespace opae::fpga::types;
@@ -38,6 +40,26 @@ namespace intel
 namespace fpga
 {
 
+// The counter objects of each FME are looked up once, and the FME
+// stays open for the life of the process, so that taking a snapshot
+// only costs the counter reads.
+static perf_sampler::ptr_t fme_sampler(token::ptr_t fme)
+{
+    static std::mutex lock;
+    static std::map<uint64_t, perf_sampler::ptr_t> samplers;
+
+    uint64_t id = properties::get(fme)->object_id;
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = samplers.find(id);
+    if (it != samplers.end())
+        return it->second;
+
+    // Only single groups are read here, so keep no history.
+    auto sampler = perf_sampler::open(fme, 0);
+    samplers[id] = sampler;
+    return sampler;
+}
+
 fpga_cache_counters::fpga_cache_counters()
 : fme_()
 , perf_feature_rev_(-1)
@@ -137,76 +159,31 @@ fpga_cache_counters operator - (const fpga_cache_counters &l,
 
 fpga_cache_counters::ctr_map_t fpga_cache_counters::read_counters()
 {
-    ctr_t c;
     ctr_map_t m;
-    auto handle = handle::open(fme_, FPGA_OPEN_SHARED);
-
-    if (handle) {
-        auto cache = sysobject::get(handle, "*perf/cache", FPGA_OBJECT_GLOB);
-
-        if (cache) {
-            auto freeze = cache->get("freeze");
-            freeze->write64(1);
-
-            c = ctr_t::read_hit;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::write_hit;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::read_miss;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::write_miss;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::hold_request;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::data_write_port_contention;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::tag_write_port_contention;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::tx_req_stall;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::rx_req_stall;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::rx_eviction;
-            m.insert(std::make_pair(c, read_counter(c)));
-
-            freeze->write64(0);
-        }
-
-        handle->close();
-    }
-    return m;
-}
+    ctr_t ctr_ts[] =
+    {
+        ctr_t::read_hit,
+        ctr_t::write_hit,
+        ctr_t::read_miss,
+        ctr_t::write_miss,
+        ctr_t::hold_request,
+        ctr_t::data_write_port_contention,
+        ctr_t::tag_write_port_contention,
+        ctr_t::tx_req_stall,
+        ctr_t::rx_req_stall,
+        ctr_t::rx_eviction,
+    };
 
-uint64_t fpga_cache_counters::read_counter(fpga_cache_counters::ctr_t c)
-{
-    std::string ctr("*perf/cache/");
+    auto sampler = fme_sampler(fme_);
+    if (!sampler || sampler->find(perf_sampler::group::cache, "read_hit") < 0)
+        return m;
 
-#define CASE(x) case x : ctr += #x; break
-    switch(c)
-    {
-        CASE(read_hit);
-        CASE(write_hit);
-        CASE(read_miss);
-        CASE(write_miss);
-        CASE(hold_request);
-        CASE(data_write_port_contention);
-        CASE(tag_write_port_contention);
-        CASE(tx_req_stall);
-        CASE(rx_req_stall);
-        CASE(rx_eviction);
-        default : return (uint64_t)-1;
-    }
-#undef CASE
-    try {
-        auto counter = sysobject::get(fme_, ctr, FPGA_OBJECT_GLOB);
-        if (counter) {
-          return counter->read64();
-        }
-    }catch(not_found &) {
-       return 0;
+    auto values = sampler->read_group(perf_sampler::group::cache);
+    for (auto c : ctr_ts) {
+        int i = sampler->find(perf_sampler::group::cache, name(c));
+        m.insert(std::make_pair(c, i < 0 ? 0 : values[i]));
     }
-
-    return 0;
+    return m;
 }
 
 
@@ -305,70 +282,29 @@ fpga_fabric_counters operator - (const fpga_fabric_counters &l,
 
 fpga_fabric_counters::ctr_map_t fpga_fabric_counters::read_counters()
 {
-    ctr_t c;
     ctr_map_t m;
-    auto handle = handle::open(fme_, FPGA_OPEN_SHARED);
-
-    if (handle) {
-        auto fabric = sysobject::get(handle, "*perf/fabric", FPGA_OBJECT_GLOB);
-
-        if (fabric) {
-            auto freeze = fabric->get("freeze");
-            freeze->write64(1);
-
-            c = ctr_t::mmio_read;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::mmio_write;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::pcie0_read;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::pcie0_write;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::pcie1_read;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::pcie1_write;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::upi_read;
-            m.insert(std::make_pair(c, read_counter(c)));
-            c = ctr_t::upi_write;
-            m.insert(std::make_pair(c, read_counter(c)));
-
-            freeze->write64(0);
-        }
-        handle->close();
-    }
-
-    return m;
-}
+    ctr_t ctr_ts[] =
+    {
+        ctr_t::mmio_read,
+        ctr_t::mmio_write,
+        ctr_t::pcie0_read,
+        ctr_t::pcie0_write,
+        ctr_t::pcie1_read,
+        ctr_t::pcie1_write,
+        ctr_t::upi_read,
+        ctr_t::upi_write,
+    };
 
-uint64_t fpga_fabric_counters::read_counter(fpga_fabric_counters::ctr_t c)
-{
-    std::string ctr("*perf/fabric/");
+    auto sampler = fme_sampler(fme_);
+    if (!sampler || sampler->find(perf_sampler::group::fabric, "mmio_read") < 0)
+        return m;
 
-#define CASE(x) case x : ctr += #x; break
-    switch(c)
-    {
-        CASE(mmio_read);
-        CASE(mmio_write);
-        CASE(pcie0_read);
-        CASE(pcie0_write);
-        CASE(pcie1_read);
-        CASE(pcie1_write);
-        CASE(upi_read);
-        CASE(upi_write);
-        default : return (uint64_t)-1;
-    }
-#undef CASE
-    try {
-        auto counter = sysobject::get(fme_, ctr, FPGA_OBJECT_GLOB);
-        if (counter) {
-          return counter->read64();
-        }
-    }catch(not_found &) {
-       return 0;
+    auto values = sampler->read_group(perf_sampler::group::fabric);
+    for (auto c : ctr_ts) {
+        int i = sampler->find(perf_sampler::group::fabric, name(c));
+        m.insert(std::make_pair(c, i < 0 ? 0 : values[i]));
     }
-
-    return 0;
+    return m;
 }
 
 } // end of namespace fpga
@@ -69,7 +69,6 @@ protected:
     typedef ctr_map_t::const_iterator const_ctr_map_iter_t;
 
     ctr_map_t read_counters();
-    uint64_t read_counter(ctr_t c);
 
 private:
     opae::fpga::types::token::ptr_t fme_;
@@ -109,7 +108,6 @@ protected:
     typedef ctr_map_t::const_iterator const_ctr_map_iter_t;
 
     ctr_map_t read_counters();
-    uint64_t read_counter(ctr_t c);
 
 private:
     opae::fpga::types::token::ptr_t fme_;
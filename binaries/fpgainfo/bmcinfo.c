@@ -27,6 +27,7 @@
 #include "fpgainfo.h"
 #include "bmcinfo.h"
 #include "bmcdata.h"
+#include "collect.h"
 #include "board.h"
 #include <opae/fpga.h>
 #include <unistd.h>
@@ -44,8 +45,9 @@
 void bmc_help(void)
 {
 	printf("\nPrint all Board Management Controller sensor values\n"
-	       "        fpgainfo bmc [-h]\n"
+	       "        fpgainfo bmc [-h] [-J]\n"
 	       "                -h,--help           Print this help\n"
+	       "                -J,--json           Print JSON output\n"
 	       "\n");
 }
 
@@ -70,37 +72,6 @@ fpga_result bmc_filter(fpga_properties *filter, int argc, char *argv[])
 	return res;
 }
 
-static void print_bmc_info(fpga_token token)
-{
-	fpga_properties props = NULL;
-	fpga_metric_info metrics_info[METRICS_MAX_NUM];
-	fpga_metric metrics[METRICS_MAX_NUM] = { { 0 } };
-	uint64_t num_metrics;
-	uint64_t num_metrics_info;
-	fpga_result res = FPGA_OK;
-
-	res = fpgaGetProperties(token, &props);
-	ON_FPGAINFO_ERR_GOTO(res, out_exit,
-			     "reading properties from token");
-
-	fpgainfo_board_info(token);
-	fpgainfo_print_common("//****** BMC SENSORS ******//", props);
-
-	res = get_metrics(token, FPGA_ALL, metrics_info, &num_metrics_info, metrics, &num_metrics);
-	ON_FPGAINFO_ERR_GOTO(res, out_destroy,
-			     "reading metrics from BMC");
-
-	print_metrics(metrics_info, num_metrics_info, metrics, num_metrics);
-
-out_destroy:
-	res = fpgaDestroyProperties(&props);
-	ON_FPGAINFO_ERR_GOTO(res, out_exit, "destroying properties");
-
-out_exit:
-	return;
-}
-
-
 fpga_result bmc_command(fpga_token *tokens, int num_tokens, int argc,
 			char *argv[])
 {
@@ -112,14 +83,16 @@ fpga_result bmc_command(fpga_token *tokens, int num_tokens, int argc,
 	optind = 0;
 	struct option longopts[] = {
 		{"help", no_argument, NULL, 'h'},
+		{"json", no_argument, NULL, 'J'},
 		{0, 0, 0, 0},
 	};
+	bool json = false;
 
 	int getopt_ret;
 	int option_index;
 
 	while (-1
-	       != (getopt_ret = getopt_long(argc, argv, ":h", longopts,
+	       != (getopt_ret = getopt_long(argc, argv, ":hJ", longopts,
 					    &option_index))) {
 		const char *tmp_optarg = optarg;
 
@@ -132,6 +105,10 @@ fpga_result bmc_command(fpga_token *tokens, int num_tokens, int argc,
 			bmc_help();
 			return res;
 
+		case 'J': /* json */
+			json = true;
+			break;
+
 		case ':': /* missing option argument */
 			OPAE_ERR("Missing option argument\n");
 			bmc_help();
@@ -145,12 +122,8 @@ fpga_result bmc_command(fpga_token *tokens, int num_tokens, int argc,
 		}
 	}
 
-	int i = 0;
-	for (i = 0; i < num_tokens; ++i) {
-		print_bmc_info(tokens[i]);
-	}
-
-	return res;
+	return fpgainfo_metrics_command(tokens, num_tokens, FPGA_ALL, "bmc",
+					"//****** BMC SENSORS ******//", json);
 }
 
 
@@ -0,0 +1,402 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <uuid/uuid.h>
+#include <json-c/json.h>
+
+#include "fpgainfo.h"
+#include "bmcdata.h"
+#include "board.h"
+#include "collect.h"
+#include "mock/opae_std.h"
+
+STATIC void *collect_metrics_thread(void *arg)
+{
+	fpgainfo_device *d = (fpgainfo_device *)arg;
+
+	d->res = get_metrics(d->token, d->inquiry,
+			     d->metrics_info, &d->num_metrics_info,
+			     d->metrics, &d->num_metrics);
+
+	return NULL;
+}
+
+fpgainfo_device *fpgainfo_collect_metrics(fpga_token *tokens,
+					  int num_tokens,
+					  metrics_inquiry inquiry)
+{
+	fpgainfo_device *devices;
+	pthread_t *threads;
+	bool *started;
+	int i;
+
+	if (num_tokens <= 0)
+		return NULL;
+
+	devices = opae_calloc(num_tokens, sizeof(fpgainfo_device));
+	threads = opae_calloc(num_tokens, sizeof(pthread_t));
+	started = opae_calloc(num_tokens, sizeof(bool));
+	if (!devices || !threads || !started)
+		goto out_free;
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		fpgainfo_device *d = &devices[i];
+
+		d->token = tokens[i];
+		d->inquiry = inquiry;
+		d->res = FPGA_NO_MEMORY;
+		d->metrics_info = opae_calloc(METRICS_MAX_NUM,
+					      sizeof(fpga_metric_info));
+		d->metrics = opae_calloc(METRICS_MAX_NUM,
+					 sizeof(fpga_metric));
+		if (!d->metrics_info || !d->metrics)
+			continue;
+
+		// Fall back to reading this device inline.
+		if (pthread_create(&threads[i], NULL,
+				   collect_metrics_thread, d))
+			collect_metrics_thread(d);
+		else
+			started[i] = true;
+	}
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+	}
+
+	opae_free(started);
+	opae_free(threads);
+	return devices;
+
+out_free:
+	if (started)
+		opae_free(started);
+	if (threads)
+		opae_free(threads);
+	if (devices)
+		opae_free(devices);
+	return NULL;
+}
+
+void fpgainfo_free_devices(fpgainfo_device *devices, int num_devices)
+{
+	int i;
+
+	if (!devices)
+		return;
+
+	for (i = 0 ; i < num_devices ; ++i) {
+		if (devices[i].metrics_info)
+			opae_free(devices[i].metrics_info);
+		if (devices[i].metrics)
+			opae_free(devices[i].metrics);
+	}
+
+	opae_free(devices);
+}
+
+STATIC const char *metric_type_to_str(enum fpga_metric_type type)
+{
+	switch (type) {
+	case FPGA_METRIC_TYPE_POWER: return "power";
+	case FPGA_METRIC_TYPE_THERMAL: return "thermal";
+	case FPGA_METRIC_TYPE_PERFORMANCE_CTR: return "performance";
+	case FPGA_METRIC_TYPE_AFU: return "afu";
+	default: return "unknown";
+	}
+}
+
+STATIC json_object *json_hex(uint64_t value, int width)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "0x%0*" PRIx64, width, value);
+	return json_object_new_string(buf);
+}
+
+STATIC json_object *device_props_json(fpga_token token)
+{
+	fpga_properties props = NULL;
+	json_object *jdev;
+	char buf[64];
+	uint16_t segment = 0;
+	uint8_t bus = 0;
+	uint8_t device = 0;
+	uint8_t function = 0;
+	uint64_t object_id = 0;
+	uint16_t u16 = 0;
+	uint8_t socket_id = 0;
+	uint32_t num_slots = 0;
+	uint64_t bbs_id = 0;
+	fpga_version bbs_version = { 0, 0, 0 };
+	fpga_guid guid;
+	fpga_interface ifc = FPGA_IFC_DFL;
+	bool ok;
+
+	jdev = json_object_new_object();
+	if (!jdev)
+		return NULL;
+
+	ok = (fpgaGetProperties(token, &props) == FPGA_OK);
+
+	if (ok &&
+	    (fpgaPropertiesGetSegment(props, &segment) == FPGA_OK) &&
+	    (fpgaPropertiesGetBus(props, &bus) == FPGA_OK) &&
+	    (fpgaPropertiesGetDevice(props, &device) == FPGA_OK) &&
+	    (fpgaPropertiesGetFunction(props, &function) == FPGA_OK)) {
+		snprintf(buf, sizeof(buf), "%04x:%02x:%02x.%x",
+			 segment, bus, device, function);
+		json_object_object_add(jdev, "pcie_address",
+				       json_object_new_string(buf));
+	} else
+		json_object_object_add(jdev, "pcie_address", NULL);
+
+	json_object_object_add(jdev, "interface",
+		ok && (fpgaPropertiesGetInterface(props, &ifc) == FPGA_OK) ?
+		json_object_new_string(fpgainfo_interface_to_str(ifc)) : NULL);
+
+	json_object_object_add(jdev, "object_id",
+		ok && (fpgaPropertiesGetObjectID(props, &object_id) == FPGA_OK) ?
+		json_hex(object_id, 0) : NULL);
+
+	json_object_object_add(jdev, "vendor_id",
+		ok && (fpgaPropertiesGetVendorID(props, &u16) == FPGA_OK) ?
+		json_hex(u16, 4) : NULL);
+
+	json_object_object_add(jdev, "device_id",
+		ok && (fpgaPropertiesGetDeviceID(props, &u16) == FPGA_OK) ?
+		json_hex(u16, 4) : NULL);
+
+	json_object_object_add(jdev, "subsystem_vendor_id",
+		ok && (fpgaPropertiesGetSubsystemVendorID(props, &u16) ==
+		       FPGA_OK) ? json_hex(u16, 4) : NULL);
+
+	json_object_object_add(jdev, "subsystem_device_id",
+		ok && (fpgaPropertiesGetSubsystemDeviceID(props, &u16) ==
+		       FPGA_OK) ? json_hex(u16, 4) : NULL);
+
+	json_object_object_add(jdev, "socket_id",
+		ok && (fpgaPropertiesGetSocketID(props, &socket_id) == FPGA_OK) ?
+		json_object_new_int(socket_id) : NULL);
+
+	json_object_object_add(jdev, "num_slots",
+		ok && (fpgaPropertiesGetNumSlots(props, &num_slots) == FPGA_OK) ?
+		json_object_new_int64(num_slots) : NULL);
+
+	json_object_object_add(jdev, "bitstream_id",
+		ok && (fpgaPropertiesGetBBSID(props, &bbs_id) == FPGA_OK) ?
+		json_hex(bbs_id, 0) : NULL);
+
+	if (ok && (fpgaPropertiesGetBBSVersion(props, &bbs_version) ==
+		   FPGA_OK)) {
+		snprintf(buf, sizeof(buf), "%d.%d.%d", bbs_version.major,
+			 bbs_version.minor, bbs_version.patch);
+		json_object_object_add(jdev, "bitstream_version",
+				       json_object_new_string(buf));
+	} else
+		json_object_object_add(jdev, "bitstream_version", NULL);
+
+	if (ok && (fpgaPropertiesGetGUID(props, &guid) == FPGA_OK)) {
+		uuid_unparse(guid, buf);
+		json_object_object_add(jdev, "pr_interface_id",
+				       json_object_new_string(buf));
+	} else
+		json_object_object_add(jdev, "pr_interface_id", NULL);
+
+	if (props)
+		fpgaDestroyProperties(&props);
+
+	return jdev;
+}
+
+STATIC json_object *metric_json(const fpga_metric_info *info,
+				const fpga_metric *metric)
+{
+	json_object *jmetric;
+	json_object *jvalue = NULL;
+
+	jmetric = json_object_new_object();
+	if (!jmetric)
+		return NULL;
+
+	json_object_object_add(jmetric, "name",
+			       json_object_new_string(info->metric_name));
+	json_object_object_add(jmetric, "group",
+			       json_object_new_string(info->group_name));
+	json_object_object_add(jmetric, "units",
+			       json_object_new_string(info->metric_units));
+	json_object_object_add(jmetric, "type",
+		json_object_new_string(metric_type_to_str(info->metric_type)));
+
+	if (metric->isvalid) {
+		switch (info->metric_datatype) {
+		case FPGA_METRIC_DATATYPE_INT:
+			jvalue = json_object_new_int64(metric->value.ivalue);
+			break;
+		case FPGA_METRIC_DATATYPE_DOUBLE: /* FALLTHROUGH */
+		case FPGA_METRIC_DATATYPE_FLOAT:
+			jvalue = json_object_new_double(metric->value.dvalue);
+			break;
+		case FPGA_METRIC_DATATYPE_BOOL:
+			jvalue = json_object_new_boolean(metric->value.bvalue);
+			break;
+		default:
+			break;
+		}
+	}
+	json_object_object_add(jmetric, "value", jvalue);
+
+	return jmetric;
+}
+
+fpga_result fpgainfo_print_json(FILE *fp, const char *command,
+				fpgainfo_device *devices, int num_devices)
+{
+	json_object *root;
+	json_object *jdevices;
+	int i;
+
+	root = json_object_new_object();
+	jdevices = json_object_new_array();
+	if (!root || !jdevices) {
+		if (root)
+			json_object_put(root);
+		if (jdevices)
+			json_object_put(jdevices);
+		return FPGA_NO_MEMORY;
+	}
+
+	json_object_object_add(root, "version",
+			       json_object_new_int(FPGAINFO_JSON_VERSION));
+	json_object_object_add(root, "command",
+			       json_object_new_string(command));
+	json_object_object_add(root, "devices", jdevices);
+
+	for (i = 0 ; i < num_devices ; ++i) {
+		fpgainfo_device *d = &devices[i];
+		json_object *jdev;
+		json_object *jmetrics;
+		uint64_t j;
+
+		jdev = device_props_json(d->token);
+		if (!jdev)
+			continue;
+		json_object_array_add(jdevices, jdev);
+
+		json_object_object_add(jdev, "error",
+			d->res == FPGA_OK ? NULL :
+			json_object_new_string(fpgaErrStr(d->res)));
+
+		jmetrics = json_object_new_array();
+		json_object_object_add(jdev, "metrics", jmetrics);
+		if ((d->res != FPGA_OK) || !jmetrics)
+			continue;
+
+		for (j = 0 ; j < d->num_metrics ; ++j) {
+			uint64_t idx = d->metrics[j].metric_num;
+
+			if (idx >= d->num_metrics_info)
+				continue;
+
+			json_object_array_add(jmetrics,
+				metric_json(&d->metrics_info[idx],
+					    &d->metrics[j]));
+		}
+	}
+
+	fprintf(fp, "%s\n",
+		json_object_to_json_string_ext(root,
+					       JSON_C_TO_STRING_PRETTY |
+					       JSON_C_TO_STRING_SPACED));
+	json_object_put(root);
+
+	return FPGA_OK;
+}
+
+fpga_result fpgainfo_metrics_command(fpga_token *tokens, int num_tokens,
+				     metrics_inquiry inquiry,
+				     const char *command, const char *hdr,
+				     bool json)
+{
+	fpgainfo_device *devices;
+	fpga_result res = FPGA_OK;
+	int i;
+
+	if (num_tokens <= 0) {
+		if (json)
+			res = fpgainfo_print_json(stdout, command, NULL, 0);
+		return res;
+	}
+
+	devices = fpgainfo_collect_metrics(tokens, num_tokens, inquiry);
+	if (!devices) {
+		OPAE_ERR("Failed to allocate device data\n");
+		return FPGA_NO_MEMORY;
+	}
+
+	if (json) {
+		res = fpgainfo_print_json(stdout, command,
+					  devices, num_tokens);
+		goto out_free;
+	}
+
+	for (i = 0 ; i < num_tokens ; ++i) {
+		fpgainfo_device *d = &devices[i];
+		fpga_properties props = NULL;
+		fpga_result r;
+
+		r = fpgaGetProperties(d->token, &props);
+		ON_FPGAINFO_ERR_GOTO(r, out_next,
+				     "reading properties from token");
+
+		fpgainfo_board_info(d->token);
+		fpgainfo_print_common(hdr, props);
+
+		if (d->res == FPGA_OK)
+			print_metrics(d->metrics_info, d->num_metrics_info,
+				      d->metrics, d->num_metrics);
+		else
+			fpgainfo_print_err("reading metrics from BMC", d->res);
+
+		r = fpgaDestroyProperties(&props);
+		fpgainfo_print_err("destroying properties", r);
+out_next:
+		continue;
+	}
+
+out_free:
+	fpgainfo_free_devices(devices, num_tokens);
+	return res;
+}
@@ -0,0 +1,93 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+/*
+ * @file collect.h
+ *
+ * @brief Parallel per-device metrics collection and JSON output.
+ */
+#ifndef COLLECT_H
+#define COLLECT_H
+
+#include <stdbool.h>
+#include <opae/fpga.h>
+#include "bmcdata.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FPGAINFO_JSON_VERSION 1
+
+typedef struct _fpgainfo_device {
+	fpga_token token;
+	metrics_inquiry inquiry;
+	fpga_result res;
+	fpga_metric_info *metrics_info;
+	uint64_t num_metrics_info;
+	fpga_metric *metrics;
+	uint64_t num_metrics;
+} fpgainfo_device;
+
+/*
+ * Read the metrics selected by inquiry from each of the devices,
+ * using one worker thread per device. Returns an array of
+ * num_tokens entries, or NULL on allocation failure.
+ */
+fpgainfo_device *fpgainfo_collect_metrics(fpga_token *tokens,
+					  int num_tokens,
+					  metrics_inquiry inquiry);
+
+void fpgainfo_free_devices(fpgainfo_device *devices, int num_devices);
+
+/*
+ * Print the collected devices as a JSON document:
+ *
+ * { "version": 1, "command": "bmc", "devices": [ {
+ *     "pcie_address": "0000:3b:00.0", "interface": "DFL",
+ *     "object_id": "0x...", "vendor_id": "0x8086", ...,
+ *     "error": null,
+ *     "metrics": [ { "name": ..., "group": ..., "units": ...,
+ *                    "type": "power", "value": 12.5 } ] } ] }
+ *
+ * Every key is always present; values that can't be read are null.
+ */
+fpga_result fpgainfo_print_json(FILE *fp, const char *command,
+				fpgainfo_device *devices, int num_devices);
+
+/*
+ * Collect the metrics of all devices in parallel, then print them
+ * in device order, either as text under hdr or as JSON.
+ */
+fpga_result fpgainfo_metrics_command(fpga_token *tokens, int num_tokens,
+				     metrics_inquiry inquiry,
+				     const char *command, const char *hdr,
+				     bool json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !COLLECT_H */
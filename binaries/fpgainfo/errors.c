@@ -264,24 +264,20 @@ static void print_errors_str(struct fpga_error_info errinfo,
 	return;
 }
 
-static void print_errors_info(fpga_token token, fpga_properties props,
+static void print_errors_info(fpga_properties props,
 			      struct fpga_error_info *errinfos,
-			      uint32_t num_errors)
+			      const uint64_t *values,
+			      uint32_t num_errors,
+			      uint64_t revision,
+			      bool decode)
 {
 	int i;
 	fpga_result res = FPGA_OK;
 	fpga_objtype objtype;
-	uint64_t revision = 0;
 	if ((NULL == errinfos) || (0 == num_errors)) {
 		return;
 	}
 
-	if (errors_config.clear) {
-		for (i = 0; i < errors_config.force_count; i++) {
-			fpgaClearAllErrors(token);
-		}
-	}
-
 	res = fpgaPropertiesGetObjectType(props, &objtype);
 	fpgainfo_print_err("reading objtype from properties", res);
 
@@ -292,26 +288,11 @@ static void print_errors_info(fpga_token token, fpga_properties props,
 		printf("//****** FME ERRORS ******// \n");
 
 		for (i = 0; i < (int)num_errors; i++) {
-			uint64_t error_value = 0;
-
-			res = fpgaReadError(token, i, &error_value);
-			fpgainfo_print_err("reading error for FME", res);
-
 			printf("%-32s : 0x%" PRIX64 "\n", errinfos[i].name,
-			       error_value);
-
-			res = get_error_revision(token, &revision);
-			if (res == FPGA_NOT_FOUND) {
-				//Todo : fpga-upstream-dev branch remove the revision sysfs node.
-				//if we check the revision is not present, we use the default value
-				revision = 0;
-			} else if (res != FPGA_OK) {
-				OPAE_ERR("could not find FME error revision - skipping decode\n");
-				continue;
-			}
+			       values[i]);
 
-			if (error_value > 0)
-				print_errors_str(errinfos[i], error_value, revision);
+			if (decode && (values[i] > 0))
+				print_errors_str(errinfos[i], values[i], revision);
 
 		}
 	} else if (((VERB_ALL == errors_config.which)
@@ -324,30 +305,104 @@ static void print_errors_info(fpga_token token, fpga_properties props,
 		printf("//****** PORT ERRORS ******// \n");
 
 		for (i = 0; i < (int)num_errors; i++) {
-			uint64_t error_value = 0;
-			res = fpgaReadError(token, i, &error_value);
-			fpgainfo_print_err("reading error for PORT", res);
-
 			printf("%-32s : 0x%" PRIX64 "\n", errinfos[i].name,
-			       error_value);
-
-			res = get_error_revision(token, &revision);
-			if (res == FPGA_NOT_FOUND) {
-				//Todo : fpga-upstream-dev branch remove the revision sysfs node.
-				//if we check the revision is not present, we use the default value
-				revision = 0;
-			} else if (res != FPGA_OK) {
-				OPAE_ERR("could not find port error revision - skipping decode\n");
-				continue;
-			}
+			       values[i]);
 
-			if (error_value > 0)
-				print_errors_str(errinfos[i], error_value, revision);
+			if (decode && (values[i] > 0))
+				print_errors_str(errinfos[i], values[i], revision);
 
 		}
 	}
 }
 
+// Read every error value, plus the error revision, from one
+// fpgaObjectReadGroup() snapshot of the token's "errors" group.
+// Errors that aren't direct members of the group (or whose name
+// isn't unique) fall back to fpgaReadError(). Returns false when
+// the revision can't be determined and the bits can't be decoded.
+static bool read_errors(fpga_token token,
+			struct fpga_error_info *errinfos,
+			uint64_t *values,
+			uint32_t num_errors,
+			uint64_t *revision)
+{
+	fpga_result res;
+	fpga_object group = NULL;
+	fpga_object_value *snapshot = NULL;
+	uint32_t count = 0;
+	bool have_revision = false;
+	bool decode = true;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+
+	res = fpgaTokenGetObject(token, "errors", &group,
+				 FPGA_OBJECT_RECURSE_ONE);
+	if (res == FPGA_OK)
+		res = fpgaObjectGetSize(group, &count, 0);
+	if ((res == FPGA_OK) && count) {
+		snapshot = (fpga_object_value *)opae_calloc(count,
+						sizeof(*snapshot));
+		if (snapshot)
+			res = fpgaObjectReadGroup(group, snapshot, count,
+						  NULL, 0);
+		if (!snapshot || (res != FPGA_OK)) {
+			OPAE_MSG("Failed to read errors group");
+			opae_free(snapshot);
+			snapshot = NULL;
+			count = 0;
+		}
+	}
+
+	for (j = 0; j < count; j++) {
+		if ((snapshot[j].result == FPGA_OK) &&
+		    !strcmp(snapshot[j].name, "revision")) {
+			*revision = snapshot[j].value;
+			have_revision = true;
+		}
+	}
+
+	for (i = 0; i < num_errors; i++) {
+		for (k = 0; k < num_errors; k++) {
+			if ((k != i) &&
+			    !strcmp(errinfos[k].name, errinfos[i].name))
+				break;
+		}
+
+		for (j = 0; (k == num_errors) && (j < count); j++) {
+			if ((snapshot[j].result == FPGA_OK) &&
+			    !strcmp(snapshot[j].name, errinfos[i].name))
+				break;
+		}
+
+		if ((k == num_errors) && (j < count)) {
+			values[i] = snapshot[j].value;
+		} else {
+			values[i] = 0;
+			res = fpgaReadError(token, i, &values[i]);
+			fpgainfo_print_err("reading error", res);
+		}
+	}
+
+	if (!have_revision) {
+		res = get_error_revision(token, revision);
+		if (res == FPGA_NOT_FOUND) {
+			//Todo : fpga-upstream-dev branch remove the revision sysfs node.
+			//if we check the revision is not present, we use the default value
+			*revision = 0;
+		} else if (res != FPGA_OK) {
+			OPAE_ERR("could not find error revision - skipping decode\n");
+			decode = false;
+		}
+	}
+
+	opae_free(snapshot);
+	if (group)
+		fpgaDestroyObject(&group);
+
+	return decode;
+}
+
 fpga_result errors_command(fpga_token *tokens, int num_tokens, int argc,
 			   char *argv[])
 {
@@ -356,6 +411,9 @@ fpga_result errors_command(fpga_token *tokens, int num_tokens, int argc,
 	fpga_result res = FPGA_OK;
 	fpga_properties props;
 	struct fpga_error_info *errinfos = NULL;
+	uint64_t *values = NULL;
+	uint64_t revision = 0;
+	bool decode = true;
 
 	if (errors_config.help_only) {
 		return res;
@@ -373,7 +431,9 @@ fpga_result errors_command(fpga_token *tokens, int num_tokens, int argc,
 				int j;
 				errinfos = (struct fpga_error_info *)opae_calloc(
 					num_errors, sizeof(*errinfos));
-				if (!errinfos) {
+				values = (uint64_t *)opae_calloc(
+					num_errors, sizeof(*values));
+				if (!errinfos || !values) {
 					res = FPGA_NO_MEMORY;
 					OPAE_ERR("Error allocating memory");
 					goto destroy_and_free;
@@ -384,18 +444,34 @@ fpga_result errors_command(fpga_token *tokens, int num_tokens, int argc,
 							       &errinfos[j]);
 					fpgainfo_print_err(
 						"reading error info structure", res);
+				}
+
+				if (errors_config.clear) {
+					for (j = 0; j < errors_config.force_count; j++) {
+						fpgaClearAllErrors(tokens[i]);
+					}
+				}
+
+				decode = read_errors(tokens[i], errinfos, values,
+						     num_errors, &revision);
+
+				for (j = 0; j < (int)num_errors; j++) {
 					replace_chars(errinfos[j].name, '_', ' ');
 					upcase_pci(errinfos[j].name);
 					upcase_first(errinfos[j].name);
 				}
 
-				print_errors_info(tokens[i], props, errinfos, num_errors);
+				print_errors_info(props, errinfos, values,
+						  num_errors, revision, decode);
 			}
 
 		destroy_and_free:
 			if (errinfos)
 				opae_free(errinfos);
 			errinfos = NULL;
+			if (values)
+				opae_free(values);
+			values = NULL;
 			fpgaDestroyProperties(&props);
 			if (res == FPGA_NO_MEMORY) {
 			    break;
@@ -47,7 +47,7 @@ void fpgainfo_print_err(const char *s, fpga_result res)
 		fprintf(stderr, "Error %s: %s\n", s, fpgaErrStr(res));
 }
 
-STATIC const char *fpgainfo_interface_to_str(fpga_interface ifc)
+const char *fpgainfo_interface_to_str(fpga_interface ifc)
 {
 	switch (ifc) {
 	case FPGA_IFC_DFL: return "DFL";
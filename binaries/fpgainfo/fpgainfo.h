@@ -42,6 +42,8 @@ void fpgainfo_print_common(const char *hdr, fpga_properties props);
 
 void fpgainfo_print_err(const char *s, fpga_result res);
 
+const char *fpgainfo_interface_to_str(fpga_interface ifc);
+
 // Replace occurrences of character within string
 void replace_chars(char *str, char match, char rep);
 
@@ -28,6 +28,7 @@
 #include "fpgainfo.h"
 #include "powerinfo.h"
 #include "bmcdata.h"
+#include "collect.h"
 #include "board.h"
 #include <opae/fpga.h>
 #include <uuid/uuid.h>
@@ -40,39 +41,12 @@
 void power_help(void)
 {
 	printf("\nPrint power metrics\n"
-	       "        fpgainfo power [-h]\n"
+	       "        fpgainfo power [-h] [-J]\n"
 	       "                -h,--help           Print this help\n"
+	       "                -J,--json           Print JSON output\n"
 	       "\n");
 }
 
-static void print_power_info(fpga_token token)
-{
-	fpga_properties props = NULL;
-	fpga_metric_info metrics_info[METRICS_MAX_NUM] = { { 0 } };
-	fpga_metric metrics[METRICS_MAX_NUM] = { { 0 } };
-	uint64_t num_metrics;
-	uint64_t num_metrics_info;
-	fpga_result res = FPGA_OK;
-
-	res = fpgaGetProperties(token, &props);
-	ON_FPGAINFO_ERR_GOTO(res, out_destroy, "reading properties from token");
-
-	fpgainfo_board_info(token);
-	fpgainfo_print_common("//****** POWER ******//", props);
-
-	res = get_metrics(token, FPGA_POWER, metrics_info, &num_metrics_info, metrics, &num_metrics);
-	ON_FPGAINFO_ERR_GOTO(res, out_destroy, "reading metrics from BMC");
-
-	print_metrics(metrics_info, num_metrics_info, metrics, num_metrics);
-
-out_destroy:
-	res = fpgaDestroyProperties(&props);
-	ON_FPGAINFO_ERR_GOTO(res, out_exit, "destroying properties");
-
-out_exit:
-	return;
-}
-
 fpga_result power_filter(fpga_properties *filter, int argc, char *argv[])
 {
 	(void)argc;
@@ -96,14 +70,16 @@ fpga_result power_command(fpga_token *tokens, int num_tokens, int argc,
 	optind = 0;
 	struct option longopts[] = {
 		{"help", no_argument, NULL, 'h'},
+		{"json", no_argument, NULL, 'J'},
 		{0, 0, 0, 0},
 	};
+	bool json = false;
 
 	int getopt_ret;
 	int option_index;
 
 	while (-1
-	       != (getopt_ret = getopt_long(argc, argv, ":h", longopts,
+	       != (getopt_ret = getopt_long(argc, argv, ":hJ", longopts,
 					    &option_index))) {
 		const char *tmp_optarg = optarg;
 
@@ -116,6 +92,10 @@ fpga_result power_command(fpga_token *tokens, int num_tokens, int argc,
 			power_help();
 			return res;
 
+		case 'J': /* json */
+			json = true;
+			break;
+
 		case ':': /* missing option argument */
 			fprintf(stderr, "Missing option argument\n");
 			power_help();
@@ -129,10 +109,6 @@ fpga_result power_command(fpga_token *tokens, int num_tokens, int argc,
 		}
 	}
 
-	int i = 0;
-	for (i = 0; i < num_tokens; ++i) {
-		print_power_info(tokens[i]);
-	}
-
-	return res;
+	return fpgainfo_metrics_command(tokens, num_tokens, FPGA_POWER, "power",
+					"//****** POWER ******//", json);
 }
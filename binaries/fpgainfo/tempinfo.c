@@ -28,6 +28,7 @@
 #include "fpgainfo.h"
 #include "tempinfo.h"
 #include "bmcdata.h"
+#include "collect.h"
 #include "board.h"
 #include <sys/stat.h>
 #include <opae/fpga.h>
@@ -39,39 +40,12 @@
 void temp_help(void)
 {
 	printf("\nPrint thermal metrics\n"
-	       "        fpgainfo temp [-h]\n"
+	       "        fpgainfo temp [-h] [-J]\n"
 	       "                -h,--help           Print this help\n"
+	       "                -J,--json           Print JSON output\n"
 	       "\n");
 }
 
-static void print_temp_info(fpga_token token)
-{
-	fpga_properties props = NULL;
-	fpga_metric_info metrics_info[METRICS_MAX_NUM];
-	fpga_metric metrics[METRICS_MAX_NUM];
-	uint64_t num_metrics;
-	uint64_t num_metrics_info;
-	fpga_result res = FPGA_OK;
-
-	res = fpgaGetProperties(token, &props);
-	ON_FPGAINFO_ERR_GOTO(res, out_exit, "Failure reading properties from token");
-
-	fpgainfo_board_info(token);
-	fpgainfo_print_common("//****** TEMP ******//", props);
-
-	res = get_metrics(token, FPGA_THERMAL, metrics_info, &num_metrics_info, metrics, &num_metrics);
-	ON_FPGAINFO_ERR_GOTO(res, out_destroy, "reading metrics from BMC");
-
-	print_metrics(metrics_info, num_metrics_info, metrics, num_metrics);
-
-out_destroy:
-	res = fpgaDestroyProperties(&props);
-	ON_FPGAINFO_ERR_GOTO(res, out_exit, "destroying properties");
-
-out_exit:
-	return;
-}
-
 fpga_result temp_filter(fpga_properties *filter, int argc, char *argv[])
 {
 	(void)argc;
@@ -95,14 +69,16 @@ fpga_result temp_command(fpga_token *tokens, int num_tokens, int argc,
 	optind = 0;
 	struct option longopts[] = {
 		{"help", no_argument, NULL, 'h'},
+		{"json", no_argument, NULL, 'J'},
 		{0, 0, 0, 0},
 	};
+	bool json = false;
 
 	int getopt_ret;
 	int option_index;
 
 	while (-1
-	       != (getopt_ret = getopt_long(argc, argv, ":h", longopts,
+	       != (getopt_ret = getopt_long(argc, argv, ":hJ", longopts,
 					    &option_index))) {
 		const char *tmp_optarg = optarg;
 
@@ -115,6 +91,10 @@ fpga_result temp_command(fpga_token *tokens, int num_tokens, int argc,
 			temp_help();
 			return res;
 
+		case 'J': /* json */
+			json = true;
+			break;
+
 		case ':': /* missing option argument */
 			fprintf(stderr, "Missing option argument\n");
 			temp_help();
@@ -128,10 +108,6 @@ fpga_result temp_command(fpga_token *tokens, int num_tokens, int argc,
 		}
 	}
 
-	int i = 0;
-	for (i = 0; i < num_tokens; ++i) {
-		print_temp_info(tokens[i]);
-	}
-
-	return res;
+	return fpgainfo_metrics_command(tokens, num_tokens, FPGA_THERMAL, "temp",
+					"//****** TEMP ******//", json);
 }
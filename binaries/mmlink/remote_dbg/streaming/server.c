@@ -30,11 +30,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h> // offsetof
+#include <time.h>
 
 #include "server.h"
 #include "packet.h"
 #include "constants.h"
 
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+#include <sys/epoll.h>
+#endif
+
 const SERVER_BUFFERS SERVER_BUFFERS_default = {
     .ctrl_rx_buff = NULL,
     .ctrl_rx_buff_sz = 0,
@@ -83,7 +88,7 @@ const SERVER_CONN SERVER_CONN_default = {
     .server_fd = INVALID_SOCKET,
     .t2h_nagle = 0,
     .mgmt_rsp_nagle = 0,
-    .pkt_stats = { 0, 0, 0, 0 }
+    .pkt_stats = { 0, 0, 0, 0, 0, 0 }
 };
 const SERVER_HW_CALLBACKS SERVER_HW_CALLBACKS_default = {
     .init_driver = NULL,
@@ -100,7 +105,7 @@ const SERVER_HW_CALLBACKS SERVER_HW_CALLBACKS_default = {
     .get_param = NULL,
     .server_printf = printf
 };
-const SERVER_PKT_STATS SERVER_PKT_STATS_default = { 0, 0, 0, 0 };
+const SERVER_PKT_STATS SERVER_PKT_STATS_default = { 0, 0, 0, 0, 0, 0 };
 const CLIENT_CONN CLIENT_CONN_default = { INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET };
 
 // Global variables
@@ -486,6 +491,21 @@ unsigned long buff_len_to_wrap_boundary(char *buff_sa, size_t buff_sz, char *buf
     }
 }
 
+int wrapped_buffer_iov(char *buff_sa, size_t buff_sz, char *buff, size_t payload_sz, char use_wrapping, SOCKET_IOVEC iov[2]) {
+    size_t first_len;
+    if (use_wrapping && ((first_len = buff_len_to_wrap_boundary(buff_sa, buff_sz, buff, payload_sz)) != 0)) {
+        // Wraps, the payload continues at the start of the buffer
+        iov[0].iov_base = buff;
+        iov[0].iov_len = first_len;
+        iov[1].iov_base = buff_sa;
+        iov[1].iov_len = payload_sz - first_len;
+        return 2;
+    }
+    iov[0].iov_base = buff;
+    iov[0].iov_len = payload_sz;
+    return 1;
+}
+
 RETURN_CODE update_curr_h2t_header(CLIENT_CONN *client_conn, SERVER_CONN *server_conn) {
     if (server_conn->h2t_waiting == 0) {
         ssize_t bytes_recvd;
@@ -512,19 +532,13 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
         // Recv H2T payload
         if (h2t_buff != NULL) {
             server_conn->pkt_stats.h2t_cnt++;
+            server_conn->pkt_stats.h2t_bytes += bytes_to_transfer;
             server_conn->h2t_waiting = 0;
-            size_t first_len;
-            if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->h2t_rx_buff, server_conn->buff->h2t_rx_buff_sz, h2t_buff, header->DATA_LEN_BYTES)) != 0)) {
-                // Wrap, 2 recv necessary
-                size_t second_len = header->DATA_LEN_BYTES - first_len;
-                has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, h2t_buff, first_len, 0, &bytes_recvd);
-                if (has_error == OK) {
-                    has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, server_conn->buff->h2t_rx_buff, second_len, 0, &bytes_recvd);
-                }
-            } else {
-                // No wrap
-            	has_error = socket_recv_accumulate_h2t_data(client_conn->h2t_data_fd, h2t_buff, bytes_to_transfer, 0, &bytes_recvd);
-            }
+
+            // A single receive, even when the payload wraps
+            SOCKET_IOVEC payload[2];
+            int payload_cnt = wrapped_buffer_iov(server_conn->buff->h2t_rx_buff, server_conn->buff->h2t_rx_buff_sz, h2t_buff, bytes_to_transfer, server_conn->buff->use_wrapping_data_buffers, payload);
+            has_error = socket_recvv_accumulate_h2t_data(client_conn->h2t_data_fd, payload, payload_cnt, 0, &bytes_recvd);
 
             // Push to driver or loopback
             if (has_error == OK) {
@@ -532,14 +546,11 @@ RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
                     // Normal operation, push the transaction to HW
                     has_error = (server_conn->hw_callbacks.h2t_data_received != NULL) ? server_conn->hw_callbacks.h2t_data_received(header, (unsigned char *)h2t_buff) : OK;
                 } else {
-                    // Send the header
-                    if ((has_error = socket_send_all(client_conn->t2h_data_fd, server_conn->buff->h2t_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER, 0, &bytes_recvd)) == OK) {
-                        // Send the payload
-                        if ((has_error = socket_send_all_t2h_data(client_conn->t2h_data_fd, h2t_buff, bytes_to_transfer, 0, &bytes_recvd)) != OK) {
-                            print_last_socket_error_b("Failed to send loopback T2H data", bytes_recvd, server_conn->hw_callbacks.server_printf);
-                        }
-                    } else {
-                        print_last_socket_error_b("Failed to send loopback T2H header", bytes_recvd, server_conn->hw_callbacks.server_printf);
+                    // Send the header and payload together
+                    server_conn->pkt_stats.t2h_cnt++;
+                    server_conn->pkt_stats.t2h_bytes += bytes_to_transfer;
+                    if ((has_error = socket_send_packet_t2h_data(client_conn->t2h_data_fd, server_conn->buff->h2t_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER, payload, payload_cnt, 0, &bytes_recvd)) != OK) {
+                        print_last_socket_error_b("Failed to send loopback T2H packet", bytes_recvd, server_conn->hw_callbacks.server_printf);
                     }
                 }
             } else {
@@ -581,18 +592,13 @@ RETURN_CODE process_mgmt_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn
         if (mgmt_buff != NULL) {
             server_conn->pkt_stats.mgmt_cnt++;
             server_conn->mgmt_waiting = 0;
-            size_t first_len;
-            if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->mgmt_rx_buff, server_conn->buff->mgmt_rx_buff_sz, mgmt_buff, header->DATA_LEN_BYTES)) != 0)) {
-                // Wrap, 2 recv necessary
-                size_t second_len = header->DATA_LEN_BYTES - first_len;
-                has_error = socket_recv_accumulate(client_conn->mgmt_fd, mgmt_buff, first_len, 0, &bytes_recvd);
-                if (has_error == OK) {
-                    has_error = socket_recv_accumulate(client_conn->mgmt_fd, server_conn->buff->mgmt_rx_buff, second_len, 0, &bytes_recvd);
-                }
-            } else {
-                // No wrap
-                has_error = socket_recv_accumulate(client_conn->mgmt_fd, mgmt_buff, bytes_to_transfer, 0, &bytes_recvd);
-            }
+
+            // A single receive, even when the payload wraps
+            SOCKET_IOVEC payload[2];
+            int payload_cnt = wrapped_buffer_iov(server_conn->buff->mgmt_rx_buff, server_conn->buff->mgmt_rx_buff_sz, mgmt_buff, bytes_to_transfer, server_conn->buff->use_wrapping_data_buffers, payload);
+            SOCKET_IOVEC iov[3];
+            memcpy(iov, payload, payload_cnt * sizeof(SOCKET_IOVEC));
+            has_error = socket_recvv_accumulate(client_conn->mgmt_fd, iov, payload_cnt, 0, &bytes_recvd);
 
             // Push to driver or loopback
             if (has_error == OK) {
@@ -600,14 +606,12 @@ RETURN_CODE process_mgmt_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn
                     // Normal operation, push the transaction to HW
                     has_error = (server_conn->hw_callbacks.mgmt_data_received != NULL) ? server_conn->hw_callbacks.mgmt_data_received(header, (unsigned char *)mgmt_buff) : OK;
                 } else {
-                    // Send the header
-                    if ((has_error = socket_send_all(client_conn->mgmt_rsp_fd, server_conn->buff->mgmt_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_MGMT_PACKET_HEADER, 0, &bytes_recvd)) == OK) {
-                        // Send the payload
-                        if ((has_error = socket_send_all(client_conn->mgmt_rsp_fd, mgmt_buff, bytes_to_transfer, 0, &bytes_recvd)) != OK) {
-                            print_last_socket_error_b("Failed to send loopback MGMT RSP data", bytes_recvd, server_conn->hw_callbacks.server_printf);
-                        }
-                    } else {
-                        print_last_socket_error_b("Failed to send loopback MGMT RSP header", bytes_recvd, server_conn->hw_callbacks.server_printf);
+                    // Send the header and payload together
+                    iov[0].iov_base = server_conn->buff->mgmt_header_buff;
+                    iov[0].iov_len = SIZEOF_PACKET_GUARDBAND + SIZEOF_MGMT_PACKET_HEADER;
+                    memcpy(iov + 1, payload, payload_cnt * sizeof(SOCKET_IOVEC));
+                    if ((has_error = socket_sendv_all(client_conn->mgmt_rsp_fd, iov, payload_cnt + 1, 0, &bytes_recvd)) != OK) {
+                        print_last_socket_error_b("Failed to send loopback MGMT RSP packet", bytes_recvd, server_conn->hw_callbacks.server_printf);
                     }
                 }
             } else {
@@ -634,22 +638,14 @@ RETURN_CODE process_t2h_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn)
             return has_error;
         }
         server_conn->pkt_stats.t2h_cnt++;
-        if ((has_error = socket_send_all(client_conn->t2h_data_fd, (const char *)server_conn->buff->t2h_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER, 0, &bytes_sent)) == OK) {
-            size_t first_len;
-            if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->t2h_tx_buff, server_conn->buff->t2h_tx_buff_sz, (char *)t2h_buff, header->DATA_LEN_BYTES)) != 0)) {
-                // Wrap, 2 sends necessary
-            	size_t second_len = header->DATA_LEN_BYTES - first_len;
-            	if ((has_error = socket_send_all_t2h_data(client_conn->t2h_data_fd, (const char *)t2h_buff, first_len, 0, &bytes_sent)) == OK) {
-                    has_error = socket_send_all_t2h_data(client_conn->t2h_data_fd, (const char *)server_conn->buff->t2h_tx_buff, second_len, 0, &bytes_sent);
-            	}
-            } else {
-                // No wrap
-                has_error = socket_send_all_t2h_data(client_conn->t2h_data_fd, (const char *)t2h_buff, curr_payload_bytes, 0, &bytes_sent);
-            }
-            if (has_error == OK) {
-                if (server_conn->hw_callbacks.t2h_data_complete != NULL) {
-                    server_conn->hw_callbacks.t2h_data_complete();
-                }
+        server_conn->pkt_stats.t2h_bytes += curr_payload_bytes;
+
+        // Send the header and payload together, even when the payload wraps
+        SOCKET_IOVEC payload[2];
+        int payload_cnt = wrapped_buffer_iov(server_conn->buff->t2h_tx_buff, server_conn->buff->t2h_tx_buff_sz, (char *)t2h_buff, curr_payload_bytes, server_conn->buff->use_wrapping_data_buffers, payload);
+        if ((has_error = socket_send_packet_t2h_data(client_conn->t2h_data_fd, (const char *)server_conn->buff->t2h_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_H2T_PACKET_HEADER, payload, payload_cnt, 0, &bytes_sent)) == OK) {
+            if (server_conn->hw_callbacks.t2h_data_complete != NULL) {
+                server_conn->hw_callbacks.t2h_data_complete();
             }
         }
         if (has_error != OK) {
@@ -672,22 +668,15 @@ RETURN_CODE process_mgmt_rsp_data(CLIENT_CONN *client_conn, SERVER_CONN *server_
             return has_error;
         }
         server_conn->pkt_stats.mgmt_rsp_cnt++;
-        if ((has_error = socket_send_all(client_conn->mgmt_rsp_fd, (const char *)server_conn->buff->mgmt_rsp_header_buff, SIZEOF_PACKET_GUARDBAND + SIZEOF_MGMT_PACKET_HEADER, 0, &bytes_sent)) == OK) {
-            size_t first_len;
-            if (server_conn->buff->use_wrapping_data_buffers && ((first_len = buff_len_to_wrap_boundary(server_conn->buff->mgmt_rsp_tx_buff, server_conn->buff->mgmt_rsp_tx_buff_sz, (char *)mgmt_rsp_buff, header->DATA_LEN_BYTES)) != 0)) {
-                // Wrap, 2 sends necessary
-                size_t second_len = header->DATA_LEN_BYTES - first_len;
-                if ((has_error = socket_send_all(client_conn->mgmt_rsp_fd, (const char *)mgmt_rsp_buff, first_len, 0, &bytes_sent)) == OK) {
-                    has_error = socket_send_all(client_conn->mgmt_rsp_fd, (const char *)server_conn->buff->mgmt_rsp_tx_buff, second_len, 0, &bytes_sent);
-                }
-            } else {
-                // No wrap
-                has_error = socket_send_all(client_conn->mgmt_rsp_fd, (const char *)mgmt_rsp_buff, curr_payload_bytes, 0, &bytes_sent);
-            }
-            if (has_error == OK) {
-                if (server_conn->hw_callbacks.mgmt_rsp_data_complete != NULL) {
-                    server_conn->hw_callbacks.mgmt_rsp_data_complete();
-                }
+
+        // Send the header and payload together, even when the payload wraps
+        SOCKET_IOVEC iov[3];
+        iov[0].iov_base = server_conn->buff->mgmt_rsp_header_buff;
+        iov[0].iov_len = SIZEOF_PACKET_GUARDBAND + SIZEOF_MGMT_PACKET_HEADER;
+        int payload_cnt = wrapped_buffer_iov(server_conn->buff->mgmt_rsp_tx_buff, server_conn->buff->mgmt_rsp_tx_buff_sz, (char *)mgmt_rsp_buff, curr_payload_bytes, server_conn->buff->use_wrapping_data_buffers, iov + 1);
+        if ((has_error = socket_sendv_all(client_conn->mgmt_rsp_fd, iov, payload_cnt + 1, 0, &bytes_sent)) == OK) {
+            if (server_conn->hw_callbacks.mgmt_rsp_data_complete != NULL) {
+                server_conn->hw_callbacks.mgmt_rsp_data_complete();
             }
         }
         if (has_error != OK) {
@@ -719,27 +708,231 @@ void reject_client(SERVER_CONN *server_conn) {
     }
 }
 
+// Indices of the sockets serviced for a connected client
+enum {
+    SERVER_FD_IDX,
+    CTRL_FD_IDX,
+    MGMT_FD_IDX,
+    MGMT_RSP_FD_IDX,
+    H2T_FD_IDX,
+    T2H_FD_IDX,
+    NUM_CLIENT_FDS
+};
+
+// Readiness of each socket, as reported by select() or epoll
+typedef struct {
+    char readable[NUM_CLIENT_FDS];
+    char writable[NUM_CLIENT_FDS];
+    char exception[NUM_CLIENT_FDS];
+} CLIENT_EVENTS;
+
+static void get_client_fds(SERVER_CONN *server_conn, CLIENT_CONN *client_conn, SOCKET all_fds[NUM_CLIENT_FDS], const char *all_fd_names[NUM_CLIENT_FDS]) {
+    all_fds[SERVER_FD_IDX] = server_conn->server_fd;
+    all_fds[CTRL_FD_IDX] = client_conn->ctrl_fd;
+    all_fds[MGMT_FD_IDX] = client_conn->mgmt_fd;
+    all_fds[MGMT_RSP_FD_IDX] = client_conn->mgmt_rsp_fd;
+    all_fds[H2T_FD_IDX] = client_conn->h2t_data_fd;
+    all_fds[T2H_FD_IDX] = client_conn->t2h_data_fd;
+    all_fd_names[SERVER_FD_IDX] = SERVER_SOCK_NAME;
+    all_fd_names[CTRL_FD_IDX] = CONTROL_SOCK_NAME;
+    all_fd_names[MGMT_FD_IDX] = MANAGEMENT_SOCK_NAME;
+    all_fd_names[MGMT_RSP_FD_IDX] = MANAGEMENT_RSP_SOCK_NAME;
+    all_fd_names[H2T_FD_IDX] = H2T_SOCK_NAME;
+    all_fd_names[T2H_FD_IDX] = T2H_SOCK_NAME;
+}
+
+// Returns 1 when the client should be disconnected
+static char service_client_events(SERVER_CONN *server_conn, CLIENT_CONN *client_conn, const CLIENT_EVENTS *events, const char *all_fd_names[NUM_CLIENT_FDS]) {
+    // First handle exceptional conditions
+    char disconnect_client = 0;
+    for (int i = 0; i < NUM_CLIENT_FDS; ++i) {
+        if (events->exception[i]) {
+            server_conn->hw_callbacks.server_printf("Exception found on socket: %s\n", all_fd_names[i]);
+            return 1;
+        }
+    }
+
+    // Check for additional clients attempting to connect,
+    // if so, politely tell them to get lost.
+    if (events->readable[SERVER_FD_IDX]) {
+        reject_client(server_conn);
+    }
+
+    // See if any incoming control messages are present
+    if (events->readable[CTRL_FD_IDX]) {
+        if (process_control_message(client_conn, server_conn, &disconnect_client) == FAILURE) {
+            return 1;
+        }
+
+        if (disconnect_client) {
+            return 1;
+        }
+    }
+
+    // See if any incoming management commands are present
+    if (events->readable[MGMT_FD_IDX]) {
+        if (process_mgmt_data(client_conn, server_conn) == FAILURE) {
+            return 1;
+        }
+    }
+
+    // Lastly handle incoming H2T data
+    if (events->readable[H2T_FD_IDX]) {
+        if (process_h2t_data(client_conn, server_conn) == FAILURE) {
+            return 1;
+        }
+    }
+
+    // See if any outbound management data is present, if so send it out
+    if (server_conn->loopback_mode == 0) {
+        if (events->writable[MGMT_RSP_FD_IDX]) {
+            if (server_conn->hw_callbacks.acquire_mgmt_rsp_data != NULL) {
+                if (process_mgmt_rsp_data(client_conn, server_conn) == FAILURE) {
+                    return 1;
+                }
+            }
+        }
+
+        // See if any outbound t2h data is present, if so send it out
+        if (events->writable[T2H_FD_IDX]) {
+            if (server_conn->hw_callbacks.acquire_t2h_data != NULL) {
+                if (process_t2h_data(client_conn, server_conn) == FAILURE) {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Summarizes the session, e.g. to measure throughput with the server in loopback mode
+static void print_client_stats(SERVER_CONN *server_conn, const struct timespec *start) {
+    const SERVER_PKT_STATS *stats = &server_conn->pkt_stats;
+    const double secs = elapsed_seconds(start);
+    const size_t bytes = stats->h2t_bytes + stats->t2h_bytes;
+    if ((stats->h2t_cnt == 0) && (stats->t2h_cnt == 0)) {
+        return;
+    }
+    server_conn->hw_callbacks.server_printf("H2T: %zu packets, %zu bytes. T2H: %zu packets, %zu bytes. %.3f s, %.2f MB/s\n",
+        stats->h2t_cnt, stats->h2t_bytes, stats->t2h_cnt, stats->t2h_bytes,
+        secs, (secs > 0.0) ? ((double)bytes / secs) / 1e6 : 0.0);
+}
+
+static int set_client_epoll_events(int epoll_fd, SOCKET fd, int idx, uint32_t events) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u32 = (uint32_t)idx;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
+    SOCKET all_fds[NUM_CLIENT_FDS];
+    const char *all_fd_names[NUM_CLIENT_FDS];
+    struct epoll_event ready[NUM_CLIENT_FDS];
+    struct epoll_event ev;
+    struct timespec start;
+    char polling_hw = -1;
+    int epoll_fd;
+    int i;
+
+    get_client_fds(server_conn, client_conn, all_fds, all_fd_names);
+
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        print_last_socket_error("epoll_create1 failure", server_conn->hw_callbacks.server_printf);
+        return;
+    }
+
+    // The server, Ctrl, H2T and MGMT sockets are read-only. T2H & MGMT_RSP are
+    // write-only, and are only polled while there may be hardware data to send.
+    // Any socket can have an exception.
+    for (i = 0; i < NUM_CLIENT_FDS; ++i) {
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLPRI;
+        if ((i != T2H_FD_IDX) && (i != MGMT_RSP_FD_IDX)) {
+            ev.events |= EPOLLIN;
+        }
+        ev.data.u32 = (uint32_t)i;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, all_fds[i], &ev) < 0) {
+            print_last_socket_error("epoll_ctl failure", server_conn->hw_callbacks.server_printf);
+            close(epoll_fd);
+            return;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (1) {
+        // The outbound sockets are almost always writable, so waiting on them
+        // turns this into a busy poll of the hardware. Don't in loopback mode.
+        const char poll_hw = (server_conn->loopback_mode == 0) ? 1 : 0;
+        if (poll_hw != polling_hw) {
+            const uint32_t out = poll_hw ? EPOLLOUT : 0;
+            if ((set_client_epoll_events(epoll_fd, client_conn->t2h_data_fd, T2H_FD_IDX, EPOLLPRI | out) < 0) ||
+                (set_client_epoll_events(epoll_fd, client_conn->mgmt_rsp_fd, MGMT_RSP_FD_IDX, EPOLLPRI | out) < 0)) {
+                print_last_socket_error("epoll_ctl failure", server_conn->hw_callbacks.server_printf);
+                break;
+            }
+            polling_hw = poll_hw;
+        }
+
+        int num_ready = epoll_wait(epoll_fd, ready, NUM_CLIENT_FDS, 1000);
+        if (num_ready < 0) {
+            print_last_socket_error("epoll_wait failure", server_conn->hw_callbacks.server_printf);
+            break;
+        }
+
+        CLIENT_EVENTS events;
+        memset(&events, 0, sizeof(events));
+        for (i = 0; i < num_ready; ++i) {
+            const uint32_t idx = ready[i].data.u32;
+            const uint32_t e = ready[i].events;
+            if (e & EPOLLIN) {
+                events.readable[idx] = 1;
+            }
+            if (e & EPOLLOUT) {
+                events.writable[idx] = 1;
+            }
+            if (e & (EPOLLPRI | EPOLLERR)) {
+                events.exception[idx] = 1;
+            }
+            if (e & EPOLLHUP) {
+                // Let the read report the hang-up where there is one.
+                if ((idx == T2H_FD_IDX) || (idx == MGMT_RSP_FD_IDX)) {
+                    events.exception[idx] = 1;
+                } else {
+                    events.readable[idx] = 1;
+                }
+            }
+        }
+
+        if (service_client_events(server_conn, client_conn, &events, all_fd_names)) {
+            break;
+        }
+    }
+
+    print_client_stats(server_conn, &start);
+    close(epoll_fd);
+}
+#else
 void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
     fd_set read_fds;
     fd_set write_fds;
     fd_set except_fds;
-    enum { NUM_FDS = 6 };
-    SOCKET all_fds[NUM_FDS];
-    all_fds[0] = server_conn->server_fd;
-    all_fds[1] = client_conn->ctrl_fd;
-    all_fds[2] = client_conn->mgmt_fd;
-    all_fds[3] = client_conn->mgmt_rsp_fd;
-    all_fds[4] = client_conn->h2t_data_fd;
-    all_fds[5] = client_conn->t2h_data_fd;
-    const char *all_fd_names[NUM_FDS];
-    all_fd_names[0] = SERVER_SOCK_NAME;
-    all_fd_names[1] = CONTROL_SOCK_NAME;
-    all_fd_names[2] = MANAGEMENT_SOCK_NAME;
-    all_fd_names[3] = MANAGEMENT_RSP_SOCK_NAME;
-    all_fd_names[4] = H2T_SOCK_NAME;
-    all_fd_names[5] = T2H_SOCK_NAME;
-
-    SOCKET max_fd = max_of(all_fds, NUM_FDS) + 1;
+    SOCKET all_fds[NUM_CLIENT_FDS];
+    const char *all_fd_names[NUM_CLIENT_FDS];
+
+    get_client_fds(server_conn, client_conn, all_fds, all_fd_names);
+
+    SOCKET max_fd = max_of(all_fds, NUM_CLIENT_FDS) + 1;
 
     while (1) {
         FD_ZERO(&read_fds);
@@ -773,72 +966,20 @@ void handle_client(SERVER_CONN *server_conn, CLIENT_CONN *client_conn) {
             print_last_socket_error("Select failure", server_conn->hw_callbacks.server_printf);
             break;
         }
-        
-        // First handle exceptional conditions
-        char disconnect_client = 0;
-        for (int i = 0; i < NUM_FDS; ++i) {
-            if (FD_ISSET(all_fds[i], &except_fds)) {
-                server_conn->hw_callbacks.server_printf("Exception found on socket: %s\n", all_fd_names[i]);
-                disconnect_client = 1;
-                break;
-            }
-        }
-        if (disconnect_client) {
-            break;
-        }
-        
-        // Check for additional clients attempting to connect,
-        // if so, politely tell them to get lost.
-        if (FD_ISSET(server_conn->server_fd, &read_fds)) {
-            reject_client(server_conn);
-        }
-
-        // See if any incoming control messages are present
-        if (FD_ISSET(client_conn->ctrl_fd, &read_fds)) {
-            if (process_control_message(client_conn, server_conn, &disconnect_client) == FAILURE) {
-                break;
-            }
 
-            if (disconnect_client) {
-                break;
-            }
-        }
-        
-        // See if any incoming management commands are present
-        if (FD_ISSET(client_conn->mgmt_fd, &read_fds)) {
-            if (process_mgmt_data(client_conn, server_conn) == FAILURE) {
-                break;
-            }
-        }
-
-        // Lastly handle incoming H2T data
-        if (FD_ISSET(client_conn->h2t_data_fd, &read_fds)) {
-            if (process_h2t_data(client_conn, server_conn) == FAILURE) {
-                break;
-            }
+        CLIENT_EVENTS events;
+        for (int i = 0; i < NUM_CLIENT_FDS; ++i) {
+            events.readable[i] = FD_ISSET(all_fds[i], &read_fds) ? 1 : 0;
+            events.writable[i] = FD_ISSET(all_fds[i], &write_fds) ? 1 : 0;
+            events.exception[i] = FD_ISSET(all_fds[i], &except_fds) ? 1 : 0;
         }
 
-        // See if any outbound management data is present, if so send it out
-        if (server_conn->loopback_mode == 0) {
-            if (FD_ISSET(client_conn->mgmt_rsp_fd, &write_fds)) {
-                if (server_conn->hw_callbacks.acquire_mgmt_rsp_data != NULL) {
-                    if (process_mgmt_rsp_data(client_conn, server_conn) == FAILURE) {
-                        break;
-                    }
-                }
-            }
-
-            // See if any outbound t2h data is present, if so send it out
-            if (FD_ISSET(client_conn->t2h_data_fd, &write_fds)) {
-                if (server_conn->hw_callbacks.acquire_t2h_data != NULL) {
-                    if (process_t2h_data(client_conn, server_conn) == FAILURE) {
-                        break;
-                    }
-                }
-            }
+        if (service_client_events(server_conn, client_conn, &events, all_fd_names)) {
+            break;
         }
     }
 }
+#endif
 
 RETURN_CODE initialize_server(unsigned short port, SERVER_CONN *server_conn, const char *port_filename) {
     if (initialize_sockets_library() == FAILURE) {
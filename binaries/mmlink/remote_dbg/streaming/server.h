@@ -129,6 +129,8 @@ typedef struct {
     size_t t2h_cnt;
     size_t mgmt_cnt;
     size_t mgmt_rsp_cnt;
+    size_t h2t_bytes;
+    size_t t2h_bytes;
 } SERVER_PKT_STATS;
 
 typedef struct {
@@ -182,6 +184,7 @@ const char *get_driver_parameter(char *cmd, SERVER_CONN *server_conn);
 const char *set_driver_parameter(char *cmd, SERVER_CONN *server_conn);
 RETURN_CODE process_control_message(CLIENT_CONN *client_conn, SERVER_CONN *server_conn, char *disconnect_client);
 unsigned long buff_len_to_wrap_boundary(char *buff_sa, size_t buff_sz, char *buff, size_t payload_sz);
+int wrapped_buffer_iov(char *buff_sa, size_t buff_sz, char *buff, size_t payload_sz, char use_wrapping, SOCKET_IOVEC iov[2]);
 RETURN_CODE update_curr_h2t_header(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
 RETURN_CODE process_h2t_data(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
 RETURN_CODE update_curr_mgmt_header(CLIENT_CONN *client_conn, SERVER_CONN *server_conn);
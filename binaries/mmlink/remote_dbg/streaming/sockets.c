@@ -136,20 +136,121 @@ RETURN_CODE socket_send_all(SOCKET fd, const char *buff, const size_t len, int f
 }
 
 
-RETURN_CODE socket_send_all_t2h_data(SOCKET fd, const char *buff, const size_t len, int flags, ssize_t *bytes_sent) {
-    // First copy the mmio ptr into local memory domain
-    volatile uint64_t *mmio_ptr = (uint64_t *)buff;
-    uint64_t *buff64 = (uint64_t *)g_socket_send_buff;
+// Device memory is only accessed 64 bits at a time, so payloads are staged
+// through local buffers.
+static size_t copy_from_mmio(char *dst, const char *src, size_t len) {
+    volatile uint64_t *mmio_ptr = (uint64_t *)src;
+    size_t transfers = (len + 7) / 8;
+    for (size_t i = 0; i < transfers; ++i) {
+        uint64_t v = *mmio_ptr++;
+        memcpy(dst + i * 8, &v, sizeof(v));
+    }
+    return len;
+}
+
+static size_t copy_to_mmio(char *dst, const char *src, size_t len) {
+    volatile uint64_t *mmio_ptr = (uint64_t *)dst;
     size_t transfers = (len + 7) / 8;
     for (size_t i = 0; i < transfers; ++i) {
-        *buff64++ = *mmio_ptr++;      
+        uint64_t v;
+        memcpy(&v, src + i * 8, sizeof(v));
+        *mmio_ptr++ = v;
+    }
+    return len;
+}
+
+static size_t iovec_len(const SOCKET_IOVEC *iov, int iovcnt) {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+RETURN_CODE socket_send_all_t2h_data(SOCKET fd, const char *buff, const size_t len, int flags, ssize_t *bytes_sent) {
+    if (len > SW_SOCKET_BUFF_SZ) {
+        if (bytes_sent != NULL) {
+            *bytes_sent = 0;
+        }
+        return FAILURE;
     }
+
+    // First copy the mmio ptr into local memory domain
+    copy_from_mmio(g_socket_send_buff, buff, len);
     
     RETURN_CODE ret = socket_send_all(fd, g_socket_send_buff, len, flags, bytes_sent);
 
     return ret;
 }
 
+RETURN_CODE socket_sendv_all(SOCKET fd, SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_sent) {
+    const size_t len = iovec_len(iov, iovcnt);
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+    ssize_t curr_bytes_sent;
+    size_t bytes_remaining = len;
+    struct msghdr msg;
+
+    while (bytes_remaining > 0) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        if ((curr_bytes_sent = sendmsg(fd, &msg, flags)) <= 0) {
+            if (bytes_sent != NULL) {
+                *bytes_sent = curr_bytes_sent;
+            }
+            return FAILURE;
+        }
+        bytes_remaining -= curr_bytes_sent;
+
+        // Skip past whatever made it out on a short send
+        while ((iovcnt > 0) && ((size_t)curr_bytes_sent >= iov->iov_len)) {
+            curr_bytes_sent -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + curr_bytes_sent;
+            iov->iov_len -= curr_bytes_sent;
+        }
+    }
+#else
+    for (int i = 0; i < iovcnt; ++i) {
+        if (socket_send_all(fd, (const char *)iov[i].iov_base, iov[i].iov_len, flags, bytes_sent) != OK) {
+            return FAILURE;
+        }
+    }
+#endif
+    if (bytes_sent != NULL) {
+        *bytes_sent = len;
+    }
+    return OK;
+}
+
+RETURN_CODE socket_send_packet_t2h_data(SOCKET fd, const char *header, size_t header_len, const SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_sent) {
+    const size_t len = iovec_len(iov, iovcnt);
+    size_t offset = 0;
+    SOCKET_IOVEC packet[2];
+
+    if (len > SW_SOCKET_BUFF_SZ) {
+        if (bytes_sent != NULL) {
+            *bytes_sent = 0;
+        }
+        return FAILURE;
+    }
+
+    // Gather the payload from device memory, then send it along
+    // with the header.
+    for (int i = 0; i < iovcnt; ++i) {
+        offset += copy_from_mmio(g_socket_send_buff + offset, (const char *)iov[i].iov_base, iov[i].iov_len);
+    }
+
+    packet[0].iov_base = (void *)header;
+    packet[0].iov_len = header_len;
+    packet[1].iov_base = g_socket_send_buff;
+    packet[1].iov_len = len;
+    return socket_sendv_all(fd, packet, 2, flags, bytes_sent);
+}
+
 RETURN_CODE socket_recv_until_null_reached(SOCKET sock_fd, char *buff, const size_t max_len, int flags, ssize_t *bytes_recvd) {
     ssize_t curr_bytes_recvd;
     size_t bytes_remaining = max_len;
@@ -204,21 +305,88 @@ RETURN_CODE socket_recv_accumulate(SOCKET sock_fd, char *buff, const size_t len,
 
 
 RETURN_CODE socket_recv_accumulate_h2t_data(SOCKET sock_fd, char *buff, const size_t len, int flags, ssize_t *bytes_recvd) {
+    if (len > SW_SOCKET_BUFF_SZ) {
+        if (bytes_recvd != NULL) {
+            *bytes_recvd = 0;
+        }
+        return FAILURE;
+    }
+
     RETURN_CODE rc = socket_recv_accumulate(sock_fd, g_socket_recv_buff, len, flags, bytes_recvd);
     
     if (rc != FAILURE) {
         // Copy the local memory ptr into the mmio domain
-        volatile uint64_t *mmio_ptr = (uint64_t *)buff;
-        uint64_t *buff64 = (uint64_t *)g_socket_recv_buff;
-        size_t transfers = (len +7) / 8;
-        for (size_t i = 0; i < transfers; ++i) {
-            *mmio_ptr++ = *buff64++;
-        }
+        copy_to_mmio(buff, g_socket_recv_buff, len);
     }
     
+    return rc;
+}
+
+RETURN_CODE socket_recvv_accumulate(SOCKET sock_fd, SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_recvd) {
+    const size_t len = iovec_len(iov, iovcnt);
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+    ssize_t curr_bytes_recvd;
+    size_t bytes_remaining = len;
+    struct msghdr msg;
+
+    while (bytes_remaining > 0) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        if ((curr_bytes_recvd = recvmsg(sock_fd, &msg, flags)) <= 0) {
+            if (bytes_recvd != NULL) {
+                *bytes_recvd = curr_bytes_recvd; // Return the error
+            }
+            return FAILURE;
+        }
+        bytes_remaining -= curr_bytes_recvd;
+
+        while ((iovcnt > 0) && ((size_t)curr_bytes_recvd >= iov->iov_len)) {
+            curr_bytes_recvd -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + curr_bytes_recvd;
+            iov->iov_len -= curr_bytes_recvd;
+        }
+    }
+#else
+    for (int i = 0; i < iovcnt; ++i) {
+        if (socket_recv_accumulate(sock_fd, (char *)iov[i].iov_base, iov[i].iov_len, flags, bytes_recvd) != OK) {
+            return FAILURE;
+        }
+    }
+#endif
+    if (bytes_recvd != NULL) {
+        *bytes_recvd = len;
+    }
     return OK;
 }
 
+RETURN_CODE socket_recvv_accumulate_h2t_data(SOCKET sock_fd, const SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_recvd) {
+    const size_t len = iovec_len(iov, iovcnt);
+    size_t offset = 0;
+
+    if (len > SW_SOCKET_BUFF_SZ) {
+        if (bytes_recvd != NULL) {
+            *bytes_recvd = 0;
+        }
+        return FAILURE;
+    }
+
+    // One receive for the whole payload, then scatter it into device memory.
+    RETURN_CODE rc = socket_recv_accumulate(sock_fd, g_socket_recv_buff, len, flags, bytes_recvd);
+
+    if (rc != FAILURE) {
+        for (int i = 0; i < iovcnt; ++i) {
+            offset += copy_to_mmio((char *)iov[i].iov_base, g_socket_recv_buff + offset, iov[i].iov_len);
+        }
+    }
+
+    return rc;
+}
+
 RETURN_CODE initialize_sockets_library() {
 #if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_WINDOWS
     WORD wVersionRequested;
@@ -49,6 +49,7 @@
         #include <netinet/tcp.h>
         #include <arpa/inet.h>
         #include <poll.h>
+        #include <sys/uio.h>
     #endif
     #include <fcntl.h>
     #include <unistd.h> // close
@@ -68,6 +69,17 @@ typedef int ssize_t;
 
 extern const struct timeval ZERO_TIMEOUT;
 
+// Describes one contiguous piece of a buffer for the vectored
+// (scatter-gather) send/recv functions below.
+#if STI_NOSYS_PROT_PLATFORM==STI_PLATFORM_LINUX
+typedef struct iovec SOCKET_IOVEC;
+#else
+typedef struct {
+    void *iov_base;
+    size_t iov_len;
+} SOCKET_IOVEC;
+#endif
+
 SOCKET max_of(SOCKET *array, int size);
 
 #define BOOL int
@@ -84,6 +96,20 @@ RETURN_CODE socket_send_all_t2h_data(SOCKET fd, const char *buff, const size_t l
 RETURN_CODE socket_recv_until_null_reached(SOCKET sock_fd, char *buff, const size_t max_len, int flags, ssize_t *bytes_recvd);
 RETURN_CODE socket_recv_accumulate(SOCKET sock_fd, char *buff, const size_t len, int flags, ssize_t *bytes_recvd);
 RETURN_CODE socket_recv_accumulate_h2t_data(SOCKET sock_fd, char *buff, const size_t len, int flags, ssize_t *bytes_recvd);
+
+// Vectored versions of the above. Each moves all of the bytes described by
+// 'iov' with as few system calls as possible. The 'iov' array is used as
+// scratch space and is modified.
+RETURN_CODE socket_sendv_all(SOCKET fd, SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_sent);
+RETURN_CODE socket_recvv_accumulate(SOCKET sock_fd, SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_recvd);
+
+// Receives a payload whose destination in device memory is split across 'iov'
+// (e.g. at the wrap of a circular buffer) with a single receive.
+RETURN_CODE socket_recvv_accumulate_h2t_data(SOCKET sock_fd, const SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_recvd);
+
+// Sends 'header' followed by a payload in device memory split across 'iov'
+// with a single send.
+RETURN_CODE socket_send_packet_t2h_data(SOCKET fd, const char *header, size_t header_len, const SOCKET_IOVEC *iov, int iovcnt, int flags, ssize_t *bytes_sent);
 RETURN_CODE initialize_sockets_library();
 int set_boolean_socket_option(SOCKET socket_fd, int option, int option_val);
 int set_tcp_no_delay(SOCKET socket_fd, int no_delay);
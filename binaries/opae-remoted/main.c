@@ -0,0 +1,168 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <getopt.h>
+#include <grp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <opae/fpga.h>
+
+#include "remote_server.h"
+
+#define DEFAULT_ENDPOINT "unix:/var/run/opae-remoted.sock"
+
+static volatile sig_atomic_t stop_requested;
+
+static void sig_handler(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static void show_help(FILE *fp)
+{
+	fprintf(fp, "Usage: opae-remoted [-h] [-v] [-e <endpoint>]"
+		    " [-g <group>] [-k <key file>] [-a]\n");
+	fprintf(fp, "\n");
+	fprintf(fp, "\t-e,--endpoint <endpoint>  listen here (default %s)\n",
+		DEFAULT_ENDPOINT);
+	fprintf(fp, "\t                          unix:<path>, shm:<path> or"
+		    " tcp:<host>:<port>\n");
+	fprintf(fp, "\t-g,--group <group>        let members of group use"
+		    " the Unix socket\n");
+	fprintf(fp, "\t-k,--key-file <file>      TCP clients must hold the"
+		    " key in file\n");
+	fprintf(fp, "\t-a,--allow-remote         listen on a TCP address"
+		    " other than loopback\n");
+	fprintf(fp, "\t                          (requires --key-file)\n");
+	fprintf(fp, "\t-h,--help                 display this help\n");
+	fprintf(fp, "\t-v,--version              display version info\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *short_opts = ":e:g:k:ahv";
+	struct option long_opts[] = {
+		{ "endpoint",     required_argument, NULL, 'e' },
+		{ "group",        required_argument, NULL, 'g' },
+		{ "key-file",     required_argument, NULL, 'k' },
+		{ "allow-remote", no_argument,       NULL, 'a' },
+		{ "help",         no_argument,       NULL, 'h' },
+		{ "version",      no_argument,       NULL, 'v' },
+		{ NULL,           0,                 NULL,  0  }
+	};
+	remote_server_config cfg;
+	const char *key_file = NULL;
+	uint8_t key[REMOTE_KEY_SIZE];
+	remote_server server;
+	struct sigaction sa;
+	struct group *grp;
+	int res;
+	int opt;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.endpoint = DEFAULT_ENDPOINT;
+	cfg.group = (gid_t)-1;
+
+	while ((opt = getopt_long(argc, argv, short_opts,
+				  long_opts, NULL)) != -1) {
+		switch (opt) {
+		case 'e':
+			cfg.endpoint = optarg;
+			break;
+		case 'g':
+			grp = getgrnam(optarg);
+			if (!grp) {
+				fprintf(stderr, "Unknown group %s\n", optarg);
+				return 1;
+			}
+			cfg.group = grp->gr_gid;
+			break;
+		case 'k':
+			key_file = optarg;
+			break;
+		case 'a':
+			cfg.listen_flags |= REMOTE_LISTEN_ALLOW_REMOTE;
+			break;
+		case 'h':
+			show_help(stdout);
+			return 0;
+		case 'v':
+			fprintf(stdout, "opae-remoted %s %s%s\n",
+					OPAE_VERSION,
+					OPAE_GIT_COMMIT_HASH,
+					OPAE_GIT_SRC_TREE_DIRTY ? "*":"");
+			return 0;
+		case ':':
+			fprintf(stderr, "Missing option argument\n");
+			show_help(stderr);
+			return 1;
+		default:
+			fprintf(stderr, "Invalid cmdline options\n");
+			show_help(stderr);
+			return 1;
+		}
+	}
+
+	// libopae-c would load the remote plugin and serve requests
+	// by forwarding them back to this server.
+	if (getenv("OPAE_REMOTE_ENDPOINT")) {
+		fprintf(stderr, "opae-remoted: unset OPAE_REMOTE_ENDPOINT"
+				" before starting the server\n");
+		return 1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sig_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	if (key_file) {
+		if (remote_load_key(key_file, key))
+			return 1;
+		cfg.key = key;
+	}
+
+	res = remote_server_start(&server, &cfg);
+	memset(key, 0, sizeof(key));
+	if (res)
+		return 1;
+
+	while (!stop_requested)
+		pause();
+
+	remote_server_stop(&server);
+	return 0;
+}
@@ -0,0 +1,1576 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif // _GNU_SOURCE
+#include <errno.h>
+#include <grp.h>
+#include <pwd.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <opae/fpga.h>
+
+#include "remote_server.h"
+#include "remote_proto.h"
+#include "opae_int.h"
+#include "props.h"
+#include "mock/opae_std.h"
+
+// Responses are gathered and sent together when no more requests
+// are waiting, or when this many bytes are queued.
+#define REMOTE_OUT_FLUSH (64 * 1024)
+
+#define REMOTE_MAX_TOKENS                        \
+	((REMOTE_MAX_PAYLOAD - sizeof(remote_enum_resp)) / \
+	 sizeof(remote_token_desc))
+
+// Server-side tokens, handles and objects, named by id = index + 1.
+typedef struct _remote_table {
+	void **items;
+	uint64_t size;
+} remote_table;
+
+typedef struct _remote_srv_handle {
+	fpga_handle handle;
+	fpga_token token; // clone of the token that was opened
+} remote_srv_handle;
+
+typedef struct _remote_session {
+	remote_transport tr;
+	remote_server *srv;
+	pthread_t thread;
+	volatile bool exited;
+	struct _remote_session *next;
+
+	remote_table tokens;
+	remote_table handles;
+	remote_table objects;
+
+	uint8_t *in;
+	size_t in_cap;
+	uint8_t *out;
+	size_t out_len;
+	size_t out_cap;
+
+	// The bitstream staged by REMOTE_BITSTREAM_DATA.
+	uint8_t *bitstream;
+	size_t bitstream_len;
+	size_t bitstream_cap;
+	bool bitstream_bad;
+} remote_session;
+
+STATIC int remote_grow(uint8_t **buf, size_t *cap, size_t need)
+{
+	size_t new_cap = *cap ? *cap : 4096;
+	uint8_t *p;
+
+	if (need <= *cap)
+		return 0;
+
+	while (new_cap < need)
+		new_cap *= 2;
+
+	p = opae_malloc(new_cap);
+	if (!p)
+		return -1;
+
+	if (*buf) {
+		memcpy(p, *buf, *cap);
+		opae_free(*buf);
+	}
+
+	*buf = p;
+	*cap = new_cap;
+	return 0;
+}
+
+STATIC uint64_t table_add(remote_table *t, void *item)
+{
+	uint64_t i;
+	void **items;
+
+	for (i = 0 ; i < t->size ; ++i) {
+		if (!t->items[i]) {
+			t->items[i] = item;
+			return i + 1;
+		}
+	}
+
+	items = opae_calloc(t->size ? 2 * t->size : 16, sizeof(void *));
+	if (!items)
+		return 0;
+
+	if (t->items) {
+		memcpy(items, t->items, t->size * sizeof(void *));
+		opae_free(t->items);
+	}
+
+	t->items = items;
+	t->items[t->size] = item;
+	t->size = t->size ? 2 * t->size : 16;
+
+	return i + 1;
+}
+
+STATIC void *table_get(remote_table *t, uint64_t id)
+{
+	if (!id || id > t->size)
+		return NULL;
+	return t->items[id - 1];
+}
+
+STATIC void *table_remove(remote_table *t, uint64_t id)
+{
+	void *item = table_get(t, id);
+
+	if (item)
+		t->items[id - 1] = NULL;
+	return item;
+}
+
+// Reserve len bytes of response payload. The pointer is good until
+// the next call.
+STATIC void *remote_reply(remote_session *s, size_t len)
+{
+	void *p;
+
+	if (remote_grow(&s->out, &s->out_cap, s->out_len + len))
+		return NULL;
+
+	p = s->out + s->out_len;
+	s->out_len += len;
+	return p;
+}
+
+STATIC fpga_result remote_reply_u64(remote_session *s, uint64_t value)
+{
+	uint64_t *p = remote_reply(s, sizeof(value));
+
+	if (!p)
+		return FPGA_NO_MEMORY;
+	*p = value;
+	return FPGA_OK;
+}
+
+#define REQUEST(__type, __name, __buf, __len)     \
+	const __type *__name = (const __type *)(__buf); \
+	if ((__len) < sizeof(__type))                   \
+		return FPGA_INVALID_PARAM
+
+#define LOOKUP(__table, __id, __var)             \
+	do {                                     \
+		__var = table_get(__table, __id); \
+		if (!__var)                       \
+			return FPGA_INVALID_PARAM; \
+	} while (0)
+
+STATIC fpga_result remote_pack_token(remote_session *s, fpga_token token,
+				     remote_token_desc *desc)
+{
+	fpga_properties prop = NULL;
+	fpga_result res;
+
+	res = fpgaGetProperties(token, &prop);
+	if (res != FPGA_OK)
+		return res;
+
+	remote_pack_properties((struct _fpga_properties *)prop, &desc->props);
+	fpgaDestroyProperties(&prop);
+
+	desc->id = table_add(&s->tokens, token);
+	return desc->id ? FPGA_OK : FPGA_NO_MEMORY;
+}
+
+STATIC fpga_result do_enumerate(remote_session *s, const uint8_t *buf,
+				uint32_t len)
+{
+	const remote_filter *wire;
+	fpga_properties *filters = NULL;
+	fpga_token *tokens = NULL;
+	remote_enum_resp *resp;
+	remote_token_desc *desc;
+	uint32_t num_filters = 0;
+	uint32_t num_matches = 0;
+	uint32_t max_tokens;
+	uint32_t i;
+	fpga_result res = FPGA_OK;
+	REQUEST(remote_enum_req, req, buf, len);
+
+	if (len != sizeof(*req) + req->num_filters * sizeof(remote_filter))
+		return FPGA_INVALID_PARAM;
+
+	max_tokens = req->max_tokens;
+	if (max_tokens > REMOTE_MAX_TOKENS)
+		max_tokens = REMOTE_MAX_TOKENS;
+
+	wire = (const remote_filter *)(req + 1);
+	if (req->num_filters) {
+		filters = opae_calloc(req->num_filters, sizeof(fpga_properties));
+		if (!filters)
+			return FPGA_NO_MEMORY;
+	}
+
+	for (i = 0 ; i < req->num_filters ; ++i) {
+		struct _fpga_properties *p;
+		fpga_token parent = NULL;
+
+		if (wire[i].props.valid_fields &
+		    ((uint64_t)1 << FPGA_PROPERTY_PARENT)) {
+			parent = table_get(&s->tokens, wire[i].parent);
+			if (!parent)
+				continue; // can match nothing
+		}
+
+		res = fpgaGetProperties(NULL, &filters[num_filters]);
+		if (res != FPGA_OK)
+			goto out_destroy;
+
+		p = (struct _fpga_properties *)filters[num_filters++];
+		remote_unpack_properties(&wire[i].props, p);
+		CLEAR_FIELD_VALID(p, FPGA_PROPERTY_PARENT);
+
+		if (parent) {
+			res = fpgaPropertiesSetParent(p, parent);
+			if (res != FPGA_OK)
+				goto out_destroy;
+		}
+	}
+
+	if (!req->num_filters || num_filters) {
+		if (max_tokens) {
+			tokens = opae_calloc(max_tokens, sizeof(fpga_token));
+			if (!tokens) {
+				res = FPGA_NO_MEMORY;
+				goto out_destroy;
+			}
+		}
+
+		res = fpgaEnumerate(filters, num_filters, tokens,
+				    max_tokens, &num_matches);
+		if (res != FPGA_OK)
+			goto out_destroy;
+	}
+
+	if (num_matches < max_tokens)
+		max_tokens = num_matches;
+
+	resp = remote_reply(s, sizeof(*resp) +
+			       max_tokens * sizeof(remote_token_desc));
+	if (!resp) {
+		res = FPGA_NO_MEMORY;
+		goto out_tokens;
+	}
+
+	resp->num_matches = num_matches;
+	resp->num_tokens = max_tokens;
+	desc = (remote_token_desc *)(resp + 1);
+
+	for (i = 0 ; i < max_tokens ; ++i) {
+		res = remote_pack_token(s, tokens[i], &desc[i]);
+		if (res != FPGA_OK) {
+			while (i--)
+				table_remove(&s->tokens, desc[i].id);
+			goto out_tokens;
+		}
+	}
+
+	goto out_destroy;
+
+out_tokens:
+	for (i = 0 ; i < max_tokens ; ++i)
+		fpgaDestroyToken(&tokens[i]);
+out_destroy:
+	for (i = 0 ; i < num_filters ; ++i)
+		fpgaDestroyProperties(&filters[i]);
+	if (filters)
+		opae_free(filters);
+	if (tokens)
+		opae_free(tokens);
+	return res;
+}
+
+STATIC fpga_result remote_reply_properties(remote_session *s,
+					   fpga_properties prop)
+{
+	remote_properties *wire = remote_reply(s, sizeof(*wire));
+
+	if (!wire)
+		return FPGA_NO_MEMORY;
+	remote_pack_properties((struct _fpga_properties *)prop, wire);
+	return FPGA_OK;
+}
+
+STATIC fpga_result do_get_properties(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	fpga_properties prop = NULL;
+	fpga_token token;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+
+	res = fpgaGetProperties(token, &prop);
+	if (res == FPGA_OK) {
+		res = remote_reply_properties(s, prop);
+		fpgaDestroyProperties(&prop);
+	}
+
+	return res;
+}
+
+STATIC fpga_result do_get_properties_from_handle(remote_session *s,
+						 const uint8_t *buf,
+						 uint32_t len)
+{
+	fpga_properties prop = NULL;
+	remote_srv_handle *h;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	res = fpgaGetPropertiesFromHandle(h->handle, &prop);
+	if (res == FPGA_OK) {
+		res = remote_reply_properties(s, prop);
+		fpgaDestroyProperties(&prop);
+	}
+
+	return res;
+}
+
+STATIC fpga_result do_clone_token(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	fpga_token token;
+	fpga_token clone = NULL;
+	uint64_t id;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+
+	res = fpgaCloneToken(token, &clone);
+	if (res != FPGA_OK)
+		return res;
+
+	id = table_add(&s->tokens, clone);
+	if (!id) {
+		fpgaDestroyToken(&clone);
+		return FPGA_NO_MEMORY;
+	}
+
+	return remote_reply_u64(s, id);
+}
+
+STATIC fpga_result do_destroy_token(remote_session *s, const uint8_t *buf,
+				    uint32_t len)
+{
+	fpga_token token;
+	REQUEST(remote_id_req, req, buf, len);
+
+	token = table_remove(&s->tokens, req->id);
+	if (!token)
+		return FPGA_INVALID_PARAM;
+
+	return fpgaDestroyToken(&token);
+}
+
+STATIC fpga_result do_open(remote_session *s, const uint8_t *buf,
+			   uint32_t len)
+{
+	fpga_token token;
+	remote_srv_handle *h;
+	uint64_t id;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+
+	h = opae_calloc(1, sizeof(remote_srv_handle));
+	if (!h)
+		return FPGA_NO_MEMORY;
+
+	// The client may destroy its token while the handle is open.
+	res = fpgaCloneToken(token, &h->token);
+	if (res != FPGA_OK)
+		goto out_free;
+
+	res = fpgaOpen(h->token, &h->handle, (int)req->arg0);
+	if (res != FPGA_OK)
+		goto out_destroy;
+
+	id = table_add(&s->handles, h);
+	if (!id) {
+		res = FPGA_NO_MEMORY;
+		goto out_close;
+	}
+
+	return remote_reply_u64(s, id);
+
+out_close:
+	fpgaClose(h->handle);
+out_destroy:
+	fpgaDestroyToken(&h->token);
+out_free:
+	opae_free(h);
+	return res;
+}
+
+STATIC fpga_result remote_close_handle(remote_srv_handle *h)
+{
+	fpga_result res;
+
+	res = fpgaClose(h->handle);
+	fpgaDestroyToken(&h->token);
+	opae_free(h);
+
+	return res;
+}
+
+STATIC fpga_result do_close(remote_session *s, const uint8_t *buf,
+			    uint32_t len)
+{
+	remote_srv_handle *h;
+	REQUEST(remote_id_req, req, buf, len);
+
+	h = table_remove(&s->handles, req->id);
+	if (!h)
+		return FPGA_INVALID_PARAM;
+
+	return remote_close_handle(h);
+}
+
+STATIC fpga_result do_reset(remote_session *s, const uint8_t *buf,
+			    uint32_t len)
+{
+	remote_srv_handle *h;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+	return fpgaReset(h->handle);
+}
+
+STATIC fpga_result do_read_mmio32(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	remote_srv_handle *h;
+	uint32_t value = 0;
+	fpga_result res;
+	REQUEST(remote_mmio_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->handle, h);
+
+	res = fpgaReadMMIO32(h->handle, req->mmio_num, req->offset, &value);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, value);
+}
+
+STATIC fpga_result do_read_mmio64(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	remote_srv_handle *h;
+	uint64_t value = 0;
+	fpga_result res;
+	REQUEST(remote_mmio_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->handle, h);
+
+	res = fpgaReadMMIO64(h->handle, req->mmio_num, req->offset, &value);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, value);
+}
+
+STATIC fpga_result do_write_mmio512(remote_session *s, const uint8_t *buf,
+				    uint32_t len)
+{
+	remote_srv_handle *h;
+	REQUEST(remote_mmio512_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->handle, h);
+	return fpgaWriteMMIO512(h->handle, req->mmio_num,
+				req->offset, req->value);
+}
+
+// Apply the writes in order. A failed write does not stop the rest;
+// the first failure is returned.
+STATIC fpga_result do_write_batch(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	const remote_mmio_write *w = (const remote_mmio_write *)buf;
+	size_t count = len / sizeof(*w);
+	fpga_result first = FPGA_OK;
+	size_t i;
+
+	if (len % sizeof(*w))
+		return FPGA_INVALID_PARAM;
+
+	for (i = 0 ; i < count ; ++i) {
+		remote_srv_handle *h = table_get(&s->handles, w[i].handle);
+		fpga_result res;
+
+		if (!h)
+			res = FPGA_INVALID_PARAM;
+		else if (w[i].width == 32)
+			res = fpgaWriteMMIO32(h->handle, w[i].mmio_num,
+					      w[i].offset, (uint32_t)w[i].value);
+		else
+			res = fpgaWriteMMIO64(h->handle, w[i].mmio_num,
+					      w[i].offset, w[i].value);
+
+		if (res != FPGA_OK && first == FPGA_OK)
+			first = res;
+	}
+
+	return first;
+}
+
+STATIC fpga_result do_read_error(remote_session *s, const uint8_t *buf,
+				 uint32_t len)
+{
+	fpga_token token;
+	uint64_t value = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+
+	res = fpgaReadError(token, (uint32_t)req->arg0, &value);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, value);
+}
+
+STATIC fpga_result do_clear_error(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	fpga_token token;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+	return fpgaClearError(token, (uint32_t)req->arg0);
+}
+
+STATIC fpga_result do_clear_all_errors(remote_session *s, const uint8_t *buf,
+				       uint32_t len)
+{
+	fpga_token token;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+	return fpgaClearAllErrors(token);
+}
+
+STATIC fpga_result do_get_error_info(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	fpga_token token;
+	struct fpga_error_info info;
+	struct fpga_error_info *p;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->tokens, req->id, token);
+
+	memset(&info, 0, sizeof(info));
+	res = fpgaGetErrorInfo(token, (uint32_t)req->arg0, &info);
+	if (res != FPGA_OK)
+		return res;
+
+	p = remote_reply(s, sizeof(info));
+	if (!p)
+		return FPGA_NO_MEMORY;
+	*p = info;
+	return FPGA_OK;
+}
+
+STATIC void remote_free_bitstream(remote_session *s)
+{
+	if (s->bitstream)
+		opae_free(s->bitstream);
+	s->bitstream = NULL;
+	s->bitstream_len = s->bitstream_cap = 0;
+	s->bitstream_bad = false;
+}
+
+// The memory staged grows with the data that actually arrives.
+STATIC fpga_result do_bitstream_data(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	size_t n;
+	REQUEST(uint64_t, offset, buf, len);
+
+	n = len - sizeof(*offset);
+
+	if (!*offset)
+		remote_free_bitstream(s);
+
+	if (s->bitstream_bad)
+		return FPGA_INVALID_PARAM;
+
+	if (*offset != s->bitstream_len || n > REMOTE_MAX_CHUNK ||
+	    s->bitstream_len + n > REMOTE_MAX_BITSTREAM) {
+		s->bitstream_bad = true;
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (remote_grow(&s->bitstream, &s->bitstream_cap,
+			s->bitstream_len + n)) {
+		s->bitstream_bad = true;
+		return FPGA_NO_MEMORY;
+	}
+
+	memcpy(s->bitstream + s->bitstream_len, offset + 1, n);
+	s->bitstream_len += n;
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result do_reconfigure_slot(remote_session *s, const uint8_t *buf,
+				       uint32_t len)
+{
+	remote_srv_handle *h;
+	fpga_result res;
+	REQUEST(remote_reconf_req, req, buf, len);
+
+	h = table_get(&s->handles, req->handle);
+	if (!h || s->bitstream_bad || req->bitstream_len != s->bitstream_len) {
+		remote_free_bitstream(s);
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = fpgaReconfigureSlot(h->handle, req->slot, s->bitstream,
+				  s->bitstream_len, req->flags);
+
+	remote_free_bitstream(s);
+	return res;
+}
+
+STATIC fpga_result do_get_user_clock(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	remote_srv_handle *h;
+	uint64_t *clk;
+	uint64_t high = 0;
+	uint64_t low = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	res = fpgaGetUserClock(h->handle, &high, &low, (int)req->arg0);
+	if (res != FPGA_OK)
+		return res;
+
+	clk = remote_reply(s, 2 * sizeof(uint64_t));
+	if (!clk)
+		return FPGA_NO_MEMORY;
+	clk[0] = high;
+	clk[1] = low;
+	return FPGA_OK;
+}
+
+STATIC fpga_result do_set_user_clock(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	remote_srv_handle *h;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+	return fpgaSetUserClock(h->handle, req->arg0, req->arg1,
+				(int)req->arg2);
+}
+
+STATIC fpga_result remote_reply_object(remote_session *s, fpga_object obj)
+{
+	uint64_t id = table_add(&s->objects, obj);
+
+	if (!id) {
+		fpgaDestroyObject(&obj);
+		return FPGA_NO_MEMORY;
+	}
+
+	return remote_reply_u64(s, id);
+}
+
+STATIC fpga_result do_get_object(remote_session *s, uint16_t op,
+				 const uint8_t *buf, uint32_t len)
+{
+	fpga_object obj = NULL;
+	const char *name;
+	void *parent;
+	fpga_result res;
+	REQUEST(remote_object_req, req, buf, len);
+
+	name = (const char *)(req + 1);
+	if (!req->name_len || len != sizeof(*req) + req->name_len ||
+	    name[req->name_len - 1])
+		return FPGA_INVALID_PARAM;
+
+	switch (op) {
+	case REMOTE_TOKEN_GET_OBJECT:
+		LOOKUP(&s->tokens, req->id, parent);
+		res = fpgaTokenGetObject(parent, name, &obj, req->flags);
+		break;
+	case REMOTE_HANDLE_GET_OBJECT:
+		LOOKUP(&s->handles, req->id, parent);
+		res = fpgaHandleGetObject(((remote_srv_handle *)parent)->handle,
+					  name, &obj, req->flags);
+		break;
+	default:
+		LOOKUP(&s->objects, req->id, parent);
+		res = fpgaObjectGetObject(parent, name, &obj, req->flags);
+		break;
+	}
+
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_object(s, obj);
+}
+
+STATIC fpga_result do_object_get_object_at(remote_session *s,
+					   const uint8_t *buf, uint32_t len)
+{
+	fpga_object parent;
+	fpga_object obj = NULL;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, parent);
+
+	res = fpgaObjectGetObjectAt(parent, (size_t)req->arg0, &obj);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_object(s, obj);
+}
+
+STATIC fpga_result do_destroy_object(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	fpga_object obj;
+	REQUEST(remote_id_req, req, buf, len);
+
+	obj = table_remove(&s->objects, req->id);
+	if (!obj)
+		return FPGA_INVALID_PARAM;
+
+	return fpgaDestroyObject(&obj);
+}
+
+STATIC fpga_result do_object_read(remote_session *s, const uint8_t *buf,
+				  uint32_t len)
+{
+	fpga_object obj;
+	uint8_t *data;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	if (req->arg1 > REMOTE_MAX_CHUNK)
+		return FPGA_INVALID_PARAM;
+
+	data = remote_reply(s, (size_t)req->arg1);
+	if (!data)
+		return FPGA_NO_MEMORY;
+
+	return fpgaObjectRead(obj, data, (size_t)req->arg0,
+			      (size_t)req->arg1, (int)req->arg2);
+}
+
+STATIC fpga_result do_object_read64(remote_session *s, const uint8_t *buf,
+				    uint32_t len)
+{
+	fpga_object obj;
+	uint64_t value = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	res = fpgaObjectRead64(obj, &value, (int)req->arg0);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, value);
+}
+
+STATIC fpga_result do_object_write64(remote_session *s, const uint8_t *buf,
+				     uint32_t len)
+{
+	fpga_object obj;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+	return fpgaObjectWrite64(obj, req->arg0, (int)req->arg1);
+}
+
+STATIC fpga_result do_object_get_size(remote_session *s, const uint8_t *buf,
+				      uint32_t len)
+{
+	fpga_object obj;
+	uint32_t size = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	res = fpgaObjectGetSize(obj, &size, (int)req->arg0);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, size);
+}
+
+STATIC fpga_result do_object_get_type(remote_session *s, const uint8_t *buf,
+				      uint32_t len)
+{
+	fpga_object obj;
+	enum fpga_sysobject_type type;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	res = fpgaObjectGetType(obj, &type);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, (uint64_t)type);
+}
+
+STATIC fpga_result do_object_readv(remote_session *s, const uint8_t *buf,
+				   uint32_t len)
+{
+	const remote_window *wire;
+	fpga_object_window *windows;
+	fpga_object obj;
+	uint8_t *data;
+	size_t total = 0;
+	uint32_t i;
+	fpga_result res;
+	REQUEST(remote_readv_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	if (!req->count ||
+	    len != sizeof(*req) + (size_t)req->count * sizeof(remote_window))
+		return FPGA_INVALID_PARAM;
+
+	wire = (const remote_window *)(req + 1);
+	for (i = 0 ; i < req->count ; ++i) {
+		if (wire[i].len > REMOTE_MAX_CHUNK - total)
+			return FPGA_INVALID_PARAM;
+		total += wire[i].len;
+	}
+
+	windows = opae_calloc(req->count, sizeof(fpga_object_window));
+	if (!windows)
+		return FPGA_NO_MEMORY;
+
+	data = remote_reply(s, total);
+	if (!data) {
+		opae_free(windows);
+		return FPGA_NO_MEMORY;
+	}
+
+	for (i = 0 ; i < req->count ; ++i) {
+		windows[i].buffer = data;
+		windows[i].offset = (size_t)wire[i].offset;
+		windows[i].len = (size_t)wire[i].len;
+		data += wire[i].len;
+	}
+
+	res = fpgaObjectReadv(obj, windows, req->count, req->flags);
+
+	opae_free(windows);
+	return res;
+}
+
+STATIC fpga_result do_object_read_group(remote_session *s,
+					const uint8_t *buf, uint32_t len)
+{
+	fpga_object obj;
+	fpga_object_value *values;
+	remote_group_resp *resp;
+	remote_group_value *wire;
+	uint32_t size = 0;
+	size_t count;
+	size_t names = 0;
+	size_t n = 0;
+	size_t i;
+	char *p;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->objects, req->id, obj);
+
+	res = fpgaObjectGetSize(obj, &size, 0);
+	if (res != FPGA_OK)
+		return res;
+
+	// A short count fails in fpgaObjectReadGroup(), as it does locally.
+	count = req->arg0 < size ? (size_t)req->arg0 : size;
+	if (!req->arg0 ||
+	    count > REMOTE_MAX_PAYLOAD / sizeof(remote_group_value))
+		return FPGA_INVALID_PARAM;
+
+	values = opae_calloc(count ? count : 1, sizeof(fpga_object_value));
+	if (!values)
+		return FPGA_NO_MEMORY;
+
+	res = fpgaObjectReadGroup(obj, values, count, &n, (int)req->arg1);
+	if (res != FPGA_OK)
+		goto out_free;
+
+	for (i = 0 ; i < count ; ++i) {
+		size_t name_len = values[i].name ?
+				  strlen(values[i].name) + 1 : 1;
+
+		if (name_len > UINT16_MAX) {
+			res = FPGA_EXCEPTION;
+			goto out_free;
+		}
+		names += name_len;
+	}
+
+	resp = remote_reply(s, sizeof(*resp) +
+			       count * sizeof(remote_group_value) + names);
+	if (!resp) {
+		res = FPGA_NO_MEMORY;
+		goto out_free;
+	}
+
+	resp->changed = n;
+	resp->count = count;
+	wire = (remote_group_value *)(resp + 1);
+	p = (char *)(wire + count);
+
+	for (i = 0 ; i < count ; ++i) {
+		const char *name = values[i].name ? values[i].name : "";
+
+		wire[i].value = values[i].value;
+		wire[i].result = values[i].result;
+		wire[i].changed = values[i].changed;
+		wire[i].name_len = (uint16_t)(strlen(name) + 1);
+		memcpy(p, name, wire[i].name_len);
+		p += wire[i].name_len;
+	}
+
+out_free:
+	opae_free(values);
+	return res;
+}
+
+STATIC fpga_result do_get_num_metrics(remote_session *s, const uint8_t *buf,
+				      uint32_t len)
+{
+	remote_srv_handle *h;
+	uint64_t num = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	res = fpgaGetNumMetrics(h->handle, &num);
+	if (res != FPGA_OK)
+		return res;
+
+	return remote_reply_u64(s, num);
+}
+
+// Reply with entries [first, first + count) of a table of total
+// entries, as many as fit in a message.
+STATIC fpga_result remote_reply_table(remote_session *s, const void *table,
+				      size_t entry_size, uint64_t total,
+				      uint64_t first, uint64_t count)
+{
+	remote_table_resp *resp;
+	uint64_t max = (REMOTE_MAX_PAYLOAD - sizeof(*resp)) / entry_size;
+
+	if (first > total)
+		first = total;
+	if (count > total - first)
+		count = total - first;
+	if (count > max)
+		count = max;
+
+	resp = remote_reply(s, sizeof(*resp) + count * entry_size);
+	if (!resp)
+		return FPGA_NO_MEMORY;
+
+	resp->total = total;
+	resp->count = count;
+	if (count)
+		memcpy(resp + 1, (const uint8_t *)table + first * entry_size,
+		       count * entry_size);
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result do_get_metrics_info(remote_session *s, const uint8_t *buf,
+				       uint32_t len)
+{
+	remote_srv_handle *h;
+	fpga_metric_info *info;
+	uint64_t num = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	res = fpgaGetNumMetrics(h->handle, &num);
+	if (res != FPGA_OK)
+		return res;
+
+	info = opae_calloc(num ? num : 1, sizeof(fpga_metric_info));
+	if (!info)
+		return FPGA_NO_MEMORY;
+
+	res = fpgaGetMetricsInfo(h->handle, info, &num);
+	if (res == FPGA_OK)
+		res = remote_reply_table(s, info, sizeof(*info), num,
+					 req->arg0, req->arg1);
+
+	opae_free(info);
+	return res;
+}
+
+STATIC fpga_result do_get_metrics_by_index(remote_session *s,
+					   const uint8_t *buf, uint32_t len)
+{
+	remote_srv_handle *h;
+	uint64_t *indexes;
+	fpga_metric *metrics;
+	size_t count;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	count = (len - sizeof(*req)) / sizeof(uint64_t);
+	if (!count || (len - sizeof(*req)) % sizeof(uint64_t) ||
+	    count > REMOTE_MAX_PAYLOAD / sizeof(fpga_metric))
+		return FPGA_INVALID_PARAM;
+
+	indexes = opae_malloc(count * sizeof(uint64_t));
+	if (!indexes)
+		return FPGA_NO_MEMORY;
+	memcpy(indexes, req + 1, count * sizeof(uint64_t));
+
+	metrics = remote_reply(s, count * sizeof(fpga_metric));
+	if (!metrics) {
+		opae_free(indexes);
+		return FPGA_NO_MEMORY;
+	}
+	memset(metrics, 0, count * sizeof(fpga_metric));
+
+	res = fpgaGetMetricsByIndex(h->handle, indexes, count, metrics);
+
+	opae_free(indexes);
+	return res;
+}
+
+STATIC fpga_result do_get_metrics_by_name(remote_session *s,
+					  const uint8_t *buf, uint32_t len)
+{
+	remote_srv_handle *h;
+	char **names;
+	fpga_metric *metrics;
+	const char *p;
+	const char *end;
+	uint64_t i;
+	fpga_result res;
+	REQUEST(remote_names_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->handle, h);
+
+	if (!req->count ||
+	    req->count > REMOTE_MAX_PAYLOAD / sizeof(fpga_metric))
+		return FPGA_INVALID_PARAM;
+
+	names = opae_calloc(req->count, sizeof(char *));
+	if (!names)
+		return FPGA_NO_MEMORY;
+
+	// The names are kept in the request buffer.
+	p = (const char *)(req + 1);
+	end = (const char *)buf + len;
+	for (i = 0 ; i < req->count ; ++i) {
+		const char *nul = memchr(p, '\0', end - p);
+
+		if (!nul) {
+			opae_free(names);
+			return FPGA_INVALID_PARAM;
+		}
+		names[i] = (char *)p;
+		p = nul + 1;
+	}
+
+	metrics = remote_reply(s, req->count * sizeof(fpga_metric));
+	if (!metrics) {
+		opae_free(names);
+		return FPGA_NO_MEMORY;
+	}
+	memset(metrics, 0, req->count * sizeof(fpga_metric));
+
+	res = fpgaGetMetricsByName(h->handle, names, req->count, metrics);
+
+	opae_free(names);
+	return res;
+}
+
+STATIC fpga_result do_get_metrics_threshold_info(remote_session *s,
+						 const uint8_t *buf,
+						 uint32_t len)
+{
+	remote_srv_handle *h;
+	metric_threshold *thresholds;
+	uint32_t num = 0;
+	fpga_result res;
+	REQUEST(remote_id_req, req, buf, len);
+
+	LOOKUP(&s->handles, req->id, h);
+
+	res = fpgaGetMetricsThresholdInfo(h->handle, NULL, &num);
+	if (res != FPGA_OK)
+		return res;
+
+	if (!req->arg1)
+		return remote_reply_table(s, NULL, sizeof(*thresholds),
+					  num, 0, 0);
+
+	thresholds = opae_calloc(num ? num : 1, sizeof(metric_threshold));
+	if (!thresholds)
+		return FPGA_NO_MEMORY;
+
+	res = fpgaGetMetricsThresholdInfo(h->handle, thresholds, &num);
+	if (res == FPGA_OK)
+		res = remote_reply_table(s, thresholds, sizeof(*thresholds),
+					 num, req->arg0, req->arg1);
+
+	opae_free(thresholds);
+	return res;
+}
+
+STATIC fpga_result remote_dispatch(remote_session *s, uint16_t op,
+				   const uint8_t *buf, uint32_t len)
+{
+	switch (op) {
+	case REMOTE_SYNC:
+		return FPGA_OK;
+	case REMOTE_ENUMERATE:
+		return do_enumerate(s, buf, len);
+	case REMOTE_GET_PROPERTIES:
+		return do_get_properties(s, buf, len);
+	case REMOTE_GET_PROPERTIES_FROM_HANDLE:
+		return do_get_properties_from_handle(s, buf, len);
+	case REMOTE_CLONE_TOKEN:
+		return do_clone_token(s, buf, len);
+	case REMOTE_DESTROY_TOKEN:
+		return do_destroy_token(s, buf, len);
+	case REMOTE_OPEN:
+		return do_open(s, buf, len);
+	case REMOTE_CLOSE:
+		return do_close(s, buf, len);
+	case REMOTE_RESET:
+		return do_reset(s, buf, len);
+	case REMOTE_READ_MMIO32:
+		return do_read_mmio32(s, buf, len);
+	case REMOTE_READ_MMIO64:
+		return do_read_mmio64(s, buf, len);
+	case REMOTE_WRITE_MMIO512:
+		return do_write_mmio512(s, buf, len);
+	case REMOTE_WRITE_BATCH:
+		return do_write_batch(s, buf, len);
+	case REMOTE_READ_ERROR:
+		return do_read_error(s, buf, len);
+	case REMOTE_CLEAR_ERROR:
+		return do_clear_error(s, buf, len);
+	case REMOTE_CLEAR_ALL_ERRORS:
+		return do_clear_all_errors(s, buf, len);
+	case REMOTE_GET_ERROR_INFO:
+		return do_get_error_info(s, buf, len);
+	case REMOTE_RECONFIGURE_SLOT:
+		return do_reconfigure_slot(s, buf, len);
+	case REMOTE_GET_USER_CLOCK:
+		return do_get_user_clock(s, buf, len);
+	case REMOTE_SET_USER_CLOCK:
+		return do_set_user_clock(s, buf, len);
+	case REMOTE_TOKEN_GET_OBJECT:
+	case REMOTE_HANDLE_GET_OBJECT:
+	case REMOTE_OBJECT_GET_OBJECT:
+		return do_get_object(s, op, buf, len);
+	case REMOTE_OBJECT_GET_OBJECT_AT:
+		return do_object_get_object_at(s, buf, len);
+	case REMOTE_DESTROY_OBJECT:
+		return do_destroy_object(s, buf, len);
+	case REMOTE_OBJECT_READ:
+		return do_object_read(s, buf, len);
+	case REMOTE_OBJECT_READ64:
+		return do_object_read64(s, buf, len);
+	case REMOTE_OBJECT_WRITE64:
+		return do_object_write64(s, buf, len);
+	case REMOTE_OBJECT_GET_SIZE:
+		return do_object_get_size(s, buf, len);
+	case REMOTE_OBJECT_GET_TYPE:
+		return do_object_get_type(s, buf, len);
+	case REMOTE_BITSTREAM_DATA:
+		return do_bitstream_data(s, buf, len);
+	case REMOTE_OBJECT_READV:
+		return do_object_readv(s, buf, len);
+	case REMOTE_OBJECT_READ_GROUP:
+		return do_object_read_group(s, buf, len);
+	case REMOTE_GET_NUM_METRICS:
+		return do_get_num_metrics(s, buf, len);
+	case REMOTE_GET_METRICS_INFO:
+		return do_get_metrics_info(s, buf, len);
+	case REMOTE_GET_METRICS_BY_INDEX:
+		return do_get_metrics_by_index(s, buf, len);
+	case REMOTE_GET_METRICS_BY_NAME:
+		return do_get_metrics_by_name(s, buf, len);
+	case REMOTE_GET_METRICS_THRESHOLD_INFO:
+		return do_get_metrics_threshold_info(s, buf, len);
+	}
+
+	return FPGA_NOT_SUPPORTED;
+}
+
+STATIC int remote_session_flush(remote_session *s)
+{
+	struct iovec iov;
+	int res;
+
+	if (!s->out_len)
+		return 0;
+
+	iov.iov_base = s->out;
+	iov.iov_len = s->out_len;
+	res = remote_send(&s->tr, &iov, 1);
+	s->out_len = 0;
+
+	return res;
+}
+
+// Serve one request. Its response, if any, is appended to s->out.
+STATIC int remote_session_request(remote_session *s)
+{
+	remote_hdr hdr;
+	size_t start;
+	fpga_result res;
+
+	if (remote_recv(&s->tr, &hdr, sizeof(hdr)))
+		return -1;
+
+	if (hdr.len > REMOTE_MAX_PAYLOAD ||
+	    remote_grow(&s->in, &s->in_cap, hdr.len ? hdr.len : 1) ||
+	    remote_recv(&s->tr, s->in, hdr.len))
+		return -1;
+
+	start = s->out_len;
+	if (!remote_reply(s, sizeof(remote_hdr)))
+		return -1;
+
+	res = remote_dispatch(s, hdr.op, s->in, hdr.len);
+
+	if (hdr.flags & REMOTE_FLAG_POSTED) {
+		if (res != FPGA_OK)
+			OPAE_ERR("posted remote op %u failed: %s",
+				 hdr.op, fpgaErrStr(res));
+		s->out_len = start;
+		return 0;
+	}
+
+	if (res == FPGA_OK &&
+	    s->out_len - start - sizeof(remote_hdr) > REMOTE_MAX_PAYLOAD) {
+		OPAE_ERR("response to remote op %u is too large", hdr.op);
+		res = FPGA_NO_MEMORY;
+	}
+
+	// A failed request carries no payload.
+	if (res != FPGA_OK)
+		s->out_len = start + sizeof(remote_hdr);
+
+	hdr.len = (uint32_t)(s->out_len - start - sizeof(remote_hdr));
+	hdr.flags = 0;
+	hdr.result = res;
+	memcpy(s->out + start, &hdr, sizeof(hdr));
+
+	return 0;
+}
+
+STATIC void remote_session_release(remote_session *s)
+{
+	uint64_t i;
+
+	for (i = 0 ; i < s->objects.size ; ++i) {
+		if (s->objects.items[i])
+			fpgaDestroyObject((fpga_object *)&s->objects.items[i]);
+	}
+
+	for (i = 0 ; i < s->handles.size ; ++i) {
+		if (s->handles.items[i])
+			remote_close_handle(s->handles.items[i]);
+	}
+
+	for (i = 0 ; i < s->tokens.size ; ++i) {
+		if (s->tokens.items[i])
+			fpgaDestroyToken((fpga_token *)&s->tokens.items[i]);
+	}
+
+	if (s->objects.items)
+		opae_free(s->objects.items);
+	if (s->handles.items)
+		opae_free(s->handles.items);
+	if (s->tokens.items)
+		opae_free(s->tokens.items);
+	if (s->in)
+		opae_free(s->in);
+	if (s->out)
+		opae_free(s->out);
+	remote_free_bitstream(s);
+}
+
+// Whether the user at the other end of a Unix socket may connect:
+// root, the server's own user, or a member of srv->group.
+STATIC bool remote_peer_allowed(remote_server *srv, int fd)
+{
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	struct passwd pw;
+	struct passwd *result = NULL;
+	char pwbuf[1024];
+	gid_t groups[256];
+	int ngroups = sizeof(groups) / sizeof(groups[0]);
+	int i;
+
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len)) {
+		OPAE_ERR("SO_PEERCRED failed: %s", strerror(errno));
+		return false;
+	}
+
+	if (!cred.uid || cred.uid == geteuid())
+		return true;
+
+	if (srv->group == (gid_t)-1)
+		goto out_deny;
+
+	if (cred.gid == srv->group)
+		return true;
+
+	if (getpwuid_r(cred.uid, &pw, pwbuf, sizeof(pwbuf), &result) ||
+	    !result ||
+	    getgrouplist(pw.pw_name, cred.gid, groups, &ngroups) < 0)
+		goto out_deny;
+
+	for (i = 0 ; i < ngroups ; ++i) {
+		if (groups[i] == srv->group)
+			return true;
+	}
+
+out_deny:
+	OPAE_ERR("refusing connection from uid %u (pid %d)",
+		 (unsigned)cred.uid, (int)cred.pid);
+	return false;
+}
+
+STATIC void *remote_session_thread(void *arg)
+{
+	remote_session *s = (remote_session *)arg;
+	struct sockaddr_storage addr;
+	socklen_t addr_len = sizeof(addr);
+
+	if (getsockname(s->tr.fd, (struct sockaddr *)&addr, &addr_len) ||
+	    (addr.ss_family == AF_UNIX &&
+	     !remote_peer_allowed(s->srv, s->tr.fd)))
+		goto out;
+
+	if (remote_server_hello(&s->tr,
+				s->srv->has_key ? s->srv->key : NULL)) {
+		OPAE_ERR("remote client handshake failed");
+		goto out;
+	}
+
+	while (!remote_session_request(s)) {
+		if (s->out_len >= REMOTE_OUT_FLUSH ||
+		    !remote_pending(&s->tr)) {
+			if (remote_session_flush(s))
+				break;
+		}
+	}
+
+	remote_session_flush(s);
+out:
+	remote_session_release(s);
+	s->exited = true;
+	return NULL;
+}
+
+// Join the sessions whose clients have gone; all of them when all
+// is set.
+STATIC void remote_server_reap(remote_server *srv, bool all)
+{
+	remote_session **pp;
+	remote_session *s;
+	int err;
+
+	opae_mutex_lock(err, &srv->lock);
+
+	pp = &srv->sessions;
+	while ((s = *pp)) {
+		// The transport is closed only after the join, so the
+		// shutdown cannot hit a reused descriptor.
+		if (all && !s->exited)
+			shutdown(s->tr.fd, SHUT_RDWR);
+
+		if (all || s->exited) {
+			pthread_join(s->thread, NULL);
+			remote_close(&s->tr);
+			*pp = s->next;
+			opae_free(s);
+		} else {
+			pp = &s->next;
+		}
+	}
+
+	opae_mutex_unlock(err, &srv->lock);
+}
+
+STATIC void *remote_server_accept(void *arg)
+{
+	remote_server *srv = (remote_server *)arg;
+	struct pollfd pfd;
+	remote_session *s;
+	int err;
+
+	pfd.fd = srv->listen_fd;
+	pfd.events = POLLIN;
+
+	while (srv->running) {
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		remote_server_reap(srv, false);
+
+		s = opae_calloc(1, sizeof(remote_session));
+		if (!s)
+			continue;
+		s->srv = srv;
+
+		if (remote_accept(srv->listen_fd, &s->tr)) {
+			opae_free(s);
+			continue;
+		}
+
+		if (pthread_create(&s->thread, NULL,
+				   remote_session_thread, s)) {
+			OPAE_ERR("failed to create session thread");
+			remote_close(&s->tr);
+			opae_free(s);
+			continue;
+		}
+
+		opae_mutex_lock(err, &srv->lock);
+		s->next = srv->sessions;
+		srv->sessions = s;
+		opae_mutex_unlock(err, &srv->lock);
+	}
+
+	return NULL;
+}
+
+int remote_server_start(remote_server *srv, const remote_server_config *cfg)
+{
+	memset(srv, 0, sizeof(*srv));
+
+	if ((cfg->listen_flags & REMOTE_LISTEN_ALLOW_REMOTE) && !cfg->key) {
+		OPAE_ERR("listening beyond loopback requires a key");
+		return 1;
+	}
+
+	srv->group = cfg->group;
+	if (cfg->key) {
+		memcpy(srv->key, cfg->key, sizeof(srv->key));
+		srv->has_key = true;
+	}
+
+	srv->listen_fd = remote_listen(cfg->endpoint, cfg->listen_flags,
+				       cfg->group);
+	if (srv->listen_fd < 0) {
+		OPAE_ERR("failed to listen on %s", cfg->endpoint);
+		return 1;
+	}
+
+	pthread_mutex_init(&srv->lock, NULL);
+	srv->running = true;
+
+	if (pthread_create(&srv->acceptor, NULL,
+			   remote_server_accept, srv)) {
+		OPAE_ERR("failed to create accept thread");
+		srv->running = false;
+		close(srv->listen_fd);
+		pthread_mutex_destroy(&srv->lock);
+		return 1;
+	}
+
+	return 0;
+}
+
+void remote_server_stop(remote_server *srv)
+{
+	struct sockaddr_un addr;
+	socklen_t addr_len = sizeof(addr);
+
+	if (!srv->running)
+		return;
+
+	srv->running = false;
+	pthread_join(srv->acceptor, NULL);
+
+	if (!getsockname(srv->listen_fd, (struct sockaddr *)&addr, &addr_len) &&
+	    addr.sun_family == AF_UNIX && addr.sun_path[0])
+		unlink(addr.sun_path);
+	close(srv->listen_fd);
+
+	remote_server_reap(srv, true);
+	pthread_mutex_destroy(&srv->lock);
+}
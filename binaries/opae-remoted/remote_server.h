@@ -0,0 +1,64 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_REMOTE_SERVER_H__
+#define __OPAE_REMOTE_SERVER_H__
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "remote_proto.h"
+
+struct _remote_session;
+
+typedef struct _remote_server_config {
+	const char *endpoint;
+	int listen_flags;   // REMOTE_LISTEN_*
+	gid_t group;        // (gid_t)-1, or a group whose members may connect
+	const uint8_t *key; // NULL, or the key that TCP clients must hold
+} remote_server_config;
+
+typedef struct _remote_server {
+	int listen_fd;
+	volatile bool running;
+	pthread_t acceptor;
+	pthread_mutex_t lock;
+	struct _remote_session *sessions;
+	gid_t group;
+	bool has_key;
+	uint8_t key[REMOTE_KEY_SIZE];
+} remote_server;
+
+// Listen on cfg->endpoint and serve each connection from its own
+// thread. Unix socket clients must run as root, as the server's user
+// or in cfg->group. Listening beyond the loopback address requires
+// a key.
+int remote_server_start(remote_server *s, const remote_server_config *cfg);
+
+// Stop accepting, disconnect all clients and release their resources.
+void remote_server_stop(remote_server *s);
+
+#endif // __OPAE_REMOTE_SERVER_H__
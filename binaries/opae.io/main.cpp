@@ -56,19 +56,38 @@ py::tuple version()
 
 void open_device(const std::string &pci_address)
 {
-  if (the_device) {
-    the_device->close();
-    delete the_device;
-    the_device = nullptr;
+  // The globals are only touched with the GIL held, so that
+  // concurrent calls can't both take and delete the same device.
+  struct vfio_device *old_device = the_device;
+  struct vfio_device *new_device = nullptr;
+  auto g = py::globals();
+
+  delete the_region;
+  the_region = nullptr;
+  the_device = nullptr;
+  g["the_device"] = the_device;
+  g["the_region"] = the_region;
+
+  {
+    // Closing and opening a VFIO device can take a while;
+    // let other Python threads run meanwhile.
+    py::gil_scoped_release release;
+    if (old_device) {
+      old_device->close();
+    }
+    if (!pci_address.empty()) {
+      new_device = vfio_device::open(pci_address.c_str());
+    }
   }
-  if (the_region) {
+
+  delete old_device;
+  if (the_device) {
+    // Another call opened a device meanwhile; the last one wins.
     delete the_region;
     the_region = nullptr;
+    delete the_device;
   }
-  if (!pci_address.empty()) {
-    the_device = vfio_device::open(pci_address.c_str());
-  }
-  auto g = py::globals();
+  the_device = new_device;
   g["the_device"] = the_device;
   g["the_region"] = the_region;
 }
@@ -205,7 +224,8 @@ PYBIND11_EMBEDDED_MODULE(opae_io, m) {
         "Open a device given a pci address",
         py::arg("pci_address") = "");
   m.def("region", &open_region);
-  m.def("allocate_buffer", &allocate_buffer);
+  m.def("allocate_buffer", &allocate_buffer,
+        py::call_guard<py::gil_scoped_release>());
   m.def("version", &version);
   py::class_<opae_io_cli, std::shared_ptr<opae_io_cli>> pycli(m, "cli", "");
   pycli.def(py::init<>())
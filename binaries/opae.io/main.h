@@ -27,9 +27,12 @@
 #pragma once
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <opae/vfio.h>
+#include <opae/cxx/core/buffer_ops.h>
 
 
 static inline void assert_config_op(uint64_t offset,
@@ -70,6 +73,80 @@ struct mmio_region {
   {
     *reinterpret_cast<uint64_t *>(ptr + offset) = value;
   }
+
+  // Copy count registers of the given width (32 or 64 bits) out of
+  // the region, starting at offset. Each register is read with a
+  // single access of that width, as read32/read64 would.
+  void read_block(uint64_t offset, void *dst, size_t count, unsigned width) const
+  {
+    check_block(offset, count, width);
+    if (width == 64)
+      mmio_copy(reinterpret_cast<volatile const uint64_t *>(ptr + offset),
+                reinterpret_cast<volatile uint64_t *>(dst), count);
+    else
+      mmio_copy(reinterpret_cast<volatile const uint32_t *>(ptr + offset),
+                reinterpret_cast<volatile uint32_t *>(dst), count);
+  }
+
+  // Copy count registers of the given width into the region,
+  // starting at offset, one write of that width per register.
+  void write_block(uint64_t offset, const void *src, size_t count, unsigned width)
+  {
+    check_block(offset, count, width);
+    if (width == 64)
+      mmio_copy(reinterpret_cast<volatile const uint64_t *>(src),
+                reinterpret_cast<volatile uint64_t *>(ptr + offset), count);
+    else
+      mmio_copy(reinterpret_cast<volatile const uint32_t *>(src),
+                reinterpret_cast<volatile uint32_t *>(ptr + offset), count);
+  }
+
+  // The number of registers to dump for size bytes at start, or
+  // for the rest of the region when size is 0.
+  size_t dump_count(uint64_t start, size_t size, unsigned width) const
+  {
+    check_width(width);
+    if (start > this->size)
+      throw std::out_of_range("start exceeds the region");
+    if (!size)
+      size = this->size - start;
+    if (size % (width / 8))
+      throw std::invalid_argument("size is not a multiple of the access width");
+    return size / (width / 8);
+  }
+
+  // Write back bytes of registers saved by a dump of start.
+  void restore(uint64_t start, const void *src, size_t bytes, unsigned width)
+  {
+    check_width(width);
+    if (bytes % (width / 8))
+      throw std::invalid_argument("data size is not a multiple of the access width");
+    write_block(start, src, bytes / (width / 8), width);
+  }
+
+  static void check_width(unsigned width)
+  {
+    if (width != 32 && width != 64)
+      throw std::invalid_argument("access width must be 32 or 64");
+  }
+
+  void check_block(uint64_t offset, size_t count, unsigned width) const
+  {
+    check_width(width);
+    size_t bytes = width / 8;
+    if (offset % bytes)
+      throw std::invalid_argument("offset is not aligned to the access width");
+    if (offset > size || count > (size - offset) / bytes)
+      throw std::out_of_range("block exceeds the region");
+  }
+
+  // volatile keeps the compiler from merging or widening the accesses.
+  template <typename T>
+  static void mmio_copy(volatile const T *src, volatile T *dst, size_t count)
+  {
+    for (size_t i = 0 ; i < count ; ++i)
+      dst[i] = src[i];
+  }
 };
 
 struct system_buffer {
@@ -107,13 +184,9 @@ struct system_buffer {
 
   size_t compare(system_buffer *other)
   {
-    size_t i;
-    for (i = 0 ; i < std::min(size, other->size) ; ++i) {
-      if (*(buf + i) != *(other->buf + i)) {
-        return i;
-      }
-    }
-    return size;
+    size_t len = std::min(size, other->size);
+    auto r = opae::fpga::types::buffer_ops::compare(buf, other->buf, len);
+    return r.mismatches ? r.first_mismatch : size;
   }
 };
 
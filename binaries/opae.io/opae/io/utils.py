@@ -433,20 +433,19 @@ def walk(region,
 
 def dump(region, start=0, output=sys.stdout, fmt='hex', count=None):
     stop_at = start + count*8 if count else len(region)
-    offset = start
-    if ACCESS_MODE == 64:
-        rd = region.read64
-        byte_length = 8
-    else:
-        rd = region.read32
-        byte_length = 4
-    while offset < stop_at:
-        value = rd(offset)
-        if fmt == 'hex':
+    byte_length = ACCESS_MODE // 8
+    size = stop_at - start
+    size -= size % byte_length
+    # Read the whole range in one call, then format it.
+    data = region.dump(start, size, ACCESS_MODE)
+    if fmt == 'hex':
+        words = memoryview(data).cast('Q' if ACCESS_MODE == 64 else 'I')
+        offset = start
+        for value in words:
             output.write(f'0x{offset:04x}: 0x{value:016x}\n')
-        else:
-            output.write(value.to_bytes(byte_length, 'little'))
-        offset += byte_length
+            offset += byte_length
+    else:
+        output.write(data)
 
 
 class feature(object):
@@ -41,7 +41,7 @@ setup(
                     "@pybind11_ROOT@/include",
                     "@OPAE_BIN_SOURCE@/opae.io",
                   ],
-                  libraries=['opaevfio'],
+                  libraries=['opaevfio', 'opae-cxx-core'],
                   library_dirs=["@LIBRARY_OUTPUT_PATH@"])
     ],
 )
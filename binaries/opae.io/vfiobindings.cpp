@@ -34,6 +34,48 @@
 
 namespace py = pybind11;
 
+// Bulk register I/O. A whole register range is moved in one call,
+// with the GIL released, instead of one Python call per register.
+
+static py::bytes region_read_block(mmio_region *r, uint64_t offset,
+                                   size_t count, unsigned width)
+{
+  r->check_block(offset, count, width);
+  auto data = py::reinterpret_steal<py::bytes>(
+      PyBytes_FromStringAndSize(nullptr, count * (width / 8)));
+  if (!data)
+    throw py::error_already_set();
+  char *dst = PyBytes_AS_STRING(data.ptr());
+  {
+    py::gil_scoped_release release;
+    r->read_block(offset, dst, count, width);
+  }
+  return data;
+}
+
+static void region_write_block(mmio_region *r, uint64_t offset,
+                               py::buffer data, unsigned width)
+{
+  py::buffer_info info = data.request();
+  size_t bytes = info.size * info.itemsize;
+  ssize_t stride = info.itemsize;
+
+  for (ssize_t i = info.ndim - 1 ; i >= 0 ; --i) {
+    if (info.strides[i] != stride)
+      throw std::invalid_argument("data must be a contiguous buffer");
+    stride *= info.shape[i];
+  }
+
+  py::gil_scoped_release release;
+  r->restore(offset, info.ptr, bytes, width);
+}
+
+static py::bytes region_dump(mmio_region *r, uint64_t start, size_t size,
+                             unsigned width)
+{
+  return region_read_block(r, start, r->dump_count(start, size, width), width);
+}
+
 
 #ifdef LIBVFIO_EMBED
 #include <pybind11/embed.h>
@@ -43,9 +85,10 @@ PYBIND11_MODULE(libvfio, m)
 #endif
 {
   py::class_<vfio_device> pydevice(m, "device", "");
-  pydevice.def_static("open", &vfio_device::open, py::return_value_policy::reference)
+  pydevice.def_static("open", &vfio_device::open, py::return_value_policy::reference,
+                      py::call_guard<py::gil_scoped_release>())
           .def("descriptor", &vfio_device::descriptor)
-          .def("close", &vfio_device::close)
+          .def("close", &vfio_device::close, py::call_guard<py::gil_scoped_release>())
           .def("__getitem__", &vfio_device::config_read<uint32_t>)
           .def("__setitem__", &vfio_device::config_write<uint32_t>)
           .def("config_read32", &vfio_device::config_read<uint32_t>)
@@ -55,7 +98,8 @@ PYBIND11_MODULE(libvfio, m)
           .def("config_read8", &vfio_device::config_read<uint8_t>)
           .def("config_write8", &vfio_device::config_write<uint8_t>)
           .def("__repr__", &vfio_device::address)
-          .def("allocate", &vfio_device::buffer_allocate)
+          .def("allocate", &vfio_device::buffer_allocate,
+               py::call_guard<py::gil_scoped_release>())
           .def("set_vf_token", &vfio_device::set_vf_token)
           .def_property_readonly("pci_address", &vfio_device::address)
           .def_property_readonly("num_regions", &vfio_device::num_regions)
@@ -68,10 +112,32 @@ PYBIND11_MODULE(libvfio, m)
           .def("read64", &mmio_region::read64)
           .def("index", [](mmio_region *r) { return r->index; })
           .def("__repr__", [](mmio_region *r) { return std::to_string(r->index); })
-          .def("__len__", [](mmio_region *r) { return r->size; });
+          .def("__len__", [](mmio_region *r) { return r->size; })
+          .def("read_block", &region_read_block,
+               "Read count registers starting at offset, returned as bytes",
+               py::arg("offset"), py::arg("count"), py::arg("width") = 64)
+          .def("write_block", &region_write_block,
+               "Write the registers in data (any contiguous buffer) starting at offset",
+               py::arg("offset"), py::arg("data"), py::arg("width") = 64)
+          .def("dump", &region_dump,
+               "Read size bytes of registers starting at start (0 reads to the end)",
+               py::arg("start") = 0, py::arg("size") = 0, py::arg("width") = 64)
+          .def("restore",
+               [](mmio_region *r, py::buffer data, uint64_t start, unsigned width) {
+                 region_write_block(r, start, data, width);
+               },
+               "Write back registers saved with dump",
+               py::arg("data"), py::arg("start") = 0, py::arg("width") = 64);
 
-  py::class_<system_buffer> pybuffer(m, "system_buffer", "");
-  pybuffer.def_property_readonly("size", [](system_buffer *b) -> size_t { return b->size; })
+  py::class_<system_buffer> pybuffer(m, "system_buffer", py::buffer_protocol(), "");
+  pybuffer.def_buffer([](system_buffer &b) -> py::buffer_info {
+            // A writable, zero-copy view of the DMA buffer, e.g. for
+            // numpy.frombuffer(buf, dtype=numpy.uint64).
+            return py::buffer_info(
+                b.buf, sizeof(uint8_t), py::format_descriptor<uint8_t>::format(),
+                static_cast<ssize_t>(b.size));
+          })
+          .def_property_readonly("size", [](system_buffer *b) -> size_t { return b->size; })
           .def_property_readonly("address", [](system_buffer *b) -> uint64_t { return reinterpret_cast<uint64_t>(b->buf); })
           .def_property_readonly("io_address", [](system_buffer *b) -> uint64_t { return b->iova; })
           .def("__getitem__", &system_buffer::get_uint64)
@@ -80,11 +146,16 @@ PYBIND11_MODULE(libvfio, m)
           .def("read16", &system_buffer::get<uint16_t>)
           .def("read32", &system_buffer::get<uint32_t>)
           .def("read64", &system_buffer::get<uint64_t>)
-          .def("fill8", &system_buffer::fill<uint8_t>)
-          .def("fill16", &system_buffer::fill<uint16_t>)
-          .def("fill32", &system_buffer::fill<uint32_t>)
-          .def("fill64", &system_buffer::fill<uint64_t>)
-          .def("compare", &system_buffer::compare)
+          .def("fill8", &system_buffer::fill<uint8_t>,
+               py::call_guard<py::gil_scoped_release>())
+          .def("fill16", &system_buffer::fill<uint16_t>,
+               py::call_guard<py::gil_scoped_release>())
+          .def("fill32", &system_buffer::fill<uint32_t>,
+               py::call_guard<py::gil_scoped_release>())
+          .def("fill64", &system_buffer::fill<uint64_t>,
+               py::call_guard<py::gil_scoped_release>())
+          .def("compare", &system_buffer::compare,
+               py::call_guard<py::gil_scoped_release>())
           .def("__repr__", [](system_buffer *b) -> std::string {
              std::ostringstream oss;
              oss << "size: " << b->size
@@ -44,12 +44,24 @@
 	p;                                               \
 })
 
+// OFS_LOG_COMPILE_LEVEL is the highest log level compiled in:
+// 0 keeps only OFS_ERR, 1 adds OFS_MSG and 2 (the default) adds
+// OFS_DBG, which also requires LIBOFS_DEBUG.
+#ifndef OFS_LOG_COMPILE_LEVEL
+#define OFS_LOG_COMPILE_LEVEL 2
+#endif // OFS_LOG_COMPILE_LEVEL
+
 #ifdef OFS_MSG
 #undef OFS_MSG
 #endif // OFS_MSG
+#if OFS_LOG_COMPILE_LEVEL >= 1
 #define OFS_MSG(__fmt, ...) \
 ofs_print(OFS_LOG_MESSAGE, "%s:%u:%s() : " __fmt "\n", \
 	  __SHORT_FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#define OFS_MSG(__fmt, ...) \
+do { if (0) ofs_print(OFS_LOG_MESSAGE, __fmt, ##__VA_ARGS__); } while (0)
+#endif // OFS_LOG_COMPILE_LEVEL
 
 #ifdef OFS_ERR
 #undef OFS_ERR
@@ -61,7 +73,7 @@ ofs_print(OFS_LOG_ERROR, "%s:%u:%s() **ERROR** : [errno=%s] " __fmt "\n", \
 #ifdef OFS_DBG
 #undef OFS_DBG
 #endif // OFS_DBG
-#ifdef LIBOFS_DEBUG
+#if defined(LIBOFS_DEBUG) && (OFS_LOG_COMPILE_LEVEL >= 2)
 #define OFS_DBG(__fmt, ...) \
 ofs_print(OFS_LOG_DEBUG, "%s:%u:%s() *DEBUG* : " __fmt "\n", \
 	  __SHORT_FILE__, __LINE__, __func__, ##__VA_ARGS__)
@@ -73,6 +73,23 @@ extern "C" {
  * using FPGA_BUF_PREALLOCATED, the input len is rounded up to the nearest
  * multiple of page size.
  *
+ * Buffers allocated by this function prefer the NUMA node the device is
+ * attached to, so that DMA traffic does not cross the socket interconnect.
+ * When that node has no free (huge) pages, the allocation falls back to
+ * another node rather than failing. FPGA_BUF_NUMA_NODE(n) prefers node n
+ * instead, FPGA_BUF_NUMA_INTERLEAVE spreads the pages across all nodes, and
+ * FPGA_BUF_NUMA_ANY applies no policy, leaving placement to the process'
+ * memory policy (e.g. numactl). Placement flags are ignored for
+ * FPGA_BUF_PREALLOCATED buffers and when the device's node is unknown.
+ *
+ * Once fpgaBindSVA() has succeeded on the handle, FPGA_BUF_SVA prepares a
+ * buffer for shared virtual addressing: the accelerator reaches the memory
+ * through the process' page tables, so the IO address of the buffer is its
+ * virtual address and no pages are pinned or mapped in the IOMMU. Unless
+ * FPGA_BUF_PREALLOCATED is also given, the memory is backed by 2MB pages when
+ * they are available and by ordinary pages otherwise. Plugins without shared
+ * virtual addressing return FPGA_NOT_SUPPORTED or FPGA_INVALID_PARAM.
+ *
  * @param[in]  handle     Handle to previously opened accelerator resource
  * @param[in]  len        Length of the buffer to allocate/prepare in bytes
  * @param[inout] buf_addr Virtual address of buffer. Contents may be NULL (OS
@@ -84,6 +101,10 @@ extern "C" {
  *                        pointed at in '*buf_addr' is already allocated an
  *                        mapped into virtual memory. FPGA_BUF_READ_ONLY
  *                        pins pages with only read access from the FPGA.
+ *                        FPGA_BUF_NUMA_ANY, FPGA_BUF_NUMA_INTERLEAVE and
+ *                        FPGA_BUF_NUMA_NODE(n) select the buffer's NUMA
+ *                        placement (see below). FPGA_BUF_SVA prepares a
+ *                        shared virtual addressing buffer (see below).
  * @returns FPGA_OK on success. FPGA_NO_MEMORY if the requested memory could
  * not be allocated. FPGA_INVALID_PARAM if invalid parameters were provided, or
  * if the parameter combination is not valid. FPGA_EXCEPTION if an internal
@@ -28,9 +28,11 @@
 #include <opae/cxx/core/events.h>
 #include <opae/cxx/core/except.h>
 #include <opae/cxx/core/handle.h>
+#include <opae/cxx/core/perf_sampler.h>
 #include <opae/cxx/core/properties.h>
 #include <opae/cxx/core/pvalue.h>
 #include <opae/cxx/core/shared_buffer.h>
+#include <opae/cxx/core/sva_allocator.h>
 #include <opae/cxx/core/sysobject.h>
 #include <opae/cxx/core/token.h>
 #include <opae/cxx/core/version.h>
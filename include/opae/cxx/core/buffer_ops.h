@@ -0,0 +1,134 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <cstddef>
+#include <chrono>
+#include <cstdint>
+
+namespace opae {
+namespace fpga {
+namespace types {
+
+/** Host-side kernels for preparing and verifying buffer contents.
+ *
+ * The kernels work on plain memory, so that they can be used on
+ * shared_buffer objects as well as on buffers obtained elsewhere.
+ * On x86, the implementation is selected at run time from
+ * AVX-512, AVX2 and SSE4.2 variants, according to what the CPU
+ * supports. Every variant produces the same results.
+ */
+namespace buffer_ops {
+
+/** The result of a detailed buffer comparison.
+ */
+struct compare_result {
+  /** Byte offset of the first difference, or the compared
+   * length when the buffers are equal.
+   */
+  std::size_t first_mismatch;
+  /** Number of bytes that differ.
+   */
+  std::size_t mismatches;
+};
+
+/** Fill buf with a byte counter, starting at start and wrapping
+ * at 0xff.
+ */
+void fill_incrementing(void *buf, std::size_t len, uint8_t start = 0);
+
+/** Fill buf with the PRBS-31 (x^31 + x^28 + 1) bit sequence
+ * generated from seed, most significant bit first.
+ * @param[in] seed The initial 31-bit LFSR state. Must be non-zero.
+ */
+void fill_prbs31(void *buf, std::size_t len, uint32_t seed = 0x7fffffff);
+
+/** Fill buf with pseudo-random data generated from seed.
+ * The same seed always produces the same data.
+ */
+void fill_random(void *buf, std::size_t len, uint64_t seed);
+
+/** Compare the first len bytes of a and b.
+ */
+compare_result compare(const void *a, const void *b, std::size_t len);
+
+/** Compare the first len bytes of buf against the pattern
+ * written by fill_incrementing(buf, len, start).
+ */
+compare_result compare_incrementing(const void *buf, std::size_t len,
+                                    uint8_t start = 0);
+
+/** Compute the CRC-32C (Castagnoli) of the first len bytes of buf.
+ * @param[in] crc The CRC of any preceding data, to continue
+ * a running checksum.
+ */
+uint32_t crc32c(const void *buf, std::size_t len, uint32_t crc = 0);
+
+/** Statistics gathered by a call to wait_for().
+ */
+struct wait_stats {
+  /** Time from the start of the wait until the value matched
+   * or the wait timed out.
+   */
+  std::chrono::nanoseconds latency;
+  /** Number of times the wait slept or entered UMWAIT before
+   * the value matched.
+   */
+  uint32_t wakeups;
+  /** True when the wait used UMONITOR/UMWAIT.
+   */
+  bool umwait;
+};
+
+/** Wait for a location in host memory, typically a status word
+ * written by the accelerator, to satisfy (*addr & mask) == value.
+ *
+ * When the CPU supports WAITPKG, the wait arms UMONITOR on the
+ * cache line and parks in UMWAIT until it is written. Otherwise,
+ * it busy-polls briefly and then sleeps with an increasing
+ * interval.
+ * @param[in] addr The location to watch.
+ * @param[in] width The size of the location in bytes: 1, 2, 4 or 8.
+ * @param[in] timeout How long to wait before giving up.
+ * @param[out] stats If not null, receives the wait statistics.
+ * @return true if the value matched before the timeout.
+ */
+bool wait_for(const volatile void *addr, unsigned width, uint64_t mask,
+              uint64_t value, std::chrono::nanoseconds timeout,
+              wait_stats *stats = nullptr);
+
+/** Whether wait_for() uses UMONITOR/UMWAIT on this CPU.
+ */
+bool has_umwait();
+
+/** The name of the instruction set selected for the kernels,
+ * one of "avx512", "avx2" or "generic".
+ */
+const char *isa();
+
+}  // end of namespace buffer_ops
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
@@ -0,0 +1,208 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <opae/cxx/core/handle.h>
+#include <opae/cxx/core/sysobject.h>
+#include <opae/cxx/core/token.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace opae {
+namespace fpga {
+namespace types {
+
+/** Continuous sampler for the FME global performance counters.
+ *
+ * perf_sampler resolves the perf/cache, perf/fabric and perf/iommu
+ * counter objects of an FME once and keeps the FME open, so that
+ * a sample only costs a freeze, a read of each counter and an
+ * unfreeze per counter group. Samples are taken on demand with
+ * sample_now(), or at a fixed interval on a background thread
+ * started with start(). Both land in a ring buffer that keeps the
+ * most recent samples.
+ */
+class perf_sampler {
+ public:
+  typedef std::shared_ptr<perf_sampler> ptr_t;
+  typedef std::chrono::steady_clock clock;
+
+  /** Counter groups of the FME perf feature.
+   */
+  enum class group { cache, fabric, iommu };
+
+  /** A counter found by open().
+   */
+  struct counter {
+    group grp;         ///< The group the counter belongs to.
+    std::string name;  ///< Path relative to the group, e.g. "read_hit".
+  };
+
+  /** One snapshot of all counters, in counters() order.
+   */
+  struct sample {
+    clock::time_point time;       ///< When the snapshot was taken.
+    std::vector<uint64_t> values; ///< Raw counter values.
+    std::vector<uint64_t> deltas; ///< Increase since the previous sample.
+  };
+
+  perf_sampler(const perf_sampler &) = delete;
+  perf_sampler &operator=(const perf_sampler &) = delete;
+
+  /** perf_sampler destructor. Stops sampling and closes the FME.
+   */
+  virtual ~perf_sampler();
+
+  /** Open the performance counters of an FME.
+   *
+   * The first reading is taken here, so the deltas of the first
+   * sample count from the time of the call.
+   *
+   * @param[in] fme      A token for an FPGA_DEVICE.
+   * @param[in] capacity The number of samples kept in the ring buffer.
+   * @param[in] counter_bits The width of the hardware counters, used to
+   *                     correct deltas when a counter wraps around.
+   * @return A valid perf_sampler smart pointer, or an empty smart
+   * pointer if the FME has no performance counters.
+   */
+  static ptr_t open(token::ptr_t fme, size_t capacity = 1024,
+                    unsigned counter_bits = 64);
+
+  /** The counters found on the FME.
+   */
+  const std::vector<counter> &counters() const { return counters_; }
+
+  /** Find a counter.
+   * @return The index of the counter in counters() and in the
+   * sample vectors, or -1 if the FME doesn't have it.
+   */
+  int find(group g, const std::string &name) const;
+
+  /** The sysfs name of a counter group.
+   */
+  static const char *group_name(group g);
+
+  /** Take a sample now.
+   * The sample is also appended to the ring buffer.
+   */
+  sample sample_now();
+
+  /** Read the counters of one group now.
+   * Only that group is frozen and read. The values are indexed
+   * like counters(), and the entries of other groups are 0. The
+   * reading is not recorded in the ring buffer or the totals.
+   */
+  std::vector<uint64_t> read_group(group g);
+
+  /** Sample at a fixed interval on a background thread.
+   * Calling start() while running changes the interval, starting
+   * after the next sample. The thread stops by itself if the
+   * counters can no longer be read, and error() then holds the
+   * exception that stopped it.
+   */
+  void start(std::chrono::microseconds interval);
+
+  /** Stop the background thread, if running.
+   */
+  void stop();
+
+  /** Whether the background thread is running.
+   */
+  bool running() const;
+
+  /** The exception that stopped the background thread, or an
+   * empty exception_ptr. Cleared by start().
+   */
+  std::exception_ptr error() const;
+
+  /** Copy the samples in the ring buffer, oldest first.
+   */
+  std::vector<sample> samples() const;
+
+  /** Remove and return the samples in the ring buffer, oldest first.
+   */
+  std::vector<sample> drain();
+
+  /** The number of samples overwritten in the ring buffer before
+   * they were drained.
+   */
+  uint64_t dropped() const;
+
+  /** The sum of the deltas of all samples taken since open().
+   */
+  std::vector<uint64_t> totals() const;
+
+ protected:
+  perf_sampler(handle::ptr_t fme, size_t capacity, unsigned counter_bits);
+
+ private:
+  struct counter_group {
+    group grp;
+    sysobject::ptr_t freeze;
+    size_t first;
+    std::vector<sysobject::ptr_t> objects;
+  };
+
+  void resolve();
+  void read(const counter_group &cg, std::vector<uint64_t> &values);
+  void read(std::vector<uint64_t> &values);
+  sample take();
+  void push(const sample &s);
+  void run();
+
+  handle::ptr_t fme_;
+  uint64_t mask_;
+  std::vector<counter> counters_;
+  std::vector<counter_group> groups_;
+
+  mutable std::mutex read_lock_;
+  std::vector<uint64_t> last_;
+  std::vector<uint64_t> totals_;
+
+  mutable std::mutex ring_lock_;
+  std::vector<sample> ring_;
+  size_t head_;
+  size_t count_;
+  uint64_t dropped_;
+
+  mutable std::mutex thread_lock_;
+  std::condition_variable wake_;
+  std::thread thread_;
+  std::chrono::microseconds interval_;
+  bool stop_;
+  std::exception_ptr error_;
+};
+
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
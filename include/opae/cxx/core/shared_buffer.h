@@ -25,6 +25,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 #include <opae/buffer.h>
+#include <opae/cxx/core/buffer_ops.h>
 #include <opae/cxx/core/except.h>
 #include <opae/cxx/core/handle.h>
 
@@ -69,6 +70,31 @@ class shared_buffer {
   static shared_buffer::ptr_t allocate(handle::ptr_t handle, size_t len,
                                        bool read_only = false);
 
+  /** NUMA placement policies for allocate().
+   */
+  enum class placement {
+    device,     ///< prefer the device's NUMA node (the default)
+    node,       ///< prefer the NUMA node given to allocate()
+    any,        ///< no policy, the process' memory policy applies
+    interleave  ///< interleave pages across all NUMA nodes
+  };
+
+  /** shared_buffer factory method - allocate a shared_buffer
+   * with an explicit NUMA placement.
+   * @param[in] handle The handle used to allocate the buffer.
+   * @param[in] len    The length in bytes of the requested buffer.
+   * @param[in] read_only Set to true for a read only buffer.
+   * @param[in] where  The NUMA placement policy for the buffer.
+   * @param[in] numa_node The node used with placement::node.
+   * @return A valid shared_buffer smart pointer on success, or an
+   * empty smart pointer on failure.
+   * @throws invalid_param if placement::node is given without a
+   * valid numa_node.
+   */
+  static shared_buffer::ptr_t allocate(handle::ptr_t handle, size_t len,
+                                       bool read_only, placement where,
+                                       int numa_node = -1);
+
   /** Attach a pre-allocated buffer to a shared_buffer object.
    *
    * @param[in] handle The handle used to attach the buffer.
@@ -123,15 +149,43 @@ class shared_buffer {
    */
   uint64_t io_address() const { return io_address_; }
 
+  /** Data patterns for fill(pattern, uint64_t).
+   */
+  enum class pattern {
+    incrementing,  ///< byte counter starting at the low byte of seed
+    prbs31,        ///< PRBS-31 bit sequence, seed is the LFSR state
+    random         ///< pseudo-random data generated from seed
+  };
+
   /** Write c to each byte location in the buffer.
    */
   void fill(int c);
 
+  /** Fill the buffer with a generated data pattern.
+   * @see buffer_ops
+   */
+  void fill(pattern p, uint64_t seed = 0);
+
   /** Compare this shared_buffer (the first len bytes)
    * to that held in other, using memcmp().
    */
   int compare(ptr_t other, size_t len) const;
 
+  /** Compare this shared_buffer (the first len bytes)
+   * to that held in other, counting the bytes that differ.
+   * @return The offset of the first difference and the
+   * number of differences.
+   */
+  buffer_ops::compare_result compare_detail(ptr_t other, size_t len) const;
+
+  /** Compute the CRC-32C of len bytes starting at offset.
+   */
+  uint32_t crc32c(size_t offset, size_t len) const;
+
+  /** Compute the CRC-32C of the whole buffer.
+   */
+  uint32_t crc32c() const { return crc32c(0, len_); }
+
   /** Read a T-sized block of memory at the given location.
    * @param[in] offset The byte offset from the start of the buffer.
    * @return A T from buffer base + offset.
@@ -148,6 +202,28 @@ class shared_buffer {
     return T();
   }
 
+  /** Wait for the T-sized value at the given location to satisfy
+   * (value & mask) == expected, as when the accelerator updates
+   * a status word in a DSM buffer.
+   * @param[in] offset The byte offset from the start of the buffer.
+   * @param[in] mask The bits of the value to compare.
+   * @param[in] expected The value the masked bits must match.
+   * @param[in] timeout How long to wait before giving up.
+   * @param[out] stats If not null, receives the wait statistics.
+   * @return true if the value matched before the timeout.
+   * @see buffer_ops::wait_for
+   */
+  template <typename T>
+  bool wait_for(size_t offset, T mask, T expected,
+                std::chrono::nanoseconds timeout,
+                buffer_ops::wait_stats *stats = nullptr) const {
+    if ((offset + sizeof(T) > len_) || (virt_ == nullptr)) {
+      throw except(OPAECXX_HERE);
+    }
+    return buffer_ops::wait_for(virt_ + offset, sizeof(T), mask, expected,
+                                timeout, stats);
+  }
+
   /** Write a T-sized block of memory to the given location.
    * @param[in] value The value to write.
    * @param[in] offset The byte offset from the start of the buffer.
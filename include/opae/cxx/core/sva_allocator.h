@@ -0,0 +1,202 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <opae/cxx/core/handle.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace opae {
+namespace fpga {
+namespace types {
+
+/** Memory shared with an accelerator through shared virtual addressing.
+ *
+ * Once a handle is bound to a PASID (see handle::bind_sva), the
+ * accelerator reaches host memory through the process' page tables.
+ * Memory allocated here is therefore usable for DMA at its virtual
+ * address, without pinning or IOMMU mapping.
+ *
+ * Requests of up to arena_size / 2 bytes are carved out of shared
+ * arenas of arena_size (2MB) bytes, each backed by a 2MB page when
+ * the system has them. They are rounded up to a multiple of
+ * granularity (64) bytes and aligned to it. An arena is released
+ * when it empties, except for the last one. Larger requests get a
+ * buffer of their own, rounded up to a multiple of 2MB (or 4KB
+ * without hugepages).
+ *
+ * Use sva_allocator to place the storage of standard containers
+ * in this memory.
+ */
+class sva_memory {
+ public:
+  typedef std::shared_ptr<sva_memory> ptr_t;
+
+  /** The size of an arena that small requests are carved out of.
+   */
+  static constexpr std::size_t arena_size = 2 * 1024 * 1024;
+
+  /** The size and alignment unit of requests served from an arena.
+   */
+  static constexpr std::size_t granularity = 64;
+
+  sva_memory(const sva_memory &) = delete;
+  sva_memory &operator=(const sva_memory &) = delete;
+
+  /** sva_memory destructor. Releases any remaining allocations.
+   */
+  virtual ~sva_memory();
+
+  /** sva_memory factory method - bind the handle to a PASID.
+   * @param[in] handle The accelerator handle.
+   * @return A valid sva_memory smart pointer, or an empty smart
+   * pointer if the platform doesn't support shared virtual
+   * addressing.
+   */
+  static ptr_t open(handle::ptr_t handle);
+
+  /** Allocate memory for DMA.
+   * @param[in] len The length in bytes.
+   * @return The address of the memory, which is also its IO address.
+   * @throws std::bad_alloc if the memory can't be allocated.
+   */
+  void *allocate(std::size_t len);
+
+  /** Release memory returned by allocate().
+   */
+  void deallocate(void *p);
+
+  /** The IO address of p, to be programmed into the accelerator.
+   */
+  static uint64_t io_address(const void *p) {
+    return reinterpret_cast<uint64_t>(p);
+  }
+
+  /** The handle the memory is shared with.
+   */
+  handle::ptr_t owner() const { return handle_; }
+
+  /** The process address space ID bound to the handle.
+   */
+  uint32_t pasid() const { return pasid_; }
+
+ protected:
+  sva_memory(handle::ptr_t handle, uint32_t pasid);
+
+  /** Get len bytes of SVA memory from the handle.
+   * @return The address, or nullptr on failure.
+   */
+  virtual void *prepare(std::size_t len, uint64_t *wsid);
+
+  /** Return memory obtained with prepare().
+   */
+  virtual void release(uint64_t wsid);
+
+  /** The number of arenas currently held.
+   */
+  std::size_t num_arenas() const;
+
+  /** Release all remaining memory. A subclass that overrides
+   * release() calls this from its own destructor.
+   */
+  void free_all();
+
+ private:
+  struct arena {
+    uint8_t *base;
+    uint64_t wsid;
+    std::size_t used;
+    std::map<std::size_t, std::size_t> free;  // offset -> length
+
+    void *take(std::size_t len);
+    void give(std::size_t offset, std::size_t len);
+  };
+
+  handle::ptr_t handle_;
+  uint32_t pasid_;
+  mutable std::mutex lock_;
+  std::map<void *, uint64_t> wsids_;
+  std::list<arena> arenas_;
+  std::map<void *, std::pair<arena *, std::size_t>> blocks_;
+};
+
+/** A standard allocator that allocates from sva_memory.
+ *
+ * Containers using sva_allocator hold their elements in memory the
+ * accelerator can read and write directly, so they can be DMA
+ * sources and targets without staging copies:
+ *
+ * @code{.cpp}
+ * auto mem = sva_memory::open(h);
+ * std::vector<uint64_t, sva_allocator<uint64_t>> v(1024, 0,
+ *     sva_allocator<uint64_t>(mem));
+ * h->write_csr64(SRC_ADDR, sva_memory::io_address(v.data()));
+ * @endcode
+ */
+template <typename T>
+class sva_allocator {
+ public:
+  typedef T value_type;
+
+  explicit sva_allocator(sva_memory::ptr_t memory) : memory_(memory) {}
+
+  template <typename U>
+  sva_allocator(const sva_allocator<U> &other) noexcept
+      : memory_(other.memory()) {}
+
+  T *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_alloc();
+    return static_cast<T *>(memory_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, std::size_t) noexcept { memory_->deallocate(p); }
+
+  sva_memory::ptr_t memory() const { return memory_; }
+
+ private:
+  sva_memory::ptr_t memory_;
+};
+
+template <typename T, typename U>
+bool operator==(const sva_allocator<T> &a, const sva_allocator<U> &b) {
+  return a.memory() == b.memory();
+}
+
+template <typename T, typename U>
+bool operator!=(const sva_allocator<T> &a, const sva_allocator<U> &b) {
+  return !(a == b);
+}
+
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
@@ -53,12 +53,30 @@
 	p;                                                     \
 	})
 
+/*
+* OPAE_LOG_COMPILE_LEVEL is the highest log level compiled in:
+* 0 keeps only OPAE_ERR, 1 adds OPAE_MSG and 2 (the default)
+* adds OPAE_DBG, which also requires LIBOPAE_DEBUG. Calls above
+* the level cost nothing at run time.
+*/
+#ifndef OPAE_LOG_COMPILE_LEVEL
+#define OPAE_LOG_COMPILE_LEVEL 2
+#endif // OPAE_LOG_COMPILE_LEVEL
+
 #ifdef OPAE_MSG
 #undef OPAE_MSG
 #endif // OPAE_MSG
+#if OPAE_LOG_COMPILE_LEVEL >= 1
 #define OPAE_MSG(format, ...)                                     \
 	opae_print(OPAE_LOG_MESSAGE, "%s:%u:%s() : " format "\n", \
 	__SHORT_FILE__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#define OPAE_MSG(format, ...)                                     \
+do {                                                              \
+	if (0)                                                    \
+		opae_print(OPAE_LOG_MESSAGE, format, ##__VA_ARGS__); \
+} while (0)
+#endif // OPAE_LOG_COMPILE_LEVEL
 
 #ifdef OPAE_ERR
 #undef OPAE_ERR
@@ -71,7 +89,7 @@
 #ifdef OPAE_DBG
 #undef OPAE_DBG
 #endif // OPAE_DBG
-#ifdef LIBOPAE_DEBUG
+#if defined(LIBOPAE_DEBUG) && (OPAE_LOG_COMPILE_LEVEL >= 2)
 #define OPAE_DBG(format, ...)                                    \
 	opae_print(OPAE_LOG_DEBUG,                               \
 	"%s:%u:%s() *DEBUG* : " format "\n",                     \
@@ -201,6 +201,58 @@ fpga_result fpgaObjectGetSize(fpga_object obj, uint32_t *value, int flags);
 fpga_result fpgaObjectRead(fpga_object obj, uint8_t *buffer, size_t offset,
 			   size_t len, int flags);
 
+/**
+ * @brief Read several windows of bytes from an FPGA object
+ *
+ * Equivalent to calling fpgaObjectRead() once for each window, but when
+ * FPGA_OBJECT_SYNC is used the underlying resource is opened only once and
+ * only the requested windows are fetched from it.
+ *
+ * @param[in] obj An fpga_object instance.
+ * @param[in,out] windows Array of windows to read. Each window's buffer
+ * receives len bytes read from the object at offset.
+ * @param[in] count The number of entries in windows.
+ * @param[in] flags Flags that control how object is read
+ * If FPGA_OBJECT_SYNC is used then the data is read from the resource
+ * rather than from the object's buffered copy.
+ *
+ * @return FPGA_OK on success, FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid or a window extends past the end of the object.
+ * FPGA_EXCEPTION if an error occurred reading the resource.
+ */
+fpga_result fpgaObjectReadv(fpga_object obj, fpga_object_window *windows,
+			    size_t count, int flags);
+
+/**
+ * @brief Read the values of all members of an FPGA object group
+ *
+ * Takes a snapshot of every child of a group (container) object. The
+ * children are read while the group is locked, and the resources backing
+ * them are kept open between snapshots, so that polling a group is cheap.
+ * Each entry reports whether its value has changed since the previous
+ * snapshot of the same group; the first snapshot reports every value as
+ * changed. The value of each child is parsed as a number unless
+ * FPGA_OBJECT_RAW is given. Children that are themselves groups, or that
+ * can't be read, have their result set to an error code and are skipped.
+ * The group must have been retrieved with FPGA_OBJECT_RECURSE_ONE or
+ * FPGA_OBJECT_RECURSE_ALL for its children to be present.
+ *
+ * @param[in] group An fpga_object instance that is a group.
+ * @param[out] values Array receiving one entry per child, in the same order
+ * as fpgaObjectGetObjectAt().
+ * @param[in] count The number of entries in values. Must be at least the
+ * number of children, as returned by fpgaObjectGetSize().
+ * @param[out] changed If not NULL, receives the number of entries whose
+ * value changed.
+ * @param[in] flags Flags that control how the children are read
+ * If FPGA_OBJECT_RAW is used, each value is read as raw bytes.
+ *
+ * @return FPGA_OK on success, FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid or obj is not a group.
+ */
+fpga_result fpgaObjectReadGroup(fpga_object group, fpga_object_value *values,
+				size_t count, size_t *changed, int flags);
+
 /**
  * @brief Read a 64-bit value from an FPGA object.
  * The value is assumed to be in string format and will be parsed. See flags
@@ -188,6 +188,29 @@ struct fpga_error_info {
  */
 typedef void *fpga_object;
 
+/** A window of an object's data, for use with fpgaObjectReadv()
+ *
+ * Describes one range of bytes to read from an `fpga_object` and where to
+ * store them.
+ */
+typedef struct fpga_object_window {
+	uint8_t *buffer;   // Destination for the data
+	size_t offset;     // Byte offset of the window within the object
+	size_t len;        // Length of the window in bytes
+} fpga_object_window;
+
+/** The value of one member of an object group, for use with
+ * fpgaObjectReadGroup()
+ *
+ * Each entry describes the child object at the same index in the group.
+ */
+typedef struct fpga_object_value {
+	const char *name;    // Name of the child, owned by the group
+	uint64_t value;      // Value read from the child
+	fpga_result result;  // FPGA_OK if value was read
+	bool changed;        // value differs from the previous snapshot
+} fpga_object_value;
+
 /** FPGA Metric string size
  *
  *
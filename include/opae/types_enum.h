@@ -145,9 +145,29 @@ typedef enum {
 enum fpga_buffer_flags {
 	FPGA_BUF_PREALLOCATED = (1u << 0), /**< Use existing buffer */
 	FPGA_BUF_QUIET = (1u << 1),        /**< Suppress error messages */
-	FPGA_BUF_READ_ONLY = (1u << 2)     /**< Buffer is read-only */
+	FPGA_BUF_READ_ONLY = (1u << 2),    /**< Buffer is read-only */
+	/** Don't place the buffer on the device's NUMA node */
+	FPGA_BUF_NUMA_ANY = (1u << 3),
+	/** Interleave the buffer's pages across all NUMA nodes */
+	FPGA_BUF_NUMA_INTERLEAVE = (1u << 4),
+	/** Place the buffer on the node given by FPGA_BUF_NUMA_NODE() */
+	FPGA_BUF_NUMA_NODE_VALID = (1u << 5),
+	/** Shared virtual addressing: the IO address of the buffer is its
+	 * virtual address and the buffer is not pinned or mapped in the
+	 * IOMMU. Requires a PASID bound with fpgaBindSVA(). */
+	FPGA_BUF_SVA = (1u << 6)
 };
 
+/** Select the NUMA node for fpgaPrepareBuffer() (0 <= n < 256). */
+#define FPGA_BUF_NUMA_NODE(n) \
+	(FPGA_BUF_NUMA_NODE_VALID | (((n) & 0xff) << 16))
+/** Extract the NUMA node given to FPGA_BUF_NUMA_NODE() from flags. */
+#define FPGA_BUF_NUMA_NODE_OF(flags) (((flags) >> 16) & 0xff)
+/** All fpgaPrepareBuffer() flag bits that select a NUMA placement. */
+#define FPGA_BUF_NUMA_MASK \
+	(FPGA_BUF_NUMA_ANY | FPGA_BUF_NUMA_INTERLEAVE | \
+	 FPGA_BUF_NUMA_NODE_VALID | (0xff << 16))
+
 /**
  * Open flags
  *
@@ -156,6 +156,7 @@ struct opae_vfio {
 	struct opae_vfio_group group;			/**< The VFIO device group. */
 	struct opae_vfio_device device;			/**< The VFIO device. */
 	opae_hash_map cont_buffers;		/**< Map of allocated DMA buffers. */
+	struct opae_vfio *cont_owner;		/**< Device whose container is shared, or NULL. */
 };
 
 #ifdef __cplusplus
@@ -244,15 +245,55 @@ int opae_vfio_secure_open(struct opae_vfio *v,
 			  const char *pciaddr,
 			  const char *token);
 
+/**
+ * Open and populate a VFIO device in the container of another
+ *
+ * Opens the PCIe device corresponding to the address given in pciaddr,
+ * attaching its group to the container already opened for owner rather
+ * than to a new container. Both devices then share one IOMMU domain:
+ * a DMA buffer mapped through either device is visible to both, and
+ * buffers allocated through v take their IOVAs from owner's IOVA space.
+ * owner must not be closed before v.
+ *
+ * This fails when the IOMMU can't place both groups in one domain. The
+ * caller may then fall back to opae_vfio_open() or
+ * opae_vfio_secure_open() and map buffers into each container.
+ *
+ * @param[out] v       Storage for the device info. May be stack-resident.
+ * @param[in]  pciaddr The PCIe address of the requested device.
+ * @param[in]  token   The GUID representing the VF token, or NULL.
+ * @param[in]  owner   An open device that owns its container.
+ * @returns Non-zero on error. Zero on success.
+ *
+ * Example
+ * @code{.c}
+ * opae_vfio parent;
+ * opae_vfio child;
+ *
+ * if (opae_vfio_open(&parent, "0000:00:00.0")) {
+ *   // handle error
+ * }
+ *
+ * if (opae_vfio_open_shared(&child, "0000:00:00.1", NULL, &parent) &&
+ *     opae_vfio_open(&child, "0000:00:00.1")) {
+ *   // handle error
+ * }
+ * @endcode
+ */
+int opae_vfio_open_shared(struct opae_vfio *v,
+			  const char *pciaddr,
+			  const char *token,
+			  struct opae_vfio *owner);
+
 /**
  * Note a new contraint on the group's IOVA space.
  *
- * OPAE does not yet attempt to connect multiple groups to the same vfio
- * container. When multiple groups and containers are active in the same
- * process, OPAE instead treats one container as the parent and applies
- * the IOVA contraints of all other containers to the parent. This way,
- * an IOVA choice in the parent is guaranteed legal in all groups.
- * For now, the IOMMU has to be configured for each device but the
+ * When a device could not be opened into the container of another
+ * with opae_vfio_open_shared(), multiple containers are active in the
+ * same process. OPAE then treats one container as the parent and
+ * applies the IOVA contraints of all other containers to the parent.
+ * This way, an IOVA choice in the parent is guaranteed legal in all
+ * groups. The IOMMU has to be configured for each container but the
  * same IOVA can be used because of the constraint managed here.
  *
  * @param[in] new_v  New source of IOVA constraints.
@@ -377,8 +418,17 @@ int opae_vfio_buffer_allocate(struct opae_vfio *v,
  */
 enum opae_vfio_buffer_flags {
 	OPAE_VFIO_BUF_PREALLOCATED = 1, /**< Use existing buffer */
+	/** Prefer the node given by OPAE_VFIO_BUF_NUMA_NODE() */
+	OPAE_VFIO_BUF_NUMA_PREFERRED = 2,
+	/** Interleave pages across all NUMA nodes */
+	OPAE_VFIO_BUF_NUMA_INTERLEAVE = 4,
 };
 
+/** Encode the NUMA node for OPAE_VFIO_BUF_NUMA_PREFERRED (0 <= n < 256). */
+#define OPAE_VFIO_BUF_NUMA_NODE(n) (((n) & 0xff) << 16)
+/** Extract the NUMA node given to OPAE_VFIO_BUF_NUMA_NODE() from flags. */
+#define OPAE_VFIO_BUF_NUMA_NODE_OF(flags) (((flags) >> 16) & 0xff)
+
 /**
  * Allocate and map system buffer (extended w/ flags)
  *
@@ -394,6 +444,9 @@ enum opae_vfio_buffer_flags {
  * greater than 4096, then the request is fulfilled by a 2MB huge
  * page. Else, the request is fulfilled by the non-huge page pool.
  *
+ * OPAE_VFIO_BUF_NUMA_PREFERRED and OPAE_VFIO_BUF_NUMA_INTERLEAVE set
+ * the NUMA policy of a newly-mapped buffer before it is pinned.
+ *
  * @param[in, out] v    The open OPAE VFIO device.
  * @param[in, out] size A pointer to the requested size. The size
  *                      may be rounded to the next page size prior
@@ -0,0 +1,392 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AFU_BENCH_TSC 1
+#endif
+
+namespace opae {
+namespace afu_test {
+
+// Cycle counter used to time individual operations. On x86 this is
+// the TSC, fenced so that the timed operation can't be reordered
+// around the reads. Elsewhere, it falls back to steady_clock.
+class bench_clock {
+public:
+  static uint64_t start()
+  {
+#ifdef AFU_BENCH_TSC
+    _mm_lfence();
+    return __rdtsc();
+#else
+    return now_ns();
+#endif
+  }
+
+  static uint64_t stop()
+  {
+#ifdef AFU_BENCH_TSC
+    unsigned int aux;
+    uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+#else
+    return now_ns();
+#endif
+  }
+
+  // Ticks per nanosecond, measured against steady_clock.
+  static double ticks_per_ns()
+  {
+    static const double tpns = calibrate();
+    return tpns;
+  }
+
+  // Cost of a back-to-back start()/stop() pair, in ticks. This is
+  // subtracted from every sample.
+  static uint64_t overhead()
+  {
+    static const uint64_t ovh = measure_overhead();
+    return ovh;
+  }
+
+private:
+  static uint64_t now_ns()
+  {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+  }
+
+  static double calibrate()
+  {
+#ifdef AFU_BENCH_TSC
+    using namespace std::chrono;
+    auto t0 = steady_clock::now();
+    uint64_t c0 = start();
+    while (steady_clock::now() - t0 < milliseconds(10))
+      ;
+    uint64_t c1 = stop();
+    auto t1 = steady_clock::now();
+    auto ns = duration_cast<nanoseconds>(t1 - t0).count();
+    return ns > 0 ? static_cast<double>(c1 - c0) / ns : 1.0;
+#else
+    return 1.0;
+#endif
+  }
+
+  static uint64_t measure_overhead()
+  {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i) {
+      uint64_t t0 = start();
+      uint64_t t1 = stop();
+      best = std::min(best, t1 - t0);
+    }
+    return best;
+  }
+};
+
+// Summary of the samples collected for one measurement. All times
+// are in nanoseconds per operation.
+struct bench_result {
+  std::string name;
+  uint64_t iterations;     // timed operations per repeat
+  uint32_t repeats;
+  uint64_t bytes;          // bytes moved per operation, 0 if n/a
+  double min;
+  double mean;
+  double stddev;
+  double ci95;             // half-width of the 95% CI of the mean
+  double p50;
+  double p90;
+  double p99;
+  double p999;
+  double max;
+
+  // Throughput in GB/s derived from the mean, or 0 when bytes is 0.
+  double gbps() const
+  {
+    return mean > 0 ? bytes / mean : 0.0;
+  }
+};
+
+// Warmup, repetition, CPU placement and percentile reporting shared
+// by all afu-test commands. Commands time their operations through
+// afu::bench().measure(); when --bench is given, afu also times the
+// command as a whole and writes a report at the end of the run.
+class benchmark {
+public:
+  struct options {
+    options()
+    : enabled(false)
+    , warmup(1)
+    , repeats(5)
+    , cpu(-1)
+    {}
+    bool enabled;
+    uint32_t warmup;
+    uint32_t repeats;
+    int cpu;
+    std::string json;
+  };
+
+  benchmark()
+  : cpu_(-1)
+  , cpu_node_(-1)
+  , device_node_(-1)
+  {}
+
+  options & opts() { return opts_; }
+  const options & opts() const { return opts_; }
+  bool enabled() const { return opts_.enabled; }
+
+  // Untimed and timed passes to use. Without --bench, a measurement
+  // is a single timed pass, so that commands behave as before.
+  uint32_t warmup() const { return opts_.enabled ? opts_.warmup : 0; }
+  uint32_t repeats() const
+  {
+    return opts_.enabled ? std::max(opts_.repeats, 1u) : 1;
+  }
+
+  // Pin the calling thread (and the threads it creates afterwards)
+  // to the requested CPU, and note which NUMA node it and the device
+  // are on. Returns false if the CPU and device nodes differ.
+  bool setup(const std::string &device_sbdf)
+  {
+    if (opts_.cpu >= 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(opts_.cpu, &set);
+      if (sched_setaffinity(0, sizeof(set), &set))
+        return false;
+    }
+    unsigned cpu = 0, node = 0;
+    if (!syscall(SYS_getcpu, &cpu, &node, nullptr)) {
+      cpu_ = cpu;
+      cpu_node_ = node;
+    }
+    device_sbdf_ = device_sbdf;
+    device_node_ = -1;
+    if (!device_sbdf.empty()) {
+      std::ifstream f("/sys/bus/pci/devices/" + device_sbdf + "/numa_node");
+      if (!(f >> device_node_))
+        device_node_ = -1;
+    }
+    return device_node_ < 0 || cpu_node_ < 0 || device_node_ == cpu_node_;
+  }
+
+  int cpu() const { return cpu_; }
+  int cpu_node() const { return cpu_node_; }
+  int device_node() const { return device_node_; }
+
+  // Time iterations calls of fn, after warmup() untimed passes,
+  // repeats() times over.
+  template<typename Fn>
+  const bench_result & measure(const std::string &name, uint64_t iterations,
+                               Fn fn, uint64_t bytes = 0)
+  {
+    std::vector<uint64_t> samples;
+    std::vector<double> means;
+    uint64_t ovh = bench_clock::overhead();
+
+    iterations = std::max<uint64_t>(iterations, 1);
+    for (uint32_t w = 0; w < warmup(); ++w)
+      for (uint64_t i = 0; i < iterations; ++i)
+        fn();
+
+    samples.reserve(iterations * repeats());
+    for (uint32_t r = 0; r < repeats(); ++r) {
+      uint64_t sum = 0;
+      for (uint64_t i = 0; i < iterations; ++i) {
+        uint64_t t0 = bench_clock::start();
+        fn();
+        uint64_t t1 = bench_clock::stop();
+        uint64_t d = t1 - t0;
+        d = d > ovh ? d - ovh : 0;
+        samples.push_back(d);
+        sum += d;
+      }
+      means.push_back(to_ns(static_cast<double>(sum) / iterations));
+    }
+
+    results_.push_back(summarize(name, iterations, bytes, samples, means));
+    return results_.back();
+  }
+
+  // Record a measurement made elsewhere, one sample per repeat.
+  const bench_result & add(const std::string &name,
+                           const std::vector<uint64_t> &ticks,
+                           uint64_t bytes = 0)
+  {
+    std::vector<double> means;
+    for (auto t : ticks)
+      means.push_back(to_ns(t));
+    results_.push_back(summarize(name, 1, bytes, ticks, means));
+    return results_.back();
+  }
+
+  const std::vector<bench_result> & results() const { return results_; }
+
+  // One-line human readable summary of a result.
+  static std::string format(const bench_result &r)
+  {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "%s: n=%" PRIu64 " x %u, mean %.1f ns (+/- %.1f), "
+             "p50 %.1f, p99 %.1f, p99.9 %.1f, min %.1f, max %.1f",
+             r.name.c_str(), r.iterations, r.repeats, r.mean, r.ci95,
+             r.p50, r.p99, r.p999, r.min, r.max);
+    std::string s(buf);
+    if (r.bytes) {
+      snprintf(buf, sizeof(buf), ", %.3f GB/s", r.gbps());
+      s += buf;
+    }
+    return s;
+  }
+
+  // The report for the whole run. The schema is the same for every
+  // AFU, so results can be compared across tools.
+  std::string json(const std::string &afu, const std::string &command) const
+  {
+    std::ostringstream os;
+    os.precision(6);
+    os << "{\n"
+       << "  \"schema\": \"opae-afu-bench/1\",\n"
+       << "  \"afu\": \"" << afu << "\",\n"
+       << "  \"command\": \"" << command << "\",\n"
+       << "  \"pci_address\": \"" << device_sbdf_ << "\",\n"
+       << "  \"cpu\": " << cpu_ << ",\n"
+       << "  \"cpu_node\": " << cpu_node_ << ",\n"
+       << "  \"device_node\": " << device_node_ << ",\n"
+       << "  \"ticks_per_ns\": " << bench_clock::ticks_per_ns() << ",\n"
+       << "  \"timer_overhead_ns\": " << to_ns(bench_clock::overhead())
+       << ",\n"
+       << "  \"warmup\": " << warmup() << ",\n"
+       << "  \"results\": [";
+    for (size_t i = 0; i < results_.size(); ++i) {
+      const bench_result &r = results_[i];
+      os << (i ? ",\n" : "\n")
+         << "    {\"name\": \"" << r.name << "\""
+         << ", \"iterations\": " << r.iterations
+         << ", \"repeats\": " << r.repeats
+         << ", \"bytes\": " << r.bytes
+         << ", \"min_ns\": " << r.min
+         << ", \"mean_ns\": " << r.mean
+         << ", \"stddev_ns\": " << r.stddev
+         << ", \"ci95_ns\": " << r.ci95
+         << ", \"p50_ns\": " << r.p50
+         << ", \"p90_ns\": " << r.p90
+         << ", \"p99_ns\": " << r.p99
+         << ", \"p999_ns\": " << r.p999
+         << ", \"max_ns\": " << r.max
+         << ", \"gbps\": " << r.gbps() << "}";
+    }
+    os << "\n  ]\n}\n";
+    return os.str();
+  }
+
+private:
+  options opts_;
+  int cpu_;
+  int cpu_node_;
+  int device_node_;
+  std::string device_sbdf_;
+  std::vector<bench_result> results_;
+
+  static double to_ns(double ticks)
+  {
+    return ticks / bench_clock::ticks_per_ns();
+  }
+
+  // Two-sided 95% Student's t quantile for the given degrees of freedom.
+  static double t95(size_t df)
+  {
+    static const double t[] = {
+      0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+      2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+      2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045
+    };
+    return df < sizeof(t)/sizeof(t[0]) ? t[df] : 1.960;
+  }
+
+  static bench_result summarize(const std::string &name, uint64_t iterations,
+                                uint64_t bytes, std::vector<uint64_t> samples,
+                                const std::vector<double> &means)
+  {
+    bench_result r = bench_result();
+    r.name = name;
+    r.iterations = iterations;
+    r.repeats = means.size();
+    r.bytes = bytes;
+    if (samples.empty())
+      return r;
+
+    std::sort(samples.begin(), samples.end());
+    auto pct = [&samples](double p) {
+      size_t i = static_cast<size_t>(std::ceil(p * samples.size()));
+      return to_ns(samples[std::min(std::max<size_t>(i, 1), samples.size()) - 1]);
+    };
+    r.min = to_ns(samples.front());
+    r.max = to_ns(samples.back());
+    r.p50 = pct(0.50);
+    r.p90 = pct(0.90);
+    r.p99 = pct(0.99);
+    r.p999 = pct(0.999);
+
+    // The spread is taken over the per-repeat means, which are
+    // independent, rather than over the individual samples.
+    double sum = 0.0;
+    for (auto m : means)
+      sum += m;
+    r.mean = sum / means.size();
+    if (means.size() > 1) {
+      double var = 0.0;
+      for (auto m : means)
+        var += (m - r.mean) * (m - r.mean);
+      r.stddev = std::sqrt(var / (means.size() - 1));
+      r.ci95 = t95(means.size() - 1) * r.stddev / std::sqrt(means.size());
+    }
+    return r;
+  }
+};
+
+} // end of namespace afu_test
+} // end of namespace opae
@@ -0,0 +1,361 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AFU_MBOX_PAUSE() _mm_pause()
+#else
+#define AFU_MBOX_PAUSE() std::this_thread::yield()
+#endif
+
+namespace opae {
+namespace afu_test {
+
+// Location and encoding of an AFU's indirect register mailbox. An
+// access writes the (write) data, then a command holding the target
+// address; the AFU sets the ack bit when done, and software clears
+// it again by writing the ack bit back.
+struct mbox_regs {
+  uint32_t cmd;            // command/status CSR offset
+  uint32_t data;           // data CSR offset
+  uint32_t select;         // channel-select CSR offset, if has_select
+  bool has_select;
+  uint64_t read_cmd;       // command bits for a read
+  uint64_t write_cmd;      // command bits for a write
+  uint64_t ack;            // ack bit in the command/status CSR
+  uint32_t addr_shift;     // position of the address in the command
+  uint32_t data_shift;     // position of the write data in the data CSR
+};
+
+// Polling policy. Each handshake spins for up to spin_polls reads of
+// the status CSR, then sleeps between polls, starting at min_sleep and
+// doubling up to max_sleep. Most accesses complete within the spin.
+struct mbox_policy {
+  mbox_policy()
+  : spin_polls(256)
+  , min_sleep(std::chrono::microseconds(1))
+  , max_sleep(std::chrono::microseconds(64))
+  , timeout(std::chrono::milliseconds(500))
+  {}
+  uint32_t spin_polls;
+  std::chrono::nanoseconds min_sleep;
+  std::chrono::nanoseconds max_sleep;
+  std::chrono::nanoseconds timeout;
+};
+
+// Running totals for a mailbox. Latencies cover the whole handshake
+// (command, ack and ack clear) and are in nanoseconds.
+struct mbox_stats {
+  mbox_stats()
+  : reads(0)
+  , writes(0)
+  , cached_reads(0)
+  , selects(0)
+  , polls(0)
+  , sleeps(0)
+  , total_ns(0)
+  , min_ns(UINT64_MAX)
+  , max_ns(0)
+  {}
+  uint64_t reads;
+  uint64_t writes;
+  uint64_t cached_reads;   // reads answered from the read cache
+  uint64_t selects;        // channel-select CSR writes
+  uint64_t polls;          // status CSR reads
+  uint64_t sleeps;         // polls that backed off to a sleep
+  uint64_t total_ns;
+  uint64_t min_ns;
+  uint64_t max_ns;
+
+  uint64_t ops() const { return reads + writes; }
+  double mean_ns() const
+  {
+    return ops() ? static_cast<double>(total_ns) / ops() : 0.0;
+  }
+};
+
+// A queue of mailbox operations, run back to back by
+// mailbox::execute(). Each op records its own latency.
+class mbox_batch {
+public:
+  enum op_type { select_op, write_op, read_op, cached_read_op };
+
+  struct op {
+    op_type type;
+    uint64_t addr;           // register address, or channel for select_op
+    uint32_t data;           // value written, or value read
+    uint32_t *result;        // optional destination of a read
+    uint64_t latency_ns;
+  };
+
+  mbox_batch & select(uint64_t channel)
+  {
+    ops_.push_back({select_op, channel, 0, nullptr, 0});
+    return *this;
+  }
+
+  mbox_batch & write(uint32_t addr, uint32_t data)
+  {
+    ops_.push_back({write_op, addr, data, nullptr, 0});
+    return *this;
+  }
+
+  mbox_batch & read(uint32_t addr, uint32_t *result = nullptr)
+  {
+    ops_.push_back({read_op, addr, 0, result, 0});
+    return *this;
+  }
+
+  // A read of a register whose value doesn't change on its own, e.g.
+  // an ID or a configuration register written by this process.
+  mbox_batch & read_cached(uint32_t addr, uint32_t *result = nullptr)
+  {
+    ops_.push_back({cached_read_op, addr, 0, result, 0});
+    return *this;
+  }
+
+  const std::vector<op> & ops() const { return ops_; }
+  std::vector<op> & ops() { return ops_; }
+  size_t size() const { return ops_.size(); }
+  void clear() { ops_.clear(); }
+
+private:
+  std::vector<op> ops_;
+};
+
+// Mailbox transaction engine. Accesses go straight through the mapped
+// MMIO region, and completion is detected by spin-polling with an
+// adaptive backoff, rather than by sleeping between every poll.
+class mailbox {
+public:
+  typedef std::chrono::steady_clock clock;
+
+  mailbox(volatile uint8_t *mmio_base, const mbox_regs &regs,
+          const mbox_policy &policy = mbox_policy())
+  : base_(mmio_base)
+  , regs_(regs)
+  , policy_(policy)
+  , channel_(0)
+  , channel_valid_(false)
+  {}
+
+  // Select a mailbox channel. The select CSR is only written when the
+  // channel changes.
+  void select(uint64_t channel)
+  {
+    if (!regs_.has_select || (channel_valid_ && channel == channel_))
+      return;
+    csr(regs_.select) = channel;
+    channel_ = channel;
+    channel_valid_ = true;
+    ++stats_.selects;
+  }
+
+  void write(uint32_t addr, uint32_t data)
+  {
+    clock::time_point t0 = clock::now();
+    csr(regs_.data) = static_cast<uint64_t>(data) << regs_.data_shift;
+    csr(regs_.cmd) = (static_cast<uint64_t>(addr) << regs_.addr_shift) |
+                     regs_.write_cmd;
+    wait_ack("mbox_write timed out [a]");
+    clear_ack("mbox_write timed out [b]");
+    cache_.erase(cache_key(addr));
+    ++stats_.writes;
+    account(t0);
+  }
+
+  uint32_t read(uint32_t addr)
+  {
+    clock::time_point t0 = clock::now();
+    csr(regs_.cmd) = (static_cast<uint64_t>(addr) << regs_.addr_shift) |
+                     regs_.read_cmd;
+    wait_ack("mbox_read timed out [a]");
+    uint32_t value = static_cast<uint32_t>(csr(regs_.data));
+    clear_ack("mbox_read timed out [b]");
+    ++stats_.reads;
+    account(t0);
+    return value;
+  }
+
+  // Read a register whose value is stable, answering from the cache
+  // when it has been read before. A write to the register (through
+  // this mailbox) drops the cached value.
+  uint32_t read_cached(uint32_t addr)
+  {
+    auto it = cache_.find(cache_key(addr));
+    if (it != cache_.end()) {
+      ++stats_.cached_reads;
+      return it->second;
+    }
+    uint32_t value = read(addr);
+    cache_[cache_key(addr)] = value;
+    return value;
+  }
+
+  // Run a batch of operations in order, recording each one's latency.
+  // Returns the total time taken in nanoseconds.
+  uint64_t execute(mbox_batch &batch)
+  {
+    clock::time_point start = clock::now();
+    for (auto &op : batch.ops()) {
+      clock::time_point t0 = clock::now();
+      switch (op.type) {
+      case mbox_batch::select_op:
+        select(op.addr);
+        break;
+      case mbox_batch::write_op:
+        write(static_cast<uint32_t>(op.addr), op.data);
+        break;
+      case mbox_batch::read_op:
+        op.data = read(static_cast<uint32_t>(op.addr));
+        break;
+      case mbox_batch::cached_read_op:
+        op.data = read_cached(static_cast<uint32_t>(op.addr));
+        break;
+      }
+      if (op.result)
+        *op.result = op.data;
+      op.latency_ns = elapsed_ns(t0);
+    }
+    return elapsed_ns(start);
+  }
+
+  // Forget the read cache and the selected channel, e.g. after the
+  // AFU is reset or its CSRs are accessed by other means.
+  void invalidate()
+  {
+    cache_.clear();
+    channel_valid_ = false;
+  }
+
+  const mbox_stats & stats() const { return stats_; }
+  void reset_stats() { stats_ = mbox_stats(); }
+
+  mbox_policy & policy() { return policy_; }
+
+private:
+  volatile uint64_t & csr(uint32_t offset)
+  {
+    return *reinterpret_cast<volatile uint64_t *>(base_ + offset);
+  }
+
+  std::pair<uint64_t, uint32_t> cache_key(uint32_t addr) const
+  {
+    return std::make_pair(channel_valid_ ? channel_ : 0, addr);
+  }
+
+  static uint64_t elapsed_ns(clock::time_point t0)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now() - t0).count();
+  }
+
+  void account(clock::time_point t0)
+  {
+    uint64_t ns = elapsed_ns(t0);
+    stats_.total_ns += ns;
+    stats_.min_ns = std::min(stats_.min_ns, ns);
+    stats_.max_ns = std::max(stats_.max_ns, ns);
+  }
+
+  // Poll until the ack bit is set.
+  void wait_ack(const char *timeout_msg)
+  {
+    poll([this]() {
+      return (csr(regs_.cmd) & regs_.ack) != 0;
+    }, timeout_msg);
+  }
+
+  // Write the ack bit back, then poll until the AFU reports it clear.
+  // Once past the spin budget, the write is repeated after each poll
+  // that still sees the bit set.
+  void clear_ack(const char *timeout_msg)
+  {
+    uint32_t polls = 0;
+    csr(regs_.cmd) = regs_.ack;
+    poll([this, &polls]() {
+      if (!(csr(regs_.cmd) & regs_.ack))
+        return true;
+      if (++polls > policy_.spin_polls)
+        csr(regs_.cmd) = regs_.ack;
+      return false;
+    }, timeout_msg);
+  }
+
+  template<typename Done>
+  void poll(Done done, const char *timeout_msg)
+  {
+    uint32_t spins = 0;
+    std::chrono::nanoseconds delay = policy_.min_sleep;
+    clock::time_point deadline;
+    bool have_deadline = false;
+
+    for (;;) {
+      ++stats_.polls;
+      if (done())
+        return;
+
+      if (spins < policy_.spin_polls) {
+        ++spins;
+        AFU_MBOX_PAUSE();
+        continue;
+      }
+
+      // The deadline is only needed once we start sleeping.
+      if (!have_deadline) {
+        deadline = clock::now() + policy_.timeout;
+        have_deadline = true;
+      } else if (clock::now() > deadline) {
+        throw std::runtime_error(timeout_msg);
+      }
+
+      ++stats_.sleeps;
+      std::this_thread::sleep_for(delay);
+      delay = std::min(delay * 2, policy_.max_sleep);
+    }
+  }
+
+  volatile uint8_t *base_;
+  mbox_regs regs_;
+  mbox_policy policy_;
+  uint64_t channel_;
+  bool channel_valid_;
+  std::map<std::pair<uint64_t, uint32_t>, uint32_t> cache_;
+  mbox_stats stats_;
+};
+
+} // end of namespace afu_test
+} // end of namespace opae
@@ -39,6 +39,8 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <opae/cxx/core.h>
 
+#include "afu_bench.h"
+
 const char *sbdf_pattern =
   "(([0-9a-fA-F]{4}):)?([0-9a-fA-F]{2}):([0-9a-fA-F]{2})\\.([0-9])";
 
@@ -202,6 +204,13 @@ public:
       check(CLI::IsMember(spdlog_levels()));
     app_.add_flag("-s,--shared", shared_, "open in shared mode, default is off");
     app_.add_option("-t,--timeout", timeout_msec_, "test timeout (msec)")->default_str(std::to_string(timeout_msec_));
+
+    auto &bopts = bench_.opts();
+    app_.add_flag("--bench", bopts.enabled, "repeat the command and report timing statistics");
+    app_.add_option("--bench-warmup", bopts.warmup, "untimed passes before measuring")->default_str(std::to_string(bopts.warmup));
+    app_.add_option("--bench-repeat", bopts.repeats, "timed passes")->default_str(std::to_string(bopts.repeats));
+    app_.add_option("--bench-cpu", bopts.cpu, "pin the test to this cpu");
+    app_.add_option("--bench-json", bopts.json, "write the benchmark report to this file");
   }
   virtual ~afu() {
   }
@@ -325,9 +334,61 @@ public:
       return res;
     }
 
+    if (bench_.enabled())
+      return run_bench(app, test);
+
     return run(app, test);
   }
 
+  int run_bench(CLI::App *app, command::ptr_t test)
+  {
+    auto props = afu_properties();
+    char sbdf[32];
+    snprintf(sbdf, sizeof(sbdf), "%04x:%02x:%02x.%x",
+             static_cast<uint16_t>(props->segment),
+             static_cast<uint8_t>(props->bus),
+             static_cast<uint8_t>(props->device),
+             static_cast<uint8_t>(props->function));
+
+    if (!bench_.setup(sbdf)) {
+      logger_->warn("running on cpu {0} (node {1}), but {2} is on node {3}",
+                    bench_.cpu(), bench_.cpu_node(), sbdf,
+                    bench_.device_node());
+    }
+
+    // Commands that time their own operations through bench() already
+    // warm up and repeat them, so they are only run once.
+    std::vector<uint64_t> ticks;
+    size_t measured = bench_.results().size();
+    uint32_t runs = bench_.warmup() + bench_.repeats();
+    int res = exit_codes::success;
+    for (uint32_t i = 0; i < runs; ++i) {
+      uint64_t t0 = bench_clock::start();
+      res = run(app, test);
+      uint64_t t1 = bench_clock::stop();
+      if (res != exit_codes::success)
+        return res;
+      if (i >= bench_.warmup() || bench_.results().size() > measured)
+        ticks.push_back(t1 - t0);
+      if (bench_.results().size() > measured)
+        break;
+    }
+
+    bench_.add(test->name(), ticks);
+    for (const auto &r : bench_.results())
+      logger_->info("{}", benchmark::format(r));
+
+    if (!bench_.opts().json.empty()) {
+      std::ofstream out(bench_.opts().json);
+      out << bench_.json(name_, test->name());
+      if (!out) {
+        logger_->error("could not write {0}", bench_.opts().json);
+        return exit_codes::error;
+      }
+    }
+    return res;
+  }
+
   virtual int run(CLI::App *app, command::ptr_t test)
   {
     int res = exit_codes::not_run;
@@ -393,6 +454,10 @@ public:
     return current_command_;
   }
 
+  benchmark & bench() {
+    return bench_;
+  }
+
 protected:
   std::string name_;
   std::string afu_id_;
@@ -405,6 +470,7 @@ protected:
   fpga::token::ptr_t token_device_;                 // Token for the DEVICE (FIM) resource
   command::ptr_t current_command_;
   std::map<CLI::App*, command::ptr_t> commands_;
+  benchmark bench_;
 public:
   std::shared_ptr<spdlog::logger> logger_;
 };
@@ -38,11 +38,13 @@
 #endif // __USE_GNU
 #include <pthread.h>
 
+#include "libopae-c/log-async.h"
 #include "mock/opae_std.h"
 
 static int log_level = OFS_DEFAULT_LOG_LEVEL;
 static FILE *log_file;
 static pthread_mutex_t log_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static struct log_async log_async;
 
 void ofs_print(int level, const char *fmt, ...)
 {
@@ -59,6 +61,13 @@ void ofs_print(int level, const char *fmt, ...)
 		fp = log_file ? log_file : stdout;
 
 	va_start(argp, fmt);
+
+	if (level != OFS_LOG_ERROR &&
+	    !log_async_vprint(&log_async, fp, fmt, argp)) {
+		va_end(argp);
+		return;
+	}
+
 	err = pthread_mutex_lock(&log_lock);
 	if (err)
 		fprintf(stderr, "ofs_print(): pthread_mutex_lock() failed: %s",
@@ -104,10 +113,23 @@ __attribute__((constructor)) STATIC void ofs_init(void)
 
 	if (!log_file)
 		log_file = stdout;
+
+	s = getenv("LIBOFS_LOG_ASYNC");
+	if ((log_level > OFS_LOG_ERROR) &&
+	    log_async_start(&log_async, log_async_mode_from_env(s)))
+		fprintf(stderr, "WARNING: could not start the asynchronous "
+			"logger. Logging synchronously.\n");
 }
 
 __attribute__((destructor)) STATIC void ofs_release(void)
 {
+	log_async_stop(&log_async);
+	if (log_async_dropped(&log_async))
+		fprintf(stderr, "WARNING: %lu libofs log messages "
+			"were dropped. Lower LIBOFS_LOG or unset "
+			"LIBOFS_LOG_ASYNC.\n",
+			(unsigned long)log_async_dropped(&log_async));
+
 	if (log_file && log_file != stdout)
 		opae_fclose(log_file);
 	log_file = NULL;
@@ -113,6 +113,11 @@ typedef struct _opae_api_adapter_table {
 	fpga_result (*fpgaUnpinBuffer)(fpga_handle handle, void *buf_addr,
 				       uint64_t len, uint64_t ioaddr);
 
+	// Internal method that sets *shared when a child handle sees
+	// its parent's DMA mappings, so that pinning on it is free.
+	fpga_result (*fpgaSharesParentMappings)(fpga_handle handle,
+						bool *shared);
+
 	// Internal method to extract details of a workspace.
 	fpga_result (*fpgaGetWSInfo)(fpga_handle handle, uint64_t wsid,
 				     uint64_t *ioaddr,
@@ -194,6 +199,15 @@ typedef struct _opae_api_adapter_table {
 	fpga_result (*fpgaObjectRead64)(fpga_object obj, uint64_t *value,
 					int flags);
 
+	fpga_result (*fpgaObjectReadv)(fpga_object obj,
+				       fpga_object_window *windows,
+				       size_t count, int flags);
+
+	fpga_result (*fpgaObjectReadGroup)(fpga_object group,
+					   fpga_object_value *values,
+					   size_t count, size_t *changed,
+					   int flags);
+
 	fpga_result (*fpgaObjectGetSize)(fpga_object obj, uint64_t *value,
 					 int flags);
 
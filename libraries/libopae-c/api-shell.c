@@ -41,6 +41,7 @@
 #include "opae_int.h"
 #include "props.h"
 #include "multi-port-afu.h"
+#include "telemetry-shm.h"
 #include "mock/opae_std.h"
 
 const char *
@@ -198,6 +199,7 @@ opae_allocate_wrapped_handle(opae_wrapped_token *wt, fpga_handle opae_handle,
 		whan->adapter_table = adapter;
 		whan->parent = NULL;
 		whan->child_next = NULL;
+		whan->telemetry = NULL;
 
 		opae_upref_wrapped_token(wt);
 	}
@@ -377,10 +379,13 @@ fpga_result __OPAE_API__ fpgaClose(fpga_handle handle)
 	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaClose,
 			       FPGA_NOT_SUPPORTED);
 
+	// Children may share the parent's IOMMU container,
+	// so close them first.
+	afu_close_children(wrapped_handle);
+
 	res = wrapped_handle->adapter_table->fpgaClose(
 		wrapped_handle->opae_handle);
 
-	afu_close_children(wrapped_handle);
 	opae_destroy_wrapped_handle(wrapped_handle);
 
 	return res;
@@ -1632,6 +1637,51 @@ fpga_result __OPAE_API__ fpgaObjectRead(fpga_object obj, uint8_t *buffer,
 		wrapped_object->opae_object, buffer, offset, len, flags);
 }
 
+fpga_result __OPAE_API__ fpgaObjectReadv(fpga_object obj,
+	fpga_object_window *windows, size_t count, int flags)
+{
+	opae_wrapped_object *wrapped_object = opae_validate_wrapped_object(obj);
+	fpga_result res = FPGA_OK;
+	size_t i;
+
+	ASSERT_NOT_NULL(wrapped_object);
+	ASSERT_NOT_NULL(windows);
+
+	if (wrapped_object->adapter_table->fpgaObjectReadv)
+		return wrapped_object->adapter_table->fpgaObjectReadv(
+			wrapped_object->opae_object, windows, count, flags);
+
+	// Plugins without a vectored read get one fpgaObjectRead per window.
+	ASSERT_NOT_NULL_RESULT(wrapped_object->adapter_table->fpgaObjectRead,
+			       FPGA_NOT_SUPPORTED);
+
+	for (i = 0 ; i < count ; ++i) {
+		res = wrapped_object->adapter_table->fpgaObjectRead(
+			wrapped_object->opae_object, windows[i].buffer,
+			windows[i].offset, windows[i].len, flags);
+		if (res != FPGA_OK)
+			break;
+	}
+
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaObjectReadGroup(fpga_object group,
+	fpga_object_value *values, size_t count, size_t *changed, int flags)
+{
+	opae_wrapped_object *wrapped_object =
+		opae_validate_wrapped_object(group);
+
+	ASSERT_NOT_NULL(wrapped_object);
+	ASSERT_NOT_NULL(values);
+	ASSERT_NOT_NULL_RESULT(
+		wrapped_object->adapter_table->fpgaObjectReadGroup,
+		FPGA_NOT_SUPPORTED);
+
+	return wrapped_object->adapter_table->fpgaObjectReadGroup(
+		wrapped_object->opae_object, values, count, changed, flags);
+}
+
 fpga_result __OPAE_API__ fpgaObjectGetSize(fpga_object obj, uint64_t *value,
 					   int flags)
 {
@@ -1750,6 +1800,42 @@ fpga_result __OPAE_API__ fpgaGetMetricsInfo(fpga_handle handle,
 		wrapped_handle->opae_handle, metric_info, num_metrics);
 }
 
+// Serve device metrics from the segment published by fpgad,
+// when there is a current one. Returns 0 on success.
+STATIC int opae_read_telemetry(opae_wrapped_handle *wrapped_handle,
+			       uint64_t *metric_num,
+			       uint64_t num_metric_indexes,
+			       fpga_metric *metrics)
+{
+	struct telemetry_reader *r;
+	fpga_token_header *hdr;
+
+	if (!metric_num)
+		return 1;
+
+	r = __atomic_load_n(&wrapped_handle->telemetry, __ATOMIC_ACQUIRE);
+	if (!r) {
+		hdr = (fpga_token_header *)
+			wrapped_handle->wrapped_token->opae_token;
+
+		// fpgad publishes the metrics of DFL FME devices.
+		if ((hdr->objtype != FPGA_DEVICE) ||
+		    (hdr->interface != FPGA_IFC_DFL))
+			return 1;
+
+		r = telemetry_reader_get(hdr->segment, hdr->bus,
+					 hdr->device, hdr->function);
+		if (!r)
+			return 1;
+
+		__atomic_store_n(&wrapped_handle->telemetry, r,
+				 __ATOMIC_RELEASE);
+	}
+
+	return telemetry_reader_read(r, metric_num,
+				     num_metric_indexes, metrics);
+}
+
 fpga_result __OPAE_API__ fpgaGetMetricsByIndex(fpga_handle handle,
 				uint64_t *metric_num,
 				uint64_t num_metric_indexes,
@@ -1762,6 +1848,10 @@ fpga_result __OPAE_API__ fpgaGetMetricsByIndex(fpga_handle handle,
 	ASSERT_NOT_NULL(num_metric_indexes);
 	ASSERT_NOT_NULL(metrics);
 
+	if (!opae_read_telemetry(wrapped_handle, metric_num,
+				 num_metric_indexes, metrics))
+		return FPGA_OK;
+
 	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaGetMetricsByIndex,
 			   FPGA_NOT_SUPPORTED);
 
@@ -0,0 +1,444 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pwd.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <opae/log.h>
+#include "cfg-file.h"
+#include "mock/opae_std.h"
+
+#ifndef OPAE_VERSION
+#define OPAE_VERSION "unknown"
+#endif // OPAE_VERSION
+
+// A config file modified this recently (in seconds) isn't
+// cached, because a further change within the same mtime tick
+// that kept the size would go unnoticed.
+#define CFG_CACHE_MIN_AGE 2
+
+STATIC uint32_t cfg_cache_fnv1a32(const void *buf, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	uint32_t h = 0x811c9dc5;
+
+	while (len--) {
+		h ^= *p++;
+		h *= 0x01000193;
+	}
+
+	return h;
+}
+
+STATIC uint64_t cfg_cache_fnv1a64(const char *s)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (*s) {
+		h ^= (uint8_t)*s++;
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+STATIC int cfg_cache_dir(char *dir, size_t len)
+{
+	const char *env;
+	struct passwd *user_passwd;
+	int res;
+
+	env = getenv("LIBOPAE_CFGCACHE");
+	if (env) {
+		if (!*env || !strcmp(env, "0"))
+			return 1;
+		res = snprintf(dir, len, "%s", env);
+	} else {
+		env = getenv("XDG_CACHE_HOME");
+		if (env && *env) {
+			res = snprintf(dir, len, "%s/opae", env);
+		} else {
+			env = getenv("HOME");
+			if (!env) {
+				user_passwd = getpwuid(getuid());
+				if (user_passwd)
+					env = user_passwd->pw_dir;
+			}
+			if (!env)
+				return 2;
+			res = snprintf(dir, len, "%s/.cache/opae", env);
+		}
+	}
+
+	return (res < 0 || (size_t)res >= len) ? 3 : 0;
+}
+
+// mkdir -p for the cache directory, private to the user.
+STATIC int cfg_cache_mkdir(char *dir)
+{
+	char *p;
+
+	for (p = dir + 1 ; *p ; ++p) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(dir, 0700) && errno != EEXIST) {
+			*p = '/';
+			return 1;
+		}
+		*p = '/';
+	}
+
+	if (mkdir(dir, 0700) && errno != EEXIST)
+		return 2;
+
+	return 0;
+}
+
+int opae_cfg_cache_path(const char *cfgfile, char *path, size_t len)
+{
+	char dir[PATH_MAX];
+	int res;
+
+	if (cfg_cache_dir(dir, sizeof(dir)))
+		return 1;
+
+	res = snprintf(path, len, "%s/libopae-%016" PRIx64 ".cache",
+		       dir, cfg_cache_fnv1a64(cfgfile));
+
+	return (res < 0 || (size_t)res >= len) ? 2 : 0;
+}
+
+STATIC void cfg_cache_key(opae_cfg_cache_header *hdr,
+			  const struct stat *st)
+{
+	hdr->magic = OPAE_CFG_CACHE_MAGIC;
+	hdr->version = OPAE_CFG_CACHE_VERSION;
+	hdr->header_size = sizeof(opae_cfg_cache_header);
+	strncpy(hdr->lib_version, OPAE_VERSION,
+		sizeof(hdr->lib_version) - 1);
+	hdr->cfg_dev = (uint64_t)st->st_dev;
+	hdr->cfg_ino = (uint64_t)st->st_ino;
+	hdr->cfg_size = (uint64_t)st->st_size;
+	hdr->cfg_mtime_sec = (int64_t)st->st_mtim.tv_sec;
+	hdr->cfg_mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+}
+
+// Validate everything but the path, which is checked by the caller.
+STATIC const char *cfg_cache_validate(const opae_cfg_cache_header *hdr,
+				      size_t size,
+				      const struct stat *st)
+{
+	opae_cfg_cache_header key;
+	const opae_cfg_cache_entry *e;
+	const char *pool;
+	uint32_t i;
+
+	memset(&key, 0, sizeof(key));
+	cfg_cache_key(&key, st);
+
+	if (hdr->magic != key.magic ||
+	    hdr->version != key.version ||
+	    hdr->header_size != key.header_size ||
+	    hdr->cache_size != size)
+		return "bad header";
+
+	if (memcmp(hdr->lib_version, key.lib_version,
+		   sizeof(key.lib_version)))
+		return "library version mismatch";
+
+	if (hdr->cfg_dev != key.cfg_dev ||
+	    hdr->cfg_ino != key.cfg_ino ||
+	    hdr->cfg_size != key.cfg_size ||
+	    hdr->cfg_mtime_sec != key.cfg_mtime_sec ||
+	    hdr->cfg_mtime_nsec != key.cfg_mtime_nsec)
+		return "stale";
+
+	if (!hdr->num_entries ||
+	    hdr->num_entries > size / sizeof(opae_cfg_cache_entry) ||
+	    !hdr->pool_size ||
+	    sizeof(*hdr) +
+	    hdr->num_entries * sizeof(opae_cfg_cache_entry) +
+	    hdr->pool_size != size)
+		return "bad size";
+
+	if (cfg_cache_fnv1a32(hdr + 1, size - sizeof(*hdr)) !=
+	    hdr->checksum)
+		return "bad checksum";
+
+	e = (const opae_cfg_cache_entry *)(hdr + 1);
+	pool = (const char *)(e + hdr->num_entries);
+
+	// Every string is terminated by the pool's final NUL.
+	if (pool[hdr->pool_size - 1])
+		return "bad string pool";
+
+	for (i = 0 ; i < hdr->num_entries ; ++i) {
+		if (e[i].module_library >= hdr->pool_size ||
+		    e[i].config_json >= hdr->pool_size)
+			return "bad string offset";
+	}
+
+	return NULL;
+}
+
+libopae_config_data *
+opae_cfg_cache_load(const char *cfgfile, const struct stat *st)
+{
+	char path[PATH_MAX];
+	struct stat cst;
+	int fd;
+	void *p;
+	size_t size;
+	const opae_cfg_cache_header *hdr;
+	const opae_cfg_cache_entry *e;
+	const char *pool;
+	const char *err;
+	libopae_config_data *cfg = NULL;
+	uint32_t i;
+
+	if (opae_cfg_cache_path(cfgfile, path, sizeof(path)))
+		return NULL;
+
+	fd = opae_open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	// The cache decides which plugins get loaded, so only trust
+	// a regular file that nobody else could have written.
+	if (fstat(fd, &cst) ||
+	    !S_ISREG(cst.st_mode) ||
+	    cst.st_uid != geteuid() ||
+	    (cst.st_mode & (S_IWGRP | S_IWOTH)) ||
+	    cst.st_size < (off_t)sizeof(opae_cfg_cache_header) ||
+	    cst.st_size > OPAE_CFG_CACHE_MAX_SIZE) {
+		OPAE_DBG("ignoring config cache %s", path);
+		opae_close(fd);
+		return NULL;
+	}
+
+	size = (size_t)cst.st_size;
+	p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	opae_close(fd);
+	if (p == MAP_FAILED) {
+		OPAE_DBG("mmap of config cache %s failed", path);
+		return NULL;
+	}
+
+	hdr = (const opae_cfg_cache_header *)p;
+	err = cfg_cache_validate(hdr, size, st);
+	if (err) {
+		OPAE_DBG("config cache %s: %s", path, err);
+		goto out_unmap;
+	}
+
+	e = (const opae_cfg_cache_entry *)(hdr + 1);
+	pool = (const char *)(e + hdr->num_entries);
+
+	if (strcmp(pool, cfgfile)) {
+		OPAE_DBG("config cache %s: path mismatch", path);
+		goto out_unmap;
+	}
+
+	cfg = opae_calloc(hdr->num_entries + 1, sizeof(libopae_config_data));
+	if (!cfg) {
+		OPAE_ERR("calloc() failed");
+		goto out_unmap;
+	}
+
+	for (i = 0 ; i < hdr->num_entries ; ++i) {
+		cfg[i].vendor_id = e[i].vendor_id;
+		cfg[i].device_id = e[i].device_id;
+		cfg[i].subsystem_vendor_id = e[i].subsystem_vendor_id;
+		cfg[i].subsystem_device_id = e[i].subsystem_device_id;
+		cfg[i].flags = e[i].flags;
+		cfg[i].module_library = opae_strdup(pool + e[i].module_library);
+		cfg[i].config_json = opae_strdup(pool + e[i].config_json);
+
+		if (!cfg[i].module_library || !cfg[i].config_json) {
+			OPAE_ERR("strdup() failed");
+			if (cfg[i].module_library)
+				opae_free((char *)cfg[i].module_library);
+			if (cfg[i].config_json)
+				opae_free((char *)cfg[i].config_json);
+			cfg[i].module_library = NULL;
+			opae_free_libopae_config(cfg);
+			cfg = NULL;
+			goto out_unmap;
+		}
+	}
+
+	OPAE_DBG("loaded config for %s from cache %s", cfgfile, path);
+
+out_unmap:
+	munmap(p, size);
+	return cfg;
+}
+
+int opae_cfg_cache_store(const char *cfgfile,
+			 const struct stat *st,
+			 const libopae_config_data *cfg)
+{
+	char dir[PATH_MAX];
+	char path[PATH_MAX];
+	char tmp[PATH_MAX + 8];
+	const libopae_config_data *c;
+	opae_cfg_cache_header *hdr;
+	opae_cfg_cache_entry *e;
+	char *pool;
+	size_t num_entries = 0;
+	size_t pool_size;
+	size_t size;
+	size_t len;
+	size_t off;
+	size_t written;
+	ssize_t n;
+	char *p;
+	int fd;
+	int res = 0;
+
+	if (st->st_mtime > time(NULL) - CFG_CACHE_MIN_AGE) {
+		OPAE_DBG("%s was modified too recently to cache", cfgfile);
+		return 1;
+	}
+
+	if (cfg_cache_dir(dir, sizeof(dir)) ||
+	    opae_cfg_cache_path(cfgfile, path, sizeof(path)))
+		return 2;
+
+	pool_size = strlen(cfgfile) + 1;
+	for (c = cfg ; c->module_library ; ++c) {
+		++num_entries;
+		pool_size += strlen(c->module_library) + 1;
+		pool_size += strlen(c->config_json ? c->config_json : "") + 1;
+	}
+
+	size = sizeof(*hdr) + num_entries * sizeof(*e) + pool_size;
+	if (!num_entries || size > OPAE_CFG_CACHE_MAX_SIZE)
+		return 3;
+
+	hdr = opae_calloc(1, size);
+	if (!hdr) {
+		OPAE_ERR("calloc() failed");
+		return 4;
+	}
+
+	cfg_cache_key(hdr, st);
+	hdr->cache_size = size;
+	hdr->num_entries = (uint32_t)num_entries;
+	hdr->pool_size = (uint32_t)pool_size;
+
+	e = (opae_cfg_cache_entry *)(hdr + 1);
+	pool = (char *)(e + num_entries);
+
+	len = strlen(cfgfile) + 1;
+	memcpy(pool, cfgfile, len);
+	off = len;
+
+	for (c = cfg ; c->module_library ; ++c, ++e) {
+		e->vendor_id = c->vendor_id;
+		e->device_id = c->device_id;
+		e->subsystem_vendor_id = c->subsystem_vendor_id;
+		e->subsystem_device_id = c->subsystem_device_id;
+		// Detection state belongs to the running process.
+		e->flags = c->flags &
+			~(OPAE_PLATFORM_DATA_DETECTED|OPAE_PLATFORM_DATA_LOADED);
+
+		len = strlen(c->module_library) + 1;
+		memcpy(pool + off, c->module_library, len);
+		e->module_library = (uint32_t)off;
+		off += len;
+
+		p = (char *)(c->config_json ? c->config_json : "");
+		len = strlen(p) + 1;
+		memcpy(pool + off, p, len);
+		e->config_json = (uint32_t)off;
+		off += len;
+	}
+
+	hdr->checksum = cfg_cache_fnv1a32(hdr + 1, size - sizeof(*hdr));
+
+	if (cfg_cache_mkdir(dir)) {
+		OPAE_DBG("can't create config cache dir %s", dir);
+		res = 5;
+		goto out_free;
+	}
+
+	// Write a private temporary file and rename it into place,
+	// so that readers see either the old or the new cache.
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		OPAE_DBG("can't create config cache %s", tmp);
+		res = 6;
+		goto out_free;
+	}
+
+	for (written = 0 ; written < size ; written += (size_t)n) {
+		n = write(fd, (char *)hdr + written, size - written);
+		if (n < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			break;
+		}
+	}
+
+	if (opae_close(fd) || written < size) {
+		OPAE_DBG("error writing config cache %s", tmp);
+		unlink(tmp);
+		res = 7;
+		goto out_free;
+	}
+
+	if (rename(tmp, path)) {
+		OPAE_DBG("can't rename config cache to %s", path);
+		unlink(tmp);
+		res = 8;
+		goto out_free;
+	}
+
+	OPAE_DBG("cached config for %s in %s", cfgfile, path);
+
+out_free:
+	opae_free(hdr);
+	return res;
+}
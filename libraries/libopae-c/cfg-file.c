@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <pwd.h>
+#include <sys/stat.h>
 #include <linux/limits.h>
 #include <opae/log.h>
 #include "opae_int.h"
@@ -338,6 +339,28 @@ opae_parse_libopae_config(const char *cfgfile, const char *json_input)
 	return c ? c : default_libopae_config_table;
 }
 
+libopae_config_data *
+opae_load_libopae_config(const char *cfgfile)
+{
+	libopae_config_data *c;
+	struct stat st;
+
+	if (!cfgfile || opae_stat(cfgfile, &st))
+		return default_libopae_config_table;
+
+	c = opae_cfg_cache_load(cfgfile, &st);
+	if (c)
+		return c;
+
+	c = opae_parse_libopae_config(cfgfile,
+				      opae_read_cfg_file(cfgfile));
+
+	if (c != default_libopae_config_table)
+		opae_cfg_cache_store(cfgfile, &st, c);
+
+	return c;
+}
+
 void opae_print_libopae_config(libopae_config_data *cfg)
 {
 #ifndef LIBOPAE_DEBUG
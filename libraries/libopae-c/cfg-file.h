@@ -87,6 +87,85 @@ void opae_print_libopae_config(libopae_config_data *cfg);
 
 void opae_free_libopae_config(libopae_config_data *cfg);
 
+// Find, read and parse the libopae configuration from cfgfile,
+// or return the default table when cfgfile is NULL or can't be
+// parsed. The parsed table is kept in a binary cache so that
+// later calls only map the cache instead of parsing the JSON.
+// Free the result with opae_free_libopae_config().
+libopae_config_data *
+opae_load_libopae_config(const char *cfgfile);
+
+
+// Parsed libopae configuration cache.
+//
+// The cache for a config file lives in $LIBOPAE_CFGCACHE, else
+// $XDG_CACHE_HOME/opae, else $HOME/.cache/opae, and is named by
+// a hash of the canonical config file path. LIBOPAE_CFGCACHE=0
+// disables the cache.
+//
+// The cache is used only while the config file's path, device,
+// inode, size and mtime and the library version all match the
+// values recorded when it was written. Any mismatch, including
+// a cache that isn't owned by the current user, falls back to
+// parsing the JSON and rewriting the cache.
+//
+// Layout: the header, num_entries entries and a string pool.
+// The pool begins with the config file path, and the entries
+// refer to their strings by pool offset.
+
+//                           O P A E C F G 1
+#define OPAE_CFG_CACHE_MAGIC 0x314746434541504fULL
+#define OPAE_CFG_CACHE_VERSION 1
+#define OPAE_CFG_CACHE_LIBVER_LEN 32
+#define OPAE_CFG_CACHE_MAX_SIZE (1024 * 1024)
+
+typedef struct _opae_cfg_cache_entry {
+	uint16_t vendor_id;
+	uint16_t device_id;
+	uint16_t subsystem_vendor_id;
+	uint16_t subsystem_device_id;
+	uint32_t flags;
+	uint32_t module_library; // pool offset
+	uint32_t config_json;    // pool offset
+	uint32_t reserved;
+} opae_cfg_cache_entry;
+
+typedef struct _opae_cfg_cache_header {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t header_size; // sizeof(opae_cfg_cache_header)
+	uint64_t cache_size;  // size of the whole cache file
+	char lib_version[OPAE_CFG_CACHE_LIBVER_LEN];
+	uint64_t cfg_dev;
+	uint64_t cfg_ino;
+	uint64_t cfg_size;
+	int64_t cfg_mtime_sec;
+	int64_t cfg_mtime_nsec;
+	uint32_t num_entries;
+	uint32_t pool_size;
+	uint32_t checksum;    // FNV-1a of the entries and the pool
+	uint32_t reserved;
+} opae_cfg_cache_header;
+
+struct stat;
+
+// Format the cache file path for cfgfile into path.
+// Returns 0 on success, or non-zero when the cache is
+// disabled or no cache directory can be determined.
+int opae_cfg_cache_path(const char *cfgfile, char *path, size_t len);
+
+// Returns a newly-allocated table built from the cache for
+// cfgfile, whose stat() result is st, or NULL if there is no
+// valid and current cache.
+libopae_config_data *
+opae_cfg_cache_load(const char *cfgfile, const struct stat *st);
+
+// Write cfg to the cache for cfgfile, replacing any existing
+// cache atomically. Returns 0 on success.
+int opae_cfg_cache_store(const char *cfgfile,
+			 const struct stat *st,
+			 const libopae_config_data *cfg);
+
 
 #define OPAE_FEATURE_ID_ANY -1
 typedef struct _fpgainfo_config_data {
@@ -45,6 +45,8 @@
 #include <opae/utils.h>
 #include "pluginmgr.h"
 #include "opae_int.h"
+#include "log-async.h"
+#include "telemetry-shm.h"
 #include "mock/opae_std.h"
 
 /* global loglevel */
@@ -52,6 +54,8 @@ static int g_loglevel = OPAE_DEFAULT_LOGLEVEL;
 static FILE *g_logfile;
 /* mutex to protect against garbled log output */
 static pthread_mutex_t log_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+/* asynchronous backend, enabled by LIBOPAE_LOG_ASYNC */
+static struct log_async g_log_async;
 
 #define CFG_PATH_MAX 64
 #define HOME_CFG_PATHS 3
@@ -83,6 +87,14 @@ void opae_print(int loglevel, const char *fmt, ...)
 		fp = g_logfile == NULL ? stdout : g_logfile;
 
 	va_start(argp, fmt);
+
+	/* Errors stay synchronous so that they are never lost. */
+	if (loglevel != OPAE_LOG_ERROR &&
+	    !log_async_vprint(&g_log_async, fp, fmt, argp)) {
+		va_end(argp);
+		return;
+	}
+
 	err = pthread_mutex_lock(
 		&log_lock); /* ignore failure and print anyway */
 	if (err)
@@ -215,6 +227,14 @@ __attribute__((constructor(1000))) STATIC void opae_init(void)
 	if (g_logfile == NULL)
 		g_logfile = stdout;
 
+	/* Errors are always synchronous, so only start the
+	   writer thread when there is something for it to do. */
+	s = getenv("LIBOPAE_LOG_ASYNC");
+	if ((g_loglevel > OPAE_LOG_ERROR) &&
+	    log_async_start(&g_log_async, log_async_mode_from_env(s)))
+		fprintf(stderr, "WARNING: could not start the asynchronous "
+			"logger. Logging synchronously.\n");
+
 	with_ase = getenv("WITH_ASE");
 	if (with_ase) {
 		cfg_path = find_ase_cfg();
@@ -246,6 +266,15 @@ __attribute__((destructor)) STATIC void opae_release(void)
 	if (res != FPGA_OK)
 		OPAE_ERR("fpgaFinalize: %s", fpgaErrStr(res));
 
+	telemetry_reader_release_all();
+
+	log_async_stop(&g_log_async);
+	if (log_async_dropped(&g_log_async))
+		fprintf(stderr, "WARNING: %lu libopae-c log messages "
+			"were dropped. Lower LIBOPAE_LOG or unset "
+			"LIBOPAE_LOG_ASYNC.\n",
+			(unsigned long)log_async_dropped(&g_log_async));
+
 	if (g_logfile != NULL && g_logfile != stdout) {
 		opae_fclose(g_logfile);
 	}
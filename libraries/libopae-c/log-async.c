@@ -0,0 +1,806 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include "log-async.h"
+#include "mock/opae_std.h"
+
+#define LOG_RING_SIZE  (64 * 1024)
+#define LOG_MAX_RECORD 4096
+#define LOG_SPEC_MAX   32
+#define LOG_MAX_STREAMS 4
+#define LOG_IDLE_NSEC  1000000L
+#define LOG_ALIGN(__x) (((__x) + 7) & ~((uint64_t)7))
+
+enum log_record_kind {
+	LOG_RECORD_PAD = 0,
+	LOG_RECORD_TEXT,
+	LOG_RECORD_BINARY
+};
+
+struct log_record {
+	uint32_t size; // including this header, a multiple of 8
+	uint32_t kind;
+	FILE *fp;
+};
+
+// A single-producer single-consumer byte ring. head is
+// written only by the owning thread, tail only by the
+// thread holding the drain lock. They are kept on separate
+// cache lines so that the two sides don't contend.
+struct log_ring {
+	uint64_t head;
+	uint8_t pad0[56];
+	uint64_t tail;
+	uint8_t pad1[56];
+	int orphaned;
+	struct log_ring *next;
+	uint8_t buf[LOG_RING_SIZE];
+};
+
+enum log_length {
+	LOG_LEN_NONE = 0,
+	LOG_LEN_HH,
+	LOG_LEN_H,
+	LOG_LEN_L,
+	LOG_LEN_LL,
+	LOG_LEN_J,
+	LOG_LEN_Z,
+	LOG_LEN_T
+};
+
+struct log_spec {
+	size_t len; // characters in the spec, including '%'
+	char conv;
+	int length;
+};
+
+static struct log_async *log_async_instances;
+static pthread_mutex_t log_async_instances_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_async_atfork_once = PTHREAD_ONCE_INIT;
+
+// Parse the conversion spec at p, which points to a '%'.
+// Returns 0 if the spec can be binary-encoded, else -1.
+STATIC int log_spec_parse(const char *p, struct log_spec *spec)
+{
+	const char *q = p + 1;
+
+	spec->length = LOG_LEN_NONE;
+
+	if (*q == '%') {
+		spec->len = 2;
+		spec->conv = '%';
+		return 0;
+	}
+
+	while (*q && strchr("-+ #0'", *q))
+		++q;
+	if (*q == '*')
+		return -1;
+	while (isdigit((unsigned char)*q))
+		++q;
+	if (*q == '.') {
+		++q;
+		if (*q == '*')
+			return -1;
+		while (isdigit((unsigned char)*q))
+			++q;
+	}
+
+	switch (*q) {
+	case 'h':
+		++q;
+		spec->length = LOG_LEN_H;
+		if (*q == 'h') {
+			++q;
+			spec->length = LOG_LEN_HH;
+		}
+		break;
+	case 'l':
+		++q;
+		spec->length = LOG_LEN_L;
+		if (*q == 'l') {
+			++q;
+			spec->length = LOG_LEN_LL;
+		}
+		break;
+	case 'q':
+		++q;
+		spec->length = LOG_LEN_LL;
+		break;
+	case 'j':
+		++q;
+		spec->length = LOG_LEN_J;
+		break;
+	case 'z':
+		++q;
+		spec->length = LOG_LEN_Z;
+		break;
+	case 't':
+		++q;
+		spec->length = LOG_LEN_T;
+		break;
+	}
+
+	spec->conv = *q;
+	spec->len = (size_t)(q + 1 - p);
+	if (spec->len >= LOG_SPEC_MAX)
+		return -1;
+
+	switch (spec->conv) {
+	case 'd': case 'i':
+	case 'u': case 'x': case 'X': case 'o':
+		return 0;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+		return (spec->length == LOG_LEN_NONE ||
+			spec->length == LOG_LEN_L) ? 0 : -1;
+	case 'c': case 's': case 'p':
+		return spec->length == LOG_LEN_NONE ? 0 : -1;
+	}
+
+	// %n, %m, %C, %S, positional arguments, long double, ..
+	return -1;
+}
+
+STATIC int log_put(uint8_t *buf, size_t cap, size_t *offset,
+		   const void *src, size_t len)
+{
+	if (*offset + LOG_ALIGN(len) > cap)
+		return -1;
+	memcpy(buf + *offset, src, len);
+	*offset += LOG_ALIGN(len);
+	return 0;
+}
+
+STATIC int log_put_string(uint8_t *buf, size_t cap, size_t *offset,
+			  const char *s)
+{
+	uint64_t len = s ? strlen(s) + 1 : UINT64_MAX;
+
+	if (log_put(buf, cap, offset, &len, sizeof(len)))
+		return -1;
+	return s ? log_put(buf, cap, offset, s, len) : 0;
+}
+
+// Encode fmt and the arguments it consumes from ap into buf:
+// the format string followed by one 8-byte slot per argument,
+// strings being stored inline after their length.
+// Returns the encoded size, or -1 if fmt can't be encoded.
+STATIC int log_encode(uint8_t *buf, size_t cap,
+		      const char *fmt, va_list ap)
+{
+	size_t offset = 0;
+	const char *p;
+	struct log_spec spec;
+	uint64_t v;
+	double d;
+	const char *s;
+
+	if (log_put_string(buf, cap, &offset, fmt))
+		return -1;
+
+	for (p = strchr(fmt, '%') ; p ; p = strchr(p + spec.len, '%')) {
+		if (log_spec_parse(p, &spec))
+			return -1;
+
+		switch (spec.conv) {
+		case '%':
+			continue;
+		case 'd':
+		case 'i':
+			switch (spec.length) {
+			case LOG_LEN_L:
+				v = (uint64_t)va_arg(ap, long);
+				break;
+			case LOG_LEN_LL:
+				v = (uint64_t)va_arg(ap, long long);
+				break;
+			case LOG_LEN_J:
+				v = (uint64_t)va_arg(ap, intmax_t);
+				break;
+			case LOG_LEN_Z:
+				v = (uint64_t)va_arg(ap, ssize_t);
+				break;
+			case LOG_LEN_T:
+				v = (uint64_t)va_arg(ap, ptrdiff_t);
+				break;
+			default:
+				v = (uint64_t)va_arg(ap, int);
+				break;
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			switch (spec.length) {
+			case LOG_LEN_L:
+				v = va_arg(ap, unsigned long);
+				break;
+			case LOG_LEN_LL:
+				v = va_arg(ap, unsigned long long);
+				break;
+			case LOG_LEN_J:
+				v = va_arg(ap, uintmax_t);
+				break;
+			case LOG_LEN_Z:
+				v = va_arg(ap, size_t);
+				break;
+			case LOG_LEN_T:
+				v = (uint64_t)va_arg(ap, ptrdiff_t);
+				break;
+			default:
+				v = va_arg(ap, unsigned int);
+				break;
+			}
+			break;
+		case 'c':
+			v = (uint64_t)va_arg(ap, int);
+			break;
+		case 'p':
+			v = (uint64_t)(uintptr_t)va_arg(ap, void *);
+			break;
+		case 's':
+			s = va_arg(ap, const char *);
+			if (log_put_string(buf, cap, &offset, s))
+				return -1;
+			continue;
+		default: // floating point
+			d = va_arg(ap, double);
+			memcpy(&v, &d, sizeof(v));
+			break;
+		}
+
+		if (log_put(buf, cap, &offset, &v, sizeof(v)))
+			return -1;
+	}
+
+	return (int)offset;
+}
+
+STATIC const uint8_t *log_get_string(const uint8_t *p, const char **s)
+{
+	uint64_t len;
+
+	memcpy(&len, p, sizeof(len));
+	p += sizeof(len);
+	if (len == UINT64_MAX) {
+		*s = NULL;
+		return p;
+	}
+	*s = (const char *)p;
+	return p + LOG_ALIGN(len);
+}
+
+// Format a record produced by log_encode() to fp.
+STATIC void log_render(FILE *fp, const uint8_t *p)
+{
+	const char *fmt;
+	const char *pct;
+	const char *s;
+	struct log_spec spec;
+	char sbuf[LOG_SPEC_MAX];
+	uint64_t v;
+	double d;
+
+	p = log_get_string(p, &fmt);
+
+	while (*fmt) {
+		pct = strchr(fmt, '%');
+		if (!pct) {
+			fputs(fmt, fp);
+			break;
+		}
+		fwrite(fmt, 1, (size_t)(pct - fmt), fp);
+
+		log_spec_parse(pct, &spec);
+		fmt = pct + spec.len;
+
+		if (spec.conv == '%') {
+			fputc('%', fp);
+			continue;
+		}
+
+		memcpy(sbuf, pct, spec.len);
+		sbuf[spec.len] = '\0';
+
+		if (spec.conv == 's') {
+			p = log_get_string(p, &s);
+			fprintf(fp, sbuf, s);
+			continue;
+		}
+
+		memcpy(&v, p, sizeof(v));
+		p += sizeof(v);
+
+		switch (spec.conv) {
+		case 'd':
+		case 'i':
+			switch (spec.length) {
+			case LOG_LEN_L:
+				fprintf(fp, sbuf, (long)v);
+				break;
+			case LOG_LEN_LL:
+				fprintf(fp, sbuf, (long long)v);
+				break;
+			case LOG_LEN_J:
+				fprintf(fp, sbuf, (intmax_t)v);
+				break;
+			case LOG_LEN_Z:
+				fprintf(fp, sbuf, (ssize_t)v);
+				break;
+			case LOG_LEN_T:
+				fprintf(fp, sbuf, (ptrdiff_t)v);
+				break;
+			default:
+				fprintf(fp, sbuf, (int)v);
+				break;
+			}
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+			switch (spec.length) {
+			case LOG_LEN_L:
+				fprintf(fp, sbuf, (unsigned long)v);
+				break;
+			case LOG_LEN_LL:
+				fprintf(fp, sbuf, (unsigned long long)v);
+				break;
+			case LOG_LEN_J:
+				fprintf(fp, sbuf, (uintmax_t)v);
+				break;
+			case LOG_LEN_Z:
+				fprintf(fp, sbuf, (size_t)v);
+				break;
+			case LOG_LEN_T:
+				fprintf(fp, sbuf, (ptrdiff_t)v);
+				break;
+			default:
+				fprintf(fp, sbuf, (unsigned int)v);
+				break;
+			}
+			break;
+		case 'c':
+			fprintf(fp, sbuf, (int)v);
+			break;
+		case 'p':
+			fprintf(fp, sbuf, (void *)(uintptr_t)v);
+			break;
+		default: // floating point
+			memcpy(&d, &v, sizeof(d));
+			fprintf(fp, sbuf, d);
+			break;
+		}
+	}
+}
+
+STATIC int log_ring_push(struct log_ring *r, FILE *fp, uint32_t kind,
+			 const void *payload, size_t len)
+{
+	struct log_record rec;
+	uint64_t head = r->head;
+	uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+	uint64_t pos = head % LOG_RING_SIZE;
+	uint64_t pad = 0;
+
+	rec.size = (uint32_t)LOG_ALIGN(sizeof(rec) + len);
+	rec.kind = kind;
+	rec.fp = fp;
+
+	// Records are contiguous. Skip to the start of the
+	// ring when this one would wrap.
+	if (pos + rec.size > LOG_RING_SIZE)
+		pad = LOG_RING_SIZE - pos;
+
+	if (head + pad + rec.size - tail > LOG_RING_SIZE)
+		return -1;
+
+	if (pad) {
+		if (pad >= sizeof(rec)) {
+			struct log_record skip = {
+				(uint32_t)pad, LOG_RECORD_PAD, NULL
+			};
+			memcpy(r->buf + pos, &skip, sizeof(skip));
+		}
+		head += pad;
+		pos = 0;
+	}
+
+	memcpy(r->buf + pos, &rec, sizeof(rec));
+	memcpy(r->buf + pos + sizeof(rec), payload, len);
+
+	__atomic_store_n(&r->head, head + rec.size, __ATOMIC_RELEASE);
+	return 0;
+}
+
+STATIC size_t log_ring_drain(struct log_ring *r,
+			     FILE *streams[LOG_MAX_STREAMS])
+{
+	uint64_t tail = r->tail;
+	uint64_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	struct log_record *rec;
+	uint64_t pos;
+	size_t count = 0;
+	int i;
+
+	while (tail != head) {
+		pos = tail % LOG_RING_SIZE;
+		if (LOG_RING_SIZE - pos < sizeof(*rec)) {
+			tail += LOG_RING_SIZE - pos;
+			continue;
+		}
+
+		rec = (struct log_record *)(r->buf + pos);
+		if (rec->kind == LOG_RECORD_TEXT)
+			fputs((const char *)(rec + 1), rec->fp);
+		else if (rec->kind == LOG_RECORD_BINARY)
+			log_render(rec->fp, (const uint8_t *)(rec + 1));
+
+		if (rec->kind != LOG_RECORD_PAD) {
+			for (i = 0 ; i < LOG_MAX_STREAMS ; ++i) {
+				if (!streams[i])
+					streams[i] = rec->fp;
+				if (streams[i] == rec->fp)
+					break;
+			}
+			if (i == LOG_MAX_STREAMS)
+				fflush(rec->fp);
+			++count;
+		}
+
+		tail += rec->size;
+	}
+
+	__atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+	return count;
+}
+
+// Drain every ring, freeing those whose thread has exited.
+STATIC size_t log_async_drain(struct log_async *b)
+{
+	FILE *streams[LOG_MAX_STREAMS] = { NULL, };
+	struct log_ring *r;
+	struct log_ring *next;
+	struct log_ring **prev;
+	size_t count = 0;
+	int orphaned;
+	int i;
+
+	pthread_mutex_lock(&b->drain_lock);
+
+	// New rings are only ever added at the head of the list,
+	// and only the drainer removes them, so the list can be
+	// walked without holding b->lock.
+	pthread_mutex_lock(&b->lock);
+	r = b->rings;
+	pthread_mutex_unlock(&b->lock);
+
+	for ( ; r ; r = next) {
+		next = r->next;
+		orphaned = __atomic_load_n(&r->orphaned, __ATOMIC_ACQUIRE);
+
+		count += log_ring_drain(r, streams);
+
+		if (orphaned) {
+			// The owner is gone, so nothing was pushed
+			// after the drain above.
+			pthread_mutex_lock(&b->lock);
+			for (prev = &b->rings ; *prev != r ; prev = &(*prev)->next)
+				;
+			*prev = next;
+			pthread_mutex_unlock(&b->lock);
+			opae_free(r);
+		}
+	}
+
+	for (i = 0 ; i < LOG_MAX_STREAMS && streams[i] ; ++i)
+		fflush(streams[i]);
+
+	pthread_mutex_unlock(&b->drain_lock);
+	return count;
+}
+
+// Count the calling thread as using b's rings, and return the
+// mode it sees. log_async_stop() sets the mode to SYNC before it
+// waits for the count to drop to zero, so a caller that sees any
+// other mode can use the rings until log_async_leave(). Both sides
+// use sequentially consistent accesses, so that the stop can't
+// miss a caller that still sees the old mode.
+STATIC int log_async_enter(struct log_async *b)
+{
+	int mode;
+
+	__atomic_add_fetch(&b->callers, 1, __ATOMIC_SEQ_CST);
+	mode = __atomic_load_n(&b->mode, __ATOMIC_SEQ_CST);
+	if (mode == LOG_ASYNC_SYNC)
+		__atomic_sub_fetch(&b->callers, 1, __ATOMIC_RELEASE);
+	return mode;
+}
+
+STATIC void log_async_leave(struct log_async *b)
+{
+	__atomic_sub_fetch(&b->callers, 1, __ATOMIC_RELEASE);
+}
+
+// Runs when the owning thread exits. log_async_stop() may have
+// freed the ring already, so it is only touched once found among
+// the rings of a backend that hasn't begun to stop.
+STATIC void log_ring_release(void *ring)
+{
+	struct log_async *b;
+	struct log_ring *r = NULL;
+
+	pthread_mutex_lock(&log_async_instances_lock);
+	for (b = log_async_instances ; b && !r ; b = b->next) {
+		if (log_async_enter(b) == LOG_ASYNC_SYNC)
+			continue;
+
+		pthread_mutex_lock(&b->lock);
+		for (r = b->rings ; r && r != ring ; r = r->next)
+			;
+		pthread_mutex_unlock(&b->lock);
+
+		if (r)
+			__atomic_store_n(&r->orphaned, 1, __ATOMIC_RELEASE);
+		log_async_leave(b);
+	}
+	pthread_mutex_unlock(&log_async_instances_lock);
+}
+
+STATIC struct log_ring *log_ring_get(struct log_async *b)
+{
+	struct log_ring *r = pthread_getspecific(b->key);
+
+	if (r)
+		return r;
+
+	r = opae_calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	if (pthread_setspecific(b->key, r)) {
+		opae_free(r);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&b->lock);
+	r->next = b->rings;
+	b->rings = r;
+	pthread_mutex_unlock(&b->lock);
+
+	return r;
+}
+
+STATIC void *log_async_writer(void *arg)
+{
+	struct log_async *b = (struct log_async *)arg;
+	struct timespec idle = { 0, LOG_IDLE_NSEC };
+
+	while (__atomic_load_n(&b->running, __ATOMIC_ACQUIRE)) {
+		if (!log_async_drain(b))
+			nanosleep(&idle, NULL);
+	}
+
+	return NULL;
+}
+
+// The writer thread doesn't survive fork(), so a child
+// falls back to synchronous logging. Its copies of the
+// rings hold only messages that the parent will write.
+STATIC void log_async_atfork_child(void)
+{
+	struct log_async *b;
+
+	for (b = log_async_instances ; b ; b = b->next) {
+		__atomic_store_n(&b->mode, LOG_ASYNC_SYNC, __ATOMIC_RELEASE);
+		b->running = 0;
+		// The callers counted belong to threads the child lacks.
+		b->callers = 0;
+	}
+	pthread_mutex_init(&log_async_instances_lock, NULL);
+}
+
+STATIC void log_async_atfork_init(void)
+{
+	pthread_atfork(NULL, NULL, log_async_atfork_child);
+}
+
+int log_async_mode_from_env(const char *s)
+{
+	if (!s || !*s || !strcmp(s, "0"))
+		return LOG_ASYNC_SYNC;
+	if (!strcmp(s, "binary"))
+		return LOG_ASYNC_BINARY;
+	return LOG_ASYNC_TEXT;
+}
+
+int log_async_start(struct log_async *b, int mode)
+{
+	sigset_t all;
+	sigset_t saved;
+	int res;
+
+	if (mode != LOG_ASYNC_TEXT && mode != LOG_ASYNC_BINARY)
+		return mode == LOG_ASYNC_SYNC ? 0 : -1;
+
+	if (b->mode != LOG_ASYNC_SYNC)
+		return 0;
+
+	if (pthread_key_create(&b->key, log_ring_release))
+		return -1;
+
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_mutex_init(&b->drain_lock, NULL);
+	b->rings = NULL;
+	b->dropped = 0;
+	b->callers = 0;
+	b->running = 1;
+
+	// Leave signal delivery to the application's threads.
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &saved);
+	res = pthread_create(&b->writer, NULL, log_async_writer, b);
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+	if (res) {
+		b->running = 0;
+		pthread_mutex_destroy(&b->drain_lock);
+		pthread_mutex_destroy(&b->lock);
+		pthread_key_delete(b->key);
+		return -1;
+	}
+
+	pthread_once(&log_async_atfork_once, log_async_atfork_init);
+
+	pthread_mutex_lock(&log_async_instances_lock);
+	b->next = log_async_instances;
+	log_async_instances = b;
+	pthread_mutex_unlock(&log_async_instances_lock);
+
+	__atomic_store_n(&b->mode, mode, __ATOMIC_RELEASE);
+	return 0;
+}
+
+STATIC int log_async_queue(struct log_async *b, int mode, FILE *fp,
+			   const char *fmt, va_list ap)
+{
+	uint64_t payload[LOG_MAX_RECORD / sizeof(uint64_t)];
+	uint32_t kind = LOG_RECORD_BINARY;
+	struct log_ring *r;
+	va_list aq;
+	int len = -1;
+
+	r = log_ring_get(b);
+	if (!r)
+		return 1;
+
+	if (mode == LOG_ASYNC_BINARY) {
+		va_copy(aq, ap);
+		len = log_encode((uint8_t *)payload, sizeof(payload), fmt, aq);
+		va_end(aq);
+	}
+
+	if (len < 0) {
+		kind = LOG_RECORD_TEXT;
+		va_copy(aq, ap);
+		len = vsnprintf((char *)payload, sizeof(payload), fmt, aq);
+		va_end(aq);
+		// Too long to queue: let the caller print it.
+		if (len < 0 || (size_t)len >= sizeof(payload))
+			return 1;
+		++len;
+	}
+
+	if (log_ring_push(r, fp, kind, payload, (size_t)len))
+		__atomic_add_fetch(&b->dropped, 1, __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+int log_async_vprint(struct log_async *b, FILE *fp,
+		     const char *fmt, va_list ap)
+{
+	int mode = log_async_enter(b);
+	int res;
+
+	if (mode == LOG_ASYNC_SYNC)
+		return 1;
+
+	res = log_async_queue(b, mode, fp, fmt, ap);
+	log_async_leave(b);
+	return res;
+}
+
+void log_async_flush(struct log_async *b)
+{
+	if (log_async_enter(b) == LOG_ASYNC_SYNC)
+		return;
+	log_async_drain(b);
+	log_async_leave(b);
+}
+
+void log_async_stop(struct log_async *b)
+{
+	struct log_async **prev;
+	struct log_ring *r;
+
+	if (__atomic_load_n(&b->mode, __ATOMIC_ACQUIRE) == LOG_ASYNC_SYNC)
+		return;
+
+	// New callers now print synchronously. Wait for the ones
+	// already queueing, so that their messages are drained
+	// below and their rings aren't freed under them.
+	__atomic_store_n(&b->mode, LOG_ASYNC_SYNC, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&b->callers, __ATOMIC_SEQ_CST))
+		sched_yield();
+
+	__atomic_store_n(&b->running, 0, __ATOMIC_RELEASE);
+	pthread_join(b->writer, NULL);
+
+	log_async_drain(b);
+
+	pthread_mutex_lock(&log_async_instances_lock);
+	for (prev = &log_async_instances ; *prev ; prev = &(*prev)->next) {
+		if (*prev == b) {
+			*prev = b->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&log_async_instances_lock);
+
+	while (b->rings) {
+		r = b->rings;
+		b->rings = r->next;
+		opae_free(r);
+	}
+
+	pthread_key_delete(b->key);
+	pthread_mutex_destroy(&b->drain_lock);
+	pthread_mutex_destroy(&b->lock);
+}
+
+uint64_t log_async_dropped(struct log_async *b)
+{
+	return __atomic_load_n(&b->dropped, __ATOMIC_RELAXED);
+}
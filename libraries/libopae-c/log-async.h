@@ -0,0 +1,112 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_LOG_ASYNC_H__
+#define __OPAE_LOG_ASYNC_H__
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Asynchronous logging backend shared by libopae-c and libofs.
+//
+// Each logging thread owns a lock-free single-producer ring.
+// A background writer thread drains the rings and performs
+// the actual stdio calls, so the caller never takes a lock
+// or blocks on I/O. When a ring is full the message is
+// dropped and counted rather than stalling the caller.
+//
+// In LOG_ASYNC_TEXT mode, the message is formatted by the
+// caller and the writer copies the text to the stream. In
+// LOG_ASYNC_BINARY mode, the caller copies only the format
+// string and the raw arguments; formatting is deferred to the
+// writer. Formats that can't be encoded (%n, %m, '*' widths,
+// long double, wide characters) fall back to text.
+//
+// The API is hidden so that libraries that each compile this
+// file keep separate copies.
+
+#define LOG_ASYNC_API __attribute__((visibility("hidden")))
+
+enum log_async_mode {
+	LOG_ASYNC_SYNC = 0,
+	LOG_ASYNC_TEXT,
+	LOG_ASYNC_BINARY
+};
+
+struct log_ring;
+
+struct log_async {
+	int mode;
+	int running;
+	int callers;                // threads using the rings
+	pthread_t writer;
+	pthread_key_t key;
+	pthread_mutex_t lock;       // protects rings
+	pthread_mutex_t drain_lock; // single consumer
+	struct log_ring *rings;
+	uint64_t dropped;
+	struct log_async *next;
+};
+
+// Parse the value of an environment variable such as
+// LIBOPAE_LOG_ASYNC: "binary" selects LOG_ASYNC_BINARY,
+// "0" or NULL selects LOG_ASYNC_SYNC and anything else
+// selects LOG_ASYNC_TEXT.
+LOG_ASYNC_API int log_async_mode_from_env(const char *s);
+
+// Start the writer thread for b in the given mode.
+// Returns 0 on success. On failure, b stays synchronous.
+LOG_ASYNC_API int log_async_start(struct log_async *b, int mode);
+
+// Queue a message for fp. Returns 0 when the message was
+// queued or dropped, and non-zero when the caller must print
+// it synchronously (b is synchronous, or in a forked child).
+// ap is not consumed.
+LOG_ASYNC_API int log_async_vprint(struct log_async *b, FILE *fp,
+				   const char *fmt, va_list ap);
+
+// Write all messages queued so far and flush the streams.
+LOG_ASYNC_API void log_async_flush(struct log_async *b);
+
+// Stop the writer thread and write any queued messages.
+// Other threads may keep logging through b: once the stop
+// has begun, log_async_vprint() asks them to print their
+// messages synchronously, and the stop waits for the calls
+// already queueing a message before it frees the rings.
+LOG_ASYNC_API void log_async_stop(struct log_async *b);
+
+// The number of messages dropped because a ring was full.
+LOG_ASYNC_API uint64_t log_async_dropped(struct log_async *b);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __OPAE_LOG_ASYNC_H__
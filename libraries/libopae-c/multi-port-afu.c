@@ -37,6 +37,8 @@
 #define _GNU_SOURCE
 #endif // _GNU_SOURCE
 
+#include <pthread.h>
+#include <stdbool.h>
 #include <uuid/uuid.h>
 
 #include <opae/properties.h>
@@ -225,12 +227,49 @@ fpga_result afu_close_children(opae_wrapped_handle *wrapped_parent_handle)
 	return FPGA_OK;
 }
 
+struct afu_pin_work {
+	opae_wrapped_handle *child;
+	void *buf_addr;
+	uint64_t len;
+	uint64_t ioaddr;
+	fpga_result res;
+	pthread_t thread;
+	bool threaded;
+};
+
+STATIC bool afu_child_shares_mappings(opae_wrapped_handle *child)
+{
+	bool shared = false;
+
+	if (!child->adapter_table->fpgaSharesParentMappings)
+		return false;
+
+	if (child->adapter_table->fpgaSharesParentMappings(
+		child->opae_handle, &shared) != FPGA_OK)
+		return false;
+
+	return shared;
+}
+
+STATIC void *afu_pin_child(void *arg)
+{
+	struct afu_pin_work *w = (struct afu_pin_work *)arg;
+
+	w->res = w->child->adapter_table->fpgaPinBuffer(
+		w->child->opae_handle, w->buf_addr, w->len, w->ioaddr);
+
+	return NULL;
+}
+
 fpga_result afu_pin_buffer(opae_wrapped_handle *wrapped_parent_handle,
 			   void *buf_addr, uint64_t len, uint64_t wsid)
 {
 	fpga_result res;
 	opae_wrapped_handle *wrapped_child = wrapped_parent_handle->child_next;
-	opae_wrapped_handle *wrapped_undo;
+	struct afu_pin_work *work;
+	uint32_t num_children = 0;
+	uint32_t separate = 0;
+	uint32_t c;
 
 	if (!wrapped_child)
 		return FPGA_OK;
@@ -247,26 +286,64 @@ fpga_result afu_pin_buffer(opae_wrapped_handle *wrapped_parent_handle,
 	while (wrapped_child) {
 		ASSERT_NOT_NULL_RESULT(wrapped_child->adapter_table->fpgaPinBuffer,
 				       FPGA_NOT_SUPPORTED);
-		res = wrapped_child->adapter_table->fpgaPinBuffer(
-			wrapped_child->opae_handle, buf_addr, len, ioaddr);
-		if (res != FPGA_OK)
-			goto error_child;
+		++num_children;
 		wrapped_child = wrapped_child->child_next;
 	}
 
-	return FPGA_OK;
+	work = opae_calloc(num_children, sizeof(struct afu_pin_work));
+	if (!work) {
+		OPAE_ERR("calloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	// Children that share the parent's IOMMU container see the
+	// parent's mapping and return at once, so pin those inline.
+	// Children with their own container each map the buffer,
+	// which pins every page, so do those in parallel. The first
+	// of them is pinned on this thread.
+	wrapped_child = wrapped_parent_handle->child_next;
+	for (c = 0; c < num_children; ++c) {
+		work[c].child = wrapped_child;
+		work[c].buf_addr = buf_addr;
+		work[c].len = len;
+		work[c].ioaddr = ioaddr;
+		if (!afu_child_shares_mappings(wrapped_child)) {
+			if (separate++ &&
+			    !pthread_create(&work[c].thread, NULL,
+					    afu_pin_child, &work[c]))
+				work[c].threaded = true;
+		}
+		wrapped_child = wrapped_child->child_next;
+	}
+
+	for (c = 0; c < num_children; ++c) {
+		if (!work[c].threaded)
+			afu_pin_child(&work[c]);
+	}
+
+	res = FPGA_OK;
+	for (c = 0; c < num_children; ++c) {
+		if (work[c].threaded)
+			pthread_join(work[c].thread, NULL);
+		if (work[c].res != FPGA_OK && res == FPGA_OK)
+			res = work[c].res;
+	}
+
+	if (res != FPGA_OK) {
+		// Undo pinning of any children that succeeded
+		for (c = 0; c < num_children; ++c) {
+			opae_wrapped_handle *wrapped_undo = work[c].child;
+
+			if (work[c].res != FPGA_OK ||
+			    !wrapped_undo->adapter_table->fpgaUnpinBuffer)
+				continue;
 
-error_child:
-	// Undo pinning of any children completed before the error
-	wrapped_undo = wrapped_parent_handle->child_next;
-	while (wrapped_undo != wrapped_child) {
-		if (wrapped_undo->adapter_table->fpgaUnpinBuffer)
 			wrapped_undo->adapter_table->fpgaUnpinBuffer(
 				wrapped_undo->opae_handle, buf_addr, len, ioaddr);
-
-		wrapped_undo = wrapped_undo->child_next;
+		}
 	}
 
+	opae_free(work);
 	return res;
 }
 
@@ -154,6 +154,10 @@ typedef struct _opae_wrapped_handle {
 	// Linked list of children, starting at the parent. The list order
 	// matches the order of the parent's child AFU GUID parameter.
 	struct _opae_wrapped_handle *child_next;
+
+	// Telemetry published by fpgad for this device, if any.
+	// Resolved on the first fpgaGetMetricsByIndex().
+	struct telemetry_reader *telemetry;
 } opae_wrapped_handle;
 
 opae_wrapped_handle *
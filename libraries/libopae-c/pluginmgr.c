@@ -1,4 +1,4 @@
-// Copyright(c) 2018-2023, Intel Corporation
+// Copyright(c) 2018-2024, Intel Corporation
 //
 // Redistribution  and  use  in source  and  binary  forms,  with  or  without
 // modification, are permitted provided that the following conditions are met:
@@ -35,6 +35,7 @@
 #include <dlfcn.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <linux/limits.h>
 #include <pthread.h>
 #include <pwd.h>
@@ -48,7 +49,7 @@
 #define OPAE_PLUGIN_CONFIGURE "opae_plugin_configure"
 typedef int (*opae_plugin_configure_t)(opae_api_adapter_table *, const char *);
 
-static libopae_config_data *platform_data_table;
+STATIC libopae_config_data *platform_data_table;
 
 int initialized;
 STATIC int finalizing;
@@ -251,49 +252,257 @@ STATIC int opae_plugin_mgr_register_adapter(opae_api_adapter_table *adapter)
 	return 0;
 }
 
-STATIC void opae_plugin_mgr_detect_platform(opae_pci_device *dev)
+// Platform detection looks at every PCI function in the system,
+// so the platform table is indexed by vendor and device ID, and
+// the IDs of each function are read with as few opens as possible.
+typedef struct _opae_platform_index {
+	uint32_t key;   // (vendor_id << 16) | device_id
+	uint32_t entry; // index into platform_data_table
+} opae_platform_index;
+
+#define OPAE_PLATFORM_KEY(__vendor, __device) \
+	(((uint32_t)(__vendor) << 16) | (uint32_t)(__device))
+
+STATIC int opae_plugin_mgr_cmp_index(const void *a, const void *b)
 {
-	int i;
-	bool match;
+	const opae_platform_index *ia = (const opae_platform_index *)a;
+	const opae_platform_index *ib = (const opae_platform_index *)b;
 
-	for (i = 0 ; platform_data_table[i].module_library ; ++i) {
-		match = true;
-
-		if ((platform_data_table[i].vendor_id != dev->vendor_id) ||
-		    (platform_data_table[i].device_id != dev->device_id))
-			match = false;
-
-		if ((platform_data_table[i].subsystem_vendor_id !=
-			OPAE_VENDOR_ANY) &&
-		    (platform_data_table[i].subsystem_vendor_id !=
-			dev->subsystem_vendor_id))
-			match = false;
-
-		if ((platform_data_table[i].subsystem_device_id !=
-			OPAE_DEVICE_ANY) &&
-		    (platform_data_table[i].subsystem_device_id !=
-			dev->subsystem_device_id))
-			match = false;
-
-		if (match) {
-			OPAE_DBG("platform detected: 0x%04x:0x%04x 0x%04x:0x%04x -> %s",
-				 dev->vendor_id, dev->device_id,
-				 dev->subsystem_vendor_id, dev->subsystem_device_id,
-				 platform_data_table[i].module_library);
-
-			platform_data_table[i].flags |= OPAE_PLATFORM_DATA_DETECTED;
-		}
+	if (ia->key != ib->key)
+		return ia->key < ib->key ? -1 : 1;
+
+	// Keep table order among entries with the same key.
+	if (ia->entry != ib->entry)
+		return ia->entry < ib->entry ? -1 : 1;
+
+	return 0;
+}
+
+// Build the index of platform_data_table, sorted by key.
+// Returns NULL when the table is empty or on allocation failure.
+STATIC opae_platform_index *opae_plugin_mgr_index_platforms(size_t *count)
+{
+	opae_platform_index *index;
+	size_t i;
+	size_t n = 0;
+
+	*count = 0;
+
+	if (!platform_data_table)
+		return NULL;
+
+	while (platform_data_table[n].module_library)
+		++n;
+
+	if (!n)
+		return NULL;
+
+	index = (opae_platform_index *)opae_calloc(n, sizeof(*index));
+	if (!index) {
+		OPAE_ERR("out of memory");
+		return NULL;
+	}
+
+	for (i = 0 ; i < n ; ++i) {
+		index[i].key = OPAE_PLATFORM_KEY(platform_data_table[i].vendor_id,
+						 platform_data_table[i].device_id);
+		index[i].entry = (uint32_t)i;
+	}
+
+	qsort(index, n, sizeof(*index), opae_plugin_mgr_cmp_index);
+
+	*count = n;
+	return index;
+}
+
+// Find the first index position whose key is not less than key.
+STATIC size_t opae_plugin_mgr_lower_bound(const opae_platform_index *index,
+					  size_t count,
+					  uint32_t key)
+{
+	size_t lo = 0;
+	size_t hi = count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (index[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+// Whether any platform in the index has the given vendor ID.
+STATIC bool opae_plugin_mgr_vendor_indexed(const opae_platform_index *index,
+					   size_t count,
+					   uint16_t vendor_id)
+{
+	size_t pos = opae_plugin_mgr_lower_bound(index, count,
+				OPAE_PLATFORM_KEY(vendor_id, 0));
+
+	return (pos < count) && ((index[pos].key >> 16) == vendor_id);
+}
+
+STATIC void opae_plugin_mgr_detect_platform(const opae_platform_index *index,
+					    size_t count,
+					    opae_pci_device *dev)
+{
+	uint32_t key = OPAE_PLATFORM_KEY(dev->vendor_id, dev->device_id);
+	size_t pos;
+
+	for (pos = opae_plugin_mgr_lower_bound(index, count, key) ;
+	     (pos < count) && (index[pos].key == key) ; ++pos) {
+		libopae_config_data *cfg = &platform_data_table[index[pos].entry];
 
+		if ((cfg->subsystem_vendor_id != OPAE_VENDOR_ANY) &&
+		    (cfg->subsystem_vendor_id != dev->subsystem_vendor_id))
+			continue;
+
+		if ((cfg->subsystem_device_id != OPAE_DEVICE_ANY) &&
+		    (cfg->subsystem_device_id != dev->subsystem_device_id))
+			continue;
+
+		OPAE_DBG("platform detected: 0x%04x:0x%04x 0x%04x:0x%04x -> %s",
+			 dev->vendor_id, dev->device_id,
+			 dev->subsystem_vendor_id, dev->subsystem_device_id,
+			 cfg->module_library);
+
+		cfg->flags |= OPAE_PLATFORM_DATA_DETECTED;
 	}
 }
 
+// Read one of the hex ID attributes of the PCI function at dev_path.
+STATIC int opae_plugin_mgr_read_pci_id(const char *dev_path,
+				       const char *attr,
+				       uint16_t *id)
+{
+	char file_path[PATH_MAX];
+	unsigned value = 0;
+	FILE *fp;
+
+	if (snprintf(file_path, sizeof(file_path),
+		     "%s/%s", dev_path, attr) >= (int)sizeof(file_path)) {
+		OPAE_ERR("snprintf buffer overflow");
+		return 1;
+	}
+
+	fp = opae_fopen(file_path, "r");
+	if (!fp) {
+		OPAE_ERR("Failed to open %s. Aborting platform detection.", file_path);
+		return 1;
+	}
+
+	if (EOF == fscanf(fp, "%x", &value)) {
+		OPAE_ERR("Failed to read %s. Aborting platform detection.", file_path);
+		opae_fclose(fp);
+		return 1;
+	}
+
+	opae_fclose(fp);
+
+	*id = (uint16_t)value;
+	return 0;
+}
+
+// Read the IDs of the PCI function at dev_path into dev.
+//
+// The kernel reports all four IDs in the function's 'uevent' file,
+// so normally one read is enough. Otherwise the 'vendor', 'device',
+// 'subsystem_vendor' and 'subsystem_device' files are read, stopping
+// after 'vendor' when no platform in the index has that vendor ID.
+STATIC int opae_plugin_mgr_read_pci_ids(const char *dev_path,
+					const opae_platform_index *index,
+					size_t count,
+					opae_pci_device *dev)
+{
+	char file_path[PATH_MAX];
+	char buf[1024];
+	ssize_t bytes = -1;
+	unsigned vendor_id, device_id;
+	unsigned subsystem_vendor_id, subsystem_device_id;
+	char *p;
+	int found = 0;
+	int fd;
+
+	if (snprintf(file_path, sizeof(file_path),
+		     "%s/uevent", dev_path) >= (int)sizeof(file_path)) {
+		OPAE_ERR("snprintf buffer overflow");
+		return 1;
+	}
+
+	fd = opae_open(file_path, O_RDONLY);
+	if (fd >= 0) {
+		bytes = opae_read(fd, buf, sizeof(buf) - 1);
+		opae_close(fd);
+	}
+
+	if (bytes > 0) {
+		buf[bytes] = '\0';
+
+		p = strstr(buf, "PCI_ID=");
+		if (p && (sscanf(p, "PCI_ID=%x:%x",
+				 &vendor_id, &device_id) == 2))
+			found |= 1;
+
+		p = strstr(buf, "PCI_SUBSYS_ID=");
+		if (p && (sscanf(p, "PCI_SUBSYS_ID=%x:%x",
+				 &subsystem_vendor_id,
+				 &subsystem_device_id) == 2))
+			found |= 2;
+
+		if (found == 3) {
+			dev->vendor_id = (uint16_t)vendor_id;
+			dev->device_id = (uint16_t)device_id;
+			dev->subsystem_vendor_id = (uint16_t)subsystem_vendor_id;
+			dev->subsystem_device_id = (uint16_t)subsystem_device_id;
+			return 0;
+		}
+	}
+
+	if (opae_plugin_mgr_read_pci_id(dev_path, "vendor", &dev->vendor_id))
+		return 1;
+
+	if (!opae_plugin_mgr_vendor_indexed(index, count, dev->vendor_id))
+		return 0;
+
+	if (opae_plugin_mgr_read_pci_id(dev_path, "device", &dev->device_id) ||
+	    opae_plugin_mgr_read_pci_id(dev_path, "subsystem_vendor",
+					&dev->subsystem_vendor_id) ||
+	    opae_plugin_mgr_read_pci_id(dev_path, "subsystem_device",
+					&dev->subsystem_device_id))
+		return 1;
+
+	return 0;
+}
+
 STATIC int opae_plugin_mgr_detect_platforms(bool with_ase)
 {
 	DIR *dir;
 	char base_dir[PATH_MAX];
-	char file_path[PATH_MAX];
+	char dev_path[PATH_MAX];
 	struct dirent *dirent;
 	int errors = 0;
+	opae_platform_index *index;
+	size_t count = 0;
+	opae_pci_device emu = {
+		.name = "emu",
+		.vendor_id = 0x8086,
+		.device_id = 0x0e5e,
+		.subsystem_vendor_id = 0x8086,
+		.subsystem_device_id = 0x0e5e
+	};
+
+	index = opae_plugin_mgr_index_platforms(&count);
+	if (!index)
+		// Either nothing can be detected, or we're out of memory.
+		return count ? 1 : 0;
+
+	// The emulated device (libopae-e) has no PCI function. It is
+	// detected whenever its opae.cfg configuration is enabled.
+	opae_plugin_mgr_detect_platform(index, count, &emu);
 
 	if (with_ase) {
 		opae_pci_device ase_pf = {
@@ -311,151 +520,54 @@ STATIC int opae_plugin_mgr_detect_platforms(bool with_ase)
 			.subsystem_device_id = 0x0a5f
 		};
 
-		opae_plugin_mgr_detect_platform(&ase_pf);
-		opae_plugin_mgr_detect_platform(&ase_vf);
-		return 0;
+		opae_plugin_mgr_detect_platform(index, count, &ase_pf);
+		opae_plugin_mgr_detect_platform(index, count, &ase_vf);
+		goto out_free;
 	}
 
 	// Iterate over the directories in /sys/bus/pci/devices.
 	// This directory contains symbolic links to device directories
-	// where 'vendor', 'device', 'subsystem_vendor', and
-	// 'subsystem_device' files exist.
+	// where the 'uevent' file and the 'vendor', 'device',
+	// 'subsystem_vendor', and 'subsystem_device' files exist.
 
 	memcpy(base_dir, "/sys/bus/pci/devices", 21);
 
 	dir = opae_opendir(base_dir);
 	if (!dir) {
 		OPAE_ERR("Failed to open %s. Aborting platform detection.", base_dir);
-		return 1;
+		errors = 1;
+		goto out_free;
 	}
 
 	while ((dirent = readdir(dir)) != NULL) {
-		FILE *fp;
 		opae_pci_device dev = { NULL, 0, 0, 0, 0 };
-		unsigned vendor_id = 0;
-		unsigned device_id = 0;
-		unsigned subsystem_vendor_id = 0;
-		unsigned subsystem_device_id = 0;
 
 		if (!strcmp(dirent->d_name, ".") ||
 		    !strcmp(dirent->d_name, ".."))
 			continue;
 
-		// Read the 'vendor' file.
-		if (snprintf(file_path, sizeof(file_path),
-			     "%s/%s/vendor",
+		if (snprintf(dev_path, sizeof(dev_path),
+			     "%s/%s",
 			     base_dir,
-			     dirent->d_name) < 0) {
+			     dirent->d_name) >= (int)sizeof(dev_path)) {
 			OPAE_ERR("snprintf buffer overflow");
 			++errors;
 			goto out_close;
 		}
 
-		fp = opae_fopen(file_path, "r");
-		if (!fp) {
-			OPAE_ERR("Failed to open %s. Aborting platform detection.", file_path);
-			++errors;
-			goto out_close;
-		}
-
-		if (EOF == fscanf(fp, "%x", &vendor_id)) {
-			OPAE_ERR("Failed to read %s. Aborting platform detection.", file_path);
-			opae_fclose(fp);
+		if (opae_plugin_mgr_read_pci_ids(dev_path, index, count, &dev)) {
 			++errors;
 			goto out_close;
 		}
 
-		opae_fclose(fp);
-
-		// Read the 'device' file.
-		if (snprintf(file_path, sizeof(file_path),
-			     "%s/%s/device",
-			     base_dir,
-			     dirent->d_name) < 0) {
-			OPAE_ERR("snprintf buffer overflow");
-			++errors;
-			goto out_close;
-		}
-
-		fp = opae_fopen(file_path, "r");
-		if (!fp) {
-			OPAE_ERR("Failed to open %s. Aborting platform detection.", file_path);
-			++errors;
-			goto out_close;
-		}
-
-		if (EOF == fscanf(fp, "%x", &device_id)) {
-			OPAE_ERR("Failed to read %s. Aborting platform detection.", file_path);
-			opae_fclose(fp);
-			++errors;
-			goto out_close;
-		}
-
-		opae_fclose(fp);
-
-		// Read the 'subsystem_vendor' file.
-		if (snprintf(file_path, sizeof(file_path),
-			     "%s/%s/subsystem_vendor",
-			     base_dir,
-			     dirent->d_name) < 0) {
-			OPAE_ERR("snprintf buffer overflow");
-			++errors;
-			goto out_close;
-		}
-
-		fp = opae_fopen(file_path, "r");
-		if (!fp) {
-			OPAE_ERR("Failed to open %s. Aborting platform detection.", file_path);
-			++errors;
-			goto out_close;
-		}
-
-		if (EOF == fscanf(fp, "%x", &subsystem_vendor_id)) {
-			OPAE_ERR("Failed to read %s. Aborting platform detection.", file_path);
-			opae_fclose(fp);
-			++errors;
-			goto out_close;
-		}
-
-		opae_fclose(fp);
-
-		// Read the 'subsystem_device' file.
-		if (snprintf(file_path, sizeof(file_path),
-			     "%s/%s/subsystem_device",
-			     base_dir,
-			     dirent->d_name) < 0) {
-			OPAE_ERR("snprintf buffer overflow");
-			++errors;
-			goto out_close;
-		}
-
-		fp = opae_fopen(file_path, "r");
-		if (!fp) {
-			OPAE_ERR("Failed to open %s. Aborting platform detection.", file_path);
-			++errors;
-			goto out_close;
-		}
-
-		if (EOF == fscanf(fp, "%x", &subsystem_device_id)) {
-			OPAE_ERR("Failed to read %s. Aborting platform detection.", file_path);
-			opae_fclose(fp);
-			++errors;
-			goto out_close;
-		}
-
-		opae_fclose(fp);
-
 		// Detect platform for this opae_pci_device.
-		dev.vendor_id = (uint16_t)vendor_id;
-		dev.device_id = (uint16_t)device_id;
-		dev.subsystem_vendor_id = (uint16_t)subsystem_vendor_id;
-		dev.subsystem_device_id = (uint16_t)subsystem_device_id;
-
-		opae_plugin_mgr_detect_platform(&dev);
+		opae_plugin_mgr_detect_platform(index, count, &dev);
 	}
 
 out_close:
 	opae_closedir(dir);
+out_free:
+	opae_free(index);
 	return errors;
 }
 
@@ -526,6 +638,29 @@ STATIC int opae_plugin_mgr_load_plugins(int *platforms_detected)
 		platform_data_table[i].flags |= OPAE_PLATFORM_DATA_LOADED;
 	}
 
+	// Devices served by opae-remoted are reached through the
+	// remote plugin, which does not depend on local PCI devices.
+	if (getenv("OPAE_REMOTE_ENDPOINT")) {
+		adapter = opae_plugin_mgr_alloc_adapter("libopae-r.so");
+		if (!adapter) {
+			OPAE_ERR("calloc failed");
+			return ++errors;
+		}
+
+		res = opae_plugin_mgr_configure_plugin(adapter, NULL);
+		if (res) {
+			opae_plugin_mgr_free_adapter(adapter);
+			OPAE_ERR("failed to configure plugin \"libopae-r.so\"");
+			return ++errors;
+		}
+
+		res = opae_plugin_mgr_register_adapter(adapter);
+		if (res)
+			opae_plugin_mgr_free_adapter(adapter);
+		else
+			(*platforms_detected)++;
+	}
+
 	return errors;
 }
 
@@ -533,7 +668,6 @@ int opae_plugin_mgr_initialize(const char *cfg_file)
 {
 	int res;
 	bool free_config = false;
-	char *raw_config = NULL;
 	int platforms_detected = 0;
 	int errors = 0;
 
@@ -555,14 +689,9 @@ int opae_plugin_mgr_initialize(const char *cfg_file)
 			free_config = true;
 	}
 
-	if (cfg_file) {
-		raw_config = opae_read_cfg_file(cfg_file);
-	}
-
-	// Parse the config file content, allocating and initializing
-	// our configuration table. If raw_config is non-NULL, then
-	// this function will delete it.
-	platform_data_table = opae_parse_libopae_config(cfg_file, raw_config);
+	// Load the configuration table from the config file cache,
+	// or by reading and parsing the config file content.
+	platform_data_table = opae_load_libopae_config(cfg_file);
 
 	// Print the config table for debug builds.
 	opae_print_libopae_config(platform_data_table);
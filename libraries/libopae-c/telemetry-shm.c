@@ -0,0 +1,524 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <opae/log.h>
+
+#include "telemetry-shm.h"
+#include "mock/opae_std.h"
+
+// How many times a reader retries while the writer is updating.
+#define TELEMETRY_READ_RETRIES 64
+// How long a reader waits before trying to (re)attach.
+#define TELEMETRY_ATTACH_RETRY_NS 1000000000ULL
+
+#define TELEMETRY_IS_VALID(__s, __i) \
+((__s)->metric_valid[(__i) / 8] & (1 << ((__i) % 8)))
+
+void telemetry_shm_name(char *name, size_t len,
+			uint16_t segment, uint8_t bus,
+			uint8_t device, uint8_t function)
+{
+	snprintf(name, len, TELEMETRY_SHM_FMT,
+		 (int)segment, (int)bus, (int)device, (int)function);
+}
+
+uint64_t telemetry_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int telemetry_writer_open(telemetry_writer *w,
+			  const char *name,
+			  uint64_t interval_ns)
+{
+	int fd;
+	void *p;
+	size_t len;
+
+	memset(w, 0, sizeof(*w));
+
+	len = strnlen(name, sizeof(w->name) - 1);
+	memcpy(w->name, name, len);
+	w->name[len] = '\0';
+
+	// Remove any segment left behind by a previous instance.
+	// Readers still mapping it see it go stale and re-attach.
+	shm_unlink(w->name);
+
+	fd = shm_open(w->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0) {
+		OPAE_ERR("shm_open(\"%s\") failed: %s",
+			 w->name, strerror(errno));
+		return 1;
+	}
+
+	// Don't let the umask keep readers out.
+	if (fchmod(fd, 0644) ||
+	    ftruncate(fd, sizeof(telemetry_shm))) {
+		OPAE_ERR("failed to size \"%s\": %s",
+			 w->name, strerror(errno));
+		goto out_unlink;
+	}
+
+	p = mmap(NULL, sizeof(telemetry_shm), PROT_READ | PROT_WRITE,
+		 MAP_SHARED, fd, 0);
+	if (p == MAP_FAILED) {
+		OPAE_ERR("mmap(\"%s\") failed: %s",
+			 w->name, strerror(errno));
+		goto out_unlink;
+	}
+
+	opae_close(fd);
+
+	w->shm = (telemetry_shm *)p;
+	w->shm->version = TELEMETRY_VERSION;
+	w->shm->size = sizeof(telemetry_shm);
+	w->shm->writer_pid = (int32_t)getpid();
+	w->shm->interval_ns = interval_ns;
+
+	// Readers check the magic last.
+	__atomic_store_n(&w->shm->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+
+	return 0;
+
+out_unlink:
+	opae_close(fd);
+	shm_unlink(w->name);
+	return 1;
+}
+
+void telemetry_writer_close(telemetry_writer *w)
+{
+	if (!w->shm)
+		return;
+
+	munmap(w->shm, sizeof(telemetry_shm));
+	w->shm = NULL;
+	shm_unlink(w->name);
+}
+
+telemetry_sample *telemetry_writer_begin(telemetry_writer *w)
+{
+	telemetry_shm *shm = w->shm;
+
+	__atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	w->slot = shm->updates ?
+		(shm->history_head + 1) % TELEMETRY_HISTORY : 0;
+
+	return &shm->history[w->slot];
+}
+
+void telemetry_writer_end(telemetry_writer *w)
+{
+	telemetry_shm *shm = w->shm;
+
+	shm->history[w->slot].timestamp_ns = telemetry_now_ns();
+	shm->history_head = w->slot;
+	if (shm->history_len < TELEMETRY_HISTORY)
+		++shm->history_len;
+	++shm->updates;
+
+	__atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELEASE);
+}
+
+const telemetry_shm *telemetry_shm_open(const char *name, ino_t *inode)
+{
+	int fd;
+	void *p;
+	struct stat st;
+	const telemetry_shm *shm;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) ||
+	    (st.st_size < (off_t)sizeof(telemetry_shm))) {
+		opae_close(fd);
+		return NULL;
+	}
+
+	// Anyone can create a segment under the expected name, so only
+	// believe one that root (or this user) made and nobody else can
+	// modify. Otherwise the caller falls back to sysfs.
+	if (((st.st_uid != 0) && (st.st_uid != geteuid())) ||
+	    (st.st_mode & (S_IWGRP | S_IWOTH))) {
+		OPAE_MSG("ignoring untrusted telemetry segment %s", name);
+		opae_close(fd);
+		return NULL;
+	}
+
+	p = mmap(NULL, sizeof(telemetry_shm), PROT_READ,
+		 MAP_SHARED, fd, 0);
+	opae_close(fd);
+	if (p == MAP_FAILED)
+		return NULL;
+
+	shm = (const telemetry_shm *)p;
+	if ((__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) !=
+		TELEMETRY_MAGIC) ||
+	    (shm->version != TELEMETRY_VERSION) ||
+	    (shm->size != sizeof(telemetry_shm))) {
+		munmap(p, sizeof(telemetry_shm));
+		return NULL;
+	}
+
+	if (inode)
+		*inode = st.st_ino;
+
+	return shm;
+}
+
+void telemetry_shm_close(const telemetry_shm *shm)
+{
+	if (shm)
+		munmap((void *)shm, sizeof(telemetry_shm));
+}
+
+// Find the table index of metric_num. The table is normally
+// indexed by metric number, so try that first.
+STATIC int telemetry_find_metric(const telemetry_shm *shm,
+				 uint32_t num_metrics,
+				 uint64_t metric_num)
+{
+	uint32_t i;
+
+	if ((metric_num < num_metrics) &&
+	    (shm->metric[metric_num].metric_num == metric_num))
+		return (int)metric_num;
+
+	for (i = 0 ; i < num_metrics ; ++i) {
+		if (shm->metric[i].metric_num == metric_num)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+int telemetry_read_metrics(const telemetry_shm *shm,
+			   const uint64_t *metric_num,
+			   uint64_t count,
+			   fpga_metric *metrics,
+			   uint64_t max_age_ns)
+{
+	int tries;
+
+	for (tries = 0 ; tries < TELEMETRY_READ_RETRIES ; ++tries) {
+		uint32_t seq;
+		uint32_t num_metrics;
+		const telemetry_sample *sample;
+		uint64_t timestamp;
+		uint64_t i;
+		int res = 0;
+
+		seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+
+		if (!shm->updates)
+			return 1;
+
+		if (!max_age_ns)
+			max_age_ns = shm->interval_ns *
+				     TELEMETRY_STALE_INTERVALS;
+
+		num_metrics = shm->num_metrics;
+		if (num_metrics > TELEMETRY_MAX_METRICS)
+			num_metrics = TELEMETRY_MAX_METRICS;
+
+		sample = &shm->history[shm->history_head % TELEMETRY_HISTORY];
+		timestamp = sample->timestamp_ns;
+
+		for (i = 0 ; i < count ; ++i) {
+			int idx = telemetry_find_metric(shm, num_metrics,
+							metric_num[i]);
+			if (idx < 0) {
+				res = 1;
+				break;
+			}
+			metrics[i].metric_num = metric_num[i];
+			metrics[i].value = sample->metrics[idx];
+			metrics[i].isvalid = TELEMETRY_IS_VALID(sample, idx) ?
+					     true : false;
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) != seq)
+			continue;
+
+		if (telemetry_now_ns() - timestamp > max_age_ns)
+			return 1;
+
+		return res;
+	}
+
+	return 1;
+}
+
+int telemetry_read_history(const telemetry_shm *shm,
+			   uint64_t metric_num,
+			   uint64_t *timestamps,
+			   metric_value *values,
+			   uint32_t *count)
+{
+	int tries;
+
+	for (tries = 0 ; tries < TELEMETRY_READ_RETRIES ; ++tries) {
+		uint32_t seq;
+		uint32_t num_metrics;
+		uint32_t head;
+		uint32_t n;
+		uint32_t i;
+		int idx;
+
+		seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+		if (seq & 1)
+			continue;
+
+		num_metrics = shm->num_metrics;
+		if (num_metrics > TELEMETRY_MAX_METRICS)
+			num_metrics = TELEMETRY_MAX_METRICS;
+
+		idx = telemetry_find_metric(shm, num_metrics, metric_num);
+
+		head = shm->history_head;
+		n = shm->history_len;
+		if (n > *count)
+			n = *count;
+
+		for (i = 0 ; (idx >= 0) && (i < n) ; ++i) {
+			const telemetry_sample *sample =
+				&shm->history[(head + TELEMETRY_HISTORY - i) %
+					      TELEMETRY_HISTORY];
+			timestamps[i] = sample->timestamp_ns;
+			values[i] = sample->metrics[idx];
+		}
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) != seq)
+			continue;
+
+		if (idx < 0)
+			return 1;
+
+		*count = n;
+		return 0;
+	}
+
+	return 1;
+}
+
+// A mapping that was replaced while other threads may still
+// be reading it. It stays mapped until release.
+struct telemetry_mapping {
+	const telemetry_shm *shm;
+	struct telemetry_mapping *next;
+};
+
+struct telemetry_reader {
+	char name[TELEMETRY_SHM_NAME_MAX];
+	uint16_t segment;
+	uint8_t bus;
+	uint8_t device;
+	uint8_t function;
+	const telemetry_shm *shm; // atomic
+	ino_t inode;
+	uint64_t retry_ns;        // atomic
+	struct telemetry_mapping *retired;
+	struct telemetry_reader *next;
+};
+
+STATIC pthread_mutex_t telemetry_lock = PTHREAD_MUTEX_INITIALIZER;
+STATIC struct telemetry_reader *telemetry_readers;
+STATIC int telemetry_enabled = -1;
+
+struct telemetry_reader *telemetry_reader_get(uint16_t segment, uint8_t bus,
+					      uint8_t device, uint8_t function)
+{
+	struct telemetry_reader *r;
+	int enabled;
+
+	enabled = __atomic_load_n(&telemetry_enabled, __ATOMIC_RELAXED);
+	if (!enabled)
+		return NULL;
+
+	if (pthread_mutex_lock(&telemetry_lock))
+		return NULL;
+
+	if (enabled < 0) {
+		const char *s = getenv("LIBOPAE_TELEMETRY");
+
+		enabled = (s && !strcmp(s, "0")) ? 0 : 1;
+		__atomic_store_n(&telemetry_enabled, enabled,
+				 __ATOMIC_RELAXED);
+		if (!enabled) {
+			r = NULL;
+			goto out_unlock;
+		}
+	}
+
+	for (r = telemetry_readers ; r ; r = r->next) {
+		if ((r->segment == segment) &&
+		    (r->bus == bus) &&
+		    (r->device == device) &&
+		    (r->function == function))
+			goto out_unlock;
+	}
+
+	r = opae_calloc(1, sizeof(struct telemetry_reader));
+	if (!r)
+		goto out_unlock;
+
+	telemetry_shm_name(r->name, sizeof(r->name),
+			   segment, bus, device, function);
+	r->segment = segment;
+	r->bus = bus;
+	r->device = device;
+	r->function = function;
+
+	r->next = telemetry_readers;
+	telemetry_readers = r;
+
+out_unlock:
+	pthread_mutex_unlock(&telemetry_lock);
+	return r;
+}
+
+// Called with telemetry_lock held.
+STATIC void telemetry_reader_attach(struct telemetry_reader *r)
+{
+	const telemetry_shm *shm;
+	struct telemetry_mapping *m;
+	ino_t inode = 0;
+
+	__atomic_store_n(&r->retry_ns,
+			 telemetry_now_ns() + TELEMETRY_ATTACH_RETRY_NS,
+			 __ATOMIC_RELAXED);
+
+	shm = telemetry_shm_open(r->name, &inode);
+	if (!shm)
+		return;
+
+	if (r->shm && (inode == r->inode)) {
+		// Same segment, the publisher is just behind.
+		telemetry_shm_close(shm);
+		return;
+	}
+
+	if (shm->writer_pid == (int32_t)getpid()) {
+		// Don't serve the publisher its own values.
+		telemetry_shm_close(shm);
+		__atomic_store_n(&r->retry_ns, UINT64_MAX, __ATOMIC_RELAXED);
+		return;
+	}
+
+	if (r->shm) {
+		m = opae_malloc(sizeof(struct telemetry_mapping));
+		if (!m) {
+			telemetry_shm_close(shm);
+			return;
+		}
+		m->shm = r->shm;
+		m->next = r->retired;
+		r->retired = m;
+	}
+
+	r->inode = inode;
+	__atomic_store_n(&r->shm, shm, __ATOMIC_RELEASE);
+}
+
+int telemetry_reader_read(struct telemetry_reader *r,
+			  const uint64_t *metric_num,
+			  uint64_t count,
+			  fpga_metric *metrics)
+{
+	const telemetry_shm *shm;
+
+	shm = __atomic_load_n(&r->shm, __ATOMIC_ACQUIRE);
+	if (shm && !telemetry_read_metrics(shm, metric_num,
+					   count, metrics, 0))
+		return 0;
+
+	if (telemetry_now_ns() <
+		__atomic_load_n(&r->retry_ns, __ATOMIC_RELAXED))
+		return 1;
+
+	// Don't make readers wait on each other.
+	if (pthread_mutex_trylock(&telemetry_lock))
+		return 1;
+	telemetry_reader_attach(r);
+	pthread_mutex_unlock(&telemetry_lock);
+
+	shm = __atomic_load_n(&r->shm, __ATOMIC_ACQUIRE);
+	if (!shm)
+		return 1;
+
+	return telemetry_read_metrics(shm, metric_num, count, metrics, 0);
+}
+
+void telemetry_reader_release_all(void)
+{
+	struct telemetry_reader *r;
+	struct telemetry_mapping *m;
+
+	if (pthread_mutex_lock(&telemetry_lock))
+		return;
+
+	while (telemetry_readers) {
+		r = telemetry_readers;
+		telemetry_readers = r->next;
+
+		while (r->retired) {
+			m = r->retired;
+			r->retired = m->next;
+			telemetry_shm_close(m->shm);
+			opae_free(m);
+		}
+
+		telemetry_shm_close(r->shm);
+		opae_free(r);
+	}
+
+	pthread_mutex_unlock(&telemetry_lock);
+}
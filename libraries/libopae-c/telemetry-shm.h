@@ -0,0 +1,208 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_TELEMETRY_SHM_H__
+#define __OPAE_TELEMETRY_SHM_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <opae/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// Board telemetry published by fpgad.
+//
+// For each monitored FPGA device, fpgad (fpgad-vc) periodically
+// reads the board sensors and the device metrics and publishes
+// them into a POSIX shared memory segment named by the device's
+// PCIe address, eg /dev/shm/opae-telemetry-0000:3b:00.0. The
+// segment is writable only by fpgad. Readers map it read-only,
+// so reading the latest values costs no system calls and does
+// not touch the BMC.
+//
+// The segment is guarded by a sequence lock: the writer makes
+// seq odd before updating and even afterwards. A reader copies
+// the values it needs and retries if seq was odd or changed.
+//
+// The most recent TELEMETRY_HISTORY samples are kept in a ring.
+// history[history_head] is the latest sample.
+//
+// The API is hidden so that fpgad and libopae-c each keep
+// their own copy.
+
+#define TELEMETRY_API __attribute__((visibility("hidden")))
+
+#define TELEMETRY_SHM_FMT "/opae-telemetry-%04x:%02x:%02x.%d"
+#define TELEMETRY_SHM_NAME_MAX 64
+
+//                          O P A E T L M 1
+#define TELEMETRY_MAGIC 0x314d4c5445415041ULL
+#define TELEMETRY_VERSION 1
+
+#define TELEMETRY_MAX_METRICS 256
+#define TELEMETRY_MAX_SENSORS 128
+#define TELEMETRY_HISTORY 32
+#define TELEMETRY_NAME_LEN 32
+#define TELEMETRY_TYPE_LEN 16
+
+// A sample older than TELEMETRY_STALE_INTERVALS publish
+// intervals is not served to readers.
+#define TELEMETRY_STALE_INTERVALS 3
+
+typedef struct _telemetry_metric {
+	uint64_t metric_num;
+	char name[FPGA_METRIC_STR_SIZE]; // qualifier name
+	char units[TELEMETRY_TYPE_LEN];
+} telemetry_metric;
+
+#define TELEMETRY_SENSOR_VALID 0x00000001
+typedef struct _telemetry_sensor {
+	char name[TELEMETRY_NAME_LEN];
+	char type[TELEMETRY_TYPE_LEN];
+	uint32_t flags;
+	uint32_t reserved;
+} telemetry_sensor;
+
+typedef struct _telemetry_sample {
+	uint64_t timestamp_ns; // CLOCK_MONOTONIC
+	uint8_t metric_valid[TELEMETRY_MAX_METRICS / 8];
+	metric_value metrics[TELEMETRY_MAX_METRICS];
+	uint64_t sensors[TELEMETRY_MAX_SENSORS];
+} telemetry_sample;
+
+typedef struct _telemetry_shm {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t size;         // sizeof(telemetry_shm)
+	int32_t writer_pid;
+	uint32_t seq;          // sequence lock
+	uint64_t interval_ns;  // publish interval
+	uint64_t updates;      // number of samples published
+	uint32_t num_metrics;
+	uint32_t num_sensors;
+	uint32_t history_len;  // number of valid samples
+	uint32_t history_head; // index of the latest sample
+	telemetry_metric metric[TELEMETRY_MAX_METRICS];
+	telemetry_sensor sensor[TELEMETRY_MAX_SENSORS];
+	telemetry_sample history[TELEMETRY_HISTORY];
+} telemetry_shm;
+
+// Format the segment name for the device at the given address.
+TELEMETRY_API void telemetry_shm_name(char *name, size_t len,
+				      uint16_t segment, uint8_t bus,
+				      uint8_t device, uint8_t function);
+
+// CLOCK_MONOTONIC in nanoseconds.
+TELEMETRY_API uint64_t telemetry_now_ns(void);
+
+// Writer side (fpgad).
+
+typedef struct _telemetry_writer {
+	telemetry_shm *shm;
+	uint32_t slot; // the sample being written
+	char name[TELEMETRY_SHM_NAME_MAX];
+} telemetry_writer;
+
+// Create (or re-create) and map the segment for name, which is
+// readable by all users. Returns 0 on success.
+TELEMETRY_API int telemetry_writer_open(telemetry_writer *w,
+					const char *name,
+					uint64_t interval_ns);
+
+// Unmap and remove the segment.
+TELEMETRY_API void telemetry_writer_close(telemetry_writer *w);
+
+// Begin an update. Returns the history slot that becomes the
+// latest sample when telemetry_writer_end() is called. The
+// metric and sensor tables may also be modified until then.
+TELEMETRY_API telemetry_sample *
+telemetry_writer_begin(telemetry_writer *w);
+
+// Time stamp the sample returned by telemetry_writer_begin(),
+// make it the latest and end the update.
+TELEMETRY_API void telemetry_writer_end(telemetry_writer *w);
+
+// Reader side (libopae-c and other consumers).
+
+// Map the segment name read-only. Returns NULL if it doesn't
+// exist, isn't a compatible telemetry segment, or isn't owned by
+// root or the caller's user with no group or other write access.
+TELEMETRY_API const telemetry_shm *telemetry_shm_open(const char *name,
+						      ino_t *inode);
+
+TELEMETRY_API void telemetry_shm_close(const telemetry_shm *shm);
+
+// Copy the latest values of the count metrics listed in
+// metric_num into metrics. The sample must be no older than
+// max_age_ns; 0 selects TELEMETRY_STALE_INTERVALS publish
+// intervals. Returns 0 on success, or non-zero when the sample
+// is stale, a metric isn't published or the writer was too
+// busy to get a consistent copy.
+TELEMETRY_API int telemetry_read_metrics(const telemetry_shm *shm,
+					 const uint64_t *metric_num,
+					 uint64_t count,
+					 fpga_metric *metrics,
+					 uint64_t max_age_ns);
+
+// Copy up to *count samples of one metric, newest first, into
+// timestamps and values. On return *count holds the number of
+// samples copied. Returns 0 on success.
+TELEMETRY_API int telemetry_read_history(const telemetry_shm *shm,
+					 uint64_t metric_num,
+					 uint64_t *timestamps,
+					 metric_value *values,
+					 uint32_t *count);
+
+// A process-wide cache of mapped segments, used by
+// fpgaGetMetricsByIndex() for FPGA_DEVICE handles.
+
+struct telemetry_reader;
+
+// Find or create the reader for the device at the given address.
+// Returns NULL if telemetry reads are disabled (LIBOPAE_TELEMETRY=0).
+TELEMETRY_API struct telemetry_reader *
+telemetry_reader_get(uint16_t segment, uint8_t bus,
+		     uint8_t device, uint8_t function);
+
+// As telemetry_read_metrics(), (re)attaching to the segment
+// when needed. Segments published by this process are ignored.
+TELEMETRY_API int telemetry_reader_read(struct telemetry_reader *r,
+					const uint64_t *metric_num,
+					uint64_t count,
+					fpga_metric *metrics);
+
+// Unmap all segments and free all readers. No reader may be
+// used during or after this call.
+TELEMETRY_API void telemetry_reader_release_all(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __OPAE_TELEMETRY_SHM_H__
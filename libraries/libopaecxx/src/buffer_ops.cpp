@@ -0,0 +1,539 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include <opae/cxx/core/buffer_ops.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BUFFER_OPS_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#include <x86intrin.h>
+#endif  // x86
+
+namespace opae {
+namespace fpga {
+namespace types {
+namespace buffer_ops {
+
+namespace {
+
+// fill_random() generates four interleaved xorshift128+ streams, so
+// that the vector and scalar implementations produce the same bytes.
+const std::size_t random_lanes = 4;
+
+struct random_state {
+  uint64_t s0[random_lanes];
+  uint64_t s1[random_lanes];
+};
+
+uint64_t splitmix64(uint64_t &x) {
+  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+void random_seed(random_state &st, uint64_t seed) {
+  for (std::size_t i = 0; i < random_lanes; ++i) {
+    st.s0[i] = splitmix64(seed);
+    st.s1[i] = splitmix64(seed);
+  }
+}
+
+void random_round(random_state &st, uint64_t out[random_lanes]) {
+  for (std::size_t i = 0; i < random_lanes; ++i) {
+    uint64_t x = st.s0[i];
+    uint64_t y = st.s1[i];
+    st.s0[i] = y;
+    x ^= x << 23;
+    st.s1[i] = x ^ y ^ (x >> 17) ^ (y >> 26);
+    out[i] = st.s1[i] + y;
+  }
+}
+
+void random_tail(random_state &st, uint8_t *p, std::size_t len) {
+  uint64_t out[random_lanes];
+  while (len) {
+    random_round(st, out);
+    std::size_t n = std::min(len, sizeof(out));
+    std::memcpy(p, out, n);
+    p += n;
+    len -= n;
+  }
+}
+
+void fill_incrementing_generic(uint8_t *p, std::size_t len, uint8_t start) {
+  for (std::size_t i = 0; i < len; ++i) {
+    p[i] = static_cast<uint8_t>(start + i);
+  }
+}
+
+void fill_random_generic(uint8_t *p, std::size_t len, random_state &st) {
+  random_tail(st, p, len);
+}
+
+compare_result compare_generic(const uint8_t *a, const uint8_t *b,
+                               std::size_t len, std::size_t base,
+                               compare_result r) {
+  for (std::size_t i = 0; i < len; ++i) {
+    if (a[i] != b[i]) {
+      if (!r.mismatches) r.first_mismatch = base + i;
+      ++r.mismatches;
+    }
+  }
+  return r;
+}
+
+compare_result compare_incrementing_generic(const uint8_t *p,
+                                            std::size_t len, uint8_t start,
+                                            std::size_t base,
+                                            compare_result r) {
+  for (std::size_t i = 0; i < len; ++i) {
+    if (p[i] != static_cast<uint8_t>(start + i)) {
+      if (!r.mismatches) r.first_mismatch = base + i;
+      ++r.mismatches;
+    }
+  }
+  return r;
+}
+
+uint32_t crc32c_table[256];
+
+bool crc32c_table_init() {
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0x82f63b78 & (0 - (c & 1)));
+    crc32c_table[i] = c;
+  }
+  return true;
+}
+
+uint32_t crc32c_generic(const uint8_t *p, std::size_t len, uint32_t crc) {
+  static const bool init = crc32c_table_init();
+  (void)init;
+  for (std::size_t i = 0; i < len; ++i)
+    crc = crc32c_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#ifdef BUFFER_OPS_X86
+
+__attribute__((target("avx2")))
+void fill_incrementing_avx2(uint8_t *p, std::size_t len, uint8_t start) {
+  const __m256i step = _mm256_set1_epi8(32);
+  __m256i v = _mm256_add_epi8(
+      _mm256_set1_epi8(static_cast<char>(start)),
+      _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                       16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+                       30, 31));
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p + i), v);
+    v = _mm256_add_epi8(v, step);
+  }
+  fill_incrementing_generic(p + i, len - i, static_cast<uint8_t>(start + i));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void fill_incrementing_avx512(uint8_t *p, std::size_t len, uint8_t start) {
+  alignas(64) uint8_t init[64];
+  fill_incrementing_generic(init, sizeof(init), start);
+  const __m512i step = _mm512_set1_epi8(64);
+  __m512i v = _mm512_load_si512(init);
+  std::size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    _mm512_storeu_si512(p + i, v);
+    v = _mm512_add_epi8(v, step);
+  }
+  fill_incrementing_generic(p + i, len - i, static_cast<uint8_t>(start + i));
+}
+
+__attribute__((target("avx2")))
+void fill_random_avx2(uint8_t *p, std::size_t len, random_state &st) {
+  __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(st.s0));
+  __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(st.s1));
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i x = s0;
+    __m256i y = s1;
+    s0 = y;
+    x = _mm256_xor_si256(x, _mm256_slli_epi64(x, 23));
+    s1 = _mm256_xor_si256(
+        _mm256_xor_si256(x, y),
+        _mm256_xor_si256(_mm256_srli_epi64(x, 17), _mm256_srli_epi64(y, 26)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p + i),
+                        _mm256_add_epi64(s1, y));
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(st.s0), s0);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(st.s1), s1);
+  random_tail(st, p + i, len - i);
+}
+
+__attribute__((target("avx2")))
+compare_result compare_avx2(const uint8_t *a, const uint8_t *b,
+                            std::size_t len) {
+  compare_result r = {len, 0};
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    uint32_t ne = ~static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    if (ne) {
+      if (!r.mismatches) r.first_mismatch = i + __builtin_ctz(ne);
+      r.mismatches += __builtin_popcount(ne);
+    }
+  }
+  return compare_generic(a + i, b + i, len - i, i, r);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+compare_result compare_avx512(const uint8_t *a, const uint8_t *b,
+                              std::size_t len) {
+  compare_result r = {len, 0};
+  std::size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    __m512i va = _mm512_loadu_si512(a + i);
+    __m512i vb = _mm512_loadu_si512(b + i);
+    uint64_t ne = _mm512_cmpneq_epi8_mask(va, vb);
+    if (ne) {
+      if (!r.mismatches) r.first_mismatch = i + __builtin_ctzll(ne);
+      r.mismatches += __builtin_popcountll(ne);
+    }
+  }
+  return compare_generic(a + i, b + i, len - i, i, r);
+}
+
+__attribute__((target("avx2")))
+compare_result compare_incrementing_avx2(const uint8_t *p, std::size_t len,
+                                         uint8_t start) {
+  compare_result r = {len, 0};
+  const __m256i step = _mm256_set1_epi8(32);
+  __m256i v = _mm256_add_epi8(
+      _mm256_set1_epi8(static_cast<char>(start)),
+      _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                       16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+                       30, 31));
+  std::size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i vp = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    uint32_t ne = ~static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(vp, v)));
+    if (ne) {
+      if (!r.mismatches) r.first_mismatch = i + __builtin_ctz(ne);
+      r.mismatches += __builtin_popcount(ne);
+    }
+    v = _mm256_add_epi8(v, step);
+  }
+  return compare_incrementing_generic(p + i, len - i,
+                                      static_cast<uint8_t>(start + i), i, r);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+compare_result compare_incrementing_avx512(const uint8_t *p, std::size_t len,
+                                           uint8_t start) {
+  compare_result r = {len, 0};
+  alignas(64) uint8_t init[64];
+  fill_incrementing_generic(init, sizeof(init), start);
+  const __m512i step = _mm512_set1_epi8(64);
+  __m512i v = _mm512_load_si512(init);
+  std::size_t i = 0;
+  for (; i + 64 <= len; i += 64) {
+    __m512i vp = _mm512_loadu_si512(p + i);
+    uint64_t ne = _mm512_cmpneq_epi8_mask(vp, v);
+    if (ne) {
+      if (!r.mismatches) r.first_mismatch = i + __builtin_ctzll(ne);
+      r.mismatches += __builtin_popcountll(ne);
+    }
+    v = _mm512_add_epi8(v, step);
+  }
+  return compare_incrementing_generic(p + i, len - i,
+                                      static_cast<uint8_t>(start + i), i, r);
+}
+
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(const uint8_t *p, std::size_t len, uint32_t crc) {
+#ifdef __x86_64__
+  uint64_t c = crc;
+  for (; len >= 8; p += 8, len -= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    c = _mm_crc32_u64(c, v);
+  }
+  crc = static_cast<uint32_t>(c);
+#endif  // __x86_64__
+  for (; len >= 4; p += 4, len -= 4) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    crc = _mm_crc32_u32(crc, v);
+  }
+  for (; len; ++p, --len) crc = _mm_crc32_u8(crc, *p);
+  return crc;
+}
+
+#endif  // BUFFER_OPS_X86
+
+enum class level { generic, avx2, avx512 };
+
+struct kernels {
+  level isa;
+  bool sse42;
+  bool waitpkg;
+};
+
+const kernels &select() {
+  static const kernels k = []() {
+    kernels r = {level::generic, false, false};
+#ifdef BUFFER_OPS_X86
+    unsigned int eax, ebx, ecx, edx;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw"))
+      r.isa = level::avx512;
+    else if (__builtin_cpu_supports("avx2"))
+      r.isa = level::avx2;
+    r.sse42 = __builtin_cpu_supports("sse4.2");
+    // CPUID.(EAX=7,ECX=0):ECX[5] - UMONITOR/UMWAIT/TPAUSE
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+      r.waitpkg = (ecx >> 5) & 1;
+#endif  // BUFFER_OPS_X86
+    return r;
+  }();
+  return k;
+}
+
+uint64_t load(const volatile void *addr, unsigned width) {
+  switch (width) {
+    case 1:
+      return *static_cast<const volatile uint8_t *>(addr);
+    case 2:
+      return *static_cast<const volatile uint16_t *>(addr);
+    case 4:
+      return *static_cast<const volatile uint32_t *>(addr);
+    default:
+      return *static_cast<const volatile uint64_t *>(addr);
+  }
+}
+
+inline void cpu_relax() {
+#ifdef BUFFER_OPS_X86
+  _mm_pause();
+#endif  // BUFFER_OPS_X86
+}
+
+typedef std::chrono::steady_clock wait_clock;
+
+// Length of the busy-poll phase of the portable wait, and the bounds
+// of the sleep interval that follows it. The interval starts small
+// and doubles on every miss, so a status word that is written soon
+// after the spin phase ends is still seen within a few microseconds.
+const std::chrono::nanoseconds WAIT_SPIN_TIME{20000};
+const std::chrono::nanoseconds WAIT_SLEEP_MIN{1000};
+const std::chrono::nanoseconds WAIT_SLEEP_MAX{100000};
+
+bool wait_generic(const volatile void *addr, unsigned width, uint64_t mask,
+                  uint64_t value, wait_clock::time_point deadline,
+                  wait_stats &st) {
+  wait_clock::time_point spin_end = wait_clock::now() + WAIT_SPIN_TIME;
+  std::chrono::nanoseconds sleep = WAIT_SLEEP_MIN;
+
+  while (true) {
+    for (int i = 0; i < 64; ++i) {
+      if ((load(addr, width) & mask) == value) return true;
+      cpu_relax();
+    }
+
+    wait_clock::time_point now = wait_clock::now();
+    if (now >= deadline) break;
+    if (now < spin_end) continue;
+
+    std::chrono::nanoseconds left = deadline - now;
+    std::this_thread::sleep_for(std::min(sleep, left));
+    sleep = std::min(sleep * 2, WAIT_SLEEP_MAX);
+    ++st.wakeups;
+  }
+  return (load(addr, width) & mask) == value;
+}
+
+#ifdef BUFFER_OPS_X86
+// Maximum TSC ticks for a single UMWAIT. The OS may impose a lower
+// limit through IA32_UMWAIT_CONTROL; either way, the wait returns
+// periodically so that the overall deadline can be enforced.
+const uint64_t UMWAIT_TSC_SLICE = 100000;
+
+__attribute__((target("waitpkg"))) bool wait_umwait(
+    const volatile void *addr, unsigned width, uint64_t mask, uint64_t value,
+    wait_clock::time_point deadline, wait_stats &st) {
+  void *line = const_cast<void *>(addr);
+
+  while (true) {
+    // Arm the monitor before re-checking the value, so that a write
+    // landing between the check and UMWAIT still wakes us.
+    _umonitor(line);
+    if ((load(addr, width) & mask) == value) return true;
+    if (wait_clock::now() >= deadline) break;
+    // Control 1 selects C0.1, the lighter state with the faster wakeup.
+    _umwait(1, __rdtsc() + UMWAIT_TSC_SLICE);
+    ++st.wakeups;
+  }
+  return (load(addr, width) & mask) == value;
+}
+#endif  // BUFFER_OPS_X86
+
+}  // end of anonymous namespace
+
+void fill_incrementing(void *buf, std::size_t len, uint8_t start) {
+  uint8_t *p = static_cast<uint8_t *>(buf);
+#ifdef BUFFER_OPS_X86
+  switch (select().isa) {
+    case level::avx512:
+      return fill_incrementing_avx512(p, len, start);
+    case level::avx2:
+      return fill_incrementing_avx2(p, len, start);
+    default:
+      break;
+  }
+#endif  // BUFFER_OPS_X86
+  fill_incrementing_generic(p, len, start);
+}
+
+void fill_prbs31(void *buf, std::size_t len, uint32_t seed) {
+  uint8_t *p = static_cast<uint8_t *>(buf);
+  uint32_t r = seed & 0x7fffffff;
+  if (!r) r = 0x7fffffff;
+
+  // Bit 0 of r holds the most recent output bit. Up to 28 new bits
+  // depend only on bits already in r, so produce 16 at a time.
+  while (len) {
+    uint32_t bits = ((r >> 15) ^ (r >> 12)) & 0xffff;
+    r = ((r << 16) | bits) & 0x7fffffff;
+    *p++ = static_cast<uint8_t>(bits >> 8);
+    if (!--len) break;
+    *p++ = static_cast<uint8_t>(bits);
+    --len;
+  }
+}
+
+void fill_random(void *buf, std::size_t len, uint64_t seed) {
+  uint8_t *p = static_cast<uint8_t *>(buf);
+  random_state st;
+  random_seed(st, seed);
+#ifdef BUFFER_OPS_X86
+  if (select().isa != level::generic) return fill_random_avx2(p, len, st);
+#endif  // BUFFER_OPS_X86
+  fill_random_generic(p, len, st);
+}
+
+compare_result compare(const void *a, const void *b, std::size_t len) {
+  const uint8_t *pa = static_cast<const uint8_t *>(a);
+  const uint8_t *pb = static_cast<const uint8_t *>(b);
+#ifdef BUFFER_OPS_X86
+  switch (select().isa) {
+    case level::avx512:
+      return compare_avx512(pa, pb, len);
+    case level::avx2:
+      return compare_avx2(pa, pb, len);
+    default:
+      break;
+  }
+#endif  // BUFFER_OPS_X86
+  return compare_generic(pa, pb, len, 0, compare_result{len, 0});
+}
+
+compare_result compare_incrementing(const void *buf, std::size_t len,
+                                    uint8_t start) {
+  const uint8_t *p = static_cast<const uint8_t *>(buf);
+#ifdef BUFFER_OPS_X86
+  switch (select().isa) {
+    case level::avx512:
+      return compare_incrementing_avx512(p, len, start);
+    case level::avx2:
+      return compare_incrementing_avx2(p, len, start);
+    default:
+      break;
+  }
+#endif  // BUFFER_OPS_X86
+  return compare_incrementing_generic(p, len, start, 0,
+                                      compare_result{len, 0});
+}
+
+uint32_t crc32c(const void *buf, std::size_t len, uint32_t crc) {
+  const uint8_t *p = static_cast<const uint8_t *>(buf);
+  crc = ~crc;
+#ifdef BUFFER_OPS_X86
+  if (select().sse42) return ~crc32c_sse42(p, len, crc);
+#endif  // BUFFER_OPS_X86
+  return ~crc32c_generic(p, len, crc);
+}
+
+bool wait_for(const volatile void *addr, unsigned width, uint64_t mask,
+              uint64_t value, std::chrono::nanoseconds timeout,
+              wait_stats *stats) {
+  wait_stats st = {std::chrono::nanoseconds(0), 0, false};
+  wait_clock::time_point begin = wait_clock::now();
+  wait_clock::time_point deadline = begin + timeout;
+  bool res;
+
+  if (width > 8 || (width & (width - 1))) width = 8;
+  if (width < 8) mask &= (uint64_t(1) << (8 * width)) - 1;
+
+#ifdef BUFFER_OPS_X86
+  if (select().waitpkg) {
+    st.umwait = true;
+    res = wait_umwait(addr, width, mask, value, deadline, st);
+  } else {
+    res = wait_generic(addr, width, mask, value, deadline, st);
+  }
+#else
+  res = wait_generic(addr, width, mask, value, deadline, st);
+#endif  // BUFFER_OPS_X86
+
+  st.latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      wait_clock::now() - begin);
+  if (stats) *stats = st;
+  return res;
+}
+
+bool has_umwait() { return select().waitpkg; }
+
+const char *isa() {
+  switch (select().isa) {
+    case level::avx512:
+      return "avx512";
+    case level::avx2:
+      return "avx2";
+    default:
+      return "generic";
+  }
+}
+
+}  // end of namespace buffer_ops
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
@@ -0,0 +1,312 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include <opae/cxx/core/perf_sampler.h>
+
+namespace opae {
+namespace fpga {
+namespace types {
+
+namespace {
+
+struct group_counters {
+  perf_sampler::group grp;
+  std::vector<const char *> names;
+};
+
+// The counters of each group, as named by the FME perf feature in
+// sysfs. Counters missing on a given FME are skipped.
+const group_counters perf_counters[] = {
+    {perf_sampler::group::cache,
+     {"read_hit", "write_hit", "read_miss", "write_miss", "hold_request",
+      "data_write_port_contention", "tag_write_port_contention",
+      "tx_req_stall", "rx_req_stall", "rx_eviction"}},
+    {perf_sampler::group::fabric,
+     {"mmio_read", "mmio_write", "pcie0_read", "pcie0_write", "pcie1_read",
+      "pcie1_write", "upi_read", "upi_write"}},
+    {perf_sampler::group::iommu,
+     {"iotlb_4k_hit", "iotlb_2m_hit", "iotlb_1g_hit", "iotlb_4k_miss",
+      "iotlb_2m_miss", "iotlb_1g_miss", "slpwc_l3_hit", "slpwc_l3_miss",
+      "slpwc_l4_hit", "slpwc_l4_miss", "rcc_hit", "rcc_miss",
+      "afu0/read_transaction", "afu0/write_transaction",
+      "afu0/devtlb_read_hit", "afu0/devtlb_write_hit", "afu0/devtlb_4k_fill",
+      "afu0/devtlb_2m_fill", "afu0/devtlb_1g_fill"}},
+};
+
+// Look up a (possibly nested) child of dir, one path component
+// at a time.
+sysobject::ptr_t get_child(sysobject::ptr_t dir, const std::string &path) {
+  size_t begin = 0;
+  size_t end;
+  sysobject::ptr_t obj = dir;
+
+  while (obj && begin < path.size()) {
+    end = path.find('/', begin);
+    if (end == std::string::npos) end = path.size();
+    obj = obj->get(path.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return obj;
+}
+
+}  // end of anonymous namespace
+
+perf_sampler::perf_sampler(handle::ptr_t fme, size_t capacity,
+                           unsigned counter_bits)
+    : fme_(fme),
+      mask_(counter_bits >= 64 ? UINT64_MAX
+                               : (uint64_t(1) << counter_bits) - 1),
+      ring_(capacity),
+      head_(0),
+      count_(0),
+      dropped_(0),
+      interval_(0),
+      stop_(true) {}
+
+perf_sampler::~perf_sampler() { stop(); }
+
+perf_sampler::ptr_t perf_sampler::open(token::ptr_t fme, size_t capacity,
+                                       unsigned counter_bits) {
+  ptr_t sampler;
+  auto h = handle::open(fme, FPGA_OPEN_SHARED);
+
+  sampler.reset(new perf_sampler(h, capacity, counter_bits));
+  sampler->resolve();
+  if (sampler->counters_.empty()) {
+    sampler.reset();
+    return sampler;
+  }
+
+  sampler->read(sampler->last_);
+  sampler->totals_.assign(sampler->last_.size(), 0);
+  return sampler;
+}
+
+const char *perf_sampler::group_name(group g) {
+  switch (g) {
+    case group::cache:
+      return "cache";
+    case group::fabric:
+      return "fabric";
+    case group::iommu:
+      return "iommu";
+  }
+  return "";
+}
+
+int perf_sampler::find(group g, const std::string &name) const {
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    if (counters_[i].grp == g && counters_[i].name == name) return i;
+  }
+  return -1;
+}
+
+void perf_sampler::resolve() {
+  for (auto &gc : perf_counters) {
+    auto dir = sysobject::get(
+        fme_, std::string("*perf/") + group_name(gc.grp), FPGA_OBJECT_GLOB);
+    if (!dir) continue;
+
+    counter_group cg;
+    cg.grp = gc.grp;
+    cg.freeze = get_child(dir, "freeze");
+    cg.first = counters_.size();
+    for (auto name : gc.names) {
+      auto obj = get_child(dir, name);
+      if (obj) {
+        counters_.push_back({gc.grp, name});
+        cg.objects.push_back(obj);
+      }
+    }
+    if (!cg.objects.empty()) groups_.push_back(cg);
+  }
+}
+
+void perf_sampler::read(const counter_group &cg,
+                        std::vector<uint64_t> &values) {
+  // Freeze the group so that its counters are read as one
+  // consistent snapshot.
+  if (cg.freeze) cg.freeze->write64(1);
+  try {
+    for (size_t i = 0; i < cg.objects.size(); ++i) {
+      values[cg.first + i] = cg.objects[i]->read64(FPGA_OBJECT_SYNC);
+    }
+  } catch (...) {
+    if (cg.freeze) cg.freeze->write64(0);
+    throw;
+  }
+  if (cg.freeze) cg.freeze->write64(0);
+}
+
+void perf_sampler::read(std::vector<uint64_t> &values) {
+  values.resize(counters_.size());
+  for (auto &cg : groups_) {
+    read(cg, values);
+  }
+}
+
+perf_sampler::sample perf_sampler::take() {
+  std::lock_guard<std::mutex> lock(read_lock_);
+  sample s;
+
+  s.time = clock::now();
+  read(s.values);
+  s.deltas.resize(s.values.size());
+  for (size_t i = 0; i < s.values.size(); ++i) {
+    // Modular subtraction gives the right delta across a wrap of
+    // the hardware counter.
+    s.deltas[i] = (s.values[i] - last_[i]) & mask_;
+    totals_[i] += s.deltas[i];
+  }
+  last_ = s.values;
+  return s;
+}
+
+void perf_sampler::push(const sample &s) {
+  std::lock_guard<std::mutex> lock(ring_lock_);
+  if (ring_.empty()) return;
+  if (count_ < ring_.size()) {
+    ring_[(head_ + count_) % ring_.size()] = s;
+    ++count_;
+  } else {
+    ring_[head_] = s;
+    head_ = (head_ + 1) % ring_.size();
+    ++dropped_;
+  }
+}
+
+perf_sampler::sample perf_sampler::sample_now() {
+  sample s = take();
+  push(s);
+  return s;
+}
+
+std::vector<uint64_t> perf_sampler::read_group(group g) {
+  // The lock keeps a background sample from unfreezing the
+  // group while it is being read.
+  std::lock_guard<std::mutex> lock(read_lock_);
+  std::vector<uint64_t> values(counters_.size(), 0);
+
+  for (auto &cg : groups_) {
+    if (cg.grp == g) read(cg, values);
+  }
+  return values;
+}
+
+void perf_sampler::start(std::chrono::microseconds interval) {
+  std::unique_lock<std::mutex> lock(thread_lock_);
+  interval_ = interval;
+  if (!stop_) return;
+
+  // The thread may have stopped by itself after an error.
+  if (thread_.joinable()) {
+    lock.unlock();
+    thread_.join();
+    lock.lock();
+  }
+  stop_ = false;
+  error_ = nullptr;
+  thread_ = std::thread(&perf_sampler::run, this);
+}
+
+void perf_sampler::stop() {
+  {
+    std::lock_guard<std::mutex> lock(thread_lock_);
+    if (!thread_.joinable()) return;
+    stop_ = true;
+  }
+  wake_.notify_all();
+  thread_.join();
+}
+
+bool perf_sampler::running() const {
+  std::lock_guard<std::mutex> lock(thread_lock_);
+  return !stop_;
+}
+
+std::exception_ptr perf_sampler::error() const {
+  std::lock_guard<std::mutex> lock(thread_lock_);
+  return error_;
+}
+
+void perf_sampler::run() {
+  std::unique_lock<std::mutex> lock(thread_lock_);
+  clock::time_point next = clock::now() + interval_;
+
+  while (!wake_.wait_until(lock, next, [this] { return stop_; })) {
+    lock.unlock();
+    try {
+      sample_now();
+    } catch (...) {
+      lock.lock();
+      error_ = std::current_exception();
+      stop_ = true;
+      break;
+    }
+    lock.lock();
+
+    // Keep a fixed rate, but don't try to catch up with samples
+    // missed while we were descheduled.
+    next += interval_;
+    clock::time_point now = clock::now();
+    if (next < now) next = now + interval_;
+  }
+}
+
+std::vector<perf_sampler::sample> perf_sampler::samples() const {
+  std::lock_guard<std::mutex> lock(ring_lock_);
+  std::vector<sample> v;
+  v.reserve(count_);
+  for (size_t i = 0; i < count_; ++i) {
+    v.push_back(ring_[(head_ + i) % ring_.size()]);
+  }
+  return v;
+}
+
+std::vector<perf_sampler::sample> perf_sampler::drain() {
+  std::lock_guard<std::mutex> lock(ring_lock_);
+  std::vector<sample> v;
+  v.reserve(count_);
+  for (size_t i = 0; i < count_; ++i) {
+    v.push_back(std::move(ring_[(head_ + i) % ring_.size()]));
+  }
+  head_ = 0;
+  count_ = 0;
+  return v;
+}
+
+uint64_t perf_sampler::dropped() const {
+  std::lock_guard<std::mutex> lock(ring_lock_);
+  return dropped_;
+}
+
+std::vector<uint64_t> perf_sampler::totals() const {
+  std::lock_guard<std::mutex> lock(read_lock_);
+  return totals_;
+}
+
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
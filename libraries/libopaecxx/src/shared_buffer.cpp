@@ -37,6 +37,12 @@ shared_buffer::~shared_buffer() { release(); }
 
 shared_buffer::ptr_t shared_buffer::allocate(handle::ptr_t handle, size_t len,
                                              bool read_only) {
+  return allocate(handle, len, read_only, placement::device);
+}
+
+shared_buffer::ptr_t shared_buffer::allocate(handle::ptr_t handle, size_t len,
+                                             bool read_only, placement where,
+                                             int numa_node) {
   ptr_t p;
 
   if (!handle) {
@@ -56,6 +62,23 @@ shared_buffer::ptr_t shared_buffer::allocate(handle::ptr_t handle, size_t len,
     flags |= FPGA_BUF_READ_ONLY;
   }
 
+  switch (where) {
+    case placement::device:
+      break;
+    case placement::node:
+      if (numa_node < 0 || numa_node > 0xff) {
+        throw invalid_param(OPAECXX_HERE);
+      }
+      flags |= FPGA_BUF_NUMA_NODE(numa_node);
+      break;
+    case placement::any:
+      flags |= FPGA_BUF_NUMA_ANY;
+      break;
+    case placement::interleave:
+      flags |= FPGA_BUF_NUMA_INTERLEAVE;
+      break;
+  }
+
   fpga_result res = fpgaPrepareBuffer(
       handle->c_type(), len, reinterpret_cast<void **>(&virt), &wsid, flags);
   ASSERT_FPGA_OK(res);
@@ -108,10 +131,39 @@ void shared_buffer::release() {
 
 void shared_buffer::fill(int c) { std::fill(virt_, virt_ + len_, c); }
 
+void shared_buffer::fill(shared_buffer::pattern p, uint64_t seed) {
+  switch (p) {
+    case pattern::incrementing:
+      buffer_ops::fill_incrementing(virt_, len_, static_cast<uint8_t>(seed));
+      break;
+    case pattern::prbs31:
+      buffer_ops::fill_prbs31(virt_, len_, static_cast<uint32_t>(seed));
+      break;
+    case pattern::random:
+      buffer_ops::fill_random(virt_, len_, seed);
+      break;
+  }
+}
+
 int shared_buffer::compare(shared_buffer::ptr_t other, size_t len) const {
   return std::equal(virt_, virt_ + len, other->virt_) ? 0 : 1;
 }
 
+buffer_ops::compare_result shared_buffer::compare_detail(
+    shared_buffer::ptr_t other, size_t len) const {
+  if (!other || len > len_ || len > other->len_) {
+    throw except(OPAECXX_HERE);
+  }
+  return buffer_ops::compare(virt_, other->virt_, len);
+}
+
+uint32_t shared_buffer::crc32c(size_t offset, size_t len) const {
+  if (offset > len_ || len > len_ - offset) {
+    throw except(OPAECXX_HERE);
+  }
+  return buffer_ops::crc32c(virt_ + offset, len);
+}
+
 shared_buffer::shared_buffer(handle::ptr_t handle, size_t len, uint8_t *virt,
                              uint64_t wsid, uint64_t io_address)
     : handle_(handle),
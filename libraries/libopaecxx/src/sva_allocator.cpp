@@ -0,0 +1,180 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include <opae/buffer.h>
+#include <opae/cxx/core/sva_allocator.h>
+
+#include <iterator>
+
+namespace opae {
+namespace fpga {
+namespace types {
+
+constexpr std::size_t sva_memory::arena_size;
+constexpr std::size_t sva_memory::granularity;
+
+void *sva_memory::arena::take(std::size_t len) {
+  for (auto it = free.begin(); it != free.end(); ++it) {
+    if (it->second < len) continue;
+    std::size_t offset = it->first;
+    std::size_t rest = it->second - len;
+    free.erase(it);
+    if (rest) free[offset + len] = rest;
+    used += len;
+    return base + offset;
+  }
+  return nullptr;
+}
+
+void sva_memory::arena::give(std::size_t offset, std::size_t len) {
+  used -= len;
+
+  // Coalesce with the free ranges on either side.
+  auto next = free.lower_bound(offset);
+  if (next != free.end() && offset + len == next->first) {
+    len += next->second;
+    next = free.erase(next);
+  }
+  if (next != free.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += len;
+      return;
+    }
+  }
+  free[offset] = len;
+}
+
+sva_memory::sva_memory(handle::ptr_t handle, uint32_t pasid)
+    : handle_(handle), pasid_(pasid) {}
+
+sva_memory::~sva_memory() { free_all(); }
+
+void sva_memory::free_all() {
+  std::lock_guard<std::mutex> guard(lock_);
+  for (auto &b : wsids_) {
+    release(b.second);
+  }
+  wsids_.clear();
+  for (auto &a : arenas_) {
+    release(a.wsid);
+  }
+  arenas_.clear();
+  blocks_.clear();
+}
+
+sva_memory::ptr_t sva_memory::open(handle::ptr_t handle) {
+  ptr_t p;
+  uint32_t pasid = handle->bind_sva();
+
+  if (pasid != (uint32_t)-1) p.reset(new sva_memory(handle, pasid));
+  return p;
+}
+
+void *sva_memory::prepare(std::size_t len, uint64_t *wsid) {
+  void *addr = nullptr;
+
+  auto res = fpgaPrepareBuffer(handle_->c_type(), len, &addr, wsid,
+                               FPGA_BUF_SVA | FPGA_BUF_QUIET);
+  return res == FPGA_OK ? addr : nullptr;
+}
+
+void sva_memory::release(uint64_t wsid) {
+  fpgaReleaseBuffer(handle_->c_type(), wsid);
+}
+
+std::size_t sva_memory::num_arenas() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return arenas_.size();
+}
+
+void *sva_memory::allocate(std::size_t len) {
+  void *addr;
+  uint64_t wsid = 0;
+
+  if (!len) len = 1;
+
+  if (len > arena_size / 2) {
+    addr = prepare(len, &wsid);
+    if (!addr) throw std::bad_alloc();
+
+    std::lock_guard<std::mutex> guard(lock_);
+    wsids_[addr] = wsid;
+    return addr;
+  }
+
+  len = (len + granularity - 1) & ~(granularity - 1);
+
+  std::lock_guard<std::mutex> guard(lock_);
+  for (auto &a : arenas_) {
+    addr = a.take(len);
+    if (addr) {
+      blocks_[addr] = std::make_pair(&a, len);
+      return addr;
+    }
+  }
+
+  addr = prepare(arena_size, &wsid);
+  if (!addr) throw std::bad_alloc();
+
+  arenas_.push_back(arena());
+  arena &a = arenas_.back();
+  a.base = static_cast<uint8_t *>(addr);
+  a.wsid = wsid;
+  a.used = 0;
+  a.free[0] = arena_size;
+
+  addr = a.take(len);
+  blocks_[addr] = std::make_pair(&a, len);
+  return addr;
+}
+
+void sva_memory::deallocate(void *p) {
+  uint64_t wsid;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto b = blocks_.find(p);
+    if (b != blocks_.end()) {
+      arena *a = b->second.first;
+      a->give(static_cast<uint8_t *>(p) - a->base, b->second.second);
+      blocks_.erase(b);
+
+      // Keep the last arena around for the next small request.
+      if (a->used || arenas_.size() == 1) return;
+      wsid = a->wsid;
+      arenas_.remove_if([a](const arena &x) { return &x == a; });
+    } else {
+      auto it = wsids_.find(p);
+      if (it == wsids_.end()) return;
+      wsid = it->second;
+      wsids_.erase(it);
+    }
+  }
+  release(wsid);
+}
+
+}  // end of namespace types
+}  // end of namespace fpga
+}  // end of namespace opae
@@ -606,13 +606,48 @@ STATIC int opae_vfio_iova_reserve(struct opae_vfio *v,
 				  uint64_t *iova)
 {
 	uint64_t page_size;
+	int res;
 
 	page_size = sysconf(_SC_PAGE_SIZE);
 	*size = page_size + ((*size - 1) & ~(page_size - 1));
 
-	return mem_alloc_get(&v->iova_alloc,
-			     iova,
-			     *size);
+	// A device sharing another's container allocates from
+	// the owner's IOVA space.
+	if (!v->cont_owner)
+		return mem_alloc_get(&v->iova_alloc, iova, *size);
+
+	if (pthread_mutex_lock(&v->cont_owner->lock)) {
+		ERR("pthread_mutex_lock() failed\n");
+		return 1;
+	}
+
+	res = mem_alloc_get(&v->cont_owner->iova_alloc, iova, *size);
+
+	if (pthread_mutex_unlock(&v->cont_owner->lock))
+		ERR("pthread_mutex_unlock() failed\n");
+
+	return res;
+}
+
+STATIC int opae_vfio_iova_release(struct opae_vfio *v,
+				  uint64_t iova)
+{
+	int res;
+
+	if (!v->cont_owner)
+		return mem_alloc_put(&v->iova_alloc, iova);
+
+	if (pthread_mutex_lock(&v->cont_owner->lock)) {
+		ERR("pthread_mutex_lock() failed\n");
+		return 1;
+	}
+
+	res = mem_alloc_put(&v->cont_owner->iova_alloc, iova);
+
+	if (pthread_mutex_unlock(&v->cont_owner->lock))
+		ERR("pthread_mutex_unlock() failed\n");
+
+	return res;
 }
 
 STATIC struct opae_vfio_buffer *
@@ -652,7 +687,7 @@ opae_vfio_destroy_buffer(struct opae_vfio *v,
 		ERR("munmap(%p, %lu) failed\n",
 		    b->buffer_ptr, b->buffer_size);
 
-	if (mem_alloc_put(&v->iova_alloc, b->buffer_iova))
+	if (opae_vfio_iova_release(v, b->buffer_iova))
 		ERR("mem_alloc_put(..., 0x%lx) failed\n",
 		    b->buffer_iova);
 
@@ -679,6 +714,20 @@ opae_vfio_destroy_buffer(struct opae_vfio *v,
 #define FLAGS_1G (FLAGS_4K|MAP_1G_HUGEPAGE|MAP_HUGETLB)
 #endif
 
+/*
+ * Apply the NUMA policy requested by OPAE_VFIO_BUF_NUMA_PREFERRED or
+ * OPAE_VFIO_BUF_NUMA_INTERLEAVE to a freshly-mapped, untouched buffer.
+ * This must happen before VFIO_IOMMU_MAP_DMA, which faults in and pins
+ * the pages. Placement is a performance hint: failure is not fatal.
+ */
+STATIC void opae_vfio_buffer_mbind(uint8_t *vaddr, size_t size, int flags)
+{
+	if (opae_mbind(vaddr, size,
+		       flags & OPAE_VFIO_BUF_NUMA_INTERLEAVE,
+		       OPAE_VFIO_BUF_NUMA_NODE_OF(flags)))
+		ERR("mbind() failed\n");
+}
+
 STATIC int
 opae_vfio_buffer_mmap(struct opae_vfio *v,
 		      size_t *size,
@@ -711,13 +760,17 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 
 		if (vaddr == MAP_FAILED) {
 			ERR("mmap() failed\n");
-			mem_alloc_put(&v->iova_alloc, ioaddr);
+			opae_vfio_iova_release(v, ioaddr);
 			return 2;
 		}
 
+		if (flags & (OPAE_VFIO_BUF_NUMA_PREFERRED |
+			     OPAE_VFIO_BUF_NUMA_INTERLEAVE))
+			opae_vfio_buffer_mbind(vaddr, *size, flags);
+
 	} else if (!buf || !*buf) {
 		ERR("got OPAE_VFIO_BUF_PREALLOCATED, but buf is NULL.\n");
-		mem_alloc_put(&v->iova_alloc, ioaddr);
+		opae_vfio_iova_release(v, ioaddr);
 		return 3;
 	} else {
 		vaddr = *buf;
@@ -733,7 +786,7 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 
 	if (opae_ioctl(v->cont_fd, VFIO_IOMMU_MAP_DMA, &dma_map) < 0) {
 		ERR("ioctl(%d, VFIO_IOMMU_MAP_DMA, &dma_map)\n", v->cont_fd);
-		mem_alloc_put(&v->iova_alloc, ioaddr);
+		opae_vfio_iova_release(v, ioaddr);
 		res = 4;
 		goto out_munmap;
 	}
@@ -741,7 +794,7 @@ opae_vfio_buffer_mmap(struct opae_vfio *v,
 	*node = opae_vfio_create_buffer(vaddr, *size, ioaddr, flags);
 	if (!*node) {
 		ERR("malloc failed\n");
-		mem_alloc_put(&v->iova_alloc, ioaddr);
+		opae_vfio_iova_release(v, ioaddr);
 		res = 5;
 		goto out_unmap_ioctl;
 	}
@@ -1159,9 +1212,48 @@ void opae_vfio_value_cleanup(void *value, void *context)
 	opae_vfio_destroy_buffer(v, b);
 }
 
+/*
+ * Attach the group of v to the container of owner, so that DMA
+ * mappings made in either are visible to both devices. This
+ * fails when the IOMMU can't place both groups in one domain,
+ * eg when they sit behind different IOMMUs.
+ */
+STATIC int opae_vfio_join_container(struct opae_vfio *v,
+				    struct opae_vfio *owner)
+{
+	int res;
+
+	if (owner->cont_owner) {
+		ERR("owner shares a container itself\n");
+		return 12;
+	}
+
+	res = opae_vfio_group_init(&v->group,
+				   opae_vfio_group_for(v->cont_pciaddr));
+	if (res)
+		return res;
+
+	v->cont_fd = dup(owner->cont_fd);
+	if (v->cont_fd < 0) {
+		ERR("dup(%d)\n", owner->cont_fd);
+		return 4;
+	}
+
+	if (opae_ioctl(v->group.group_fd, VFIO_GROUP_SET_CONTAINER, &v->cont_fd)) {
+		ERR("ioctl(%d, VFIO_GROUP_SET_CONTAINER, &cont_fd)\n",
+		    v->group.group_fd);
+		return 13;
+	}
+
+	// The container's IOMMU model was set by the owner.
+	v->cont_owner = owner;
+	return 0;
+}
+
 STATIC int opae_vfio_init(struct opae_vfio *v,
 			  const char *pciaddr,
-			  const char *token)
+			  const char *token,
+			  struct opae_vfio *owner)
 {
 	int res = 0;
 	pthread_mutexattr_t mattr;
@@ -1208,6 +1300,14 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 
 	v->cont_device = opae_strdup("/dev/vfio/vfio");
 	v->cont_pciaddr = opae_strdup(pciaddr);
+
+	if (owner) {
+		res = opae_vfio_join_container(v, owner);
+		if (res)
+			goto out_destroy_container;
+		goto out_device_init;
+	}
+
 	v->cont_fd = opae_open(v->cont_device, O_RDWR);
 	if (v->cont_fd < 0) {
 		ERR("open(\"%s\")\n", v->cont_device);
@@ -1247,6 +1347,7 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 		goto out_destroy_container;
 	}
 
+out_device_init:
 	res = opae_vfio_device_init(&v->device,
 				    v->group.group_fd,
 				    pciaddr,
@@ -1256,6 +1357,18 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 
 	v->cont_ranges = opae_vfio_iova_discover(v);
 
+	if (owner) {
+		// The container's usable IOVA ranges may have shrunk
+		// when our group joined it.
+		if (pthread_mutex_lock(&owner->lock))
+			ERR("pthread_mutex_lock() failed\n");
+		if (mem_alloc_apply_constraint(&owner->iova_alloc,
+					       &v->iova_alloc))
+			ERR("mem_alloc_apply_constraint() failed\n");
+		if (pthread_mutex_unlock(&owner->lock))
+			ERR("pthread_mutex_unlock() failed\n");
+	}
+
 	if (pthread_mutexattr_destroy(&mattr)) {
 		ERR("pthread_mutexattr_destroy()\n");
 		return 9;
@@ -1304,7 +1417,7 @@ int opae_vfio_open(struct opae_vfio *v,
 		return 1;
 	}
 
-	return opae_vfio_init(v, pciaddr, NULL);
+	return opae_vfio_init(v, pciaddr, NULL, NULL);
 }
 
 #define GUID_RE_PATTERN "[0-9a-fA-F]{8}-" \
@@ -1344,7 +1457,20 @@ int opae_vfio_secure_open(struct opae_vfio *v,
 	}
 
 	regfree(&re);
-	return opae_vfio_init(v, pciaddr, token);
+	return opae_vfio_init(v, pciaddr, token, NULL);
+}
+
+int opae_vfio_open_shared(struct opae_vfio *v,
+			  const char *pciaddr,
+			  const char *token,
+			  struct opae_vfio *owner)
+{
+	if (!v || !pciaddr || !owner) {
+		ERR("NULL param\n");
+		return 1;
+	}
+
+	return opae_vfio_init(v, pciaddr, token, owner);
 }
 
 int opae_vfio_apply_group_constraint(struct opae_vfio *new_v,
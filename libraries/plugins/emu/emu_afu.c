@@ -0,0 +1,388 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <byteswap.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "opae_emu.h"
+#include "mock/opae_std.h"
+
+// Host exerciser CSRs (see samples/host_exerciser/host_exerciser.h)
+#define HE_DFH         0x0000
+#define HE_ID_L        0x0008
+#define HE_ID_H        0x0010
+#define HE_DSM_BASEL   0x0110
+#define HE_DSM_BASEH   0x0114
+#define HE_SRC_ADDR    0x0120
+#define HE_DST_ADDR    0x0128
+#define HE_NUM_LINES   0x0130
+#define HE_CTL         0x0138
+#define HE_CFG         0x0140
+#define HE_INTERRUPT0  0x0150
+#define HE_SWTEST_MSG  0x0158
+#define HE_STATUS0     0x0160
+#define HE_STATUS1     0x0168
+#define HE_ERROR       0x0170
+#define HE_INFO0       0x0180
+
+#define HE_CTL_RESETL          (1u << 0)
+#define HE_CTL_START           (1u << 1)
+#define HE_CTL_FORCED_TEST_CMPL (1u << 2)
+
+#define HE_CFG_CONTINUOUS      (1ull << 1)
+#define HE_CFG_TEST_MODE(c)    (((c) >> 2) & 0x7)
+#define HE_CFG_INTR_ON_ERR     (1ull << 28)
+#define HE_CFG_INTR_TEST_MODE  (1ull << 29)
+
+#define HE_MODE_LPBK1 0
+#define HE_MODE_READ  1
+#define HE_MODE_WRITE 2
+#define HE_MODE_TRPUT 3
+
+// API version 3, 64-byte host bus, no atomics.
+#define HE_INFO0_API_VERSION   (3ull << 16)
+#define HE_INFO0_NO_ATOMICS    (1ull << 24)
+#define HE_INFO0_BUS_64B       (1ull << 25)
+
+#define HE_LINE_LOG2 6
+#define HE_LINE_SIZE (1 << HE_LINE_LOG2)
+#define HE_DSM_SIZE  64
+
+#define HE_ERR_DSM 0x1
+#define HE_ERR_SRC 0x2
+#define HE_ERR_DST 0x4
+
+#define EMU_CSR32(__d, __o) \
+	(*(volatile uint32_t *)((__d)->port_mmio + (__o)))
+#define EMU_CSR64(__d, __o) \
+	(*(volatile uint64_t *)((__d)->port_mmio + (__o)))
+
+void emu_afu_init(emu_device *dev)
+{
+	uint64_t *guid = (uint64_t *)emu_cfg.afu_id;
+
+	// AFU DFH: feature type AFU, end of list.
+	EMU_CSR64(dev, HE_DFH) = (1ull << 60) | (1ull << 40);
+	EMU_CSR64(dev, HE_ID_L) = bswap_64(guid[1]);
+	EMU_CSR64(dev, HE_ID_H) = bswap_64(guid[0]);
+
+	if (!emu_cfg.he_lb)
+		return;
+
+	EMU_CSR64(dev, HE_INFO0) = HE_INFO0_BUS_64B |
+				   HE_INFO0_NO_ATOMICS |
+				   HE_INFO0_API_VERSION |
+				   (emu_cfg.clock_mhz & 0xffff);
+}
+
+void emu_afu_reset(emu_device *dev)
+{
+	EMU_CSR64(dev, HE_STATUS0) = 0;
+	EMU_CSR64(dev, HE_STATUS1) = 0;
+	EMU_CSR64(dev, HE_ERROR) = 0;
+	EMU_CSR64(dev, HE_SWTEST_MSG) = 0;
+}
+
+// Translate an AFU address into the buffer that backs it. The
+// whole range must lie within one prepared buffer, as it would
+// need to for an IOMMU mapping.
+STATIC uint8_t *emu_afu_translate(emu_device *dev,
+				  uint64_t iova,
+				  uint64_t len)
+{
+	emu_buffer *b;
+	uint8_t *virt = NULL;
+	int err;
+
+	opae_mutex_lock(err, &dev->lock);
+
+	for (b = dev->buffers ; b ; b = b->next) {
+		if ((iova >= b->iova) &&
+		    (iova + len <= b->iova + b->len)) {
+			virt = b->virt + (iova - b->iova);
+			break;
+		}
+	}
+
+	opae_mutex_unlock(err, &dev->lock);
+
+	return virt;
+}
+
+STATIC void emu_afu_interrupt(emu_device *dev, uint32_t vector)
+{
+	uint64_t one = 1;
+	int err;
+
+	if (vector >= EMU_NUM_IRQS)
+		return;
+
+	opae_mutex_lock(err, &dev->lock);
+
+	if ((dev->irq_fds[vector] >= 0) &&
+	    (write(dev->irq_fds[vector], &one, sizeof(one)) < 0))
+		OPAE_ERR("emu irq %u write failed: %s",
+			 vector, strerror(errno));
+
+	opae_mutex_unlock(err, &dev->lock);
+}
+
+STATIC uint64_t emu_afu_read_lines(const uint8_t *src, uint64_t len)
+{
+	const volatile uint64_t *p = (const volatile uint64_t *)src;
+	uint64_t sum = 0;
+	uint64_t i;
+
+	for (i = 0 ; i < len / sizeof(uint64_t) ; i += HE_LINE_SIZE / sizeof(uint64_t))
+		sum += p[i];
+
+	return sum;
+}
+
+// Run one host exerciser test from the CSRs the host programmed.
+// The data movement is plain memcpy(), so num_ticks measures the
+// emulation itself; the numbers worth tracking are the host-side
+// ones (MMIO, completion polling, interrupt delivery).
+STATIC void emu_afu_run(emu_device *dev)
+{
+	uint64_t cfg = EMU_CSR64(dev, HE_CFG);
+	uint32_t mode = HE_CFG_TEST_MODE(cfg);
+	uint64_t lines = (EMU_CSR64(dev, HE_NUM_LINES) & 0xffffffff) + 1;
+	uint64_t len = lines << HE_LINE_LOG2;
+	uint64_t dsm_addr;
+	volatile uint64_t *dsm;
+	uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	uint64_t ticks;
+	uint32_t errors = 0;
+	uint32_t ctl;
+	struct timespec begin;
+	struct timespec end;
+
+	dsm_addr = ((uint64_t)EMU_CSR32(dev, HE_DSM_BASEH) << 32) |
+		   EMU_CSR32(dev, HE_DSM_BASEL);
+	dsm = (volatile uint64_t *)emu_afu_translate(dev,
+		dsm_addr << HE_LINE_LOG2, HE_DSM_SIZE);
+	if (!dsm) {
+		OPAE_ERR("emu: DSM address 0x%lx is not mapped",
+			 dsm_addr << HE_LINE_LOG2);
+		EMU_CSR64(dev, HE_ERROR) = HE_ERR_DSM;
+		return;
+	}
+
+	if (mode != HE_MODE_WRITE) {
+		src = emu_afu_translate(dev,
+			EMU_CSR64(dev, HE_SRC_ADDR) << HE_LINE_LOG2, len);
+		if (!src)
+			errors |= HE_ERR_SRC;
+	}
+
+	if (mode != HE_MODE_READ) {
+		dst = emu_afu_translate(dev,
+			EMU_CSR64(dev, HE_DST_ADDR) << HE_LINE_LOG2, len);
+		if (!dst)
+			errors |= HE_ERR_DST;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	while (!errors) {
+		switch (mode) {
+		case HE_MODE_LPBK1:
+		case HE_MODE_TRPUT:
+			memcpy(dst, src, len);
+			reads += lines;
+			writes += lines;
+			break;
+		case HE_MODE_READ:
+			emu_afu_read_lines(src, len);
+			reads += lines;
+			break;
+		case HE_MODE_WRITE:
+			memset(dst, 0, len);
+			writes += lines;
+			break;
+		default:
+			errors |= HE_ERR_SRC;
+			break;
+		}
+
+		if (!(cfg & HE_CFG_CONTINUOUS))
+			break;
+
+		ctl = EMU_CSR32(dev, HE_CTL);
+		if (!(ctl & HE_CTL_RESETL) || (ctl & HE_CTL_FORCED_TEST_CMPL))
+			break;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	ticks = (uint64_t)(end.tv_sec - begin.tv_sec) * 1000000000ull;
+	ticks += end.tv_nsec;
+	ticks -= begin.tv_nsec;
+	ticks = (ticks * emu_cfg.clock_mhz) / 1000;
+
+	EMU_CSR64(dev, HE_STATUS0) = (reads << 32) | (writes & 0xffffffff);
+	EMU_CSR64(dev, HE_ERROR) = errors;
+
+	// Fill in the counters before the completion bit, which is
+	// what the host polls on.
+	dsm[1] = (ticks & 0xffffffffffull) |
+		 (((reads >> 32) & 0xff) << 48) |
+		 (((writes >> 32) & 0xff) << 56);
+	dsm[2] = (reads & 0xffffffff) | ((writes & 0xffffffff) << 32);
+	__atomic_store_n(&dsm[0], ((uint64_t)errors << 32) | 1,
+			 __ATOMIC_RELEASE);
+
+	if ((cfg & HE_CFG_INTR_TEST_MODE) ||
+	    (errors && (cfg & HE_CFG_INTR_ON_ERR)))
+		emu_afu_interrupt(dev, EMU_CSR32(dev, HE_INTERRUPT0) >> 16);
+}
+
+// The host may program HE_CTL through fpgaWriteMMIO*() or through
+// the pointer from fpgaMapMMIO(). Writes through the API call
+// emu_afu_mmio_write() and are seen at once; writes through the pointer
+// are seen by polling, every emu_cfg.poll_us.
+STATIC void *emu_afu_worker(void *arg)
+{
+	emu_device *dev = (emu_device *)arg;
+	uint32_t prev_ctl = HE_CTL_RESETL;
+	uint32_t ctl;
+	bool run;
+	int err;
+
+	opae_mutex_lock(err, &dev->lock);
+
+	while (dev->running) {
+		struct timespec ts;
+
+		ctl = EMU_CSR32(dev, HE_CTL);
+		run = dev->start_pending ||
+		      ((ctl & HE_CTL_RESETL) && (ctl & HE_CTL_START) &&
+		       !(prev_ctl & HE_CTL_START));
+		dev->start_pending = false;
+
+		if (!(ctl & HE_CTL_RESETL) && (prev_ctl & HE_CTL_RESETL))
+			emu_afu_reset(dev);
+		prev_ctl = ctl;
+
+		if (run) {
+			opae_mutex_unlock(err, &dev->lock);
+			emu_afu_run(dev);
+			opae_mutex_lock(err, &dev->lock);
+			continue;
+		}
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += (long)emu_cfg.poll_us * 1000;
+		ts.tv_sec += ts.tv_nsec / 1000000000;
+		ts.tv_nsec %= 1000000000;
+
+		pthread_cond_timedwait(&dev->kick, &dev->lock, &ts);
+	}
+
+	opae_mutex_unlock(err, &dev->lock);
+
+	return NULL;
+}
+
+void emu_afu_mmio_write(emu_device *dev, uint64_t offset, size_t size)
+{
+	uint32_t ctl;
+	int err;
+
+	if (!emu_cfg.he_lb ||
+	    (offset > HE_CTL) || (offset + size <= HE_CTL))
+		return;
+
+	ctl = EMU_CSR32(dev, HE_CTL);
+
+	opae_mutex_lock(err, &dev->lock);
+
+	if (!(ctl & HE_CTL_RESETL)) {
+		emu_afu_reset(dev);
+		dev->start_pending = false;
+	} else if (ctl & HE_CTL_START) {
+		dev->start_pending = true;
+	}
+
+	pthread_cond_signal(&dev->kick);
+
+	opae_mutex_unlock(err, &dev->lock);
+}
+
+int emu_afu_start(emu_device *dev)
+{
+	int res = 0;
+	int err;
+
+	opae_mutex_lock(err, &dev->lock);
+
+	if ((dev->open_count++ == 0) && emu_cfg.he_lb) {
+		dev->running = true;
+		dev->start_pending = false;
+		res = pthread_create(&dev->worker, NULL, emu_afu_worker, dev);
+		if (res) {
+			OPAE_ERR("failed to start emu AFU worker: %s",
+				 strerror(res));
+			dev->running = false;
+			--dev->open_count;
+		}
+	}
+
+	opae_mutex_unlock(err, &dev->lock);
+
+	return res;
+}
+
+void emu_afu_stop(emu_device *dev)
+{
+	bool join = false;
+	int err;
+
+	opae_mutex_lock(err, &dev->lock);
+
+	if (dev->open_count && (--dev->open_count == 0) && dev->running) {
+		dev->running = false;
+		pthread_cond_signal(&dev->kick);
+		join = true;
+	}
+
+	opae_mutex_unlock(err, &dev->lock);
+
+	if (join)
+		pthread_join(dev->worker, NULL);
+}
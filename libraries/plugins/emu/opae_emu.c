@@ -0,0 +1,1291 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif // _GNU_SOURCE
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uuid/uuid.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#undef _GNU_SOURCE
+
+#include <opae/fpga.h>
+
+#include "opae_emu.h"
+
+#include "opae_int.h"
+#include "props.h"
+#include "mock/opae_std.h"
+
+#define EMU_TOKEN_MAGIC 0xFF0E5EFF
+#define EMU_HANDLE_MAGIC ~EMU_TOKEN_MAGIC
+#define EMU_EVENT_HANDLE_MAGIC 0x5a7e5ea5
+
+#define EMU_IOVA_BASE 0x100000000ull
+#define EMU_PAGE_SIZE 4096
+#define EMU_ROUND_UP(__n, __a) ((((__n) + (__a) - 1) / (__a)) * (__a))
+
+emu_config emu_cfg = {
+	.num_devices = 1,
+	.poll_us = EMU_DEFAULT_POLL_US,
+	.clock_mhz = EMU_DEFAULT_CLOCK_MHZ,
+};
+
+STATIC emu_device *_emu_devices;
+
+STATIC emu_token *emu_new_token(emu_device *dev,
+				fpga_objtype objtype,
+				emu_token *parent)
+{
+	emu_token *t;
+
+	t = (emu_token *)opae_calloc(1, sizeof(emu_token));
+	if (!t) {
+		OPAE_ERR("Failed to allocate memory for emu_token");
+		return NULL;
+	}
+
+	t->hdr.magic = EMU_TOKEN_MAGIC;
+	t->hdr.vendor_id = EMU_VENDOR_ID;
+	t->hdr.device_id = EMU_DEVICE_ID;
+	t->hdr.subsystem_vendor_id = EMU_SUBSYSTEM_VENDOR;
+	t->hdr.subsystem_device_id = EMU_SUBSYSTEM_DEVICE;
+	t->hdr.segment = dev->bdf.segment;
+	t->hdr.bus = dev->bdf.bus;
+	t->hdr.device = dev->bdf.device;
+	t->hdr.function = dev->bdf.function;
+	t->hdr.interface = FPGA_IFC_SIM_DFL;
+	t->hdr.objtype = objtype;
+	t->hdr.object_id = dev->object_id | (objtype == FPGA_ACCELERATOR);
+	t->device = dev;
+	t->parent = parent;
+
+	uuid_parse(EMU_PR_INTERFACE_ID, t->compat_id);
+	t->bitstream_id = 0x0300000000000000ull | dev->bdf.bus;
+
+	if (objtype == FPGA_ACCELERATOR) {
+		memcpy(t->hdr.guid, emu_cfg.afu_id, sizeof(fpga_guid));
+		t->num_afu_irqs = EMU_NUM_IRQS;
+		t->afu_state = FPGA_ACCELERATOR_UNASSIGNED;
+	} else {
+		memcpy(t->hdr.guid, t->compat_id, sizeof(fpga_guid));
+	}
+
+	t->next = dev->tokens;
+	dev->tokens = t;
+
+	return t;
+}
+
+STATIC void emu_free_device(emu_device *dev)
+{
+	emu_token *t;
+	emu_buffer *b;
+
+	while (dev->tokens) {
+		t = dev->tokens;
+		dev->tokens = t->next;
+		t->hdr.magic = 0;
+		opae_free(t);
+	}
+
+	while (dev->buffers) {
+		b = dev->buffers;
+		dev->buffers = b->next;
+		if (!b->preallocated)
+			munmap(b->virt, b->len);
+		opae_free(b);
+	}
+
+	if (dev->port_mmio)
+		munmap((void *)dev->port_mmio, EMU_PORT_MMIO_SIZE);
+
+	pthread_cond_destroy(&dev->kick);
+	pthread_mutex_destroy(&dev->lock);
+	opae_free(dev);
+}
+
+STATIC emu_device *emu_new_device(uint32_t index)
+{
+	emu_device *dev;
+	emu_token *fme;
+	void *mmio;
+	uint32_t i;
+
+	dev = (emu_device *)opae_calloc(1, sizeof(emu_device));
+	if (!dev) {
+		OPAE_ERR("Failed to allocate memory for emu_device");
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&dev->lock, NULL) ||
+	    pthread_cond_init(&dev->kick, NULL)) {
+		OPAE_ERR("Failed to init emu device lock");
+		opae_free(dev);
+		return NULL;
+	}
+
+	dev->bdf.segment = 0;
+	dev->bdf.bus = 0xe0 + index;
+	dev->bdf.device = 0;
+	dev->bdf.function = 0;
+	dev->object_id = (uint64_t)dev->bdf.bdf << 4;
+	dev->numa_node = 0;
+	dev->next_wsid = 1;
+	dev->next_iova = EMU_IOVA_BASE;
+
+	for (i = 0 ; i < EMU_NUM_IRQS ; ++i)
+		dev->irq_fds[i] = -1;
+
+	mmio = mmap(NULL, EMU_PORT_MMIO_SIZE, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mmio == MAP_FAILED) {
+		OPAE_ERR("Failed to map emu MMIO region");
+		goto out_free;
+	}
+	dev->port_mmio = (volatile uint8_t *)mmio;
+	emu_afu_init(dev);
+
+	fme = emu_new_token(dev, FPGA_DEVICE, NULL);
+	if (!fme)
+		goto out_free;
+
+	if (!emu_new_token(dev, FPGA_ACCELERATOR, fme))
+		goto out_free;
+
+	return dev;
+
+out_free:
+	emu_free_device(dev);
+	return NULL;
+}
+
+int emu_discover(void)
+{
+	emu_device *dev;
+	uint32_t i;
+
+	if (emu_cfg.num_devices > EMU_MAX_DEVICES)
+		emu_cfg.num_devices = EMU_MAX_DEVICES;
+
+	for (i = emu_cfg.num_devices ; i ; --i) {
+		dev = emu_new_device(i - 1);
+		if (!dev)
+			return 1;
+		dev->next = _emu_devices;
+		_emu_devices = dev;
+	}
+
+	return 0;
+}
+
+void emu_free_device_list(void)
+{
+	emu_device *dev;
+
+	while (_emu_devices) {
+		dev = _emu_devices;
+		_emu_devices = dev->next;
+		emu_free_device(dev);
+	}
+}
+
+STATIC emu_token *clone_token(emu_token *src)
+{
+	emu_token *token;
+
+	ASSERT_NOT_NULL_RESULT(src, NULL);
+	if (src->hdr.magic != EMU_TOKEN_MAGIC)
+		return NULL;
+
+	token = (emu_token *)opae_malloc(sizeof(emu_token));
+	if (!token) {
+		OPAE_ERR("Failed to allocate memory for emu_token");
+		return NULL;
+	}
+
+	memcpy(token, src, sizeof(emu_token));
+
+	if (src->parent)
+		token->parent = clone_token(src->parent);
+
+	token->next = NULL;
+
+	return token;
+}
+
+STATIC void free_token(emu_token *t)
+{
+	if (t->parent)
+		free_token(t->parent);
+	t->hdr.magic = 0;
+	opae_free(t);
+}
+
+STATIC emu_token *token_check(fpga_token token)
+{
+	emu_token *t;
+
+	ASSERT_NOT_NULL_RESULT(token, NULL);
+
+	t = (emu_token *)token;
+	if (t->hdr.magic != EMU_TOKEN_MAGIC) {
+		OPAE_ERR("invalid token magic");
+		return NULL;
+	}
+
+	return t;
+}
+
+STATIC emu_handle *handle_check(fpga_handle handle)
+{
+	emu_handle *h;
+
+	ASSERT_NOT_NULL_RESULT(handle, NULL);
+
+	h = (emu_handle *)handle;
+	if (h->magic != EMU_HANDLE_MAGIC) {
+		OPAE_ERR("invalid handle magic");
+		return NULL;
+	}
+
+	return h;
+}
+
+STATIC emu_event_handle *event_handle_check(fpga_event_handle event_handle)
+{
+	emu_event_handle *eh;
+
+	ASSERT_NOT_NULL_RESULT(event_handle, NULL);
+
+	eh = (emu_event_handle *)event_handle;
+	if (eh->magic != EMU_EVENT_HANDLE_MAGIC) {
+		OPAE_ERR("invalid event handle magic");
+		return NULL;
+	}
+
+	return eh;
+}
+
+STATIC emu_handle *handle_check_and_lock(fpga_handle handle)
+{
+	int res;
+	emu_handle *h;
+
+	h = handle_check(handle);
+	if (h)
+		return opae_mutex_lock(res, &h->lock) ? NULL : h;
+
+	return NULL;
+}
+
+STATIC emu_event_handle *
+event_handle_check_and_lock(fpga_event_handle event_handle)
+{
+	int res;
+	emu_event_handle *eh;
+
+	eh = event_handle_check(event_handle);
+	if (eh)
+		return opae_mutex_lock(res, &eh->lock) ? NULL : eh;
+
+	return NULL;
+}
+
+fpga_result __EMU_API__ emu_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
+{
+	fpga_result res = FPGA_EXCEPTION;
+	emu_token *_token;
+	emu_handle *_handle;
+	emu_device *dev;
+	pthread_mutexattr_t mattr;
+	int err;
+
+	ASSERT_NOT_NULL(token);
+	ASSERT_NOT_NULL(handle);
+
+	_token = token_check(token);
+	ASSERT_NOT_NULL(_token);
+
+	dev = _token->device;
+
+	if (_token->hdr.objtype == FPGA_ACCELERATOR) {
+		opae_mutex_lock(err, &dev->lock);
+		if (dev->open_count && !(flags & FPGA_OPEN_SHARED)) {
+			opae_mutex_unlock(err, &dev->lock);
+			return FPGA_BUSY;
+		}
+		opae_mutex_unlock(err, &dev->lock);
+	}
+
+	if (pthread_mutexattr_init(&mattr)) {
+		OPAE_ERR("Failed to init handle mutex attr");
+		return FPGA_EXCEPTION;
+	}
+
+	_handle = opae_calloc(1, sizeof(emu_handle));
+	if (!_handle) {
+		OPAE_ERR("Failed to allocate memory for handle");
+		res = FPGA_NO_MEMORY;
+		goto out_attr_destroy;
+	}
+
+	if (pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE) ||
+	    pthread_mutex_init(&_handle->lock, &mattr)) {
+		OPAE_ERR("Failed to init handle mutex");
+		opae_free(_handle);
+		_handle = NULL;
+		goto out_attr_destroy;
+	}
+
+	_handle->token = clone_token(_token);
+	if (!_handle->token) {
+		res = FPGA_NO_MEMORY;
+		goto out_attr_destroy;
+	}
+
+	_handle->device = dev;
+
+	if (_token->hdr.objtype == FPGA_ACCELERATOR) {
+		if (emu_afu_start(dev)) {
+			res = FPGA_EXCEPTION;
+			goto out_attr_destroy;
+		}
+		_handle->mmio_base = dev->port_mmio;
+		_handle->mmio_size = EMU_PORT_MMIO_SIZE;
+	}
+
+	_handle->magic = EMU_HANDLE_MAGIC;
+
+	*handle = _handle;
+	res = FPGA_OK;
+out_attr_destroy:
+	pthread_mutexattr_destroy(&mattr);
+	if (res && _handle) {
+		pthread_mutex_destroy(&_handle->lock);
+		if (_handle->token)
+			free_token(_handle->token);
+		opae_free(_handle);
+	}
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaClose(fpga_handle handle)
+{
+	fpga_result res = FPGA_OK;
+	emu_handle *h;
+	emu_device *dev;
+	emu_buffer **pb;
+	emu_buffer *b;
+	int err;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	dev = h->device;
+
+	// Release any buffers that the application didn't.
+	opae_mutex_lock(err, &dev->lock);
+	pb = &dev->buffers;
+	while (*pb) {
+		b = *pb;
+		if (b->owner == h) {
+			*pb = b->next;
+			if (!b->preallocated)
+				munmap(b->virt, b->len);
+			opae_free(b);
+		} else {
+			pb = &b->next;
+		}
+	}
+	opae_mutex_unlock(err, &dev->lock);
+
+	if (h->token->hdr.objtype == FPGA_ACCELERATOR)
+		emu_afu_stop(dev);
+
+	free_token(h->token);
+
+	if (pthread_mutex_unlock(&h->lock) ||
+	    pthread_mutex_destroy(&h->lock)) {
+		OPAE_ERR("error unlocking/destroying handle mutex");
+		res = FPGA_EXCEPTION;
+	}
+
+	h->magic = 0;
+	opae_free(h);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaReset(fpga_handle handle)
+{
+	int err;
+	fpga_result res = FPGA_NOT_SUPPORTED;
+	emu_handle *h;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (h->token->hdr.objtype == FPGA_ACCELERATOR) {
+		emu_afu_reset(h->device);
+		res = FPGA_OK;
+	}
+
+	opae_mutex_unlock(err, &h->lock);
+
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaUpdateProperties(fpga_token token, fpga_properties prop)
+{
+	emu_token *t;
+	struct _fpga_properties *_prop;
+	int err;
+
+	t = token_check(token);
+	ASSERT_NOT_NULL(t);
+
+	_prop = opae_validate_and_lock_properties(prop);
+	if (!_prop) {
+		OPAE_ERR("Invalid properties object");
+		return FPGA_INVALID_PARAM;
+	}
+
+	_prop->valid_fields = 0;
+
+	_prop->vendor_id = t->hdr.vendor_id;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_VENDORID);
+
+	_prop->device_id = t->hdr.device_id;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_DEVICEID);
+
+	_prop->subsystem_vendor_id = t->hdr.subsystem_vendor_id;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_SUB_VENDORID);
+
+	_prop->subsystem_device_id = t->hdr.subsystem_device_id;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_SUB_DEVICEID);
+
+	_prop->segment = t->hdr.segment;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_SEGMENT);
+
+	_prop->bus = t->hdr.bus;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_BUS);
+
+	_prop->device = t->hdr.device;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_DEVICE);
+
+	_prop->function = t->hdr.function;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_FUNCTION);
+
+	_prop->socket_id = t->device->numa_node;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_SOCKETID);
+
+	_prop->object_id = t->hdr.object_id;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_OBJECTID);
+
+	_prop->objtype = t->hdr.objtype;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_OBJTYPE);
+
+	_prop->interface = FPGA_IFC_SIM_DFL;
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_INTERFACE);
+
+	memcpy(_prop->guid, t->hdr.guid, sizeof(fpga_guid));
+	SET_FIELD_VALID(_prop, FPGA_PROPERTY_GUID);
+
+	if (t->hdr.objtype == FPGA_ACCELERATOR) {
+		_prop->parent = NULL;
+		CLEAR_FIELD_VALID(_prop, FPGA_PROPERTY_PARENT);
+
+		_prop->u.accelerator.num_mmio = 1;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_NUM_MMIO);
+
+		_prop->u.accelerator.num_interrupts = t->num_afu_irqs;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_NUM_INTERRUPTS);
+
+		opae_mutex_lock(err, &t->device->lock);
+		t->afu_state = t->device->open_count ?
+			FPGA_ACCELERATOR_ASSIGNED : FPGA_ACCELERATOR_UNASSIGNED;
+		opae_mutex_unlock(err, &t->device->lock);
+
+		_prop->u.accelerator.state = t->afu_state;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_ACCELERATOR_STATE);
+	} else {
+		_prop->u.fpga.bbs_id = t->bitstream_id;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_BBSID);
+
+		_prop->u.fpga.bbs_version.major = (t->bitstream_id >> 56) & 0xf;
+		_prop->u.fpga.bbs_version.minor = (t->bitstream_id >> 52) & 0xf;
+		_prop->u.fpga.bbs_version.patch = (t->bitstream_id >> 48) & 0xf;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_BBSVERSION);
+
+		_prop->u.fpga.num_slots = 1;
+		SET_FIELD_VALID(_prop, FPGA_PROPERTY_NUM_SLOTS);
+	}
+
+	opae_mutex_unlock(err, &_prop->lock);
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaGetProperties(fpga_token token, fpga_properties *prop)
+{
+	struct _fpga_properties *_prop = NULL;
+	fpga_result result = FPGA_OK;
+	int err;
+
+	ASSERT_NOT_NULL(prop);
+
+	result = fpgaGetProperties(NULL, (fpga_properties *)&_prop);
+	if (result)
+		return result;
+
+	if (token) {
+		result = emu_fpgaUpdateProperties(token, _prop);
+		if (result)
+			goto out_free;
+	}
+
+	*prop = (fpga_properties)_prop;
+	return result;
+
+out_free:
+	err = pthread_mutex_destroy(&_prop->lock);
+	if (err)
+		OPAE_ERR("pthread_mutex_destroy() failed");
+	opae_free(_prop);
+	return result;
+}
+
+fpga_result __EMU_API__ emu_fpgaGetPropertiesFromHandle(fpga_handle handle, fpga_properties *prop)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	ASSERT_NOT_NULL(prop);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_fpgaGetProperties(h->token, prop);
+
+	opae_mutex_unlock(err, &h->lock);
+
+	return res;
+}
+
+STATIC fpga_result emu_mmio_check(emu_handle *h,
+				  uint32_t mmio_num,
+				  uint64_t offset,
+				  size_t size)
+{
+	if (h->token->hdr.objtype == FPGA_DEVICE)
+		return FPGA_NOT_SUPPORTED;
+
+	if (mmio_num != 0)
+		return FPGA_INVALID_PARAM;
+
+	if ((offset % size) || (offset + size > h->mmio_size)) {
+		OPAE_ERR("Invalid MMIO access at 0x%lx", offset);
+		return FPGA_INVALID_PARAM;
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaWriteMMIO64(fpga_handle handle,
+					    uint32_t mmio_num,
+					    uint64_t offset,
+					    uint64_t value)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, offset, sizeof(uint64_t));
+	if (res == FPGA_OK) {
+		*((volatile uint64_t *)(h->mmio_base + offset)) = value;
+		emu_afu_mmio_write(h->device, offset, sizeof(uint64_t));
+	}
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaReadMMIO64(fpga_handle handle,
+					   uint32_t mmio_num,
+					   uint64_t offset,
+					   uint64_t *value)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	ASSERT_NOT_NULL(value);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, offset, sizeof(uint64_t));
+	if (res == FPGA_OK)
+		*value = *((volatile uint64_t *)(h->mmio_base + offset));
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaWriteMMIO32(fpga_handle handle,
+					    uint32_t mmio_num,
+					    uint64_t offset,
+					    uint32_t value)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, offset, sizeof(uint32_t));
+	if (res == FPGA_OK) {
+		*((volatile uint32_t *)(h->mmio_base + offset)) = value;
+		emu_afu_mmio_write(h->device, offset, sizeof(uint32_t));
+	}
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaReadMMIO32(fpga_handle handle,
+					   uint32_t mmio_num,
+					   uint64_t offset,
+					   uint32_t *value)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	ASSERT_NOT_NULL(value);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, offset, sizeof(uint32_t));
+	if (res == FPGA_OK)
+		*value = *((volatile uint32_t *)(h->mmio_base + offset));
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaWriteMMIO512(fpga_handle handle,
+					     uint32_t mmio_num,
+					     uint64_t offset,
+					     const void *value)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	ASSERT_NOT_NULL(value);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, offset, 64);
+	if (res == FPGA_OK) {
+		memcpy((void *)(h->mmio_base + offset), value, 64);
+		emu_afu_mmio_write(h->device, offset, 64);
+	}
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaMapMMIO(fpga_handle handle,
+					uint32_t mmio_num,
+					uint64_t **mmio_ptr)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, 0, sizeof(uint64_t));
+
+	/* Store return value only if return pointer has allocated memory */
+	if ((res == FPGA_OK) && mmio_ptr)
+		*mmio_ptr = (uint64_t *)h->mmio_base;
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaUnmapMMIO(fpga_handle handle,
+					  uint32_t mmio_num)
+{
+	emu_handle *h;
+	fpga_result res;
+	int err;
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = emu_mmio_check(h, mmio_num, 0, sizeof(uint64_t));
+
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaPrepareBuffer(fpga_handle handle,
+					      uint64_t len,
+					      void **buf_addr,
+					      uint64_t *wsid,
+					      int flags)
+{
+	emu_handle *h;
+	emu_device *dev;
+	emu_buffer *b;
+	void *virt = NULL;
+	bool preallocated = false;
+	int err;
+
+	if (flags & FPGA_BUF_PREALLOCATED) {
+		if (!buf_addr && !len) {
+			/* Special case: respond FPGA_OK when
+			** !buf_addr and !len as an indication that
+			** FPGA_BUF_PREALLOCATED is supported by the
+			** library.
+			*/
+			return FPGA_OK;
+		} else if (!buf_addr || !*buf_addr) {
+			OPAE_ERR("got FPGA_BUF_PREALLOCATED but NULL buf");
+			return FPGA_INVALID_PARAM;
+		}
+		virt = *buf_addr;
+		preallocated = true;
+	}
+
+	ASSERT_NOT_NULL(buf_addr);
+	ASSERT_NOT_NULL(wsid);
+
+	if (!len) {
+		OPAE_ERR("zero-length buffer");
+		return FPGA_INVALID_PARAM;
+	}
+
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+	dev = h->device;
+
+	if (!preallocated) {
+		len = EMU_ROUND_UP(len, EMU_PAGE_SIZE);
+		virt = mmap(NULL, len, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (virt == MAP_FAILED) {
+			OPAE_ERR("could not allocate buffer");
+			return FPGA_NO_MEMORY;
+		}
+	}
+
+	b = opae_calloc(1, sizeof(emu_buffer));
+	if (!b) {
+		OPAE_ERR("error allocating buffer metadata");
+		if (!preallocated)
+			munmap(virt, len);
+		return FPGA_NO_MEMORY;
+	}
+
+	b->virt = (uint8_t *)virt;
+	b->len = len;
+	b->preallocated = preallocated;
+	b->owner = h;
+
+	opae_mutex_lock(err, &dev->lock);
+	b->wsid = dev->next_wsid++;
+	b->iova = dev->next_iova;
+	dev->next_iova += EMU_ROUND_UP(len, EMU_PAGE_SIZE);
+	b->next = dev->buffers;
+	dev->buffers = b;
+	opae_mutex_unlock(err, &dev->lock);
+
+	*buf_addr = virt;
+	*wsid = b->wsid;
+
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaReleaseBuffer(fpga_handle handle,
+					      uint64_t wsid)
+{
+	emu_handle *h;
+	emu_device *dev;
+	emu_buffer **pb;
+	emu_buffer *b = NULL;
+	int err;
+
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+	dev = h->device;
+
+	opae_mutex_lock(err, &dev->lock);
+	for (pb = &dev->buffers ; *pb ; pb = &(*pb)->next) {
+		if ((*pb)->wsid == wsid) {
+			b = *pb;
+			*pb = b->next;
+			break;
+		}
+	}
+	opae_mutex_unlock(err, &dev->lock);
+
+	if (!b)
+		return FPGA_INVALID_PARAM;
+
+	if (!b->preallocated)
+		munmap(b->virt, b->len);
+	opae_free(b);
+
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaGetIOAddress(fpga_handle handle,
+					     uint64_t wsid,
+					     uint64_t *ioaddr)
+{
+	emu_handle *h;
+	emu_buffer *b;
+	fpga_result res = FPGA_INVALID_PARAM;
+	int err;
+
+	ASSERT_NOT_NULL(ioaddr);
+
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	opae_mutex_lock(err, &h->device->lock);
+	for (b = h->device->buffers ; b ; b = b->next) {
+		if (b->wsid == wsid) {
+			*ioaddr = b->iova;
+			res = FPGA_OK;
+			break;
+		}
+	}
+	opae_mutex_unlock(err, &h->device->lock);
+
+	return res;
+}
+
+STATIC bool matches_filter(const fpga_properties filter, emu_token *t)
+{
+	struct _fpga_properties *_prop = (struct _fpga_properties *)filter;
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_PARENT)) {
+		fpga_token_header *parent_hdr =
+			(fpga_token_header *)_prop->parent;
+
+		if (!parent_hdr)
+			return false;
+
+		if (!fpga_is_parent_child(parent_hdr, &t->hdr))
+			return false;
+	}
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_OBJTYPE)) {
+		if (_prop->objtype != t->hdr.objtype)
+			return false;
+
+		if ((t->hdr.objtype == FPGA_ACCELERATOR) &&
+		    FIELD_VALID(_prop, FPGA_PROPERTY_ACCELERATOR_STATE))
+			if (_prop->u.accelerator.state != t->afu_state)
+				return false;
+
+		if ((t->hdr.objtype == FPGA_ACCELERATOR) &&
+		    FIELD_VALID(_prop, FPGA_PROPERTY_NUM_INTERRUPTS))
+			if (_prop->u.accelerator.num_interrupts != t->num_afu_irqs)
+				return false;
+	}
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_SEGMENT))
+		if (_prop->segment != t->hdr.segment)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_BUS))
+		if (_prop->bus != t->hdr.bus)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_DEVICE))
+		if (_prop->device != t->hdr.device)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_FUNCTION))
+		if (_prop->function != t->hdr.function)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_SOCKETID))
+		if (_prop->socket_id != t->device->numa_node)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_VENDORID))
+		if (_prop->vendor_id != t->hdr.vendor_id)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_DEVICEID))
+		if (_prop->device_id != t->hdr.device_id)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_SUB_VENDORID))
+		if (_prop->subsystem_vendor_id != t->hdr.subsystem_vendor_id)
+			return false;
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_SUB_DEVICEID))
+		if (_prop->subsystem_device_id != t->hdr.subsystem_device_id)
+			return false;
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_OBJECTID))
+		if (_prop->object_id != t->hdr.object_id)
+			return false;
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_GUID))
+		if (memcmp(_prop->guid, t->hdr.guid, sizeof(fpga_guid)))
+			return false;
+
+	if (FIELD_VALID(_prop, FPGA_PROPERTY_INTERFACE))
+		if (_prop->interface != FPGA_IFC_SIM_DFL)
+			return false;
+
+	return true;
+}
+
+STATIC bool matches_filters(const fpga_properties *filters,
+			    uint32_t num_filters,
+			    emu_token *t)
+{
+	if (!filters)
+		return true;
+
+	for (uint32_t i = 0; i < num_filters; ++i) {
+		if (matches_filter(filters[i], t))
+			return true;
+	}
+
+	return false;
+}
+
+fpga_result __EMU_API__ emu_fpgaEnumerate(const fpga_properties *filters,
+					  uint32_t num_filters, fpga_token *tokens,
+					  uint32_t max_tokens, uint32_t *num_matches)
+{
+	emu_device *dev;
+	emu_token *tptr;
+	uint32_t matches = 0;
+	int err;
+
+	ASSERT_NOT_NULL(num_matches);
+
+	for (dev = _emu_devices ; dev ; dev = dev->next) {
+		for (tptr = dev->tokens ; tptr ; tptr = tptr->next) {
+			if (tptr->hdr.objtype == FPGA_ACCELERATOR) {
+				opae_mutex_lock(err, &dev->lock);
+				tptr->afu_state = dev->open_count ?
+					FPGA_ACCELERATOR_ASSIGNED :
+					FPGA_ACCELERATOR_UNASSIGNED;
+				opae_mutex_unlock(err, &dev->lock);
+			}
+
+			if (matches_filters(filters, num_filters, tptr)) {
+				if (matches < max_tokens)
+					tokens[matches] = clone_token(tptr);
+				++matches;
+			}
+		}
+	}
+
+	*num_matches = matches;
+
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaCloneToken(fpga_token src, fpga_token *dst)
+{
+	emu_token *_src;
+	emu_token *_dst;
+
+	if (!src || !dst) {
+		OPAE_ERR("src or dst token is NULL");
+		return FPGA_INVALID_PARAM;
+	}
+
+	_src = (emu_token *)src;
+	if (_src->hdr.magic != EMU_TOKEN_MAGIC) {
+		OPAE_ERR("Invalid src token");
+		return FPGA_INVALID_PARAM;
+	}
+
+	_dst = clone_token(_src);
+	if (!_dst)
+		return FPGA_NO_MEMORY;
+
+	*dst = _dst;
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaDestroyToken(fpga_token *token)
+{
+	emu_token *t;
+
+	if (!token || !*token) {
+		OPAE_ERR("invalid token pointer");
+		return FPGA_INVALID_PARAM;
+	}
+
+	t = (emu_token *)*token;
+	if (t->hdr.magic != EMU_TOKEN_MAGIC)
+		return FPGA_INVALID_PARAM;
+
+	free_token(t);
+	*token = NULL;
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaCreateEventHandle(fpga_event_handle *event_handle)
+{
+	emu_event_handle *_eeh;
+	pthread_mutexattr_t mattr;
+	fpga_result res = FPGA_OK;
+
+	ASSERT_NOT_NULL(event_handle);
+
+	_eeh = opae_calloc(1, sizeof(emu_event_handle));
+	if (!_eeh) {
+		OPAE_ERR("Out of memory");
+		return FPGA_NO_MEMORY;
+	}
+
+	_eeh->magic = EMU_EVENT_HANDLE_MAGIC;
+	_eeh->fd = -1;
+
+	if (pthread_mutexattr_init(&mattr)) {
+		OPAE_ERR("Failed to init event handle mutex attr");
+		opae_free(_eeh);
+		return FPGA_EXCEPTION;
+	}
+
+	if (pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE) ||
+	    pthread_mutex_init(&_eeh->lock, &mattr)) {
+		OPAE_ERR("Failed to initialize event handle lock");
+		opae_free(_eeh);
+		res = FPGA_EXCEPTION;
+	} else {
+		*event_handle = (fpga_event_handle)_eeh;
+	}
+
+	pthread_mutexattr_destroy(&mattr);
+	return res;
+}
+
+// Detach an event handle's eventfd from the device's vector table.
+STATIC void emu_release_irq(emu_event_handle *_eeh)
+{
+	int err;
+
+	if (_eeh->fd < 0)
+		return;
+
+	if (_eeh->device) {
+		opae_mutex_lock(err, &_eeh->device->lock);
+		if ((_eeh->flags < EMU_NUM_IRQS) &&
+		    (_eeh->device->irq_fds[_eeh->flags] == _eeh->fd))
+			_eeh->device->irq_fds[_eeh->flags] = -1;
+		opae_mutex_unlock(err, &_eeh->device->lock);
+	}
+
+	opae_close(_eeh->fd);
+	_eeh->fd = -1;
+	_eeh->device = NULL;
+}
+
+fpga_result __EMU_API__ emu_fpgaDestroyEventHandle(fpga_event_handle *event_handle)
+{
+	emu_event_handle *_eeh;
+	int err;
+
+	ASSERT_NOT_NULL(event_handle);
+
+	_eeh = event_handle_check_and_lock(*event_handle);
+	ASSERT_NOT_NULL(_eeh);
+
+	emu_release_irq(_eeh);
+	_eeh->magic = 0;
+
+	opae_mutex_unlock(err, &_eeh->lock);
+	err = pthread_mutex_destroy(&_eeh->lock);
+	if (err)
+		OPAE_ERR("pthread_mutex_destroy() failed: %s",
+			 strerror(err));
+
+	opae_free(_eeh);
+
+	*event_handle = NULL;
+	return FPGA_OK;
+}
+
+fpga_result __EMU_API__ emu_fpgaGetOSObjectFromEventHandle(const fpga_event_handle eh,
+							   int *fd)
+{
+	emu_event_handle *_eeh;
+	int err;
+
+	ASSERT_NOT_NULL(eh);
+	ASSERT_NOT_NULL(fd);
+
+	_eeh = event_handle_check_and_lock(eh);
+	ASSERT_NOT_NULL(_eeh);
+
+	*fd = _eeh->fd;
+
+	opae_mutex_unlock(err, &_eeh->lock);
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result register_event(emu_handle *_h,
+				  fpga_event_type event_type,
+				  emu_event_handle *_eeh,
+				  uint32_t flags)
+{
+	emu_device *dev = _h->device;
+	int err;
+
+	switch (event_type) {
+	case FPGA_EVENT_ERROR:
+		OPAE_ERR("Error interrupts are not currently supported.");
+		return FPGA_NOT_SUPPORTED;
+
+	case FPGA_EVENT_INTERRUPT:
+		if (_h->token->hdr.objtype != FPGA_ACCELERATOR ||
+		    flags >= EMU_NUM_IRQS) {
+			OPAE_ERR("Invalid interrupt vector %u", flags);
+			return FPGA_INVALID_PARAM;
+		}
+
+		emu_release_irq(_eeh);
+
+		_eeh->fd = eventfd(0, 0);
+		if (_eeh->fd < 0) {
+			OPAE_ERR("eventfd() failed: %s", strerror(errno));
+			return FPGA_EXCEPTION;
+		}
+
+		_eeh->flags = flags;
+		_eeh->device = dev;
+
+		opae_mutex_lock(err, &dev->lock);
+		dev->irq_fds[flags] = _eeh->fd;
+		opae_mutex_unlock(err, &dev->lock);
+		return FPGA_OK;
+
+	case FPGA_EVENT_POWER_THERMAL:
+		OPAE_ERR("Thermal interrupts are not currently supported.");
+		return FPGA_NOT_SUPPORTED;
+	default:
+		OPAE_ERR("Invalid event type");
+		return FPGA_EXCEPTION;
+	}
+}
+
+fpga_result __EMU_API__ emu_fpgaRegisterEvent(fpga_handle handle,
+					      fpga_event_type event_type,
+					      fpga_event_handle event_handle,
+					      uint32_t flags)
+{
+	emu_handle *_h;
+	emu_event_handle *_eeh;
+	fpga_result res = FPGA_EXCEPTION;
+	int err;
+
+	ASSERT_NOT_NULL(handle);
+	ASSERT_NOT_NULL(event_handle);
+
+	_h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(_h);
+
+	_eeh = event_handle_check_and_lock(event_handle);
+	if (!_eeh)
+		goto out_unlock_handle;
+
+	res = register_event(_h, event_type, _eeh, flags);
+
+	opae_mutex_unlock(err, &_eeh->lock);
+
+out_unlock_handle:
+	opae_mutex_unlock(err, &_h->lock);
+	return res;
+}
+
+fpga_result __EMU_API__ emu_fpgaUnregisterEvent(fpga_handle handle,
+						fpga_event_type event_type,
+						fpga_event_handle event_handle)
+{
+	emu_handle *_h;
+	emu_event_handle *_eeh;
+	fpga_result res = FPGA_EXCEPTION;
+	int err;
+
+	ASSERT_NOT_NULL(handle);
+	ASSERT_NOT_NULL(event_handle);
+
+	_h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(_h);
+
+	_eeh = event_handle_check_and_lock(event_handle);
+	if (!_eeh)
+		goto out_unlock_handle;
+
+	switch (event_type) {
+	case FPGA_EVENT_INTERRUPT:
+		emu_release_irq(_eeh);
+		res = FPGA_OK;
+		break;
+	case FPGA_EVENT_ERROR:
+	case FPGA_EVENT_POWER_THERMAL:
+		res = FPGA_NOT_SUPPORTED;
+		break;
+	default:
+		OPAE_ERR("Invalid event type");
+		break;
+	}
+
+	opae_mutex_unlock(err, &_eeh->lock);
+
+out_unlock_handle:
+	opae_mutex_unlock(err, &_h->lock);
+	return res;
+}
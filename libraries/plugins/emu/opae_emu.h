@@ -0,0 +1,144 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef _OPAE_EMU_PLUGIN_H
+#define _OPAE_EMU_PLUGIN_H
+#include <stdbool.h>
+#include <pthread.h>
+#include <opae/fpga.h>
+
+#include "opae_int.h"
+
+// Emulated devices report this id pair so that they never
+// collide with a real card in the opae.cfg platform table.
+#define EMU_VENDOR_ID         0x8086
+#define EMU_DEVICE_ID         0x0e5e
+#define EMU_SUBSYSTEM_VENDOR  0x8086
+#define EMU_SUBSYSTEM_DEVICE  0x0e5e
+
+#define EMU_MAX_DEVICES       8
+#define EMU_NUM_IRQS          4
+#define EMU_PORT_MMIO_SIZE    (256 * 1024)
+#define EMU_DEFAULT_POLL_US   100
+#define EMU_DEFAULT_CLOCK_MHZ 400
+
+// The HE-LB (host exerciser loopback) AFU.
+#define EMU_HE_LB_GUID "56e203e9-864f-49a7-b94b-12284c31e02b"
+// The FME's PR interface id.
+#define EMU_PR_INTERFACE_ID "c54b8e0d-7e13-5a28-9b41-4c9a25d2e5f0"
+
+typedef struct _emu_config {
+	uint32_t num_devices;
+	uint32_t poll_us;
+	uint32_t clock_mhz;
+	fpga_guid afu_id;
+	bool he_lb;
+} emu_config;
+
+extern emu_config emu_cfg;
+
+typedef union _bdf {
+	struct {
+		uint16_t segment;
+		uint8_t bus;
+		uint8_t device : 5;
+		uint8_t function : 3;
+	};
+	uint32_t bdf;
+} bdf_t;
+
+struct _emu_token;
+struct _emu_handle;
+
+typedef struct _emu_buffer {
+	uint64_t wsid;
+	uint8_t *virt;
+	uint64_t iova;
+	uint64_t len;
+	bool preallocated;
+	struct _emu_handle *owner;
+	struct _emu_buffer *next;
+} emu_buffer;
+
+// One emulated card: an FME and a single port whose AFU
+// behaves like the host exerciser loopback.
+typedef struct _emu_device {
+	bdf_t bdf;
+	uint64_t object_id;
+	uint32_t numa_node;
+	volatile uint8_t *port_mmio;
+	pthread_mutex_t lock;
+	pthread_cond_t kick;
+	bool start_pending;
+	pthread_t worker;
+	bool running;
+	uint32_t open_count;
+	int irq_fds[EMU_NUM_IRQS];
+	emu_buffer *buffers;
+	uint64_t next_wsid;
+	uint64_t next_iova;
+	struct _emu_token *tokens;
+	struct _emu_device *next;
+} emu_device;
+
+typedef struct _emu_token {
+	fpga_token_header hdr; //< Must appear at offset 0!
+	fpga_guid compat_id;
+	emu_device *device;
+	uint64_t bitstream_id;
+	fpga_accelerator_state afu_state;
+	uint32_t num_afu_irqs;
+	struct _emu_token *parent;
+	struct _emu_token *next;
+} emu_token;
+
+typedef struct _emu_handle {
+	uint32_t magic;
+	emu_token *token;
+	emu_device *device;
+	volatile uint8_t *mmio_base;
+	size_t mmio_size;
+	pthread_mutex_t lock;
+} emu_handle;
+
+typedef struct _emu_event_handle {
+	uint32_t magic;
+	pthread_mutex_t lock;
+	int fd;
+	uint32_t flags;
+	emu_device *device;
+} emu_event_handle;
+
+int emu_discover(void);
+void emu_free_device_list(void);
+
+// Device model (emu_afu.c)
+void emu_afu_init(emu_device *dev);
+void emu_afu_reset(emu_device *dev);
+void emu_afu_mmio_write(emu_device *dev, uint64_t offset, size_t size);
+int emu_afu_start(emu_device *dev);
+void emu_afu_stop(emu_device *dev);
+
+#endif // _OPAE_EMU_PLUGIN_H
@@ -0,0 +1,165 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <dlfcn.h>
+#include <json-c/json.h>
+#include <uuid/uuid.h>
+
+#include <opae/types_enum.h>
+
+#include "adapter.h"
+#include "opae_int.h"
+#include "opae_emu.h"
+#include "mock/opae_std.h"
+
+#ifndef __EMU_API__
+#define __EMU_API__
+#endif
+
+// Settings come from the plugin's "configuration" object in opae.cfg.
+STATIC void emu_parse_config(const char *jsonConfig)
+{
+	json_object *root = NULL;
+	json_object *j;
+
+	if (jsonConfig)
+		root = json_tokener_parse(jsonConfig);
+
+	if (!root)
+		return;
+
+	if (json_object_object_get_ex(root, "devices", &j) &&
+	    json_object_is_type(j, json_type_int))
+		emu_cfg.num_devices = (uint32_t)json_object_get_int(j);
+
+	if (json_object_object_get_ex(root, "poll_us", &j) &&
+	    json_object_is_type(j, json_type_int))
+		emu_cfg.poll_us = (uint32_t)json_object_get_int(j);
+
+	if (json_object_object_get_ex(root, "clock_mhz", &j) &&
+	    json_object_is_type(j, json_type_int))
+		emu_cfg.clock_mhz = (uint32_t)json_object_get_int(j);
+
+	if (json_object_object_get_ex(root, "afu_id", &j) &&
+	    json_object_is_type(j, json_type_string) &&
+	    uuid_parse(json_object_get_string(j), emu_cfg.afu_id))
+		OPAE_ERR("invalid afu_id: %s", json_object_get_string(j));
+
+	json_object_put(root);
+}
+
+int __EMU_API__ emu_plugin_initialize(void)
+{
+	fpga_guid he_lb;
+	int res;
+
+	uuid_parse(EMU_HE_LB_GUID, he_lb);
+	if (uuid_is_null(emu_cfg.afu_id))
+		uuid_copy(emu_cfg.afu_id, he_lb);
+	emu_cfg.he_lb = !uuid_compare(emu_cfg.afu_id, he_lb);
+
+	if (!emu_cfg.poll_us)
+		emu_cfg.poll_us = 1;
+
+	res = emu_discover();
+	if (res) {
+		OPAE_ERR("error with emu_discover");
+	}
+
+	return res;
+}
+
+int __EMU_API__ emu_plugin_finalize(void)
+{
+	emu_free_device_list();
+	return 0;
+}
+
+int __EMU_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
+				      const char *jsonConfig)
+{
+	emu_parse_config(jsonConfig);
+
+	adapter->fpgaOpen = dlsym(adapter->plugin.dl_handle, "emu_fpgaOpen");
+	adapter->fpgaClose =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaClose");
+	adapter->fpgaReset =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaReset");
+	adapter->fpgaGetPropertiesFromHandle = dlsym(
+		adapter->plugin.dl_handle, "emu_fpgaGetPropertiesFromHandle");
+	adapter->fpgaGetProperties =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaGetProperties");
+	adapter->fpgaUpdateProperties =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaUpdateProperties");
+	adapter->fpgaWriteMMIO64 =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaWriteMMIO64");
+	adapter->fpgaReadMMIO64 =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaReadMMIO64");
+	adapter->fpgaWriteMMIO32 =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaWriteMMIO32");
+	adapter->fpgaReadMMIO32 =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaReadMMIO32");
+	adapter->fpgaWriteMMIO512 =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaWriteMMIO512");
+	adapter->fpgaMapMMIO =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaMapMMIO");
+	adapter->fpgaUnmapMMIO =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaUnmapMMIO");
+	adapter->fpgaPrepareBuffer =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaPrepareBuffer");
+	adapter->fpgaReleaseBuffer =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaReleaseBuffer");
+	adapter->fpgaGetIOAddress =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaGetIOAddress");
+	adapter->fpgaEnumerate =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaEnumerate");
+	adapter->fpgaCloneToken =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaCloneToken");
+	adapter->fpgaDestroyToken =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaDestroyToken");
+	adapter->fpgaCreateEventHandle =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaCreateEventHandle");
+	adapter->fpgaDestroyEventHandle =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaDestroyEventHandle");
+	adapter->fpgaGetOSObjectFromEventHandle =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaGetOSObjectFromEventHandle");
+	adapter->fpgaRegisterEvent =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaRegisterEvent");
+	adapter->fpgaUnregisterEvent =
+		dlsym(adapter->plugin.dl_handle, "emu_fpgaUnregisterEvent");
+
+	adapter->initialize =
+		dlsym(adapter->plugin.dl_handle, "emu_plugin_initialize");
+	adapter->finalize =
+		dlsym(adapter->plugin.dl_handle, "emu_plugin_finalize");
+
+	return 0;
+}
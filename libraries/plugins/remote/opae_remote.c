@@ -0,0 +1,1405 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <pthread.h>
+#include <string.h>
+
+#include <opae/fpga.h>
+
+#include "opae_remote.h"
+#include "opae_int.h"
+#include "props.h"
+#include "mock/opae_std.h"
+
+#ifndef __REMOTE_API__
+#define __REMOTE_API__
+#endif
+
+remote_client *remote_conn;
+
+// The server stages one bitstream per connection.
+STATIC pthread_mutex_t remote_reconf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Windows per REMOTE_OBJECT_READV request.
+#define REMOTE_READV_MAX 256
+
+fpga_result __REMOTE_API__ remote_fpgaDestroyToken(fpga_token *token);
+
+STATIC remote_token *token_check(fpga_token token)
+{
+	remote_token *t = (remote_token *)token;
+
+	if (!t || t->hdr.magic != REMOTE_TOKEN_MAGIC) {
+		OPAE_ERR("invalid remote token");
+		return NULL;
+	}
+
+	return t;
+}
+
+STATIC remote_handle *handle_check(fpga_handle handle)
+{
+	remote_handle *h = (remote_handle *)handle;
+
+	if (!h || h->magic != REMOTE_HANDLE_MAGIC) {
+		OPAE_ERR("invalid remote handle");
+		return NULL;
+	}
+
+	return h;
+}
+
+STATIC remote_object *object_check(fpga_object obj)
+{
+	remote_object *o = (remote_object *)obj;
+
+	if (!o || o->magic != REMOTE_OBJECT_MAGIC) {
+		OPAE_ERR("invalid remote object");
+		return NULL;
+	}
+
+	return o;
+}
+
+// Send a fixed-size request and receive a fixed-size response.
+STATIC fpga_result remote_request(uint16_t op, const void *req,
+				  size_t req_len, void *resp,
+				  size_t resp_len)
+{
+	struct iovec iov = { (void *)req, req_len };
+	size_t len = 0;
+	fpga_result res;
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	res = remote_call_sync(remote_conn, op, &iov, 1,
+			       resp, resp_len, &len);
+	if (res == FPGA_OK && len != resp_len) {
+		OPAE_ERR("short response to remote op %u", op);
+		res = FPGA_EXCEPTION;
+	}
+
+	return res;
+}
+
+STATIC fpga_result remote_request_id(uint16_t op, uint64_t id,
+				     uint64_t arg0, uint64_t arg1,
+				     uint64_t arg2, uint64_t *value)
+{
+	remote_id_req req = { id, arg0, arg1, arg2 };
+	uint64_t v = 0;
+	fpga_result res;
+
+	res = remote_request(op, &req, sizeof(req),
+			     value ? &v : NULL, value ? sizeof(v) : 0);
+	if (res == FPGA_OK && value)
+		*value = v;
+
+	return res;
+}
+
+STATIC remote_token *remote_new_token(const remote_token_desc *desc)
+{
+	const remote_properties *p = &desc->props;
+	remote_token *t;
+
+	t = opae_calloc(1, sizeof(remote_token));
+	if (!t)
+		return NULL;
+
+	t->hdr.magic = REMOTE_TOKEN_MAGIC;
+	t->hdr.vendor_id = p->vendor_id;
+	t->hdr.device_id = p->device_id;
+	t->hdr.segment = p->segment;
+	t->hdr.bus = p->bus;
+	t->hdr.device = p->device;
+	t->hdr.function = p->function;
+	t->hdr.interface = (fpga_interface)p->interface;
+	t->hdr.objtype = (fpga_objtype)p->objtype;
+	t->hdr.object_id = p->object_id;
+	memcpy(t->hdr.guid, p->guid, sizeof(fpga_guid));
+	t->hdr.subsystem_vendor_id = p->subsystem_vendor_id;
+	t->hdr.subsystem_device_id = p->subsystem_device_id;
+	t->id = desc->id;
+
+	return t;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaEnumerate(const fpga_properties *filters,
+						uint32_t num_filters,
+						fpga_token *tokens,
+						uint32_t max_tokens,
+						uint32_t *num_matches)
+{
+	remote_enum_req req;
+	remote_filter *wire = NULL;
+	remote_enum_resp *resp = NULL;
+	remote_token_desc *desc;
+	struct iovec iov[2];
+	size_t resp_cap;
+	size_t resp_len = 0;
+	fpga_result res;
+	uint32_t i;
+	int err;
+
+	ASSERT_NOT_NULL(num_matches);
+	*num_matches = 0;
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	memset(&req, 0, sizeof(req));
+	req.max_tokens = max_tokens;
+
+	if (num_filters) {
+		wire = opae_calloc(num_filters, sizeof(remote_filter));
+		if (!wire)
+			return FPGA_NO_MEMORY;
+	}
+
+	for (i = 0 ; i < num_filters ; ++i) {
+		struct _fpga_properties *p =
+			opae_validate_and_lock_properties(filters[i]);
+
+		if (!p) {
+			opae_free(wire);
+			return FPGA_INVALID_PARAM;
+		}
+
+		if (FIELD_VALID(p, FPGA_PROPERTY_PARENT)) {
+			remote_token *parent = (remote_token *)p->parent;
+
+			// A parent from another plugin matches nothing here.
+			if (!parent || parent->hdr.magic != REMOTE_TOKEN_MAGIC) {
+				opae_mutex_unlock(err, &p->lock);
+				continue;
+			}
+
+			wire[req.num_filters].parent = parent->id;
+		}
+
+		remote_pack_properties(p, &wire[req.num_filters].props);
+		if (FIELD_VALID(p, FPGA_PROPERTY_PARENT))
+			wire[req.num_filters].props.valid_fields |=
+				(uint64_t)1 << FPGA_PROPERTY_PARENT;
+		++req.num_filters;
+
+		opae_mutex_unlock(err, &p->lock);
+	}
+
+	if (num_filters && !req.num_filters) {
+		opae_free(wire);
+		return FPGA_OK;
+	}
+
+	resp_cap = sizeof(remote_enum_resp) +
+		   (size_t)max_tokens * sizeof(remote_token_desc);
+	resp = opae_malloc(resp_cap);
+	if (!resp) {
+		opae_free(wire);
+		return FPGA_NO_MEMORY;
+	}
+
+	iov[0].iov_base = &req;
+	iov[0].iov_len = sizeof(req);
+	iov[1].iov_base = wire;
+	iov[1].iov_len = req.num_filters * sizeof(remote_filter);
+
+	res = remote_call_sync(remote_conn, REMOTE_ENUMERATE, iov, 2,
+			       resp, resp_cap, &resp_len);
+	opae_free(wire);
+
+	if (res != FPGA_OK)
+		goto out_free;
+
+	if (resp_len < sizeof(*resp) ||
+	    resp->num_tokens > max_tokens ||
+	    resp_len != sizeof(*resp) +
+			resp->num_tokens * sizeof(remote_token_desc)) {
+		OPAE_ERR("malformed enumeration response");
+		res = FPGA_EXCEPTION;
+		goto out_free;
+	}
+
+	desc = (remote_token_desc *)(resp + 1);
+	for (i = 0 ; i < resp->num_tokens ; ++i) {
+		tokens[i] = remote_new_token(&desc[i]);
+		if (!tokens[i]) {
+			while (i--)
+				remote_fpgaDestroyToken(&tokens[i]);
+			res = FPGA_NO_MEMORY;
+			goto out_free;
+		}
+	}
+
+	*num_matches = resp->num_matches;
+
+out_free:
+	opae_free(resp);
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaCloneToken(fpga_token src,
+						 fpga_token *dst)
+{
+	remote_token *t;
+	remote_token *clone;
+	uint64_t id = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(dst);
+	t = token_check(src);
+	ASSERT_NOT_NULL(t);
+
+	res = remote_request_id(REMOTE_CLONE_TOKEN, t->id, 0, 0, 0, &id);
+	if (res != FPGA_OK)
+		return res;
+
+	clone = opae_malloc(sizeof(remote_token));
+	if (!clone) {
+		remote_request_id(REMOTE_DESTROY_TOKEN, id, 0, 0, 0, NULL);
+		return FPGA_NO_MEMORY;
+	}
+
+	*clone = *t;
+	clone->id = id;
+	*dst = clone;
+
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaDestroyToken(fpga_token *token)
+{
+	remote_token *t;
+	remote_id_req req;
+	struct iovec iov = { &req, sizeof(req) };
+
+	if (!token || !*token) {
+		OPAE_ERR("invalid token pointer");
+		return FPGA_INVALID_PARAM;
+	}
+
+	t = token_check(*token);
+	ASSERT_NOT_NULL_RESULT(t, FPGA_INVALID_PARAM);
+
+	memset(&req, 0, sizeof(req));
+	req.id = t->id;
+	if (remote_conn)
+		remote_call_posted(remote_conn, REMOTE_DESTROY_TOKEN, &iov, 1);
+
+	t->hdr.magic = 0;
+	opae_free(t);
+	*token = NULL;
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result remote_get_properties(uint16_t op, uint64_t id,
+					 struct _fpga_properties *p)
+{
+	remote_id_req req = { id, 0, 0, 0 };
+	remote_properties wire;
+	fpga_result res;
+
+	res = remote_request(op, &req, sizeof(req), &wire, sizeof(wire));
+	if (res == FPGA_OK)
+		remote_unpack_properties(&wire, p);
+
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaUpdateProperties(fpga_token token,
+						       fpga_properties prop)
+{
+	remote_token *t;
+	struct _fpga_properties *p;
+	fpga_result res;
+	int err;
+
+	t = token_check(token);
+	ASSERT_NOT_NULL(t);
+
+	p = opae_validate_and_lock_properties(prop);
+	if (!p) {
+		OPAE_ERR("Invalid properties object");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = remote_get_properties(REMOTE_GET_PROPERTIES, t->id, p);
+
+	opae_mutex_unlock(err, &p->lock);
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetProperties(fpga_token token,
+						    fpga_properties *prop)
+{
+	struct _fpga_properties *p;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(prop);
+
+	p = opae_properties_create();
+	if (!p)
+		return FPGA_NO_MEMORY;
+
+	if (token) {
+		res = remote_fpgaUpdateProperties(token, p);
+		if (res != FPGA_OK) {
+			fpgaDestroyProperties((fpga_properties *)&p);
+			return res;
+		}
+	}
+
+	*prop = p;
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__
+remote_fpgaGetPropertiesFromHandle(fpga_handle handle, fpga_properties *prop)
+{
+	remote_handle *h;
+	struct _fpga_properties *p;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(prop);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	p = opae_properties_create();
+	if (!p)
+		return FPGA_NO_MEMORY;
+
+	res = remote_get_properties(REMOTE_GET_PROPERTIES_FROM_HANDLE,
+				    h->id, p);
+	if (res != FPGA_OK) {
+		fpgaDestroyProperties((fpga_properties *)&p);
+		return res;
+	}
+
+	*prop = p;
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaOpen(fpga_token token,
+					   fpga_handle *handle, int flags)
+{
+	remote_token *t;
+	remote_handle *h;
+	uint64_t id = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(handle);
+	t = token_check(token);
+	ASSERT_NOT_NULL(t);
+
+	res = remote_request_id(REMOTE_OPEN, t->id, (uint64_t)flags,
+				0, 0, &id);
+	if (res != FPGA_OK)
+		return res;
+
+	h = opae_calloc(1, sizeof(remote_handle));
+	if (!h) {
+		remote_request_id(REMOTE_CLOSE, id, 0, 0, 0, NULL);
+		return FPGA_NO_MEMORY;
+	}
+
+	h->magic = REMOTE_HANDLE_MAGIC;
+	h->token = *t;
+	h->id = id;
+	*handle = h;
+
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaClose(fpga_handle handle)
+{
+	remote_handle *h;
+	fpga_result res;
+
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	res = remote_request_id(REMOTE_CLOSE, h->id, 0, 0, 0, NULL);
+
+	h->magic = 0;
+	opae_free(h);
+
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaReset(fpga_handle handle)
+{
+	remote_handle *h = handle_check(handle);
+
+	ASSERT_NOT_NULL(h);
+	return remote_request_id(REMOTE_RESET, h->id, 0, 0, 0, NULL);
+}
+
+STATIC fpga_result remote_read_mmio(remote_handle *h, uint16_t op,
+				    uint32_t mmio_num, uint64_t offset,
+				    uint64_t *value)
+{
+	remote_mmio_req req;
+
+	memset(&req, 0, sizeof(req));
+	req.handle = h->id;
+	req.offset = offset;
+	req.mmio_num = mmio_num;
+
+	return remote_request(op, &req, sizeof(req), value, sizeof(*value));
+}
+
+fpga_result __REMOTE_API__ remote_fpgaReadMMIO64(fpga_handle handle,
+						 uint32_t mmio_num,
+						 uint64_t offset,
+						 uint64_t *value)
+{
+	remote_handle *h;
+
+	ASSERT_NOT_NULL(value);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (offset % sizeof(uint64_t)) {
+		OPAE_ERR("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
+	}
+
+	return remote_read_mmio(h, REMOTE_READ_MMIO64, mmio_num,
+				offset, value);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaReadMMIO32(fpga_handle handle,
+						 uint32_t mmio_num,
+						 uint64_t offset,
+						 uint32_t *value)
+{
+	remote_handle *h;
+	uint64_t v = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(value);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (offset % sizeof(uint32_t)) {
+		OPAE_ERR("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = remote_read_mmio(h, REMOTE_READ_MMIO32, mmio_num, offset, &v);
+	if (res == FPGA_OK)
+		*value = (uint32_t)v;
+
+	return res;
+}
+
+// MMIO writes are posted and coalesced: they are sent in batches, and
+// a failure is reported in the server's log rather than to the caller.
+fpga_result __REMOTE_API__ remote_fpgaWriteMMIO64(fpga_handle handle,
+						  uint32_t mmio_num,
+						  uint64_t offset,
+						  uint64_t value)
+{
+	remote_handle *h = handle_check(handle);
+
+	ASSERT_NOT_NULL(h);
+
+	if (offset % sizeof(uint64_t)) {
+		OPAE_ERR("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
+	}
+
+	return remote_write_mmio(remote_conn, h->id, mmio_num,
+				 offset, value, 64);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaWriteMMIO32(fpga_handle handle,
+						  uint32_t mmio_num,
+						  uint64_t offset,
+						  uint32_t value)
+{
+	remote_handle *h = handle_check(handle);
+
+	ASSERT_NOT_NULL(h);
+
+	if (offset % sizeof(uint32_t)) {
+		OPAE_ERR("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
+	}
+
+	return remote_write_mmio(remote_conn, h->id, mmio_num,
+				 offset, value, 32);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaWriteMMIO512(fpga_handle handle,
+						   uint32_t mmio_num,
+						   uint64_t offset,
+						   const void *value)
+{
+	remote_handle *h;
+	remote_mmio512_req req;
+	struct iovec iov = { &req, sizeof(req) };
+
+	ASSERT_NOT_NULL(value);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (offset % 64) {
+		OPAE_ERR("Misaligned MMIO access");
+		return FPGA_INVALID_PARAM;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.handle = h->id;
+	req.offset = offset;
+	req.mmio_num = mmio_num;
+	memcpy(req.value, value, sizeof(req.value));
+
+	return remote_call_posted(remote_conn, REMOTE_WRITE_MMIO512, &iov, 1);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaReadError(fpga_token token,
+						uint32_t error_num,
+						uint64_t *value)
+{
+	remote_token *t;
+
+	ASSERT_NOT_NULL(value);
+	t = token_check(token);
+	ASSERT_NOT_NULL(t);
+
+	return remote_request_id(REMOTE_READ_ERROR, t->id, error_num,
+				 0, 0, value);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaClearError(fpga_token token,
+						 uint32_t error_num)
+{
+	remote_token *t = token_check(token);
+
+	ASSERT_NOT_NULL(t);
+	return remote_request_id(REMOTE_CLEAR_ERROR, t->id, error_num,
+				 0, 0, NULL);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaClearAllErrors(fpga_token token)
+{
+	remote_token *t = token_check(token);
+
+	ASSERT_NOT_NULL(t);
+	return remote_request_id(REMOTE_CLEAR_ALL_ERRORS, t->id, 0,
+				 0, 0, NULL);
+}
+
+fpga_result __REMOTE_API__
+remote_fpgaGetErrorInfo(fpga_token token, uint32_t error_num,
+			struct fpga_error_info *error_info)
+{
+	remote_token *t;
+	remote_id_req req;
+
+	ASSERT_NOT_NULL(error_info);
+	t = token_check(token);
+	ASSERT_NOT_NULL(t);
+
+	memset(&req, 0, sizeof(req));
+	req.id = t->id;
+	req.arg0 = error_num;
+
+	return remote_request(REMOTE_GET_ERROR_INFO, &req, sizeof(req),
+			      error_info, sizeof(*error_info));
+}
+
+fpga_result __REMOTE_API__
+remote_fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
+			   const uint8_t *bitstream, size_t bitstream_len,
+			   int flags)
+{
+	remote_handle *h;
+	remote_reconf_req req;
+	struct iovec iov[2];
+	uint64_t offset;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	ASSERT_NOT_NULL(bitstream);
+	h = handle_check(fpga);
+	ASSERT_NOT_NULL(h);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	if (bitstream_len > REMOTE_MAX_BITSTREAM) {
+		OPAE_ERR("bitstream is too large to send");
+		return FPGA_INVALID_PARAM;
+	}
+
+	opae_mutex_lock(err, &remote_reconf_lock);
+
+	// Stage the bitstream on the server in chunks. A failed chunk is
+	// reported by the reconfiguration that follows.
+	for (offset = 0 ; offset < bitstream_len ; offset += iov[1].iov_len) {
+		iov[0].iov_base = &offset;
+		iov[0].iov_len = sizeof(offset);
+		iov[1].iov_base = (void *)(bitstream + offset);
+		iov[1].iov_len = bitstream_len - offset;
+		if (iov[1].iov_len > REMOTE_MAX_CHUNK)
+			iov[1].iov_len = REMOTE_MAX_CHUNK;
+
+		res = remote_call_posted(remote_conn, REMOTE_BITSTREAM_DATA,
+					 iov, 2);
+		if (res != FPGA_OK)
+			goto out_unlock;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.handle = h->id;
+	req.bitstream_len = bitstream_len;
+	req.slot = slot;
+	req.flags = flags;
+
+	iov[0].iov_base = &req;
+	iov[0].iov_len = sizeof(req);
+
+	res = remote_call_sync(remote_conn, REMOTE_RECONFIGURE_SLOT,
+			       iov, 1, NULL, 0, NULL);
+
+out_unlock:
+	opae_mutex_unlock(err, &remote_reconf_lock);
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaSetUserClock(fpga_handle handle,
+						   uint64_t high_clk,
+						   uint64_t low_clk,
+						   int flags)
+{
+	remote_handle *h = handle_check(handle);
+
+	ASSERT_NOT_NULL(h);
+	return remote_request_id(REMOTE_SET_USER_CLOCK, h->id, high_clk,
+				 low_clk, (uint64_t)flags, NULL);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetUserClock(fpga_handle handle,
+						   uint64_t *high_clk,
+						   uint64_t *low_clk,
+						   int flags)
+{
+	remote_handle *h;
+	remote_id_req req;
+	uint64_t clk[2];
+	fpga_result res;
+
+	ASSERT_NOT_NULL(high_clk);
+	ASSERT_NOT_NULL(low_clk);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	memset(&req, 0, sizeof(req));
+	req.id = h->id;
+	req.arg0 = (uint64_t)flags;
+
+	res = remote_request(REMOTE_GET_USER_CLOCK, &req, sizeof(req),
+			     clk, sizeof(clk));
+	if (res == FPGA_OK) {
+		*high_clk = clk[0];
+		*low_clk = clk[1];
+	}
+
+	return res;
+}
+
+STATIC fpga_result remote_get_object(uint16_t op, uint64_t id,
+				     const char *name, int flags,
+				     fpga_object *object)
+{
+	remote_object_req req;
+	remote_object *o;
+	struct iovec iov[2];
+	uint64_t obj_id = 0;
+	size_t len = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(name);
+	ASSERT_NOT_NULL(object);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	memset(&req, 0, sizeof(req));
+	req.id = id;
+	req.flags = flags;
+	req.name_len = strlen(name) + 1;
+
+	iov[0].iov_base = &req;
+	iov[0].iov_len = sizeof(req);
+	iov[1].iov_base = (void *)name;
+	iov[1].iov_len = req.name_len;
+
+	res = remote_call_sync(remote_conn, op, iov, 2,
+			       &obj_id, sizeof(obj_id), &len);
+	if (res != FPGA_OK)
+		return res;
+
+	if (len != sizeof(obj_id))
+		return FPGA_EXCEPTION;
+
+	o = opae_calloc(1, sizeof(remote_object));
+	if (!o) {
+		remote_request_id(REMOTE_DESTROY_OBJECT, obj_id, 0, 0, 0, NULL);
+		return FPGA_NO_MEMORY;
+	}
+
+	o->magic = REMOTE_OBJECT_MAGIC;
+	o->id = obj_id;
+	*object = o;
+
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaTokenGetObject(fpga_token token,
+						     const char *name,
+						     fpga_object *object,
+						     int flags)
+{
+	remote_token *t = token_check(token);
+
+	ASSERT_NOT_NULL(t);
+	return remote_get_object(REMOTE_TOKEN_GET_OBJECT, t->id,
+				 name, flags, object);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaHandleGetObject(fpga_handle handle,
+						      const char *name,
+						      fpga_object *object,
+						      int flags)
+{
+	remote_handle *h = handle_check(handle);
+
+	ASSERT_NOT_NULL(h);
+	return remote_get_object(REMOTE_HANDLE_GET_OBJECT, h->id,
+				 name, flags, object);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectGetObject(fpga_object parent,
+						      const char *name,
+						      fpga_object *object,
+						      int flags)
+{
+	remote_object *o = object_check(parent);
+
+	ASSERT_NOT_NULL(o);
+	return remote_get_object(REMOTE_OBJECT_GET_OBJECT, o->id,
+				 name, flags, object);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectGetObjectAt(fpga_object parent,
+							size_t index,
+							fpga_object *object)
+{
+	remote_object *o;
+	remote_object *child;
+	uint64_t id = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(object);
+	o = object_check(parent);
+	ASSERT_NOT_NULL(o);
+
+	res = remote_request_id(REMOTE_OBJECT_GET_OBJECT_AT, o->id,
+				index, 0, 0, &id);
+	if (res != FPGA_OK)
+		return res;
+
+	child = opae_calloc(1, sizeof(remote_object));
+	if (!child) {
+		remote_request_id(REMOTE_DESTROY_OBJECT, id, 0, 0, 0, NULL);
+		return FPGA_NO_MEMORY;
+	}
+
+	child->magic = REMOTE_OBJECT_MAGIC;
+	child->id = id;
+	*object = child;
+
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaDestroyObject(fpga_object *obj)
+{
+	remote_object *o;
+	remote_id_req req;
+	struct iovec iov = { &req, sizeof(req) };
+
+	ASSERT_NOT_NULL(obj);
+	o = object_check(*obj);
+	ASSERT_NOT_NULL_RESULT(o, FPGA_INVALID_PARAM);
+
+	memset(&req, 0, sizeof(req));
+	req.id = o->id;
+	if (remote_conn)
+		remote_call_posted(remote_conn, REMOTE_DESTROY_OBJECT, &iov, 1);
+
+	if (o->names)
+		opae_free(o->names);
+	o->magic = 0;
+	opae_free(o);
+	*obj = NULL;
+
+	return FPGA_OK;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectRead(fpga_object obj,
+						 uint8_t *buffer,
+						 size_t offset,
+						 size_t len, int flags)
+{
+	remote_object *o;
+	remote_id_req req;
+	struct iovec iov = { &req, sizeof(req) };
+	size_t done = 0;
+	size_t got = 0;
+	fpga_result res = FPGA_OK;
+
+	ASSERT_NOT_NULL(buffer);
+	o = object_check(obj);
+	ASSERT_NOT_NULL(o);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	memset(&req, 0, sizeof(req));
+	req.id = o->id;
+	req.arg2 = (uint64_t)flags;
+
+	// The responses land directly in the caller's buffer.
+	do {
+		req.arg0 = offset + done;
+		req.arg1 = len - done;
+		if (req.arg1 > REMOTE_MAX_CHUNK)
+			req.arg1 = REMOTE_MAX_CHUNK;
+
+		res = remote_call_sync(remote_conn, REMOTE_OBJECT_READ,
+				       &iov, 1, buffer + done,
+				       (size_t)req.arg1, &got);
+		if (res == FPGA_OK && got != req.arg1)
+			res = FPGA_EXCEPTION;
+
+		done += got;
+	} while (res == FPGA_OK && done < len);
+
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectReadv(fpga_object obj,
+						  fpga_object_window *windows,
+						  size_t count, int flags)
+{
+	remote_object *o;
+	remote_readv_req req;
+	remote_window wire[REMOTE_READV_MAX];
+	uint8_t *dst[REMOTE_READV_MAX];
+	uint8_t *data;
+	struct iovec iov[2];
+	size_t i = 0;
+	size_t done = 0;
+	size_t got = 0;
+	fpga_result res = FPGA_OK;
+
+	ASSERT_NOT_NULL(windows);
+	o = object_check(obj);
+	ASSERT_NOT_NULL(o);
+
+	for (i = 0 ; i < count ; ++i)
+		ASSERT_NOT_NULL(windows[i].buffer);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	data = opae_malloc(REMOTE_MAX_CHUNK);
+	if (!data)
+		return FPGA_NO_MEMORY;
+
+	memset(&req, 0, sizeof(req));
+	req.id = o->id;
+	req.flags = flags;
+
+	iov[0].iov_base = &req;
+	iov[0].iov_len = sizeof(req);
+	iov[1].iov_base = wire;
+
+	// Split the windows into requests of REMOTE_MAX_CHUNK bytes at
+	// most; done is how much of windows[i] earlier requests read.
+	i = 0;
+	while (i < count && res == FPGA_OK) {
+		size_t total = 0;
+		uint32_t n = 0;
+		uint32_t j;
+		uint8_t *p;
+
+		while (i < count && n < REMOTE_READV_MAX &&
+		       total < REMOTE_MAX_CHUNK) {
+			size_t piece = windows[i].len - done;
+
+			if (piece > REMOTE_MAX_CHUNK - total)
+				piece = REMOTE_MAX_CHUNK - total;
+
+			wire[n].offset = windows[i].offset + done;
+			wire[n].len = piece;
+			dst[n++] = windows[i].buffer + done;
+			total += piece;
+
+			done += piece;
+			if (done == windows[i].len) {
+				++i;
+				done = 0;
+			}
+		}
+
+		req.count = n;
+		iov[1].iov_len = n * sizeof(remote_window);
+
+		res = remote_call_sync(remote_conn, REMOTE_OBJECT_READV,
+				       iov, 2, data, total, &got);
+		if (res == FPGA_OK && got != total)
+			res = FPGA_EXCEPTION;
+
+		for (j = 0, p = data ; res == FPGA_OK && j < n ; ++j) {
+			memcpy(dst[j], p, wire[j].len);
+			p += wire[j].len;
+		}
+	}
+
+	opae_free(data);
+	return res;
+}
+
+// The names are kept with the object, so that values[].name stays
+// valid until the group is read again or destroyed.
+fpga_result __REMOTE_API__ remote_fpgaObjectReadGroup(fpga_object group,
+						      fpga_object_value *values,
+						      size_t count,
+						      size_t *changed,
+						      int flags)
+{
+	remote_object *o;
+	remote_id_req req;
+	remote_group_resp *resp;
+	remote_group_value *wire;
+	const char *names;
+	size_t resp_cap;
+	size_t resp_len = 0;
+	size_t names_len;
+	size_t n;
+	size_t i;
+	struct iovec iov = { &req, sizeof(req) };
+	fpga_result res;
+
+	ASSERT_NOT_NULL(values);
+	o = object_check(group);
+	ASSERT_NOT_NULL(o);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	if (!count)
+		return FPGA_INVALID_PARAM;
+
+	// Room for the values and for names of up to 256 bytes each.
+	resp_cap = REMOTE_MAX_PAYLOAD;
+	if (count < (REMOTE_MAX_PAYLOAD - sizeof(*resp)) /
+		    (sizeof(remote_group_value) + 256))
+		resp_cap = sizeof(*resp) +
+			   count * (sizeof(remote_group_value) + 256);
+
+	resp = opae_malloc(resp_cap);
+	if (!resp)
+		return FPGA_NO_MEMORY;
+
+	memset(&req, 0, sizeof(req));
+	req.id = o->id;
+	req.arg0 = count;
+	req.arg1 = (uint64_t)flags;
+
+	res = remote_call_sync(remote_conn, REMOTE_OBJECT_READ_GROUP,
+			       &iov, 1, resp, resp_cap, &resp_len);
+	if (res != FPGA_OK)
+		goto out_free;
+
+	if (resp_len < sizeof(*resp) || resp->count > count ||
+	    resp_len - sizeof(*resp) <
+	    resp->count * sizeof(remote_group_value)) {
+		res = FPGA_EXCEPTION;
+		goto out_free;
+	}
+
+	wire = (remote_group_value *)(resp + 1);
+	names = (const char *)(wire + resp->count);
+	names_len = resp_len - sizeof(*resp) -
+		    resp->count * sizeof(remote_group_value);
+
+	// Every name must be NUL-terminated within the response.
+	for (i = 0, n = 0 ; i < resp->count ; ++i) {
+		n += wire[i].name_len;
+		if (!wire[i].name_len || n > names_len || names[n - 1]) {
+			res = FPGA_EXCEPTION;
+			goto out_free;
+		}
+	}
+
+	if (!o->names || names_len != o->names_len ||
+	    memcmp(names, o->names, names_len)) {
+		char *copy = opae_malloc(names_len ? names_len : 1);
+
+		if (!copy) {
+			res = FPGA_NO_MEMORY;
+			goto out_free;
+		}
+
+		memcpy(copy, names, names_len);
+		if (o->names)
+			opae_free(o->names);
+		o->names = copy;
+		o->names_len = names_len;
+	}
+
+	names = o->names;
+	for (i = 0 ; i < resp->count ; ++i) {
+		values[i].name = names;
+		values[i].value = wire[i].value;
+		values[i].result = (fpga_result)wire[i].result;
+		values[i].changed = wire[i].changed != 0;
+		names += wire[i].name_len;
+	}
+
+	if (changed)
+		*changed = (size_t)resp->changed;
+
+out_free:
+	opae_free(resp);
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectRead64(fpga_object obj,
+						   uint64_t *value,
+						   int flags)
+{
+	remote_object *o;
+
+	ASSERT_NOT_NULL(value);
+	o = object_check(obj);
+	ASSERT_NOT_NULL(o);
+
+	return remote_request_id(REMOTE_OBJECT_READ64, o->id,
+				 (uint64_t)flags, 0, 0, value);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectWrite64(fpga_object obj,
+						    uint64_t value,
+						    int flags)
+{
+	remote_object *o = object_check(obj);
+
+	ASSERT_NOT_NULL(o);
+	return remote_request_id(REMOTE_OBJECT_WRITE64, o->id, value,
+				 (uint64_t)flags, 0, NULL);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaObjectGetSize(fpga_object obj,
+						    uint32_t *value,
+						    int flags)
+{
+	remote_object *o;
+	uint64_t v = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(value);
+	o = object_check(obj);
+	ASSERT_NOT_NULL(o);
+
+	res = remote_request_id(REMOTE_OBJECT_GET_SIZE, o->id,
+				(uint64_t)flags, 0, 0, &v);
+	if (res == FPGA_OK)
+		*value = (uint32_t)v;
+
+	return res;
+}
+
+fpga_result __REMOTE_API__
+remote_fpgaObjectGetType(fpga_object obj, enum fpga_sysobject_type *type)
+{
+	remote_object *o;
+	uint64_t v = 0;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(type);
+	o = object_check(obj);
+	ASSERT_NOT_NULL(o);
+
+	res = remote_request_id(REMOTE_OBJECT_GET_TYPE, o->id, 0, 0, 0, &v);
+	if (res == FPGA_OK)
+		*type = (enum fpga_sysobject_type)v;
+
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetNumMetrics(fpga_handle handle,
+						    uint64_t *num_metrics)
+{
+	remote_handle *h;
+
+	ASSERT_NOT_NULL(num_metrics);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	return remote_request_id(REMOTE_GET_NUM_METRICS, h->id,
+				 0, 0, 0, num_metrics);
+}
+
+// Fetch entries [0, *num) of a table kept by the server, as many per
+// request as fit in a message. *num receives the number fetched.
+STATIC fpga_result remote_get_table(uint16_t op, uint64_t id, void *table,
+				    size_t entry_size, uint64_t *num)
+{
+	remote_id_req req;
+	remote_table_resp *resp;
+	struct iovec iov = { &req, sizeof(req) };
+	size_t resp_len = 0;
+	uint64_t first = 0;
+	fpga_result res = FPGA_OK;
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	resp = opae_malloc(REMOTE_MAX_PAYLOAD);
+	if (!resp)
+		return FPGA_NO_MEMORY;
+
+	memset(&req, 0, sizeof(req));
+	req.id = id;
+
+	do {
+		req.arg0 = first;
+		req.arg1 = *num - first;
+
+		res = remote_call_sync(remote_conn, op, &iov, 1, resp,
+				       REMOTE_MAX_PAYLOAD, &resp_len);
+		if (res != FPGA_OK)
+			break;
+
+		if (resp_len < sizeof(*resp) ||
+		    resp->count > req.arg1 ||
+		    resp_len != sizeof(*resp) + resp->count * entry_size) {
+			res = FPGA_EXCEPTION;
+			break;
+		}
+
+		if (table)
+			memcpy((uint8_t *)table + first * entry_size,
+			       resp + 1, resp->count * entry_size);
+		first += resp->count;
+	} while (table && resp->count && first < *num);
+
+	if (res == FPGA_OK)
+		*num = table ? first : resp->total;
+
+	opae_free(resp);
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetMetricsInfo(fpga_handle handle,
+						     fpga_metric_info *metric_info,
+						     uint64_t *num_metrics)
+{
+	remote_handle *h;
+	uint64_t num;
+
+	ASSERT_NOT_NULL(metric_info);
+	ASSERT_NOT_NULL(num_metrics);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	num = *num_metrics;
+	return remote_get_table(REMOTE_GET_METRICS_INFO, h->id, metric_info,
+				sizeof(*metric_info), &num);
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetMetricsByIndex(fpga_handle handle,
+							uint64_t *metric_num,
+							uint64_t num_metric_indexes,
+							fpga_metric *metrics)
+{
+	const uint64_t max = REMOTE_MAX_PAYLOAD / sizeof(fpga_metric);
+	remote_handle *h;
+	remote_id_req req;
+	struct iovec iov[2];
+	uint64_t first;
+	size_t len = 0;
+	fpga_result res = FPGA_OK;
+
+	ASSERT_NOT_NULL(metric_num);
+	ASSERT_NOT_NULL(metrics);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	memset(&req, 0, sizeof(req));
+	req.id = h->id;
+
+	iov[0].iov_base = &req;
+	iov[0].iov_len = sizeof(req);
+
+	for (first = 0 ; first < num_metric_indexes ; first += max) {
+		uint64_t n = num_metric_indexes - first;
+
+		if (n > max)
+			n = max;
+
+		iov[1].iov_base = metric_num + first;
+		iov[1].iov_len = n * sizeof(uint64_t);
+
+		res = remote_call_sync(remote_conn, REMOTE_GET_METRICS_BY_INDEX,
+				       iov, 2, metrics + first,
+				       n * sizeof(fpga_metric), &len);
+		if (res == FPGA_OK && len != n * sizeof(fpga_metric))
+			res = FPGA_EXCEPTION;
+		if (res != FPGA_OK)
+			break;
+	}
+
+	return res;
+}
+
+fpga_result __REMOTE_API__ remote_fpgaGetMetricsByName(fpga_handle handle,
+						       char **metrics_names,
+						       uint64_t num_metric_names,
+						       fpga_metric *metrics)
+{
+	const uint64_t max = REMOTE_MAX_PAYLOAD / sizeof(fpga_metric);
+	remote_handle *h;
+	remote_names_req *req;
+	uint8_t *buf;
+	uint64_t first = 0;
+	size_t len = 0;
+	fpga_result res = FPGA_OK;
+
+	ASSERT_NOT_NULL(metrics_names);
+	ASSERT_NOT_NULL(metrics);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	if (!remote_conn)
+		return FPGA_NO_DRIVER;
+
+	buf = opae_malloc(REMOTE_MAX_PAYLOAD);
+	if (!buf)
+		return FPGA_NO_MEMORY;
+
+	req = (remote_names_req *)buf;
+	req->handle = h->id;
+
+	// Pack as many names as fit in each request.
+	while (first < num_metric_names) {
+		size_t used = sizeof(*req);
+		struct iovec iov;
+
+		req->count = 0;
+		while (first + req->count < num_metric_names &&
+		       req->count < max) {
+			const char *name = metrics_names[first + req->count];
+			size_t name_len;
+
+			if (!name) {
+				res = FPGA_INVALID_PARAM;
+				goto out_free;
+			}
+
+			name_len = strlen(name) + 1;
+			if (used + name_len > REMOTE_MAX_PAYLOAD)
+				break;
+
+			memcpy(buf + used, name, name_len);
+			used += name_len;
+			++req->count;
+		}
+
+		if (!req->count) {
+			OPAE_ERR("metric name is too long");
+			res = FPGA_INVALID_PARAM;
+			goto out_free;
+		}
+
+		iov.iov_base = buf;
+		iov.iov_len = used;
+
+		res = remote_call_sync(remote_conn, REMOTE_GET_METRICS_BY_NAME,
+				       &iov, 1, metrics + first,
+				       req->count * sizeof(fpga_metric), &len);
+		if (res == FPGA_OK && len != req->count * sizeof(fpga_metric))
+			res = FPGA_EXCEPTION;
+		if (res != FPGA_OK)
+			goto out_free;
+
+		first += req->count;
+	}
+
+out_free:
+	opae_free(buf);
+	return res;
+}
+
+fpga_result __REMOTE_API__
+remote_fpgaGetMetricsThresholdInfo(fpga_handle handle,
+				   metric_threshold *metric_thresholds,
+				   uint32_t *num_thresholds)
+{
+	remote_handle *h;
+	uint64_t num;
+	fpga_result res;
+
+	ASSERT_NOT_NULL(num_thresholds);
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+
+	// Without an array, only the number of thresholds is returned.
+	num = metric_thresholds ? *num_thresholds : 0;
+	res = remote_get_table(REMOTE_GET_METRICS_THRESHOLD_INFO, h->id,
+			       metric_thresholds, sizeof(*metric_thresholds),
+			       &num);
+	if (res == FPGA_OK)
+		*num_thresholds = (uint32_t)num;
+
+	return res;
+}
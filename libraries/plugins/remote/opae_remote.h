@@ -0,0 +1,128 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_REMOTE_PLUGIN_H__
+#define __OPAE_REMOTE_PLUGIN_H__
+#include <pthread.h>
+#include <time.h>
+
+#include <opae/fpga.h>
+
+#include "remote_proto.h"
+
+#define REMOTE_TOKEN_MAGIC  0x52454d4f54544f4bULL // REMOTTOK
+#define REMOTE_HANDLE_MAGIC 0x52484e44            // RHND
+#define REMOTE_OBJECT_MAGIC 0x524f424a            // ROBJ
+
+typedef struct _remote_token {
+	fpga_token_header hdr; //< Must appear at offset 0!
+	uint64_t id;           //< server-side token id
+} remote_token;
+
+typedef struct _remote_handle {
+	uint32_t magic;
+	remote_token token;    //< copy of the token that was opened
+	uint64_t id;           //< server-side handle id
+} remote_handle;
+
+typedef struct _remote_object {
+	uint32_t magic;
+	uint64_t id;           //< server-side object id
+	char *names;           //< child names of the last fpgaObjectReadGroup()
+	size_t names_len;
+} remote_object;
+
+// Counters kept per connection, for tuning and for the tests.
+typedef struct _remote_client_stats {
+	uint64_t requests;      //< requests that waited for a response
+	uint64_t posted;        //< requests sent without a response
+	uint64_t mmio_writes;   //< MMIO writes submitted
+	uint64_t write_batches; //< REMOTE_WRITE_BATCH messages sent
+} remote_client_stats;
+
+typedef struct _remote_call remote_call;
+
+// Coalesced MMIO writes are sent once this many are queued, or when
+// the oldest has waited coalesce_us, or ahead of any other request.
+#define REMOTE_BATCH_MAX 256
+#define REMOTE_DEFAULT_COALESCE_US 50
+
+typedef struct _remote_client {
+	remote_transport tr;
+
+	// Sending: one thread at a time, in sequence number order.
+	pthread_mutex_t send_lock;
+	uint32_t next_seq;
+	remote_mmio_write batch[REMOTE_BATCH_MAX];
+	uint32_t batch_count;
+	struct timespec batch_start;
+	uint32_t coalesce_us;
+	pthread_cond_t flush_cond;
+	pthread_t flusher;
+	bool flusher_running;
+	bool stopping;
+
+	// Receiving: the first waiting thread reads responses and hands
+	// each one to the call that matches its sequence number.
+	pthread_mutex_t recv_lock;
+	pthread_cond_t recv_cond;
+	remote_call *calls;
+	bool reading;
+
+	bool broken;
+	remote_client_stats stats;
+} remote_client;
+
+// key, when not NULL, is the REMOTE_KEY_SIZE byte key that the
+// server may challenge the client for.
+remote_client *remote_client_connect(const char *endpoint,
+				     const uint8_t *key,
+				     uint32_t coalesce_us);
+void remote_client_disconnect(remote_client *c);
+
+// Send a request and wait for its response. Up to resp_cap bytes of
+// the response payload are stored to resp.
+fpga_result remote_call_sync(remote_client *c, uint16_t op,
+			     const struct iovec *req, int reqcnt,
+			     void *resp, size_t resp_cap, size_t *resp_len);
+
+// Send a request that has no response.
+fpga_result remote_call_posted(remote_client *c, uint16_t op,
+			       const struct iovec *req, int reqcnt);
+
+// Queue an MMIO write for coalescing.
+fpga_result remote_write_mmio(remote_client *c, uint64_t handle,
+			      uint32_t mmio_num, uint64_t offset,
+			      uint64_t value, uint32_t width);
+
+// Send any queued MMIO writes now.
+fpga_result remote_flush(remote_client *c);
+
+void remote_client_get_stats(remote_client *c, remote_client_stats *stats);
+
+// The plugin's connection, made by remote_plugin_initialize().
+extern remote_client *remote_conn;
+
+#endif // __OPAE_REMOTE_PLUGIN_H__
@@ -0,0 +1,219 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <json-c/json.h>
+
+#include <opae/types_enum.h>
+
+#include "adapter.h"
+#include "opae_int.h"
+#include "opae_remote.h"
+#include "mock/opae_std.h"
+
+#ifndef __REMOTE_API__
+#define __REMOTE_API__
+#endif
+
+STATIC char remote_endpoint[256];
+STATIC char remote_key_file[256];
+STATIC uint32_t remote_coalesce_us = REMOTE_DEFAULT_COALESCE_US;
+
+// Settings come from the plugin's "configuration" object, and
+// OPAE_REMOTE_ENDPOINT / OPAE_REMOTE_KEY_FILE /
+// OPAE_REMOTE_COALESCE_US override them.
+STATIC void remote_parse_config(const char *jsonConfig)
+{
+	json_object *root = NULL;
+	json_object *j;
+	char *s;
+
+	if (jsonConfig)
+		root = json_tokener_parse(jsonConfig);
+
+	if (root) {
+		if (json_object_object_get_ex(root, "endpoint", &j) &&
+		    json_object_is_type(j, json_type_string)) {
+			strncpy(remote_endpoint, json_object_get_string(j),
+				sizeof(remote_endpoint) - 1);
+		}
+
+		if (json_object_object_get_ex(root, "key_file", &j) &&
+		    json_object_is_type(j, json_type_string)) {
+			strncpy(remote_key_file, json_object_get_string(j),
+				sizeof(remote_key_file) - 1);
+		}
+
+		if (json_object_object_get_ex(root, "coalesce_us", &j) &&
+		    json_object_is_type(j, json_type_int))
+			remote_coalesce_us = (uint32_t)json_object_get_int(j);
+
+		json_object_put(root);
+	}
+
+	s = getenv("OPAE_REMOTE_ENDPOINT");
+	if (s)
+		strncpy(remote_endpoint, s, sizeof(remote_endpoint) - 1);
+
+	s = getenv("OPAE_REMOTE_KEY_FILE");
+	if (s)
+		strncpy(remote_key_file, s, sizeof(remote_key_file) - 1);
+
+	s = getenv("OPAE_REMOTE_COALESCE_US");
+	if (s)
+		remote_coalesce_us = (uint32_t)strtoul(s, NULL, 0);
+}
+
+int __REMOTE_API__ remote_plugin_initialize(void)
+{
+	uint8_t key[REMOTE_KEY_SIZE];
+
+	if (!remote_endpoint[0]) {
+		OPAE_ERR("no remote endpoint configured");
+		return 1;
+	}
+
+	if (remote_key_file[0] && remote_load_key(remote_key_file, key))
+		return 1;
+
+	remote_conn = remote_client_connect(remote_endpoint,
+					    remote_key_file[0] ? key : NULL,
+					    remote_coalesce_us);
+	memset(key, 0, sizeof(key));
+	if (!remote_conn) {
+		OPAE_ERR("failed to connect to %s", remote_endpoint);
+		return 1;
+	}
+
+	return 0;
+}
+
+int __REMOTE_API__ remote_plugin_finalize(void)
+{
+	if (remote_conn) {
+		remote_client_disconnect(remote_conn);
+		remote_conn = NULL;
+	}
+
+	return 0;
+}
+
+int __REMOTE_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
+					 const char *jsonConfig)
+{
+	remote_parse_config(jsonConfig);
+
+	adapter->fpgaOpen =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaOpen");
+	adapter->fpgaClose =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaClose");
+	adapter->fpgaReset =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaReset");
+	adapter->fpgaGetPropertiesFromHandle = dlsym(
+		adapter->plugin.dl_handle, "remote_fpgaGetPropertiesFromHandle");
+	adapter->fpgaGetProperties =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetProperties");
+	adapter->fpgaUpdateProperties =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaUpdateProperties");
+	adapter->fpgaWriteMMIO64 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaWriteMMIO64");
+	adapter->fpgaReadMMIO64 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaReadMMIO64");
+	adapter->fpgaWriteMMIO32 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaWriteMMIO32");
+	adapter->fpgaReadMMIO32 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaReadMMIO32");
+	adapter->fpgaWriteMMIO512 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaWriteMMIO512");
+	adapter->fpgaEnumerate =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaEnumerate");
+	adapter->fpgaCloneToken =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaCloneToken");
+	adapter->fpgaDestroyToken =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaDestroyToken");
+	adapter->fpgaReadError =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaReadError");
+	adapter->fpgaClearError =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaClearError");
+	adapter->fpgaClearAllErrors =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaClearAllErrors");
+	adapter->fpgaGetErrorInfo =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetErrorInfo");
+	adapter->fpgaReconfigureSlot =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaReconfigureSlot");
+	adapter->fpgaSetUserClock =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaSetUserClock");
+	adapter->fpgaGetUserClock =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetUserClock");
+	adapter->fpgaTokenGetObject =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaTokenGetObject");
+	adapter->fpgaHandleGetObject =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaHandleGetObject");
+	adapter->fpgaObjectGetObject =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectGetObject");
+	adapter->fpgaObjectGetObjectAt =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectGetObjectAt");
+	adapter->fpgaDestroyObject =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaDestroyObject");
+	adapter->fpgaObjectRead =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectRead");
+	adapter->fpgaObjectRead64 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectRead64");
+	adapter->fpgaObjectReadv =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectReadv");
+	adapter->fpgaObjectReadGroup =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectReadGroup");
+	adapter->fpgaObjectWrite64 =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectWrite64");
+	adapter->fpgaObjectGetSize =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectGetSize");
+	adapter->fpgaObjectGetType =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaObjectGetType");
+
+	adapter->fpgaGetNumMetrics =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetNumMetrics");
+	adapter->fpgaGetMetricsInfo =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetMetricsInfo");
+	adapter->fpgaGetMetricsByIndex =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetMetricsByIndex");
+	adapter->fpgaGetMetricsByName =
+		dlsym(adapter->plugin.dl_handle, "remote_fpgaGetMetricsByName");
+	adapter->fpgaGetMetricsThresholdInfo = dlsym(
+		adapter->plugin.dl_handle, "remote_fpgaGetMetricsThresholdInfo");
+
+	adapter->initialize =
+		dlsym(adapter->plugin.dl_handle, "remote_plugin_initialize");
+	adapter->finalize =
+		dlsym(adapter->plugin.dl_handle, "remote_plugin_finalize");
+
+	return 0;
+}
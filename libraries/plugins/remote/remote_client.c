@@ -0,0 +1,449 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <errno.h>
+#include <string.h>
+
+#include <opae/log.h>
+
+#include "opae_remote.h"
+#include "opae_int.h"
+#include "mock/opae_std.h"
+
+struct _remote_call {
+	uint32_t seq;
+	bool done;
+	fpga_result result;
+	void *resp;
+	size_t resp_cap;
+	size_t resp_len;
+	struct _remote_call *next;
+};
+
+// Caller holds recv_lock.
+STATIC void remote_fail_calls(remote_client *c)
+{
+	remote_call *call;
+
+	c->broken = true;
+
+	for (call = c->calls ; call ; call = call->next) {
+		call->result = FPGA_EXCEPTION;
+		call->done = true;
+	}
+
+	c->calls = NULL;
+}
+
+// Caller holds send_lock. Queued MMIO writes always go out ahead of
+// the request, so the server sees every access in program order.
+STATIC fpga_result remote_send_locked(remote_client *c, remote_hdr *hdr,
+				      const struct iovec *req, int reqcnt)
+{
+	struct iovec iov[8];
+	remote_hdr batch_hdr;
+	size_t len = 0;
+	int n = 0;
+	int i;
+
+	if (c->broken)
+		return FPGA_EXCEPTION;
+
+	if (reqcnt > 4)
+		return FPGA_INVALID_PARAM;
+
+	// The server drops a connection that sends more.
+	for (i = 0 ; i < reqcnt ; ++i)
+		len += req[i].iov_len;
+	if (len > REMOTE_MAX_PAYLOAD)
+		return FPGA_INVALID_PARAM;
+
+	if (c->batch_count) {
+		memset(&batch_hdr, 0, sizeof(batch_hdr));
+		batch_hdr.op = REMOTE_WRITE_BATCH;
+		batch_hdr.flags = REMOTE_FLAG_POSTED;
+		batch_hdr.seq = c->next_seq++;
+		batch_hdr.len = c->batch_count * sizeof(remote_mmio_write);
+
+		iov[n].iov_base = &batch_hdr;
+		iov[n++].iov_len = sizeof(batch_hdr);
+		iov[n].iov_base = c->batch;
+		iov[n++].iov_len = batch_hdr.len;
+
+		c->batch_count = 0;
+		++c->stats.write_batches;
+	}
+
+	if (hdr) {
+		hdr->len = (uint32_t)len;
+
+		iov[n].iov_base = hdr;
+		iov[n++].iov_len = sizeof(*hdr);
+		for (i = 0 ; i < reqcnt ; ++i)
+			iov[n++] = req[i];
+	}
+
+	if (!n)
+		return FPGA_OK;
+
+	if (remote_send(&c->tr, iov, n)) {
+		int err;
+
+		OPAE_ERR("lost connection to the remote server");
+		opae_mutex_lock(err, &c->recv_lock);
+		remote_fail_calls(c);
+		pthread_cond_broadcast(&c->recv_cond);
+		opae_mutex_unlock(err, &c->recv_lock);
+		return FPGA_EXCEPTION;
+	}
+
+	return FPGA_OK;
+}
+
+// Read one response and hand it to its call. On success, *done is
+// the completed call (or NULL when no call matched).
+STATIC int remote_read_response(remote_client *c, remote_call **done)
+{
+	remote_hdr hdr;
+	remote_call **pp;
+	remote_call *call = NULL;
+	size_t n = 0;
+	int err;
+
+	*done = NULL;
+
+	if (remote_recv(&c->tr, &hdr, sizeof(hdr)) ||
+	    hdr.len > REMOTE_MAX_PAYLOAD)
+		return -1;
+
+	opae_mutex_lock(err, &c->recv_lock);
+	for (pp = &c->calls ; *pp ; pp = &(*pp)->next) {
+		if ((*pp)->seq == hdr.seq) {
+			call = *pp;
+			*pp = call->next;
+			break;
+		}
+	}
+	opae_mutex_unlock(err, &c->recv_lock);
+
+	*done = call;
+
+	if (call) {
+		n = hdr.len < call->resp_cap ? hdr.len : call->resp_cap;
+		if (n && remote_recv(&c->tr, call->resp, n))
+			return -1;
+		call->resp_len = n;
+		call->result = (fpga_result)hdr.result;
+	} else {
+		OPAE_ERR("unexpected response (seq %u)", hdr.seq);
+	}
+
+	return remote_discard(&c->tr, hdr.len - n);
+}
+
+fpga_result remote_call_sync(remote_client *c, uint16_t op,
+			     const struct iovec *req, int reqcnt,
+			     void *resp, size_t resp_cap, size_t *resp_len)
+{
+	remote_call call;
+	remote_hdr hdr;
+	fpga_result res;
+	int err;
+
+	memset(&call, 0, sizeof(call));
+	call.resp = resp;
+	call.resp_cap = resp_cap;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.op = op;
+
+	opae_mutex_lock(err, &c->send_lock);
+
+	call.seq = hdr.seq = c->next_seq++;
+
+	// Register the call before sending, so that its response can't
+	// arrive ahead of it.
+	opae_mutex_lock(err, &c->recv_lock);
+	if (c->broken) {
+		opae_mutex_unlock(err, &c->recv_lock);
+		opae_mutex_unlock(err, &c->send_lock);
+		return FPGA_EXCEPTION;
+	}
+	call.next = c->calls;
+	c->calls = &call;
+	opae_mutex_unlock(err, &c->recv_lock);
+
+	res = remote_send_locked(c, &hdr, req, reqcnt);
+	++c->stats.requests;
+
+	opae_mutex_unlock(err, &c->send_lock);
+
+	opae_mutex_lock(err, &c->recv_lock);
+
+	if (res != FPGA_OK && !call.done) {
+		remote_call **pp;
+
+		for (pp = &c->calls ; *pp ; pp = &(*pp)->next) {
+			if (*pp == &call) {
+				*pp = call.next;
+				break;
+			}
+		}
+		opae_mutex_unlock(err, &c->recv_lock);
+		return res;
+	}
+
+	while (!call.done) {
+		remote_call *completed;
+		int failed;
+
+		if (c->reading) {
+			pthread_cond_wait(&c->recv_cond, &c->recv_lock);
+			continue;
+		}
+
+		c->reading = true;
+		opae_mutex_unlock(err, &c->recv_lock);
+
+		failed = remote_read_response(c, &completed);
+
+		opae_mutex_lock(err, &c->recv_lock);
+		c->reading = false;
+
+		if (completed) {
+			if (failed)
+				completed->result = FPGA_EXCEPTION;
+			completed->done = true;
+		}
+
+		if (failed) {
+			OPAE_ERR("lost connection to the remote server");
+			remote_fail_calls(c);
+		}
+
+		pthread_cond_broadcast(&c->recv_cond);
+	}
+
+	opae_mutex_unlock(err, &c->recv_lock);
+
+	if (resp_len)
+		*resp_len = call.resp_len;
+
+	return call.result;
+}
+
+fpga_result remote_call_posted(remote_client *c, uint16_t op,
+			       const struct iovec *req, int reqcnt)
+{
+	remote_hdr hdr;
+	fpga_result res;
+	int err;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.op = op;
+	hdr.flags = REMOTE_FLAG_POSTED;
+
+	opae_mutex_lock(err, &c->send_lock);
+	hdr.seq = c->next_seq++;
+	res = remote_send_locked(c, &hdr, req, reqcnt);
+	++c->stats.posted;
+	opae_mutex_unlock(err, &c->send_lock);
+
+	return res;
+}
+
+fpga_result remote_write_mmio(remote_client *c, uint64_t handle,
+			      uint32_t mmio_num, uint64_t offset,
+			      uint64_t value, uint32_t width)
+{
+	remote_mmio_write *w;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	opae_mutex_lock(err, &c->send_lock);
+
+	if (c->broken) {
+		opae_mutex_unlock(err, &c->send_lock);
+		return FPGA_EXCEPTION;
+	}
+
+	w = &c->batch[c->batch_count];
+	w->handle = handle;
+	w->offset = offset;
+	w->value = value;
+	w->mmio_num = mmio_num;
+	w->width = width;
+
+	if (!c->batch_count++) {
+		clock_gettime(CLOCK_MONOTONIC, &c->batch_start);
+		if (c->flusher_running)
+			pthread_cond_signal(&c->flush_cond);
+	}
+
+	++c->stats.mmio_writes;
+
+	if (c->batch_count == REMOTE_BATCH_MAX || !c->flusher_running)
+		res = remote_send_locked(c, NULL, NULL, 0);
+
+	opae_mutex_unlock(err, &c->send_lock);
+
+	return res;
+}
+
+fpga_result remote_flush(remote_client *c)
+{
+	fpga_result res;
+	int err;
+
+	opae_mutex_lock(err, &c->send_lock);
+	res = remote_send_locked(c, NULL, NULL, 0);
+	opae_mutex_unlock(err, &c->send_lock);
+
+	return res;
+}
+
+void remote_client_get_stats(remote_client *c, remote_client_stats *stats)
+{
+	int err;
+
+	opae_mutex_lock(err, &c->send_lock);
+	*stats = c->stats;
+	opae_mutex_unlock(err, &c->send_lock);
+}
+
+// Sends queued MMIO writes once the oldest has waited coalesce_us.
+STATIC void *remote_flusher(void *arg)
+{
+	remote_client *c = (remote_client *)arg;
+	int err;
+
+	opae_mutex_lock(err, &c->send_lock);
+
+	while (!c->stopping) {
+		struct timespec deadline;
+		struct timespec now;
+
+		if (!c->batch_count) {
+			pthread_cond_wait(&c->flush_cond, &c->send_lock);
+			continue;
+		}
+
+		deadline = c->batch_start;
+		deadline.tv_nsec += (long)c->coalesce_us * 1000;
+		while (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_nsec -= 1000000000L;
+			++deadline.tv_sec;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((now.tv_sec > deadline.tv_sec) ||
+		    ((now.tv_sec == deadline.tv_sec) &&
+		     (now.tv_nsec >= deadline.tv_nsec))) {
+			remote_send_locked(c, NULL, NULL, 0);
+			continue;
+		}
+
+		pthread_cond_timedwait(&c->flush_cond, &c->send_lock,
+				       &deadline);
+	}
+
+	opae_mutex_unlock(err, &c->send_lock);
+
+	return NULL;
+}
+
+remote_client *remote_client_connect(const char *endpoint,
+				     const uint8_t *key,
+				     uint32_t coalesce_us)
+{
+	remote_client *c;
+	pthread_condattr_t cattr;
+
+	c = opae_calloc(1, sizeof(remote_client));
+	if (!c) {
+		OPAE_ERR("out of memory");
+		return NULL;
+	}
+
+	c->tr.fd = -1;
+	if (remote_connect(endpoint, key, &c->tr)) {
+		opae_free(c);
+		return NULL;
+	}
+
+	pthread_mutex_init(&c->send_lock, NULL);
+	pthread_mutex_init(&c->recv_lock, NULL);
+	pthread_cond_init(&c->recv_cond, NULL);
+
+	pthread_condattr_init(&cattr);
+	pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+	pthread_cond_init(&c->flush_cond, &cattr);
+	pthread_condattr_destroy(&cattr);
+
+	c->next_seq = 1;
+	c->coalesce_us = coalesce_us;
+
+	if (coalesce_us) {
+		if (pthread_create(&c->flusher, NULL, remote_flusher, c))
+			OPAE_ERR("failed to start the write flusher, "
+				 "MMIO writes will not be coalesced");
+		else
+			c->flusher_running = true;
+	}
+
+	return c;
+}
+
+void remote_client_disconnect(remote_client *c)
+{
+	int err;
+
+	if (!c)
+		return;
+
+	remote_flush(c);
+
+	if (c->flusher_running) {
+		opae_mutex_lock(err, &c->send_lock);
+		c->stopping = true;
+		pthread_cond_signal(&c->flush_cond);
+		opae_mutex_unlock(err, &c->send_lock);
+		pthread_join(c->flusher, NULL);
+	}
+
+	remote_close(&c->tr);
+
+	pthread_cond_destroy(&c->flush_cond);
+	pthread_cond_destroy(&c->recv_cond);
+	pthread_mutex_destroy(&c->recv_lock);
+	pthread_mutex_destroy(&c->send_lock);
+
+	opae_free(c);
+}
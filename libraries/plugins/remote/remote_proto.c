@@ -0,0 +1,105 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <string.h>
+
+#include "remote_proto.h"
+#include "props.h"
+
+void remote_pack_properties(const struct _fpga_properties *p,
+			    remote_properties *wire)
+{
+	memset(wire, 0, sizeof(*wire));
+
+	// The parent is rebuilt by the client from the token headers.
+	wire->valid_fields = p->valid_fields &
+			     ~((uint64_t)1 << FPGA_PROPERTY_PARENT);
+
+	memcpy(wire->guid, p->guid, sizeof(fpga_guid));
+	wire->object_id = p->object_id;
+	wire->objtype = p->objtype;
+	wire->interface = p->interface;
+	wire->num_errors = p->num_errors;
+	wire->segment = p->segment;
+	wire->vendor_id = p->vendor_id;
+	wire->device_id = p->device_id;
+	wire->subsystem_vendor_id = p->subsystem_vendor_id;
+	wire->subsystem_device_id = p->subsystem_device_id;
+	wire->bus = p->bus;
+	wire->device = p->device;
+	wire->function = p->function;
+	wire->socket_id = p->socket_id;
+
+	if (p->objtype == FPGA_DEVICE) {
+		wire->num_slots = p->u.fpga.num_slots;
+		wire->bbs_id = p->u.fpga.bbs_id;
+		wire->bbs_major = p->u.fpga.bbs_version.major;
+		wire->bbs_minor = p->u.fpga.bbs_version.minor;
+		wire->bbs_patch = p->u.fpga.bbs_version.patch;
+	} else {
+		wire->accelerator_state = p->u.accelerator.state;
+		wire->num_mmio = p->u.accelerator.num_mmio;
+		wire->num_interrupts = p->u.accelerator.num_interrupts;
+	}
+}
+
+void remote_unpack_properties(const remote_properties *wire,
+			      struct _fpga_properties *p)
+{
+	p->valid_fields = wire->valid_fields;
+	memcpy(p->guid, wire->guid, sizeof(fpga_guid));
+	p->parent = NULL;
+	p->object_id = wire->object_id;
+	p->objtype = (fpga_objtype)wire->objtype;
+	p->interface = (fpga_interface)wire->interface;
+	p->num_errors = wire->num_errors;
+	p->segment = wire->segment;
+	p->vendor_id = wire->vendor_id;
+	p->device_id = wire->device_id;
+	p->subsystem_vendor_id = wire->subsystem_vendor_id;
+	p->subsystem_device_id = wire->subsystem_device_id;
+	p->bus = wire->bus;
+	p->device = wire->device;
+	p->function = wire->function;
+	p->socket_id = wire->socket_id;
+
+	if (p->objtype == FPGA_DEVICE) {
+		p->u.fpga.num_slots = wire->num_slots;
+		p->u.fpga.bbs_id = wire->bbs_id;
+		p->u.fpga.bbs_version.major = wire->bbs_major;
+		p->u.fpga.bbs_version.minor = wire->bbs_minor;
+		p->u.fpga.bbs_version.patch = wire->bbs_patch;
+	} else {
+		p->u.accelerator.state =
+			(fpga_accelerator_state)wire->accelerator_state;
+		p->u.accelerator.num_mmio = wire->num_mmio;
+		p->u.accelerator.num_interrupts = wire->num_interrupts;
+	}
+}
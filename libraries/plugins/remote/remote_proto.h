@@ -0,0 +1,359 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef __OPAE_REMOTE_PROTO_H__
+#define __OPAE_REMOTE_PROTO_H__
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <opae/types.h>
+
+/*
+ * Wire format shared by the remote plugin (libopae-r) and its server
+ * (opae-remoted).
+ *
+ * Every message is a fixed remote_hdr followed by hdr.len bytes of
+ * payload. Requests carry a sequence number that is echoed in the
+ * response, so a client may have many requests outstanding on one
+ * connection. Requests flagged REMOTE_FLAG_POSTED get no response.
+ * The server executes the requests of a connection in the order they
+ * were sent.
+ *
+ * Fields are in host byte order. The HELLO exchange checks the magic
+ * and the layout size of the wire structures, so a client and a
+ * server with a different ABI refuse to talk rather than misread.
+ */
+
+#define OPAE_REMOTE_MAGIC   0x4f504552 // OPER
+#define OPAE_REMOTE_VERSION 2
+
+typedef struct _remote_hdr {
+	uint32_t len;    // payload bytes that follow
+	uint16_t op;     // remote_op
+	uint16_t flags;  // REMOTE_FLAG_*
+	uint32_t seq;    // echoed in the response
+	int32_t result;  // fpga_result, in responses
+} remote_hdr;
+
+#define REMOTE_FLAG_POSTED 0x0001 // no response is sent
+
+// Upper bound on a message payload. The largest replies are metric
+// and threshold tables; bulk data is moved in REMOTE_MAX_CHUNK pieces.
+#define REMOTE_MAX_PAYLOAD (256 * 1024)
+#define REMOTE_MAX_CHUNK   (64 * 1024)
+
+// Upper bound on a bitstream staged with REMOTE_BITSTREAM_DATA.
+#define REMOTE_MAX_BITSTREAM (512 * 1024 * 1024)
+
+typedef enum _remote_op {
+	REMOTE_HELLO = 1,
+	REMOTE_SYNC,
+	REMOTE_ENUMERATE,
+	REMOTE_GET_PROPERTIES,
+	REMOTE_GET_PROPERTIES_FROM_HANDLE,
+	REMOTE_CLONE_TOKEN,
+	REMOTE_DESTROY_TOKEN,
+	REMOTE_OPEN,
+	REMOTE_CLOSE,
+	REMOTE_RESET,
+	REMOTE_READ_MMIO32,
+	REMOTE_READ_MMIO64,
+	REMOTE_WRITE_MMIO512,
+	REMOTE_WRITE_BATCH,
+	REMOTE_READ_ERROR,
+	REMOTE_CLEAR_ERROR,
+	REMOTE_CLEAR_ALL_ERRORS,
+	REMOTE_GET_ERROR_INFO,
+	REMOTE_RECONFIGURE_SLOT,
+	REMOTE_GET_USER_CLOCK,
+	REMOTE_SET_USER_CLOCK,
+	REMOTE_TOKEN_GET_OBJECT,
+	REMOTE_HANDLE_GET_OBJECT,
+	REMOTE_OBJECT_GET_OBJECT,
+	REMOTE_OBJECT_GET_OBJECT_AT,
+	REMOTE_DESTROY_OBJECT,
+	REMOTE_OBJECT_READ,
+	REMOTE_OBJECT_READ64,
+	REMOTE_OBJECT_WRITE64,
+	REMOTE_OBJECT_GET_SIZE,
+	REMOTE_OBJECT_GET_TYPE,
+	REMOTE_AUTH,
+	REMOTE_BITSTREAM_DATA,
+	REMOTE_OBJECT_READV,
+	REMOTE_OBJECT_READ_GROUP,
+	REMOTE_GET_NUM_METRICS,
+	REMOTE_GET_METRICS_INFO,
+	REMOTE_GET_METRICS_BY_INDEX,
+	REMOTE_GET_METRICS_BY_NAME,
+	REMOTE_GET_METRICS_THRESHOLD_INFO,
+	REMOTE_OP_MAX
+} remote_op;
+
+// REMOTE_HELLO request and response.
+typedef struct _remote_hello {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t hdr_size;   // sizeof(remote_hdr)
+	uint32_t props_size; // sizeof(remote_properties)
+	uint32_t flags;      // REMOTE_HELLO_*
+	uint32_t ring_size;  // bytes per shared memory ring
+	uint8_t nonce[16];   // server's challenge, with REMOTE_HELLO_AUTH
+} remote_hello;
+
+// The client asks for / the server grants shared memory rings. The
+// grant carries the memory file descriptor as SCM_RIGHTS data.
+#define REMOTE_HELLO_SHM  0x00000001
+// The server requires the client to prove that it holds the shared
+// key: the client answers with a REMOTE_AUTH request, whose response
+// reports whether the connection is accepted.
+#define REMOTE_HELLO_AUTH 0x00000002
+
+#define REMOTE_KEY_SIZE 16
+
+// REMOTE_AUTH request: SipHash-2-4 of the server's nonce, keyed with
+// the shared key.
+typedef struct _remote_auth {
+	uint64_t mac;
+} remote_auth;
+
+// The properties of a token, as sent on the wire. Tokens and parent
+// tokens are not carried: libopae-c rebuilds the parent/child links
+// from the token headers.
+typedef struct _remote_properties {
+	uint64_t valid_fields;
+	fpga_guid guid;
+	uint64_t object_id;
+	uint64_t bbs_id;
+	uint32_t objtype;
+	uint32_t interface;
+	uint32_t num_errors;
+	uint32_t num_slots;
+	uint32_t accelerator_state;
+	uint32_t num_mmio;
+	uint32_t num_interrupts;
+	uint16_t segment;
+	uint16_t vendor_id;
+	uint16_t device_id;
+	uint16_t subsystem_vendor_id;
+	uint16_t subsystem_device_id;
+	uint8_t bus;
+	uint8_t device;
+	uint8_t function;
+	uint8_t socket_id;
+	uint8_t bbs_major;
+	uint8_t bbs_minor;
+	uint16_t bbs_patch;
+} remote_properties;
+
+// A filter as sent in REMOTE_ENUMERATE. parent is the id of a remote
+// token, valid when the filter's FPGA_PROPERTY_PARENT bit is set.
+typedef struct _remote_filter {
+	remote_properties props;
+	uint64_t parent;
+} remote_filter;
+
+// REMOTE_ENUMERATE request: followed by num_filters remote_filter's.
+typedef struct _remote_enum_req {
+	uint32_t num_filters;
+	uint32_t max_tokens;
+} remote_enum_req;
+
+// REMOTE_ENUMERATE response: followed by num_tokens remote_token_desc's.
+typedef struct _remote_enum_resp {
+	uint32_t num_matches;
+	uint32_t num_tokens;
+} remote_enum_resp;
+
+typedef struct _remote_token_desc {
+	uint64_t id;
+	remote_properties props;
+} remote_token_desc;
+
+// One write of a REMOTE_WRITE_BATCH payload.
+typedef struct _remote_mmio_write {
+	uint64_t handle;
+	uint64_t offset;
+	uint64_t value;
+	uint32_t mmio_num;
+	uint32_t width; // 32 or 64
+} remote_mmio_write;
+
+// Generic request bodies. Ids name server-side tokens, handles and
+// objects; 0 is never a valid id.
+typedef struct _remote_id_req {
+	uint64_t id;
+	uint64_t arg0;
+	uint64_t arg1;
+	uint64_t arg2;
+} remote_id_req;
+
+typedef struct _remote_mmio_req {
+	uint64_t handle;
+	uint64_t offset;
+	uint32_t mmio_num;
+	uint32_t pad;
+} remote_mmio_req;
+
+typedef struct _remote_mmio512_req {
+	uint64_t handle;
+	uint64_t offset;
+	uint32_t mmio_num;
+	uint32_t pad;
+	uint8_t value[64];
+} remote_mmio512_req;
+
+// REMOTE_*_GET_OBJECT requests: followed by the NUL-terminated name.
+typedef struct _remote_object_req {
+	uint64_t id;
+	int32_t flags;
+	uint32_t name_len; // including the NUL
+} remote_object_req;
+
+// REMOTE_RECONFIGURE_SLOT request. The bitstream is sent ahead of it
+// in REMOTE_BITSTREAM_DATA messages, which the server stages for the
+// connection; bitstream_len must match the bytes that were staged.
+typedef struct _remote_reconf_req {
+	uint64_t handle;
+	uint64_t bitstream_len;
+	uint32_t slot;
+	int32_t flags;
+} remote_reconf_req;
+
+// REMOTE_BITSTREAM_DATA request: the uint64_t offset of the data in
+// the bitstream, followed by at most REMOTE_MAX_CHUNK bytes of it.
+// Offset 0 starts a new bitstream.
+
+// REMOTE_OBJECT_READV request: followed by count remote_window's. The
+// response carries the windows' bytes back to back, REMOTE_MAX_CHUNK
+// at most.
+typedef struct _remote_window {
+	uint64_t offset;
+	uint64_t len;
+} remote_window;
+
+typedef struct _remote_readv_req {
+	uint64_t id;
+	int32_t flags;
+	uint32_t count;
+} remote_readv_req;
+
+// REMOTE_OBJECT_READ_GROUP response: followed by count
+// remote_group_value's, then the children's NUL-terminated names back
+// to back.
+typedef struct _remote_group_resp {
+	uint64_t changed;
+	uint64_t count;
+} remote_group_resp;
+
+typedef struct _remote_group_value {
+	uint64_t value;
+	int32_t result;
+	uint16_t changed;
+	uint16_t name_len; // including the NUL
+} remote_group_value;
+
+// REMOTE_GET_METRICS_INFO, REMOTE_GET_METRICS_THRESHOLD_INFO response:
+// the number of entries the device has and count entries, starting at
+// the index given in the request.
+typedef struct _remote_table_resp {
+	uint64_t total;
+	uint64_t count;
+} remote_table_resp;
+
+// REMOTE_GET_METRICS_BY_NAME request: followed by count NUL-terminated
+// names back to back.
+typedef struct _remote_names_req {
+	uint64_t handle;
+	uint64_t count;
+} remote_names_req;
+
+struct _fpga_properties;
+
+void remote_pack_properties(const struct _fpga_properties *p,
+			    remote_properties *wire);
+void remote_unpack_properties(const remote_properties *wire,
+			      struct _fpga_properties *p);
+
+/*
+ * Transport: a stream socket (Unix or TCP), optionally upgraded to a
+ * pair of single-producer/single-consumer rings in shared memory
+ * when both ends are on the same host. The socket is kept open after
+ * the upgrade to detect when the peer goes away.
+ */
+typedef struct _remote_ring remote_ring;
+
+typedef struct _remote_transport {
+	int fd;
+	remote_ring *tx;
+	remote_ring *rx;
+	void *shm;
+	size_t shm_size;
+	// The peer can write anything to the rings, so the ring size and
+	// this end's own index are kept here, out of the peer's reach.
+	uint32_t ring_size;
+	uint32_t tx_head;
+	uint32_t rx_tail;
+} remote_transport;
+
+#define REMOTE_DEFAULT_RING_SIZE (1024 * 1024)
+// Ring sizes are powers of two in [REMOTE_MIN_RING_SIZE,
+// REMOTE_MAX_RING_SIZE]. The server substitutes the default for any
+// other size a client asks for.
+#define REMOTE_MIN_RING_SIZE 4096
+#define REMOTE_MAX_RING_SIZE (16 * 1024 * 1024)
+
+// Endpoints: "unix:<path>", "tcp:<host>:<port>" or "shm:<path>".
+// A bare absolute path is taken as "unix:", anything else as "tcp:".
+// key, when not NULL, is the REMOTE_KEY_SIZE byte shared key used to
+// answer the server's challenge.
+int remote_connect(const char *endpoint, const uint8_t *key,
+		   remote_transport *t);
+
+// A Unix socket is created with mode 0600, or 0660 and owned by group
+// when group is not (gid_t)-1. A TCP endpoint without a host listens
+// on the loopback address; any other address needs
+// REMOTE_LISTEN_ALLOW_REMOTE.
+#define REMOTE_LISTEN_ALLOW_REMOTE 0x00000001
+int remote_listen(const char *endpoint, int flags, gid_t group);
+int remote_accept(int listen_fd, remote_transport *t);
+
+// Read the shared key from path, which must not be accessible to
+// group or other. Returns 0 on success.
+int remote_load_key(const char *path, uint8_t key[REMOTE_KEY_SIZE]);
+
+int remote_client_hello(remote_transport *t, bool want_shm,
+			const uint8_t *key);
+// With key, the client must answer the challenge.
+int remote_server_hello(remote_transport *t, const uint8_t *key);
+
+int remote_send(remote_transport *t, const struct iovec *iov, int iovcnt);
+int remote_recv(remote_transport *t, void *buf, size_t len);
+int remote_discard(remote_transport *t, size_t len);
+bool remote_pending(remote_transport *t);
+void remote_close(remote_transport *t);
+
+#endif // __OPAE_REMOTE_PROTO_H__
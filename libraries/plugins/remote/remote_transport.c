@@ -0,0 +1,1051 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif // _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+
+#include <opae/log.h>
+
+#include "remote_proto.h"
+#include "mock/opae_std.h"
+
+// One direction of a shared memory connection: a byte stream in a
+// power-of-two ring. head is only written by the producer and tail
+// only by the consumer; each side sleeps on the other's index with
+// a futex once it has spun for a while without progress.
+struct _remote_ring {
+	uint32_t head;
+	uint32_t consumer_waiting;
+	uint8_t pad0[56];
+	uint32_t tail;
+	uint32_t producer_waiting;
+	uint8_t pad1[56];
+	uint32_t size;
+	uint8_t pad2[60];
+	uint8_t data[];
+};
+
+// Spinning only helps when the peer can run at the same time.
+#define REMOTE_RING_SPIN 4096
+STATIC int remote_ring_spin = -1;
+#define REMOTE_RING_WAIT_NS (100 * 1000 * 1000)
+
+static inline void remote_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	__asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+// After the upgrade to shared memory nothing more is sent on the
+// socket, so any readiness on it means the peer has gone away.
+STATIC bool remote_peer_gone(remote_transport *t)
+{
+	struct pollfd pfd = { .fd = t->fd, .events = POLLIN | POLLRDHUP };
+
+	return poll(&pfd, 1, 0) > 0;
+}
+
+STATIC int remote_ring_wait(remote_transport *t, uint32_t *word,
+			    uint32_t *waiting, uint32_t observed)
+{
+	int i;
+
+	if (remote_ring_spin < 0)
+		remote_ring_spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ?
+				   REMOTE_RING_SPIN : 0;
+
+	for (i = 0 ; i < remote_ring_spin ; ++i) {
+		if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != observed)
+			return 0;
+		remote_cpu_relax();
+	}
+
+	__atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+
+	while (__atomic_load_n(word, __ATOMIC_SEQ_CST) == observed) {
+		struct timespec ts = { 0, REMOTE_RING_WAIT_NS };
+
+		syscall(SYS_futex, word, FUTEX_WAIT, observed, &ts, NULL, 0);
+
+		if (remote_peer_gone(t)) {
+			__atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+			return -1;
+		}
+	}
+
+	__atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+	return 0;
+}
+
+static inline void remote_ring_wake(uint32_t *word, uint32_t *waiting)
+{
+	if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST))
+		syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// The peer owns the other index and may have written anything to it,
+// so the distance between the indices is checked against the ring
+// size kept in the transport before it is used.
+STATIC int remote_ring_write(remote_transport *t, remote_ring *r,
+			     const uint8_t *src, size_t len)
+{
+	uint32_t size = t->ring_size;
+	uint32_t mask = size - 1;
+
+	while (len) {
+		uint32_t head = t->tx_head;
+		uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+		uint32_t used = head - tail;
+		uint32_t space;
+		uint32_t pos;
+		uint32_t n;
+		uint32_t first;
+
+		if (used > size) {
+			OPAE_ERR("shared memory ring is corrupt");
+			return -1;
+		}
+
+		space = size - used;
+		if (!space) {
+			if (remote_ring_wait(t, &r->tail,
+					     &r->producer_waiting, tail))
+				return -1;
+			continue;
+		}
+
+		n = len < space ? (uint32_t)len : space;
+		pos = head & mask;
+		first = size - pos;
+		if (first > n)
+			first = n;
+
+		memcpy(&r->data[pos], src, first);
+		memcpy(&r->data[0], src + first, n - first);
+
+		t->tx_head = head + n;
+		__atomic_store_n(&r->head, t->tx_head, __ATOMIC_SEQ_CST);
+		remote_ring_wake(&r->head, &r->consumer_waiting);
+
+		src += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+STATIC int remote_ring_read(remote_transport *t, remote_ring *r,
+			    uint8_t *dst, size_t len)
+{
+	uint32_t size = t->ring_size;
+	uint32_t mask = size - 1;
+
+	while (len) {
+		uint32_t tail = t->rx_tail;
+		uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		uint32_t avail = head - tail;
+		uint32_t pos;
+		uint32_t n;
+		uint32_t first;
+
+		if (avail > size) {
+			OPAE_ERR("shared memory ring is corrupt");
+			return -1;
+		}
+
+		if (!avail) {
+			if (remote_ring_wait(t, &r->head,
+					     &r->consumer_waiting, head))
+				return -1;
+			continue;
+		}
+
+		n = len < avail ? (uint32_t)len : avail;
+		pos = tail & mask;
+		first = size - pos;
+		if (first > n)
+			first = n;
+
+		if (dst) {
+			memcpy(dst, &r->data[pos], first);
+			memcpy(dst + first, &r->data[0], n - first);
+			dst += n;
+		}
+
+		t->rx_tail = tail + n;
+		__atomic_store_n(&r->tail, t->rx_tail, __ATOMIC_SEQ_CST);
+		remote_ring_wake(&r->tail, &r->producer_waiting);
+
+		len -= n;
+	}
+
+	return 0;
+}
+
+int remote_send(remote_transport *t, const struct iovec *iov, int iovcnt)
+{
+	struct iovec v[8];
+	struct msghdr msg;
+	int i;
+
+	if (t->tx) {
+		for (i = 0 ; i < iovcnt ; ++i) {
+			if (remote_ring_write(t, t->tx,
+					      (const uint8_t *)iov[i].iov_base,
+					      iov[i].iov_len))
+				return -1;
+		}
+		return 0;
+	}
+
+	if (iovcnt > (int)(sizeof(v) / sizeof(v[0])))
+		return -1;
+	memcpy(v, iov, iovcnt * sizeof(struct iovec));
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = v;
+	msg.msg_iovlen = iovcnt;
+
+	while (msg.msg_iovlen) {
+		ssize_t n = sendmsg(t->fd, &msg, MSG_NOSIGNAL);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			OPAE_DBG("sendmsg failed: %s", strerror(errno));
+			return -1;
+		}
+
+		while (msg.msg_iovlen && (size_t)n >= msg.msg_iov->iov_len) {
+			n -= msg.msg_iov->iov_len;
+			++msg.msg_iov;
+			--msg.msg_iovlen;
+		}
+
+		if (msg.msg_iovlen) {
+			msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + n;
+			msg.msg_iov->iov_len -= n;
+		}
+	}
+
+	return 0;
+}
+
+int remote_recv(remote_transport *t, void *buf, size_t len)
+{
+	uint8_t *p = (uint8_t *)buf;
+
+	if (t->rx)
+		return remote_ring_read(t, t->rx, p, len);
+
+	while (len) {
+		ssize_t n = recv(t->fd, p, len, 0);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			OPAE_DBG("recv failed: %s", strerror(errno));
+			return -1;
+		}
+
+		if (!n)
+			return -1; // peer closed
+
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int remote_discard(remote_transport *t, size_t len)
+{
+	uint8_t scratch[256];
+
+	if (t->rx)
+		return remote_ring_read(t, t->rx, NULL, len);
+
+	while (len) {
+		size_t n = len < sizeof(scratch) ? len : sizeof(scratch);
+
+		if (remote_recv(t, scratch, n))
+			return -1;
+		len -= n;
+	}
+
+	return 0;
+}
+
+bool remote_pending(remote_transport *t)
+{
+	struct pollfd pfd = { .fd = t->fd, .events = POLLIN };
+
+	if (t->rx)
+		return __atomic_load_n(&t->rx->head, __ATOMIC_ACQUIRE) !=
+		       t->rx_tail;
+
+	return poll(&pfd, 1, 0) > 0;
+}
+
+void remote_close(remote_transport *t)
+{
+	if (t->shm) {
+		munmap(t->shm, t->shm_size);
+		t->shm = NULL;
+		t->tx = t->rx = NULL;
+	}
+
+	if (t->fd >= 0) {
+		close(t->fd);
+		t->fd = -1;
+	}
+}
+
+#define REMOTE_EP_UNIX 0
+#define REMOTE_EP_TCP  1
+
+typedef struct _remote_endpoint {
+	int kind;
+	bool shm;
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	char host[256];
+	char port[32];
+} remote_endpoint;
+
+STATIC int remote_parse_endpoint(const char *endpoint, remote_endpoint *ep)
+{
+	const char *colon;
+	const char *host;
+	size_t len;
+
+	memset(ep, 0, sizeof(*ep));
+
+	if (!strncmp(endpoint, "unix:", 5)) {
+		endpoint += 5;
+		ep->kind = REMOTE_EP_UNIX;
+	} else if (!strncmp(endpoint, "shm:", 4)) {
+		endpoint += 4;
+		ep->kind = REMOTE_EP_UNIX;
+		ep->shm = true;
+	} else if (!strncmp(endpoint, "tcp:", 4)) {
+		endpoint += 4;
+		ep->kind = REMOTE_EP_TCP;
+	} else {
+		ep->kind = (*endpoint == '/') ? REMOTE_EP_UNIX : REMOTE_EP_TCP;
+	}
+
+	if (ep->kind == REMOTE_EP_UNIX) {
+		len = strnlen(endpoint, sizeof(ep->path));
+		if (!len || len == sizeof(ep->path)) {
+			OPAE_ERR("invalid socket path in endpoint");
+			return -1;
+		}
+		memcpy(ep->path, endpoint, len + 1);
+		return 0;
+	}
+
+	// host:port, where host may be a bracketed IPv6 address.
+	colon = strrchr(endpoint, ':');
+	if (!colon || !colon[1]) {
+		OPAE_ERR("endpoint \"%s\" has no port", endpoint);
+		return -1;
+	}
+
+	host = endpoint;
+	len = colon - endpoint;
+	if (len >= 2 && host[0] == '[' && host[len - 1] == ']') {
+		++host;
+		len -= 2;
+	}
+
+	if (len >= sizeof(ep->host) || strlen(colon + 1) >= sizeof(ep->port)) {
+		OPAE_ERR("endpoint \"%s\" is too long", endpoint);
+		return -1;
+	}
+
+	memcpy(ep->host, host, len);
+	ep->host[len] = '\0';
+	strcpy(ep->port, colon + 1);
+
+	return 0;
+}
+
+STATIC void remote_init_transport(remote_transport *t, int fd)
+{
+	memset(t, 0, sizeof(*t));
+	t->fd = fd;
+}
+
+STATIC void remote_set_nodelay(int fd)
+{
+	int one = 1;
+
+	// Batching is done by the protocol, so don't let Nagle delay
+	// the small request/response messages.
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int remote_connect(const char *endpoint, const uint8_t *key,
+		   remote_transport *t)
+{
+	remote_endpoint ep;
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	struct addrinfo *ai;
+	int fd = -1;
+	int err;
+
+	if (remote_parse_endpoint(endpoint, &ep))
+		return -1;
+
+	if (ep.kind == REMOTE_EP_UNIX) {
+		struct sockaddr_un addr;
+
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			OPAE_ERR("socket failed: %s", strerror(errno));
+			return -1;
+		}
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		memcpy(addr.sun_path, ep.path, sizeof(ep.path));
+
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+			OPAE_ERR("connect to %s failed: %s",
+				 ep.path, strerror(errno));
+			close(fd);
+			return -1;
+		}
+
+		remote_init_transport(t, fd);
+		return remote_client_hello(t, ep.shm, key);
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	err = getaddrinfo(ep.host, ep.port, &hints, &res);
+	if (err) {
+		OPAE_ERR("getaddrinfo(%s:%s): %s",
+			 ep.host, ep.port, gai_strerror(err));
+		return -1;
+	}
+
+	for (ai = res ; ai ; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+			    ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		if (!connect(fd, ai->ai_addr, ai->ai_addrlen))
+			break;
+		close(fd);
+		fd = -1;
+	}
+
+	freeaddrinfo(res);
+
+	if (fd < 0) {
+		OPAE_ERR("connect to %s:%s failed", ep.host, ep.port);
+		return -1;
+	}
+
+	remote_set_nodelay(fd);
+	remote_init_transport(t, fd);
+	return remote_client_hello(t, false, key);
+}
+
+STATIC bool remote_is_loopback(const struct sockaddr *sa)
+{
+	if (sa->sa_family == AF_INET) {
+		const struct sockaddr_in *in = (const struct sockaddr_in *)sa;
+
+		return (ntohl(in->sin_addr.s_addr) >> 24) == IN_LOOPBACKNET;
+	}
+
+	if (sa->sa_family == AF_INET6) {
+		const struct sockaddr_in6 *in6 =
+			(const struct sockaddr_in6 *)sa;
+
+		return IN6_IS_ADDR_LOOPBACK(&in6->sin6_addr);
+	}
+
+	return false;
+}
+
+STATIC int remote_listen_unix(remote_endpoint *ep, gid_t group)
+{
+	struct sockaddr_un addr;
+	mode_t mask;
+	int fd;
+	int err;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		OPAE_ERR("socket failed: %s", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, ep->path, sizeof(ep->path));
+
+	unlink(ep->path);
+
+	// Connecting needs write permission on the socket: create it
+	// for the owner only, then open it to the group if asked.
+	mask = umask(0177);
+	err = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(mask);
+
+	if (!err && group != (gid_t)-1)
+		err = chown(ep->path, (uid_t)-1, group) ||
+		      chmod(ep->path, 0660);
+
+	if (err || listen(fd, SOMAXCONN)) {
+		OPAE_ERR("listen on %s failed: %s",
+			 ep->path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+int remote_listen(const char *endpoint, int flags, gid_t group)
+{
+	remote_endpoint ep;
+	struct addrinfo hints;
+	struct addrinfo *res = NULL;
+	struct addrinfo *ai;
+	int fd = -1;
+	int one = 1;
+	int err;
+
+	if (remote_parse_endpoint(endpoint, &ep))
+		return -1;
+
+	if (ep.kind == REMOTE_EP_UNIX)
+		return remote_listen_unix(&ep, group);
+
+	// Without AI_PASSIVE, a NULL host resolves to the loopback address.
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	err = getaddrinfo(ep.host[0] ? ep.host : NULL, ep.port, &hints, &res);
+	if (err) {
+		OPAE_ERR("getaddrinfo(%s:%s): %s",
+			 ep.host, ep.port, gai_strerror(err));
+		return -1;
+	}
+
+	for (ai = res ; ai ; ai = ai->ai_next) {
+		if (!(flags & REMOTE_LISTEN_ALLOW_REMOTE) &&
+		    !remote_is_loopback(ai->ai_addr)) {
+			OPAE_ERR("%s:%s is not a loopback address",
+				 ep.host, ep.port);
+			continue;
+		}
+
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+			    ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (!bind(fd, ai->ai_addr, ai->ai_addrlen) &&
+		    !listen(fd, SOMAXCONN))
+			break;
+		close(fd);
+		fd = -1;
+	}
+
+	freeaddrinfo(res);
+
+	if (fd < 0)
+		OPAE_ERR("listen on %s:%s failed", ep.host, ep.port);
+
+	return fd;
+}
+
+int remote_accept(int listen_fd, remote_transport *t)
+{
+	struct sockaddr_storage addr;
+	socklen_t len = sizeof(addr);
+	int fd;
+
+	do {
+		fd = accept4(listen_fd, (struct sockaddr *)&addr, &len,
+			     SOCK_CLOEXEC);
+	} while (fd < 0 && errno == EINTR);
+
+	if (fd < 0)
+		return -1;
+
+	if (addr.ss_family == AF_INET || addr.ss_family == AF_INET6)
+		remote_set_nodelay(fd);
+
+	remote_init_transport(t, fd);
+	return 0;
+}
+
+static inline bool remote_ring_size_valid(uint32_t ring_size)
+{
+	return ring_size >= REMOTE_MIN_RING_SIZE &&
+	       ring_size <= REMOTE_MAX_RING_SIZE &&
+	       !(ring_size & (ring_size - 1));
+}
+
+static inline size_t remote_ring_bytes(uint32_t ring_size)
+{
+	size_t bytes = sizeof(remote_ring) + ring_size;
+
+	return (bytes + 4095) & ~(size_t)4095;
+}
+
+// Map the rings. The client to server ring comes first.
+STATIC int remote_map_rings(remote_transport *t, int memfd,
+			    uint32_t ring_size, bool server)
+{
+	size_t ring_bytes = remote_ring_bytes(ring_size);
+	remote_ring *c2s;
+	remote_ring *s2c;
+	struct stat st;
+	void *shm;
+
+	if (!remote_ring_size_valid(ring_size) ||
+	    fstat(memfd, &st) || (size_t)st.st_size < 2 * ring_bytes) {
+		OPAE_ERR("invalid shared memory rings");
+		return -1;
+	}
+
+	shm = mmap(NULL, 2 * ring_bytes, PROT_READ | PROT_WRITE,
+		   MAP_SHARED, memfd, 0);
+	if (shm == MAP_FAILED) {
+		OPAE_ERR("mmap of rings failed: %s", strerror(errno));
+		return -1;
+	}
+
+	c2s = (remote_ring *)shm;
+	s2c = (remote_ring *)((uint8_t *)shm + ring_bytes);
+
+	if (server) {
+		c2s->size = s2c->size = ring_size;
+		t->tx = s2c;
+		t->rx = c2s;
+	} else {
+		if (c2s->size != ring_size || s2c->size != ring_size) {
+			munmap(shm, 2 * ring_bytes);
+			return -1;
+		}
+		t->tx = c2s;
+		t->rx = s2c;
+	}
+
+	t->shm = shm;
+	t->shm_size = 2 * ring_bytes;
+	t->ring_size = ring_size;
+	t->tx_head = 0;
+	t->rx_tail = 0;
+	return 0;
+}
+
+#define SIPROUND                                       \
+	do {                                           \
+		v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0; \
+		v0 = ROTL64(v0, 32);                    \
+		v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2; \
+		v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0; \
+		v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2; \
+		v2 = ROTL64(v2, 32);                    \
+	} while (0)
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+static inline uint64_t remote_le64(const uint8_t *p, size_t n)
+{
+	uint64_t v = 0;
+	size_t i;
+
+	for (i = 0 ; i < n ; ++i)
+		v |= (uint64_t)p[i] << (8 * i);
+	return v;
+}
+
+// SipHash-2-4 of msg, keyed with key.
+STATIC uint64_t remote_siphash(const uint8_t key[REMOTE_KEY_SIZE],
+			       const uint8_t *msg, size_t len)
+{
+	uint64_t k0 = remote_le64(key, 8);
+	uint64_t k1 = remote_le64(key + 8, 8);
+	uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+	uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+	uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+	uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+	uint64_t b = (uint64_t)len << 56;
+	uint64_t m;
+	size_t left = len;
+
+	for ( ; left >= 8 ; left -= 8, msg += 8) {
+		m = remote_le64(msg, 8);
+		v3 ^= m;
+		SIPROUND;
+		SIPROUND;
+		v0 ^= m;
+	}
+
+	b |= remote_le64(msg, left);
+	v3 ^= b;
+	SIPROUND;
+	SIPROUND;
+	v0 ^= b;
+
+	v2 ^= 0xff;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+	SIPROUND;
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+int remote_load_key(const char *path, uint8_t key[REMOTE_KEY_SIZE])
+{
+	struct stat st;
+	ssize_t n;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		OPAE_ERR("open %s failed: %s", path, strerror(errno));
+		return -1;
+	}
+
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode) ||
+	    (st.st_mode & (S_IRWXG | S_IRWXO))) {
+		OPAE_ERR("%s must be a regular file that only its owner"
+			 " can access", path);
+		close(fd);
+		return -1;
+	}
+
+	do {
+		n = read(fd, key, REMOTE_KEY_SIZE);
+	} while (n < 0 && errno == EINTR);
+
+	close(fd);
+
+	if (n != REMOTE_KEY_SIZE) {
+		OPAE_ERR("%s must hold at least %d bytes",
+			 path, REMOTE_KEY_SIZE);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Answer the server's challenge.
+STATIC int remote_client_auth(remote_transport *t, const remote_hello *hello,
+			      const uint8_t *key)
+{
+	remote_hdr hdr;
+	remote_auth auth;
+	struct iovec iov[2];
+
+	if (!key) {
+		OPAE_ERR("remote server requires a key");
+		return -1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.len = sizeof(auth);
+	hdr.op = REMOTE_AUTH;
+	auth.mac = remote_siphash(key, hello->nonce, sizeof(hello->nonce));
+
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = &auth;
+	iov[1].iov_len = sizeof(auth);
+
+	if (remote_send(t, iov, 2) ||
+	    remote_recv(t, &hdr, sizeof(hdr)) ||
+	    hdr.op != REMOTE_AUTH || hdr.len)
+		return -1;
+
+	if (hdr.result != FPGA_OK) {
+		OPAE_ERR("remote server rejected the key");
+		return -1;
+	}
+
+	return 0;
+}
+
+// Check the client's answer to the challenge in hello.
+STATIC int remote_server_auth(remote_transport *t, const remote_hello *hello,
+			      const uint8_t *key)
+{
+	remote_hdr hdr;
+	remote_auth auth;
+	struct iovec iov = { &hdr, sizeof(hdr) };
+	uint64_t diff;
+
+	if (remote_recv(t, &hdr, sizeof(hdr)) ||
+	    hdr.op != REMOTE_AUTH || hdr.len != sizeof(auth) ||
+	    remote_recv(t, &auth, sizeof(auth)))
+		return -1;
+
+	diff = auth.mac ^ remote_siphash(key, hello->nonce,
+					 sizeof(hello->nonce));
+
+	hdr.len = 0;
+	hdr.result = diff ? FPGA_NO_ACCESS : FPGA_OK;
+	if (remote_send(t, &iov, 1) || diff) {
+		OPAE_ERR("remote client failed authentication");
+		return -1;
+	}
+
+	return 0;
+}
+
+int remote_client_hello(remote_transport *t, bool want_shm,
+			const uint8_t *key)
+{
+	remote_hdr hdr;
+	remote_hello hello;
+	struct iovec iov[2];
+	struct msghdr msg;
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct cmsghdr *cmsg;
+	int memfd = -1;
+	ssize_t n;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.len = sizeof(hello);
+	hdr.op = REMOTE_HELLO;
+
+	memset(&hello, 0, sizeof(hello));
+	hello.magic = OPAE_REMOTE_MAGIC;
+	hello.version = OPAE_REMOTE_VERSION;
+	hello.hdr_size = sizeof(remote_hdr);
+	hello.props_size = sizeof(remote_properties);
+	hello.flags = want_shm ? REMOTE_HELLO_SHM : 0;
+	hello.ring_size = REMOTE_DEFAULT_RING_SIZE;
+
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = &hello;
+	iov[1].iov_len = sizeof(hello);
+
+	if (remote_send(t, iov, 2))
+		goto out_close;
+
+	// The shared memory grant rides on the first byte of the reply.
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		n = recvmsg(t->fd, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+	} while (n < 0 && errno == EINTR);
+
+	if (n != (ssize_t)sizeof(hdr))
+		goto out_close;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg) ; cmsg ;
+	     cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET &&
+		    cmsg->cmsg_type == SCM_RIGHTS)
+			memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+	}
+
+	if (hdr.op != REMOTE_HELLO || hdr.len != sizeof(hello) ||
+	    remote_recv(t, &hello, sizeof(hello)))
+		goto out_close;
+
+	if (hdr.result != FPGA_OK || hello.magic != OPAE_REMOTE_MAGIC) {
+		OPAE_ERR("remote server refused the connection");
+		goto out_close;
+	}
+
+	if ((hello.flags & REMOTE_HELLO_AUTH) &&
+	    remote_client_auth(t, &hello, key))
+		goto out_close;
+
+	if (memfd >= 0) {
+		if ((hello.flags & REMOTE_HELLO_SHM) &&
+		    !remote_map_rings(t, memfd, hello.ring_size, false))
+			OPAE_DBG("using shared memory transport");
+		close(memfd);
+	}
+
+	return 0;
+
+out_close:
+	if (memfd >= 0)
+		close(memfd);
+	OPAE_ERR("remote handshake failed");
+	remote_close(t);
+	return -1;
+}
+
+int remote_server_hello(remote_transport *t, const uint8_t *key)
+{
+	remote_hdr hdr;
+	remote_hello hello;
+	struct iovec iov[2];
+	struct msghdr msg;
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE(sizeof(int))];
+	} control;
+	struct sockaddr_storage addr;
+	socklen_t addr_len = sizeof(addr);
+	int memfd = -1;
+	uint32_t ring_size = 0;
+	bool unix_socket;
+	int res = 0;
+
+	if (remote_recv(t, &hdr, sizeof(hdr)) ||
+	    hdr.op != REMOTE_HELLO || hdr.len != sizeof(hello) ||
+	    remote_recv(t, &hello, sizeof(hello)))
+		return -1;
+
+	hdr.result = FPGA_OK;
+	if (hello.magic != OPAE_REMOTE_MAGIC ||
+	    hello.version != OPAE_REMOTE_VERSION ||
+	    hello.hdr_size != sizeof(remote_hdr) ||
+	    hello.props_size != sizeof(remote_properties)) {
+		OPAE_ERR("client protocol mismatch (version %u)",
+			 hello.version);
+		hdr.result = FPGA_NOT_SUPPORTED;
+		res = -1;
+	}
+
+	unix_socket = !getsockname(t->fd, (struct sockaddr *)&addr,
+				   &addr_len) &&
+		      addr.ss_family == AF_UNIX;
+
+	// Shared memory is only offered over Unix sockets, where the
+	// client is on this host.
+	if (!res && (hello.flags & REMOTE_HELLO_SHM) && unix_socket) {
+		ring_size = hello.ring_size;
+		if (!remote_ring_size_valid(ring_size))
+			ring_size = REMOTE_DEFAULT_RING_SIZE;
+
+		memfd = syscall(SYS_memfd_create, "opae-remote", MFD_CLOEXEC);
+		if (memfd >= 0 &&
+		    (ftruncate(memfd, 2 * remote_ring_bytes(ring_size)) ||
+		     remote_map_rings(t, memfd, ring_size, true))) {
+			close(memfd);
+			memfd = -1;
+		}
+	}
+
+	hello.magic = OPAE_REMOTE_MAGIC;
+	hello.version = OPAE_REMOTE_VERSION;
+	hello.hdr_size = sizeof(remote_hdr);
+	hello.props_size = sizeof(remote_properties);
+	hello.flags = memfd >= 0 ? REMOTE_HELLO_SHM : 0;
+	hello.ring_size = ring_size;
+	memset(hello.nonce, 0, sizeof(hello.nonce));
+
+	// Unix socket clients are checked by their credentials instead.
+	if (!res && key && !unix_socket) {
+		if (getrandom(hello.nonce, sizeof(hello.nonce), 0) !=
+		    (ssize_t)sizeof(hello.nonce)) {
+			OPAE_ERR("getrandom failed: %s", strerror(errno));
+			hdr.result = FPGA_EXCEPTION;
+			res = -1;
+		} else {
+			hello.flags |= REMOTE_HELLO_AUTH;
+		}
+	}
+
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = &hello;
+	iov[1].iov_len = sizeof(hello);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+
+	if (memfd >= 0) {
+		struct cmsghdr *cmsg;
+
+		memset(&control, 0, sizeof(control));
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+	}
+
+	if (sendmsg(t->fd, &msg, MSG_NOSIGNAL) !=
+	    (ssize_t)(sizeof(hdr) + sizeof(hello)))
+		res = -1;
+
+	if (memfd >= 0)
+		close(memfd);
+
+	if (!res && (hello.flags & REMOTE_HELLO_AUTH))
+		res = remote_server_auth(t, &hello, key);
+
+	return res;
+}
@@ -48,14 +48,11 @@ extern libopae_config_data *opae_u_supported_devices;
 int __UIO_API__ uio_plugin_initialize(void)
 {
 	int res;
-	char *raw_cfg = NULL;
 	char *cfg_file;
 
 	cfg_file = opae_find_cfg_file();
-	if (cfg_file)
-		raw_cfg = opae_read_cfg_file(cfg_file);
 
-	opae_u_supported_devices = opae_parse_libopae_config(cfg_file, raw_cfg);
+	opae_u_supported_devices = opae_load_libopae_config(cfg_file);
 
 	if (cfg_file) {
 		opae_free(cfg_file);
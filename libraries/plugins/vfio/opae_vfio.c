@@ -44,6 +44,7 @@
 #include <uuid/uuid.h>
 #include <sys/stat.h>
 #include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #undef _GNU_SOURCE
 
@@ -471,6 +472,69 @@ event_handle_check_and_lock(fpga_event_handle event_handle)
 	return NULL;
 }
 
+STATIC fpga_result vfio_free_sva_buffer(vfio_sva_buffer *sva)
+{
+	fpga_result res = FPGA_OK;
+
+	if (!(sva->binfo.flags & OPAE_VFIO_BUF_PREALLOCATED) &&
+	    munmap(sva->binfo.buffer_ptr, sva->binfo.buffer_size)) {
+		OPAE_ERR("munmap() failed");
+		res = FPGA_EXCEPTION;
+	}
+	opae_free(sva);
+	return res;
+}
+
+/*
+ * Remove the SVA buffer whose wsid is given from h's list.
+ * Returns NULL when wsid isn't an SVA buffer of h.
+ */
+STATIC vfio_sva_buffer *vfio_take_sva_buffer(vfio_handle *h, uint64_t wsid)
+{
+	vfio_sva_buffer **prev;
+	vfio_sva_buffer *sva = NULL;
+	int err;
+
+	if (opae_mutex_lock(err, &h->lock))
+		return NULL;
+
+	for (prev = &h->sva_buffers ; *prev ; prev = &(*prev)->next) {
+		if ((uint64_t)&(*prev)->binfo == wsid) {
+			sva = *prev;
+			*prev = sva->next;
+			break;
+		}
+	}
+
+	opae_mutex_unlock(err, &h->lock);
+	return sva;
+}
+
+/*
+ * Whether buf_addr is an SVA buffer prepared on h, or on the
+ * parent AFU of h.
+ */
+STATIC bool vfio_is_sva_buffer(vfio_handle *h, void *buf_addr)
+{
+	vfio_sva_buffer *sva;
+	bool found = false;
+	int err;
+
+	for ( ; h && !found ; h = h->parent_afu) {
+		if (opae_mutex_lock(err, &h->lock))
+			break;
+		for (sva = h->sva_buffers ; sva ; sva = sva->next) {
+			if (sva->binfo.buffer_ptr == buf_addr) {
+				found = true;
+				break;
+			}
+		}
+		opae_mutex_unlock(err, &h->lock);
+	}
+
+	return found;
+}
+
 STATIC int close_vfio_pair(vfio_pair_t **pair)
 {
 	ASSERT_NOT_NULL(pair);
@@ -490,7 +554,10 @@ STATIC int close_vfio_pair(vfio_pair_t **pair)
 	return 0;
 }
 
-STATIC fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair)
+// When owner is not NULL, try to open the device into owner's
+// VFIO container first, so that DMA mappings are shared.
+STATIC fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair,
+				  struct opae_vfio *owner)
 {
 	char phys_device[PCIADDR_MAX];
 	char phys_driver[PATH_MAX];
@@ -545,7 +612,12 @@ STATIC fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair)
 			goto out_destroy;
 		}
 
-		ires = opae_vfio_secure_open(pair->device, addr, secret);
+		ires = 1;
+		if (owner)
+			ires = opae_vfio_open_shared(pair->device, addr,
+						     secret, owner);
+		if (ires)
+			ires = opae_vfio_secure_open(pair->device, addr, secret);
 		if (ires) {
 			if (ires == 2)
 				res = FPGA_BUSY;
@@ -556,7 +628,12 @@ STATIC fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair)
 			goto out_destroy;
 		}
 	} else {
-		ires = opae_vfio_open(pair->device, addr);
+		ires = 1;
+		if (owner)
+			ires = opae_vfio_open_shared(pair->device, addr,
+						     NULL, owner);
+		if (ires)
+			ires = opae_vfio_open(pair->device, addr);
 		if (ires) {
 			if (ires == 2)
 				res = FPGA_BUSY;
@@ -610,7 +687,7 @@ STATIC int vfio_walk(vfio_pci_device_t *dev)
 	vfio_token *tok;
 	struct opae_vfio *v;
 
-	res = open_vfio_pair(dev->addr, &pair);
+	res = open_vfio_pair(dev->addr, &pair, NULL);
 	if (res) {
 		OPAE_DBG("error opening vfio device: %s",
 			 dev->addr);
@@ -717,7 +794,9 @@ fpga_result __VFIO_API__ vfio_fpgaOpen(fpga_token token, fpga_handle *handle, in
 	if (flags & FPGA_OPEN_HAS_PARENT_AFU)
 		_handle->parent_afu = handle_check_and_lock(*handle);
 
-	res = open_vfio_pair(_token->device->addr, &_handle->vfio_pair);
+	res = open_vfio_pair(_token->device->addr, &_handle->vfio_pair,
+			     _handle->parent_afu ?
+			     _handle->parent_afu->vfio_pair->device : NULL);
 	if (res) {
 		OPAE_DBG("error opening vfio device: %s",
 			 _token->device->addr);
@@ -743,7 +822,10 @@ fpga_result __VFIO_API__ vfio_fpgaOpen(fpga_token token, fpga_handle *handle, in
 #endif // GCC_VERSION
 #endif // x86
 
-	if (_handle->parent_afu) {
+	// A child in its parent's container allocates IOVAs from the
+	// parent. Otherwise, constrain the parent's IOVA choices to
+	// those that are also legal in the child's container.
+	if (_handle->parent_afu && !_handle->vfio_pair->device->cont_owner) {
 		if (opae_vfio_apply_group_constraint(
 				_handle->vfio_pair->device,
 				_handle->parent_afu->vfio_pair->device)) {
@@ -792,6 +874,12 @@ fpga_result __VFIO_API__ vfio_fpgaClose(fpga_handle handle)
 		OPAE_ERR("invalid token in handle");
 	}
 
+	while (h->sva_buffers) {
+		vfio_sva_buffer *sva = h->sva_buffers;
+		h->sva_buffers = sva->next;
+		vfio_free_sva_buffer(sva);
+	}
+
 	if (h->flags & OPAE_FLAG_SVA_FD_VALID) {
 		// Release PASID and shared virtual addressing
 		opae_close(h->sva_fd);
@@ -1494,6 +1582,116 @@ fpga_result __VFIO_API__ vfio_fpgaDestroyToken(fpga_token *token)
 #define HUGE_2M (2*1024*1024)
 #define ROUND_UP(N, M) ((N + M - 1) & ~(M-1))
 
+/*
+ * Translate fpgaPrepareBuffer() flags to libopaevfio buffer flags,
+ * resolving the default NUMA placement to the device's node.
+ */
+STATIC int vfio_buffer_flags(vfio_handle *h, int flags)
+{
+	uint32_t node = h->token->device->numa_node;
+
+	if (flags & FPGA_BUF_PREALLOCATED)
+		return OPAE_VFIO_BUF_PREALLOCATED;
+
+	if (flags & FPGA_BUF_NUMA_ANY)
+		return 0;
+
+	if (flags & FPGA_BUF_NUMA_INTERLEAVE)
+		return OPAE_VFIO_BUF_NUMA_INTERLEAVE;
+
+	if (flags & FPGA_BUF_NUMA_NODE_VALID)
+		node = FPGA_BUF_NUMA_NODE_OF(flags);
+
+	if (node > 0xff)
+		return 0;
+
+	return OPAE_VFIO_BUF_NUMA_PREFERRED | OPAE_VFIO_BUF_NUMA_NODE(node);
+}
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/*
+ * Prepare a buffer for a handle bound to a PASID. The device reaches
+ * the buffer through the process' page tables, so its IO address is
+ * its virtual address and nothing is pinned or mapped. Hugepages are
+ * preferred to keep device TLB misses down, but not required.
+ */
+STATIC fpga_result vfio_prepare_sva_buffer(vfio_handle *h,
+					   uint64_t len,
+					   void **buf_addr,
+					   uint64_t *wsid,
+					   int flags)
+{
+	vfio_sva_buffer *sva;
+	uint8_t *virt = MAP_FAILED;
+	size_t sz = 0;
+	int err;
+
+	if (!(h->flags & OPAE_FLAG_PASID_VALID)) {
+		if (!(flags & FPGA_BUF_QUIET))
+			OPAE_ERR("FPGA_BUF_SVA requires fpgaBindSVA()");
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	if (!len)
+		return FPGA_INVALID_PARAM;
+
+	if (flags & FPGA_BUF_PREALLOCATED) {
+		virt = *buf_addr;
+		sz = len;
+	} else {
+		if (len > 4096) {
+			sz = ROUND_UP(len, HUGE_2M);
+			virt = mmap(NULL, sz, PROT_READ|PROT_WRITE,
+				    MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|
+				    (21 << MAP_HUGE_SHIFT), -1, 0);
+		}
+
+		if (virt == MAP_FAILED) {
+			sz = ROUND_UP(len, 4096);
+			virt = mmap(NULL, sz, PROT_READ|PROT_WRITE,
+				    MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+			if (virt == MAP_FAILED) {
+				OPAE_ERR("mmap() failed");
+				return FPGA_NO_MEMORY;
+			}
+			if (sz >= HUGE_2M)
+				madvise(virt, sz, MADV_HUGEPAGE);
+		}
+	}
+
+	sva = opae_malloc(sizeof(*sva));
+	if (!sva) {
+		OPAE_ERR("error allocating buffer metadata");
+		if (!(flags & FPGA_BUF_PREALLOCATED))
+			munmap(virt, sz);
+		return FPGA_NO_MEMORY;
+	}
+
+	sva->binfo.buffer_ptr = virt;
+	sva->binfo.buffer_size = sz;
+	sva->binfo.buffer_iova = (uint64_t)virt;
+	sva->binfo.flags = (flags & FPGA_BUF_PREALLOCATED) ?
+			   OPAE_VFIO_BUF_PREALLOCATED : 0;
+
+	if (opae_mutex_lock(err, &h->lock)) {
+		vfio_free_sva_buffer(sva);
+		return FPGA_EXCEPTION;
+	}
+	sva->next = h->sva_buffers;
+	h->sva_buffers = sva;
+	opae_mutex_unlock(err, &h->lock);
+
+	*buf_addr = virt;
+	*wsid = (uint64_t)&sva->binfo;
+	return FPGA_OK;
+}
+
 fpga_result __VFIO_API__ vfio_fpgaPrepareBuffer(fpga_handle handle,
 						uint64_t len,
 						void **buf_addr,
@@ -1525,6 +1723,9 @@ fpga_result __VFIO_API__ vfio_fpgaPrepareBuffer(fpga_handle handle,
 	h = handle_check(handle);
 	ASSERT_NOT_NULL(h);
 
+	if (flags & FPGA_BUF_SVA)
+		return vfio_prepare_sva_buffer(h, len, buf_addr, wsid, flags);
+
 	fpga_result res = FPGA_EXCEPTION;
 
 	struct opae_vfio *v = h->vfio_pair->device;
@@ -1536,7 +1737,8 @@ fpga_result __VFIO_API__ vfio_fpgaPrepareBuffer(fpga_handle handle,
 		sz = ROUND_UP(len, HUGE_2M);
 	else
 		sz = 4096;
-	if (opae_vfio_buffer_allocate_ex(v, &sz, &virt, &iova, flags)) {
+	if (opae_vfio_buffer_allocate_ex(v, &sz, &virt, &iova,
+					 vfio_buffer_flags(h, flags))) {
 		OPAE_DBG("could not allocate buffer");
 		return FPGA_EXCEPTION;
 	}
@@ -1573,10 +1775,15 @@ fpga_result __VFIO_API__ vfio_fpgaReleaseBuffer(fpga_handle handle,
 
 	struct opae_vfio *v = h->vfio_pair->device;
 	struct opae_vfio_buffer *binfo = (struct opae_vfio_buffer *)wsid;
+	vfio_sva_buffer *sva;
 	fpga_result res = FPGA_OK;
 
 	ASSERT_NOT_NULL(binfo);
 
+	sva = vfio_take_sva_buffer(h, wsid);
+	if (sva)
+		return vfio_free_sva_buffer(sva);
+
 	if (opae_vfio_buffer_free(v, binfo->buffer_ptr)) {
 		OPAE_ERR("error freeing vfio buffer");
 		res = FPGA_NOT_FOUND;
@@ -1669,6 +1876,15 @@ fpga_result __VFIO_API__ vfio_fpgaPinBuffer(fpga_handle handle, void *buf_addr,
 	ASSERT_NOT_NULL(h);
 
 	struct opae_vfio *v = h->vfio_pair->device;
+
+	// The parent's mapping is already visible to a child
+	// that shares its container. A handle bound to a PASID
+	// already reaches an SVA buffer by its virtual address.
+	if (v->cont_owner ||
+	    ((h->flags & OPAE_FLAG_PASID_VALID) &&
+	     vfio_is_sva_buffer(h, buf_addr)))
+		return FPGA_OK;
+
 	if (opae_vfio_buffer_map(v, len, buf_addr, ioaddr)) {
 		OPAE_DBG("could not map buffer");
 		return FPGA_EXCEPTION;
@@ -1680,13 +1896,18 @@ fpga_result __VFIO_API__ vfio_fpgaPinBuffer(fpga_handle handle, void *buf_addr,
 fpga_result __VFIO_API__ vfio_fpgaUnpinBuffer(fpga_handle handle, void *buf_addr,
 					      uint64_t len, uint64_t ioaddr)
 {
-	UNUSED_PARAM(buf_addr);
-
 	vfio_handle *h;
 	h = handle_check(handle);
 	ASSERT_NOT_NULL(h);
 
 	struct opae_vfio *v = h->vfio_pair->device;
+
+	// The mapping belongs to the parent, or there is none.
+	if (v->cont_owner ||
+	    ((h->flags & OPAE_FLAG_PASID_VALID) &&
+	     vfio_is_sva_buffer(h, buf_addr)))
+		return FPGA_OK;
+
 	if (opae_vfio_buffer_unmap(v, len, ioaddr)) {
 		OPAE_DBG("could not unmap buffer");
 		return FPGA_EXCEPTION;
@@ -1695,6 +1916,19 @@ fpga_result __VFIO_API__ vfio_fpgaUnpinBuffer(fpga_handle handle, void *buf_addr
 	return FPGA_OK;
 }
 
+fpga_result __VFIO_API__ vfio_fpgaSharesParentMappings(fpga_handle handle,
+						       bool *shared)
+{
+	vfio_handle *h;
+	h = handle_check(handle);
+	ASSERT_NOT_NULL(h);
+	ASSERT_NOT_NULL(shared);
+
+	*shared = h->vfio_pair->device->cont_owner != NULL;
+
+	return FPGA_OK;
+}
+
 fpga_result __VFIO_API__ vfio_fpgaGetWSInfo(fpga_handle handle, uint64_t wsid,
 					    uint64_t *ioaddr,
 					    void **buf_addr, uint64_t *len)
@@ -92,6 +92,14 @@ typedef struct _vfio_pair {
 	struct opae_vfio *physfn;
 } vfio_pair_t;
 
+// A buffer prepared with FPGA_BUF_SVA. libopaevfio doesn't know
+// these, so each handle keeps a list of its own and frees what is
+// left of it at fpgaClose(). The wsid points to binfo.
+typedef struct _vfio_sva_buffer {
+	struct opae_vfio_buffer binfo;
+	struct _vfio_sva_buffer *next;
+} vfio_sva_buffer;
+
 typedef struct _vfio_handle {
 	uint32_t magic;
 	vfio_token *token;
@@ -102,6 +110,7 @@ typedef struct _vfio_handle {
 	pthread_mutex_t lock;
 	int sva_fd;
 	int pasid;
+	vfio_sva_buffer *sva_buffers; // protected by lock
 #define OPAE_FLAG_HAS_AVX512 (1u << 0)
 #define OPAE_FLAG_SVA_FD_VALID (1u << 1)  // Indicates sva_fd file handle is valid
 #define OPAE_FLAG_PASID_VALID (1u << 2)   // Indicates pasid is set
@@ -48,14 +48,11 @@ extern libopae_config_data *opae_v_supported_devices;
 int __VFIO_API__ vfio_plugin_initialize(void)
 {
 	int res;
-	char *raw_cfg = NULL;
 	char *cfg_file;
 
 	cfg_file = opae_find_cfg_file();
-	if (cfg_file)
-		raw_cfg = opae_read_cfg_file(cfg_file);
 
-	opae_v_supported_devices = opae_parse_libopae_config(cfg_file, raw_cfg);
+	opae_v_supported_devices = opae_load_libopae_config(cfg_file);
 
 	if (cfg_file) {
 		opae_free(cfg_file);
@@ -128,6 +125,8 @@ int __VFIO_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaPinBuffer");
 	adapter->fpgaUnpinBuffer =
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaUnpinBuffer");
+	adapter->fpgaSharesParentMappings =
+		dlsym(adapter->plugin.dl_handle, "vfio_fpgaSharesParentMappings");
 	adapter->fpgaGetWSInfo =
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaGetWSInfo");
 	adapter->fpgaCreateEventHandle =
@@ -84,6 +84,31 @@ STATIC fpga_result buffer_allocate(void **addr, uint64_t len, int flags)
 	return FPGA_OK;
 }
 
+/*
+ * Set the NUMA policy of a newly-allocated buffer before its pages are
+ * faulted in by the DMA map ioctl. By default, the buffer prefers the
+ * device's node (numa_node); flags may select another node, interleave
+ * across all nodes, or no policy at all. Placement is a performance
+ * hint, so an mbind() failure is not an error.
+ */
+STATIC void buffer_set_mempolicy(void *addr, uint64_t len, int flags,
+				 int numa_node)
+{
+	int interleave = flags & FPGA_BUF_NUMA_INTERLEAVE;
+
+	if (flags & FPGA_BUF_NUMA_ANY)
+		return;
+
+	if (flags & FPGA_BUF_NUMA_NODE_VALID)
+		numa_node = FPGA_BUF_NUMA_NODE_OF(flags);
+
+	if (!interleave && (numa_node < 0))
+		return;
+
+	if (opae_mbind(addr, len, interleave, numa_node))
+		OPAE_DBG("mbind() failed: %s", strerror(errno));
+}
+
 /*
  * Release (unmap) allocated buffer
  */
@@ -147,7 +172,7 @@ fpga_result __XFPGA_API__ xfpga_fpgaPrepareBuffer(fpga_handle handle, uint64_t l
 	}
 
 	if (flags & (~(FPGA_BUF_PREALLOCATED | FPGA_BUF_QUIET |
-		       FPGA_BUF_READ_ONLY))) {
+		       FPGA_BUF_READ_ONLY | FPGA_BUF_NUMA_MASK))) {
 		OPAE_MSG("Unrecognized flags");
 		result = FPGA_INVALID_PARAM;
 		goto out_unlock;
@@ -205,6 +230,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaPrepareBuffer(fpga_handle handle, uint64_t l
 		if (result != FPGA_OK) {
 			goto out_unlock;
 		}
+
+		buffer_set_mempolicy(addr, len, flags, _handle->numa_node);
 	}
 
 	if (opae_port_map(_handle->fddev, addr, len, map_flags, &io_addr)) {
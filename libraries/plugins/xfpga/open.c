@@ -48,6 +48,7 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 	int fddev = -1;
 	pthread_mutexattr_t mattr;
 	int open_flags = 0;
+	char spath[SYSFS_PATH_MAX] = { 0, };
 
 	if (NULL == token) {
 		OPAE_MSG("token is NULL");
@@ -152,6 +153,13 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 #endif // GCC_VERSION
 #endif // x86
 
+	// The port/FME lives below its region, whose parent is the PCIe
+	// device. Buffers are placed on that device's NUMA node.
+	_handle->numa_node = -1;
+	if (cat_token_sysfs_path(spath, token, "../device/numa_node") ==
+	    FPGA_OK)
+		sysfs_read_int(spath, &_handle->numa_node);
+
 	// set handle return value
 	*handle = (void *)_handle;
 
@@ -155,6 +155,10 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaObjectRead");
 	adapter->fpgaObjectRead64 =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaObjectRead64");
+	adapter->fpgaObjectReadv =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaObjectReadv");
+	adapter->fpgaObjectReadGroup =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaObjectReadGroup");
 	adapter->fpgaObjectGetSize =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaObjectGetSize");
 	adapter->fpgaObjectGetType =
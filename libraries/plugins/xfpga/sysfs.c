@@ -39,6 +39,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <regex.h>
 #undef _GNU_SOURCE
 
@@ -1919,6 +1920,29 @@ ssize_t eintr_read(int fd, void *buf, size_t count)
 	return total_read;
 }
 
+ssize_t eintr_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	ssize_t bytes_read = 0, total_read = 0;
+	char *ptr = buf;
+	while (total_read < (ssize_t)count) {
+		bytes_read = opae_pread(fd, ptr + total_read,
+					count - total_read,
+					offset + total_read);
+
+		if (bytes_read < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return bytes_read;
+		} else if (bytes_read == 0) {
+			break;
+		} else {
+			total_read += bytes_read;
+		}
+	}
+	return total_read;
+}
+
 ssize_t eintr_write(int fd, void *buf, size_t count)
 {
 	ssize_t bytes_written = 0, total_written = 0;
@@ -2026,6 +2050,8 @@ struct _fpga_object *alloc_fpga_object(const char *sysfspath, const char *name)
 		obj->max_size = 0;
 		obj->buffer = NULL;
 		obj->objects = NULL;
+		obj->fd = -1;
+		obj->snapshot = false;
 	}
 	return obj;
 out_err:
@@ -2039,6 +2065,10 @@ out_err:
 fpga_result destroy_fpga_object(struct _fpga_object *obj)
 {
 	fpga_result res = FPGA_OK;
+	if (obj->fd >= 0) {
+		opae_close(obj->fd);
+		obj->fd = -1;
+	}
 	FREE_IF(obj->path);
 	FREE_IF(obj->name);
 	FREE_IF(obj->buffer);
@@ -2218,6 +2248,80 @@ fpga_result sync_object(fpga_object obj)
 	return FPGA_OK;
 }
 
+fpga_result sync_object_windows(fpga_object obj,
+				fpga_object_window *windows, size_t count)
+{
+	struct _fpga_object *_obj;
+	int fd = -1;
+	fpga_result res = FPGA_OK;
+	ssize_t bytes_read;
+	struct stat st;
+	uint8_t *map = MAP_FAILED;
+	size_t map_off = 0;
+	size_t map_len = 0;
+	size_t lo = SIZE_MAX;
+	size_t hi = 0;
+	size_t i;
+	ASSERT_NOT_NULL(obj);
+	ASSERT_NOT_NULL(windows);
+	_obj = (struct _fpga_object *)obj;
+
+	for (i = 0 ; i < count ; ++i) {
+		if (windows[i].offset < lo)
+			lo = windows[i].offset;
+		if (windows[i].offset + windows[i].len > hi)
+			hi = windows[i].offset + windows[i].len;
+	}
+
+	fd = opae_open(_obj->path, _obj->perm);
+	if (fd < 0) {
+		OPAE_ERR("Error opening %s: %s", _obj->path, strerror(errno));
+		return FPGA_EXCEPTION;
+	}
+
+	// When several windows are requested, map the span that covers
+	// them once. Only bin_attribute files that implement mmap allow
+	// this; everything else falls back to one pread per window.
+	if (count > 1 && !fstat(fd, &st) && (size_t)st.st_size >= hi) {
+		size_t pg_size = (size_t)sysconf(_SC_PAGE_SIZE);
+		map_off = lo & ~(pg_size - 1);
+		map_len = hi - map_off;
+		map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd,
+			   (off_t)map_off);
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		fpga_object_window *w = &windows[i];
+
+		if (map != MAP_FAILED) {
+			memcpy(w->buffer, map + (w->offset - map_off), w->len);
+		} else {
+			bytes_read = eintr_pread(fd, w->buffer, w->len,
+						 (off_t)w->offset);
+			if (bytes_read < 0) {
+				OPAE_ERR("Error reading %s: %s",
+					 _obj->path, strerror(errno));
+				res = FPGA_EXCEPTION;
+				break;
+			}
+			if ((size_t)bytes_read < w->len) {
+				OPAE_ERR("Bytes requested exceed object size");
+				res = FPGA_INVALID_PARAM;
+				break;
+			}
+		}
+
+		// Keep the buffered copy in step with what was read.
+		if (w->offset + w->len <= _obj->max_size)
+			memcpy(_obj->buffer + w->offset, w->buffer, w->len);
+	}
+
+	if (map != MAP_FAILED)
+		munmap(map, map_len);
+	opae_close(fd);
+	return res;
+}
+
 fpga_result make_sysfs_group(char *sysfspath, const char *name,
 			     fpga_object *object, int flags, fpga_handle handle)
 {
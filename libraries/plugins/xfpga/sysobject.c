@@ -29,6 +29,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <string.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <inttypes.h>
@@ -265,16 +266,162 @@ fpga_result __XFPGA_API__ xfpga_fpgaObjectRead(fpga_object obj,
 	}
 
 	if (flags & FPGA_OBJECT_SYNC) {
-		res = sync_object(obj);
-		if (res) {
-			return res;
+		// Fetch only the requested window from the resource.
+		fpga_object_window window = { buffer, offset, len };
+		return sync_object_windows(obj, &window, 1);
+	}
+	memcpy(buffer, _obj->buffer + offset, len);
+
+	return res;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaObjectReadv(fpga_object obj,
+					       fpga_object_window *windows,
+					       size_t count,
+					       int flags)
+{
+	struct _fpga_object *_obj = (struct _fpga_object *)obj;
+	size_t i;
+	ASSERT_NOT_NULL(obj);
+	ASSERT_NOT_NULL(windows);
+	if (_obj->type != FPGA_SYSFS_FILE) {
+		return FPGA_INVALID_PARAM;
+	}
+	for (i = 0 ; i < count ; ++i) {
+		if (!windows[i].buffer ||
+		    windows[i].offset + windows[i].len > _obj->size) {
+			return FPGA_INVALID_PARAM;
 		}
 	}
-	if (offset + len > _obj->size) {
-		OPAE_ERR("Bytes requested exceed object size");
+
+	if (flags & FPGA_OBJECT_SYNC) {
+		return sync_object_windows(obj, windows, count);
+	}
+
+	for (i = 0 ; i < count ; ++i) {
+		memcpy(windows[i].buffer, _obj->buffer + windows[i].offset,
+		       windows[i].len);
+	}
+
+	return FPGA_OK;
+}
+
+// Re-read one member of a group through its cached descriptor, and
+// report whether its contents differ from the last snapshot.
+STATIC fpga_result snapshot_object(struct _fpga_object *obj, bool *changed)
+{
+	uint8_t *buffer;
+	ssize_t bytes_read;
+
+	if (obj->fd < 0) {
+		obj->fd = opae_open(obj->path, obj->perm);
+		if (obj->fd < 0) {
+			OPAE_DBG("Error opening %s: %s",
+				 obj->path, strerror(errno));
+			return FPGA_EXCEPTION;
+		}
+	}
+
+	buffer = opae_malloc(obj->max_size);
+	if (!buffer) {
+		return FPGA_NO_MEMORY;
+	}
+
+	// sysfs regenerates an attribute when it is read from offset 0.
+	bytes_read = eintr_pread(obj->fd, buffer, obj->max_size - 1, 0);
+	if (bytes_read < 0) {
+		OPAE_DBG("Error reading %s: %s", obj->path, strerror(errno));
+		opae_free(buffer);
+		opae_close(obj->fd);
+		obj->fd = -1;
+		return FPGA_EXCEPTION;
+	}
+	buffer[bytes_read] = '\0';
+
+	*changed = !obj->snapshot ||
+		   (size_t)bytes_read != obj->size ||
+		   memcmp(buffer, obj->buffer, bytes_read);
+
+	opae_free(obj->buffer);
+	obj->buffer = buffer;
+	obj->size = bytes_read;
+	obj->snapshot = true;
+	return FPGA_OK;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaObjectReadGroup(fpga_object group,
+						   fpga_object_value *values,
+						   size_t count,
+						   size_t *changed,
+						   int flags)
+{
+	struct _fpga_object *_obj = (struct _fpga_object *)group;
+	size_t num_changed = 0;
+	size_t i;
+	ASSERT_NOT_NULL(group);
+	ASSERT_NOT_NULL(values);
+
+	if (_obj->type == FPGA_SYSFS_FILE) {
 		return FPGA_INVALID_PARAM;
 	}
-	memcpy(buffer, _obj->buffer + offset, len);
+
+	if (pthread_mutex_lock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_lock() failed");
+		return FPGA_EXCEPTION;
+	}
+
+	if (count < _obj->size) {
+		pthread_mutex_unlock(&_obj->lock);
+		return FPGA_INVALID_PARAM;
+	}
+
+	for (i = 0 ; i < _obj->size ; ++i) {
+		struct _fpga_object *child =
+			(struct _fpga_object *)_obj->objects[i];
+		fpga_object_value *v = &values[i];
+
+		v->name = child->name;
+		v->value = 0;
+		v->changed = false;
+
+		if (child->type != FPGA_SYSFS_FILE ||
+		    child->perm == O_WRONLY) {
+			v->result = FPGA_NOT_SUPPORTED;
+			continue;
+		}
+
+		if (pthread_mutex_lock(&child->lock)) {
+			OPAE_ERR("pthread_mutex_lock() failed");
+			v->result = FPGA_EXCEPTION;
+			continue;
+		}
+
+		v->result = snapshot_object(child, &v->changed);
+		if (v->result == FPGA_OK) {
+			if (flags & FPGA_OBJECT_RAW) {
+				memcpy(&v->value, child->buffer,
+				       child->size < sizeof(v->value) ?
+				       child->size : sizeof(v->value));
+			} else {
+				v->value = strtoull((char *)child->buffer,
+						    NULL, 0);
+			}
+		}
+
+		if (pthread_mutex_unlock(&child->lock)) {
+			OPAE_ERR("pthread_mutex_unlock() failed");
+		}
+
+		if (v->result == FPGA_OK && v->changed)
+			++num_changed;
+	}
+
+	if (pthread_mutex_unlock(&_obj->lock)) {
+		OPAE_ERR("pthread_mutex_unlock() failed");
+	}
+
+	if (changed)
+		*changed = num_changed;
 
 	return FPGA_OK;
 }
@@ -167,6 +167,7 @@ struct _fpga_handle {
 	void *umsg_virt;	        // umsg Virtual Memory pointer
 	uint64_t umsg_size;	        // umsg Virtual Memory Size
 	uint64_t *umsg_iova;	        // umsg IOVA from driver
+	int numa_node;                  // NUMA node of the device, or -1
 
 	// Metric
 	bool metric_enum_status;                             // metric enum status
@@ -239,6 +240,8 @@ struct _fpga_object {
 	size_t max_size;
 	uint8_t *buffer;
 	fpga_object *objects;
+	int fd;         // kept open by fpgaObjectReadGroup(), or -1
+	bool snapshot;  // buffer holds a value from fpgaObjectReadGroup()
 };
 
 typedef char max_path_t[PATH_MAX];
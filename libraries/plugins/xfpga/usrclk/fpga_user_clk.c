@@ -33,6 +33,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <glob.h>
+#include <time.h>
 #include <opae/uio.h>
 
 #include "fpga_user_clk.h"
@@ -66,6 +67,58 @@ struct dfh {
 	};
 };
 
+STATIC uint64_t usrclk_elapsed_us(const struct timespec *start)
+{
+	struct timespec now;
+	int64_t us;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	us = (int64_t)(now.tv_sec - start->tv_sec) * 1000000 +
+	     (now.tv_nsec - start->tv_nsec) / 1000;
+
+	return us < 0 ? 0 : (uint64_t)us;
+}
+
+fpga_result usrclk_poll_sts0(uint8_t *uio_ptr,
+	uint64_t mask, uint64_t value,
+	uint32_t timeout_us, uint64_t *sts0)
+{
+	struct timespec start;
+	uint32_t spins = 0;
+	uint64_t v     = 0;
+
+	if (uio_ptr == NULL) {
+		OPAE_ERR("Invalid input parameters");
+		return FPGA_INVALID_PARAM;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (1) {
+		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
+		if ((v & mask) == value)
+			break;
+
+		if (usrclk_elapsed_us(&start) >= timeout_us) {
+			if (sts0)
+				*sts0 = v;
+			return FPGA_BUSY;
+		}
+
+		// Most IOPLL status changes complete within a few
+		// CSR reads. Only start sleeping for the slow ones.
+		if (spins < IOPLL_POLL_SPIN_COUNT)
+			++spins;
+		else
+			usleep(IOPLL_WRITE_POLL_INVL_US);
+	}
+
+	if (sts0)
+		*sts0 = v;
+	return FPGA_OK;
+}
+
 fpga_result usrclk_reset(uint8_t *uio_ptr)
 {
 	uint64_t v      = 0;
@@ -92,11 +145,11 @@ fpga_result usrclk_reset(uint8_t *uio_ptr)
 	v = IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	usleep(IOPLL_RESET_DELAY_US);
-
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-	if (!(v & IOPLL_LOCKED)) {
-		OPAE_ERR("IOPLL NOT locked after reset");;
+	/* Wait no longer than necessary for the IOPLL to lock */
+	res = usrclk_poll_sts0(uio_ptr, IOPLL_LOCKED, IOPLL_LOCKED,
+			       IOPLL_RESET_DELAY_US, NULL);
+	if (res != FPGA_OK) {
+		OPAE_ERR("IOPLL NOT locked after reset");
 		res = FPGA_BUSY;
 	}
 
@@ -66,6 +66,7 @@ extern "C" {
 #define IOPLL_CAL_DELAY_US            1000
 #define IOPLL_WRITE_POLL_INVL_US      10 /* Write poll interval */
 #define IOPLL_WRITE_POLL_TIMEOUT_US   1000000 /* Write poll timeout */
+#define IOPLL_POLL_SPIN_COUNT         64 /* Status reads before sleeping */
 
 #define  IOPLL_MAX_FREQ             600
 #define  IOPLL_MIN_FREQ             10
@@ -98,6 +99,24 @@ extern const struct iopll_config iopll_agilex_freq_config[];
 fpga_result usrclk_reset(uint8_t *uio_ptr);
 int usrclk_using_iopll(char *sysfs_usrpath, const char *sysfs_path);
 
+/**
+ * @brief poll the IOPLL STS0 register
+ *
+ * Spins on STS0 for a short while, then falls back to sleeping
+ * between reads, until (STS0 & mask) == value or the timeout expires.
+ *
+ * @param uio_ptr     mapped user clock registers
+ * @param mask        STS0 bits to compare
+ * @param value       expected value of the masked bits
+ * @param timeout_us  maximum time to wait, in microseconds
+ * @param sts0        if not NULL, receives the last STS0 value read
+ *
+ * @return FPGA_OK on match, FPGA_BUSY on timeout
+ */
+fpga_result usrclk_poll_sts0(uint8_t *uio_ptr,
+			     uint64_t mask, uint64_t value,
+			     uint32_t timeout_us, uint64_t *sts0);
+
 /**
  * @brief open UIO handle to fpga user clock manager
  *
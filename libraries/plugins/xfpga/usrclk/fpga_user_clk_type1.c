@@ -41,6 +41,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <glob.h>
+#include <time.h>
 #include <opae/uio.h>
 
 #include "fpga_user_clk.h"
@@ -107,7 +108,6 @@ STATIC fpga_result usrclk_write(uint8_t *uio_ptr, uint16_t address,
 {
 	fpga_result res   = FPGA_OK;
 	uint64_t v        = 0;
-	uint32_t timeout  = IOPLL_WRITE_POLL_TIMEOUT_US;
 
 	if (uio_ptr == NULL) {
 		OPAE_ERR("Invalid input parameters");
@@ -122,16 +122,10 @@ STATIC fpga_result usrclk_write(uint8_t *uio_ptr, uint16_t address,
 	v |= IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-
-	while (!(FIELD_GET(IOPLL_SEQ, v) == seq)) {
-		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-		usleep(IOPLL_WRITE_POLL_INVL_US);
-		if (--timeout == 0) {
-			OPAE_ERR("Timeout on IOPLL write");
-			res = FPGA_EXCEPTION;
-			break;
-		}
+	if (usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, seq),
+			     IOPLL_WRITE_POLL_TIMEOUT_US, NULL)) {
+		OPAE_ERR("Timeout on IOPLL write");
+		res = FPGA_EXCEPTION;
 	}
 
 	return res;
@@ -141,7 +135,6 @@ STATIC fpga_result usrclk_read(uint8_t *uio_ptr, uint16_t address,
 	uint32_t *data, uint8_t seq)
 {
 	uint64_t v       = 0;
-	uint32_t timeout = IOPLL_WRITE_POLL_TIMEOUT_US;
 
 	if (uio_ptr == NULL) {
 		OPAE_ERR("Invalid input parameters");
@@ -154,15 +147,10 @@ STATIC fpga_result usrclk_read(uint8_t *uio_ptr, uint16_t address,
 	v |= IOPLL_AVMM_RESET_N;
 	*((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_CMD0)) = v;
 
-	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-
-	while (!(FIELD_GET(IOPLL_SEQ, v) == seq)) {
-		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
-		usleep(IOPLL_WRITE_POLL_INVL_US);
-		if (--timeout == 0) {
-			OPAE_ERR("Timeout on IOPLL write");
-			return FPGA_EXCEPTION;
-		}
+	if (usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, seq),
+			     IOPLL_WRITE_POLL_TIMEOUT_US, &v)) {
+		OPAE_ERR("Timeout on IOPLL write");
+		return FPGA_EXCEPTION;
 	}
 
 	*data = FIELD_GET(IOPLL_DATA, v);
@@ -357,6 +345,42 @@ STATIC fpga_result usrclk_set_freq(uint8_t *uio_ptr,
 	return usrclk_write(uio_ptr, PLL_LF_ADDR, lf | rc, (*seq)++);
 }
 
+/*
+ * Wait for the calibration request bit to self-clear and the IOPLL
+ * to lock, for at most IOPLL_CAL_DELAY_US. Calibration normally
+ * finishes well before that. When the bound expires we carry on
+ * exactly as the fixed delay used to.
+ */
+STATIC fpga_result usrclk_wait_calibrated(uint8_t *uio_ptr, uint8_t *seq)
+{
+	struct timespec start;
+	struct timespec now;
+	uint32_t data   = 0;
+	int64_t elapsed = 0;
+	uint64_t v      = 0;
+	fpga_result res = FPGA_OK;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	do {
+		res = usrclk_read(uio_ptr, PLL_REQUEST_CAL_ADDR, &data, (*seq)++);
+		if (res)
+			return res;
+
+		v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
+		if (!(data & PLL_REQUEST_CALIBRATION) && (v & IOPLL_LOCKED))
+			return FPGA_OK;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed = (int64_t)(now.tv_sec - start.tv_sec) * 1000000 +
+			  (now.tv_nsec - start.tv_nsec) / 1000;
+	} while (elapsed < IOPLL_CAL_DELAY_US);
+
+	OPAE_DBG("IOPLL calibration status not seen after %d usec",
+		 IOPLL_CAL_DELAY_US);
+	return FPGA_OK;
+}
+
 STATIC fpga_result usrclk_calibrate(uint8_t *uio_ptr, uint8_t *seq)
 {
 	fpga_result res = FPGA_OK;
@@ -377,8 +401,64 @@ STATIC fpga_result usrclk_calibrate(uint8_t *uio_ptr, uint8_t *seq)
 	/* Enable calibration interface */
 	res = usrclk_write(uio_ptr, PLL_ENABLE_CAL_ADDR, PLL_ENABLE_CALIBRATION,
 		(*seq)++);
-	usleep(IOPLL_CAL_DELAY_US);
-	return res;
+	if (res)
+		return res;
+
+	return usrclk_wait_calibrated(uio_ptr, seq);
+}
+
+STATIC bool usrclk_counter_matches(uint8_t *uio_ptr, uint16_t high_addr,
+	uint16_t low_addr, uint32_t cfg, uint8_t *seq)
+{
+	uint32_t high = 0;
+	uint32_t low  = 0;
+
+	if (usrclk_read(uio_ptr, high_addr, &high, (*seq)++) ||
+	    usrclk_read(uio_ptr, low_addr, &low, (*seq)++))
+		return false;
+
+	return ((high & 0xff) == FIELD_GET(CFG_PLL_HIGH, cfg)) &&
+	       ((low & 0xff) == FIELD_GET(CFG_PLL_LOW, cfg));
+}
+
+/*
+ * Check whether the IOPLL already runs at the requested configuration:
+ * it must be locked, and the M, N, C0 and C1 counters read back from
+ * the PLL must hold the values we would program. Reading the counters
+ * catches reprogramming by any other process or agent.
+ */
+STATIC bool usrclk_config_active(const char *sysfs_path,
+	struct pll_config *c)
+{
+	uint8_t seq      = 0;
+	uint8_t *uio_ptr = NULL;
+	uint64_t v       = 0;
+	bool active      = false;
+	struct opae_uio uio;
+
+	memset(&uio, 0, sizeof(uio));
+	if (get_usrclk_uio(sysfs_path, USRCLK_FEATURE_ID,
+			   &uio, &uio_ptr) != FPGA_OK)
+		return false;
+
+	v = *((volatile uint64_t *)(uio_ptr + IOPLL_FREQ_STS0));
+	if (!(v & IOPLL_LOCKED))
+		goto out_close;
+
+	seq = FIELD_GET(IOPLL_SEQ, v) + 1;
+
+	active = usrclk_counter_matches(uio_ptr, PLL_M_HIGH_ADDR,
+			PLL_M_LOW_ADDR, c->pll_m, &seq) &&
+		 usrclk_counter_matches(uio_ptr, PLL_N_HIGH_ADDR,
+			PLL_N_LOW_ADDR, c->pll_n, &seq) &&
+		 usrclk_counter_matches(uio_ptr, PLL_C0_HIGH_ADDR,
+			PLL_C0_LOW_ADDR, c->pll_c0, &seq) &&
+		 usrclk_counter_matches(uio_ptr, PLL_C1_HIGH_ADDR,
+			PLL_C1_LOW_ADDR, c->pll_c1, &seq);
+
+out_close:
+	opae_uio_close(&uio);
+	return active;
 }
 
 // set fpga user clock
@@ -442,6 +522,11 @@ fpga_result set_userclock_type1(const char *sysfs_path,
 		return FPGA_NOT_SUPPORTED;
 	}
 
+	// Nothing to do if the IOPLL is already locked at the
+	// requested configuration.
+	if (usrclk_config_active(sysfs_path, (struct pll_config *)bufp))
+		return FPGA_OK;
+
 	// Transitions from a currently configured very high frequency
 	// or very low frequency to another extreme frequency sometimes
 	// fails to stabilize. Start by forcing the fast clock to half
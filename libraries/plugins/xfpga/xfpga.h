@@ -118,6 +118,11 @@ fpga_result xfpga_fpgaObjectGetSize(fpga_object obj, uint32_t *value,
 fpga_result xfpga_fpgaObjectRead(fpga_object obj, uint8_t *buffer,
 				 size_t offset, size_t len, int flags);
 fpga_result xfpga_fpgaObjectRead64(fpga_object obj, uint64_t *value, int flags);
+fpga_result xfpga_fpgaObjectReadv(fpga_object obj, fpga_object_window *windows,
+				  size_t count, int flags);
+fpga_result xfpga_fpgaObjectReadGroup(fpga_object group,
+				      fpga_object_value *values, size_t count,
+				      size_t *changed, int flags);
 fpga_result xfpga_fpgaObjectWrite64(fpga_object obj, uint64_t value, int flags);
 fpga_result xfpga_fpgaSetUserClock(fpga_handle handle, uint64_t low_clk,
 				   uint64_t high_clk, int flags);
@@ -200,7 +200,8 @@ PYBIND11_MODULE(_opae, m) {
         []() { std::atomic_thread_fence(std::memory_order_release); },
         memory_barrier_doc);
   // define token class
-  m.def("enumerate", &token::enumerate, token_doc_enumerate())
+  m.def("enumerate", &token::enumerate, token_doc_enumerate(),
+        py::call_guard<py::gil_scoped_release>())
       .def("enumerate", token_enumerate_kwargs, token_doc_enumerate_kwargs());
   py::class_<token, token::ptr_t> pytoken(m, "token", token_doc());
   pytoken.def("__getattr__", token_get_sysobject, sysobject_doc_token_get())
@@ -217,8 +218,10 @@ PYBIND11_MODULE(_opae, m) {
       .def("reconfigure", handle_reconfigure, handle_doc_reconfigure(),
            py::arg("slot"), py::arg("fd"), py::arg("flags") = 0)
       .def("__bool__", handle_valid, handle_doc_valid())
-      .def("close", &handle::close, handle_doc_close())
-      .def("reset", &handle::reset, handle_doc_reset())
+      .def("close", &handle::close, handle_doc_close(),
+           py::call_guard<py::gil_scoped_release>())
+      .def("reset", &handle::reset, handle_doc_reset(),
+           py::call_guard<py::gil_scoped_release>())
       .def("read_csr32", &handle::read_csr32, handle_doc_read_csr32(),
            py::arg("offset"), py::arg("csr_space") = 0)
       .def("read_csr64", &handle::read_csr64, handle_doc_read_csr64(),
@@ -234,15 +237,27 @@ PYBIND11_MODULE(_opae, m) {
       .def("bind_sva", &handle::bind_sva, handle_doc_bind_sva());
 
   // define shared_buffer class
+  py::enum_<shared_buffer::placement>(m, "buffer_placement",
+                                      "NUMA placement of shared buffers")
+      .value("DEVICE", shared_buffer::placement::device)
+      .value("NODE", shared_buffer::placement::node)
+      .value("ANY", shared_buffer::placement::any)
+      .value("INTERLEAVE", shared_buffer::placement::interleave);
+
   m.def("allocate_shared_buffer", shared_buffer_allocate,
-        shared_buffer_doc_allocate());
+        shared_buffer_doc_allocate(), py::arg("handle"), py::arg("len"),
+        py::arg("read_only") = false,
+        py::arg("placement") = shared_buffer::placement::device,
+        py::arg("numa_node") = -1);
   py::class_<shared_buffer, shared_buffer::ptr_t> pybuffer(
       m, "shared_buffer", py::buffer_protocol(), shared_buffer_doc());
   pybuffer.def("size", &shared_buffer::size, shared_buffer_doc_size())
       .def("wsid", &shared_buffer::wsid, shared_buffer_doc_wsid())
       .def("io_address", &shared_buffer::io_address,
            shared_buffer_doc_io_address())
-      .def("fill", &shared_buffer::fill, shared_buffer_doc_fill())
+      .def("fill",
+           static_cast<void (shared_buffer::*)(int)>(&shared_buffer::fill),
+           shared_buffer_doc_fill(), py::call_guard<py::gil_scoped_release>())
       .def("poll", shared_buffer_poll<uint8_t>,
            "Poll for an 8-bit value being set at given offset",
            py::arg("offset"), py::arg("value"), py::arg("mask") = 0,
@@ -255,9 +270,11 @@ PYBIND11_MODULE(_opae, m) {
            "Poll for a 64-bit value being set at given offset",
            py::arg("offset"), py::arg("value"), py::arg("mask"),
            py::arg("timeout_usec") = 1000)
-      .def("compare", &shared_buffer::compare, shared_buffer_doc_compare())
+      .def("compare", &shared_buffer::compare, shared_buffer_doc_compare(),
+           py::call_guard<py::gil_scoped_release>())
       .def("copy", shared_buffer_copy, shared_buffer_doc_copy(),
-           py::arg("other"), py::arg("size") = 0)
+           py::arg("other"), py::arg("size") = 0,
+           py::call_guard<py::gil_scoped_release>())
       .def_buffer([](shared_buffer &b) -> py::buffer_info {
         return py::buffer_info(
             const_cast<uint8_t *>(b.c_type()), sizeof(uint8_t),
@@ -279,7 +296,9 @@ PYBIND11_MODULE(_opae, m) {
         py::arg("handle"), py::arg("event_type"), py::arg("flags") = 0);
   py::class_<event, event::ptr_t> pyevent(m, "event", event_doc());
 
-  pyevent.def("os_object", event_os_object, event_doc_os_object());
+  pyevent.def("os_object", event_os_object, event_doc_os_object())
+      .def("wait", event_wait, event_doc_wait(),
+           py::arg("timeout_msec") = -1);
 
   py::class_<error, error::ptr_t> pyerror(m, "error", error_doc());
   pyerror.def_property_readonly("name", &error::name, error_doc_name())
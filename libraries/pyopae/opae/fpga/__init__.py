@@ -32,6 +32,7 @@ from ._opae import (
     enumerate,
     open,
     allocate_shared_buffer,
+    buffer_placement,
     register_event,
     error,
     errors,
@@ -51,6 +52,7 @@ __all__ = ['properties',
            'enumerate',
            'open',
            'allocate_shared_buffer',
+           'buffer_placement',
            'register_event',
            'error',
            'errors',
@@ -0,0 +1,96 @@
+# Copyright(c) 2024, Intel Corporation
+#
+# Redistribution  and  use  in source  and  binary  forms,  with  or  without
+# modification, are permitted provided that the following conditions are met:
+#
+# * Redistributions of  source code  must retain the  above copyright notice,
+#   this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright notice,
+#   this list of conditions and the following disclaimer in the documentation
+#   and/or other materials provided with the distribution.
+# * Neither the name  of Intel Corporation  nor the names of its contributors
+#   may be used to  endorse or promote  products derived  from this  software
+#   without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+# IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+# LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+# CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+# SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+# INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+# CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+"""asyncio helpers for FPGA events and shared buffer polls.
+
+The blocking calls in opae.fpga release the GIL while they wait, so
+they can run on an executor thread without stalling the interpreter.
+Events are waited for on the event loop itself, by watching the OS
+object of the event with loop.add_reader().
+"""
+
+import asyncio
+import functools
+
+
+async def wait_event(event, timeout=None):
+    """Wait for an FPGA event from a coroutine.
+
+    Args:
+      event: An event object returned by opae.fpga.register_event().
+      timeout: The time to wait in seconds, or None to wait forever.
+
+    Returns the number of times the event was signaled since it was
+    last consumed. Raises asyncio.TimeoutError if the timeout expires.
+    """
+    loop = asyncio.get_running_loop()
+    fd = event.os_object()
+    future = loop.create_future()
+
+    def on_readable():
+        if future.done():
+            return
+        count = event.wait(0)
+        if count:
+            future.set_result(count)
+
+    loop.add_reader(fd, on_readable)
+    try:
+        return await asyncio.wait_for(future, timeout)
+    finally:
+        loop.remove_reader(fd)
+
+
+_POLL_WIDTHS = {8: 'poll', 32: 'poll32', 64: 'poll64'}
+
+
+async def poll(buf, offset, value, mask=0, timeout_usec=1000, width=64,
+               executor=None):
+    """Wait for a value in a shared buffer from a coroutine.
+
+    The wait runs on an executor thread, so many buffers (and many
+    FPGAs) can be polled concurrently from one event loop.
+
+    Args:
+      buf: A shared_buffer object.
+      offset: The byte offset of the value in the buffer.
+      value: The value to wait for.
+      mask: The bits of the value to compare, 0 compares all bits.
+      timeout_usec: The time to wait in microseconds.
+      width: The size of the value in bits: 8, 32 or 64.
+      executor: The concurrent.futures executor to wait on, or None
+                for the loop's default executor.
+
+    Returns True if the value was seen before the timeout.
+    """
+    try:
+        method = getattr(buf, _POLL_WIDTHS[width])
+    except KeyError:
+        raise ValueError('width must be one of 8, 32 or 64') from None
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(
+        executor,
+        functools.partial(method, offset, value, mask, timeout_usec))
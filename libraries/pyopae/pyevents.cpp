@@ -24,6 +24,10 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #include "pyevents.h"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
 namespace py = pybind11;
 using opae::fpga::types::event;
 
@@ -65,3 +69,56 @@ const char *event_doc_os_object() {
 int event_os_object(opae::fpga::types::event::ptr_t evnt) {
   return evnt->os_object();
 }
+
+const char *event_doc_wait() {
+  return R"opaedoc(
+    Wait for the event to be signaled and consume it.
+    Other Python threads keep running while the calling thread waits.
+
+    Args:
+      timeout_msec: The time to wait in milliseconds. A negative value
+                    waits forever and 0 only checks whether the event
+                    is pending.
+
+    Returns the number of times the event was signaled since it was
+    last consumed, or 0 if the wait timed out.
+
+    To wait from an asyncio event loop, register os_object() with
+    loop.add_reader() and call wait(0) from the reader callback,
+    or use opae.fpga.aio.wait_event().
+  )opaedoc";
+}
+
+uint64_t event_wait(opae::fpga::types::event::ptr_t evnt, int timeout_msec) {
+  struct pollfd pfd;
+  uint64_t count = 0;
+  int res;
+  int err = 0;
+
+  pfd.fd = evnt->os_object();
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  {
+    py::gil_scoped_release release;
+    do {
+      res = poll(&pfd, 1, timeout_msec);
+    } while (res < 0 && errno == EINTR);
+
+    if (res < 0) {
+      err = errno;
+    } else if (res > 0 && (pfd.revents & POLLIN)) {
+      // The OS object is an eventfd. Reading it returns the number of
+      // signals since the last read and re-arms it.
+      if (read(pfd.fd, &count, sizeof(count)) !=
+          static_cast<ssize_t>(sizeof(count))) {
+        count = 0;
+      }
+    }
+  }
+
+  if (res < 0) {
+    throw std::system_error(err, std::system_category(), "poll");
+  }
+  return count;
+}
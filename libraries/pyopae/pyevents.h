@@ -38,3 +38,6 @@ opae::fpga::types::event::ptr_t event_register_event(
 const char *event_doc_os_object();
 int event_os_object(opae::fpga::types::event::ptr_t evnt);
 
+const char *event_doc_wait();
+uint64_t event_wait(opae::fpga::types::event::ptr_t evnt, int timeout_msec);
+
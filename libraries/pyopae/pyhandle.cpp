@@ -39,6 +39,7 @@ const char *handle_doc_open() {
 }
 
 handle::ptr_t handle_open(token::ptr_t tok, int flags) {
+  py::gil_scoped_release release;
   return handle::open(tok, flags);
 }
 
@@ -85,6 +86,7 @@ void handle_reconfigure(handle::ptr_t handle, uint32_t slot, py::object file,
     throw std::runtime_error("error reading from file object");
   }
   fclose(fp);
+  py::gil_scoped_release release;
   handle->reconfigure(slot, reinterpret_cast<const uint8_t *>(buffer.data()),
                       size, flags);
 }
@@ -45,11 +45,24 @@ const char *shared_buffer_doc_allocate() {
       handle: An accelerator handle object that identifies an open accelerator
       obect to share the buffer with.
       len: The length in bytes of the requested buffer.
+      read_only: Pin the buffer with read access only from the accelerator.
+      placement: A buffer_placement value. DEVICE (the default) prefers the
+      device's NUMA node, NODE prefers numa_node, ANY applies no policy and
+      INTERLEAVE spreads the buffer across all nodes.
+      numa_node: The NUMA node used with buffer_placement.NODE.
   )opaedoc";
 }
 
-shared_buffer::ptr_t shared_buffer_allocate(handle::ptr_t hndl, size_t size) {
-  auto buf = shared_buffer::allocate(hndl, size);
+shared_buffer::ptr_t shared_buffer_allocate(handle::ptr_t hndl, size_t size,
+                                            bool read_only,
+                                            shared_buffer::placement where,
+                                            int numa_node) {
+  shared_buffer::ptr_t buf;
+  {
+    // Pinning a large buffer can take a while.
+    py::gil_scoped_release release;
+    buf = shared_buffer::allocate(hndl, size, read_only, where, numa_node);
+  }
   buffer_registry::instance().add_buffer(hndl, buf);
   return buf;
 }
@@ -34,7 +34,8 @@ const char *shared_buffer_doc();
 
 const char *shared_buffer_doc_allocate();
 opae::fpga::types::shared_buffer::ptr_t shared_buffer_allocate(
-    opae::fpga::types::handle::ptr_t hndl, size_t size);
+    opae::fpga::types::handle::ptr_t hndl, size_t size, bool read_only,
+    opae::fpga::types::shared_buffer::placement where, int numa_node);
 const char *shared_buffer_doc_size();
 
 const char *shared_buffer_doc_wsid();
@@ -73,19 +74,13 @@ template <typename T>
 bool shared_buffer_poll(opae::fpga::types::shared_buffer::ptr_t self,
                         size_t offset, T value, T mask = 0,
                         uint64_t timeout_usec = 1000) {
-  using hrc = std::chrono::high_resolution_clock;
-  auto ptr = self->c_type();
-  auto begin = hrc::now();
   std::chrono::microseconds timeout(timeout_usec);
   if (!mask) {
     mask = ~mask;
   }
 
-  while ((*reinterpret_cast<volatile T *>(ptr + offset) & mask) != value) {
-    if (std::chrono::duration_cast<std::chrono::microseconds>(
-            hrc::now() - begin) >= timeout) {
-      return false;
-    }
-  }
-  return true;
+  // The accelerator writes the value without any help from Python,
+  // so let other threads run while we wait for it.
+  pybind11::gil_scoped_release release;
+  return self->wait_for<T>(offset, mask, value, timeout);
 }
@@ -63,5 +63,7 @@ const char *token_doc_enumerate_kwargs() {
 }
 
 std::vector<token::ptr_t> token_enumerate_kwargs(py::kwargs kwargs) {
-  return token::enumerate({properties_get(kwargs)});
+  auto filter = properties_get(kwargs);
+  py::gil_scoped_release release;
+  return token::enumerate({filter});
 };
@@ -23,6 +23,7 @@
 # CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 # POSSIBILITY OF SUCH DAMAGE.
+import asyncio
 import json
 import select
 import struct
@@ -33,6 +34,7 @@ import unittest
 import uuid
 import sys
 import opae.fpga
+import opae.fpga.aio
 
 NLB0 = "d8424dc4-a4a3-c413-f89e-433683f9040b"
 
@@ -421,6 +423,24 @@ class TestEvent(unittest.TestCase):
         # temporarily disalbe this assertion
         #assert received_event
 
+    def test_event_wait_timeout(self):
+        err_ev = opae.fpga.register_event(self.handle,
+                                          opae.fpga.EVENT_ERROR)
+        assert err_ev
+        assert err_ev.wait(0) == 0
+        assert err_ev.wait(10) == 0
+
+    def test_wait_event_async_timeout(self):
+        err_ev = opae.fpga.register_event(self.handle,
+                                          opae.fpga.EVENT_ERROR)
+        assert err_ev
+
+        async def waiter():
+            with self.assertRaises(asyncio.TimeoutError):
+                await opae.fpga.aio.wait_event(err_ev, 0.1)
+
+        asyncio.run(waiter())
+
 
 class TestError(unittest.TestCase):
     def setUp(self):
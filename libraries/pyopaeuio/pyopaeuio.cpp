@@ -30,6 +30,7 @@
 #include <pybind11/stl.h>
 
 #include <exception>
+#include <string>
 
 // open uio
 int pyopae_uio::open(const std::string &uio_str) {
@@ -186,13 +187,88 @@ size_t pyopae_uio::get_size(uint32_t region_index) {
   return size;
 }
 
+// get a pointer to count registers of width bits at offset
+uint8_t *pyopae_uio::get_block(uint32_t region_index, uint32_t offset,
+                               size_t count, unsigned width) {
+  uint8_t *vptr = nullptr;
+  size_t size = 0;
+
+  uio_check_width(width);
+  if (opae_uio_region_get(&uio_, region_index, &vptr, &size)) {
+    throw std::invalid_argument("Failed to get uio region");
+  }
+  return uio_block(vptr, size, offset, count, width);
+}
+
+// read count registers, one access of width bits each
+void pyopae_uio::read_block(uint32_t region_index, uint32_t offset, void *dst,
+                            size_t count, unsigned width) {
+  uint8_t *ptr = get_block(region_index, offset, count, width);
+  uio_mmio_copy(ptr, dst, count, width);
+}
+
+// write count registers, one access of width bits each
+void pyopae_uio::write_block(uint32_t region_index, uint32_t offset,
+                             const void *src, size_t count, unsigned width) {
+  uint8_t *ptr = get_block(region_index, offset, count, width);
+  uio_mmio_copy(src, ptr, count, width);
+}
+
 namespace py = pybind11;
+
+// Bulk register I/O: a whole register range is moved in one call,
+// with the GIL released, instead of one Python call per register.
+static py::bytes uio_read_block(pyopae_uio &uio, uint32_t region_index,
+                                uint32_t offset, size_t count,
+                                unsigned width) {
+  uio.get_block(region_index, offset, count, width);
+  auto data = py::reinterpret_steal<py::bytes>(
+      PyBytes_FromStringAndSize(nullptr, count * (width / 8)));
+  if (!data) {
+    throw py::error_already_set();
+  }
+  char *dst = PyBytes_AS_STRING(data.ptr());
+  {
+    py::gil_scoped_release release;
+    uio.read_block(region_index, offset, dst, count, width);
+  }
+  return data;
+}
+
+static void uio_write_block(pyopae_uio &uio, uint32_t region_index,
+                            uint32_t offset, py::buffer data,
+                            unsigned width) {
+  py::buffer_info info = data.request();
+  size_t bytes = info.size * info.itemsize;
+  ssize_t stride = info.itemsize;
+
+  for (ssize_t i = info.ndim - 1; i >= 0; --i) {
+    if (info.strides[i] != stride) {
+      throw std::invalid_argument("data must be a contiguous buffer");
+    }
+    stride *= info.shape[i];
+  }
+  size_t count = uio_block_count(bytes, width);
+
+  py::gil_scoped_release release;
+  uio.write_block(region_index, offset, info.ptr, count, width);
+}
+
+static py::bytes uio_dump(pyopae_uio &uio, uint32_t region_index,
+                          uint32_t start, size_t size, unsigned width) {
+  size_t count =
+      uio_dump_count(uio.get_size(region_index), start, size, width);
+  return uio_read_block(uio, region_index, start, count, width);
+}
+
 PYBIND11_MODULE(pyopaeuio, m) {
   m.doc() = "pybind11 pyopaeuio plugin";
   py::class_<pyopae_uio>(m, "pyopaeuio")
       .def(py::init<>())
-      .def("open", (int(pyopae_uio::*)(const std::string &)) & pyopae_uio::open)
-      .def("close", (void(pyopae_uio::*)(void)) & pyopae_uio::close)
+      .def("open", (int(pyopae_uio::*)(const std::string &)) & pyopae_uio::open,
+           py::call_guard<py::gil_scoped_release>())
+      .def("close", (void(pyopae_uio::*)(void)) & pyopae_uio::close,
+           py::call_guard<py::gil_scoped_release>())
       .def("read8",
            (uint8_t(pyopae_uio::*)(uint32_t region_index, uint32_t offset)) &
                pyopae_uio::read8)
@@ -222,5 +298,24 @@ PYBIND11_MODULE(pyopaeuio, m) {
                pyopae_uio::write64)
       .def("getsize", (size_t(pyopae_uio::*)(uint32_t region_index)) &
                           pyopae_uio::get_size)
+      .def("read_block", &uio_read_block,
+           "Read count registers starting at offset, returned as bytes",
+           py::arg("region_index"), py::arg("offset"), py::arg("count"),
+           py::arg("width") = 64)
+      .def("write_block", &uio_write_block,
+           "Write the registers in data (any contiguous buffer) at offset",
+           py::arg("region_index"), py::arg("offset"), py::arg("data"),
+           py::arg("width") = 64)
+      .def("dump", &uio_dump,
+           "Read size bytes of registers at start (0 reads to the end)",
+           py::arg("region_index"), py::arg("start") = 0,
+           py::arg("size") = 0, py::arg("width") = 64)
+      .def("restore",
+           [](pyopae_uio &uio, uint32_t region_index, py::buffer data,
+              uint32_t start, unsigned width) {
+             uio_write_block(uio, region_index, start, data, width);
+           },
+           "Write back registers saved with dump", py::arg("region_index"),
+           py::arg("data"), py::arg("start") = 0, py::arg("width") = 64)
       .def_readonly("numregions", &pyopae_uio::num_regions);
 }
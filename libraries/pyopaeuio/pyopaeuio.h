@@ -33,6 +33,81 @@
 #include <iostream>
 #include <stdexcept>
 
+// bulk register access helpers
+
+inline void uio_check_width(unsigned width) {
+  if (width != 8 && width != 16 && width != 32 && width != 64) {
+    throw std::invalid_argument("access width must be 8, 16, 32 or 64");
+  }
+}
+
+// check that count registers of width bits at offset lie within
+// a region of size bytes mapped at base, and return their address
+inline uint8_t *uio_block(uint8_t *base, size_t size, uint32_t offset,
+                          size_t count, unsigned width) {
+  uio_check_width(width);
+  if (offset % (width / 8)) {
+    throw std::invalid_argument("offset is not aligned to the access width");
+  }
+  if (offset > size || count > (size - offset) / (width / 8)) {
+    throw std::out_of_range("block exceeds the uio region");
+  }
+  return base + offset;
+}
+
+// the number of width-bit registers held in bytes
+inline size_t uio_block_count(size_t bytes, unsigned width) {
+  uio_check_width(width);
+  if (bytes % (width / 8)) {
+    throw std::invalid_argument(
+        "data size is not a multiple of the access width");
+  }
+  return bytes / (width / 8);
+}
+
+// the number of registers to dump for size bytes at start, or for
+// the rest of a region of region_size bytes when size is 0
+inline size_t uio_dump_count(size_t region_size, uint32_t start, size_t size,
+                             unsigned width) {
+  if (start > region_size) {
+    throw std::out_of_range("start exceeds the uio region");
+  }
+  if (!size) {
+    size = region_size - start;
+  }
+  return uio_block_count(size, width);
+}
+
+// volatile keeps the compiler from merging or widening the accesses
+template <typename T>
+inline void uio_mmio_copy(volatile const void *src, volatile void *dst,
+                          size_t count) {
+  volatile const T *s = reinterpret_cast<volatile const T *>(src);
+  volatile T *d = reinterpret_cast<volatile T *>(dst);
+  for (size_t i = 0; i < count; ++i) {
+    d[i] = s[i];
+  }
+}
+
+// copy count registers, one access of width bits each
+inline void uio_mmio_copy(volatile const void *src, volatile void *dst,
+                          size_t count, unsigned width) {
+  switch (width) {
+    case 8:
+      uio_mmio_copy<uint8_t>(src, dst, count);
+      break;
+    case 16:
+      uio_mmio_copy<uint16_t>(src, dst, count);
+      break;
+    case 32:
+      uio_mmio_copy<uint32_t>(src, dst, count);
+      break;
+    default:
+      uio_mmio_copy<uint64_t>(src, dst, count);
+      break;
+  }
+}
+
 // opae uio python binding class
 class pyopae_uio {
  public:
@@ -52,6 +127,12 @@ class pyopae_uio {
   uint64_t write32(uint32_t region_index, uint32_t offset, uint32_t value);
   uint64_t write64(uint32_t region_index, uint32_t offset, uint64_t value);
   size_t get_size(uint32_t region_index);
+  void read_block(uint32_t region_index, uint32_t offset, void *dst,
+                  size_t count, unsigned width);
+  void write_block(uint32_t region_index, uint32_t offset, const void *src,
+                   size_t count, unsigned width);
+  uint8_t *get_block(uint32_t region_index, uint32_t offset, size_t count,
+                     unsigned width);
   uint32_t num_regions;
 
  private:
@@ -78,6 +78,17 @@ typedef union _{name} {{
 
 '''
 
+csr_access_macros = '''
+// Full-width register accesses made by the driver functions.
+// Define these before including this header to trace them.
+#ifndef OFS_CSR_READ
+#define OFS_CSR_READ(__reg) ((__reg)->value)
+#endif
+#ifndef OFS_CSR_WRITE
+#define OFS_CSR_WRITE(__reg, __value) ((__reg)->value = (__value))
+#endif
+'''
+
 driver_struct_templ = '''
 typedef struct _{driver} {{
   fpga_handle handle;
@@ -138,12 +149,24 @@ class ofs_field(object):
 
 
 class ofs_register(object):
-    def __init__(self, name, offset, default, description, fields=[]):
+    def __init__(self, name, offset, default, description, fields=[],
+                 attributes=()):
         self.name = name
         self.offset = offset
         self.default = default
         self.description = description
         self.fields = [ofs_field(*f) for f in fields]
+        self.attributes = set(attributes)
+
+    @property
+    def write_only(self):
+        # reads return the host-side copy instead of the device's value
+        return 'write_only' in self.attributes
+
+    @property
+    def shadow(self):
+        # writes start from the host-side copy instead of a read-back
+        return self.write_only or 'shadow' in self.attributes
 
     def __repr__(self):
         return (f'{self.name}, 0x{self.offset:0x}, 0x{self.default:0x}, '
@@ -152,7 +175,8 @@ class ofs_register(object):
     def to_structure(self, tmpl,  writer):
         for line in self.description.split('\n'):
             writer.writeline(f'// {line}')
-        writer.write(tmpl.lstrip().format(**vars(self)))
+        fields = declare_fields(self.pod, self.fields, 4)
+        writer.write(tmpl.lstrip().format(**dict(vars(self), fields=fields)))
 
 
 def write_temp(local_file: Path) -> Path:
@@ -186,6 +210,17 @@ def use_local_refs(schema):
     return schema
 
 
+def make_register(r):
+    # [name, offset, default, description(, attributes)], fields
+    name, offset, default, description = r[0][:4]
+    attributes = r[0][4] if len(r[0]) > 4 else ()
+    if isinstance(attributes, str):
+        attributes = [attributes]
+    return ofs_register(name, offset, default, description,
+                        fields=r[1] if len(r) > 1 else (),
+                        attributes=attributes)
+
+
 def parse(fp, schemafile=None, local_refs=False):
     data = yaml.load(fp, Loader=YamlLoader)
     if schemafile:
@@ -203,8 +238,7 @@ def parse(fp, schemafile=None, local_refs=False):
                 print(f'invalid/incomplete schema({fp.name}): {err}')
                 raise
     registers = data.get('registers')
-    data['registers'] = [ofs_register(*r[0], r[1] if len(r) > 1 else ())
-                         for r in registers]
+    data['registers'] = [make_register(r) for r in registers]
     return data
 
 
@@ -287,6 +321,7 @@ class ofs_driver_writer(object):
                 writer.writeline('#pragma once')
             writer.writeline('#include <opae/fpga.h>')
             writer.writeline('#include <ofs/ofs.h>')
+            writer.write(csr_access_macros)
 
             if language == 'c':
                 writer.writeline('\n#ifdef __cplusplus')
@@ -305,7 +340,6 @@ class ofs_driver_writer(object):
         for r in self.registers:
             r.width = 64 if max(r.fields, key=ofs_field.max).max() > 32 else 32
             r.pod = f'uint{r.width}_t'
-            r.fields = declare_fields(r.pod, r.fields, 4)
             r.to_structure(tmpl, fp)
 
     def get_body_text(self, body, lines):
@@ -338,6 +372,10 @@ class ofs_driver_writer(object):
             members.write(f'  volatile {r.name} *r_{r.name};\n')
             inits.write(f'  {var}->r_{r.name} =\n')
             inits.write(f'    (volatile {r.name}*)(ptr+{r.name}_OFFSET);\n')
+        for r in self.registers:
+            if r.shadow:
+                members.write(f'  {r.name} s_{r.name};\n')
+                inits.write(f'  {var}->s_{r.name}.value = 0x{r.default:x};\n')
         fp.write(
             driver_struct_templ.format(driver=self.name,
                                        var=var,
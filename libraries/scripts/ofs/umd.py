@@ -156,14 +156,48 @@ class scope_visitor(c_visitor):
     def visit_Expr(self, node):
         return self.visit(node.value)
 
+    def register(self, node):
+        """The register named by a Name or Attribute node, if any."""
+        if isinstance(node, ast.Attribute):
+            node = node.value
+        if isinstance(node, ast.Name):
+            for r in self.driver.registers:
+                if r.name == node.id:
+                    return r
+        return None
+
+    def is_pure(self, node):
+        """Whether evaluating node touches no register and calls nothing."""
+        for n in ast.walk(node):
+            if isinstance(n, ast.Call):
+                return False
+            if isinstance(n, ast.Name) and n.id in self.driver.reg_names:
+                return False
+        return True
+
+    def register_write(self, node, op=None):
+        target = node.targets[0] if isinstance(node, ast.Assign) else node.target
+        reg = self.register(target)
+        if reg is None:
+            return None
+        field = target.attr if isinstance(target, ast.Attribute) else 'value'
+        return c_reg_write(reg, field, self.visit(node.value),
+                           self.is_pure(node.value), op)
+
     def visit_Assign(self, node):
+        write = self.register_write(node)
+        if write:
+            return write
         lhs = self.visit(node.targets[0])
         rhs = self.visit(node.value)
         return c_code(f'{lhs} = {rhs}')
 
     def visit_AugAssign(self, node):
-        lhs = self.visit(node.target)
         op = self.visit(node.op)
+        write = self.register_write(node, op)
+        if write:
+            return write
+        lhs = self.visit(node.target)
         rhs = self.visit(node.value)
         return c_code(f'{lhs} {op}= {rhs}')
 
@@ -210,11 +244,15 @@ class scope_visitor(c_visitor):
         if node.value.id in self.driver.reg_names:
             # bitfields prefixed with f_ but value member isn't
             f_prefix = '' if node.attr == 'value' else 'f_'
+            if self.register(node).write_only:
+                return f'drv->s_{node.value.id}.{f_prefix}{node.attr}'
             return f'drv->r_{node.value.id}->{f_prefix}{node.attr}'
         return f'{node.value.id}.{node.attr}'
 
     def visit_Name(self, node):
         if node.id in self.driver.reg_names:
+            if self.register(node).write_only:
+                return f'drv->s_{node.id}.value'
             return f'drv->r_{node.id}->value'
         return node.id
 
@@ -244,6 +282,112 @@ class c_code(c_node):
         return self.code
 
 
+def preserved_fields(reg):
+    """The fields that a write must leave unchanged when not assigned."""
+    preserved = []
+    for f in reg.fields:
+        access = str(f.access).upper()
+        if access.startswith('RW') and access not in ('RW1C', 'RW1CS', 'RW1S'):
+            preserved.append(f)
+    return preserved
+
+
+class c_reg_write(c_node):
+    """Stores to one register, issued as a single full-width write.
+
+    Consecutive stores to distinct fields of the same register are
+    merged into one c_reg_write as long as their values don't depend
+    on the device. A store to a field already stored, or to the whole
+    register, starts a new write, so that pulses like
+    cfg.flags = 1; cfg.flags = 0 reach the device as two writes.
+    The new register value is composed in a local copy. It starts
+    from the host-side copy of shadow registers, from zero when all
+    preserved fields are assigned, and otherwise from one read.
+    """
+    def __init__(self, reg, field, rhs, pure=True, op=None):
+        self.reg = reg
+        self.pure = pure
+        self.stores = [(field, rhs, op)]
+
+    def merge(self, other):
+        if other.reg is not self.reg or not other.pure:
+            return False
+        fields = {field for field, _, _ in self.stores}
+        for field, _, _ in other.stores:
+            if field in fields or 'value' in fields or field == 'value':
+                return False
+            fields.add(field)
+        self.stores.extend(other.stores)
+        return True
+
+    def live_stores(self):
+        # a store to the whole register overrides the ones before it
+        stores = self.stores
+        for i, (field, _, op) in enumerate(self.stores):
+            if field == 'value' and op is None:
+                stores = self.stores[i:]
+        return stores
+
+    def needs_read(self):
+        stores = self.live_stores()
+        if self.reg.shadow or stores[0][::2] == ('value', None):
+            return False
+        assigned = set()
+        for field, _, op in stores:
+            if op is not None and field not in assigned:
+                return True
+            assigned.add(field)
+        return any(f.name not in assigned for f in preserved_fields(self.reg))
+
+    def field(self, name):
+        for f in self.reg.fields:
+            if f.name == name:
+                return f
+        raise SystemExit(f'{self.reg.name} has no field {name}')
+
+    def single_store(self):
+        field, rhs, op = self.stores[0]
+        if len(self.stores) > 1 or self.reg.shadow or op or field == 'value':
+            return None
+        if self.needs_read():
+            return None
+        f = self.field(field)
+        pod = getattr(self.reg, 'pod', 'uint64_t')
+        width = f.hi() - f.lo() + 1
+        value = f'({pod})({rhs})'
+        if width < int(pod[4:-2]):
+            value = f'({value} & 0x{(1 << width) - 1:x})'
+        if f.lo():
+            value = f'({value} << {f.lo()})'
+        return f'OFS_CSR_WRITE(drv->r_{self.reg.name}, {value})'
+
+    def write_lines(self):
+        single = self.single_store()
+        if single:
+            return [f'{single};']
+        name = self.reg.name
+        v = f'v_{name}'
+        stores = self.live_stores()
+        lines = ['{', f'\t{name} {v};']
+        if stores[0][::2] == ('value', None):
+            lines.append(f'\t{v}.value = {stores[0][1]};')
+            stores = stores[1:]
+        elif self.reg.shadow:
+            lines.append(f'\t{v}.value = drv->s_{name}.value;')
+        elif self.needs_read():
+            lines.append(f'\t{v}.value = OFS_CSR_READ(drv->r_{name});')
+        else:
+            lines.append(f'\t{v}.value = 0;')
+        for field, rhs, op in stores:
+            member = 'value' if field == 'value' else f'f_{field}'
+            lines.append(f'\t{v}.{member} {op or ""}= {rhs};')
+        if self.reg.shadow:
+            lines.append(f'\tdrv->s_{name}.value = {v}.value;')
+        lines.append(f'\tOFS_CSR_WRITE(drv->r_{name}, {v}.value);')
+        lines.append('}')
+        return lines
+
+
 class c_block(c_node):
     def __init__(self, node, driver, sv: scope_visitor = None):
         super().__init__(node)
@@ -252,6 +396,10 @@ class c_block(c_node):
         self.sv = sv
 
     def append(self, n):
+        if (isinstance(n, c_reg_write) and self.body and
+                isinstance(self.body[-1], c_reg_write) and
+                self.body[-1].merge(n)):
+            return
         self.body.append(n)
 
     def write_header(self):
@@ -264,6 +412,9 @@ class c_block(c_node):
                 writer.writeline(f'{spaces}{s.write_header()} {{')
                 s.write_body(writer, indent+1)
                 writer.writeline(f'{spaces}}}')
+            elif isinstance(s, c_reg_write):
+                for line in s.write_lines():
+                    writer.writeline(f'{spaces}{line}')
             else:
                 writer.writeline(f'{spaces}{s.write_code()};')
 
@@ -329,7 +480,7 @@ class c_func(c_block):
         for s in self.node.body:
             if isinstance(s, ast.Pass):
                 break
-            self.body.append(self.sv.visit(s))
+            self.append(self.sv.visit(s))
 
 
 class driver_writer(file_writer):
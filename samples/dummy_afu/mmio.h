@@ -32,31 +32,26 @@ namespace dummy_afu {
 template<typename T>
 inline void timeit_wr(std::shared_ptr<spdlog::logger> log, dummy_afu *afu, uint32_t count)
 {
-  using namespace std::chrono;
-  auto begin = high_resolution_clock::now();
-  for (uint32_t i = 0; i < count; ++i) {
-    afu->write<T>(SCRATCHPAD, i);
-  }
-  auto end = high_resolution_clock::now();
-  auto delta = duration_cast<nanoseconds>(end - begin).count();
   auto width = sizeof(T)*8;
-  log->debug("count: {0}, op: wr, width: {1}, mean: {2} nsec",
-             count, width, delta/count);
+  auto name = "mmio_wr" + std::to_string(width);
+  uint32_t i = 0;
+  auto &r = afu->bench().measure(name, count, [afu, &i]() {
+    afu->write<T>(SCRATCHPAD, i++);
+  }, sizeof(T));
+  log->debug("count: {0}, op: wr, width: {1}, mean: {2:0.1f} nsec, p50: {3:0.1f} nsec, p99: {4:0.1f} nsec",
+             count, width, r.mean, r.p50, r.p99);
 }
 
 template<typename T>
 inline void timeit_rd(std::shared_ptr<spdlog::logger> log, dummy_afu *afu, uint32_t count)
 {
-  using namespace std::chrono;
-  auto begin = high_resolution_clock::now();
-  for (uint32_t i = 0; i < count; ++i) {
-    afu->read<T>(SCRATCHPAD);
-  }
-  auto end = high_resolution_clock::now();
-  auto delta = duration_cast<nanoseconds>(end - begin).count();
   auto width = sizeof(T)*8;
-  log->debug("count: {0}, op: rd, width: {1}, mean: {2} nsec",
-             count, width, delta/count);
+  auto name = "mmio_rd" + std::to_string(width);
+  auto &r = afu->bench().measure(name, count, [afu]() {
+    afu->read<T>(SCRATCHPAD);
+  }, sizeof(T));
+  log->debug("count: {0}, op: rd, width: {1}, mean: {2:0.1f} nsec, p50: {3:0.1f} nsec, p99: {4:0.1f} nsec",
+             count, width, r.mean, r.p50, r.p99);
 }
 
 
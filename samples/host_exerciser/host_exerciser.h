@@ -418,6 +418,10 @@ public:
 
     app_.add_option("--clock-mhz", he_clock_mhz_,
         "Clock frequency (MHz) -- when zero, read the frequency from the AFU")->default_val("0");
+
+    app_.add_option("--perf-sample-us", he_perf_sample_us_,
+        "Sample the FME performance counters at this interval (microseconds) "
+        "while the test runs -- zero disables sampling")->default_val("0");
    }
 
   virtual int run(CLI::App *app, test_command::ptr_t test) override
@@ -481,13 +485,8 @@ public:
   void fill(shared_buffer::ptr_t buffer)
   {
     std::random_device rd;
-    std::mt19937 mt(rd());
-    std::uniform_int_distribution<uint32_t> dist(1, -1);
-    auto sz = sizeof(uint32_t);
-    for (uint32_t i = 0; i < buffer->size(); i+=sz){
-      buffer->write<uint32_t>(dist(mt), i);
-    }
-
+    uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    buffer->fill(shared_buffer::pattern::random, seed);
   }
 
   void fill(shared_buffer::ptr_t buffer, uint32_t value)
@@ -553,6 +552,7 @@ public:
   uint32_t he_interrupt_;
   uint32_t he_contmodetime_;
   uint32_t he_clock_mhz_;
+  uint32_t he_perf_sample_us_;
 
   std::map<uint32_t, uint32_t> limits_;
 
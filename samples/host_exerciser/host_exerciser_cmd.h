@@ -26,6 +26,7 @@
 #pragma once
 
 #include <unistd.h>
+#include <algorithm>
 
 #include "afu_test.h"
 #include "host_exerciser.h"
@@ -65,6 +66,7 @@ public:
           he_lpbk_api_ver_ = 0;
           he_lpbk_atomics_supported_ = false;
           is_ase_sim_ = false;
+          dsm_wait_ = { std::chrono::nanoseconds(0), 0, false };
     }
     virtual ~host_exerciser_cmd() {}
 
@@ -192,6 +194,86 @@ public:
             double perf_data = he_num_xfers_to_bw(num_cache_lines, dsm_num_ticks(dsm_status));
             host_exe_->logger_->info("Bandwidth: {0:0.3f} GB/s", perf_data);
         }
+
+        if (dsm_wait_.latency.count() > 0) {
+            host_exe_->logger_->info("Completion wait: {0:0.3f} us, {1} wakeups ({2})",
+                                     dsm_wait_.latency.count() / 1000.0,
+                                     dsm_wait_.wakeups,
+                                     dsm_wait_.umwait ? "umwait" : "poll");
+            dsm_wait_.latency = std::chrono::nanoseconds(0);
+        }
+    }
+
+    // Sample the FME performance counters while the test runs.
+    void he_perf_sampler_start()
+    {
+        if (!host_exe_->he_perf_sample_us_)
+            return;
+
+        if (!perf_sampler_) {
+            auto fme = host_exe_->token_device();
+            if (fme)
+                perf_sampler_ = fpga::perf_sampler::open(fme);
+            if (!perf_sampler_) {
+                host_exe_->logger_->warn("FME performance counters not available");
+                host_exe_->he_perf_sample_us_ = 0;
+                return;
+            }
+        }
+
+        perf_sampler_->drain();
+        perf_sampler_->sample_now();
+        perf_sampler_->start(std::chrono::microseconds(host_exe_->he_perf_sample_us_));
+    }
+
+    // Stop sampling and print the total and the peak rate of each
+    // counter that moved during the test.
+    void he_perf_sampler_report()
+    {
+        if (!perf_sampler_)
+            return;
+
+        if (!perf_sampler_->running()) {
+            auto err = perf_sampler_->error();
+            if (!err)
+                return;
+            try {
+                std::rethrow_exception(err);
+            } catch (std::exception &e) {
+                host_exe_->logger_->warn("FME performance counter sampling stopped: {0}",
+                                         e.what());
+            }
+            return;
+        }
+
+        perf_sampler_->stop();
+        perf_sampler_->sample_now();
+        auto samples = perf_sampler_->drain();
+        if (samples.size() < 2)
+            return;
+
+        auto &counters = perf_sampler_->counters();
+        std::vector<uint64_t> total(counters.size(), 0);
+        std::vector<double> peak(counters.size(), 0.0);
+
+        for (size_t i = 1; i < samples.size(); ++i) {
+            std::chrono::duration<double> dt = samples[i].time - samples[i-1].time;
+            for (size_t c = 0; c < counters.size(); ++c) {
+                total[c] += samples[i].deltas[c];
+                if (dt.count() > 0.0)
+                    peak[c] = std::max(peak[c], samples[i].deltas[c] / dt.count());
+            }
+        }
+
+        host_exe_->logger_->info("FME performance counters ({0} samples, {1} dropped):",
+                                 samples.size() - 1, perf_sampler_->dropped());
+        for (size_t c = 0; c < counters.size(); ++c) {
+            if (!total[c])
+                continue;
+            host_exe_->logger_->info("  {0}/{1}: {2} (peak {3:0.0f}/s)",
+                                     fpga::perf_sampler::group_name(counters[c].grp),
+                                     counters[c].name, total[c], peak[c]);
+        }
     }
 
     bool he_interrupt(event::ptr_t ev)
@@ -216,16 +298,12 @@ public:
             timeout *= 100;
         }
 
-        volatile uint8_t* status_ptr = dsm_->c_type();
-
-        while (0 == ((*status_ptr) & 0x1)) {
-            usleep(HELPBK_TEST_SLEEP_INVL);
-            if (--timeout == 0) {
-                std::cout << "HE LPBK TIME OUT" << std::endl;
-                host_exerciser_errors();
-                host_exerciser_status();
-                return false;
-            }
+        std::chrono::microseconds wait_time(timeout * HELPBK_TEST_SLEEP_INVL);
+        if (!dsm_->wait_for<uint8_t>(0, 0x1, 0x1, wait_time, &dsm_wait_)) {
+            std::cout << "HE LPBK TIME OUT" << std::endl;
+            host_exerciser_errors();
+            host_exerciser_status();
+            return false;
         }
         return true;
     }
@@ -310,8 +388,15 @@ public:
             // host memory bus some of the data is lost. The FPGA-side
             // drops the portion of each line that doesn't map 1:1 to
             // a local memory bank.
-            if (!is_he_mem_ || (he_lpbk_bus_bytes_ <= local_mem_bus_bytes_))
-                return (source_->compare(destination_, source_->size()));
+            if (!is_he_mem_ || (he_lpbk_bus_bytes_ <= local_mem_bus_bytes_)) {
+                auto r = source_->compare_detail(destination_, source_->size());
+                if (r.mismatches)
+                    std::cerr << "Buffer mismatch: " << r.mismatches
+                              << " byte(s) differ, first at offset 0x"
+                              << std::hex << r.first_mismatch << std::dec
+                              << std::endl;
+                return r.mismatches;
+            }
 
             // Resort to line-by-line comparison, ignoring the missing high
             // part of each line skipped by the trip through local memory.
@@ -545,6 +630,8 @@ public:
             std::cout << std::endl;
         }
 
+        he_perf_sampler_start();
+
         // Write to CSR_CTL
         he_lpbk_ctl_.value = 0;
         he_lpbk_ctl_.Start = 1;
@@ -600,6 +687,8 @@ public:
             }
         }
 
+        he_perf_sampler_report();
+
         // assert reset he-lpbk
         he_lpbk_ctl_.value = 0;
         host_exe_->write32(HE_CTL, he_lpbk_ctl_.value);
@@ -942,6 +1031,8 @@ protected:
     bool he_lpbk_atomics_supported_;
     bool is_he_mem_;
     bool is_ase_sim_;
+    opae::fpga::types::buffer_ops::wait_stats dsm_wait_;
+    opae::fpga::types::perf_sampler::ptr_t perf_sampler_;
 };
 
 } // end of namespace host_exerciser
@@ -200,10 +200,23 @@ public:
 
   void read_performance(perf_data *perf, hssi_afu *hafu) const
   {
-    perf->tx_count = data_64(hafu->mbox_read(CSR_STATS_TX_CNT_LO), hafu->mbox_read(CSR_STATS_TX_CNT_HI));
-    perf->rx_count = data_64(hafu->mbox_read(CSR_STATS_RX_CNT_LO), hafu->mbox_read(CSR_STATS_RX_CNT_HI));
-    perf->rx_good_packet_count = data_64(hafu->mbox_read(CSR_STATS_RX_GD_CNT_LO), hafu->mbox_read(CSR_STATS_RX_GD_CNT_HI));
-    perf->rx_pkt_sec = data_64(hafu->mbox_read(CSR_RX_END_TIMESTAMP_LO), hafu->mbox_read(CSR_RX_END_TIMESTAMP_HI));
+    // Read each counter low word first, in a single batch.
+    uint32_t v[8];
+    opae::afu_test::mbox_batch batch;
+    batch.read(CSR_STATS_TX_CNT_LO, &v[0])
+         .read(CSR_STATS_TX_CNT_HI, &v[1])
+         .read(CSR_STATS_RX_CNT_LO, &v[2])
+         .read(CSR_STATS_RX_CNT_HI, &v[3])
+         .read(CSR_STATS_RX_GD_CNT_LO, &v[4])
+         .read(CSR_STATS_RX_GD_CNT_HI, &v[5])
+         .read(CSR_RX_END_TIMESTAMP_LO, &v[6])
+         .read(CSR_RX_END_TIMESTAMP_HI, &v[7]);
+    hafu->mbox_execute(batch);
+
+    perf->tx_count = data_64(v[0], v[1]);
+    perf->rx_count = data_64(v[2], v[3]);
+    perf->rx_good_packet_count = data_64(v[4], v[5]);
+    perf->rx_pkt_sec = data_64(v[6], v[7]);
   }
 
   void calc_performance(perf_data *old_perf, perf_data *new_perf, perf_data *perf, uint64_t size) const
@@ -233,20 +246,19 @@ public:
     return 1;
   }
 
-  void write_ctrl_config(hssi_afu *hafu, ctrl_config config_data) const
+  void write_ctrl_config(opae::afu_test::mbox_batch &batch, ctrl_config config_data) const
   {
-    hafu->mbox_write(CSR_PKT_SIZE, config_data.pkt_size_data);
-    hafu->mbox_write(CSR_CTRL0, config_data.ctrl0_data);
-    hafu->mbox_write(CSR_CTRL1, config_data.ctrl1_data);
+    batch.write(CSR_PKT_SIZE, config_data.pkt_size_data)
+         .write(CSR_CTRL0, config_data.ctrl0_data)
+         .write(CSR_CTRL1, config_data.ctrl1_data);
   }
 
-  void write_csr_addr(hssi_afu *hafu, uint64_t bin_src_addr, uint64_t bin_dest_addr) const
+  void write_csr_addr(opae::afu_test::mbox_batch &batch, uint64_t bin_src_addr, uint64_t bin_dest_addr) const
   {
-    hafu->mbox_write(CSR_SRC_ADDR_LO, static_cast<uint32_t>(bin_src_addr));
-    hafu->mbox_write(CSR_SRC_ADDR_HI, static_cast<uint32_t>(bin_src_addr >> 32));
-
-    hafu->mbox_write(CSR_DST_ADDR_LO, static_cast<uint32_t>(bin_dest_addr));
-    hafu->mbox_write(CSR_DST_ADDR_HI, static_cast<uint32_t>(bin_dest_addr >> 32));
+    batch.write(CSR_SRC_ADDR_LO, static_cast<uint32_t>(bin_src_addr))
+         .write(CSR_SRC_ADDR_HI, static_cast<uint32_t>(bin_src_addr >> 32))
+         .write(CSR_DST_ADDR_LO, static_cast<uint32_t>(bin_dest_addr))
+         .write(CSR_DST_ADDR_HI, static_cast<uint32_t>(bin_dest_addr >> 32));
   }
 
   std::ostream & print_monitor_headers(std::ostream &os, uint32_t max_timer) const
@@ -291,9 +303,11 @@ public:
   void select_port(int port, ctrl_config config_data, hssi_afu *hafu) const
   {
     /* Selects the port before performing read/write to traffic controller reg space */
-    hafu->write64(TRAFFIC_CTRL_PORT_SEL, port);
-    write_ctrl_config(hafu, config_data);
-    write_csr_addr(hafu, mac_bits_for(src_addr_), mac_bits_for(dest_addr_));
+    opae::afu_test::mbox_batch batch;
+    batch.select(port);
+    write_ctrl_config(batch, config_data);
+    write_csr_addr(batch, mac_bits_for(src_addr_), mac_bits_for(dest_addr_));
+    hafu->mbox_execute(batch);
   }
 
   void capture_perf(perf_data *old_perf_data, hssi_afu *hafu) const
@@ -430,7 +444,7 @@ public:
     DFH dfh;
     dfh.csr = hafu->read64(ETH_AFU_DFH);
 
-    hafu->write64(TRAFFIC_CTRL_PORT_SEL, port_[0]);
+    hafu->mbox_select(port_[0]);
     hafu->mbox_write(CSR_CTRL1, STOP_BITS);
 
     uint32_t reg;
@@ -453,11 +467,9 @@ public:
     hafu->mbox_write(CSR_CTRL0, reg);
     config_data.ctrl0_data = reg;
 
-    hafu->mbox_write(CSR_SRC_ADDR_LO, static_cast<uint32_t>(bin_src_addr));
-    hafu->mbox_write(CSR_SRC_ADDR_HI, static_cast<uint32_t>(bin_src_addr >> 32));
-
-    hafu->mbox_write(CSR_DST_ADDR_LO, static_cast<uint32_t>(bin_dest_addr));
-    hafu->mbox_write(CSR_DST_ADDR_HI, static_cast<uint32_t>(bin_dest_addr >> 32));
+    opae::afu_test::mbox_batch addrs;
+    write_csr_addr(addrs, bin_src_addr, bin_dest_addr);
+    hafu->mbox_execute(addrs);
 
     reg = 0;
     if (dfh.major_rev < 2){
@@ -608,7 +620,7 @@ public:
     os << "0x1000 " << std::setw(22) << "scratch" << ": " <<
       int_to_hex(hafu->mbox_read(CSR_SCRATCH)) << std::endl;
     os << "0x1001 " << std::setw(22) << "block_ID" << ": " <<
-      int_to_hex(hafu->mbox_read(CSR_BLOCK_ID)) << std::endl;
+      int_to_hex(hafu->mbox_read_cached(CSR_BLOCK_ID)) << std::endl;
     os << "0x1008 " << std::setw(22) << "pkt_size" << ": " <<
       int_to_hex(hafu->mbox_read(CSR_PKT_SIZE)) << std::endl;
     os << "0x1009 " << std::setw(22) << "ctrl0" << ": " <<
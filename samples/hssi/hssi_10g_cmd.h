@@ -227,23 +227,21 @@ public:
 
     double clk_freq = clock_freq_for(hafu);
 
-    hafu->mbox_write(src_port_, CSR_NUM_PACKETS, num_packets_);
-
-    hafu->mbox_write(src_port_, CSR_PACKET_LENGTH, packet_length_);
-
-    hafu->mbox_write(src_port_, CSR_SRC_ADDR0, static_cast<uint32_t>(bin_src_addr));
-    hafu->mbox_write(src_port_, CSR_SRC_ADDR1, static_cast<uint32_t>(bin_src_addr >> 32));
-
-    hafu->mbox_write(src_port_, CSR_DEST_ADDR0, static_cast<uint32_t>(bin_dest_addr));
-    hafu->mbox_write(src_port_, CSR_DEST_ADDR1, static_cast<uint32_t>(bin_dest_addr >> 32));
-
-    hafu->mbox_write(src_port_, CSR_RANDOM_LENGTH, (random_length_ == "fixed") ? 0 : 1);
-    hafu->mbox_write(src_port_, CSR_RANDOM_PAYLOAD, (random_payload_ == "incremental") ? 0 : 1);
-    hafu->mbox_write(src_port_, CSR_RND_SEED0, rnd_seed0_);
-    hafu->mbox_write(src_port_, CSR_RND_SEED1, rnd_seed1_);
-    hafu->mbox_write(src_port_, CSR_RND_SEED2, rnd_seed2_);
-
-    hafu->mbox_write(src_port_, CSR_START, 1);
+    opae::afu_test::mbox_batch setup;
+    setup.select(src_port_)
+         .write(CSR_NUM_PACKETS, num_packets_)
+         .write(CSR_PACKET_LENGTH, packet_length_)
+         .write(CSR_SRC_ADDR0, static_cast<uint32_t>(bin_src_addr))
+         .write(CSR_SRC_ADDR1, static_cast<uint32_t>(bin_src_addr >> 32))
+         .write(CSR_DEST_ADDR0, static_cast<uint32_t>(bin_dest_addr))
+         .write(CSR_DEST_ADDR1, static_cast<uint32_t>(bin_dest_addr >> 32))
+         .write(CSR_RANDOM_LENGTH, (random_length_ == "fixed") ? 0 : 1)
+         .write(CSR_RANDOM_PAYLOAD, (random_payload_ == "incremental") ? 0 : 1)
+         .write(CSR_RND_SEED0, rnd_seed0_)
+         .write(CSR_RND_SEED1, rnd_seed1_)
+         .write(CSR_RND_SEED2, rnd_seed2_)
+         .write(CSR_START, 1);
+    hafu->mbox_execute(setup);
 
     print_registers(std::cout, hafu);
 
@@ -269,10 +267,15 @@ public:
     } else {
       std::cout << "HSSI performance: " << std::endl;
       // Read traffic control Tx/Rx timestamp registers
-      uint32_t tx_sta_tstamp = hafu->mbox_read(src_port_, CSR_TX_STA_TSTAMP);
-      uint32_t tx_end_tstamp = hafu->mbox_read(src_port_, CSR_TX_END_TSTAMP);
-      uint32_t rx_sta_tstamp = hafu->mbox_read(dst_port_, CSR_RX_STA_TSTAMP);
-      uint32_t rx_end_tstamp = hafu->mbox_read(dst_port_, CSR_RX_END_TSTAMP);
+      uint32_t tx_sta_tstamp, tx_end_tstamp, rx_sta_tstamp, rx_end_tstamp;
+      opae::afu_test::mbox_batch tstamps;
+      tstamps.select(src_port_)
+             .read(CSR_TX_STA_TSTAMP, &tx_sta_tstamp)
+             .read(CSR_TX_END_TSTAMP, &tx_end_tstamp)
+             .select(dst_port_)
+             .read(CSR_RX_STA_TSTAMP, &rx_sta_tstamp)
+             .read(CSR_RX_END_TSTAMP, &rx_end_tstamp);
+      hafu->mbox_execute(tstamps);
 
       // Convert timestamp register from clock cycles to nanoseconds
       double sample_period_ns = 1000 / clk_freq;
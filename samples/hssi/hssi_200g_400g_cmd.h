@@ -130,7 +130,7 @@ class hssi_200g_400g_cmd : public hssi_cmd {
       // Select the appropriate port on the Mailbox
       std::cout << "Setting traffic control/mailbox channel-select to " << i
                 << std::endl;
-      hafu->write64(TRAFFIC_CTRL_PORT_SEL, i);
+      hafu->mbox_select(i);
 
       // Set ROM start/end address.
       // The TG reads and transmits packet data from a 1024-word ROM. The ROM
@@ -187,9 +187,8 @@ class hssi_200g_400g_cmd : public hssi_cmd {
       uint64_t tx_sop_count = 0;
       const uint64_t interval = 100ULL;
       while (tx_sop_count < num_packets_) {
-        tx_sop_count =
-            ((uint64_t)hafu->mbox_read(CSR_STAT_TX_SOP_CNT_MSB) << 32) |
-            (uint64_t)hafu->mbox_read(CSR_STAT_TX_SOP_CNT_LSB);
+        tx_sop_count = read_counter(hafu, CSR_STAT_TX_SOP_CNT_MSB,
+                                    CSR_STAT_TX_SOP_CNT_LSB);
         if (!running()) {
           reg = 0x00;  // Stop the TG
           hafu->mbox_write(CSR_HW_PC_CTRL, reg);
@@ -217,12 +216,10 @@ class hssi_200g_400g_cmd : public hssi_cmd {
       double sample_period_ns = 1000 / USER_CLKFREQ_N6001;
       uint64_t timestamp_start, timestamp_end, timestamp_duration_cycles;
       double timestamp_duration_ns;
-      timestamp_start =
-          ((uint64_t)hafu->mbox_read(CSR_STAT_TIMESTAMP_TG_START_MSB) << 32) |
-          (uint64_t)hafu->mbox_read(CSR_STAT_TIMESTAMP_TG_START_LSB);
-      timestamp_end =
-          ((uint64_t)hafu->mbox_read(CSR_STAT_TIMESTAMP_TG_END_MSB) << 32) |
-          (uint64_t)hafu->mbox_read(CSR_STAT_TIMESTAMP_TG_END_LSB);
+      timestamp_start = read_counter(hafu, CSR_STAT_TIMESTAMP_TG_START_MSB,
+                                     CSR_STAT_TIMESTAMP_TG_START_LSB);
+      timestamp_end = read_counter(hafu, CSR_STAT_TIMESTAMP_TG_END_MSB,
+                                   CSR_STAT_TIMESTAMP_TG_END_LSB);
       assert(timestamp_end > timestamp_start);
       timestamp_duration_cycles = timestamp_end - timestamp_start;
       timestamp_duration_ns = timestamp_duration_cycles * sample_period_ns;
@@ -271,6 +268,15 @@ class hssi_200g_400g_cmd : public hssi_cmd {
     return "71f59769-ad60-49ed-b18a-51879087c674";
   }
 
+  // Read a 64-bit counter split across two mailbox registers, MSB first.
+  uint64_t read_counter(hssi_afu *hafu, uint16_t msb, uint16_t lsb) const {
+    uint32_t hi = 0, lo = 0;
+    opae::afu_test::mbox_batch batch;
+    batch.read(msb, &hi).read(lsb, &lo);
+    hafu->mbox_execute(batch);
+    return ((uint64_t)hi << 32) | lo;
+  }
+
   std::ostream &print_registers(std::ostream &os, hssi_afu *hafu) const {
     os << "Printing CSRs from base AFU region:" << std::endl;
 
@@ -29,8 +29,9 @@
 #include <sstream>
 #include <exception>
 #include <glob.h>
-#include <time.h>
+#include <memory>
 #include "afu_test.h"
+#include "afu_mbox.h"
 
 using test_afu =  opae::afu_test::afu;
 using namespace opae::fpga::types;
@@ -49,8 +50,6 @@ using namespace opae::fpga::types;
 #define AFU_CMD_SHIFT         32
 #define WRITE_DATA_SHIFT      32
 
-#define NO_TIMEOUT            0xffffffffffffffffULL
-
 class hssi_afu : public test_afu {
 public:
   hssi_afu()
@@ -117,125 +116,108 @@ public:
     return std::string("");
   }
 
+  // The traffic controller mailbox, created on first use (the handle
+  // isn't open until the command runs).
+  opae::afu_test::mailbox & mbox()
+  {
+    if (!mbox_) {
+      opae::afu_test::mbox_regs regs;
+      regs.cmd = TRAFFIC_CTRL_CMD;
+      regs.data = TRAFFIC_CTRL_DATA;
+      regs.select = TRAFFIC_CTRL_PORT_SEL;
+      regs.has_select = true;
+      regs.read_cmd = READ_CMD;
+      regs.write_cmd = WRITE_CMD;
+      regs.ack = ACK_TRANS;
+      regs.addr_shift = AFU_CMD_SHIFT;
+      regs.data_shift = WRITE_DATA_SHIFT;
+      mbox_.reset(new opae::afu_test::mailbox(handle_->mmio_ptr(0), regs));
+    }
+    return *mbox_;
+  }
+
+  void mbox_select(uint64_t port_select)
+  {
+    mbox().select(port_select);
+  }
+
   void mbox_write(uint64_t port_select, uint16_t offset, uint32_t data)
   {
-    write64(TRAFFIC_CTRL_PORT_SEL, port_select);
+    mbox_select(port_select);
     mbox_write(offset, data);
   }
 
   void mbox_write(uint16_t offset, uint32_t data)
   {
-    volatile uint8_t *mmio_base = handle_->mmio_ptr(0);
-
-    uint64_t val;
-    struct timespec ts;
-    uint64_t ticks;
-    const uint64_t max_ticks = 10000ULL;
-
-    val = (((uint64_t)data) << WRITE_DATA_SHIFT);
-    *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_DATA)) = val;
-
-    val = (((uint64_t)offset) << AFU_CMD_SHIFT) | WRITE_CMD;
-    *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD)) = val;
-
-    ticks = max_ticks;
-    ts.tv_sec = 0;
-    ts.tv_nsec = 100;
-    do
-    {
-        val = *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD));
-        if (val & ACK_TRANS)
-            break;
-        if (nanosleep(&ts, NULL) != -1 &&
-            ticks != NO_TIMEOUT) {
-            if (!ticks) {
-                const char *msg = "mbox_write timed out [a]";
-                std::cerr << msg << std::endl;
-                throw std::runtime_error(msg);
-            }
-            --ticks;
-        }
-    } while (!(val & ACK_TRANS));
-
-    ticks = max_ticks;
-    do
-    {
-        *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD)) = ACK_TRANS;
-        val = *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD));
-        if (!(val & ACK_TRANS))
-            break;
-        if (nanosleep(&ts, NULL) != -1 &&
-            ticks != NO_TIMEOUT) {
-            if (!ticks) {
-                const char *msg = "mbox_write timed out [b]";
-                std::cerr << msg << std::endl;
-                throw std::runtime_error(msg);
-            }
-            --ticks;
-        }
-    } while (val & ACK_TRANS); 
+    try {
+      mbox().write(offset, data);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      throw;
+    }
   }
 
   uint32_t mbox_read(uint64_t port_select, uint16_t offset)
   {
-    write64(TRAFFIC_CTRL_PORT_SEL, port_select);
+    mbox_select(port_select);
     return mbox_read(offset);
   }
 
   uint32_t mbox_read(uint16_t offset)
   {
-    volatile uint8_t *mmio_base = handle_->mmio_ptr(0);
-    uint32_t res = 0;
-
-    uint64_t val;
-    struct timespec ts;
-    uint64_t ticks;
-    const uint64_t max_ticks = 10000ULL;
-
-    val = (((uint64_t)offset) << AFU_CMD_SHIFT) | READ_CMD;
-    *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD)) = val;
-
-    ticks = max_ticks;
-    ts.tv_sec = 0;
-    ts.tv_nsec = 100;
-    do
-    {
-        val = *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD));
-        if (val & ACK_TRANS)
-            break;
-        if (nanosleep(&ts, NULL) != -1 &&
-            ticks != NO_TIMEOUT) {
-            if (!ticks) {
-                const char *msg = "mbox_read timed out [a]";
-                std::cerr << msg << std::endl;
-                throw std::runtime_error(msg);
-            }
-            --ticks;
-        }
-    } while (!(val & ACK_TRANS));
-
-    val = *(volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_DATA);
-    res = (uint32_t)val;
-
-    ticks = max_ticks;
-    do
-    {
-        *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD)) = ACK_TRANS;
-        val = *((volatile uint64_t *)(mmio_base + TRAFFIC_CTRL_CMD));
-        if (!(val & ACK_TRANS))
-            break;
-        if (nanosleep(&ts, NULL) != -1 &&
-            ticks != NO_TIMEOUT) {
-            if (!ticks) {
-                const char *msg = "mbox_read timed out [b]";
-                std::cerr << msg << std::endl;
-                throw std::runtime_error(msg);
-            }
-            --ticks;
-        }
-    } while (val & ACK_TRANS);
+    try {
+      return mbox().read(offset);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      throw;
+    }
+  }
 
+  // Read a register that doesn't change, e.g. an ID, at most once.
+  uint32_t mbox_read_cached(uint16_t offset)
+  {
+    try {
+      return mbox().read_cached(offset);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      throw;
+    }
+  }
+
+  // Run a queued sequence of mailbox accesses, e.g. a port setup.
+  void mbox_execute(opae::afu_test::mbox_batch &batch)
+  {
+    try {
+      uint64_t ns = mbox().execute(batch);
+      if (logger_)
+        logger_->debug("mailbox batch: {0} ops in {1} ns", batch.size(), ns);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      throw;
+    }
+  }
+
+  void log_mbox_stats()
+  {
+    if (!mbox_ || !logger_)
+      return;
+    const opae::afu_test::mbox_stats &st = mbox_->stats();
+    if (!st.ops())
+      return;
+    logger_->debug("mailbox: {0} reads ({1} cached), {2} writes, "
+                   "{3} selects, latency min/mean/max {4}/{5:.0f}/{6} ns, "
+                   "{7} polls, {8} sleeps",
+                   st.reads, st.cached_reads, st.writes, st.selects,
+                   st.min_ns, st.mean_ns(), st.max_ns, st.polls, st.sleeps);
+  }
+
+  virtual int run(CLI::App *app, opae::afu_test::command::ptr_t test) override
+  {
+    int res = test_afu::run(app, test);
+    log_mbox_stats();
     return res;
   }
 
+protected:
+  std::unique_ptr<opae::afu_test::mailbox> mbox_;
 };
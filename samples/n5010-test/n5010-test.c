@@ -24,7 +24,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
-// compile: gcc -DSTATIC=static -D_GNU_SOURCE -I /usr/src/opae/argsfilter /usr/src/opae/argsfilter/argsfilter.c n5010-test.c -o n5010-test -l opae-c -l uuid
+// compile: gcc -DSTATIC=static -D_GNU_SOURCE -I /usr/src/opae/argsfilter /usr/src/opae/argsfilter/argsfilter.c n5010-test.c -o n5010-test -l opae-c -l uuid -l json-c
 
 #include <stdio.h>
 #include <stdint.h>
@@ -37,6 +37,7 @@
 #include <opae/fpga.h>
 #include <uuid/uuid.h>
 #include <endian.h>
+#include <json-c/json.h>
 
 #include <argsfilter.h>
 
@@ -73,55 +74,153 @@
 
 #define ESRAM_TEST_CTRL    0x6008
 
-#define MAX_POLLS 10
+#define DDR_PRBS_PASS 0x39
+
+#define MAX_BANKS 64
+
+// Status registers are polled every POLL_MIN_NS at first. The
+// interval grows by a quarter, up to POLL_MAX_NS, while no bank
+// completes, which bounds the error of the per-bank elapsed time.
+#define POLL_MIN_NS 10000ULL
+#define POLL_MAX_NS 100000000ULL
+
+// Time allowed for the generators to go idle after a stop, and for
+// the eSRAM and QDR, and the much slower HBM and DDR, testers to
+// report a result. Banks still running then are marked timed out.
+#define READY_TIMEOUT_NS 1000000000ULL
+#define CHANNEL_TIMEOUT_NS 1000000000ULL
+#define MEM_TIMEOUT_NS 60000000000ULL
+
+// eSRAM and QDR report pass, fail and timeout bits for n channels in
+// three consecutive n-bit fields of one status register.
+#define CHAN_MASK(n)          ((1ULL << (n)) - 1)
+#define CHAN_PASS(h, n)       ((h) & CHAN_MASK(n))
+#define CHAN_FAIL(h, n)       (((h) >> (n)) & CHAN_MASK(n))
+#define CHAN_TIMEOUT(h, n)    (((h) >> 2 * (n)) & CHAN_MASK(n))
+
+#define JSON_VERSION 1
 
 struct n5010;
+struct n5010_mem;
 
 struct n5010_test {
 	const char *name;
-	fpga_result (*func)(struct n5010 *n5010);
+	// Check that the generators are idle and start all banks.
+	fpga_result (*start)(struct n5010 *n5010, struct n5010_mem *mem);
+	// Read the status registers and complete the banks that finished.
+	fpga_result (*poll)(struct n5010 *n5010, struct n5010_mem *mem);
+	uint64_t ctrl;       // control register, tests sharing it can't run together
+	uint64_t stat;       // status register (eSRAM, QDR)
+	uint64_t channels;   // number of channels (eSRAM, QDR)
+	uint64_t timeout_ns; // time allowed for all banks to report
 };
 
+enum bank_state {
+	BANK_RUNNING = 0,
+	BANK_PASS,
+	BANK_FAIL,
+	BANK_TIMEOUT,
+};
+
+struct n5010_bank {
+	enum bank_state state;
+	uint64_t elapsed_ns;
+};
+
+// A test in progress. All its banks are started at once.
+struct n5010_mem {
+	const struct n5010_test *test;
+	fpga_result res;
+	uint64_t num_banks;
+	uint64_t running;
+	uint64_t start_ns;
+	struct n5010_bank bank[MAX_BANKS];
+};
+
+#define NUM_TESTS 5
+
 struct n5010 {
 	fpga_token token;
 	fpga_handle handle;
 	fpga_guid guid;
 	fpga_properties filter;
 	uint64_t base;
-	const struct n5010_test *test;
+	struct n5010_mem mem[NUM_TESTS];
+	size_t num_mem;
+	uint64_t bytes;
 	bool debug;
+	bool json;
 	uint open_mode;
 };
 
-static fpga_result fpga_test_ddr_directed(struct n5010 *n5010);
-static fpga_result fpga_test_ddr_prbs(struct n5010 *n5010);
-static fpga_result fpga_test_hbm(struct n5010 *n5010);
-static fpga_result fpga_test_esram(struct n5010 *n5010);
-static fpga_result fpga_test_qdr(struct n5010 *n5010);
+static fpga_result fpga_start_ddr_directed(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_poll_ddr_directed(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_start_ddr_prbs(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_poll_ddr_prbs(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_start_hbm(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_poll_hbm(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_start_channels(struct n5010 *n5010, struct n5010_mem *mem);
+static fpga_result fpga_poll_channels(struct n5010 *n5010, struct n5010_mem *mem);
 
-static const struct n5010_test n5010_test[] = {
+static const struct n5010_test n5010_test[NUM_TESTS] = {
 	{
 		.name = "hbm",
-		.func = fpga_test_hbm,
+		.start = fpga_start_hbm,
+		.poll = fpga_poll_hbm,
+		.ctrl = HBM_TEST_CTRL,
+		.timeout_ns = MEM_TIMEOUT_NS,
 	},
 	{
 		.name = "ddr-directed",
-		.func = fpga_test_ddr_directed,
+		.start = fpga_start_ddr_directed,
+		.poll = fpga_poll_ddr_directed,
+		.ctrl = DDR_TEST_MODE0_CTRL,
+		.timeout_ns = MEM_TIMEOUT_NS,
 	},
 	{
 		.name = "ddr-prbs",
-		.func = fpga_test_ddr_prbs,
+		.start = fpga_start_ddr_prbs,
+		.poll = fpga_poll_ddr_prbs,
+		.ctrl = DDR_TEST_MODE1_CTRL,
+		.timeout_ns = MEM_TIMEOUT_NS,
 	},
 	{
 		.name = "esram",
-		.func = fpga_test_esram,
+		.start = fpga_start_channels,
+		.poll = fpga_poll_channels,
+		.ctrl = ESRAM_TEST_CTRL,
+		.stat = ESRAM_TEST_STAT,
+		.channels = 16,
+		.timeout_ns = CHANNEL_TIMEOUT_NS,
 	},
 	{
 		.name = "qdr",
-		.func = fpga_test_qdr,
+		.start = fpga_start_channels,
+		.poll = fpga_poll_channels,
+		.ctrl = QDR_TEST_CTRL,
+		.stat = QDR_TEST_STAT,
+		.channels = 8,
+		.timeout_ns = CHANNEL_TIMEOUT_NS,
 	}
 };
 
+// The tests run by --mode all. ddr-directed shares its registers
+// with ddr-prbs.
+static const char *const all_tests[] = { "hbm", "ddr-prbs", "esram", "qdr" };
+
+#define info(n5010, ...)                        \
+	do {                                    \
+		if (!(n5010)->json)             \
+			printf(__VA_ARGS__);    \
+	} while (0)
+
+#define debug(n5010, ...)                                                 \
+	do {                                                              \
+		if ((n5010)->debug)                                       \
+			fprintf((n5010)->json ? stderr : stdout,          \
+				__VA_ARGS__);                             \
+	} while (0)
+
 static fpga_result fpga_open(struct n5010 *n5010)
 {
 	fpga_result res;
@@ -267,7 +366,7 @@ static void fpga_dump(struct n5010 *n5010, uint64_t offset, size_t count)
 		uint64_t val;
 
 		fpgaReadMMIO64(n5010->handle, 0, reg, &val);
-		printf("reg: 0x%04jx, val: 0x%016jx\n", reg, val);
+		debug(n5010, "reg: 0x%04jx, val: 0x%016jx\n", reg, val);
 	}
 }
 
@@ -285,24 +384,39 @@ error:
 	return res;
 }
 
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+	struct timespec ts = {
+		.tv_sec = ns / 1000000000ULL,
+		.tv_nsec = ns % 1000000000ULL,
+	};
+
+	nanosleep(&ts, NULL);
+}
+
 static fpga_result fpga_start(struct n5010 *n5010, uint64_t offset, uint64_t num_banks)
 {
 	uint64_t ctrl;
 	fpga_result res = FPGA_OK;
 
 	ctrl = ((uint64_t)1 << num_banks) - 1;
-	printf("starting PRBS generators\n");
 
 	fpga_dump(n5010, offset, 1);
 
 	res = fpgaWriteMMIO64(n5010->handle, 0, n5010->base + offset, ctrl);
 	if (res != FPGA_OK) {
-		fprintf(stderr, "failed to start PRBS generators: %s\n", fpgaErrStr(res));
+		fprintf(stderr, "failed to start test generators: %s\n", fpgaErrStr(res));
 		goto error;
 	}
 
-	usleep(1000000);
-
 	fpga_dump(n5010, offset, 1);
 
 error:
@@ -314,60 +428,71 @@ static fpga_result fpga_stop(struct n5010 *n5010, uint64_t offset)
 	uint64_t ctrl = 0;
 	fpga_result res = FPGA_OK;
 
-	printf("stopping DDR test generators\n");
 	fpga_dump(n5010, offset, 1);
 
 	res = fpgaWriteMMIO64(n5010->handle, 0, n5010->base + offset, ctrl);
 	if (res != FPGA_OK) {
-		fprintf(stderr, "failed to stop DDR test generators: %s\n", fpgaErrStr(res));
+		fprintf(stderr, "failed to stop test generators: %s\n", fpgaErrStr(res));
 		goto error;
 	}
 
-	usleep(1000000);
-
 	fpga_dump(n5010, offset, 1);
 
 error:
 	return res;
 }
 
-static fpga_result fpga_wait(struct n5010 *n5010, uint64_t offset, uint64_t init, uint64_t result)
+// Wait for (register & mask) == value, as when the test generators
+// have gone idle after a stop. *status holds the last value read.
+static fpga_result fpga_ready(struct n5010 *n5010, uint64_t offset, uint64_t mask,
+			      uint64_t value, uint64_t *status)
 {
-	struct timespec ts = {.tv_sec = 0, .tv_nsec = 100000000};
-	uint64_t status = init;
+	uint64_t delay = POLL_MIN_NS;
+	uint64_t start = now_ns();
 	fpga_result res;
 
-	printf("waiting for test to complete...\n");
-
-	while (status == init) {
-		nanosleep(&ts, NULL);
-
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + offset, &status);
+	while (1) {
+		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + offset, status);
 		if (res != FPGA_OK) {
 			fprintf(stderr, "failed to read status: %s\n", fpgaErrStr(res));
-			goto error;
+			return res;
 		}
 
-		if (n5010->debug)
-			printf("reg: 0x%04jx (DDR status), val: 0x%016jx\n", offset, status);
-	}
+		if ((*status & mask) == value)
+			return FPGA_OK;
 
-	if (status != result) {
-		fprintf(stderr, "failed with unexpected result: expected: 0x%016jx, got: 0x%016jx\n", result, status);
-		res = FPGA_EXCEPTION;
-		goto error;
+		if (now_ns() - start > READY_TIMEOUT_NS)
+			return FPGA_BUSY;
+
+		sleep_ns(delay);
+		if (delay < POLL_MAX_NS)
+			delay += delay / 4;
 	}
+}
 
-error:
-	return res;
+static void bank_done(struct n5010_mem *mem, uint64_t bank, enum bank_state state, uint64_t now)
+{
+	if (mem->bank[bank].state != BANK_RUNNING)
+		return;
+
+	mem->bank[bank].state = state;
+	mem->bank[bank].elapsed_ns = now - mem->start_ns;
+	mem->running--;
 }
 
-static fpga_result fpga_test_ddr_prbs(struct n5010 *n5010)
+static void mem_started(struct n5010_mem *mem, uint64_t num_banks)
+{
+	mem->num_banks = num_banks;
+	mem->running = num_banks;
+	mem->start_ns = now_ns();
+}
+
+static fpga_result fpga_start_ddr_prbs(struct n5010 *n5010, struct n5010_mem *mem)
 {
 	uint64_t num_banks, stat, i;
 	fpga_result res;
 
-	printf("starting DDR PRBS read/write test\n");
+	info(n5010, "starting DDR PRBS read/write test\n");
 
 	fpga_dump(n5010, DDR_TEST_MODE1_CTRL, 6);
 
@@ -376,24 +501,26 @@ static fpga_result fpga_test_ddr_prbs(struct n5010 *n5010)
 	if (res != FPGA_OK)
 		goto error;
 
+	if (num_banks > MAX_BANKS) {
+		fprintf(stderr, "Error: unexpected number of DDR banks: %ju\n", num_banks);
+		res = FPGA_EXCEPTION;
+		goto error;
+	}
+
 	// Clear PRBS start bits
 	res = fpga_stop(n5010, DDR_TEST_MODE1_CTRL);
 	if (res != FPGA_OK)
 		goto error;
 
-	// Expect DDR_TEST_MODE1_BANK_STAT(bank) to return 0 while PRBS not running
+	// Expect DDR_TEST_MODE1_BANK_STAT(bank) to return 0 once PRBS is idle
 	for (i = 0; i < num_banks; i++) {
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + DDR_TEST_MODE1_BANK_STAT(i), &stat);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read DDR_TEST_MODE1_BANK_STAT(%ju): %s\n", i, fpgaErrStr(res));
-			goto error;
-		}
-
-		if (stat != 0x0) {
+		res = fpga_ready(n5010, DDR_TEST_MODE1_BANK_STAT(i), ~0ULL, 0x0, &stat);
+		if (res == FPGA_BUSY) {
 			fprintf(stderr, "Error: PRBS stat non-zero while generator idle: 0x%016jx\n", stat);
 			res = FPGA_EXCEPTION;
-			goto error;
 		}
+		if (res != FPGA_OK)
+			goto error;
 	}
 
 	// Set PRBS start bits for each bank
@@ -401,23 +528,51 @@ static fpga_result fpga_test_ddr_prbs(struct n5010 *n5010)
 	if (res != FPGA_OK)
 		goto error;
 
-	// Wait for PRBS pass
-	for (i = 0; i < num_banks; i++) {
-		res = fpga_wait(n5010, DDR_TEST_MODE1_BANK_STAT(i), 0, 0x39);
-		if (res != FPGA_OK)
-			goto error;
-	}
+	mem_started(mem, num_banks);
 
 error:
 	return res;
 }
 
-static fpga_result fpga_test_ddr_directed(struct n5010 *n5010)
+static fpga_result fpga_poll_ddr_prbs(struct n5010 *n5010, struct n5010_mem *mem)
+{
+	uint64_t stat, i, now;
+	fpga_result res = FPGA_OK;
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (mem->bank[i].state != BANK_RUNNING)
+			continue;
+
+		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + DDR_TEST_MODE1_BANK_STAT(i), &stat);
+		if (res != FPGA_OK) {
+			fprintf(stderr, "failed to read DDR_TEST_MODE1_BANK_STAT(%ju): %s\n", i, fpgaErrStr(res));
+			break;
+		}
+		now = now_ns();
+
+		debug(n5010, "reg: 0x%04jx (DDR status), val: 0x%016jx\n", DDR_TEST_MODE1_BANK_STAT(i), stat);
+
+		if (stat == 0x0)
+			continue;
+
+		if (stat == DDR_PRBS_PASS) {
+			bank_done(mem, i, BANK_PASS, now);
+		} else {
+			fprintf(stderr, "bank %ju failed with unexpected result: expected: 0x%016jx, got: 0x%016jx\n",
+				i, (uint64_t)DDR_PRBS_PASS, stat);
+			bank_done(mem, i, BANK_FAIL, now);
+		}
+	}
+
+	return res;
+}
+
+static fpga_result fpga_start_ddr_directed(struct n5010 *n5010, struct n5010_mem *mem)
 {
 	uint64_t num_banks, stat;
 	fpga_result res;
 
-	printf("starting DDR directed read/write test\n");
+	info(n5010, "starting DDR directed read/write test\n");
 
 	fpga_dump(n5010, DDR_TEST_MODE0_CTRL, 4);
 
@@ -425,267 +580,418 @@ static fpga_result fpga_test_ddr_directed(struct n5010 *n5010)
 	res = fpga_banks(n5010, DDR_TEST_MODE0_STAT, &num_banks);
 	if (res != FPGA_OK)
 		goto error;
+	num_banks &= 0xFF;
+
+	if (num_banks > 8) {
+		fprintf(stderr, "Error: unexpected number of DDR banks: %ju\n", num_banks);
+		res = FPGA_EXCEPTION;
+		goto error;
+	}
 
 	// Clear test generator start bits
 	res = fpga_stop(n5010, DDR_TEST_MODE0_CTRL);
 	if (res != FPGA_OK)
 		goto error;
 
-	// Expect error status to return 0 while test generator is not running
-	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + DDR_TEST_MODE0_STAT, &stat);
-	if (res != FPGA_OK) {
-		fprintf(stderr, "Error: failed to read DDR_TEST_MODE0_STAT: %s\n", fpgaErrStr(res));
-		goto error;
-	}
-	// Check test error bits [23:16]
-	if ((stat & 0xFF0000) != 0x0) {
-		fprintf(stderr, "Error: test generator error status non-zero while generator idle: 0x%016jx\n", stat);
+	// Expect error and done status to return 0 once the test generator is idle
+	res = fpga_ready(n5010, DDR_TEST_MODE0_STAT, 0xFFFF00, 0x0, &stat);
+	if (res == FPGA_BUSY) {
+		fprintf(stderr, "Error: test generator status non-zero while generator idle: 0x%016jx\n", stat);
 		res = FPGA_EXCEPTION;
-		goto error;
 	}
+	if (res != FPGA_OK)
+		goto error;
 
 	// Set start bits for each bank
 	res = fpga_start(n5010, DDR_TEST_MODE0_CTRL, num_banks);
 	if (res != FPGA_OK)
 		goto error;
 
-	// Wait for test generator pass bits to indicate done for all banks:
-	// DDR_TEST_MODE0_STAT[23:16] : test error = 0x0
-	// DDR_TEST_MODE0_STAT[15:8]  : test done  = (1 << num_banks)-1
-	// DDR_TEST_MODE0_STAT[7:0]   : # banks    = num_banks
-	res = fpga_wait(n5010, DDR_TEST_MODE0_STAT, num_banks, (((1 << num_banks)-1) << 8) + num_banks);
-	if (res != FPGA_OK)
-		goto error;
+	mem_started(mem, num_banks);
+
+error:
+	return res;
+}
+
+static fpga_result fpga_poll_ddr_directed(struct n5010 *n5010, struct n5010_mem *mem)
+{
+	uint64_t stat, done, errors, i, now;
+	fpga_result res;
 
-	// Check for reported errors (DDR_TEST_MODE0_STAT[23:16])
 	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + DDR_TEST_MODE0_STAT, &stat);
 	if (res != FPGA_OK) {
 		fprintf(stderr, "Error: failed to read DDR_TEST_MODE0_STAT: %s\n", fpgaErrStr(res));
-		goto error;
+		return res;
 	}
-	if ((stat & 0xFF0000) != 0x0) {
-		fprintf(stderr, "Error: Test failed with the following status: 0x%016jx\n", stat);
-		res = FPGA_EXCEPTION;
-		goto error;
+	now = now_ns();
+
+	debug(n5010, "reg: 0x%04x (DDR status), val: 0x%016jx\n", DDR_TEST_MODE0_STAT, stat);
+
+	// DDR_TEST_MODE0_STAT[23:16] : test error, per bank
+	// DDR_TEST_MODE0_STAT[15:8]  : test done, per bank
+	// DDR_TEST_MODE0_STAT[7:0]   : # banks
+	errors = (stat >> 16) & 0xFF;
+	done = (stat >> 8) & 0xFF;
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (errors & (1ULL << i))
+			bank_done(mem, i, BANK_FAIL, now);
+		else if (done & (1ULL << i))
+			bank_done(mem, i, BANK_PASS, now);
 	}
 
-error:
-	return res;
+	if (errors && !mem->running)
+		fprintf(stderr, "Error: Test failed with the following status: 0x%016jx\n", stat);
+
+	return FPGA_OK;
 }
 
-static fpga_result fpga_test_esram(struct n5010 *n5010)
+static fpga_result fpga_start_hbm(struct n5010 *n5010, struct n5010_mem *mem)
 {
-	struct timespec ts = {.tv_sec = 0, .tv_nsec = 100000000};
-	uint64_t stat = 0;
-	uint16_t pass = 0;
-	uint16_t fail = 0;
-	uint16_t timeout = 0;
-	fpga_result res ;
-	uint32_t polls = 0;
-
-	printf("starting eSRAM read/write test\n");
-
-	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + ESRAM_TEST_STAT, &stat);
-	if (res != FPGA_OK || stat != 0) {
-		fprintf(stderr, "FPGA not ready for test, status: 0x%016jx\n", stat);
-		if (res == FPGA_OK)
-			res = FPGA_EXCEPTION;
-		goto error;
-	}
+	fpga_result res;
 
-	res = fpgaWriteMMIO64(n5010->handle, 0, n5010->base + ESRAM_TEST_CTRL, 1);
-	if (res != FPGA_OK) {
-		fprintf(stderr, "failed to start test: %s\n", fpgaErrStr(res));
-		goto error;
-	}
-	printf("waiting for test to complete...\n");
+	info(n5010, "starting HBM read/write test\n");
 
-	do {
-		++polls;
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + ESRAM_TEST_STAT, &stat);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read stat: %s\n", fpgaErrStr(res));
-			goto error;
-		}
-		pass	= ESRAM_TEST_PASS(stat);
-		fail	= ESRAM_TEST_FAIL(stat);
-		timeout = ESRAM_TEST_TIMEOUT(stat);
+	res = fpga_start(n5010, HBM_TEST_CTRL, 32);
+	if (res != FPGA_OK)
+		return res;
 
+	mem_started(mem, 32);
 
-		if (n5010->debug) {
-			printf("pass (16x eSRAM channels)   : 0x%04x\n", pass);
-			printf("fail (16x eSRAM channels)   : 0x%04x\n", fail);
-			printf("timeout (16x eSRAM channels): 0x%04x\n", timeout);
-		}
-		nanosleep(&ts, NULL);
+	return FPGA_OK;
+}
 
-	} while (((pass | fail | timeout) != ESRAM_FM) && polls < MAX_POLLS);
+static fpga_result fpga_poll_hbm(struct n5010 *n5010, struct n5010_mem *mem)
+{
+	uint64_t pass = 0;
+	uint64_t fail = 0;
+	uint64_t timeout = 0;
+	uint64_t i, now;
+	fpga_result res;
 
-	if (polls == MAX_POLLS) {
-		fprintf(stderr, "Error: Test failed FPGA not returning result within time\n");
-		res = FPGA_EXCEPTION;
+	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_PASS, &pass);
+	if (res != FPGA_OK) {
+		fprintf(stderr, "failed to read pass: %s\n", fpgaErrStr(res));
+		return res;
 	}
 
-	if (fail != 0x0) {
-		fprintf(stderr, "Error: Test failed on the following channels: 0x%04x\n", fail);
-		res = FPGA_EXCEPTION;
+	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_FAIL, &fail);
+	if (res != FPGA_OK) {
+		fprintf(stderr, "failed to read fail: %s\n", fpgaErrStr(res));
+		return res;
 	}
 
-	if (timeout != 0x0) {
-		fprintf(stderr, "Error: Test timed out on the following channels: 0x%04x\n", timeout);
-		res = FPGA_EXCEPTION;
+	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_TIMEOUT, &timeout);
+	if (res != FPGA_OK) {
+		fprintf(stderr, "failed to read timeout: %s\n", fpgaErrStr(res));
+		return res;
 	}
-
-	if (pass != ESRAM_FM) {
-		fprintf(stderr, "Error: Test did not pass on all channels: 0x%04x\n", pass);
-		res = FPGA_EXCEPTION;
+	now = now_ns();
+
+	debug(n5010, "reg: 0x%04x (32x HBM channels, pass),    val: 0x%016jx\n", HBM_TEST_PASS, pass);
+	debug(n5010, "reg: 0x%04x (32x HBM channels, fail),    val: 0x%016jx\n", HBM_TEST_FAIL, fail);
+	debug(n5010, "reg: 0x%04x (32x HBM channels, timeout), val: 0x%016jx\n", HBM_TEST_TIMEOUT, timeout);
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (fail & (1ULL << i))
+			bank_done(mem, i, BANK_FAIL, now);
+		else if (timeout & (1ULL << i))
+			bank_done(mem, i, BANK_TIMEOUT, now);
+		else if (pass & (1ULL << i))
+			bank_done(mem, i, BANK_PASS, now);
 	}
 
-	if (res != FPGA_OK)
-		goto error;
-
-error:
-	return res;
+	return FPGA_OK;
 }
 
-static fpga_result fpga_test_qdr(struct n5010 *n5010)
+// eSRAM and QDR
+static fpga_result fpga_start_channels(struct n5010 *n5010, struct n5010_mem *mem)
 {
-	struct timespec ts = {.tv_sec = 0, .tv_nsec = 100000000};
+	const struct n5010_test *t = mem->test;
 	uint64_t stat = 0;
-	uint8_t  pass = 0;
-	uint8_t  fail = 0;
-	uint8_t timeout = 0;
 	fpga_result res;
-	uint32_t polls = 0;
 
-	printf("starting QDR read/write test\n");
+	info(n5010, "starting %s read/write test\n", t->name);
 
-	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + QDR_TEST_STAT, &stat);
+	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + t->stat, &stat);
 	if (res != FPGA_OK || stat != 0) {
-		fprintf(stderr, "FPGA not ready for test, status: 0x%016jx\n", stat);
+		fprintf(stderr, "FPGA not ready for %s test, status: 0x%016jx\n", t->name, stat);
 		if (res == FPGA_OK)
 			res = FPGA_EXCEPTION;
-		goto error;
+		return res;
 	}
 
-	res = fpgaWriteMMIO64(n5010->handle, 0, n5010->base + QDR_TEST_CTRL, 1);
+	res = fpgaWriteMMIO64(n5010->handle, 0, n5010->base + t->ctrl, 1);
 	if (res != FPGA_OK) {
-		fprintf(stderr, "failed to start test: %s\n", fpgaErrStr(res));
-		goto error;
+		fprintf(stderr, "failed to start %s test: %s\n", t->name, fpgaErrStr(res));
+		return res;
 	}
-	printf("waiting for test to complete...\n");
 
-	do {
-		++polls;
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + QDR_TEST_STAT, &stat);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read stat: %s\n", fpgaErrStr(res));
-			goto error;
-		}
-		pass	= QDR_TEST_PASS(stat);
-		fail	= QDR_TEST_FAIL(stat);
-		timeout = QDR_TEST_TIMEOUT(stat);
+	mem_started(mem, t->channels);
 
+	return FPGA_OK;
+}
 
-		if (n5010->debug) {
-			printf("pass (8x QDR channels)   : 0x%02x\n", pass);
-			printf("fail (8x QDR channels)   : 0x%02x\n", fail);
-			printf("timeout (8x QDR channels): 0x%02x\n", timeout);
-		}
-		nanosleep(&ts, NULL);
+static fpga_result fpga_poll_channels(struct n5010 *n5010, struct n5010_mem *mem)
+{
+	const struct n5010_test *t = mem->test;
+	uint64_t stat, pass, fail, timeout, i, now;
+	fpga_result res;
 
-	} while (((pass | fail | timeout) != QDR_FM) && polls < MAX_POLLS);
+	res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + t->stat, &stat);
+	if (res != FPGA_OK) {
+		fprintf(stderr, "failed to read stat: %s\n", fpgaErrStr(res));
+		return res;
+	}
+	now = now_ns();
+
+	pass = CHAN_PASS(stat, t->channels);
+	fail = CHAN_FAIL(stat, t->channels);
+	timeout = CHAN_TIMEOUT(stat, t->channels);
+
+	debug(n5010, "pass (%jux %s channels)   : 0x%04jx\n", t->channels, t->name, pass);
+	debug(n5010, "fail (%jux %s channels)   : 0x%04jx\n", t->channels, t->name, fail);
+	debug(n5010, "timeout (%jux %s channels): 0x%04jx\n", t->channels, t->name, timeout);
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (fail & (1ULL << i))
+			bank_done(mem, i, BANK_FAIL, now);
+		else if (timeout & (1ULL << i))
+			bank_done(mem, i, BANK_TIMEOUT, now);
+		else if (pass & (1ULL << i))
+			bank_done(mem, i, BANK_PASS, now);
+	}
 
-	if (polls == MAX_POLLS) {
-		fprintf(stderr, "Error: Test failed FPGA not returning result within time\n");
-		res = FPGA_EXCEPTION;
+	return FPGA_OK;
+}
+
+// Start every selected test, then poll all of them together until
+// each bank has completed.
+static fpga_result fpga_run(struct n5010 *n5010)
+{
+	uint64_t delay = POLL_MIN_NS;
+	uint64_t running = 0;
+	fpga_result res = FPGA_OK;
+	size_t i;
+
+	for (i = 0; i < n5010->num_mem; i++) {
+		struct n5010_mem *mem = &n5010->mem[i];
+
+		mem->res = mem->test->start(n5010, mem);
+		if (mem->res != FPGA_OK)
+			res = mem->res;
+		running += mem->running;
 	}
 
-	if (fail != 0x0) {
-		fprintf(stderr, "Error: Test failed on the following channels: 0x%02x\n", fail);
-		res = FPGA_EXCEPTION;
+	info(n5010, "waiting for test to complete...\n");
+
+	while (running) {
+		uint64_t before = running;
+
+		sleep_ns(delay);
+
+		running = 0;
+		for (i = 0; i < n5010->num_mem; i++) {
+			struct n5010_mem *mem = &n5010->mem[i];
+			uint64_t b, now;
+
+			if (!mem->running)
+				continue;
+
+			mem->res = mem->test->poll(n5010, mem);
+			if (mem->res != FPGA_OK) {
+				res = mem->res;
+				mem->running = 0;
+				continue;
+			}
+
+			now = now_ns();
+			if (mem->running &&
+			    now - mem->start_ns > mem->test->timeout_ns) {
+				fprintf(stderr, "Error: %s test failed FPGA not returning result within time\n",
+					mem->test->name);
+				for (b = 0; b < mem->num_banks; b++)
+					bank_done(mem, b, BANK_TIMEOUT, now);
+			}
+
+			running += mem->running;
+		}
+
+		if (running < before)
+			delay = POLL_MIN_NS;
+		else if (delay < POLL_MAX_NS)
+			delay += delay / 4;
 	}
 
-	if (timeout != 0x0) {
-		fprintf(stderr, "Error: Test timed out on the following channels: 0x%02x\n", timeout);
-		res = FPGA_EXCEPTION;
+	return res;
+}
+
+static const char *bank_state_str(enum bank_state state)
+{
+	switch (state) {
+	case BANK_PASS:
+		return "pass";
+	case BANK_FAIL:
+		return "fail";
+	case BANK_TIMEOUT:
+		return "timeout";
+	default:
+		return "incomplete";
 	}
+}
 
-	if (pass != QDR_FM) {
-		fprintf(stderr, "Error: Test did not pass on all channels: 0x%02x\n", pass);
-		res = FPGA_EXCEPTION;
+static bool mem_passed(const struct n5010_mem *mem)
+{
+	uint64_t i;
+
+	if (mem->res != FPGA_OK || mem->num_banks == 0)
+		return false;
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (mem->bank[i].state != BANK_PASS)
+			return false;
 	}
 
-	if (res != FPGA_OK)
-		goto error;
+	return true;
+}
 
-error:
-	return res;
+static uint64_t mem_elapsed_ns(const struct n5010_mem *mem)
+{
+	uint64_t i, elapsed = 0;
+
+	for (i = 0; i < mem->num_banks; i++) {
+		if (mem->bank[i].elapsed_ns > elapsed)
+			elapsed = mem->bank[i].elapsed_ns;
+	}
+
+	return elapsed;
 }
 
-static fpga_result fpga_test_hbm(struct n5010 *n5010)
+// MB/s, or 0 when the number of bytes per bank isn't known.
+static double bank_bandwidth(const struct n5010 *n5010, const struct n5010_bank *bank)
 {
-	struct timespec ts = {.tv_sec = 0, .tv_nsec = 100000000};
-	uint64_t pass = 0;
-	uint64_t fail = 0;
-	uint64_t timeout = 0;
-	fpga_result res;
+	if (!n5010->bytes || !bank->elapsed_ns || bank->state != BANK_PASS)
+		return 0.0;
 
-	printf("starting HBM read/write test\n");
+	return (double)n5010->bytes * 1000.0 / (double)bank->elapsed_ns;
+}
 
-	res = fpga_start(n5010, HBM_TEST_CTRL, 32);
-	if (res != FPGA_OK)
-		goto error;
+static void report_text(struct n5010 *n5010)
+{
+	size_t i;
+	uint64_t b;
 
-	printf("waiting for test to complete...\n");
+	for (i = 0; i < n5010->num_mem; i++) {
+		const struct n5010_mem *mem = &n5010->mem[i];
 
-	while (pass == 0 && fail == 0 && timeout == 0) {
-		nanosleep(&ts, NULL);
+		for (b = 0; b < mem->num_banks; b++) {
+			const struct n5010_bank *bank = &mem->bank[b];
+			double bw = bank_bandwidth(n5010, bank);
 
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_PASS, &pass);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read pass: %s\n", fpgaErrStr(res));
-			goto error;
+			printf("%s bank %ju: %s, %.3f ms", mem->test->name, b,
+			       bank_state_str(bank->state), bank->elapsed_ns / 1e6);
+			if (bw > 0.0)
+				printf(", %.1f MB/s", bw);
+			printf("\n");
 		}
 
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_FAIL, &fail);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read fail: %s\n", fpgaErrStr(res));
-			goto error;
+		printf("%s: %s, %.3f ms\n", mem->test->name,
+		       mem_passed(mem) ? "passed" : "failed", mem_elapsed_ns(mem) / 1e6);
+	}
+}
+
+static void report_json(struct n5010 *n5010)
+{
+	json_object *root = json_object_new_object();
+	json_object *tests = json_object_new_array();
+	bool passed = true;
+	size_t i;
+	uint64_t b;
+
+	for (i = 0; i < n5010->num_mem; i++) {
+		const struct n5010_mem *mem = &n5010->mem[i];
+		json_object *jtest = json_object_new_object();
+		json_object *banks = json_object_new_array();
+
+		for (b = 0; b < mem->num_banks; b++) {
+			const struct n5010_bank *bank = &mem->bank[b];
+			json_object *jbank = json_object_new_object();
+			double bw = bank_bandwidth(n5010, bank);
+
+			json_object_object_add(jbank, "bank", json_object_new_int64(b));
+			json_object_object_add(jbank, "result",
+					       json_object_new_string(bank_state_str(bank->state)));
+			json_object_object_add(jbank, "elapsed_ns",
+					       bank->state == BANK_RUNNING ? NULL :
+					       json_object_new_int64(bank->elapsed_ns));
+			json_object_object_add(jbank, "bandwidth_mbps",
+					       bw > 0.0 ? json_object_new_double(bw) : NULL);
+			json_object_array_add(banks, jbank);
 		}
 
-		res = fpgaReadMMIO64(n5010->handle, 0, n5010->base + HBM_TEST_TIMEOUT, &timeout);
-		if (res != FPGA_OK) {
-			fprintf(stderr, "failed to read timeout: %s\n", fpgaErrStr(res));
-			goto error;
+		passed = passed && mem_passed(mem);
+
+		json_object_object_add(jtest, "name", json_object_new_string(mem->test->name));
+		json_object_object_add(jtest, "result",
+				       json_object_new_string(mem_passed(mem) ? "pass" : "fail"));
+		json_object_object_add(jtest, "elapsed_ns",
+				       json_object_new_int64(mem_elapsed_ns(mem)));
+		json_object_object_add(jtest, "banks", banks);
+		json_object_array_add(tests, jtest);
+	}
+
+	json_object_object_add(root, "version", json_object_new_int(JSON_VERSION));
+	json_object_object_add(root, "result", json_object_new_string(passed ? "pass" : "fail"));
+	json_object_object_add(root, "bytes_per_bank",
+			       n5010->bytes ? json_object_new_int64(n5010->bytes) : NULL);
+	json_object_object_add(root, "tests", tests);
+
+	printf("%s\n", json_object_to_json_string_ext(root,
+						      JSON_C_TO_STRING_PRETTY |
+						      JSON_C_TO_STRING_SPACED));
+	json_object_put(root);
+}
+
+// Log the failed, timed out and incomplete banks of each test.
+static fpga_result fpga_check(struct n5010 *n5010)
+{
+	fpga_result res = FPGA_OK;
+	size_t i;
+	uint64_t b;
+
+	for (i = 0; i < n5010->num_mem; i++) {
+		const struct n5010_mem *mem = &n5010->mem[i];
+		uint64_t fail = 0, timeout = 0, pass = 0;
+
+		if (mem->res != FPGA_OK) {
+			res = mem->res;
+			continue;
 		}
 
-		if (n5010->debug) {
-			printf("reg: 0x%04x (32x HBM channels, pass),    val: 0x%016jx\n", HBM_TEST_PASS, pass);
-			printf("reg: 0x%04x (32x HBM channels, fail),    val: 0x%016jx\n", HBM_TEST_FAIL, fail);
-			printf("reg: 0x%04x (32x HBM channels, timeout), val: 0x%016jx\n", HBM_TEST_TIMEOUT, timeout);
+		for (b = 0; b < mem->num_banks; b++) {
+			if (mem->bank[b].state == BANK_FAIL)
+				fail |= 1ULL << b;
+			else if (mem->bank[b].state == BANK_TIMEOUT)
+				timeout |= 1ULL << b;
+			else if (mem->bank[b].state == BANK_PASS)
+				pass |= 1ULL << b;
 		}
-	}
 
-	if (fail != 0x0) {
-		fprintf(stderr, "Error: Test failed on the following channels: 0x%016jx\n", fail);
-		res = FPGA_EXCEPTION;
-	}
+		if (fail != 0x0)
+			fprintf(stderr, "Error: %s test failed on the following channels: 0x%016jx\n",
+				mem->test->name, fail);
 
-	if (timeout != 0x0) {
-		fprintf(stderr, "Error: Test timed out on the following channels: 0x%016jx\n", timeout);
-		res = FPGA_EXCEPTION;
-	}
+		if (timeout != 0x0)
+			fprintf(stderr, "Error: %s test timed out on the following channels: 0x%016jx\n",
+				mem->test->name, timeout);
 
-	if (pass != 0xffffffff) {
-		fprintf(stderr, "Error: Test did not pass on all channels: 0x%016jx\n", pass);
-		res = FPGA_EXCEPTION;
+		if (!mem_passed(mem)) {
+			fprintf(stderr, "Error: %s test did not pass on all channels: 0x%016jx\n",
+				mem->test->name, pass);
+			res = FPGA_EXCEPTION;
+		}
 	}
 
-	if (res != FPGA_OK)
-		goto error;
-
-error:
 	return res;
 }
 
@@ -704,13 +1010,19 @@ static void print_usage(FILE *f)
 		"  -g  --guid      uuid of accelerator to open\n"
 		"  -m  --mode      test mode to execute. Known modes:\n"
 		"                  ddr-directed, ddr-prbs, hbm, esram, qdr\n"
+		"                  A comma separated list of modes runs the\n"
+		"                  tests in parallel, 'all' runs hbm, ddr-prbs,\n"
+		"                  esram and qdr\n"
+		"  -b  --bytes     bytes each bank moves in one test, used to\n"
+		"                  report the achieved bandwidth\n"
+		"  -J  --json      print per bank results as JSON\n"
 		"  -d  --debug     enable debug print of register values\n"
 		"  -s  --shared    open FPGA connection in shared mode\n"
 		"\n",
 		program_invocation_short_name);
 }
 
-static bool parse_mode(struct n5010 *n5010, const char *mode)
+static bool add_mode(struct n5010 *n5010, const char *mode)
 {
 	const struct n5010_test *t;
 	size_t count = sizeof(n5010_test) / sizeof(*n5010_test);
@@ -728,7 +1040,53 @@ static bool parse_mode(struct n5010 *n5010, const char *mode)
 		return false;
 	}
 
-	n5010->test = t;
+	for (i = 0; i < n5010->num_mem; i++) {
+		if (n5010->mem[i].test == t)
+			return true;
+
+		if (n5010->mem[i].test->ctrl == t->ctrl) {
+			fprintf(stderr, "modes '%s' and '%s' can't run together\n",
+				n5010->mem[i].test->name, mode);
+			return false;
+		}
+	}
+
+	n5010->mem[n5010->num_mem++].test = t;
+
+	return true;
+}
+
+static bool parse_mode(struct n5010 *n5010, const char *mode)
+{
+	char modes[256];
+	char *saveptr = NULL;
+	char *m;
+	size_t i;
+
+	n5010->num_mem = 0;
+
+	if (strcmp(mode, "all") == 0) {
+		for (i = 0; i < sizeof(all_tests) / sizeof(*all_tests); i++) {
+			if (!add_mode(n5010, all_tests[i]))
+				return false;
+		}
+		return true;
+	}
+
+	if (snprintf(modes, sizeof(modes), "%s", mode) >= (int)sizeof(modes)) {
+		fprintf(stderr, "invalid mode setting: '%s'\n", mode);
+		return false;
+	}
+
+	for (m = strtok_r(modes, ",", &saveptr); m; m = strtok_r(NULL, ",", &saveptr)) {
+		if (!add_mode(n5010, m))
+			return false;
+	}
+
+	if (!n5010->num_mem) {
+		fprintf(stderr, "invalid mode setting: '%s'\n", mode);
+		return false;
+	}
 
 	return true;
 }
@@ -740,11 +1098,14 @@ static fpga_result parse_args(int argc, char **argv, struct n5010 *n5010)
 		{ "guid",  required_argument, NULL, 'g' },
 		{ "mode",  required_argument, NULL, 'm' },
 		{ "debug", no_argument,       NULL, 'd' },
+		{ "bytes", required_argument, NULL, 'b' },
+		{ "json",  no_argument,       NULL, 'J' },
 		{ "shared",no_argument,       NULL, 's' },
 		{ NULL,    0,                 NULL, 0   },
 	};
 
 	fpga_result res;
+	char *endptr;
 	int c;
 
 	res = fpgaGetProperties(NULL, &n5010->filter);
@@ -765,7 +1126,7 @@ static fpga_result parse_args(int argc, char **argv, struct n5010 *n5010)
 	n5010->open_mode = 0;
 
 	while (1) {
-		c = getopt_long_only(argc, argv, "hg:m:d", options, NULL);
+		c = getopt_long_only(argc, argv, "hg:m:db:J", options, NULL);
 		if (c == -1)
 			break;
 
@@ -787,6 +1148,17 @@ static fpga_result parse_args(int argc, char **argv, struct n5010 *n5010)
 		case 'd':
 			n5010->debug = true;
 			break;
+		case 'b':
+			errno = 0;
+			n5010->bytes = strtoull(optarg, &endptr, 0);
+			if (errno || *endptr) {
+				fprintf(stderr, "invalid bytes: '%s'\n", optarg);
+				return FPGA_EXCEPTION;
+			}
+			break;
+		case 'J':
+			n5010->json = true;
+			break;
 		case 's':
 			n5010->open_mode = FPGA_OPEN_SHARED;
 			break;
@@ -801,12 +1173,16 @@ static fpga_result parse_args(int argc, char **argv, struct n5010 *n5010)
 		return FPGA_EXCEPTION;
 	}
 
+	// hbm is the default mode
+	if (!n5010->num_mem)
+		n5010->mem[n5010->num_mem++].test = n5010_test;
+
 	return FPGA_OK;
 }
 
 int main(int argc, char **argv)
 {
-	struct n5010 n5010 = {.test = n5010_test};
+	struct n5010 n5010 = {0};
 	fpga_result res;
 
 	res = parse_args(argc, argv, &n5010);
@@ -823,11 +1199,19 @@ int main(int argc, char **argv)
 
 	fpga_dump(&n5010, 0, 3);
 
-	res = n5010.test->func(&n5010);
+	res = fpga_run(&n5010);
+
+	if (n5010.json)
+		report_json(&n5010);
+	else
+		report_text(&n5010);
+
+	if (res == FPGA_OK)
+		res = fpga_check(&n5010);
 	if (res != FPGA_OK)
 		goto error;
 
-	printf("passed\n");
+	info(&n5010, "passed\n");
 
 error:
 	fpga_close(&n5010);
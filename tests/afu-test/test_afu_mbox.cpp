@@ -0,0 +1,289 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "afu_mbox.h"
+
+using namespace opae::afu_test;
+
+#define MBOX_CMD      0x0030
+#define MBOX_DATA     0x0038
+#define MBOX_SEL      0x0040
+#define MBOX_READ     0x00000001ULL
+#define MBOX_WRITE    0x00000002ULL
+#define MBOX_ACK      0x00000004ULL
+#define MBOX_DONE     0x00000100ULL // model-only: distinguishes a
+                                    // completed op from an ack clear
+
+// A software model of an indirect register mailbox, in the layout
+// used by the HSSI AFU, served from its own thread.
+class mbox_model {
+ public:
+  mbox_model(std::chrono::microseconds delay = std::chrono::microseconds(0))
+  : delay_(delay)
+  , running_(true)
+  , ops_(0)
+  {
+    memset(mmio_, 0, sizeof(mmio_));
+    thread_ = std::thread(&mbox_model::serve, this);
+  }
+
+  ~mbox_model()
+  {
+    running_ = false;
+    thread_.join();
+  }
+
+  volatile uint8_t *base() { return reinterpret_cast<uint8_t *>(mmio_); }
+
+  uint32_t reg(uint64_t channel, uint32_t addr)
+  {
+    return regs_[std::make_pair(channel, addr)];
+  }
+
+  uint64_t ops() const { return ops_; }
+
+  static mbox_regs layout()
+  {
+    mbox_regs r;
+    r.cmd = MBOX_CMD;
+    r.data = MBOX_DATA;
+    r.select = MBOX_SEL;
+    r.has_select = true;
+    r.read_cmd = MBOX_READ;
+    r.write_cmd = MBOX_WRITE;
+    r.ack = MBOX_ACK;
+    r.addr_shift = 32;
+    r.data_shift = 32;
+    return r;
+  }
+
+ private:
+  uint64_t load(uint32_t offset)
+  {
+    return __atomic_load_n(&mmio_[offset / 8], __ATOMIC_ACQUIRE);
+  }
+
+  void store(uint32_t offset, uint64_t value)
+  {
+    __atomic_store_n(&mmio_[offset / 8], value, __ATOMIC_RELEASE);
+  }
+
+  void serve()
+  {
+    while (running_) {
+      uint64_t cmd = load(MBOX_CMD);
+      if ((cmd & (MBOX_READ | MBOX_WRITE)) && !(cmd & MBOX_ACK)) {
+        if (delay_.count())
+          std::this_thread::sleep_for(delay_);
+        auto key = std::make_pair(load(MBOX_SEL),
+                                  static_cast<uint32_t>(cmd >> 32));
+        if (cmd & MBOX_WRITE)
+          regs_[key] = static_cast<uint32_t>(load(MBOX_DATA) >> 32);
+        else
+          store(MBOX_DATA, regs_[key]);
+        ++ops_;
+        store(MBOX_CMD, (cmd & ~(MBOX_READ | MBOX_WRITE)) |
+                        MBOX_ACK | MBOX_DONE);
+      } else if (cmd == MBOX_ACK) {
+        store(MBOX_CMD, 0);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  uint64_t mmio_[512];
+  std::chrono::microseconds delay_;
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> ops_;
+  std::map<std::pair<uint64_t, uint32_t>, uint32_t> regs_;
+  std::thread thread_;
+};
+
+class afu_mbox : public ::testing::Test {
+ protected:
+  afu_mbox() {}
+};
+
+/**
+ * @test       write_read
+ * @brief      Test: mailbox::write, mailbox::read
+ * @details    Values written through the mailbox are read back,<br>
+ *             and each access is counted in the stats.<br>
+ */
+TEST_F(afu_mbox, write_read) {
+  mbox_model afu;
+  mailbox mbox(afu.base(), mbox_model::layout());
+
+  for (uint32_t i = 0; i < 16; ++i)
+    mbox.write(0x100 + i, 0xc0de0000 | i);
+  for (uint32_t i = 0; i < 16; ++i)
+    EXPECT_EQ(0xc0de0000 | i, mbox.read(0x100 + i));
+
+  EXPECT_EQ(0xc0de0003, afu.reg(0, 0x103));
+  EXPECT_EQ(16u, mbox.stats().writes);
+  EXPECT_EQ(16u, mbox.stats().reads);
+  EXPECT_EQ(32u, afu.ops());
+  EXPECT_LE(mbox.stats().min_ns, mbox.stats().max_ns);
+  EXPECT_GT(mbox.stats().mean_ns(), 0.0);
+}
+
+/**
+ * @test       select
+ * @brief      Test: mailbox::select
+ * @details    Registers on different channels are independent,<br>
+ *             and the select CSR is written only when the channel<br>
+ *             changes.<br>
+ */
+TEST_F(afu_mbox, select) {
+  mbox_model afu;
+  mailbox mbox(afu.base(), mbox_model::layout());
+
+  mbox.select(0);
+  mbox.write(0x10, 1);
+  mbox.select(0);
+  mbox.select(1);
+  mbox.write(0x10, 2);
+  mbox.select(1);
+
+  EXPECT_EQ(1u, afu.reg(0, 0x10));
+  EXPECT_EQ(2u, afu.reg(1, 0x10));
+  EXPECT_EQ(2u, mbox.stats().selects);
+
+  mbox.invalidate();
+  mbox.select(1);
+  EXPECT_EQ(3u, mbox.stats().selects);
+}
+
+/**
+ * @test       batch
+ * @brief      Test: mailbox::execute
+ * @details    A batch runs its ops in order, delivers read results,<br>
+ *             and records a latency for each op.<br>
+ */
+TEST_F(afu_mbox, batch) {
+  mbox_model afu;
+  mailbox mbox(afu.base(), mbox_model::layout());
+  uint32_t a = 0, b = 0;
+
+  mbox_batch batch;
+  batch.select(2)
+       .write(0x20, 0xaaaa)
+       .write(0x24, 0xbbbb)
+       .read(0x20, &a)
+       .read(0x24, &b)
+       .write(0x20, 0xcccc);
+
+  uint64_t total = mbox.execute(batch);
+
+  EXPECT_EQ(0xaaaau, a);
+  EXPECT_EQ(0xbbbbu, b);
+  EXPECT_EQ(0xccccu, afu.reg(2, 0x20));
+  EXPECT_EQ(6u, batch.size());
+  EXPECT_EQ(0xbbbbu, batch.ops()[4].data);
+
+  uint64_t sum = 0;
+  for (const auto &op : batch.ops())
+    sum += op.latency_ns;
+  EXPECT_LE(sum, total);
+  EXPECT_GT(batch.ops()[1].latency_ns, 0u);
+}
+
+/**
+ * @test       read_cached
+ * @brief      Test: mailbox::read_cached
+ * @details    A cached read is served from the cache the second<br>
+ *             time, and a write to the register drops the entry.<br>
+ */
+TEST_F(afu_mbox, read_cached) {
+  mbox_model afu;
+  mailbox mbox(afu.base(), mbox_model::layout());
+
+  mbox.write(0x30, 7);
+  EXPECT_EQ(7u, mbox.read_cached(0x30));
+  EXPECT_EQ(7u, mbox.read_cached(0x30));
+  EXPECT_EQ(1u, mbox.stats().reads);
+  EXPECT_EQ(1u, mbox.stats().cached_reads);
+
+  mbox.write(0x30, 8);
+  EXPECT_EQ(8u, mbox.read_cached(0x30));
+  EXPECT_EQ(2u, mbox.stats().reads);
+
+  // Cache entries are per channel.
+  mbox.select(1);
+  EXPECT_EQ(0u, mbox.read_cached(0x30));
+  EXPECT_EQ(3u, mbox.stats().reads);
+}
+
+/**
+ * @test       backoff
+ * @brief      Test: mbox_policy
+ * @details    When the AFU is slower than the spin budget, the<br>
+ *             engine backs off to sleeping and still completes.<br>
+ */
+TEST_F(afu_mbox, backoff) {
+  mbox_model afu(std::chrono::microseconds(500));
+  mbox_policy policy;
+  policy.spin_polls = 8;
+  mailbox mbox(afu.base(), mbox_model::layout(), policy);
+
+  mbox.write(0x40, 0x1234);
+  EXPECT_EQ(0x1234u, mbox.read(0x40));
+  EXPECT_GT(mbox.stats().sleeps, 0u);
+  EXPECT_GE(mbox.stats().min_ns, 500000u);
+}
+
+/**
+ * @test       timeout
+ * @brief      Test: mailbox::write
+ * @details    When the AFU never acknowledges, the access throws<br>
+ *             std::runtime_error after the policy's timeout.<br>
+ */
+TEST_F(afu_mbox, timeout) {
+  uint64_t mmio[512];
+  memset(mmio, 0, sizeof(mmio));
+  mbox_policy policy;
+  policy.spin_polls = 8;
+  policy.timeout = std::chrono::milliseconds(5);
+  mailbox mbox(reinterpret_cast<uint8_t *>(mmio), mbox_model::layout(),
+               policy);
+
+  auto t0 = std::chrono::steady_clock::now();
+  EXPECT_THROW(mbox.write(0x50, 1), std::runtime_error);
+  EXPECT_GE(std::chrono::steady_clock::now() - t0,
+            std::chrono::milliseconds(5));
+}
@@ -191,6 +191,47 @@ TEST_P(dummy_afu_p, main_sleep_notimeout) {
   EXPECT_EQ(0, app_->main(args_.size(), const_cast<char**>(args_.data())));
 }
 
+/*
+ * @test       main_mmio_bench
+ * @brief      Test: test main with --bench and the mmio perf subcommand
+ * @details    The command measures its own MMIO reads, so it runs once,<br>
+ *             and the JSON report lists the reads and the command.
+ */
+TEST_P(dummy_afu_p, main_mmio_bench) {
+  char tmpfile[] = "/tmp/dummy_afu-bench-XXXXXX";
+  int fd = mkstemp(tmpfile);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  args_.push_back(opae_strdup("dummy_afu"));
+  args_.push_back(opae_strdup("--bench"));
+  args_.push_back(opae_strdup("--bench-repeat"));
+  args_.push_back(opae_strdup("3"));
+  args_.push_back(opae_strdup("--bench-json"));
+  args_.push_back(opae_strdup(tmpfile));
+  args_.push_back(opae_strdup("mmio"));
+  args_.push_back(opae_strdup("--perf"));
+  args_.push_back(opae_strdup("-c"));
+  args_.push_back(opae_strdup("10"));
+  EXPECT_EQ(0, app_->main(args_.size(), const_cast<char**>(args_.data())));
+
+  auto &results = app_->bench().results();
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0].name, "mmio_rd64");
+  EXPECT_EQ(results[0].iterations, 10u);
+  EXPECT_EQ(results[0].repeats, 3u);
+  EXPECT_LE(results[0].p50, results[0].p99);
+  EXPECT_EQ(results[1].name, "mmio");
+  EXPECT_EQ(results[1].repeats, 1u);
+
+  std::ifstream in(tmpfile);
+  std::string json((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  EXPECT_NE(json.find("\"schema\": \"opae-afu-bench/1\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\": \"mmio_rd64\""), std::string::npos);
+  unlink(tmpfile);
+}
+
 /*
  * @test       main_ddr
  * @brief      Test: test main with ddr subcommand
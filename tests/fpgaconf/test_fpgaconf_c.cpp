@@ -43,6 +43,7 @@ struct config {
        } mode;
   int flags;
   char *filename;
+  bool all;
 };
 extern struct config config;
 
@@ -64,6 +65,14 @@ int find_fpga(fpga_properties device_filter,
 int program_bitstream(fpga_token token, uint32_t slot_num,
                       opae_bitstream_info *info, int flags);
 
+int find_fpgas(fpga_properties device_filter,
+               fpga_guid interface_id,
+               fpga_token **fpgas,
+               uint32_t *num_fpgas);
+
+int program_all(fpga_token *tokens, uint32_t num_tokens,
+                uint32_t slot_num, opae_bitstream_info *info, int flags);
+
 int fpgaconf_main(int argc, char *argv[]);
 
 }
@@ -979,6 +988,102 @@ TEST_P(fpgaconf_c_mock_p, prog_bs2) {
   EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
 }
 
+/**
+ * @test       find_fpgas0
+ * @brief      Test: find_fpgas
+ * @details    When the given PCIe address settings match no device,<br>
+ *             find_fpgas returns 0 and allocates no tokens.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, find_fpgas0) {
+  fpga_properties filter = NULL;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetBus(filter, 0xff), FPGA_OK);
+
+  fpga_token *toks = nullptr;
+  uint32_t num_toks = 0;
+  EXPECT_EQ(find_fpgas(filter, test_guid, &toks, &num_toks), 0);
+  EXPECT_EQ(toks, nullptr);
+  EXPECT_EQ(num_toks, 0);
+
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
+/**
+ * @test       prog_all0
+ * @brief      Test: program_all
+ * @details    When config.dry_run is set to true,<br>
+ *             find_fpgas returns each matching device,<br>
+ *             and program_all programs them all,<br>
+ *             returning 0 failures.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, prog_all0) {
+  fpga_properties filter = NULL;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+
+  config.dry_run = true;
+
+  fpga_guid pr_ifc_id;
+  ASSERT_EQ(uuid_parse(platform_.devices[0].fme_guid, pr_ifc_id), 0);
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmp_gbs_, &info), FPGA_OK);
+
+  fpga_token *toks = nullptr;
+  uint32_t num_toks = 0;
+  EXPECT_GE(find_fpgas(filter, pr_ifc_id, &toks, &num_toks), 1);
+  ASSERT_NE(toks, nullptr);
+  ASSERT_GE(num_toks, 1);
+
+  EXPECT_EQ(program_all(toks, num_toks, 0, &info, 0), 0);
+
+  for (uint32_t i = 0 ; i < num_toks ; ++i) {
+    EXPECT_EQ(fpgaDestroyToken(&toks[i]), FPGA_OK);
+  }
+  opae_free(toks);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
+/**
+ * @test       prog_all1
+ * @brief      Test: program_all
+ * @details    When config.dry_run is set to false,<br>
+ *             program_all attempts the PR on each device,<br>
+ *             which fails to set user clocks,<br>
+ *             and the fn returns the number of failed devices.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, prog_all1) {
+  fpga_properties filter = NULL;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+
+  ASSERT_EQ(config.dry_run, false);
+
+  fpga_guid pr_ifc_id;
+  ASSERT_EQ(uuid_parse(platform_.devices[0].fme_guid, pr_ifc_id), 0);
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmp_gbs_, &info), FPGA_OK);
+
+  fpga_token *toks = nullptr;
+  uint32_t num_toks = 0;
+  EXPECT_GE(find_fpgas(filter, pr_ifc_id, &toks, &num_toks), 1);
+  ASSERT_NE(toks, nullptr);
+
+  EXPECT_EQ(program_all(toks, num_toks, 0, &info, 0), (int)num_toks);
+
+  for (uint32_t i = 0 ; i < num_toks ; ++i) {
+    EXPECT_EQ(fpgaDestroyToken(&toks[i]), FPGA_OK);
+  }
+  opae_free(toks);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgaconf_c_mock_p);
 INSTANTIATE_TEST_SUITE_P(fpgaconf_c, fpgaconf_c_mock_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"skx-p"})));
@@ -570,6 +570,44 @@ TEST_P(mock_fme_fpgad_xfpga_c_p, KtiLinkFatal) {
   EXPECT_EQ(d.num_error_occurrences, 0);
 }
 
+/**
+ * @test       errors_snapshot
+ * @brief      Test: fpgad_xfpga_detect_Error
+ * @details    When the plugin is configured, error detection reads<br>
+ *             from a snapshot of the errors group, which is refreshed<br>
+ *             each time the same context is seen again.<br>
+ */
+TEST_P(mock_fme_fpgad_xfpga_c_p, errors_snapshot) {
+  fpgad_monitored_device d;
+  fpgad_config_data s;
+  init_monitored_device(&d, &s);
+
+  ASSERT_EQ(fpgad_plugin_configure(&d, NULL), 0);
+  ASSERT_NE(d.plugin_context, nullptr);
+
+  fpgad_xfpga_Error_context ap6;
+  init_AP6_context(&ap6);
+  fpgad_xfpga_Error_context kti;
+  init_KtiLinkFatal_context(&kti);
+
+  set_AP6_state(true);
+
+  EXPECT_EQ(fpgad_xfpga_detect_Error(&d, &ap6),
+            FPGAD_STATUS_DETECTED);
+  EXPECT_EQ(fpgad_xfpga_detect_Error(&d, &kti),
+            FPGAD_STATUS_NOT_DETECTED);
+  EXPECT_EQ(d.num_error_occurrences, 1);
+
+  set_AP6_state(false);
+
+  EXPECT_EQ(fpgad_xfpga_detect_Error(&d, &ap6),
+            FPGAD_STATUS_NOT_DETECTED);
+  EXPECT_EQ(d.num_error_occurrences, 0);
+
+  fpgad_plugin_destroy(&d);
+  EXPECT_EQ(d.plugin_context, nullptr);
+}
+
 /**
  * @test       configure
  * @brief      Test: fpgad_plugin_configure, fpgad_plugin_destroy
@@ -28,6 +28,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <limits.h>
+#include <string>
 
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
@@ -109,6 +110,14 @@ fpga_result get_metrics(fpga_token token, metrics_inquiry inquiry,
                         fpga_metric_info *metrics_info, uint64_t *num_metrics_info,
                         fpga_metric *metrics,uint64_t *num_metrics);
 
+void *fpgainfo_collect_metrics(fpga_token *tokens, int num_tokens,
+                               metrics_inquiry inquiry);
+
+void fpgainfo_free_devices(void *devices, int num_devices);
+
+fpga_result fpgainfo_print_json(FILE *fp, const char *command,
+                                void *devices, int num_devices);
+
 void replace_chars(char *str, char match, char rep);
 
 void upcase_pci(char *str);
@@ -919,6 +928,141 @@ TEST_P(fpgainfo_c_p, bmc_help) {
   bmc_help();
 }
 
+/**
+ * @test       bmc_command_json
+ * @brief      Test: bmc_command
+ * @details    When passed with '--json', the fn prints <br>
+ *             the BMC sensors of all devices as JSON and <br>
+ *             returns FPGA_OK. <br>
+ */
+TEST_P(fpgainfo_c_p, bmc_command_json) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  char *argv[] = { zero, one, two, NULL };
+
+  fpga_properties filter = NULL;
+  fpga_token *tokens = NULL;
+  uint32_t matches = 0, num_tokens = 0;;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter,FPGA_DEVICE), FPGA_OK);
+  ASSERT_EQ(fpgaEnumerate(&filter, 1, NULL, 0, &matches), FPGA_OK);
+  ASSERT_GT(matches, 0);
+  tokens = (fpga_token *)opae_malloc(matches * sizeof(fpga_token));
+
+  num_tokens = matches;
+  ASSERT_EQ(fpgaEnumerate(&filter, 1, tokens, num_tokens, &matches), FPGA_OK);
+
+  strcpy(zero, "fpgainfo");
+  strcpy(one, "bmc");
+  strcpy(two, "--json");
+  EXPECT_EQ(bmc_command(tokens, num_tokens, 3, argv), FPGA_OK);
+
+  for (uint32_t i = 0; i < num_tokens; ++i) {
+    fpgaDestroyToken(&tokens[i]);
+  }
+  opae_free(tokens);
+  fpgaDestroyProperties(&filter);
+}
+
+/**
+ * @test       print_json
+ * @brief      Test: fpgainfo_collect_metrics, fpgainfo_print_json
+ * @details    The metrics collected from each device are printed <br>
+ *             as one JSON document with a fixed set of keys. <br>
+ */
+TEST_P(fpgainfo_c_p, print_json) {
+  fpga_properties filter = NULL;
+  fpga_token *tokens = NULL;
+  uint32_t matches = 0, num_tokens = 0;;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter,FPGA_DEVICE), FPGA_OK);
+  ASSERT_EQ(fpgaEnumerate(&filter, 1, NULL, 0, &matches), FPGA_OK);
+  ASSERT_GT(matches, 0);
+  tokens = (fpga_token *)opae_malloc(matches * sizeof(fpga_token));
+
+  num_tokens = matches;
+  ASSERT_EQ(fpgaEnumerate(&filter, 1, tokens, num_tokens, &matches), FPGA_OK);
+
+  void *devices = fpgainfo_collect_metrics(tokens, num_tokens, FPGA_ALL);
+  ASSERT_NE(devices, nullptr);
+
+  FILE *fp = tmpfile();
+  ASSERT_NE(fp, nullptr);
+  EXPECT_EQ(fpgainfo_print_json(fp, "bmc", devices, num_tokens), FPGA_OK);
+  fpgainfo_free_devices(devices, num_tokens);
+
+  std::string text;
+  char buf[4096];
+  size_t n;
+  rewind(fp);
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    text.append(buf, n);
+  fclose(fp);
+
+  json_object *root = json_tokener_parse(text.c_str());
+  ASSERT_NE(root, nullptr);
+
+  json_object *j = nullptr;
+  ASSERT_TRUE(json_object_object_get_ex(root, "version", &j));
+  EXPECT_EQ(json_object_get_int(j), 1);
+  ASSERT_TRUE(json_object_object_get_ex(root, "command", &j));
+  EXPECT_STREQ(json_object_get_string(j), "bmc");
+
+  json_object *jdevices = nullptr;
+  ASSERT_TRUE(json_object_object_get_ex(root, "devices", &jdevices));
+  ASSERT_TRUE(json_object_is_type(jdevices, json_type_array));
+  ASSERT_EQ(json_object_array_length(jdevices), num_tokens);
+
+  const char *keys[] = { "pcie_address", "interface", "object_id",
+                         "vendor_id", "device_id", "subsystem_vendor_id",
+                         "subsystem_device_id", "socket_id", "num_slots",
+                         "bitstream_id", "bitstream_version",
+                         "pr_interface_id", "error", "metrics" };
+  for (uint32_t i = 0; i < num_tokens; ++i) {
+    json_object *jdev = json_object_array_get_idx(jdevices, i);
+    for (auto key : keys) {
+      EXPECT_TRUE(json_object_object_get_ex(jdev, key, nullptr)) << key;
+    }
+    ASSERT_TRUE(json_object_object_get_ex(jdev, "metrics", &j));
+    EXPECT_TRUE(json_object_is_type(j, json_type_array));
+  }
+
+  json_object_put(root);
+
+  for (uint32_t i = 0; i < num_tokens; ++i) {
+    fpgaDestroyToken(&tokens[i]);
+  }
+  opae_free(tokens);
+  fpgaDestroyProperties(&filter);
+}
+
+/**
+ * @test       print_json_empty
+ * @brief      Test: fpgainfo_print_json
+ * @details    With no devices, the fn prints an empty <br>
+ *             devices array. <br>
+ */
+TEST_P(fpgainfo_c_p, print_json_empty) {
+  FILE *fp = tmpfile();
+  ASSERT_NE(fp, nullptr);
+  EXPECT_EQ(fpgainfo_print_json(fp, "temp", nullptr, 0), FPGA_OK);
+
+  char buf[256] = { 0 };
+  rewind(fp);
+  EXPECT_GT(fread(buf, 1, sizeof(buf) - 1, fp), 0u);
+  fclose(fp);
+
+  json_object *root = json_tokener_parse(buf);
+  ASSERT_NE(root, nullptr);
+  json_object *jdevices = nullptr;
+  ASSERT_TRUE(json_object_object_get_ex(root, "devices", &jdevices));
+  EXPECT_EQ(json_object_array_length(jdevices), 0u);
+  json_object_put(root);
+}
+
 /**
  * @test     events_filter
  * @brief    Test: events_filter
@@ -50,6 +50,11 @@ ssize_t opae_read(int fd, void *buf, size_t count)
   return opae::testing::test_system::instance()->read(fd, buf, count);
 }
 
+ssize_t opae_pread(int fd, void *buf, size_t count, off_t offset)
+{
+  return ::pread(fd, buf, count, offset);
+}
+
 FILE *opae_fopen(const char *path, const char *mode)
 {
   return opae::testing::test_system::instance()->fopen(path, mode);
@@ -132,6 +137,12 @@ int opae_sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t *mask)
   return opae::testing::test_system::instance()->sched_setaffinity(pid, cpusetsize, mask);
 }
 
+int opae_mbind(void *, size_t, int, int)
+{
+  // Placement is only a hint: leave the test's memory policy alone.
+  return 0;
+}
+
 int opae_glob(const char *pattern,
 	      int flags,
 	      int (*errfunc)(const char *epath, int eerrno),
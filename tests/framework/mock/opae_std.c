@@ -28,6 +28,8 @@
 #endif // HAVE_CONFIG_H
 
 #include "mock/opae_std.h"
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 int opae_open(const char *path, int flags)
 {
@@ -49,6 +51,11 @@ ssize_t opae_read(int fd, void *buf, size_t count)
 	return read(fd, buf, count);
 }
 
+ssize_t opae_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	return pread(fd, buf, count, offset);
+}
+
 FILE *opae_fopen(const char *path, const char *mode)
 {
 	return fopen(path, mode);
@@ -130,6 +137,33 @@ int opae_sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t *mask)
 	return sched_setaffinity(pid, cpusetsize, mask);
 }
 
+#define NUMA_MASK_BITS 256
+#define ULONG_BITS (8 * sizeof(unsigned long))
+
+int opae_mbind(void *addr, size_t len, int interleave, int node)
+{
+	unsigned long mask[NUMA_MASK_BITS / ULONG_BITS];
+	unsigned long mode = MPOL_PREFERRED;
+	size_t i;
+
+	memset(mask, 0, sizeof(mask));
+
+	if (interleave) {
+		mode = MPOL_INTERLEAVE;
+		for (i = 0 ; i < NUMA_MASK_BITS / ULONG_BITS ; ++i)
+			mask[i] = ~0UL;
+	} else {
+		if ((node < 0) || (node >= NUMA_MASK_BITS)) {
+			errno = EINVAL;
+			return -1;
+		}
+		mask[node / ULONG_BITS] = 1UL << (node % ULONG_BITS);
+	}
+
+	return (int)syscall(__NR_mbind, addr, len, mode, mask,
+			    NUMA_MASK_BITS + 1, 0);
+}
+
 int opae_glob(const char *pattern,
 	      int flags,
 	      int (*errfunc)(const char *epath, int eerrno),
@@ -56,6 +56,7 @@ int opae_open(const char *path, int flags);
 int opae_open_create(const char *path, int flags, mode_t mode);
 int opae_close(int fd);
 ssize_t opae_read(int fd, void *buf, size_t count);
+ssize_t opae_pread(int fd, void *buf, size_t count, off_t offset);
 
 FILE *opae_fopen(const char *path, const char *mode);
 int opae_fclose(FILE *stream);
@@ -83,6 +84,13 @@ int opae_scandir(const char *dirp,
 
 int opae_sched_setaffinity(pid_t pid, size_t cpusetsize, const cpu_set_t *mask);
 
+/*
+ * Set the NUMA policy of [addr, addr + len) before its pages are
+ * faulted in: interleave them across all nodes, or else prefer node.
+ * Returns 0 on success, or -1 with errno set, like mbind(2).
+ */
+int opae_mbind(void *addr, size_t len, int interleave, int node);
+
 int opae_glob(const char *pattern,
 	      int flags,
 	      int (*errfunc)(const char *epath, int eerrno),
@@ -116,7 +116,7 @@ test_device test_device::unknown() {
                      .mdata = ""};
 }
 
-test_system::test_system() : initialized_(false), root_("") {}
+test_system::test_system() : initialized_(false), opens_(0), root_("") {}
 
 test_system *test_system::instance_ = nullptr;
 test_system *test_system::instance() {
@@ -220,6 +220,8 @@ std::vector<uint8_t> test_system::assemble_gbs_header(const test_device &td,
 }
 
 void test_system::initialize() {
+  opens_ = 0;
+
   invalidate_malloc_ = false;
   invalidate_malloc_after_ = 0;
   invalidate_malloc_when_called_from_ = nullptr;
@@ -423,6 +425,7 @@ int test_system::open(const std::string &path, int flags) {
   }
   std::string syspath = get_sysfs_path(path);
   int fd;
+  ++opens_;
   auto r1 = regex<>::create(sysclass_pattern);
   auto r2 = regex<>::create(dev_pattern);
   match_t::ptr_t m;
@@ -486,6 +489,7 @@ int test_system::open(const std::string &path, int flags, mode_t mode) {
   }
 
   std::string syspath = get_sysfs_path(path);
+  ++opens_;
   int fd = ::open(syspath.c_str(), flags, mode);
 
   if (syspath.find(root_) == 0) {
@@ -560,6 +564,7 @@ ssize_t test_system::read(int fd, void *buf, size_t count) {
 
 FILE *test_system::fopen(const std::string &path, const std::string &mode) {
   std::string syspath = get_sysfs_path(path);
+  ++opens_;
   FILE *fp = ::fopen(syspath.c_str(), mode.c_str());
   if (fp) {
     std::lock_guard<std::mutex> guard(fopens_mutex_);
@@ -155,6 +155,11 @@ class test_system {
   int open(const std::string &path, int flags, mode_t m);
   int close(int fd);
 
+  // The number of open() and fopen() calls made since
+  // initialize() or the last reset_opens().
+  uint32_t opens() const { return opens_; }
+  void reset_opens() { opens_ = 0; }
+
   void invalidate_read(uint32_t after=0, const char *when_called_from=nullptr);
   ssize_t read(int fd, void *buf, size_t count);
 
@@ -253,6 +258,7 @@ class test_system {
   test_system();
   std::mutex fds_mutex_;
   std::atomic_bool initialized_;
+  std::atomic<uint32_t> opens_;
   std::string root_;
   std::map<int, Resource<mock_object>> fds_;
   std::mutex fopens_mutex_;
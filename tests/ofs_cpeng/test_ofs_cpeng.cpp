@@ -24,12 +24,26 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #include <chrono>
+#include <cstring>
 #include <future>
 #include <thread>
 #include <uuid/uuid.h>
 #include "gtest/gtest.h"
+
+// Count the full-width register accesses made by the driver.
+static uint32_t csr_reads;
+static uint32_t csr_writes;
+#define OFS_CSR_READ(__reg) (++csr_reads, (__reg)->value)
+#define OFS_CSR_WRITE(__reg, __value) \
+  (++csr_writes, (__reg)->value = (__value))
+
 #include "ofs_cpeng.h"
 
+// Point a driver register at its offset in a memory-backed register file.
+#define MAP_CSR(__drv, __regs, __name)                     \
+  (__drv).r_##__name = reinterpret_cast<volatile __name *>( \
+    reinterpret_cast<uint8_t *>(__regs) + __name##_OFFSET)
+
 
 /**
  * @test    wait_for_hps_ready
@@ -93,3 +107,66 @@ TEST(ofs_cpeng, copy_chunk)
   EXPECT_EQ(r_dst.f_CSR_DST_ADDR, 0x4000);
   EXPECT_EQ(r_size.f_CSR_DATA_SIZE, 8192);
 }
+
+/**
+ * @test    copy_chunk_mmio
+ * @brief   Tests: ofs_cpeng_copy_chunk
+ * @details The source, destination, size and start registers each have
+ *          a single writable field, so programming a chunk must take one
+ *          full-width write per register and no read-back. The registers
+ *          are backed by a memory register file at their YAML offsets.
+ * */
+TEST(ofs_cpeng, copy_chunk_mmio)
+{
+  ofs_cpeng otest;
+  uint64_t regs[0x160 / 8];
+
+  memset(regs, 0xff, sizeof(regs));
+  MAP_CSR(otest, regs, CSR_SRC_ADDR);
+  MAP_CSR(otest, regs, CSR_DST_ADDR);
+  MAP_CSR(otest, regs, CSR_DATA_SIZE);
+  MAP_CSR(otest, regs, CSR_HOST2CE_MRD_START);
+  MAP_CSR(otest, regs, CSR_CE2HOST_STATUS);
+  otest.r_CSR_CE2HOST_STATUS->value = 0b10;
+
+  csr_reads = csr_writes = 0;
+  EXPECT_EQ(ofs_cpeng_copy_chunk(&otest, 0x123456789, 0x2000, 4096, 1000), 0);
+  EXPECT_EQ(csr_writes, 4u);
+  EXPECT_EQ(csr_reads, 0u);
+
+  // The unused upper bits are written as zero.
+  EXPECT_EQ(regs[CSR_SRC_ADDR_OFFSET / 8], 0x23456789u);
+  EXPECT_EQ(regs[CSR_DST_ADDR_OFFSET / 8], 0x2000u);
+  EXPECT_EQ(regs[CSR_DATA_SIZE_OFFSET / 8], 4096u);
+  EXPECT_EQ(regs[CSR_HOST2CE_MRD_START_OFFSET / 8], 1u);
+}
+
+/**
+ * @test    soft_reset_mmio
+ * @brief   Tests: ofs_cpeng_ce_soft_reset, ofs_cpeng_set_data_req_limit
+ * @details CSR_CE_SFTRST has a read-write field besides CE_SFTRST, so
+ *          setting CE_SFTRST reads the register once to preserve it.
+ *          CSR_CE2HOST_DATA_REQ_LIMIT has none, so it is only written.
+ * */
+TEST(ofs_cpeng, soft_reset_mmio)
+{
+  ofs_cpeng otest;
+  uint64_t regs[0x160 / 8];
+
+  memset(regs, 0, sizeof(regs));
+  MAP_CSR(otest, regs, CSR_CE_SFTRST);
+  MAP_CSR(otest, regs, CSR_CE2HOST_DATA_REQ_LIMIT);
+  regs[CSR_CE_SFTRST_OFFSET / 8] = 0x100;
+
+  csr_reads = csr_writes = 0;
+  ofs_cpeng_ce_soft_reset(&otest);
+  EXPECT_EQ(csr_reads, 1u);
+  EXPECT_EQ(csr_writes, 1u);
+  EXPECT_EQ(regs[CSR_CE_SFTRST_OFFSET / 8], 0x101u);
+
+  csr_reads = csr_writes = 0;
+  ofs_cpeng_set_data_req_limit(&otest, 0b11);
+  EXPECT_EQ(csr_reads, 0u);
+  EXPECT_EQ(csr_writes, 1u);
+  EXPECT_EQ(regs[CSR_CE2HOST_DATA_REQ_LIMIT_OFFSET / 8], 3u);
+}
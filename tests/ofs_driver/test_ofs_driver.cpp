@@ -25,13 +25,29 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <chrono>
+#include <cstring>
 #include <future>
 #include <thread>
 #include <uuid/uuid.h>
 #include <ofs/ofs.h>
 #include "gtest/gtest.h"
+
+// Count the full-width register accesses made by the driver,
+// and remember the first values written.
+static uint32_t csr_reads;
+static uint32_t csr_writes;
+static uint64_t csr_written[4];
+#define OFS_CSR_READ(__reg) (++csr_reads, (__reg)->value)
+#define OFS_CSR_WRITE(__reg, __value) \
+  ((__reg)->value = csr_written[csr_writes++ % 4] = (__value))
+
 #include "ofs_test.h"
 
+// Point a driver register at its offset in a memory-backed register file.
+#define MAP_CSR(__drv, __regs, __name)                     \
+  (__drv).r_##__name = reinterpret_cast<volatile __name *>( \
+    reinterpret_cast<uint8_t *>(__regs) + __name##_OFFSET)
+
 union uuid_bytes {
   struct {
     uint64_t lo;
@@ -96,4 +112,100 @@ TEST(ofs_driver, ofs_test_read_guid)
   char unparsed[56];
   uuid_unparse(u2, unparsed);
   EXPECT_STREQ(guid_str, unparsed);
-}
\ No newline at end of file
+}
+
+/**
+ * @test    ofs_test_coalesced_writes
+ * @brief   Tests: ofs_test_configure, ofs_test_set_count
+ * @details Consecutive field assignments to one register are combined
+ *          into a single write. When they cover all the read-write fields
+ *          of the register (configure), the register isn't read first.
+ *          Otherwise (set_count) it is read once to preserve the others.
+ * */
+TEST(ofs_driver, ofs_test_coalesced_writes)
+{
+  ofs_test otest;
+  uint64_t regs[0x30 / 8];
+
+  memset(regs, 0, sizeof(regs));
+  MAP_CSR(otest, regs, cfg);
+  regs[cfg_OFFSET / 8] = 0xdead0000;
+
+  csr_reads = csr_writes = 0;
+  ofs_test_configure(&otest, 0x12, 0x34);
+  EXPECT_EQ(csr_reads, 0u);
+  EXPECT_EQ(csr_writes, 1u);
+  EXPECT_EQ(regs[cfg_OFFSET / 8], 0x1234u);
+
+  csr_reads = csr_writes = 0;
+  ofs_test_set_count(&otest, 0x56);
+  EXPECT_EQ(csr_reads, 1u);
+  EXPECT_EQ(csr_writes, 1u);
+  EXPECT_EQ(regs[cfg_OFFSET / 8], 0x5634u);
+}
+
+/**
+ * @test    ofs_test_pulse_writes
+ * @brief   Tests: ofs_test_pulse
+ * @details Assignments to the same field are not combined, so setting
+ *          the flags and clearing them again reaches the device as two
+ *          writes. Each write preserves the count field.
+ * */
+TEST(ofs_driver, ofs_test_pulse_writes)
+{
+  ofs_test otest;
+  uint64_t regs[0x30 / 8];
+
+  memset(regs, 0, sizeof(regs));
+  MAP_CSR(otest, regs, cfg);
+  regs[cfg_OFFSET / 8] = 0x1200;
+
+  csr_reads = csr_writes = 0;
+  ofs_test_pulse(&otest, 0x01);
+  EXPECT_EQ(csr_writes, 2u);
+  EXPECT_EQ(csr_written[0], 0x1201u);
+  EXPECT_EQ(csr_written[1], 0x1200u);
+  EXPECT_EQ(regs[cfg_OFFSET / 8], 0x1200u);
+}
+
+/**
+ * @test    ofs_test_shadow_writes
+ * @brief   Tests: ofs_test_start, ofs_test_stop, ofs_test_ring
+ * @details The ctl register is marked shadow, so its writes start from
+ *          the host-side copy and never read the device. The doorbell
+ *          register is write_only, so reading it returns the host-side
+ *          copy as well.
+ * */
+TEST(ofs_driver, ofs_test_shadow_writes)
+{
+  ofs_test otest;
+  uint64_t regs[0x30 / 8];
+
+  memset(regs, 0, sizeof(regs));
+  MAP_CSR(otest, regs, ctl);
+  MAP_CSR(otest, regs, doorbell);
+  otest.s_ctl.value = 0;
+  otest.s_doorbell.value = 0;
+
+  // What the device returns must not leak into the writes.
+  regs[ctl_OFFSET / 8] = 0xffffffffffffffffULL;
+  regs[doorbell_OFFSET / 8] = 0xffffffffffffffffULL;
+
+  csr_reads = csr_writes = 0;
+  ofs_test_start(&otest, 3);
+  EXPECT_EQ(csr_reads, 0u);
+  EXPECT_EQ(csr_writes, 1u);
+  EXPECT_EQ(regs[ctl_OFFSET / 8], 0x301u);
+
+  ofs_test_stop(&otest);
+  EXPECT_EQ(csr_reads, 0u);
+  EXPECT_EQ(csr_writes, 2u);
+  EXPECT_EQ(regs[ctl_OFFSET / 8], 0x300u);
+  EXPECT_EQ(otest.s_ctl.value, 0x300u);
+
+  ofs_test_ring(&otest, 42);
+  EXPECT_EQ(csr_reads, 0u);
+  EXPECT_EQ(csr_writes, 3u);
+  EXPECT_EQ(regs[doorbell_OFFSET / 8], 42u);
+  EXPECT_EQ(ofs_test_last_tail(&otest), 42u);
+}
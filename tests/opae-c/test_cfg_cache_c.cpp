@@ -0,0 +1,444 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/limits.h>
+#include <string>
+
+#include "mock/opae_fixtures.h"
+#include "cfg-file.h"
+
+extern "C" {
+extern libopae_config_data default_libopae_config_table[];
+}
+
+using namespace opae::testing;
+
+const char *cache_cfg_json = R"json(
+{
+  "configurations": {
+
+    "ofs": {
+      "enabled": true,
+      "devices": [
+        { "name": "ofs0_pf", "id": [ "0x8086", "0xaf00", "0x8086", "0" ] },
+        { "name": "ofs0_vf", "id": [ "0x8086", "0xaf01", "0x8086", "0" ] }
+      ],
+
+      "opae": {
+        "plugin": [
+          {
+            "enabled": true,
+            "module": "libxfpga.so",
+            "devices": [ "ofs0_pf" ],
+            "configuration": {}
+          },
+          {
+            "enabled": true,
+            "module": "libopae-v.so",
+            "devices": [ "ofs0_pf", "ofs0_vf" ],
+            "configuration": { "key": "value" }
+          }
+        ]
+      }
+    }
+
+  },
+
+  "configs": [
+    "ofs"
+  ]
+}
+)json";
+
+const char *cache_cfg_json_short = R"json(
+{
+  "configurations": {
+
+    "ofs": {
+      "enabled": true,
+      "devices": [
+        { "name": "ofs0_pf", "id": [ "0x8086", "0xaf00", "0x8086", "0" ] }
+      ],
+
+      "opae": {
+        "plugin": [
+          {
+            "enabled": true,
+            "module": "libxfpga.so",
+            "devices": [ "ofs0_pf" ],
+            "configuration": {}
+          }
+        ]
+      }
+    }
+
+  },
+
+  "configs": [
+    "ofs"
+  ]
+}
+)json";
+
+class cfg_cache_c : public ::testing::Test {
+ protected:
+  cfg_cache_c() : saved_env_(false), mtime_(0) {}
+
+  virtual void SetUp() override {
+    char tmpl[] = "/tmp/opae-cfg-cache-XXXXXX";
+    ASSERT_NE((char *)NULL, mkdtemp(tmpl));
+    dir_ = tmpl;
+    cache_dir_ = dir_ + "/cache/opae";
+    cfg_ = dir_ + "/opae.cfg";
+
+    const char *env = getenv("LIBOPAE_CFGCACHE");
+    if (env) {
+      saved_env_ = true;
+      env_ = env;
+    }
+    setenv("LIBOPAE_CFGCACHE", cache_dir_.c_str(), 1);
+
+    // Old enough to be cached.
+    mtime_ = time(NULL) - 60;
+    write_cfg(cache_cfg_json, mtime_);
+  }
+
+  virtual void TearDown() override {
+    char path[PATH_MAX];
+
+    if (!opae_cfg_cache_path(cfg_.c_str(), path, sizeof(path)))
+      unlink(path);
+    rmdir(cache_dir_.c_str());
+    rmdir((dir_ + "/cache").c_str());
+    unlink(cfg_.c_str());
+    unlink((cfg_ + ".new").c_str());
+    rmdir(dir_.c_str());
+
+    if (saved_env_)
+      setenv("LIBOPAE_CFGCACHE", env_.c_str(), 1);
+    else
+      unsetenv("LIBOPAE_CFGCACHE");
+  }
+
+  void write_cfg(const char *json, time_t mtime,
+                 const std::string &file = std::string()) {
+    const std::string &f = file.empty() ? cfg_ : file;
+    FILE *fp = opae_fopen(f.c_str(), "w");
+    ASSERT_NE((FILE *)NULL, fp);
+    fwrite(json, 1, strlen(json), fp);
+    opae_fclose(fp);
+
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = mtime;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    ASSERT_EQ(0, utimensat(AT_FDCWD, f.c_str(), times, 0));
+  }
+
+  std::string cache_path() {
+    char path[PATH_MAX];
+    EXPECT_EQ(0, opae_cfg_cache_path(cfg_.c_str(), path, sizeof(path)));
+    return path;
+  }
+
+  bool cache_exists() {
+    struct stat st;
+    return !stat(cache_path().c_str(), &st);
+  }
+
+  libopae_config_data *load_cache() {
+    struct stat st;
+    EXPECT_EQ(0, opae_stat(cfg_.c_str(), &st));
+    return opae_cfg_cache_load(cfg_.c_str(), &st);
+  }
+
+  void patch_cache(off_t offset, const void *buf, size_t len) {
+    int fd = opae_open(cache_path().c_str(), O_WRONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ((ssize_t)len, pwrite(fd, buf, len, offset));
+    opae_close(fd);
+  }
+
+  int entries(const libopae_config_data *cfg) {
+    int n = 0;
+    while (cfg[n].module_library)
+      ++n;
+    return n;
+  }
+
+  void expect_equal(const libopae_config_data *a,
+                    const libopae_config_data *b) {
+    ASSERT_EQ(entries(a), entries(b));
+    for ( ; a->module_library ; ++a, ++b) {
+      EXPECT_EQ(a->vendor_id, b->vendor_id);
+      EXPECT_EQ(a->device_id, b->device_id);
+      EXPECT_EQ(a->subsystem_vendor_id, b->subsystem_vendor_id);
+      EXPECT_EQ(a->subsystem_device_id, b->subsystem_device_id);
+      EXPECT_STREQ(a->module_library, b->module_library);
+      EXPECT_STREQ(a->config_json, b->config_json);
+      EXPECT_EQ(a->flags, b->flags);
+    }
+  }
+
+  std::string dir_;
+  std::string cache_dir_;
+  std::string cfg_;
+  bool saved_env_;
+  std::string env_;
+  time_t mtime_;
+};
+
+/**
+ * @test       load0
+ * @brief      Test: opae_load_libopae_config
+ * @details    When there is no cache for the config file,<br>
+ *             then the function parses the config file,<br>
+ *             and writes a cache that yields the same table.
+ */
+TEST_F(cfg_cache_c, load0) {
+  EXPECT_FALSE(cache_exists());
+
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  ASSERT_NE(default_libopae_config_table, cfg);
+  EXPECT_EQ(3, entries(cfg));
+  EXPECT_TRUE(cache_exists());
+
+  libopae_config_data *cached = load_cache();
+  ASSERT_NE((libopae_config_data *)NULL, cached);
+  expect_equal(cfg, cached);
+  opae_free_libopae_config(cached);
+
+  cached = opae_load_libopae_config(cfg_.c_str());
+  expect_equal(cfg, cached);
+  opae_free_libopae_config(cached);
+
+  opae_free_libopae_config(cfg);
+}
+
+/**
+ * @test       stale_mtime
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the config file's mtime changes,<br>
+ *             then the cache is not used,<br>
+ *             and opae_load_libopae_config rewrites it.
+ */
+TEST_F(cfg_cache_c, stale_mtime) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  write_cfg(cache_cfg_json, mtime_ - 1);
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  EXPECT_EQ(3, entries(cfg));
+  opae_free_libopae_config(cfg);
+
+  cfg = load_cache();
+  ASSERT_NE((libopae_config_data *)NULL, cfg);
+  opae_free_libopae_config(cfg);
+}
+
+/**
+ * @test       stale_size
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the config file's size changes,<br>
+ *             even though its mtime is the same,<br>
+ *             then the new config file is parsed.
+ */
+TEST_F(cfg_cache_c, stale_size) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  write_cfg(cache_cfg_json_short, mtime_);
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  ASSERT_EQ(1, entries(cfg));
+  EXPECT_STREQ("libxfpga.so", cfg[0].module_library);
+  opae_free_libopae_config(cfg);
+}
+
+/**
+ * @test       stale_inode
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the config file is replaced by another file<br>
+ *             with the same size and mtime,<br>
+ *             then the cache is not used.
+ */
+TEST_F(cfg_cache_c, stale_inode) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  std::string tmp = cfg_ + ".new";
+  write_cfg(cache_cfg_json, mtime_, tmp);
+  ASSERT_EQ(0, rename(tmp.c_str(), cfg_.c_str()));
+
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+}
+
+/**
+ * @test       lib_version
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the cache was written by another library version,<br>
+ *             then the cache is not used.
+ */
+TEST_F(cfg_cache_c, lib_version) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  char version[OPAE_CFG_CACHE_LIBVER_LEN] = "0.0.0";
+  patch_cache(offsetof(opae_cfg_cache_header, lib_version),
+              version, sizeof(version));
+
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+}
+
+/**
+ * @test       layout_version
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the cache has another layout version,<br>
+ *             then the cache is not used.
+ */
+TEST_F(cfg_cache_c, layout_version) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  uint32_t version = OPAE_CFG_CACHE_VERSION + 1;
+  patch_cache(offsetof(opae_cfg_cache_header, version),
+              &version, sizeof(version));
+
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+}
+
+/**
+ * @test       checksum
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the cache contents are corrupt,<br>
+ *             then the cache is not used,<br>
+ *             and opae_load_libopae_config parses the config file.
+ */
+TEST_F(cfg_cache_c, checksum) {
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  ASSERT_TRUE(cache_exists());
+
+  uint16_t id = 0xdead;
+  patch_cache(sizeof(opae_cfg_cache_header) +
+              offsetof(opae_cfg_cache_entry, device_id),
+              &id, sizeof(id));
+
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+
+  libopae_config_data *reparsed = opae_load_libopae_config(cfg_.c_str());
+  expect_equal(cfg, reparsed);
+  opae_free_libopae_config(reparsed);
+  opae_free_libopae_config(cfg);
+}
+
+/**
+ * @test       permissions
+ * @brief      Test: opae_cfg_cache_load
+ * @details    When the cache is writable by other users,<br>
+ *             then the cache is not used.
+ */
+TEST_F(cfg_cache_c, permissions) {
+  opae_free_libopae_config(opae_load_libopae_config(cfg_.c_str()));
+  ASSERT_TRUE(cache_exists());
+
+  ASSERT_EQ(0, chmod(cache_path().c_str(), 0666));
+  EXPECT_EQ((libopae_config_data *)NULL, load_cache());
+}
+
+/**
+ * @test       recent
+ * @brief      Test: opae_load_libopae_config
+ * @details    When the config file was modified very recently,<br>
+ *             then the function parses it,<br>
+ *             but doesn't cache the result.
+ */
+TEST_F(cfg_cache_c, recent) {
+  write_cfg(cache_cfg_json, time(NULL));
+
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  EXPECT_EQ(3, entries(cfg));
+  EXPECT_FALSE(cache_exists());
+  opae_free_libopae_config(cfg);
+}
+
+/**
+ * @test       invalid
+ * @brief      Test: opae_load_libopae_config
+ * @details    When the config file can't be parsed,<br>
+ *             then the function returns the default table,<br>
+ *             and no cache is written.
+ */
+TEST_F(cfg_cache_c, invalid) {
+  write_cfg("{ not json", mtime_);
+
+  EXPECT_EQ(default_libopae_config_table,
+            opae_load_libopae_config(cfg_.c_str()));
+  EXPECT_FALSE(cache_exists());
+}
+
+/**
+ * @test       disabled
+ * @brief      Test: opae_cfg_cache_path
+ * @details    When LIBOPAE_CFGCACHE is "0",<br>
+ *             then there is no cache path,<br>
+ *             and opae_load_libopae_config still parses the config.
+ */
+TEST_F(cfg_cache_c, disabled) {
+  char path[PATH_MAX];
+
+  setenv("LIBOPAE_CFGCACHE", "0", 1);
+  EXPECT_NE(0, opae_cfg_cache_path(cfg_.c_str(), path, sizeof(path)));
+
+  libopae_config_data *cfg = opae_load_libopae_config(cfg_.c_str());
+  EXPECT_EQ(3, entries(cfg));
+  opae_free_libopae_config(cfg);
+
+  setenv("LIBOPAE_CFGCACHE", cache_dir_.c_str(), 1);
+  EXPECT_FALSE(cache_exists());
+}
+
+/**
+ * @test       no_cfg
+ * @brief      Test: opae_load_libopae_config
+ * @details    When cfgfile is NULL or doesn't exist,<br>
+ *             then the function returns the default table.
+ */
+TEST_F(cfg_cache_c, no_cfg) {
+  EXPECT_EQ(default_libopae_config_table, opae_load_libopae_config(NULL));
+  EXPECT_EQ(default_libopae_config_table,
+            opae_load_libopae_config("/does/not/exist/opae.cfg"));
+}
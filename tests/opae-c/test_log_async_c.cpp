@@ -0,0 +1,349 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+void opae_init(void);
+void opae_release(void);
+}
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log-async.h"
+#include "mock/opae_fixtures.h"
+
+using namespace opae::testing;
+
+class log_async_c_p : public ::testing::Test {
+ protected:
+  log_async_c_p() : fp_(nullptr), b_() {}
+
+  virtual void SetUp() override {
+    fp_ = tmpfile();
+    ASSERT_NE(fp_, nullptr);
+  }
+
+  virtual void TearDown() override {
+    log_async_stop(&b_);
+    if (fp_)
+      fclose(fp_);
+  }
+
+  void print(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list ap;
+    va_start(ap, fmt);
+    EXPECT_EQ(0, log_async_vprint(&b_, fp_, fmt, ap));
+    va_end(ap);
+  }
+
+  void expect(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    expected_ += buf;
+
+    va_start(ap, fmt);
+    EXPECT_EQ(0, log_async_vprint(&b_, fp_, fmt, ap));
+    va_end(ap);
+  }
+
+  std::string contents() {
+    std::string s;
+    char buf[4096];
+    size_t n;
+    log_async_flush(&b_);
+    rewind(fp_);
+    while ((n = fread(buf, 1, sizeof(buf), fp_)) > 0)
+      s.append(buf, n);
+    return s;
+  }
+
+  std::set<std::string> lines() {
+    std::set<std::string> l;
+    std::string s = contents();
+    size_t begin = 0;
+    size_t end;
+    while ((end = s.find('\n', begin)) != std::string::npos) {
+      l.insert(s.substr(begin, end - begin));
+      begin = end + 1;
+    }
+    return l;
+  }
+
+  FILE *fp_;
+  struct log_async b_;
+  std::string expected_;
+};
+
+/**
+ * @test       mode_from_env
+ * @brief      Test: log_async_mode_from_env
+ * @details    An unset or "0" LIBOPAE_LOG_ASYNC is synchronous,<br>
+ *             "binary" selects deferred formatting, and any other<br>
+ *             value selects text mode.<br>
+ */
+TEST(log_async_c, mode_from_env) {
+  EXPECT_EQ(LOG_ASYNC_SYNC, log_async_mode_from_env(nullptr));
+  EXPECT_EQ(LOG_ASYNC_SYNC, log_async_mode_from_env(""));
+  EXPECT_EQ(LOG_ASYNC_SYNC, log_async_mode_from_env("0"));
+  EXPECT_EQ(LOG_ASYNC_TEXT, log_async_mode_from_env("1"));
+  EXPECT_EQ(LOG_ASYNC_TEXT, log_async_mode_from_env("text"));
+  EXPECT_EQ(LOG_ASYNC_BINARY, log_async_mode_from_env("binary"));
+}
+
+/**
+ * @test       sync
+ * @brief      Test: log_async_vprint
+ * @details    When the backend has not been started,<br>
+ *             log_async_vprint returns non-zero so that the<br>
+ *             caller prints the message itself.<br>
+ */
+TEST_F(log_async_c_p, sync) {
+  auto vp = [this](const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int res = log_async_vprint(&b_, fp_, fmt, ap);
+    va_end(ap);
+    return res;
+  };
+  EXPECT_NE(0, vp("%d\n", 1));
+  EXPECT_EQ(0, log_async_start(&b_, LOG_ASYNC_SYNC));
+  EXPECT_NE(0, vp("%d\n", 2));
+  EXPECT_EQ("", contents());
+}
+
+/**
+ * @test       text_threads
+ * @brief      Test: log_async_start, log_async_vprint, log_async_stop
+ * @details    Given a backend in text mode,<br>
+ *             when several threads log concurrently,<br>
+ *             then every message is written whole, and the rings<br>
+ *             of the exited threads are freed by the writer.<br>
+ */
+TEST_F(log_async_c_p, text_threads) {
+  const int num_threads = 8;
+  const int num_msgs = 200;
+  std::vector<std::thread> threads;
+
+  ASSERT_EQ(0, log_async_start(&b_, LOG_ASYNC_TEXT));
+
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([this, t, num_msgs]() {
+      for (int m = 0; m < num_msgs; ++m)
+        print("thread %d message %d\n", t, m);
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  auto l = lines();
+  EXPECT_EQ(0u, log_async_dropped(&b_));
+  EXPECT_EQ(size_t(num_threads * num_msgs), l.size());
+  for (int t = 0; t < num_threads; ++t) {
+    for (int m = 0; m < num_msgs; ++m) {
+      std::string s = "thread " + std::to_string(t) +
+                      " message " + std::to_string(m);
+      EXPECT_EQ(1u, l.count(s)) << s;
+    }
+  }
+
+  EXPECT_EQ(nullptr, b_.rings);
+}
+
+/**
+ * @test       binary_format
+ * @brief      Test: log_async_vprint
+ * @details    Given a backend in binary mode,<br>
+ *             when messages are logged with a variety of<br>
+ *             conversions, flags and length modifiers,<br>
+ *             then the deferred output matches vsnprintf.<br>
+ */
+TEST_F(log_async_c_p, binary_format) {
+  char local[16] = "transient";
+  long double ld = 2.5;
+
+  ASSERT_EQ(0, log_async_start(&b_, LOG_ASYNC_BINARY));
+
+  expect("%d %i %u %x %X %o\n", -42, 17, 3000000000u, 0xbeef, 0xcafe, 8);
+  expect("%hhd %hd %hhu %hu\n", -1, -2, 255, 65535);
+  expect("%ld %lu %lld %llx\n", -1L, 1UL << 40, -(1LL << 62), ~0ULL);
+  expect("%zu %zd %jd %td\n", sizeof(local), (ssize_t)-7,
+         (intmax_t)INT64_MIN, (ptrdiff_t)-3);
+  expect("%5.2f|%e|%g|%a|%lf\n", 3.14159, 1e-9, 1e20, 0.5, -1.0);
+  expect("%c%c|%-10s|%.3s|%8s|\n", 'o', 'k', "left", "truncated", "right");
+  expect("%#08x %+d % d %-4d| %p\n", 0x1f, 5, 6, 7, (void *)&ld);
+  expect("100%% %s\n", "done");
+  expect("%s %s\n", __func__, local);
+  // Not encodable: these fall back to text.
+  expect("%*d|%.*s\n", 6, 9, 2, "abc");
+  expect("%Lf\n", ld);
+  expect("%2$s %1$s\n", "world", "hello");
+  expect("no conversions\n");
+
+  // Strings are copied when logged.
+  local[0] = '\0';
+
+  EXPECT_EQ(expected_, contents());
+  EXPECT_EQ(0u, log_async_dropped(&b_));
+}
+
+/**
+ * @test       overflow
+ * @brief      Test: log_async_vprint, log_async_dropped
+ * @details    When a thread logs faster than the writer drains,<br>
+ *             then messages that don't fit are dropped and counted<br>
+ *             rather than blocking the caller, and the ones that<br>
+ *             fit are written intact.<br>
+ */
+TEST_F(log_async_c_p, overflow) {
+  const int num_msgs = 4096;
+  std::string pad(100, 'x');
+
+  ASSERT_EQ(0, log_async_start(&b_, LOG_ASYNC_TEXT));
+
+  // Hold off the writer while the ring fills.
+  pthread_mutex_lock(&b_.drain_lock);
+  for (int m = 0; m < num_msgs; ++m)
+    print("%04d %s\n", m, pad.c_str());
+  pthread_mutex_unlock(&b_.drain_lock);
+
+  uint64_t dropped = log_async_dropped(&b_);
+  EXPECT_GT(dropped, 0u);
+
+  auto l = lines();
+  EXPECT_EQ(size_t(num_msgs), l.size() + dropped);
+  for (auto s : l)
+    EXPECT_EQ(105u, s.size()) << s;
+
+  // The ring is usable again once drained.
+  print("after\n");
+  EXPECT_EQ(1u, lines().count("after"));
+  EXPECT_EQ(dropped, log_async_dropped(&b_));
+}
+
+/**
+ * @test       long_message
+ * @brief      Test: log_async_vprint
+ * @details    A message too long to queue is left to the caller.<br>
+ */
+TEST_F(log_async_c_p, long_message) {
+  std::string big(8192, 'y');
+  auto vp = [this](const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int res = log_async_vprint(&b_, fp_, fmt, ap);
+    va_end(ap);
+    return res;
+  };
+
+  ASSERT_EQ(0, log_async_start(&b_, LOG_ASYNC_TEXT));
+  EXPECT_NE(0, vp("%s\n", big.c_str()));
+  EXPECT_EQ("", contents());
+}
+
+/**
+ * @test       stop_while_logging
+ * @brief      Test: log_async_stop
+ * @details    Given threads that keep logging while the backend<br>
+ *             is stopped, when their messages can no longer be<br>
+ *             queued they print them themselves, and no message<br>
+ *             is lost.<br>
+ */
+TEST_F(log_async_c_p, stop_while_logging) {
+  const int num_threads = 4;
+  const int num_msgs = 2000;
+  std::vector<std::thread> threads;
+  std::atomic<int> started(0);
+  auto log = [this](const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    if (log_async_vprint(&b_, fp_, fmt, ap))
+      vfprintf(fp_, fmt, ap);
+    va_end(ap);
+  };
+
+  ASSERT_EQ(0, log_async_start(&b_, LOG_ASYNC_TEXT));
+
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&log, &started, t, num_msgs]() {
+      for (int m = 0; m < num_msgs; ++m) {
+        log("thread %d message %d\n", t, m);
+        if (!m)
+          ++started;
+      }
+    });
+  }
+
+  while (started < num_threads)
+    std::this_thread::yield();
+  log_async_stop(&b_);
+  for (auto &t : threads)
+    t.join();
+
+  EXPECT_EQ(size_t(num_threads * num_msgs),
+            lines().size() + log_async_dropped(&b_));
+}
+
+/**
+ * @test       opae_print
+ * @brief      Test: opae_init, opae_print, opae_release
+ * @details    When LIBOPAE_LOG_ASYNC is set,<br>
+ *             then messages are written by the background writer<br>
+ *             by the time opae_release returns, and errors are<br>
+ *             still written synchronously.<br>
+ */
+TEST(log_async_c, opae_print) {
+  ASSERT_EQ(0, putenv((char *)"LIBOPAE_LOG=1"));
+  ASSERT_EQ(0, putenv((char *)"LIBOPAE_LOG_ASYNC=binary"));
+  opae_init();
+  testing::internal::CaptureStdout();
+  testing::internal::CaptureStderr();
+
+  OPAE_ERR("Error log %d.", 1);
+  OPAE_MSG("Message log %d.", 2);
+
+  opae_release();
+
+  std::string log_stdout = testing::internal::GetCapturedStdout();
+  std::string log_stderr = testing::internal::GetCapturedStderr();
+
+  EXPECT_NE(std::string::npos, log_stderr.find("Error log 1."));
+  EXPECT_NE(std::string::npos, log_stdout.find("Message log 2."));
+
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG_ASYNC"));
+  EXPECT_EQ(0, unsetenv("LIBOPAE_LOG"));
+}
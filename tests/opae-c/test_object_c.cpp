@@ -83,6 +83,42 @@ TEST_P(object_c_p, obj_read) {
   EXPECT_STREQ(power_state, "0x0\n");
 }
 
+/**
+ * @test       obj_readv
+ * @brief      Test: fpgaObjectReadv
+ * @details    When fpgaObjectReadv is called with valid params,<br>
+ *             the fn fills each window from the targeted object<br>
+ *             and returns FPGA_OK.<br>
+ */
+TEST_P(object_c_p, obj_readv) {
+  uint8_t a[2] = { 0, };
+  uint8_t b[2] = { 0, };
+  fpga_object_window windows[] = {
+    { a, 0, sizeof(a) },
+    { b, 2, sizeof(b) },
+  };
+  EXPECT_EQ(fpgaObjectReadv(handle_obj_, windows, 2, FPGA_OBJECT_SYNC),
+            FPGA_OK);
+  EXPECT_EQ(0, memcmp(a, "0x", 2));
+  EXPECT_EQ(0, memcmp(b, "0\n", 2));
+  EXPECT_EQ(fpgaObjectReadv(handle_obj_, NULL, 2, 0), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       obj_read_group
+ * @brief      Test: fpgaObjectReadGroup
+ * @details    When fpgaObjectReadGroup is called with a file object,<br>
+ *             or with NULL values, the fn returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(object_c_p, obj_read_group) {
+  fpga_object_value values[1];
+  size_t changed = 0;
+  EXPECT_EQ(fpgaObjectReadGroup(handle_obj_, values, 1, &changed, 0),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaObjectReadGroup(handle_obj_, NULL, 1, &changed, 0),
+            FPGA_INVALID_PARAM);
+}
+
 /**
  * @test       obj_read64
  * @brief      Test: fpgaObjectRead64
@@ -28,10 +28,16 @@
 #endif // HAVE_CONFIG_H
 
 #include <array>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
 
 extern "C" {
 #include "opae_int.h"
 #include "pluginmgr.h"
+#include "cfg-file.h"
+#include "mock/opae_std.h"
 
 int opae_plugin_mgr_initialize_all(void);
 void *opae_plugin_mgr_find_plugin(const char *lib_path);
@@ -46,6 +52,8 @@ int process_cfg_buffer(const char *buffer, const char *filename);
 extern opae_api_adapter_table *adapter_list;
 extern int finalizing;
 int opae_plugin_mgr_finalize_all(void);
+extern libopae_config_data *platform_data_table;
+int opae_plugin_mgr_detect_platforms(bool with_ase);
 }
 
 #include "mock/opae_fixtures.h"
@@ -319,6 +327,173 @@ TEST_P(pluginmgr_mock_c_p, register_plugin02) {
   opae_plugin_mgr_finalize_all();
 }
 
+struct pci_function_ids {
+  uint16_t vendor_id;
+  uint16_t device_id;
+  uint16_t subsystem_vendor_id;
+  uint16_t subsystem_device_id;
+  bool has_uevent;
+};
+
+static uint16_t read_pci_id(const std::string &path)
+{
+  unsigned id = 0;
+  FILE *fp = opae_fopen(path.c_str(), "r");
+
+  EXPECT_NE(nullptr, fp);
+  if (fp) {
+    EXPECT_EQ(1, fscanf(fp, "%x", &id));
+    opae_fclose(fp);
+  }
+
+  return (uint16_t)id;
+}
+
+// Collect the IDs of the PCI functions in sysfs from the
+// vendor, device, subsystem_vendor and subsystem_device files.
+static std::vector<pci_function_ids> read_pci_functions()
+{
+  const std::string base = "/sys/bus/pci/devices";
+  std::vector<pci_function_ids> functions;
+  struct dirent *dirent;
+  DIR *dir = opae_opendir(base.c_str());
+
+  EXPECT_NE(nullptr, dir);
+  if (!dir)
+    return functions;
+
+  while ((dirent = readdir(dir)) != nullptr) {
+    if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+      continue;
+
+    std::string path = base + "/" + dirent->d_name;
+    pci_function_ids ids;
+
+    ids.vendor_id = read_pci_id(path + "/vendor");
+    ids.device_id = read_pci_id(path + "/device");
+    ids.subsystem_vendor_id = read_pci_id(path + "/subsystem_vendor");
+    ids.subsystem_device_id = read_pci_id(path + "/subsystem_device");
+    ids.has_uevent = !opae_access((path + "/uevent").c_str(), R_OK);
+
+    functions.push_back(ids);
+  }
+
+  opae_closedir(dir);
+  return functions;
+}
+
+static bool platform_matches(const libopae_config_data &cfg,
+                             const pci_function_ids &ids)
+{
+  return (cfg.vendor_id == ids.vendor_id) &&
+         (cfg.device_id == ids.device_id) &&
+         ((cfg.subsystem_vendor_id == OPAE_VENDOR_ANY) ||
+          (cfg.subsystem_vendor_id == ids.subsystem_vendor_id)) &&
+         ((cfg.subsystem_device_id == OPAE_DEVICE_ANY) ||
+          (cfg.subsystem_device_id == ids.subsystem_device_id));
+}
+
+/**
+ * @test       detect_platforms01
+ * @brief      Test: opae_plugin_mgr_detect_platforms
+ * @details    Each platform table entry is detected when a PCI function<br>
+ *             in sysfs has matching IDs. Functions that have a uevent file<br>
+ *             are identified with one file open. Otherwise the ID files<br>
+ *             are read, stopping after 'vendor' for unknown vendors.<br>
+ */
+TEST_P(pluginmgr_mock_c_p, detect_platforms01) {
+  std::vector<pci_function_ids> functions = read_pci_functions();
+  ASSERT_GT(functions.size(), 0u);
+
+  const pci_function_ids &first = functions[0];
+  std::vector<libopae_config_data> table;
+
+  // One exact entry per function, listed in reverse so that the
+  // index must reorder them.
+  for (auto it = functions.rbegin() ; it != functions.rend() ; ++it) {
+    table.push_back({ it->vendor_id, it->device_id,
+                      it->subsystem_vendor_id, it->subsystem_device_id,
+                      "libexact.so", "{}", 0 });
+  }
+  table.push_back({ first.vendor_id, first.device_id,
+                    OPAE_VENDOR_ANY, OPAE_DEVICE_ANY,
+                    "libany.so", "{}", 0 });
+  table.push_back({ first.vendor_id, first.device_id,
+                    first.subsystem_vendor_id,
+                    (uint16_t)(first.subsystem_device_id ^ 0x5a5a),
+                    "libothersub.so", "{}", 0 });
+  table.push_back({ 0x1d1d, 0x1d1d, OPAE_VENDOR_ANY, OPAE_DEVICE_ANY,
+                    "libnone.so", "{}", 0 });
+  table.push_back({ 0, 0, 0, 0, nullptr, nullptr, 0 });
+
+  libopae_config_data *saved = platform_data_table;
+  platform_data_table = table.data();
+
+  system_->reset_opens();
+  EXPECT_EQ(0, opae_plugin_mgr_detect_platforms(false));
+  uint32_t opens = system_->opens();
+
+  platform_data_table = saved;
+
+  uint32_t expected_opens = 0;
+  for (const auto &f : functions) {
+    // uevent, or uevent + vendor + device + subsystem IDs.
+    expected_opens += f.has_uevent ? 1 : 5;
+  }
+  EXPECT_EQ(expected_opens, opens);
+
+  for (size_t i = 0 ; table[i].module_library ; ++i) {
+    bool expected = false;
+    for (const auto &f : functions) {
+      if (platform_matches(table[i], f))
+        expected = true;
+    }
+    EXPECT_EQ(expected,
+              (table[i].flags & OPAE_PLATFORM_DATA_DETECTED) != 0) <<
+      table[i].module_library << " 0x" << std::hex <<
+      table[i].vendor_id << ":0x" << table[i].device_id << " 0x" <<
+      table[i].subsystem_vendor_id << ":0x" << table[i].subsystem_device_id;
+  }
+  EXPECT_EQ(0u, table[table.size() - 2].flags);
+}
+
+/**
+ * @test       detect_platforms02
+ * @brief      Test: opae_plugin_mgr_detect_platforms
+ * @details    When no platform has the vendor ID of a PCI function<br>
+ *             without a uevent file, only its 'vendor' file is read.<br>
+ *             An empty platform table needs no reads at all.<br>
+ */
+TEST_P(pluginmgr_mock_c_p, detect_platforms02) {
+  std::vector<pci_function_ids> functions = read_pci_functions();
+  ASSERT_GT(functions.size(), 0u);
+
+  libopae_config_data table[] = {
+    { 0x1d1d, 0x1d1d, OPAE_VENDOR_ANY, OPAE_DEVICE_ANY, "libnone.so", "{}", 0 },
+    { 0, 0, 0, 0, nullptr, nullptr, 0 }
+  };
+
+  libopae_config_data *saved = platform_data_table;
+  platform_data_table = table;
+
+  system_->reset_opens();
+  EXPECT_EQ(0, opae_plugin_mgr_detect_platforms(false));
+
+  uint32_t expected_opens = 0;
+  for (const auto &f : functions) {
+    expected_opens += f.has_uevent ? 1 : 2;
+  }
+  EXPECT_EQ(expected_opens, system_->opens());
+  EXPECT_EQ(0u, table[0].flags);
+
+  platform_data_table = &table[1];
+  system_->reset_opens();
+  EXPECT_EQ(0, opae_plugin_mgr_detect_platforms(false));
+  EXPECT_EQ(0u, system_->opens());
+
+  platform_data_table = saved;
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(pluginmgr_mock_c_p);
 INSTANTIATE_TEST_SUITE_P(pluginmgr_c, pluginmgr_mock_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({})));
@@ -0,0 +1,383 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+void opae_init(void);
+void opae_release(void);
+extern int telemetry_enabled;
+}
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "telemetry-shm.h"
+#include "mock/opae_fixtures.h"
+
+using namespace opae::testing;
+
+class telemetry_shm_c_p : public ::testing::Test {
+ protected:
+  telemetry_shm_c_p() : w_() {}
+
+  virtual void SetUp() override {
+    name_ = "/opae-telemetry-test-" + std::to_string(getpid());
+    ASSERT_EQ(0, telemetry_writer_open(&w_, name_.c_str(), 1000000000ULL));
+  }
+
+  virtual void TearDown() override {
+    telemetry_writer_close(&w_);
+    telemetry_reader_release_all();
+  }
+
+  void add_metrics(const uint64_t *nums, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      w_.shm->metric[i].metric_num = nums[i];
+      snprintf(w_.shm->metric[i].name, sizeof(w_.shm->metric[i].name),
+               "metric%lu", nums[i]);
+    }
+    w_.shm->num_metrics = count;
+  }
+
+  void publish(uint64_t value, uint32_t count) {
+    telemetry_sample *sample = telemetry_writer_begin(&w_);
+    for (uint32_t i = 0; i < count; ++i) {
+      sample->metrics[i].ivalue = value + i;
+      sample->metric_valid[i / 8] |= 1 << (i % 8);
+    }
+    telemetry_writer_end(&w_);
+  }
+
+  std::string name_;
+  telemetry_writer w_;
+};
+
+/**
+ * @test       shm_name
+ * @brief      Test: telemetry_shm_name
+ * @details    The segment name is formed from the device's
+ *             PCIe address.<br>
+ */
+TEST(telemetry_shm_c, shm_name) {
+  char name[TELEMETRY_SHM_NAME_MAX];
+  telemetry_shm_name(name, sizeof(name), 0, 0x3b, 0, 1);
+  EXPECT_STREQ("/opae-telemetry-0000:3b:00.1", name);
+}
+
+/**
+ * @test       open_close
+ * @brief      Test: telemetry_writer_open, telemetry_shm_open
+ * @details    The writer creates a world-readable segment that
+ *             readers can map, and removes it on close.<br>
+ */
+TEST_F(telemetry_shm_c_p, open_close) {
+  struct stat st;
+  std::string path = "/dev/shm" + name_;
+  ASSERT_EQ(0, stat(path.c_str(), &st));
+  EXPECT_EQ(0644, st.st_mode & 0777);
+
+  ino_t inode = 0;
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), &inode);
+  ASSERT_NE(nullptr, shm);
+  EXPECT_EQ(st.st_ino, inode);
+  EXPECT_EQ(TELEMETRY_MAGIC, shm->magic);
+  EXPECT_EQ(getpid(), shm->writer_pid);
+  EXPECT_EQ(0u, shm->updates);
+  telemetry_shm_close(shm);
+
+  telemetry_writer_close(&w_);
+  EXPECT_NE(0, stat(path.c_str(), &st));
+  EXPECT_EQ(nullptr, telemetry_shm_open(name_.c_str(), nullptr));
+}
+
+/**
+ * @test       untrusted
+ * @brief      Test: telemetry_shm_open
+ * @details    A segment that group or other can write, or that
+ *             another user owns, is not mapped.<br>
+ */
+TEST_F(telemetry_shm_c_p, untrusted) {
+  std::string path = "/dev/shm" + name_;
+
+  ASSERT_EQ(0, chmod(path.c_str(), 0666));
+  EXPECT_EQ(nullptr, telemetry_shm_open(name_.c_str(), nullptr));
+
+  ASSERT_EQ(0, chmod(path.c_str(), 0644));
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), nullptr);
+  EXPECT_NE(nullptr, shm);
+  telemetry_shm_close(shm);
+
+  if (geteuid() == 0) {
+    ASSERT_EQ(0, chown(path.c_str(), 65534, (gid_t)-1));
+    EXPECT_EQ(nullptr, telemetry_shm_open(name_.c_str(), nullptr));
+  }
+}
+
+/**
+ * @test       bad_segment
+ * @brief      Test: telemetry_shm_open
+ * @details    A segment that is too small or lacks the magic
+ *             is not mapped.<br>
+ */
+TEST(telemetry_shm_c, bad_segment) {
+  std::string name = "/opae-telemetry-bad-" + std::to_string(getpid());
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+  ASSERT_GE(fd, 0);
+
+  ASSERT_EQ(0, ftruncate(fd, 64));
+  EXPECT_EQ(nullptr, telemetry_shm_open(name.c_str(), nullptr));
+
+  ASSERT_EQ(0, ftruncate(fd, sizeof(telemetry_shm)));
+  EXPECT_EQ(nullptr, telemetry_shm_open(name.c_str(), nullptr));
+
+  close(fd);
+  shm_unlink(name.c_str());
+}
+
+/**
+ * @test       read_metrics
+ * @brief      Test: telemetry_read_metrics
+ * @details    Metrics are found by metric number in any order,
+ *             and the latest sample is returned.<br>
+ */
+TEST_F(telemetry_shm_c_p, read_metrics) {
+  const uint64_t nums[] = { 0, 1, 5 };
+  add_metrics(nums, 3);
+
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), nullptr);
+  ASSERT_NE(nullptr, shm);
+
+  uint64_t want[] = { 5, 0 };
+  fpga_metric metrics[2];
+  // Nothing has been published yet.
+  EXPECT_NE(0, telemetry_read_metrics(shm, want, 2, metrics, 0));
+
+  publish(100, 3);
+  publish(200, 2);
+
+  ASSERT_EQ(0, telemetry_read_metrics(shm, want, 2, metrics, 0));
+  EXPECT_EQ(5u, metrics[0].metric_num);
+  EXPECT_FALSE(metrics[0].isvalid);
+  EXPECT_EQ(0u, metrics[1].metric_num);
+  EXPECT_TRUE(metrics[1].isvalid);
+  EXPECT_EQ(200u, metrics[1].value.ivalue);
+
+  uint64_t missing[] = { 0, 7 };
+  EXPECT_NE(0, telemetry_read_metrics(shm, missing, 2, metrics, 0));
+
+  telemetry_shm_close(shm);
+}
+
+/**
+ * @test       stale
+ * @brief      Test: telemetry_read_metrics
+ * @details    A sample older than max_age_ns is not served.<br>
+ */
+TEST_F(telemetry_shm_c_p, stale) {
+  const uint64_t nums[] = { 0 };
+  add_metrics(nums, 1);
+  publish(1, 1);
+
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), nullptr);
+  ASSERT_NE(nullptr, shm);
+
+  uint64_t want = 0;
+  fpga_metric metric;
+  EXPECT_EQ(0, telemetry_read_metrics(shm, &want, 1, &metric, 0));
+  usleep(2000);
+  EXPECT_NE(0, telemetry_read_metrics(shm, &want, 1, &metric, 1000000));
+
+  telemetry_shm_close(shm);
+}
+
+/**
+ * @test       history
+ * @brief      Test: telemetry_read_history
+ * @details    The most recent TELEMETRY_HISTORY samples are
+ *             returned newest first.<br>
+ */
+TEST_F(telemetry_shm_c_p, history) {
+  const uint64_t nums[] = { 3, 4 };
+  add_metrics(nums, 2);
+
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), nullptr);
+  ASSERT_NE(nullptr, shm);
+
+  for (uint64_t i = 0; i < TELEMETRY_HISTORY + 8; ++i)
+    publish(i, 2);
+
+  uint64_t timestamps[TELEMETRY_HISTORY * 2];
+  metric_value values[TELEMETRY_HISTORY * 2];
+  uint32_t count = TELEMETRY_HISTORY * 2;
+  ASSERT_EQ(0, telemetry_read_history(shm, 4, timestamps, values, &count));
+  ASSERT_EQ((uint32_t)TELEMETRY_HISTORY, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    EXPECT_EQ((uint64_t)TELEMETRY_HISTORY + 8 - i, values[i].ivalue);
+    if (i) {
+      EXPECT_LE(timestamps[i], timestamps[i - 1]);
+    }
+  }
+
+  count = 4;
+  ASSERT_EQ(0, telemetry_read_history(shm, 3, timestamps, values, &count));
+  EXPECT_EQ(4u, count);
+  EXPECT_EQ((uint64_t)TELEMETRY_HISTORY + 7, values[0].ivalue);
+
+  EXPECT_NE(0, telemetry_read_history(shm, 9, timestamps, values, &count));
+
+  telemetry_shm_close(shm);
+}
+
+/**
+ * @test       seqlock
+ * @brief      Test: telemetry_read_metrics
+ * @details    A reader racing with the writer always sees the
+ *             metrics of a single sample.<br>
+ */
+TEST_F(telemetry_shm_c_p, seqlock) {
+  const uint64_t nums[] = { 0, 1, 2, 3 };
+  add_metrics(nums, 4);
+  telemetry_sample *first = telemetry_writer_begin(&w_);
+  for (uint32_t j = 0; j < 4; ++j) {
+    first->metrics[j].ivalue = 0;
+    first->metric_valid[0] |= 1 << j;
+  }
+  telemetry_writer_end(&w_);
+
+  const telemetry_shm *shm = telemetry_shm_open(name_.c_str(), nullptr);
+  ASSERT_NE(nullptr, shm);
+
+  std::atomic<bool> done(false);
+  std::atomic<uint64_t> reads(0);
+  uint64_t published = 0;
+  std::thread writer([&] {
+    uint64_t i;
+    for (i = 1; (reads < 1000) && (i < 2000000); ++i) {
+      telemetry_sample *sample = telemetry_writer_begin(&w_);
+      for (uint32_t j = 0; j < 4; ++j) {
+        sample->metrics[j].ivalue = i;
+        sample->metric_valid[0] |= 1 << j;
+      }
+      telemetry_writer_end(&w_);
+    }
+    published = i - 1;
+    done = true;
+  });
+
+  uint64_t last = 0;
+  uint64_t want[] = { 3, 2, 1, 0 };
+  fpga_metric metrics[4];
+  while (!done) {
+    if (telemetry_read_metrics(shm, want, 4, metrics, 0))
+      continue;
+    ++reads;
+    for (uint32_t j = 1; j < 4; ++j)
+      ASSERT_EQ(metrics[0].value.ivalue, metrics[j].value.ivalue);
+    EXPECT_GE(metrics[0].value.ivalue, last);
+    last = metrics[0].value.ivalue;
+  }
+  writer.join();
+
+  ASSERT_EQ(0, telemetry_read_metrics(shm, want, 4, metrics, 0));
+  EXPECT_EQ(published, metrics[0].value.ivalue);
+  telemetry_shm_close(shm);
+}
+
+/**
+ * @test       reader
+ * @brief      Test: telemetry_reader_get, telemetry_reader_read
+ * @details    Readers are cached per device and attach to the
+ *             device's segment, but never to a segment published
+ *             by the calling process.<br>
+ */
+TEST(telemetry_shm_c, reader) {
+  char name[TELEMETRY_SHM_NAME_MAX];
+  telemetry_writer w;
+  const uint64_t nums[] = { 0, 1 };
+  uint64_t want[] = { 1 };
+  fpga_metric metric;
+
+  telemetry_shm_name(name, sizeof(name), 0xfffe, 0xff, 0x1f, 7);
+  ASSERT_EQ(0, telemetry_writer_open(&w, name, 1000000000ULL));
+  w.shm->metric[0].metric_num = nums[0];
+  w.shm->metric[1].metric_num = nums[1];
+  w.shm->num_metrics = 2;
+
+  telemetry_sample *sample = telemetry_writer_begin(&w);
+  sample->metrics[1].ivalue = 42;
+  sample->metric_valid[0] = 3;
+  telemetry_writer_end(&w);
+
+  // Published by this process: ignored.
+  struct telemetry_reader *r = telemetry_reader_get(0xfffe, 0xff, 0x1f, 7);
+  ASSERT_NE(nullptr, r);
+  EXPECT_EQ(r, telemetry_reader_get(0xfffe, 0xff, 0x1f, 7));
+  EXPECT_NE(0, telemetry_reader_read(r, want, 1, &metric));
+  telemetry_reader_release_all();
+
+  // Published by another process.
+  w.shm->writer_pid = getpid() + 1;
+  r = telemetry_reader_get(0xfffe, 0xff, 0x1f, 7);
+  ASSERT_NE(nullptr, r);
+  ASSERT_EQ(0, telemetry_reader_read(r, want, 1, &metric));
+  EXPECT_EQ(1u, metric.metric_num);
+  EXPECT_TRUE(metric.isvalid);
+  EXPECT_EQ(42u, metric.value.ivalue);
+
+  // The segment is gone, but its last sample is still current.
+  telemetry_writer_close(&w);
+  EXPECT_EQ(0, telemetry_reader_read(r, want, 1, &metric));
+  telemetry_reader_release_all();
+  EXPECT_NE(0, telemetry_reader_read(
+    telemetry_reader_get(0xfffe, 0xff, 0x1f, 7), want, 1, &metric));
+  telemetry_reader_release_all();
+}
+
+/**
+ * @test       disabled
+ * @brief      Test: telemetry_reader_get
+ * @details    LIBOPAE_TELEMETRY=0 disables telemetry reads.<br>
+ */
+TEST(telemetry_shm_c, disabled) {
+  telemetry_enabled = -1;
+  setenv("LIBOPAE_TELEMETRY", "0", 1);
+  EXPECT_EQ(nullptr, telemetry_reader_get(0, 0x3b, 0, 0));
+  unsetenv("LIBOPAE_TELEMETRY");
+  EXPECT_EQ(nullptr, telemetry_reader_get(0, 0x3b, 0, 0));
+
+  telemetry_enabled = -1;
+  EXPECT_NE(nullptr, telemetry_reader_get(0, 0x3b, 0, 0));
+  telemetry_reader_release_all();
+}
@@ -30,9 +30,11 @@
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
 
+#include <opae/cxx/core/buffer_ops.h>
 #include <opae/cxx/core/handle.h>
 #include <opae/cxx/core/properties.h>
 #include <opae/cxx/core/shared_buffer.h>
+#include <opae/cxx/core/sva_allocator.h>
 #include <opae/cxx/core/token.h>
 #include "common_int.h"
 
@@ -114,6 +116,36 @@ TEST_P(buffer_cxx_core, allocate_valid) {
   EXPECT_EQ(0, buf->c_type());
 }
 
+/**
+ * @test shared_buffer::allocate_placement
+ * Calling shared_buffer::allocate with each NUMA placement should
+ * return a shared buffer. placement::node requires a valid node.
+ */
+TEST_P(buffer_cxx_core, allocate_placement) {
+  size_t length = 4096;
+  shared_buffer::ptr_t buf;
+
+  for (auto where : { shared_buffer::placement::device,
+                      shared_buffer::placement::any,
+                      shared_buffer::placement::interleave }) {
+    ASSERT_NO_THROW(buf = shared_buffer::allocate(handle_, length,
+                                                  false, where));
+    ASSERT_NE(nullptr, buf);
+    EXPECT_EQ(length, buf->size());
+    buf.reset();
+  }
+
+  ASSERT_NO_THROW(buf = shared_buffer::allocate(handle_, length, false,
+                                                shared_buffer::placement::node,
+                                                0));
+  ASSERT_NE(nullptr, buf);
+  buf.reset();
+
+  EXPECT_THROW(shared_buffer::allocate(handle_, length, false,
+                                       shared_buffer::placement::node),
+               invalid_param);
+}
+
 /**
  * @test shared_buffer::attach_no_len
  * Calling shared_buffer::attach with buffer length = 0 should throw
@@ -212,6 +244,335 @@ TEST_P(buffer_cxx_core, read_write) {
   EXPECT_EQ(0xdecafbad, buf->read<uint32_t>(0));
 }
 
+/**
+ * @test shared_buffer::fill_pattern
+ * Calling shared_buffer::fill with a pattern fills the buffer
+ * with data that depends only on the pattern and the seed.
+ */
+TEST_P(buffer_cxx_core, fill_pattern) {
+  size_t length = 4096;
+  shared_buffer::ptr_t buf1;
+  shared_buffer::ptr_t buf2;
+
+  ASSERT_NO_THROW(buf1 = shared_buffer::allocate(handle_, length));
+  ASSERT_NE(nullptr, buf1.get());
+  ASSERT_NO_THROW(buf2 = shared_buffer::allocate(handle_, length));
+  ASSERT_NE(nullptr, buf2.get());
+
+  buf1->fill(shared_buffer::pattern::incrementing, 0x10);
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_EQ(buf1->read<uint8_t>(i), static_cast<uint8_t>(0x10 + i));
+  }
+
+  buf1->fill(shared_buffer::pattern::random, 42);
+  buf2->fill(shared_buffer::pattern::random, 42);
+  EXPECT_EQ(buf1->compare(buf2, length), 0);
+  buf2->fill(shared_buffer::pattern::random, 43);
+  EXPECT_NE(buf1->compare(buf2, length), 0);
+
+  buf1->fill(shared_buffer::pattern::prbs31, 0x7fffffff);
+  buf2->fill(shared_buffer::pattern::prbs31, 0x7fffffff);
+  EXPECT_EQ(buf1->compare(buf2, length), 0);
+  EXPECT_EQ(buf1->read<uint8_t>(0), 0x00);
+}
+
+/**
+ * @test shared_buffer::compare_detail
+ * Calling shared_buffer::compare_detail returns the offset of
+ * the first differing byte and the number of differing bytes.
+ */
+TEST_P(buffer_cxx_core, compare_detail) {
+  size_t length = 4096;
+  shared_buffer::ptr_t buf1;
+  shared_buffer::ptr_t buf2;
+
+  ASSERT_NO_THROW(buf1 = shared_buffer::allocate(handle_, length));
+  ASSERT_NE(nullptr, buf1.get());
+  ASSERT_NO_THROW(buf2 = shared_buffer::allocate(handle_, length));
+  ASSERT_NE(nullptr, buf2.get());
+
+  buf1->fill(shared_buffer::pattern::random, 7);
+  buf2->fill(shared_buffer::pattern::random, 7);
+
+  auto r = buf1->compare_detail(buf2, length);
+  EXPECT_EQ(r.first_mismatch, length);
+  EXPECT_EQ(r.mismatches, 0);
+
+  buf2->write<uint8_t>(~buf1->read<uint8_t>(100), 100);
+  buf2->write<uint8_t>(~buf1->read<uint8_t>(4095), 4095);
+
+  r = buf1->compare_detail(buf2, length);
+  EXPECT_EQ(r.first_mismatch, 100);
+  EXPECT_EQ(r.mismatches, 2);
+
+  EXPECT_THROW(buf1->compare_detail(buf2, length + 1), except);
+}
+
+/**
+ * @test shared_buffer::crc32c
+ * Calling shared_buffer::crc32c returns the CRC-32C of the
+ * requested range.
+ */
+TEST_P(buffer_cxx_core, crc32c) {
+  shared_buffer::ptr_t buf;
+  const char *check = "123456789";
+
+  ASSERT_NO_THROW(buf = shared_buffer::allocate(handle_, 4096));
+  ASSERT_NE(nullptr, buf.get());
+
+  buf->fill(0);
+  for (size_t i = 0; i < 9; ++i) {
+    buf->write<char>(check[i], 16 + i);
+  }
+
+  EXPECT_EQ(buf->crc32c(16, 9), 0xe3069283);
+  EXPECT_EQ(buf->crc32c(), buffer_ops::crc32c(
+              const_cast<uint8_t *>(buf->c_type()), 4096));
+  EXPECT_THROW(buf->crc32c(4000, 100), except);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(buffer_cxx_core);
 INSTANTIATE_TEST_SUITE_P(buffer, buffer_cxx_core,
                          ::testing::ValuesIn(test_platform::platforms({})));
+
+/**
+ * @test shared_buffer::wait_for
+ * Calling shared_buffer::wait_for returns true once the masked
+ * value matches, returns false after the timeout when it does
+ * not, and throws for an offset outside the buffer.
+ */
+TEST_P(buffer_cxx_core, wait_for) {
+  shared_buffer::ptr_t buf;
+  buffer_ops::wait_stats stats;
+
+  ASSERT_NO_THROW(buf = shared_buffer::allocate(handle_, 64));
+  ASSERT_NE(nullptr, buf.get());
+  buf->fill(0);
+
+  buf->write<uint32_t>(0x80000001, 8);
+  EXPECT_TRUE(buf->wait_for<uint32_t>(8, 0x1, 0x1,
+                                      std::chrono::milliseconds(1), &stats));
+  EXPECT_EQ(stats.wakeups, 0);
+
+  EXPECT_FALSE(buf->wait_for<uint32_t>(8, 0x2, 0x2,
+                                       std::chrono::milliseconds(2), &stats));
+  EXPECT_GE(stats.latency, std::chrono::milliseconds(2));
+
+  EXPECT_THROW(buf->wait_for<uint64_t>(60, 1, 1,
+                                       std::chrono::milliseconds(1)),
+               except);
+}
+
+/**
+ * @test sva_memory::not_supported
+ * Without shared virtual addressing, sva_memory::open returns an
+ * empty pointer and preparing an FPGA_BUF_SVA buffer fails.
+ */
+TEST_P(buffer_cxx_core, sva_not_supported) {
+  EXPECT_EQ(nullptr, sva_memory::open(handle_).get());
+
+  void *addr = nullptr;
+  uint64_t wsid = 0;
+  EXPECT_NE(FPGA_OK, fpgaPrepareBuffer(handle_->c_type(), 4096, &addr,
+                                       &wsid, FPGA_BUF_SVA | FPGA_BUF_QUIET));
+}
+
+/**
+ * @test sva_allocator::rebind
+ * sva_allocator satisfies the standard allocator requirements used
+ * by containers: rebinding and comparison share the sva_memory.
+ */
+TEST(sva_allocator, rebind) {
+  sva_memory::ptr_t none;
+  sva_allocator<uint64_t> a(none);
+  sva_allocator<uint8_t> b(a);
+  typedef std::allocator_traits<sva_allocator<uint64_t>>::rebind_alloc<char>
+      char_alloc;
+  char_alloc c(a);
+
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != c);
+  EXPECT_EQ(0x1000u, sva_memory::io_address(reinterpret_cast<void *>(0x1000)));
+
+  std::vector<uint64_t, sva_allocator<uint64_t>> v(a);
+  EXPECT_TRUE(v.empty());
+}
+
+// Backs sva_memory with heap memory, so that its arenas can be
+// tested without a PASID.
+class heap_sva_memory : public sva_memory {
+ public:
+  heap_sva_memory() : sva_memory(nullptr, 1) {}
+  virtual ~heap_sva_memory() { free_all(); }
+
+  using sva_memory::num_arenas;
+
+  std::vector<std::size_t> prepared;
+  std::size_t released = 0;
+
+ protected:
+  virtual void *prepare(std::size_t len, uint64_t *wsid) override {
+    void *p = nullptr;
+    if (posix_memalign(&p, 4096, len)) return nullptr;
+    prepared.push_back(len);
+    *wsid = reinterpret_cast<uint64_t>(p);
+    return p;
+  }
+
+  virtual void release(uint64_t wsid) override {
+    free(reinterpret_cast<void *>(wsid));
+    ++released;
+  }
+};
+
+/**
+ * @test sva_memory::arenas
+ * Small requests share a 2MB arena, in 64-byte aligned blocks,
+ * and freed blocks coalesce so that they can be reused.
+ */
+TEST(sva_memory, arenas) {
+  heap_sva_memory mem;
+
+  uint8_t *a = static_cast<uint8_t *>(mem.allocate(100));
+  uint8_t *b = static_cast<uint8_t *>(mem.allocate(8000));
+  uint8_t *c = static_cast<uint8_t *>(mem.allocate(1));
+  ASSERT_EQ(1u, mem.prepared.size());
+  EXPECT_EQ(sva_memory::arena_size, mem.prepared[0]);
+  EXPECT_EQ(1u, mem.num_arenas());
+
+  EXPECT_EQ(0u, reinterpret_cast<uint64_t>(a) % sva_memory::granularity);
+  EXPECT_EQ(a + 128, b);
+  EXPECT_EQ(b + 8000, c);
+
+  mem.deallocate(a);
+  mem.deallocate(b);
+  // a and b coalesce into one range at the start of the arena.
+  EXPECT_EQ(a, mem.allocate(8000 + 128));
+  mem.deallocate(a);
+  mem.deallocate(c);
+
+  // The last arena is kept.
+  EXPECT_EQ(1u, mem.num_arenas());
+  EXPECT_EQ(0u, mem.released);
+  EXPECT_EQ(a, mem.allocate(sva_memory::arena_size / 2));
+  mem.deallocate(a);
+}
+
+/**
+ * @test sva_memory::more_arenas
+ * A second arena is added when the first is full, and released
+ * when it empties. Large requests get a buffer of their own.
+ */
+TEST(sva_memory, more_arenas) {
+  heap_sva_memory mem;
+
+  void *a = mem.allocate(sva_memory::arena_size / 2);
+  void *b = mem.allocate(sva_memory::arena_size / 2);
+  void *c = mem.allocate(64);
+  EXPECT_EQ(2u, mem.num_arenas());
+
+  mem.deallocate(c);
+  EXPECT_EQ(1u, mem.num_arenas());
+  EXPECT_EQ(1u, mem.released);
+
+  void *d = mem.allocate(sva_memory::arena_size / 2 + 1);
+  ASSERT_EQ(3u, mem.prepared.size());
+  EXPECT_EQ(sva_memory::arena_size / 2 + 1, mem.prepared[2]);
+  EXPECT_EQ(1u, mem.num_arenas());
+  mem.deallocate(d);
+  EXPECT_EQ(2u, mem.released);
+
+  mem.deallocate(a);
+  mem.deallocate(b);
+  EXPECT_EQ(1u, mem.num_arenas());
+  // Unknown pointers are ignored.
+  mem.deallocate(&mem);
+}
+
+/**
+ * @test buffer_ops::kernels
+ * The buffer_ops kernels agree with simple byte-wise reference
+ * implementations at every length, including partial vectors.
+ */
+TEST(buffer_ops, kernels) {
+  for (size_t len : {0, 1, 31, 32, 33, 63, 64, 65, 127, 1000, 4099}) {
+    std::vector<uint8_t> a(len);
+    std::vector<uint8_t> b(len);
+
+    buffer_ops::fill_incrementing(a.data(), len, 0xfe);
+    for (size_t i = 0; i < len; ++i) {
+      ASSERT_EQ(a[i], static_cast<uint8_t>(0xfe + i));
+    }
+
+    auto r = buffer_ops::compare_incrementing(a.data(), len, 0xfe);
+    EXPECT_EQ(r.first_mismatch, len);
+    EXPECT_EQ(r.mismatches, 0);
+
+    b = a;
+    size_t first = len;
+    size_t count = 0;
+    for (size_t i = 3; i < len; i += 37) {
+      b[i] ^= 0x5a;
+      if (first == len) first = i;
+      ++count;
+    }
+
+    r = buffer_ops::compare(a.data(), b.data(), len);
+    EXPECT_EQ(r.first_mismatch, first);
+    EXPECT_EQ(r.mismatches, count);
+
+    r = buffer_ops::compare_incrementing(b.data(), len, 0xfe);
+    EXPECT_EQ(r.first_mismatch, first);
+    EXPECT_EQ(r.mismatches, count);
+  }
+}
+
+/**
+ * @test buffer_ops::prbs31
+ * Every bit written by fill_prbs31 satisfies the PRBS-31
+ * recurrence b[n] = b[n-31] ^ b[n-28].
+ */
+TEST(buffer_ops, prbs31) {
+  std::vector<uint8_t> p(1001);
+  buffer_ops::fill_prbs31(p.data(), p.size(), 0x12345);
+
+  auto bit = [&p](size_t n) { return (p[n / 8] >> (7 - n % 8)) & 1; };
+  for (size_t n = 31; n < p.size() * 8; ++n) {
+    ASSERT_EQ(bit(n), bit(n - 31) ^ bit(n - 28)) << "bit " << n;
+  }
+}
+
+/**
+ * @test buffer_ops::crc32c
+ * crc32c returns the standard CRC-32C check value, and can be
+ * continued across calls.
+ */
+TEST(buffer_ops, crc32c) {
+  EXPECT_EQ(buffer_ops::crc32c("123456789", 9), 0xe3069283);
+  EXPECT_EQ(buffer_ops::crc32c("6789", 4, buffer_ops::crc32c("12345", 5)),
+            0xe3069283);
+  EXPECT_EQ(buffer_ops::crc32c(nullptr, 0), 0);
+  EXPECT_NE(std::string(buffer_ops::isa()), "");
+}
+
+/**
+ * @test buffer_ops::wait_for
+ * wait_for wakes up when another thread writes the watched
+ * location, well before the timeout.
+ */
+TEST(buffer_ops, wait_for) {
+  alignas(64) volatile uint64_t status = 0;
+  buffer_ops::wait_stats stats;
+
+  std::thread writer([&status]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    status = 0xff01;
+  });
+  EXPECT_TRUE(buffer_ops::wait_for(&status, sizeof(status), 0xff00, 0xff00,
+                                   std::chrono::seconds(5), &stats));
+  writer.join();
+
+  EXPECT_GE(stats.latency, std::chrono::milliseconds(4));
+  EXPECT_LT(stats.latency, std::chrono::seconds(1));
+  EXPECT_EQ(stats.umwait, buffer_ops::has_umwait());
+}
@@ -0,0 +1,235 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <opae/cxx/core/perf_sampler.h>
+
+#include <thread>
+
+#define NO_OPAE_C
+#include "mock/opae_fixtures.h"
+
+using namespace opae::testing;
+using namespace opae::fpga::types;
+
+class perf_sampler_cxx_p : public opae_base_p<> {
+ protected:
+  perf_sampler_cxx_p() {}
+
+  virtual void SetUp() override {
+    opae_base_p<>::SetUp();
+
+    properties::ptr_t props = properties::get(FPGA_DEVICE);
+    props->device_id = platform_.devices[0].device_id;
+
+    tokens_ = token::enumerate({props});
+    ASSERT_GT(tokens_.size(), 0u);
+    handle_ = handle::open(tokens_[0], FPGA_OPEN_SHARED);
+    ASSERT_NE(handle_.get(), nullptr);
+  }
+
+  virtual void TearDown() override {
+    if (handle_.get()) {
+      handle_->close();
+      handle_.reset();
+    }
+    tokens_.clear();
+
+    opae_base_p<>::TearDown();
+  }
+
+  // The mock sysfs files aren't truncated by write64(), so each
+  // value written to a counter must be at least as long (in hex)
+  // as the one before it.
+  void set_counter(const std::string &path, uint64_t value) {
+    auto obj = sysobject::get(handle_, "iperf/" + path);
+    ASSERT_NE(obj.get(), nullptr);
+    obj->write64(value);
+  }
+
+  std::vector<token::ptr_t> tokens_;
+  handle::ptr_t handle_;
+};
+
+/**
+ * @test open
+ * Given an FME token
+ * When I open a perf_sampler on it
+ * Then the cache, fabric and iommu counters are found
+ * And find() returns -1 for an unknown counter.
+ */
+TEST_P(perf_sampler_cxx_p, open) {
+  auto sampler = perf_sampler::open(tokens_[0]);
+  ASSERT_NE(sampler.get(), nullptr);
+
+  EXPECT_GE(sampler->find(perf_sampler::group::cache, "read_hit"), 0);
+  EXPECT_GE(sampler->find(perf_sampler::group::fabric, "mmio_read"), 0);
+  EXPECT_GE(sampler->find(perf_sampler::group::iommu,
+                          "afu0/read_transaction"), 0);
+  EXPECT_EQ(sampler->find(perf_sampler::group::cache, "mmio_read"), -1);
+  EXPECT_EQ(sampler->find(perf_sampler::group::fabric, "abc"), -1);
+
+  EXPECT_STREQ(perf_sampler::group_name(perf_sampler::group::fabric),
+               "fabric");
+  EXPECT_FALSE(sampler->running());
+  EXPECT_TRUE(sampler->samples().empty());
+}
+
+/**
+ * @test deltas
+ * Given an open perf_sampler
+ * When a counter increases between two samples
+ * Then each sample holds the raw value and the increase
+ * And totals() holds the sum of the increases.
+ */
+TEST_P(perf_sampler_cxx_p, deltas) {
+  set_counter("cache/read_hit", 0x100);
+  auto sampler = perf_sampler::open(tokens_[0]);
+  ASSERT_NE(sampler.get(), nullptr);
+  int i = sampler->find(perf_sampler::group::cache, "read_hit");
+  ASSERT_GE(i, 0);
+
+  set_counter("cache/read_hit", 0x180);
+  auto s = sampler->sample_now();
+  ASSERT_EQ(s.values.size(), sampler->counters().size());
+  EXPECT_EQ(s.values[i], 0x180u);
+  EXPECT_EQ(s.deltas[i], 0x80u);
+
+  set_counter("cache/read_hit", 0x200);
+  s = sampler->sample_now();
+  EXPECT_EQ(s.deltas[i], 0x80u);
+
+  s = sampler->sample_now();
+  EXPECT_EQ(s.deltas[i], 0u);
+
+  EXPECT_EQ(sampler->totals()[i], 0x100u);
+  EXPECT_EQ(sampler->samples().size(), 3u);
+}
+
+/**
+ * @test wraparound
+ * Given a perf_sampler opened with 8-bit counters
+ * When a counter wraps around between two samples
+ * Then the delta counts across the wrap.
+ */
+TEST_P(perf_sampler_cxx_p, wraparound) {
+  set_counter("fabric/mmio_read", 0xf0);
+  auto sampler = perf_sampler::open(tokens_[0], 16, 8);
+  ASSERT_NE(sampler.get(), nullptr);
+  int i = sampler->find(perf_sampler::group::fabric, "mmio_read");
+  ASSERT_GE(i, 0);
+
+  set_counter("fabric/mmio_read", 0x10);
+  auto s = sampler->sample_now();
+  EXPECT_EQ(s.deltas[i], 0x20u);
+}
+
+/**
+ * @test read_group
+ * Given an open perf_sampler
+ * When I read the cache group
+ * Then only the cache counters are filled in
+ * And nothing is added to the ring buffer or the totals.
+ */
+TEST_P(perf_sampler_cxx_p, read_group) {
+  set_counter("cache/read_hit", 0x100);
+  set_counter("fabric/mmio_read", 0x200);
+  auto sampler = perf_sampler::open(tokens_[0]);
+  ASSERT_NE(sampler.get(), nullptr);
+  int hit = sampler->find(perf_sampler::group::cache, "read_hit");
+  int mmio = sampler->find(perf_sampler::group::fabric, "mmio_read");
+  ASSERT_GE(hit, 0);
+  ASSERT_GE(mmio, 0);
+
+  set_counter("cache/read_hit", 0x300);
+  auto v = sampler->read_group(perf_sampler::group::cache);
+  ASSERT_EQ(v.size(), sampler->counters().size());
+  EXPECT_EQ(v[hit], 0x300u);
+  EXPECT_EQ(v[mmio], 0u);
+
+  EXPECT_TRUE(sampler->samples().empty());
+  EXPECT_EQ(sampler->totals()[hit], 0u);
+}
+
+/**
+ * @test ring
+ * Given a perf_sampler with a ring buffer of 4 samples
+ * When I take 6 samples
+ * Then the 4 most recent are kept, oldest first
+ * And dropped() counts the 2 that were overwritten
+ * And drain() empties the ring buffer.
+ */
+TEST_P(perf_sampler_cxx_p, ring) {
+  set_counter("cache/write_hit", 0x10);
+  auto sampler = perf_sampler::open(tokens_[0], 4);
+  ASSERT_NE(sampler.get(), nullptr);
+  int i = sampler->find(perf_sampler::group::cache, "write_hit");
+  ASSERT_GE(i, 0);
+
+  for (uint64_t v = 0x11; v <= 0x16; ++v) {
+    set_counter("cache/write_hit", v);
+    sampler->sample_now();
+  }
+
+  auto v = sampler->drain();
+  ASSERT_EQ(v.size(), 4u);
+  EXPECT_EQ(v.front().values[i], 0x13u);
+  EXPECT_EQ(v.back().values[i], 0x16u);
+  EXPECT_LE(v.front().time, v.back().time);
+  EXPECT_EQ(sampler->dropped(), 2u);
+  EXPECT_TRUE(sampler->samples().empty());
+}
+
+/**
+ * @test background
+ * Given an open perf_sampler
+ * When I start sampling on the background thread
+ * Then samples are added to the ring buffer until I stop it.
+ */
+TEST_P(perf_sampler_cxx_p, background) {
+  auto sampler = perf_sampler::open(tokens_[0]);
+  ASSERT_NE(sampler.get(), nullptr);
+
+  sampler->start(std::chrono::microseconds(1000));
+  EXPECT_TRUE(sampler->running());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  sampler->stop();
+  EXPECT_FALSE(sampler->running());
+  EXPECT_FALSE(sampler->error());
+
+  auto n = sampler->samples().size();
+  EXPECT_GT(n, 0u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(sampler->samples().size(), n);
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(perf_sampler_cxx_p);
+INSTANTIATE_TEST_SUITE_P(perf_sampler_cxx, perf_sampler_cxx_p,
+                         ::testing::ValuesIn(test_platform::platforms({
+                                                                        "skx-p"
+                                                                      })));
@@ -0,0 +1,398 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <poll.h>
+#include <unistd.h>
+#include <uuid/uuid.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "opae_emu.h"
+
+int emu_plugin_initialize(void);
+int emu_plugin_finalize(void);
+
+fpga_result emu_fpgaOpen(fpga_token token, fpga_handle *handle, int flags);
+fpga_result emu_fpgaClose(fpga_handle handle);
+fpga_result emu_fpgaGetProperties(fpga_token token, fpga_properties *prop);
+fpga_result emu_fpgaWriteMMIO64(fpga_handle handle, uint32_t mmio_num,
+                                uint64_t offset, uint64_t value);
+fpga_result emu_fpgaReadMMIO64(fpga_handle handle, uint32_t mmio_num,
+                               uint64_t offset, uint64_t *value);
+fpga_result emu_fpgaWriteMMIO32(fpga_handle handle, uint32_t mmio_num,
+                                uint64_t offset, uint32_t value);
+fpga_result emu_fpgaReadMMIO32(fpga_handle handle, uint32_t mmio_num,
+                               uint64_t offset, uint32_t *value);
+fpga_result emu_fpgaMapMMIO(fpga_handle handle, uint32_t mmio_num,
+                            uint64_t **mmio_ptr);
+fpga_result emu_fpgaPrepareBuffer(fpga_handle handle, uint64_t len,
+                                  void **buf_addr, uint64_t *wsid, int flags);
+fpga_result emu_fpgaReleaseBuffer(fpga_handle handle, uint64_t wsid);
+fpga_result emu_fpgaGetIOAddress(fpga_handle handle, uint64_t wsid,
+                                 uint64_t *ioaddr);
+fpga_result emu_fpgaEnumerate(const fpga_properties *filters,
+                              uint32_t num_filters, fpga_token *tokens,
+                              uint32_t max_tokens, uint32_t *num_matches);
+fpga_result emu_fpgaDestroyToken(fpga_token *token);
+fpga_result emu_fpgaCreateEventHandle(fpga_event_handle *event_handle);
+fpga_result emu_fpgaDestroyEventHandle(fpga_event_handle *event_handle);
+fpga_result emu_fpgaGetOSObjectFromEventHandle(const fpga_event_handle eh,
+                                               int *fd);
+fpga_result emu_fpgaRegisterEvent(fpga_handle handle,
+                                  fpga_event_type event_type,
+                                  fpga_event_handle event_handle,
+                                  uint32_t flags);
+fpga_result emu_fpgaUnregisterEvent(fpga_handle handle,
+                                    fpga_event_type event_type,
+                                    fpga_event_handle event_handle);
+}
+
+#define HE_ID_L       0x0008
+#define HE_ID_H       0x0010
+#define HE_SCRATCH    0x0100
+#define HE_DSM_BASEL  0x0110
+#define HE_DSM_BASEH  0x0114
+#define HE_SRC_ADDR   0x0120
+#define HE_DST_ADDR   0x0128
+#define HE_NUM_LINES  0x0130
+#define HE_CTL        0x0138
+#define HE_CFG        0x0140
+#define HE_INTERRUPT0 0x0150
+#define HE_STATUS0    0x0160
+#define HE_ERROR      0x0170
+#define HE_INFO0      0x0180
+
+#define BUFFER_SIZE (64 * 1024)
+#define NUM_LINES   (BUFFER_SIZE / 64)
+
+// Drives the emulated host exerciser the way host_exerciser does.
+class emu_c : public ::testing::Test {
+ protected:
+  emu_c() :
+    accel_(nullptr),
+    handle_(nullptr),
+    src_(nullptr),
+    dst_(nullptr),
+    dsm_(nullptr),
+    src_wsid_(0),
+    dst_wsid_(0),
+    dsm_wsid_(0)
+  {}
+
+  virtual void SetUp() override
+  {
+    fpga_token tokens[2];
+    fpga_properties props = nullptr;
+    fpga_objtype objtype;
+    uint32_t matches = 0;
+
+    ASSERT_EQ(emu_plugin_initialize(), 0);
+    ASSERT_EQ(emu_fpgaEnumerate(nullptr, 0, tokens, 2, &matches), FPGA_OK);
+    ASSERT_EQ(matches, 2u);
+
+    for (auto t : tokens) {
+      ASSERT_EQ(emu_fpgaGetProperties(t, &props), FPGA_OK);
+      ASSERT_EQ(fpgaPropertiesGetObjectType(props, &objtype), FPGA_OK);
+      EXPECT_EQ(fpgaDestroyProperties(&props), FPGA_OK);
+      if (objtype == FPGA_ACCELERATOR) {
+        accel_ = t;
+      } else {
+        EXPECT_EQ(emu_fpgaDestroyToken(&t), FPGA_OK);
+      }
+    }
+    ASSERT_NE(accel_, nullptr);
+    ASSERT_EQ(emu_fpgaOpen(accel_, &handle_, 0), FPGA_OK);
+  }
+
+  virtual void TearDown() override
+  {
+    if (handle_) {
+      EXPECT_EQ(emu_fpgaClose(handle_), FPGA_OK);
+    }
+    if (accel_) {
+      EXPECT_EQ(emu_fpgaDestroyToken(&accel_), FPGA_OK);
+    }
+    emu_plugin_finalize();
+  }
+
+  uint64_t allocate(uint8_t **buf, uint64_t *wsid, uint64_t len)
+  {
+    uint64_t iova = 0;
+    EXPECT_EQ(emu_fpgaPrepareBuffer(handle_, len, (void **)buf, wsid, 0),
+              FPGA_OK);
+    EXPECT_EQ(emu_fpgaGetIOAddress(handle_, *wsid, &iova), FPGA_OK);
+    return iova;
+  }
+
+  void setup_lpbk()
+  {
+    uint64_t dsm = allocate(&dsm_, &dsm_wsid_, 4096);
+
+    ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_SRC_ADDR,
+              allocate(&src_, &src_wsid_, BUFFER_SIZE) >> 6), FPGA_OK);
+    ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_DST_ADDR,
+              allocate(&dst_, &dst_wsid_, BUFFER_SIZE) >> 6), FPGA_OK);
+    ASSERT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_DSM_BASEL,
+              (uint32_t)(dsm >> 6)), FPGA_OK);
+    ASSERT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_DSM_BASEH,
+              (uint32_t)(dsm >> 38)), FPGA_OK);
+    ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_NUM_LINES, NUM_LINES - 1),
+              FPGA_OK);
+
+    for (int i = 0 ; i < BUFFER_SIZE ; ++i)
+      src_[i] = (uint8_t)(i * 7);
+    memset(dst_, 0xbe, BUFFER_SIZE);
+  }
+
+  // Reset the AFU, start one test and wait for the DSM completion bit.
+  bool run_lpbk(uint64_t cfg)
+  {
+    memset(dsm_, 0, 64);
+    EXPECT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_CTL, 0), FPGA_OK);
+    EXPECT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_CTL, 1), FPGA_OK);
+    EXPECT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_CFG, cfg), FPGA_OK);
+    EXPECT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_CTL, 3), FPGA_OK);
+    return wait_dsm();
+  }
+
+  bool wait_dsm()
+  {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(5);
+    volatile uint64_t *status = (volatile uint64_t *)dsm_;
+    while (!(*status & 1)) {
+      std::this_thread::yield();
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+    }
+    return true;
+  }
+
+  fpga_token accel_;
+  fpga_handle handle_;
+  uint8_t *src_;
+  uint8_t *dst_;
+  uint8_t *dsm_;
+  uint64_t src_wsid_;
+  uint64_t dst_wsid_;
+  uint64_t dsm_wsid_;
+};
+
+/**
+ * @test       enumerate
+ * @brief      Test: emu_fpgaEnumerate
+ * @details    The port reports the HE-LB GUID and the FME<br>
+ *             is its parent.<br>
+ */
+TEST_F(emu_c, enumerate) {
+  fpga_properties filter = nullptr;
+  fpga_properties props = nullptr;
+  fpga_token fme = nullptr;
+  fpga_token port = nullptr;
+  fpga_guid guid;
+  fpga_guid he_lb;
+  uint32_t matches = 0;
+
+  ASSERT_EQ(emu_fpgaGetProperties(accel_, &props), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesGetGUID(props, &guid), FPGA_OK);
+  ASSERT_EQ(uuid_parse(EMU_HE_LB_GUID, he_lb), 0);
+  EXPECT_EQ(memcmp(guid, he_lb, sizeof(fpga_guid)), 0);
+  EXPECT_EQ(fpgaDestroyProperties(&props), FPGA_OK);
+
+  ASSERT_EQ(fpgaGetProperties(nullptr, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter, FPGA_DEVICE), FPGA_OK);
+  ASSERT_EQ(emu_fpgaEnumerate(&filter, 1, &fme, 1, &matches), FPGA_OK);
+  ASSERT_EQ(matches, 1u);
+
+  ASSERT_EQ(fpgaClearProperties(filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetParent(filter, fme), FPGA_OK);
+  ASSERT_EQ(emu_fpgaEnumerate(&filter, 1, &port, 1, &matches), FPGA_OK);
+  ASSERT_EQ(matches, 1u);
+
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+  EXPECT_EQ(emu_fpgaDestroyToken(&port), FPGA_OK);
+  EXPECT_EQ(emu_fpgaDestroyToken(&fme), FPGA_OK);
+}
+
+/**
+ * @test       mmio
+ * @brief      Test: emu_fpgaReadMMIO64, emu_fpgaWriteMMIO64
+ * @details    The AFU id CSRs hold the HE-LB GUID, scratch<br>
+ *             registers read back, and the exclusive open is<br>
+ *             enforced.<br>
+ */
+TEST_F(emu_c, mmio) {
+  uint64_t value = 0;
+  uint64_t *mmio = nullptr;
+  fpga_handle second = nullptr;
+
+  ASSERT_EQ(emu_fpgaReadMMIO64(handle_, 0, HE_ID_L, &value), FPGA_OK);
+  EXPECT_EQ(value, 0xb94b12284c31e02bull);
+  ASSERT_EQ(emu_fpgaReadMMIO64(handle_, 0, HE_ID_H, &value), FPGA_OK);
+  EXPECT_EQ(value, 0x56e203e9864f49a7ull);
+  ASSERT_EQ(emu_fpgaReadMMIO64(handle_, 0, HE_INFO0, &value), FPGA_OK);
+  EXPECT_EQ((value >> 16) & 0xff, 3u);
+  EXPECT_EQ(value & 0xffff, (uint64_t)EMU_DEFAULT_CLOCK_MHZ);
+
+  ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_SCRATCH, 0xc0cac01a),
+            FPGA_OK);
+  ASSERT_EQ(emu_fpgaMapMMIO(handle_, 0, &mmio), FPGA_OK);
+  EXPECT_EQ(mmio[HE_SCRATCH / 8], 0xc0cac01aull);
+
+  EXPECT_EQ(emu_fpgaReadMMIO64(handle_, 0, EMU_PORT_MMIO_SIZE, &value),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(emu_fpgaReadMMIO64(handle_, 1, 0, &value), FPGA_INVALID_PARAM);
+  EXPECT_EQ(emu_fpgaOpen(accel_, &second, 0), FPGA_BUSY);
+}
+
+/**
+ * @test       lpbk
+ * @brief      Test: emu_fpgaPrepareBuffer, emu_fpgaWriteMMIO32
+ * @details    A loopback test copies the source buffer to the<br>
+ *             destination and reports its counters in the DSM<br>
+ *             and in HE_STATUS0.<br>
+ */
+TEST_F(emu_c, lpbk) {
+  uint64_t status0 = 0;
+  volatile uint64_t *dsm;
+
+  setup_lpbk();
+  ASSERT_TRUE(run_lpbk(0));
+  EXPECT_EQ(memcmp(src_, dst_, BUFFER_SIZE), 0);
+
+  dsm = (volatile uint64_t *)dsm_;
+  EXPECT_EQ(dsm[0] >> 32, 0u);
+  EXPECT_EQ(dsm[2] & 0xffffffff, (uint64_t)NUM_LINES);
+  EXPECT_EQ(dsm[2] >> 32, (uint64_t)NUM_LINES);
+
+  ASSERT_EQ(emu_fpgaReadMMIO64(handle_, 0, HE_STATUS0, &status0), FPGA_OK);
+  EXPECT_EQ(status0, ((uint64_t)NUM_LINES << 32) | NUM_LINES);
+}
+
+/**
+ * @test       lpbk_mapped
+ * @brief      Test: emu_fpgaMapMMIO
+ * @details    A test started through the mapped CSRs is seen<br>
+ *             by the AFU's poll.<br>
+ */
+TEST_F(emu_c, lpbk_mapped) {
+  uint64_t *mmio = nullptr;
+
+  setup_lpbk();
+  ASSERT_EQ(emu_fpgaMapMMIO(handle_, 0, &mmio), FPGA_OK);
+
+  mmio[HE_CFG / 8] = 0;
+  *(volatile uint32_t *)((uint8_t *)mmio + HE_CTL) = 3;
+  ASSERT_TRUE(wait_dsm());
+  EXPECT_EQ(memcmp(src_, dst_, BUFFER_SIZE), 0);
+}
+
+/**
+ * @test       interrupt
+ * @brief      Test: emu_fpgaRegisterEvent
+ * @details    With IntrTestMode, completion signals the eventfd<br>
+ *             of the vector programmed in HE_INTERRUPT0.<br>
+ */
+TEST_F(emu_c, interrupt) {
+  fpga_event_handle eh = nullptr;
+  struct pollfd pfd;
+  uint64_t count = 0;
+
+  setup_lpbk();
+  ASSERT_EQ(emu_fpgaCreateEventHandle(&eh), FPGA_OK);
+  ASSERT_EQ(emu_fpgaRegisterEvent(handle_, FPGA_EVENT_INTERRUPT, eh, 2),
+            FPGA_OK);
+  ASSERT_EQ(emu_fpgaGetOSObjectFromEventHandle(eh, &pfd.fd), FPGA_OK);
+  pfd.events = POLLIN;
+
+  ASSERT_EQ(emu_fpgaWriteMMIO32(handle_, 0, HE_INTERRUPT0, 2 << 16),
+            FPGA_OK);
+  ASSERT_TRUE(run_lpbk(1ull << 29));
+  ASSERT_EQ(poll(&pfd, 1, 5000), 1);
+  ASSERT_EQ(read(pfd.fd, &count, sizeof(count)), (ssize_t)sizeof(count));
+  EXPECT_EQ(count, 1u);
+
+  EXPECT_EQ(emu_fpgaRegisterEvent(handle_, FPGA_EVENT_INTERRUPT, eh,
+                                  EMU_NUM_IRQS), FPGA_INVALID_PARAM);
+  EXPECT_EQ(emu_fpgaUnregisterEvent(handle_, FPGA_EVENT_INTERRUPT, eh),
+            FPGA_OK);
+  EXPECT_EQ(emu_fpgaDestroyEventHandle(&eh), FPGA_OK);
+}
+
+/**
+ * @test       fault
+ * @brief      Test: emu_fpgaReleaseBuffer
+ * @details    A destination address outside every prepared<br>
+ *             buffer is reported in HE_ERROR and err_vector,<br>
+ *             and nothing is written.<br>
+ */
+TEST_F(emu_c, fault) {
+  uint64_t error = 0;
+
+  setup_lpbk();
+  ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_DST_ADDR,
+            (uint64_t)dst_ >> 6), FPGA_OK);
+  ASSERT_TRUE(run_lpbk(0));
+  EXPECT_NE(((volatile uint64_t *)dsm_)[0] >> 32, 0u);
+  EXPECT_EQ(dst_[0], 0xbe);
+
+  ASSERT_EQ(emu_fpgaReadMMIO64(handle_, 0, HE_ERROR, &error), FPGA_OK);
+  EXPECT_NE(error, 0u);
+
+  EXPECT_EQ(emu_fpgaReleaseBuffer(handle_, src_wsid_), FPGA_OK);
+  EXPECT_EQ(emu_fpgaReleaseBuffer(handle_, src_wsid_), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       overhead
+ * @brief      Test: emu_fpgaWriteMMIO32
+ * @details    Records the host-side cost of a start/complete<br>
+ *             round trip in the test report, to be tracked<br>
+ *             across releases.<br>
+ */
+TEST_F(emu_c, overhead) {
+  const int runs = 1000;
+
+  setup_lpbk();
+  ASSERT_EQ(emu_fpgaWriteMMIO64(handle_, 0, HE_NUM_LINES, 0), FPGA_OK);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0 ; i < runs ; ++i)
+    ASSERT_TRUE(run_lpbk(0));
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start).count();
+
+  RecordProperty("lpbk_round_trip_ns", (int)(ns / runs));
+}
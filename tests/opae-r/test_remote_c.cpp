@@ -0,0 +1,604 @@
+// Copyright(c) 2023, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/ioctl.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "fpga-dfl.h"
+#include "mock/opae_fixtures.h"
+
+extern "C" {
+#include "opae_remote.h"
+#include "remote_server.h"
+
+fpga_result remote_fpgaEnumerate(const fpga_properties *filters,
+                                 uint32_t num_filters, fpga_token *tokens,
+                                 uint32_t max_tokens, uint32_t *num_matches);
+fpga_result remote_fpgaDestroyToken(fpga_token *token);
+fpga_result remote_fpgaGetProperties(fpga_token token, fpga_properties *prop);
+fpga_result remote_fpgaOpen(fpga_token token, fpga_handle *handle, int flags);
+fpga_result remote_fpgaClose(fpga_handle handle);
+fpga_result remote_fpgaWriteMMIO64(fpga_handle handle, uint32_t mmio_num,
+                                   uint64_t offset, uint64_t value);
+fpga_result remote_fpgaReadMMIO64(fpga_handle handle, uint32_t mmio_num,
+                                  uint64_t offset, uint64_t *value);
+fpga_result remote_fpgaWriteMMIO32(fpga_handle handle, uint32_t mmio_num,
+                                   uint64_t offset, uint32_t value);
+fpga_result remote_fpgaReadMMIO32(fpga_handle handle, uint32_t mmio_num,
+                                  uint64_t offset, uint32_t *value);
+fpga_result remote_fpgaHandleGetObject(fpga_handle handle, const char *name,
+                                       fpga_object *object, int flags);
+fpga_result remote_fpgaObjectGetObject(fpga_object parent, const char *name,
+                                       fpga_object *object, int flags);
+fpga_result remote_fpgaDestroyObject(fpga_object *obj);
+fpga_result remote_fpgaObjectRead(fpga_object obj, uint8_t *buffer,
+                                  size_t offset, size_t len, int flags);
+fpga_result remote_fpgaObjectReadv(fpga_object obj,
+                                   fpga_object_window *windows,
+                                   size_t count, int flags);
+fpga_result remote_fpgaObjectReadGroup(fpga_object group,
+                                       fpga_object_value *values,
+                                       size_t count, size_t *changed,
+                                       int flags);
+fpga_result remote_fpgaObjectGetSize(fpga_object obj, uint32_t *value,
+                                     int flags);
+fpga_result remote_fpgaObjectGetType(fpga_object obj,
+                                     enum fpga_sysobject_type *type);
+int remote_map_rings(remote_transport *t, int memfd,
+                     uint32_t ring_size, bool server);
+}
+
+using namespace opae::testing;
+
+static int mmio_ioctl(mock_object *m, int request, va_list argp)
+{
+  UNUSED_PARAM(m);
+  UNUSED_PARAM(request);
+  struct dfl_fpga_port_region_info *rinfo =
+    va_arg(argp, struct dfl_fpga_port_region_info *);
+  if (!rinfo || rinfo->argsz != sizeof(*rinfo) || rinfo->index > 1) {
+    errno = EINVAL;
+    return -1;
+  }
+  rinfo->flags = DFL_PORT_REGION_READ | DFL_PORT_REGION_WRITE |
+                 DFL_PORT_REGION_MMAP;
+  rinfo->size = 0x40000;
+  rinfo->offset = 0;
+  return 0;
+}
+
+// Serves the mock platform with an in-process server and talks to it
+// through the remote plugin's API entry points.
+class remote_c_p : public opae_base_p<> {
+ protected:
+  remote_c_p() :
+    handle_(nullptr)
+  {}
+
+  virtual void SetUp() override
+  {
+    opae_base_p<>::SetUp();
+    system_->register_ioctl_handler(DFL_FPGA_PORT_GET_REGION_INFO, mmio_ioctl);
+
+    path_ = "/tmp/opae-remote-test-" + std::to_string(getpid()) + ".sock";
+    std::string ep = endpoint();
+    remote_server_config cfg = { ep.c_str(), 0, (gid_t)-1, nullptr };
+    ASSERT_EQ(remote_server_start(&server_, &cfg), 0);
+
+    remote_conn = remote_client_connect(ep.c_str(), nullptr,
+                                        REMOTE_DEFAULT_COALESCE_US);
+    ASSERT_NE(remote_conn, nullptr);
+  }
+
+  virtual void TearDown() override
+  {
+    if (handle_) {
+      EXPECT_EQ(remote_fpgaClose(handle_), FPGA_OK);
+      handle_ = nullptr;
+    }
+    for (auto &t : tokens_)
+      EXPECT_EQ(remote_fpgaDestroyToken(&t), FPGA_OK);
+    tokens_.clear();
+
+    if (remote_conn) {
+      remote_client_disconnect(remote_conn);
+      remote_conn = nullptr;
+    }
+    // Joins the session, which releases its server-side resources.
+    remote_server_stop(&server_);
+
+    opae_base_p<>::TearDown();
+  }
+
+  virtual std::string endpoint() const
+  {
+    return "unix:" + path_;
+  }
+
+  uint32_t remote_enumerate(fpga_objtype objtype, fpga_token parent,
+                            uint32_t max_tokens)
+  {
+    fpga_properties filter = nullptr;
+    uint32_t num_matches = 0;
+
+    EXPECT_EQ(fpgaGetProperties(nullptr, &filter), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesSetObjectType(filter, objtype), FPGA_OK);
+    if (parent) {
+      EXPECT_EQ(fpgaPropertiesSetParent(filter, parent), FPGA_OK);
+    }
+
+    size_t first = tokens_.size();
+    tokens_.resize(first + max_tokens, nullptr);
+    EXPECT_EQ(remote_fpgaEnumerate(&filter, 1, tokens_.data() + first,
+                                   max_tokens, &num_matches), FPGA_OK);
+    tokens_.resize(first + std::min(num_matches, max_tokens));
+
+    EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+    return num_matches;
+  }
+
+  void open_accelerator()
+  {
+    ASSERT_GT(remote_enumerate(FPGA_ACCELERATOR, nullptr, 1), 0u);
+    ASSERT_EQ(remote_fpgaOpen(tokens_.back(), &handle_, 0), FPGA_OK);
+  }
+
+  std::string path_;
+  remote_server server_;
+  std::vector<fpga_token> tokens_;
+  fpga_handle handle_;
+  const uint64_t CSR_SCRATCHPAD0 = 0x100;
+};
+
+/**
+ * @test       enumerate
+ * @brief      Test: remote_fpgaEnumerate, remote_fpgaGetProperties
+ * @details    Enumerating through the server finds the same devices<br>
+ *             as enumerating locally, with the same PCIe addresses.<br>
+ */
+TEST_P(remote_c_p, enumerate) {
+  fpga_properties filter = nullptr;
+  uint32_t local_matches = 0;
+
+  ASSERT_EQ(fpgaGetProperties(nullptr, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter, FPGA_DEVICE), FPGA_OK);
+  ASSERT_EQ(fpgaEnumerate(&filter, 1, nullptr, 0, &local_matches), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+
+  ASSERT_EQ(remote_enumerate(FPGA_DEVICE, nullptr, 8), local_matches);
+  ASSERT_GT(tokens_.size(), 0u);
+
+  fpga_properties prop = nullptr;
+  uint16_t vendor_id = 0;
+  fpga_objtype objtype = FPGA_ACCELERATOR;
+  ASSERT_EQ(remote_fpgaGetProperties(tokens_[0], &prop), FPGA_OK);
+  EXPECT_EQ(fpgaPropertiesGetObjectType(prop, &objtype), FPGA_OK);
+  EXPECT_EQ(objtype, FPGA_DEVICE);
+  EXPECT_EQ(fpgaPropertiesGetVendorID(prop, &vendor_id), FPGA_OK);
+  EXPECT_EQ(vendor_id, platform_.devices[0].vendor_id);
+  EXPECT_EQ(fpgaDestroyProperties(&prop), FPGA_OK);
+}
+
+/**
+ * @test       parent_filter
+ * @brief      Test: remote_fpgaEnumerate
+ * @details    A filter whose parent is a remote device token<br>
+ *             finds that device's accelerator.<br>
+ */
+TEST_P(remote_c_p, parent_filter) {
+  ASSERT_GT(remote_enumerate(FPGA_DEVICE, nullptr, 1), 0u);
+  fpga_token device = tokens_.back();
+  EXPECT_EQ(remote_enumerate(FPGA_ACCELERATOR, device, 1), 1u);
+}
+
+/**
+ * @test       mmio
+ * @brief      Test: remote_fpgaWriteMMIO64, remote_fpgaReadMMIO64,<br>
+ *             remote_fpgaWriteMMIO32, remote_fpgaReadMMIO32
+ * @details    A read that follows queued writes sees the last write.<br>
+ */
+TEST_P(remote_c_p, mmio) {
+  uint64_t value64 = 0;
+  uint32_t value32 = 0;
+
+  open_accelerator();
+
+  EXPECT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0, 1), FPGA_OK);
+  EXPECT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0,
+                                   0xdeadbeefdecafbad), FPGA_OK);
+  EXPECT_EQ(remote_fpgaReadMMIO64(handle_, 0, CSR_SCRATCHPAD0, &value64),
+            FPGA_OK);
+  EXPECT_EQ(value64, 0xdeadbeefdecafbad);
+
+  EXPECT_EQ(remote_fpgaWriteMMIO32(handle_, 0, CSR_SCRATCHPAD0, 0xc0cac01a),
+            FPGA_OK);
+  EXPECT_EQ(remote_fpgaReadMMIO32(handle_, 0, CSR_SCRATCHPAD0, &value32),
+            FPGA_OK);
+  EXPECT_EQ(value32, 0xc0cac01a);
+
+  EXPECT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0 + 1, 0),
+            FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       object
+ * @brief      Test: remote_fpgaHandleGetObject, remote_fpgaObjectRead
+ * @details    Sysfs objects of an open accelerator can be read<br>
+ *             through the server.<br>
+ */
+TEST_P(remote_c_p, object) {
+  fpga_object errors = nullptr;
+  fpga_object obj = nullptr;
+  enum fpga_sysobject_type type = FPGA_OBJECT_CONTAINER;
+  uint32_t size = 0;
+
+  if (!platform_.devices[0].has_afu)
+    GTEST_SKIP();
+
+  open_accelerator();
+
+  ASSERT_EQ(remote_fpgaHandleGetObject(handle_, "errors", &errors, 0),
+            FPGA_OK);
+  ASSERT_EQ(remote_fpgaObjectGetObject(errors, "errors", &obj, 0), FPGA_OK);
+
+  EXPECT_EQ(remote_fpgaObjectGetType(obj, &type), FPGA_OK);
+  EXPECT_EQ(type, FPGA_OBJECT_ATTRIBUTE);
+  ASSERT_EQ(remote_fpgaObjectGetSize(obj, &size, FPGA_OBJECT_SYNC), FPGA_OK);
+  ASSERT_GT(size, 0u);
+
+  std::vector<uint8_t> buf(size);
+  EXPECT_EQ(remote_fpgaObjectRead(obj, buf.data(), 0, size, 0), FPGA_OK);
+
+  EXPECT_EQ(remote_fpgaDestroyObject(&obj), FPGA_OK);
+  EXPECT_EQ(remote_fpgaDestroyObject(&errors), FPGA_OK);
+}
+
+/**
+ * @test       object_readv
+ * @brief      Test: remote_fpgaObjectReadv
+ * @details    Windows read through the server hold the same bytes<br>
+ *             as remote_fpgaObjectRead of the same ranges.<br>
+ */
+TEST_P(remote_c_p, object_readv) {
+  fpga_object errors = nullptr;
+  fpga_object obj = nullptr;
+  uint32_t size = 0;
+
+  if (!platform_.devices[0].has_afu)
+    GTEST_SKIP();
+
+  open_accelerator();
+
+  ASSERT_EQ(remote_fpgaHandleGetObject(handle_, "errors", &errors, 0),
+            FPGA_OK);
+  ASSERT_EQ(remote_fpgaObjectGetObject(errors, "errors", &obj, 0), FPGA_OK);
+  ASSERT_EQ(remote_fpgaObjectGetSize(obj, &size, FPGA_OBJECT_SYNC), FPGA_OK);
+  ASSERT_GT(size, 1u);
+
+  std::vector<uint8_t> whole(size);
+  std::vector<uint8_t> first(1);
+  std::vector<uint8_t> rest(size - 1);
+  fpga_object_window windows[] = {
+    { first.data(), 0, 1 },
+    { rest.data(), 1, size - 1 }
+  };
+  ASSERT_EQ(remote_fpgaObjectRead(obj, whole.data(), 0, size, 0), FPGA_OK);
+  ASSERT_EQ(remote_fpgaObjectReadv(obj, windows, 2, 0), FPGA_OK);
+  EXPECT_EQ(first[0], whole[0]);
+  EXPECT_TRUE(std::equal(rest.begin(), rest.end(), whole.begin() + 1));
+
+  windows[1].len = size;
+  EXPECT_NE(remote_fpgaObjectReadv(obj, windows, 2, 0), FPGA_OK);
+
+  EXPECT_EQ(remote_fpgaDestroyObject(&obj), FPGA_OK);
+  EXPECT_EQ(remote_fpgaDestroyObject(&errors), FPGA_OK);
+}
+
+/**
+ * @test       object_read_group
+ * @brief      Test: remote_fpgaObjectReadGroup
+ * @details    A group snapshot returns one named value per child,<br>
+ *             all changed the first time and none the second.<br>
+ */
+TEST_P(remote_c_p, object_read_group) {
+  fpga_object errors = nullptr;
+  uint32_t size = 0;
+  size_t changed = 0;
+
+  if (!platform_.devices[0].has_afu)
+    GTEST_SKIP();
+
+  open_accelerator();
+
+  ASSERT_EQ(remote_fpgaHandleGetObject(handle_, "errors", &errors,
+                                       FPGA_OBJECT_RECURSE_ONE), FPGA_OK);
+  ASSERT_EQ(remote_fpgaObjectGetSize(errors, &size, 0), FPGA_OK);
+  ASSERT_GT(size, 0u);
+
+  std::vector<fpga_object_value> values(size);
+  ASSERT_EQ(remote_fpgaObjectReadGroup(errors, values.data(), size,
+                                       &changed, 0), FPGA_OK);
+  for (auto &v : values)
+    ASSERT_NE(v.name, nullptr);
+  EXPECT_GT(changed, 0u);
+
+  ASSERT_EQ(remote_fpgaObjectReadGroup(errors, values.data(), size,
+                                       &changed, 0), FPGA_OK);
+  EXPECT_EQ(changed, 0u);
+
+  EXPECT_NE(remote_fpgaObjectReadGroup(errors, values.data(), size - 1,
+                                       &changed, 0), FPGA_OK);
+
+  EXPECT_EQ(remote_fpgaDestroyObject(&errors), FPGA_OK);
+}
+
+/**
+ * @test       socket_mode
+ * @brief      Test: remote_server_start
+ * @details    The server's Unix socket is usable by its owner only.<br>
+ */
+TEST_P(remote_c_p, socket_mode) {
+  struct stat st;
+
+  ASSERT_EQ(stat(path_.c_str(), &st), 0);
+  EXPECT_EQ(st.st_mode & 0777, 0600u);
+}
+
+/**
+ * @test       coalesce
+ * @brief      Test: remote_fpgaWriteMMIO64
+ * @details    Back-to-back MMIO writes are sent in batches, so<br>
+ *             there are fewer batch messages than writes. Records<br>
+ *             the write throughput and the read round trip time.<br>
+ */
+TEST_P(remote_c_p, coalesce) {
+  const int writes = 10000;
+  const int reads = 1000;
+  uint64_t value = 0;
+  remote_client_stats stats;
+
+  open_accelerator();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0 ; i < writes ; ++i)
+    ASSERT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0, i), FPGA_OK);
+  ASSERT_EQ(remote_fpgaReadMMIO64(handle_, 0, CSR_SCRATCHPAD0, &value),
+            FPGA_OK);
+  EXPECT_EQ(value, (uint64_t)writes - 1);
+  auto write_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0 ; i < reads ; ++i)
+    ASSERT_EQ(remote_fpgaReadMMIO64(handle_, 0, CSR_SCRATCHPAD0, &value),
+              FPGA_OK);
+  auto read_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start).count();
+
+  remote_client_get_stats(remote_conn, &stats);
+  EXPECT_EQ(stats.mmio_writes, (uint64_t)writes);
+  EXPECT_LT(stats.write_batches, stats.mmio_writes);
+
+  RecordProperty("writes_per_s", (int)(writes * 1e9 / write_ns));
+  RecordProperty("write_batches", (int)stats.write_batches);
+  RecordProperty("read_round_trip_ns", (int)(read_ns / reads));
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(remote_c_p);
+INSTANTIATE_TEST_SUITE_P(remote_c, remote_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({
+                                                                        "dfl-d5005",
+                                                                        "dfl-n3000"
+                                                                      })));
+
+// The same requests over shared memory rings.
+class remote_shm_c_p : public remote_c_p {
+ protected:
+  virtual std::string endpoint() const override
+  {
+    return "shm:" + path_;
+  }
+};
+
+/**
+ * @test       shm_mmio
+ * @brief      Test: remote_fpgaWriteMMIO64, remote_fpgaReadMMIO64
+ * @details    MMIO round trips work over the shared memory rings.<br>
+ */
+TEST_P(remote_shm_c_p, shm_mmio) {
+  uint64_t value = 0;
+
+  open_accelerator();
+
+  EXPECT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0,
+                                   0xdeadbeefdecafbad), FPGA_OK);
+  EXPECT_EQ(remote_fpgaReadMMIO64(handle_, 0, CSR_SCRATCHPAD0, &value),
+            FPGA_OK);
+  EXPECT_EQ(value, 0xdeadbeefdecafbad);
+}
+
+/**
+ * @test       shm_coalesce
+ * @brief      Test: remote_fpgaWriteMMIO64
+ * @details    Records the throughput over the shared memory rings.<br>
+ */
+TEST_P(remote_shm_c_p, shm_coalesce) {
+  uint64_t value = 0;
+  remote_client_stats stats;
+  const int writes = 10000;
+
+  open_accelerator();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0 ; i < writes ; ++i)
+    ASSERT_EQ(remote_fpgaWriteMMIO64(handle_, 0, CSR_SCRATCHPAD0, i), FPGA_OK);
+  ASSERT_EQ(remote_fpgaReadMMIO64(handle_, 0, CSR_SCRATCHPAD0, &value),
+            FPGA_OK);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start).count();
+
+  remote_client_get_stats(remote_conn, &stats);
+  EXPECT_LT(stats.write_batches, stats.mmio_writes);
+  RecordProperty("writes_per_s", (int)(writes * 1e9 / ns));
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(remote_shm_c_p);
+INSTANTIATE_TEST_SUITE_P(remote_shm_c, remote_shm_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({
+                                                                        "dfl-d5005",
+                                                                        "dfl-n3000"
+                                                                      })));
+
+// A server on a TCP endpoint, which challenges its clients for a key.
+class remote_tcp_c : public ::testing::Test {
+ protected:
+  virtual void SetUp() override
+  {
+    key_path_ = "/tmp/opae-remote-key-" + std::to_string(getpid());
+    int fd = open(key_path_.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    ASSERT_GE(fd, 0);
+    for (size_t i = 0 ; i < sizeof(key_) ; ++i)
+      key_[i] = (uint8_t)(0xa5 ^ i);
+    ASSERT_EQ(write(fd, key_, sizeof(key_)), (ssize_t)sizeof(key_));
+    close(fd);
+  }
+
+  virtual void TearDown() override
+  {
+    unlink(key_path_.c_str());
+  }
+
+  // The endpoint of the server's ephemeral port.
+  std::string endpoint_of(remote_server *srv)
+  {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    EXPECT_EQ(getsockname(srv->listen_fd, (struct sockaddr *)&addr, &len), 0);
+    EXPECT_EQ(addr.sin_family, AF_INET);
+    return "tcp:127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+  }
+
+  std::string key_path_;
+  uint8_t key_[REMOTE_KEY_SIZE];
+};
+
+/**
+ * @test       loopback_only
+ * @brief      Test: remote_server_start
+ * @details    Listening on an address other than loopback needs<br>
+ *             --allow-remote, and --allow-remote needs a key.<br>
+ */
+TEST_F(remote_tcp_c, loopback_only) {
+  remote_server srv;
+  remote_server_config cfg = { "tcp:0.0.0.0:0", 0, (gid_t)-1, nullptr };
+
+  EXPECT_NE(remote_server_start(&srv, &cfg), 0);
+
+  cfg.listen_flags = REMOTE_LISTEN_ALLOW_REMOTE;
+  EXPECT_NE(remote_server_start(&srv, &cfg), 0);
+}
+
+/**
+ * @test       key
+ * @brief      Test: remote_load_key, remote_client_connect
+ * @details    A TCP client with the server's key connects; one<br>
+ *             with another key or without a key is refused.<br>
+ */
+TEST_F(remote_tcp_c, key) {
+  remote_server srv;
+  uint8_t key[REMOTE_KEY_SIZE];
+  remote_server_config cfg = { "tcp:127.0.0.1:0", 0, (gid_t)-1, key };
+
+  ASSERT_EQ(remote_load_key(key_path_.c_str(), key), 0);
+  EXPECT_TRUE(std::equal(key, key + sizeof(key), key_));
+
+  ASSERT_EQ(remote_server_start(&srv, &cfg), 0);
+  std::string ep = endpoint_of(&srv);
+
+  remote_client *c = remote_client_connect(ep.c_str(), key, 0);
+  EXPECT_NE(c, nullptr);
+  remote_client_disconnect(c);
+
+  key[0] ^= 1;
+  EXPECT_EQ(remote_client_connect(ep.c_str(), key, 0), nullptr);
+  EXPECT_EQ(remote_client_connect(ep.c_str(), nullptr, 0), nullptr);
+
+  remote_server_stop(&srv);
+}
+
+/**
+ * @test       key_mode
+ * @brief      Test: remote_load_key
+ * @details    A key file that group or other can read is refused.<br>
+ */
+TEST_F(remote_tcp_c, key_mode) {
+  uint8_t key[REMOTE_KEY_SIZE];
+
+  ASSERT_EQ(chmod(key_path_.c_str(), 0640), 0);
+  EXPECT_NE(remote_load_key(key_path_.c_str(), key), 0);
+}
+
+/**
+ * @test       ring_size
+ * @brief      Test: remote_map_rings
+ * @details    Ring sizes that aren't a power of two, or that lie<br>
+ *             outside [REMOTE_MIN_RING_SIZE, REMOTE_MAX_RING_SIZE],<br>
+ *             are refused however large the shared memory is.<br>
+ */
+TEST(remote_transport_c, ring_size) {
+  remote_transport t;
+  int memfd = syscall(SYS_memfd_create, "opae-remote-test", 0);
+
+  ASSERT_GE(memfd, 0);
+  ASSERT_EQ(ftruncate(memfd, 8 * (off_t)REMOTE_MAX_RING_SIZE), 0);
+
+  memset(&t, 0, sizeof(t));
+  EXPECT_NE(remote_map_rings(&t, memfd, 2 * REMOTE_MAX_RING_SIZE, true), 0);
+  EXPECT_NE(remote_map_rings(&t, memfd, REMOTE_MIN_RING_SIZE / 2, true), 0);
+  EXPECT_NE(remote_map_rings(&t, memfd, 3 * REMOTE_MIN_RING_SIZE, true), 0);
+  EXPECT_EQ(t.shm, nullptr);
+
+  ASSERT_EQ(remote_map_rings(&t, memfd, REMOTE_MAX_RING_SIZE, true), 0);
+  EXPECT_EQ(t.ring_size, (uint32_t)REMOTE_MAX_RING_SIZE);
+  munmap(t.shm, t.shm_size);
+  close(memfd);
+}
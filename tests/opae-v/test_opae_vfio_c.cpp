@@ -67,7 +67,8 @@ vfio_handle *handle_check_and_lock(fpga_handle handle);
 vfio_event_handle *event_handle_check_and_lock(fpga_event_handle event_handle);
 
 int close_vfio_pair(vfio_pair_t **pair);
-fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair);
+fpga_result open_vfio_pair(const char *addr, vfio_pair_t **ppair,
+                           struct opae_vfio *owner);
 
 fpga_result vfio_reset(const vfio_pci_device_t *dev,
                       volatile uint8_t *port_base);
@@ -139,6 +140,11 @@ fpga_result unregister_event(vfio_handle *_h,
                              fpga_event_type event_type,
                              vfio_event_handle *_ueh);
 
+fpga_result vfio_fpgaPinBuffer(fpga_handle handle, void *buf_addr,
+                               uint64_t len, uint64_t ioaddr);
+fpga_result vfio_fpgaUnpinBuffer(fpga_handle handle, void *buf_addr,
+                                 uint64_t len, uint64_t ioaddr);
+fpga_result vfio_fpgaSharesParentMappings(fpga_handle handle, bool *shared);
 fpga_result vfio_fpgaUnregisterEvent(fpga_handle handle,
                                     fpga_event_type event_type,
                                     fpga_event_handle event_handle);
@@ -1317,7 +1323,7 @@ TEST(opae_v, open_vfio_pair_err0)
 
   test_system::instance()->invalidate_malloc(0, "open_vfio_pair");
 
-  EXPECT_EQ(FPGA_NO_MEMORY, open_vfio_pair(addr, &pair));
+  EXPECT_EQ(FPGA_NO_MEMORY, open_vfio_pair(addr, &pair, NULL));
 }
 
 /**
@@ -1337,7 +1343,7 @@ TEST(opae_v, open_vfio_pair_err1)
 
   test_system::instance()->invalidate_malloc(1, "open_vfio_pair");
 
-  EXPECT_EQ(FPGA_NO_MEMORY, open_vfio_pair(addr, &pair));
+  EXPECT_EQ(FPGA_NO_MEMORY, open_vfio_pair(addr, &pair, NULL));
 }
 
 /**
@@ -3079,6 +3085,151 @@ TEST(opae_v, prepare_buffer_err2)
   EXPECT_EQ(FPGA_EXCEPTION, vfio_fpgaPrepareBuffer(&handle, len, &buf_addr, &wsid, flags));
 }
 
+/**
+ * @test    prepare_buffer_sva
+ * @brief   Test: vfio_fpgaPrepareBuffer(), vfio_fpgaReleaseBuffer()
+ * @details When the flags contain FPGA_BUF_SVA,<br>
+ *          the function returns FPGA_NOT_SUPPORTED until a PASID<br>
+ *          is bound to the handle. Afterwards it allocates memory<br>
+ *          whose IO address is its virtual address, without<br>
+ *          touching the VFIO container.
+ */
+TEST(opae_v, prepare_buffer_sva)
+{
+  struct opae_vfio device;
+  memset(&device, 0, sizeof(device));
+  device.cont_fd = -1; // <- any mapping would fail
+
+  vfio_pair_t pair;
+  memset(&pair, 0, sizeof(pair));
+  pair.device = &device;
+
+  vfio_handle handle;
+  memset(&handle, 0, sizeof(handle));
+  handle.magic = VFIO_HANDLE_MAGIC;
+  handle.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  handle.vfio_pair = &pair;
+
+  uint64_t wsid = 0;
+  void *buf_addr = nullptr;
+  EXPECT_EQ(FPGA_NOT_SUPPORTED,
+            vfio_fpgaPrepareBuffer(&handle, 4096, &buf_addr, &wsid,
+                                   FPGA_BUF_SVA | FPGA_BUF_QUIET));
+
+  handle.flags |= OPAE_FLAG_PASID_VALID;
+  ASSERT_EQ(FPGA_OK,
+            vfio_fpgaPrepareBuffer(&handle, 3 * 4096, &buf_addr, &wsid,
+                                   FPGA_BUF_SVA));
+  ASSERT_NE(nullptr, buf_addr);
+
+  uint64_t ioaddr = 0;
+  EXPECT_EQ(FPGA_OK, vfio_fpgaGetIOAddress(&handle, wsid, &ioaddr));
+  EXPECT_EQ((uint64_t)buf_addr, ioaddr);
+  memset(buf_addr, 0xa5, 3 * 4096);
+
+  EXPECT_EQ(FPGA_OK, vfio_fpgaPinBuffer(&handle, buf_addr, 3 * 4096, ioaddr));
+  EXPECT_EQ(FPGA_OK, vfio_fpgaReleaseBuffer(&handle, wsid));
+  EXPECT_EQ(nullptr, handle.sva_buffers);
+
+  // Pre-allocated memory is used as is, and not freed.
+  uint64_t mem[512];
+  buf_addr = mem;
+  ASSERT_EQ(FPGA_OK,
+            vfio_fpgaPrepareBuffer(&handle, sizeof(mem), &buf_addr, &wsid,
+                                   FPGA_BUF_SVA | FPGA_BUF_PREALLOCATED));
+  EXPECT_EQ((void *)mem, buf_addr);
+  EXPECT_EQ(FPGA_OK, vfio_fpgaGetIOAddress(&handle, wsid, &ioaddr));
+  EXPECT_EQ((uint64_t)mem, ioaddr);
+  EXPECT_EQ(FPGA_OK, vfio_fpgaReleaseBuffer(&handle, wsid));
+  EXPECT_EQ(nullptr, handle.sva_buffers);
+
+  // No longer an SVA buffer: pinning it goes to the IOMMU.
+  EXPECT_EQ(FPGA_EXCEPTION,
+            vfio_fpgaPinBuffer(&handle, mem, sizeof(mem), (uint64_t)mem));
+}
+
+/**
+ * @test    PinBuffer_sva_parent
+ * @brief   Test: vfio_fpgaPinBuffer(), vfio_fpgaUnpinBuffer()
+ * @details When a child handle bound to a PASID is given an SVA<br>
+ *          buffer of its parent,<br>
+ *          then the functions return FPGA_OK without touching<br>
+ *          the IOMMU. Any other buffer is mapped, even when its<br>
+ *          IO address equals its virtual address.
+ */
+TEST(opae_v, PinBuffer_sva_parent)
+{
+  struct opae_vfio device;
+  memset(&device, 0, sizeof(device));
+  device.cont_fd = -1; // <- any mapping would fail
+
+  vfio_pair_t pair;
+  memset(&pair, 0, sizeof(pair));
+  pair.device = &device;
+
+  vfio_handle parent;
+  memset(&parent, 0, sizeof(parent));
+  parent.magic = VFIO_HANDLE_MAGIC;
+  parent.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  parent.flags = OPAE_FLAG_PASID_VALID;
+  parent.vfio_pair = &pair;
+
+  vfio_handle handle;
+  memset(&handle, 0, sizeof(handle));
+  handle.magic = VFIO_HANDLE_MAGIC;
+  handle.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  handle.flags = OPAE_FLAG_PASID_VALID;
+  handle.vfio_pair = &pair;
+  handle.parent_afu = &parent;
+
+  uint64_t wsid = 0;
+  void *buf_addr = nullptr;
+  ASSERT_EQ(FPGA_OK,
+            vfio_fpgaPrepareBuffer(&parent, 4096, &buf_addr, &wsid,
+                                   FPGA_BUF_SVA));
+
+  EXPECT_EQ(FPGA_OK,
+            vfio_fpgaPinBuffer(&handle, buf_addr, 4096, (uint64_t)buf_addr));
+  EXPECT_EQ(FPGA_OK,
+            vfio_fpgaUnpinBuffer(&handle, buf_addr, 4096, (uint64_t)buf_addr));
+
+  uint8_t buf[4096];
+  EXPECT_EQ(FPGA_EXCEPTION,
+            vfio_fpgaPinBuffer(&handle, buf, sizeof(buf), (uint64_t)buf));
+
+  EXPECT_EQ(FPGA_OK, vfio_fpgaReleaseBuffer(&parent, wsid));
+}
+
+/**
+ * @test    vfio_fpgaClose_sva
+ * @brief   Test: vfio_fpgaClose()
+ * @details When the given handle has SVA buffers<br>
+ *          that were never released,<br>
+ *          then the function frees them and returns FPGA_OK.
+ */
+TEST(opae_v, vfio_fpgaClose_sva)
+{
+  vfio_handle *h = (vfio_handle *)opae_calloc(1, sizeof(*h));
+  h->magic = VFIO_HANDLE_MAGIC;
+  h->lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  h->flags = OPAE_FLAG_PASID_VALID;
+
+  uint64_t wsid = 0;
+  void *buf_addr = nullptr;
+  ASSERT_EQ(FPGA_OK,
+            vfio_fpgaPrepareBuffer(h, 2 * 4096, &buf_addr, &wsid,
+                                   FPGA_BUF_SVA));
+
+  uint64_t mem[512];
+  buf_addr = mem;
+  ASSERT_EQ(FPGA_OK,
+            vfio_fpgaPrepareBuffer(h, sizeof(mem), &buf_addr, &wsid,
+                                   FPGA_BUF_SVA | FPGA_BUF_PREALLOCATED));
+  ASSERT_NE(nullptr, h->sva_buffers);
+
+  EXPECT_EQ(FPGA_OK, vfio_fpgaClose(h));
+}
+
 /**
  * @test    release_buffer_err0
  * @brief   Test: vfio_fpgaReleaseBuffer()
@@ -3490,3 +3641,76 @@ TEST(opae_v, UnregisterEvent_ok)
 
   EXPECT_EQ(FPGA_EXCEPTION, vfio_fpgaUnregisterEvent(&handle, FPGA_EVENT_INTERRUPT, &eh));
 }
+
+/**
+ * @test    PinBuffer_shared_container
+ * @brief   Test: vfio_fpgaPinBuffer(), vfio_fpgaUnpinBuffer()
+ * @details When the handle's device shares the VFIO container<br>
+ *          of its parent,<br>
+ *          then the functions return FPGA_OK without touching<br>
+ *          the IOMMU, because the parent's mapping is shared.
+ */
+TEST(opae_v, PinBuffer_shared_container)
+{
+  struct opae_vfio owner;
+  memset(&owner, 0, sizeof(owner));
+  owner.cont_fd = -1;
+
+  struct opae_vfio device;
+  memset(&device, 0, sizeof(device));
+  device.cont_fd = -1; // <- any ioctl() would fail
+  device.cont_owner = &owner;
+
+  vfio_pair_t pair;
+  memset(&pair, 0, sizeof(pair));
+  pair.device = &device;
+
+  vfio_handle handle;
+  memset(&handle, 0, sizeof(handle));
+  handle.magic = VFIO_HANDLE_MAGIC;
+  handle.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  handle.vfio_pair = &pair;
+
+  uint8_t buf[4096];
+  EXPECT_EQ(FPGA_OK, vfio_fpgaPinBuffer(&handle, buf, sizeof(buf), 0x1000));
+  EXPECT_EQ(FPGA_OK, vfio_fpgaUnpinBuffer(&handle, buf, sizeof(buf), 0x1000));
+
+  device.cont_owner = nullptr;
+  EXPECT_EQ(FPGA_EXCEPTION, vfio_fpgaPinBuffer(&handle, buf, sizeof(buf), 0x1000));
+}
+
+/**
+ * @test    SharesParentMappings
+ * @brief   Test: vfio_fpgaSharesParentMappings()
+ * @details A handle whose device shares the VFIO container of<br>
+ *          its parent reports that it sees the parent's mappings.<br>
+ */
+TEST(opae_v, SharesParentMappings)
+{
+  struct opae_vfio owner;
+  memset(&owner, 0, sizeof(owner));
+
+  struct opae_vfio device;
+  memset(&device, 0, sizeof(device));
+  device.cont_owner = &owner;
+
+  vfio_pair_t pair;
+  memset(&pair, 0, sizeof(pair));
+  pair.device = &device;
+
+  vfio_handle handle;
+  memset(&handle, 0, sizeof(handle));
+  handle.magic = VFIO_HANDLE_MAGIC;
+  handle.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  handle.vfio_pair = &pair;
+
+  bool shared = false;
+  EXPECT_EQ(FPGA_OK, vfio_fpgaSharesParentMappings(&handle, &shared));
+  EXPECT_TRUE(shared);
+
+  device.cont_owner = nullptr;
+  EXPECT_EQ(FPGA_OK, vfio_fpgaSharesParentMappings(&handle, &shared));
+  EXPECT_FALSE(shared);
+
+  EXPECT_EQ(FPGA_INVALID_PARAM, vfio_fpgaSharesParentMappings(&handle, NULL));
+}
@@ -0,0 +1,158 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "main.h"
+
+class opae_io_block_io : public ::testing::Test {
+ protected:
+  opae_io_block_io() : regs_(16) {}
+
+  virtual void SetUp() override {
+    for (size_t i = 0; i < regs_.size(); ++i)
+      regs_[i] = 0x1111111111111111ULL * i;
+    region_.index = 0;
+    region_.ptr = reinterpret_cast<uint8_t *>(regs_.data());
+    region_.size = regs_.size() * sizeof(uint64_t);
+  }
+
+  std::vector<uint64_t> regs_;
+  mmio_region region_;
+};
+
+/**
+ * @test       read_block
+ * @brief      Test: mmio_region::read_block
+ * @details    Registers are copied out at either access
+ *             width, starting at the given offset.<br>
+ */
+TEST_F(opae_io_block_io, read_block) {
+  uint64_t q[3] = { 0, 0, 0 };
+  region_.read_block(0x10, q, 3, 64);
+  EXPECT_EQ(regs_[2], q[0]);
+  EXPECT_EQ(regs_[3], q[1]);
+  EXPECT_EQ(regs_[4], q[2]);
+
+  uint32_t d[3] = { 0, 0, 0 };
+  region_.read_block(0x1c, d, 3, 32);
+  EXPECT_EQ(region_.read32(0x1c), d[0]);
+  EXPECT_EQ(region_.read32(0x20), d[1]);
+  EXPECT_EQ(region_.read32(0x24), d[2]);
+}
+
+/**
+ * @test       write_block
+ * @brief      Test: mmio_region::write_block
+ * @details    Registers are copied in at either access width,
+ *             and the registers around the block are kept.<br>
+ */
+TEST_F(opae_io_block_io, write_block) {
+  const uint64_t q[2] = { 0xdeadbeefcafef00dULL, 0x0123456789abcdefULL };
+  region_.write_block(0x08, q, 2, 64);
+  EXPECT_EQ(0x0000000000000000ULL, regs_[0]);
+  EXPECT_EQ(q[0], regs_[1]);
+  EXPECT_EQ(q[1], regs_[2]);
+  EXPECT_EQ(0x3333333333333333ULL, regs_[3]);
+
+  const uint32_t d[1] = { 0xa5a5a5a5 };
+  region_.write_block(0x1c, d, 1, 32);
+  EXPECT_EQ(0xa5a5a5a533333333ULL, regs_[3]);
+}
+
+/**
+ * @test       dump_restore
+ * @brief      Test: mmio_region::dump_count, mmio_region::restore
+ * @details    A size of 0 dumps up to the end of the region, and
+ *             a dump is written back by restore.<br>
+ */
+TEST_F(opae_io_block_io, dump_restore) {
+  EXPECT_EQ(16u, region_.dump_count(0, 0, 64));
+  EXPECT_EQ(28u, region_.dump_count(0x10, 0, 32));
+  EXPECT_EQ(4u, region_.dump_count(0x10, 0x20, 64));
+  EXPECT_EQ(0u, region_.dump_count(region_.size, 0, 64));
+
+  std::vector<uint64_t> saved(region_.dump_count(0x20, 0x40, 64));
+  region_.read_block(0x20, saved.data(), saved.size(), 64);
+  std::vector<uint64_t> orig(regs_);
+
+  for (size_t i = 4; i < 12; ++i)
+    regs_[i] = 0;
+  region_.restore(0x20, saved.data(), saved.size() * sizeof(uint64_t), 64);
+  EXPECT_EQ(orig, regs_);
+}
+
+/**
+ * @test       dump_restore_err
+ * @brief      Test: mmio_region::dump_count, mmio_region::restore
+ * @details    A start beyond the region, or a size that isn't a
+ *             multiple of the access width, is rejected.<br>
+ */
+TEST_F(opae_io_block_io, dump_restore_err) {
+  EXPECT_THROW(region_.dump_count(region_.size + 8, 0, 64),
+               std::out_of_range);
+  EXPECT_THROW(region_.dump_count(0, 12, 64), std::invalid_argument);
+  EXPECT_THROW(region_.dump_count(0, 0, 16), std::invalid_argument);
+
+  uint64_t q[2] = { 0, 0 };
+  EXPECT_THROW(region_.restore(0, q, 12, 64), std::invalid_argument);
+  EXPECT_THROW(region_.restore(region_.size - 8, q, sizeof(q), 64),
+               std::out_of_range);
+}
+
+/**
+ * @test       check_block
+ * @brief      Test: mmio_region::check_block
+ * @details    A block must use a 32 or 64-bit width, be aligned
+ *             to it and lie within the region, even when the
+ *             register count would overflow.<br>
+ */
+TEST_F(opae_io_block_io, check_block) {
+  EXPECT_NO_THROW(region_.check_block(0, 16, 64));
+  EXPECT_NO_THROW(region_.check_block(0x7c, 1, 32));
+  EXPECT_NO_THROW(region_.check_block(region_.size, 0, 64));
+
+  EXPECT_THROW(region_.check_block(0, 1, 8), std::invalid_argument);
+  EXPECT_THROW(region_.check_block(0, 1, 16), std::invalid_argument);
+  EXPECT_THROW(region_.check_block(4, 1, 64), std::invalid_argument);
+  EXPECT_THROW(region_.check_block(2, 1, 32), std::invalid_argument);
+
+  EXPECT_THROW(region_.check_block(0, 17, 64), std::out_of_range);
+  EXPECT_THROW(region_.check_block(0x7c, 2, 32), std::out_of_range);
+  EXPECT_THROW(region_.check_block(region_.size + 8, 0, 64),
+               std::out_of_range);
+  EXPECT_THROW(region_.check_block(8, SIZE_MAX / 4, 64), std::out_of_range);
+
+  uint64_t q = 0;
+  EXPECT_THROW(region_.read_block(0x80, &q, 1, 64), std::out_of_range);
+  EXPECT_THROW(region_.write_block(0x80, &q, 1, 64), std::out_of_range);
+}
@@ -25,6 +25,8 @@
 # POSSIBILITY OF SUCH DAMAGE.
 import struct
 import sys
+import threading
+import time
 
 # pylint: disable=E0602, E0603
 
@@ -76,6 +78,24 @@ class TestSharedBuffer(unittest.TestCase):
         buff1[42] = int(65536)
         assert struct.unpack('<L', (bytearray(buff1[42:46])))[0] == 65536
 
+    def test_allocate_placement(self):
+        placements = [opae.fpga.buffer_placement.DEVICE,
+                      opae.fpga.buffer_placement.ANY,
+                      opae.fpga.buffer_placement.INTERLEAVE]
+        for p in placements:
+            buff = opae.fpga.allocate_shared_buffer(self.handle, 4096,
+                                                    placement=p)
+            assert buff
+            assert buff.size() == 4096
+        buff = opae.fpga.allocate_shared_buffer(
+            self.handle, 4096, placement=opae.fpga.buffer_placement.NODE,
+            numa_node=0)
+        assert buff
+        with self.assertRaises(RuntimeError):
+            opae.fpga.allocate_shared_buffer(
+                self.handle, 4096,
+                placement=opae.fpga.buffer_placement.NODE)
+
     def test_conext_release(self):
         assert self.handle
         self.handle.close()
@@ -88,3 +108,20 @@ class TestSharedBuffer(unittest.TestCase):
         assert buff.size() == 0
         assert buff.wsid() == 0
 
+    def test_poll_releases_gil(self):
+        with opae.fpga.open(self.toks[0]) as h:
+            buff = opae.fpga.allocate_shared_buffer(h, 4096)
+            assert buff
+            buff.fill(0)
+
+            # The writer is a Python thread, so it can only run if poll
+            # lets go of the GIL while it waits.
+            def writer():
+                time.sleep(0.01)
+                buff.write64(0xc0ffee, 64)
+
+            t = threading.Thread(target=writer)
+            t.start()
+            assert buff.poll64(64, 0xc0ffee, 0, 5000000)
+            t.join()
+            assert not buff.poll32(128, 1, 0, 1000)
@@ -0,0 +1,163 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pyopaeuio.h"
+
+class pyopaeuio_block_io : public ::testing::Test {
+ protected:
+  pyopaeuio_block_io() : regs_(16), base_(nullptr), size_(0) {}
+
+  virtual void SetUp() override {
+    for (size_t i = 0; i < regs_.size(); ++i)
+      regs_[i] = 0x1111111111111111ULL * i;
+    base_ = reinterpret_cast<uint8_t *>(regs_.data());
+    size_ = regs_.size() * sizeof(uint64_t);
+  }
+
+  std::vector<uint64_t> regs_;
+  uint8_t *base_;
+  size_t size_;
+};
+
+/**
+ * @test       read_block
+ * @brief      Test: uio_block, uio_mmio_copy
+ * @details    Registers are copied out at each access width,
+ *             starting at the given offset.<br>
+ */
+TEST_F(pyopaeuio_block_io, read_block) {
+  uint64_t q[2] = { 0, 0 };
+  uio_mmio_copy(uio_block(base_, size_, 0x18, 2, 64), q, 2, 64);
+  EXPECT_EQ(regs_[3], q[0]);
+  EXPECT_EQ(regs_[4], q[1]);
+
+  uint32_t d[2] = { 0, 0 };
+  uio_mmio_copy(uio_block(base_, size_, 0x1c, 2, 32), d, 2, 32);
+  EXPECT_EQ(0x33333333u, d[0]);
+  EXPECT_EQ(0x44444444u, d[1]);
+
+  uint16_t w = 0;
+  uio_mmio_copy(uio_block(base_, size_, 0x2a, 1, 16), &w, 1, 16);
+  EXPECT_EQ(0x5555u, w);
+
+  uint8_t b = 0;
+  uio_mmio_copy(uio_block(base_, size_, 0x3f, 1, 8), &b, 1, 8);
+  EXPECT_EQ(0x77u, b);
+}
+
+/**
+ * @test       write_block
+ * @brief      Test: uio_block, uio_mmio_copy
+ * @details    Registers are copied in at each access width, and
+ *             the registers around the block are kept.<br>
+ */
+TEST_F(pyopaeuio_block_io, write_block) {
+  const uint64_t q[1] = { 0xdeadbeefcafef00dULL };
+  uio_mmio_copy(q, uio_block(base_, size_, 0x08, 1, 64), 1, 64);
+  EXPECT_EQ(0x0000000000000000ULL, regs_[0]);
+  EXPECT_EQ(q[0], regs_[1]);
+  EXPECT_EQ(0x2222222222222222ULL, regs_[2]);
+
+  const uint32_t d[1] = { 0xa5a5a5a5 };
+  uio_mmio_copy(d, uio_block(base_, size_, 0x1c, 1, 32), 1, 32);
+  EXPECT_EQ(0xa5a5a5a533333333ULL, regs_[3]);
+
+  const uint8_t b[2] = { 0x01, 0x02 };
+  uio_mmio_copy(b, uio_block(base_, size_, 0x20, 2, 8), 2, 8);
+  EXPECT_EQ(0x4444444444440201ULL, regs_[4]);
+}
+
+/**
+ * @test       dump_restore
+ * @brief      Test: uio_dump_count, uio_block_count
+ * @details    A size of 0 dumps up to the end of the region, and
+ *             a dump is written back whole.<br>
+ */
+TEST_F(pyopaeuio_block_io, dump_restore) {
+  EXPECT_EQ(16u, uio_dump_count(size_, 0, 0, 64));
+  EXPECT_EQ(28u, uio_dump_count(size_, 0x10, 0, 32));
+  EXPECT_EQ(8u, uio_dump_count(size_, 0x10, 0x10, 16));
+  EXPECT_EQ(0u, uio_dump_count(size_, size_, 0, 8));
+
+  size_t count = uio_dump_count(size_, 0x20, 0x40, 64);
+  std::vector<uint64_t> saved(count);
+  uio_mmio_copy(uio_block(base_, size_, 0x20, count, 64), saved.data(),
+                count, 64);
+  std::vector<uint64_t> orig(regs_);
+
+  for (size_t i = 4; i < 12; ++i)
+    regs_[i] = 0;
+  count = uio_block_count(saved.size() * sizeof(uint64_t), 32);
+  uio_mmio_copy(saved.data(), uio_block(base_, size_, 0x20, count, 32),
+                count, 32);
+  EXPECT_EQ(orig, regs_);
+}
+
+/**
+ * @test       dump_restore_err
+ * @brief      Test: uio_dump_count, uio_block_count
+ * @details    A start beyond the region, or a size that isn't a
+ *             multiple of the access width, is rejected.<br>
+ */
+TEST_F(pyopaeuio_block_io, dump_restore_err) {
+  EXPECT_THROW(uio_dump_count(size_, size_ + 8, 0, 64), std::out_of_range);
+  EXPECT_THROW(uio_dump_count(size_, 0, 6, 64), std::invalid_argument);
+  EXPECT_THROW(uio_dump_count(size_, 0, 0, 24), std::invalid_argument);
+  EXPECT_THROW(uio_block_count(6, 32), std::invalid_argument);
+  EXPECT_THROW(uio_block_count(8, 128), std::invalid_argument);
+}
+
+/**
+ * @test       check_block
+ * @brief      Test: uio_block
+ * @details    A block must use an 8, 16, 32 or 64-bit width, be
+ *             aligned to it and lie within the region, even when
+ *             the register count would overflow.<br>
+ */
+TEST_F(pyopaeuio_block_io, check_block) {
+  EXPECT_EQ(base_, uio_block(base_, size_, 0, 16, 64));
+  EXPECT_EQ(base_ + 0x7f, uio_block(base_, size_, 0x7f, 1, 8));
+  EXPECT_EQ(base_ + size_, uio_block(base_, size_, size_, 0, 64));
+
+  EXPECT_THROW(uio_block(base_, size_, 0, 1, 0), std::invalid_argument);
+  EXPECT_THROW(uio_block(base_, size_, 0, 1, 128), std::invalid_argument);
+  EXPECT_THROW(uio_block(base_, size_, 4, 1, 64), std::invalid_argument);
+  EXPECT_THROW(uio_block(base_, size_, 1, 1, 16), std::invalid_argument);
+
+  EXPECT_THROW(uio_block(base_, size_, 0, 17, 64), std::out_of_range);
+  EXPECT_THROW(uio_block(base_, size_, 0x7e, 2, 16), std::out_of_range);
+  EXPECT_THROW(uio_block(base_, size_, size_ + 8, 0, 64), std::out_of_range);
+  EXPECT_THROW(uio_block(base_, size_, 8, SIZE_MAX / 4, 64),
+               std::out_of_range);
+}
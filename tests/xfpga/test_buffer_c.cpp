@@ -249,6 +249,31 @@ TEST_P(buffer_prepare, not_aligned) {
   EXPECT_EQ(xfpga_fpgaReleaseBuffer(handle_, wsid), FPGA_OK);
 }
 
+/**
+ * @test       numa_placement
+ *
+ * @brief      Each NUMA placement flag is accepted by fpgaPrepareBuffer,
+ *             and the buffer is usable and can be released.
+ *
+ */
+TEST_P(buffer_prepare, numa_placement) {
+  int placements[] = { 0,
+                       FPGA_BUF_NUMA_ANY,
+                       FPGA_BUF_NUMA_INTERLEAVE,
+                       FPGA_BUF_NUMA_NODE(0) };
+
+  for (auto p : placements) {
+    void *buf_addr = nullptr;
+    uint64_t wsid = 0;
+
+    ASSERT_EQ(xfpga_fpgaPrepareBuffer(handle_, 4 * 1024, &buf_addr, &wsid, p),
+              FPGA_OK) << "flags " << p;
+    ASSERT_NE(buf_addr, nullptr);
+    memset(buf_addr, 0xa5, 4 * 1024);
+    EXPECT_EQ(xfpga_fpgaReleaseBuffer(handle_, wsid), FPGA_OK);
+  }
+}
+
 /**
  * @test       write_read
  *
@@ -178,6 +178,122 @@ TEST_P(sysobject_mock_p, xfpga_fpgaObjectRead) {
   EXPECT_EQ(xfpga_fpgaDestroyObject(&object), FPGA_OK);
 }
 
+/**
+ * @test       xfpga_fpgaObjectReadv
+ * @brief      Test: xfpga_fpgaObjectReadv
+ * @details    Without FPGA_OBJECT_SYNC, the windows are copied from the<br>
+ *             buffered data. With it, the current contents of the file<br>
+ *             are read. A window past the end of the object is rejected.
+ */
+TEST_P(sysobject_mock_p, xfpga_fpgaObjectReadv) {
+  _fpga_token *tk = static_cast<_fpga_token *>(device_token_);
+  std::string syspath(tk->sysfspath);
+  syspath += "/testdata";
+  auto fp = system_->register_file(syspath);
+  ASSERT_NE(fp, nullptr) << strerror(errno);
+  fwrite(DATA.c_str(), DATA.size(), 1, fp);
+  fflush(fp);
+  fpga_object object;
+  ASSERT_EQ(xfpga_fpgaTokenGetObject(device_token_, "testdata", &object, 0),
+            FPGA_OK);
+
+  std::string updated = DATA;
+  for (size_t i = 0; i < updated.size(); i += 7)
+    updated[i] = '#';
+  rewind(fp);
+  fwrite(updated.c_str(), updated.size(), 1, fp);
+  fflush(fp);
+  opae_fclose(fp);
+
+  uint8_t a[4], b[8], c[3];
+  fpga_object_window windows[] = {
+    { a, 0, sizeof(a) },
+    { b, 14, sizeof(b) },
+    { c, DATA.size() - sizeof(c), sizeof(c) },
+  };
+
+  EXPECT_EQ(xfpga_fpgaObjectReadv(object, windows, 3, 0), FPGA_OK);
+  EXPECT_EQ(std::string((char *)a, sizeof(a)), DATA.substr(0, sizeof(a)));
+  EXPECT_EQ(std::string((char *)b, sizeof(b)), DATA.substr(14, sizeof(b)));
+
+  EXPECT_EQ(xfpga_fpgaObjectReadv(object, windows, 3, FPGA_OBJECT_SYNC),
+            FPGA_OK);
+  EXPECT_EQ(std::string((char *)a, sizeof(a)), updated.substr(0, sizeof(a)));
+  EXPECT_EQ(std::string((char *)b, sizeof(b)), updated.substr(14, sizeof(b)));
+  EXPECT_EQ(std::string((char *)c, sizeof(c)),
+            updated.substr(DATA.size() - sizeof(c)));
+
+  EXPECT_EQ(xfpga_fpgaObjectRead(object, b, 14, sizeof(b), 0), FPGA_OK);
+  EXPECT_EQ(std::string((char *)b, sizeof(b)), updated.substr(14, sizeof(b)));
+
+  windows[1].offset = DATA.size() - 1;
+  EXPECT_EQ(xfpga_fpgaObjectReadv(object, windows, 3, FPGA_OBJECT_SYNC),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(xfpga_fpgaDestroyObject(&object), FPGA_OK);
+}
+
+/**
+ * @test       xfpga_fpgaObjectReadGroup
+ * @brief      Test: xfpga_fpgaObjectReadGroup
+ * @details    The first snapshot of a group reports every readable<br>
+ *             member as changed. Later snapshots report only the<br>
+ *             members whose contents differ. A file object, or too<br>
+ *             few values, is rejected with FPGA_INVALID_PARAM.
+ */
+TEST_P(sysobject_mock_p, xfpga_fpgaObjectReadGroup) {
+  fpga_object group = nullptr;
+  ASSERT_EQ(xfpga_fpgaHandleGetObject(device_, "errors", &group,
+                                      FPGA_OBJECT_RECURSE_ONE), FPGA_OK);
+  uint32_t count = 0;
+  ASSERT_EQ(xfpga_fpgaObjectGetSize(group, &count, 0), FPGA_OK);
+  ASSERT_GT(count, 0);
+
+  fpga_object nonfatal = nullptr;
+  ASSERT_EQ(xfpga_fpgaHandleGetObject(device_, "errors/nonfatal_errors",
+                                      &nonfatal, 0), FPGA_OK);
+  ASSERT_EQ(xfpga_fpgaObjectWrite64(nonfatal, 0x0, 0), FPGA_OK);
+
+  std::vector<fpga_object_value> values(count);
+  size_t changed = 0;
+  size_t readable = 0;
+  EXPECT_EQ(xfpga_fpgaObjectReadGroup(group, values.data(), count,
+                                      &changed, 0), FPGA_OK);
+  for (auto &v : values) {
+    ASSERT_NE(v.name, nullptr);
+    if (v.result == FPGA_OK) {
+      EXPECT_TRUE(v.changed);
+      ++readable;
+    }
+  }
+  EXPECT_EQ(changed, readable);
+
+  EXPECT_EQ(xfpga_fpgaObjectReadGroup(group, values.data(), count,
+                                      &changed, 0), FPGA_OK);
+  EXPECT_EQ(changed, 0);
+
+  ASSERT_EQ(xfpga_fpgaObjectWrite64(nonfatal, 0x200, 0), FPGA_OK);
+  EXPECT_EQ(xfpga_fpgaObjectReadGroup(group, values.data(), count,
+                                      &changed, 0), FPGA_OK);
+  EXPECT_EQ(changed, 1);
+  for (auto &v : values) {
+    if (!strcmp(v.name, "nonfatal_errors")) {
+      EXPECT_EQ(v.result, FPGA_OK);
+      EXPECT_TRUE(v.changed);
+      EXPECT_EQ(v.value, 0x200);
+    } else {
+      EXPECT_FALSE(v.changed);
+    }
+  }
+
+  EXPECT_EQ(xfpga_fpgaObjectReadGroup(group, values.data(), count - 1,
+                                      &changed, 0), FPGA_INVALID_PARAM);
+  EXPECT_EQ(xfpga_fpgaObjectReadGroup(nonfatal, values.data(), count,
+                                      &changed, 0), FPGA_INVALID_PARAM);
+
+  EXPECT_EQ(xfpga_fpgaDestroyObject(&nonfatal), FPGA_OK);
+  EXPECT_EQ(xfpga_fpgaDestroyObject(&group), FPGA_OK);
+}
+
 TEST_P(sysobject_mock_p, xfpga_fpgaObjectWrite64) {
   _fpga_handle *h = static_cast<_fpga_handle *>(device_);
   _fpga_token *tok = static_cast<_fpga_token *>(h->token);
@@ -101,6 +101,61 @@ TEST(usrclk_c, get_userclock_null) {
   EXPECT_EQ(result, FPGA_INVALID_PARAM);
 }
 
+/**
+* @test    reset_locked
+* @brief   Tests: usrclk_reset
+* @details When the IOPLL reports lock once its resets
+*          are released, usrclk_reset returns FPGA_OK and
+*          leaves only IOPLL_AVMM_RESET_N set.
+*/
+TEST(usrclk_c, reset_locked) {
+  uint64_t csrs[8] = { 0 };
+  uint8_t *uio_ptr = (uint8_t *)csrs;
+
+  csrs[IOPLL_FREQ_STS0 / sizeof(uint64_t)] = IOPLL_LOCKED;
+
+  EXPECT_EQ(usrclk_reset(uio_ptr), FPGA_OK);
+  EXPECT_EQ(csrs[IOPLL_FREQ_CMD0 / sizeof(uint64_t)], IOPLL_AVMM_RESET_N);
+}
+
+/**
+* @test    reset_unlocked
+* @brief   Tests: usrclk_reset
+* @details When the IOPLL never reports lock,
+*          usrclk_reset returns FPGA_BUSY.
+*/
+TEST(usrclk_c, reset_unlocked) {
+  uint64_t csrs[8] = { 0 };
+
+  EXPECT_EQ(usrclk_reset((uint8_t *)csrs), FPGA_BUSY);
+  EXPECT_EQ(usrclk_reset(NULL), FPGA_INVALID_PARAM);
+}
+
+/**
+* @test    poll_sts0
+* @brief   Tests: usrclk_poll_sts0
+* @details usrclk_poll_sts0 returns FPGA_OK and the register value
+*          when the masked bits match, and FPGA_BUSY once the
+*          timeout expires otherwise.
+*/
+TEST(usrclk_c, poll_sts0) {
+  uint64_t csrs[8] = { 0 };
+  uint8_t *uio_ptr = (uint8_t *)csrs;
+  uint64_t sts0 = 0;
+
+  csrs[IOPLL_FREQ_STS0 / sizeof(uint64_t)] =
+    FIELD_PREP(IOPLL_SEQ, 2) | FIELD_PREP(IOPLL_DATA, 0xa5);
+
+  EXPECT_EQ(usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, 2),
+                             IOPLL_WRITE_POLL_TIMEOUT_US, &sts0), FPGA_OK);
+  EXPECT_EQ(FIELD_GET(IOPLL_DATA, sts0), 0xa5);
+
+  EXPECT_EQ(usrclk_poll_sts0(uio_ptr, IOPLL_SEQ, FIELD_PREP(IOPLL_SEQ, 3),
+                             100, &sts0), FPGA_BUSY);
+  EXPECT_EQ(usrclk_poll_sts0(NULL, IOPLL_SEQ, 0, 100, NULL),
+            FPGA_INVALID_PARAM);
+}
+
 /**
 * @test    fpga_set_user_clock
 * @brief   Tests: fpgaSetUserClock